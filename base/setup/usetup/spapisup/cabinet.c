@@ -491,6 +491,13 @@ CloseCabinet(
         CabinetContext->FileBuffer = NULL;
     }
 
+    if (CabinetContext->BlockBuffer)
+    {
+        RtlFreeHeap(ProcessHeap, 0, CabinetContext->BlockBuffer);
+        CabinetContext->BlockBuffer = NULL;
+    }
+    CabinetContext->BlockData = NULL;
+
     return 0;
 }
 
@@ -933,6 +940,29 @@ CabinetFindNextFileSequential(
     return CabinetFindNext(CabinetContext, Search);
 }
 
+/*
+ * FUNCTION: Returns the name and location of the file last found by a search
+ * ARGUMENTS:
+ *     Search      = Pointer to search structure
+ *     FileName    = Receives a pointer to the ANSI name of the file
+ *     FolderIndex = Receives the index of the folder containing the file
+ *     FileOffset  = Receives the uncompressed offset of the file in the folder
+ */
+VOID
+CabinetGetFileInfo(
+    IN PCAB_SEARCH Search,
+    OUT PCSTR* FileName OPTIONAL,
+    OUT PULONG FolderIndex OPTIONAL,
+    OUT PULONG FileOffset OPTIONAL)
+{
+    if (FileName)
+        *FileName = Search->File->FileName;
+    if (FolderIndex)
+        *FolderIndex = Search->File->FolderIndex;
+    if (FileOffset)
+        *FileOffset = Search->File->FileOffset;
+}
+
 #if 0
 int
 Validate(VOID)
@@ -941,6 +971,60 @@ Validate(VOID)
 }
 #endif
 
+/*
+ * FUNCTION: Sets the time stamp and attributes of an extracted file
+ * ARGUMENTS:
+ *     File       = Pointer to CFFILE node for the file
+ *     FileHandle = Handle to the extracted file
+ * RETURNS:
+ *     FALSE if the time stamp of the file is invalid
+ */
+BOOL
+CabinetSetFileInformation(
+    IN PCFFILE File,
+    IN HANDLE FileHandle)
+{
+    FILETIME FileTime;
+    NTSTATUS NtStatus;
+    IO_STATUS_BLOCK IoStatusBlock;
+    FILE_BASIC_INFORMATION FileBasic;
+
+    if (!ConvertDosDateTimeToFileTime(File->FileDate,
+                                      File->FileTime,
+                                      &FileTime))
+    {
+        DPRINT1("DosDateTimeToFileTime() failed\n");
+        return FALSE;
+    }
+
+    NtStatus = NtQueryInformationFile(FileHandle,
+                                      &IoStatusBlock,
+                                      &FileBasic,
+                                      sizeof(FILE_BASIC_INFORMATION),
+                                      FileBasicInformation);
+    if (!NT_SUCCESS(NtStatus))
+    {
+        DPRINT("NtQueryInformationFile() failed (%x)\n", NtStatus);
+    }
+    else
+    {
+        memcpy(&FileBasic.LastAccessTime, &FileTime, sizeof(FILETIME));
+
+        NtStatus = NtSetInformationFile(FileHandle,
+                                        &IoStatusBlock,
+                                        &FileBasic,
+                                        sizeof(FILE_BASIC_INFORMATION),
+                                        FileBasicInformation);
+        if (!NT_SUCCESS(NtStatus))
+        {
+            DPRINT("NtSetInformationFile() failed (%x)\n", NtStatus);
+        }
+    }
+
+    SetAttributesOnFile(File, FileHandle);
+    return TRUE;
+}
+
 /*
  * FUNCTION: Extracts a file from the cabinet
  * ARGUMENTS:
@@ -953,28 +1037,25 @@ CabinetExtractFile(
     IN PCABINET_CONTEXT CabinetContext,
     IN PCAB_SEARCH Search)
 {
-    ULONG Size;                 // remaining file bytes to decompress
-    ULONG CurrentOffset;        // current uncompressed offset within the folder
-    PUCHAR CurrentBuffer;       // current pointer to compressed data in the block
-    LONG RemainingBlock;        // remaining comp data in the block
+    ULONG Size;                 // remaining file bytes to copy
+    ULONG Offset;               // uncompressed offset of the next file byte
+    ULONG Length;               // file bytes to copy from the current block
+    ULONG CurrentOffset;        // uncompressed offset of the current block within the folder
     HANDLE DestFile;
     HANDLE DestFileSection;
     PVOID DestFileBuffer;       // mapped view of dest file
     PVOID CurrentDestBuffer;    // pointer to the current position in the dest view
     PCFDATA CFData;             // current data block
     ULONG Status;
-    FILETIME FileTime;
     WCHAR DestName[MAX_PATH];
     NTSTATUS NtStatus;
     UNICODE_STRING UnicodeString;
     ANSI_STRING AnsiString;
     IO_STATUS_BLOCK IoStatusBlock;
     OBJECT_ATTRIBUTES ObjectAttributes;
-    FILE_BASIC_INFORMATION FileBasic;
     PCFFOLDER CurrentFolder;
     LARGE_INTEGER MaxDestFileSize;
     LONG InputLength, OutputLength;
-    char Chunk[512];
 
     if (wcscmp(Search->Cabinet, CabinetContext->CabinetName) != 0)
     {
@@ -1124,142 +1205,121 @@ CabinetExtractFile(
         }
 
         CurrentDestBuffer = DestFileBuffer;
-        if (!ConvertDosDateTimeToFileTime(Search->File->FileDate,
-                                          Search->File->FileTime,
-                                          &FileTime))
+        if (!CabinetSetFileInformation(Search->File, DestFile))
         {
-            DPRINT1("DosDateTimeToFileTime() failed\n");
             Status = CAB_STATUS_CANNOT_WRITE;
             goto UnmapDestFile;
         }
-
-        NtStatus = NtQueryInformationFile(DestFile,
-                                          &IoStatusBlock,
-                                          &FileBasic,
-                                          sizeof(FILE_BASIC_INFORMATION),
-                                          FileBasicInformation);
-        if (!NT_SUCCESS(NtStatus))
-        {
-            DPRINT("NtQueryInformationFile() failed (%x)\n", NtStatus);
-        }
-        else
-        {
-            memcpy(&FileBasic.LastAccessTime, &FileTime, sizeof(FILETIME));
-
-            NtStatus = NtSetInformationFile(DestFile,
-                                            &IoStatusBlock,
-                                            &FileBasic,
-                                            sizeof(FILE_BASIC_INFORMATION),
-                                            FileBasicInformation);
-            if (!NT_SUCCESS(NtStatus))
-            {
-                DPRINT("NtSetInformationFile() failed (%x)\n", NtStatus);
-            }
-        }
-
-        SetAttributesOnFile(Search->File, DestFile);
     }
 
     /* Call extract event handler */
     if (CabinetContext->ExtractHandler != NULL)
         CabinetContext->ExtractHandler(CabinetContext, Search->File, DestName);
 
-    if (Search->CFData)
-        CFData = Search->CFData;
-    else
-        CFData = (PCFDATA)(CabinetContext->CabinetFolders[Search->File->FolderIndex].DataOffset + CabinetContext->FileBuffer);
-
-    CurrentOffset = Search->Offset;
-    while (CurrentOffset + CFData->UncompSize <= Search->File->FileOffset)
+    /* Allocate the buffer for the uncompressed data blocks */
+    if (!CabinetContext->BlockBuffer)
     {
-        /* walk the data blocks until we reach
-           the one containing the start of the file */
-        CurrentOffset += CFData->UncompSize;
-        CFData = (PCFDATA)((char *)(CFData + 1) + CabinetContext->DataReserved + CFData->CompSize);
+        CabinetContext->BlockBuffer = RtlAllocateHeap(ProcessHeap, 0, CAB_BLOCKSIZE);
+        if (!CabinetContext->BlockBuffer)
+        {
+            Status = CAB_STATUS_NOMEMORY;
+            goto UnmapDestFile;
+        }
+        CabinetContext->BlockData = NULL;
     }
 
-    Search->CFData = CFData;
-    Search->Offset = CurrentOffset;
-
-    /* now decompress and discard any data in
-       the block before the start of the file */
-
-    /* start of comp data */
-    CurrentBuffer = ((unsigned char *)(CFData + 1)) + CabinetContext->DataReserved;
-    RemainingBlock = CFData->CompSize;
-    InputLength = RemainingBlock;
-
-    while (CurrentOffset < Search->File->FileOffset)
+    CFData = Search->CFData;
+    CurrentOffset = Search->Offset;
+    if (!CFData || CurrentOffset > Search->File->FileOffset)
     {
-        /* compute remaining uncomp bytes to start
-           of file, bounded by size of chunk */
-        OutputLength = Search->File->FileOffset - CurrentOffset;
-        if (OutputLength > (LONG)sizeof(Chunk))
-            OutputLength = sizeof(Chunk);
-
-        /* negate to signal NOT end of block */
-        OutputLength = -OutputLength;
-
-        CabinetContext->Codec->Uncompress(CabinetContext->Codec,
-                                          Chunk,
-                                          CurrentBuffer,
-                                          &InputLength,
-                                          &OutputLength);
-
-        /* add the uncomp bytes extracted to current folder offset */
-        CurrentOffset += OutputLength;
-        /* add comp bytes consumed to CurrentBuffer */
-        CurrentBuffer += InputLength;
-        /* subtract bytes consumed from bytes remaining in block */
-        RemainingBlock -= InputLength;
-        /* neg for resume decompression of the same block */
-        InputLength = -RemainingBlock;
-    }
+        /* start over from the first data block of the folder */
+        CFData = (PCFDATA)(CurrentFolder->DataOffset + CabinetContext->FileBuffer);
+        CurrentOffset = 0;
 
-    /* now CurrentBuffer points to the first comp byte
-       of the file, so we can begin decompressing */
+        if ((PUCHAR)(CFData + 1) > CabinetContext->FileBuffer + CabinetContext->FileSize)
+        {
+            DPRINT1("Folder data beyond the end of the cabinet\n");
+            Status = CAB_STATUS_INVALID_CAB;
+            goto UnmapDestFile;
+        }
+    }
 
-    /* Size = remaining uncomp bytes of the file to decompress */
+    /*
+     * Each data block is uncompressed as a whole, and the last one is kept
+     * in the context. Files extracted in folder order (see SetupCommitFileQueueW)
+     * therefore uncompress every block of the folder exactly once.
+     */
+    Offset = Search->File->FileOffset;
     Size = Search->File->FileSize;
     while (Size > 0)
     {
-        OutputLength = Size;
-        DPRINT("Decompressing block at %x with RemainingBlock = %d, Size = %d\n",
-               CurrentBuffer, RemainingBlock, Size);
-
-        Status = CabinetContext->Codec->Uncompress(CabinetContext->Codec,
-                                                   CurrentDestBuffer,
-                                                   CurrentBuffer,
-                                                   &InputLength,
-                                                   &OutputLength);
-        if (Status != CS_SUCCESS)
+        /* walk the data blocks until we reach
+           the one containing the next byte of the file */
+        while (CurrentOffset + CFData->UncompSize <= Offset)
         {
-            DPRINT("Cannot uncompress block\n");
-            if (Status == CS_NOMEMORY)
-                Status = CAB_STATUS_NOMEMORY;
-            Status = CAB_STATUS_INVALID_CAB;
-            goto UnmapDestFile;
+            CurrentOffset += CFData->UncompSize;
+            CFData = (PCFDATA)((char *)(CFData + 1) + CabinetContext->DataReserved + CFData->CompSize);
+
+            if ((PUCHAR)(CFData + 1) > CabinetContext->FileBuffer + CabinetContext->FileSize)
+            {
+                DPRINT1("File data beyond the end of the cabinet\n");
+                Status = CAB_STATUS_INVALID_CAB;
+                goto UnmapDestFile;
+            }
         }
 
-        /* advance dest buffer by bytes produced */
-        CurrentDestBuffer = (PVOID)((ULONG_PTR)CurrentDestBuffer + OutputLength);
-        /* advance src buffer by bytes consumed */
-        CurrentBuffer += InputLength;
-        /* reduce remaining file bytes by bytes produced */
-        Size -= OutputLength;
-        /* reduce remaining block size by bytes consumed */
-        RemainingBlock -= InputLength;
-        if (Size > 0 && RemainingBlock == 0)
+        if (CabinetContext->BlockData != CFData)
         {
-            /* used up this block, move on to the next */
-            DPRINT("Out of block data\n");
-            CFData = (PCFDATA)CurrentBuffer;
-            RemainingBlock = CFData->CompSize;
-            CurrentBuffer = (unsigned char *)(CFData + 1) + CabinetContext->DataReserved;
-            InputLength = RemainingBlock;
+            DPRINT("Decompressing block at %p, CompSize = %d, UncompSize = %d\n",
+                   CFData, CFData->CompSize, CFData->UncompSize);
+
+            if ((PUCHAR)(CFData + 1) + CabinetContext->DataReserved + CFData->CompSize >
+                CabinetContext->FileBuffer + CabinetContext->FileSize ||
+                CFData->UncompSize > CAB_BLOCKSIZE)
+            {
+                DPRINT1("Invalid data block at %p\n", CFData);
+                Status = CAB_STATUS_INVALID_CAB;
+                goto UnmapDestFile;
+            }
+
+            /* positive lengths: the whole block at once */
+            InputLength = CFData->CompSize;
+            OutputLength = CFData->UncompSize;
+            CabinetContext->BlockData = NULL;
+
+            Status = CabinetContext->Codec->Uncompress(CabinetContext->Codec,
+                                                       CabinetContext->BlockBuffer,
+                                                       (PUCHAR)(CFData + 1) + CabinetContext->DataReserved,
+                                                       &InputLength,
+                                                       &OutputLength);
+            if (Status != CS_SUCCESS || OutputLength != CFData->UncompSize)
+            {
+                DPRINT("Cannot uncompress block\n");
+                if (Status == CS_NOMEMORY)
+                    Status = CAB_STATUS_NOMEMORY;
+                else
+                    Status = CAB_STATUS_INVALID_CAB;
+                goto UnmapDestFile;
+            }
+
+            CabinetContext->BlockData = CFData;
         }
+
+        /* copy the part of the block that belongs to the file */
+        Length = min(Size, CurrentOffset + CFData->UncompSize - Offset);
+        RtlCopyMemory(CurrentDestBuffer,
+                      CabinetContext->BlockBuffer + (Offset - CurrentOffset),
+                      Length);
+
+        CurrentDestBuffer = (PVOID)((ULONG_PTR)CurrentDestBuffer + Length);
+        Offset += Length;
+        Size -= Length;
     }
 
+    /* the next file in the folder continues from here */
+    Search->CFData = CFData;
+    Search->Offset = CurrentOffset;
+
     Status = CAB_STATUS_SUCCESS;
 
 UnmapDestFile:
@@ -106,6 +106,8 @@ typedef struct _CABINET_CONTEXT
     ULONG CodecId;
     BOOL CodecSelected;
     ULONG LastFileOffset;           // Uncompressed offset of last extracted file
+    PUCHAR BlockBuffer;             // Uncompressed data of BlockData
+    PCFDATA BlockData;              // Data block currently in BlockBuffer
     PCABINET_OVERWRITE OverwriteHandler;
     PCABINET_EXTRACT ExtractHandler;
     PCABINET_DISK_CHANGE DiskChangeHandler;
@@ -190,12 +192,26 @@ CabinetFindNextFileSequential(
     IN PCWSTR FileName,
     IN OUT PCAB_SEARCH Search);
 
+/* Returns the name and location of the file last found by a search */
+VOID
+CabinetGetFileInfo(
+    IN PCAB_SEARCH Search,
+    OUT PCSTR* FileName OPTIONAL,
+    OUT PULONG FolderIndex OPTIONAL,
+    OUT PULONG FileOffset OPTIONAL);
+
 /* Extracts a file from the current cabinet file */
 ULONG
 CabinetExtractFile(
     IN PCABINET_CONTEXT CabinetContext,
     IN PCAB_SEARCH Search);
 
+/* Sets the time stamp and attributes of an extracted file */
+BOOL
+CabinetSetFileInformation(
+    IN PCFFILE File,
+    IN HANDLE FileHandle);
+
 /* Select codec engine to use */
 VOID
 CabinetSelectCodec(
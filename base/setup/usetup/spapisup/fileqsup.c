@@ -43,8 +43,26 @@ typedef struct _QUEUEENTRY
     PWSTR SourceFileName;
     PWSTR TargetDirectory;
     PWSTR TargetFileName;
+
+    /* Copy order, see SetupSortCopyQueue() */
+    ULONG Sequence;         // Position in the queue
+    ULONG CabinetGroup;     // Index of the cabinet, or MAXULONG
+    ULONG FolderIndex;      // Location of the file in the cabinet,
+    ULONG FileOffset;       // or MAXULONG if not found
 } QUEUEENTRY, *PQUEUEENTRY;
 
+/* A cabinet file extracted in memory, to be written by the writer thread */
+typedef struct _SETUP_WRITE_JOB
+{
+    PCFFILE File;
+    PVOID Buffer;
+    ULONG Size;
+    ULONG CabinetGroup;
+    NTSTATUS Status;
+    WCHAR SourcePath[MAX_PATH];
+    WCHAR TargetPath[MAX_PATH];
+} SETUP_WRITE_JOB, *PSETUP_WRITE_JOB;
+
 typedef struct _FILEQUEUEHEADER
 {
     LIST_ENTRY DeleteQueue; // PQUEUEENTRY entries
@@ -60,11 +78,70 @@ typedef struct _FILEQUEUEHEADER
     CABINET_CONTEXT CabinetContext;
     CAB_SEARCH Search;
     WCHAR CurrentCabinetName[MAX_PATH];
+
+    /* Batch copy from the cabinets, see SetupCommitFileQueueW() */
+    HANDLE WriterThread;
+    HANDLE WriteStartEvent;
+    HANDLE WriteDoneEvent;
+    BOOLEAN WriterQuit;
+    BOOLEAN WritePending;
+    SETUP_WRITE_JOB WriteJob;
+    PVOID ExtractBuffer;    // File extracted by SetupExtractFile()
+    ULONG ExtractSize;
 } FILEQUEUEHEADER, *PFILEQUEUEHEADER;
 
 
 /* SETUP* API COMPATIBILITY FUNCTIONS ****************************************/
 
+static NTSTATUS
+SetupOpenCabinet(
+    IN OUT PFILEQUEUEHEADER QueueHeader,
+    IN PCWSTR CabinetFileName)
+{
+    ULONG CabStatus;
+
+    if (QueueHeader->HasCurrentCabinet)
+    {
+        QueueHeader->HasCurrentCabinet = FALSE;
+        CabinetCleanup(&QueueHeader->CabinetContext);
+    }
+
+    RtlStringCchCopyW(QueueHeader->CurrentCabinetName,
+                      ARRAYSIZE(QueueHeader->CurrentCabinetName),
+                      CabinetFileName);
+
+    CabinetInitialize(&QueueHeader->CabinetContext);
+    CabinetSetEventHandlers(&QueueHeader->CabinetContext,
+                            NULL, NULL, NULL, NULL);
+    CabinetSetCabinetName(&QueueHeader->CabinetContext, CabinetFileName);
+
+    CabStatus = CabinetOpen(&QueueHeader->CabinetContext);
+    if (CabStatus != CAB_STATUS_SUCCESS)
+    {
+        DPRINT("Cannot open cabinet (%d)\n", CabStatus);
+        return STATUS_UNSUCCESSFUL;
+    }
+
+    DPRINT("Opened cabinet %S\n", CabinetFileName /*CabinetGetCabinetName(&QueueHeader->CabinetContext)*/);
+    QueueHeader->HasCurrentCabinet = TRUE;
+    return STATUS_SUCCESS;
+}
+
+/* Extracts the files in memory for the writer thread */
+static PVOID
+SetupCreateFileBuffer(
+    IN PCABINET_CONTEXT CabinetContext,
+    IN ULONG FileSize)
+{
+    PFILEQUEUEHEADER QueueHeader;
+
+    QueueHeader = CONTAINING_RECORD(CabinetContext, FILEQUEUEHEADER, CabinetContext);
+
+    QueueHeader->ExtractBuffer = RtlAllocateHeap(ProcessHeap, 0, max(FileSize, 1));
+    QueueHeader->ExtractSize = FileSize;
+    return QueueHeader->ExtractBuffer;
+}
+
 static NTSTATUS
 SetupExtractFile(
     IN OUT PFILEQUEUEHEADER QueueHeader,
@@ -105,32 +182,8 @@ SetupExtractFile(
     {
         DPRINT("Using new cabinet\n");
 
-        if (QueueHeader->HasCurrentCabinet)
-        {
-            QueueHeader->HasCurrentCabinet = FALSE;
-            CabinetCleanup(&QueueHeader->CabinetContext);
-        }
-
-        RtlStringCchCopyW(QueueHeader->CurrentCabinetName,
-                          ARRAYSIZE(QueueHeader->CurrentCabinetName),
-                          CabinetFileName);
-
-        CabinetInitialize(&QueueHeader->CabinetContext);
-        CabinetSetEventHandlers(&QueueHeader->CabinetContext,
-                                NULL, NULL, NULL, NULL);
-        CabinetSetCabinetName(&QueueHeader->CabinetContext, CabinetFileName);
-
-        CabStatus = CabinetOpen(&QueueHeader->CabinetContext);
-        if (CabStatus == CAB_STATUS_SUCCESS)
-        {
-            DPRINT("Opened cabinet %S\n", CabinetFileName /*CabinetGetCabinetName(&QueueHeader->CabinetContext)*/);
-            QueueHeader->HasCurrentCabinet = TRUE;
-        }
-        else
-        {
-            DPRINT("Cannot open cabinet (%d)\n", CabStatus);
+        if (!NT_SUCCESS(SetupOpenCabinet(QueueHeader, CabinetFileName)))
             return STATUS_UNSUCCESSFUL;
-        }
 
         /* We have to start at the beginning here */
         CabStatus = CabinetFindFirst(&QueueHeader->CabinetContext,
@@ -145,11 +198,21 @@ SetupExtractFile(
         return STATUS_UNSUCCESSFUL;
     }
 
+    /* With a writer thread, only extract the file in memory */
+    CabinetSetEventHandlers(&QueueHeader->CabinetContext,
+                            NULL, NULL, NULL,
+                            QueueHeader->WriterThread ? SetupCreateFileBuffer : NULL);
+
     CabinetSetDestinationPath(&QueueHeader->CabinetContext, DestinationPathName);
     CabStatus = CabinetExtractFile(&QueueHeader->CabinetContext, &QueueHeader->Search);
     if (CabStatus != CAB_STATUS_SUCCESS)
     {
         DPRINT("Cannot extract file %S (%d)\n", SourceFileName, CabStatus);
+        if (QueueHeader->ExtractBuffer != NULL)
+        {
+            RtlFreeHeap(ProcessHeap, 0, QueueHeader->ExtractBuffer);
+            QueueHeader->ExtractBuffer = NULL;
+        }
         return STATUS_UNSUCCESSFUL;
     }
 
@@ -250,6 +313,10 @@ SetupCloseFileQueue(
         SetupDeleteQueueEntry(Entry);
     }
 
+    /* Close the last cabinet used */
+    if (QueueHeader->HasCurrentCabinet)
+        CabinetCleanup(&QueueHeader->CabinetContext);
+
     /* Delete queue header */
     RtlFreeHeap(ProcessHeap, 0, QueueHeader);
 
@@ -612,6 +679,433 @@ SetupQueueRenameW(
     return TRUE;
 }
 
+static BOOLEAN
+SetupIsSameCabinet(
+    IN PQUEUEENTRY Entry1,
+    IN PQUEUEENTRY Entry2)
+{
+    if (_wcsicmp(Entry1->SourceCabinet, Entry2->SourceCabinet) != 0 ||
+        _wcsicmp(Entry1->SourceRootPath, Entry2->SourceRootPath) != 0)
+    {
+        return FALSE;
+    }
+
+    if (Entry1->SourcePath == NULL || Entry2->SourcePath == NULL)
+        return (Entry1->SourcePath == Entry2->SourcePath);
+
+    return (_wcsicmp(Entry1->SourcePath, Entry2->SourcePath) == 0);
+}
+
+static int
+__cdecl
+SetupCompareFileName(
+    IN const void* Key,
+    IN const void* Element)
+{
+    return wcscmp((*(PQUEUEENTRY*)Key)->SourceFileName,
+                  (*(PQUEUEENTRY*)Element)->SourceFileName);
+}
+
+static int
+__cdecl
+SetupCompareCopyOrder(
+    IN const void* Element1,
+    IN const void* Element2)
+{
+    PQUEUEENTRY Entry1 = *(PQUEUEENTRY*)Element1;
+    PQUEUEENTRY Entry2 = *(PQUEUEENTRY*)Element2;
+
+    if (Entry1->CabinetGroup != Entry2->CabinetGroup)
+        return (Entry1->CabinetGroup < Entry2->CabinetGroup) ? -1 : 1;
+    if (Entry1->FolderIndex != Entry2->FolderIndex)
+        return (Entry1->FolderIndex < Entry2->FolderIndex) ? -1 : 1;
+    if (Entry1->FileOffset != Entry2->FileOffset)
+        return (Entry1->FileOffset < Entry2->FileOffset) ? -1 : 1;
+    if (Entry1->Sequence != Entry2->Sequence)
+        return (Entry1->Sequence < Entry2->Sequence) ? -1 : 1;
+    return 0;
+}
+
+/*
+ * Locates the queued files in their cabinet: the entries of
+ * Entries[0..Count-1] are sorted by name on return.
+ */
+static VOID
+SetupLocateCabinetFiles(
+    IN OUT PFILEQUEUEHEADER QueueHeader,
+    IN PQUEUEENTRY* Entries,
+    IN ULONG Count)
+{
+    ULONG CabStatus;
+    ULONG FolderIndex, FileOffset;
+    PCSTR CabFileName;
+    PQUEUEENTRY* Found;
+    PQUEUEENTRY* Last;
+    QUEUEENTRY Key;
+    PQUEUEENTRY KeyEntry = &Key;
+    ANSI_STRING AnsiString;
+    UNICODE_STRING UnicodeString;
+    WCHAR FileName[MAX_PATH];
+    WCHAR CabinetPath[MAX_PATH];
+
+    CombinePaths(CabinetPath, ARRAYSIZE(CabinetPath), 3,
+                 Entries[0]->SourceRootPath, Entries[0]->SourcePath,
+                 Entries[0]->SourceCabinet);
+
+    if (!NT_SUCCESS(SetupOpenCabinet(QueueHeader, CabinetPath)))
+        return;
+
+    qsort(Entries, Count, sizeof(*Entries), SetupCompareFileName);
+    Last = &Entries[Count - 1];
+    Key.SourceFileName = FileName;
+
+    /* Enumerate the cabinet once and look up each of its files in the queue */
+    CabStatus = CabinetFindFirst(&QueueHeader->CabinetContext, L"*", &QueueHeader->Search);
+    while (CabStatus == CAB_STATUS_SUCCESS)
+    {
+        CabinetGetFileInfo(&QueueHeader->Search, &CabFileName, &FolderIndex, &FileOffset);
+
+        RtlInitAnsiString(&AnsiString, CabFileName);
+        UnicodeString.Buffer = FileName;
+        UnicodeString.Length = 0;
+        UnicodeString.MaximumLength = sizeof(FileName);
+        if (NT_SUCCESS(RtlAnsiStringToUnicodeString(&UnicodeString, &AnsiString, FALSE)))
+        {
+            FileName[UnicodeString.Length / sizeof(WCHAR)] = UNICODE_NULL;
+
+            Found = bsearch(&KeyEntry, Entries, Count, sizeof(*Entries), SetupCompareFileName);
+            if (Found != NULL)
+            {
+                /* The same file may be queued several times */
+                while (Found > Entries && wcscmp(Found[-1]->SourceFileName, FileName) == 0)
+                    --Found;
+
+                /* Keep the first occurrence in the cabinet, as SetupExtractFile() does */
+                for (; Found <= Last && wcscmp((*Found)->SourceFileName, FileName) == 0; ++Found)
+                {
+                    if ((*Found)->FolderIndex == MAXULONG)
+                    {
+                        (*Found)->FolderIndex = FolderIndex;
+                        (*Found)->FileOffset = FileOffset;
+                    }
+                }
+            }
+        }
+
+        CabStatus = CabinetFindNext(&QueueHeader->CabinetContext, &QueueHeader->Search);
+    }
+}
+
+/*
+ * Sorts the copy queue by cabinet, then by folder and offset within the
+ * cabinet, so that each folder is uncompressed only once when committing
+ * the queue. Files that are not in a cabinet are copied last, in queue order.
+ */
+static BOOL
+SetupSortCopyQueue(
+    IN OUT PFILEQUEUEHEADER QueueHeader)
+{
+    PLIST_ENTRY ListEntry;
+    PQUEUEENTRY* Entries;
+    PQUEUEENTRY* GroupEntries;
+    ULONG Count, GroupCount;
+    ULONG CabinetGroups;
+    ULONG i, j;
+
+    if (QueueHeader->CopyCount == 0)
+        return FALSE;
+
+    Entries = RtlAllocateHeap(ProcessHeap, 0, 2 * QueueHeader->CopyCount * sizeof(PQUEUEENTRY));
+    if (Entries == NULL)
+        return FALSE;
+    GroupEntries = Entries + QueueHeader->CopyCount;
+
+    /* Assign the cabinet groups, in the order of their first use */
+    Count = 0;
+    CabinetGroups = 0;
+    for (ListEntry = QueueHeader->CopyQueue.Flink;
+         ListEntry != &QueueHeader->CopyQueue && Count < QueueHeader->CopyCount;
+         ListEntry = ListEntry->Flink)
+    {
+        Entries[Count] = CONTAINING_RECORD(ListEntry, QUEUEENTRY, ListEntry);
+        Entries[Count]->Sequence = Count;
+        Entries[Count]->CabinetGroup = MAXULONG;
+        Entries[Count]->FolderIndex = MAXULONG;
+        Entries[Count]->FileOffset = MAXULONG;
+
+        if (Entries[Count]->SourceCabinet != NULL)
+        {
+            for (i = 0; i < Count; i++)
+            {
+                if (Entries[i]->SourceCabinet != NULL &&
+                    SetupIsSameCabinet(Entries[i], Entries[Count]))
+                {
+                    Entries[Count]->CabinetGroup = Entries[i]->CabinetGroup;
+                    break;
+                }
+            }
+
+            if (Entries[Count]->CabinetGroup == MAXULONG)
+                Entries[Count]->CabinetGroup = CabinetGroups++;
+        }
+
+        ++Count;
+    }
+
+    /* Find the location of the files in each cabinet */
+    for (i = 0; i < CabinetGroups; i++)
+    {
+        GroupCount = 0;
+        for (j = 0; j < Count; j++)
+        {
+            if (Entries[j]->CabinetGroup == i)
+                GroupEntries[GroupCount++] = Entries[j];
+        }
+
+        SetupLocateCabinetFiles(QueueHeader, GroupEntries, GroupCount);
+    }
+
+    /* Rebuild the queue in copy order */
+    qsort(Entries, Count, sizeof(*Entries), SetupCompareCopyOrder);
+
+    InitializeListHead(&QueueHeader->CopyQueue);
+    for (i = 0; i < Count; i++)
+        InsertTailList(&QueueHeader->CopyQueue, &Entries[i]->ListEntry);
+
+    RtlFreeHeap(ProcessHeap, 0, Entries);
+    return (CabinetGroups > 0);
+}
+
+static NTSTATUS
+SetupWriteExtractedFile(
+    IN PSETUP_WRITE_JOB Job)
+{
+    NTSTATUS Status;
+    HANDLE FileHandle;
+    UNICODE_STRING FileName;
+    OBJECT_ATTRIBUTES ObjectAttributes;
+    IO_STATUS_BLOCK IoStatusBlock;
+    LARGE_INTEGER AllocationSize;
+
+    RtlInitUnicodeString(&FileName, Job->TargetPath);
+    InitializeObjectAttributes(&ObjectAttributes,
+                               &FileName,
+                               OBJ_CASE_INSENSITIVE,
+                               NULL, NULL);
+
+    AllocationSize.QuadPart = Job->Size;
+    Status = NtCreateFile(&FileHandle,
+                          GENERIC_READ | GENERIC_WRITE | SYNCHRONIZE,
+                          &ObjectAttributes,
+                          &IoStatusBlock,
+                          &AllocationSize,
+                          FILE_ATTRIBUTE_NORMAL,
+                          0,
+                          FILE_OVERWRITE_IF,
+                          FILE_SYNCHRONOUS_IO_NONALERT | FILE_SEQUENTIAL_ONLY,
+                          NULL, 0);
+    if (!NT_SUCCESS(Status))
+    {
+        DPRINT1("NtCreateFile() failed (%S) (%x)\n", Job->TargetPath, Status);
+        return Status;
+    }
+
+    if (Job->Size > 0)
+    {
+        Status = NtWriteFile(FileHandle,
+                             NULL, NULL, NULL,
+                             &IoStatusBlock,
+                             Job->Buffer,
+                             Job->Size,
+                             NULL, NULL);
+        if (!NT_SUCCESS(Status))
+            DPRINT1("NtWriteFile() failed (%S) (%x)\n", Job->TargetPath, Status);
+    }
+
+    if (NT_SUCCESS(Status) && !CabinetSetFileInformation(Job->File, FileHandle))
+        Status = STATUS_UNSUCCESSFUL;
+
+    NtClose(FileHandle);
+    return Status;
+}
+
+static ULONG
+NTAPI
+SetupWriterThread(
+    IN PVOID Parameter)
+{
+    PFILEQUEUEHEADER QueueHeader = (PFILEQUEUEHEADER)Parameter;
+
+    for (;;)
+    {
+        NtWaitForSingleObject(QueueHeader->WriteStartEvent, FALSE, NULL);
+        if (QueueHeader->WriterQuit)
+            break;
+
+        QueueHeader->WriteJob.Status = SetupWriteExtractedFile(&QueueHeader->WriteJob);
+        NtSetEvent(QueueHeader->WriteDoneEvent, NULL);
+    }
+
+    return 0;
+}
+
+static VOID
+SetupStopWriter(
+    IN OUT PFILEQUEUEHEADER QueueHeader)
+{
+    if (QueueHeader->WriterThread != NULL)
+    {
+        QueueHeader->WriterQuit = TRUE;
+        NtSetEvent(QueueHeader->WriteStartEvent, NULL);
+        NtWaitForSingleObject(QueueHeader->WriterThread, FALSE, NULL);
+        NtClose(QueueHeader->WriterThread);
+        QueueHeader->WriterThread = NULL;
+        QueueHeader->WriterQuit = FALSE;
+    }
+
+    if (QueueHeader->WriteStartEvent != NULL)
+    {
+        NtClose(QueueHeader->WriteStartEvent);
+        QueueHeader->WriteStartEvent = NULL;
+    }
+
+    if (QueueHeader->WriteDoneEvent != NULL)
+    {
+        NtClose(QueueHeader->WriteDoneEvent);
+        QueueHeader->WriteDoneEvent = NULL;
+    }
+}
+
+/* Without a writer thread, the files are extracted directly into their target */
+static VOID
+SetupStartWriter(
+    IN OUT PFILEQUEUEHEADER QueueHeader)
+{
+    NTSTATUS Status;
+
+    Status = NtCreateEvent(&QueueHeader->WriteStartEvent,
+                           EVENT_ALL_ACCESS,
+                           NULL,
+                           SynchronizationEvent,
+                           FALSE);
+    if (!NT_SUCCESS(Status))
+        goto Failure;
+
+    Status = NtCreateEvent(&QueueHeader->WriteDoneEvent,
+                           EVENT_ALL_ACCESS,
+                           NULL,
+                           SynchronizationEvent,
+                           FALSE);
+    if (!NT_SUCCESS(Status))
+        goto Failure;
+
+    QueueHeader->WriterQuit = FALSE;
+    Status = RtlCreateUserThread(NtCurrentProcess(),
+                                 NULL,
+                                 FALSE,
+                                 0,
+                                 0,
+                                 0,
+                                 SetupWriterThread,
+                                 QueueHeader,
+                                 &QueueHeader->WriterThread,
+                                 NULL);
+    if (!NT_SUCCESS(Status))
+    {
+        QueueHeader->WriterThread = NULL;
+        goto Failure;
+    }
+
+    return;
+
+Failure:
+    DPRINT1("Failed to start the writer thread (Status 0x%08lx)\n", Status);
+    SetupStopWriter(QueueHeader);
+}
+
+/* Hands the file extracted in memory over to the writer thread */
+static VOID
+SetupSubmitWrite(
+    IN OUT PFILEQUEUEHEADER QueueHeader,
+    IN PQUEUEENTRY Entry,
+    IN PCWSTR SourcePath,
+    IN PCWSTR TargetPath)
+{
+    PSETUP_WRITE_JOB Job = &QueueHeader->WriteJob;
+
+    Job->File = QueueHeader->Search.File;
+    Job->Buffer = QueueHeader->ExtractBuffer;
+    Job->Size = QueueHeader->ExtractSize;
+    Job->CabinetGroup = Entry->CabinetGroup;
+    Job->Status = STATUS_PENDING;
+    RtlStringCchCopyW(Job->SourcePath, ARRAYSIZE(Job->SourcePath), SourcePath);
+    RtlStringCchCopyW(Job->TargetPath, ARRAYSIZE(Job->TargetPath), TargetPath);
+    QueueHeader->ExtractBuffer = NULL;
+
+    QueueHeader->WritePending = TRUE;
+    NtSetEvent(QueueHeader->WriteStartEvent, NULL);
+}
+
+/*
+ * Waits for the pending write, and sends the notifications of its copy
+ * that SetupCommitFileQueueW() has deferred. Returns FALSE if the queue
+ * commit has to stop.
+ */
+static BOOL
+SetupFinishPendingCopy(
+    IN OUT PFILEQUEUEHEADER QueueHeader,
+    IN PSP_FILE_CALLBACK_W MsgHandler,
+    IN PVOID Context OPTIONAL)
+{
+    PSETUP_WRITE_JOB Job = &QueueHeader->WriteJob;
+    BOOL Success = TRUE;
+    UINT Result;
+    FILEPATHS_W FilePathInfo;
+
+    if (!QueueHeader->WritePending)
+        return TRUE;
+
+    NtWaitForSingleObject(QueueHeader->WriteDoneEvent, FALSE, NULL);
+    QueueHeader->WritePending = FALSE;
+
+    FilePathInfo.Target = Job->TargetPath;
+    FilePathInfo.Source = Job->SourcePath;
+    FilePathInfo.Win32Error = STATUS_SUCCESS;
+    FilePathInfo.Flags = 0; // FIXME: Unused yet...
+
+    while (!NT_SUCCESS(Job->Status))
+    {
+        /* An error happened */
+        FilePathInfo.Win32Error = (UINT)Job->Status;
+        Result = MsgHandler(Context,
+                            SPFILENOTIFY_COPYERROR,
+                            (UINT_PTR)&FilePathInfo,
+                            (UINT_PTR)NULL); // FIXME: Unused yet...
+        if (Result == FILEOP_RETRY || Result == FILEOP_NEWPATH)
+        {
+            /* The file data is still in memory, write it again */
+            Job->Status = SetupWriteExtractedFile(Job);
+            continue;
+        }
+
+        if (Result != FILEOP_SKIP)
+            Success = FALSE;
+        break;
+    }
+
+    RtlFreeHeap(ProcessHeap, 0, Job->Buffer);
+    Job->Buffer = NULL;
+
+    /* This notification is always sent, even in case of error */
+    FilePathInfo.Win32Error = (UINT)Job->Status;
+    MsgHandler(Context,
+               SPFILENOTIFY_ENDCOPY,
+               (UINT_PTR)&FilePathInfo,
+               0);
+
+    return Success;
+}
+
 BOOL
 WINAPI
 SetupCommitFileQueueW(
@@ -629,6 +1123,7 @@ SetupCommitFileQueueW(
     FILEPATHS_W FilePathInfo;
     WCHAR FileSrcPath[MAX_PATH];
     WCHAR FileDstPath[MAX_PATH];
+    LARGE_INTEGER StartTime, EndTime, Frequency;
 
     if (QueueHandle == NULL)
         return FALSE;
@@ -847,6 +1342,15 @@ EndRename:
             Success = FALSE;
             goto Quit;
         }
+
+        NtQueryPerformanceCounter(&StartTime, &Frequency);
+
+        /*
+         * Copy the cabinet files in the order they are stored, and write
+         * them on a second thread while the next ones are uncompressed.
+         */
+        if (SetupSortCopyQueue(QueueHeader))
+            SetupStartWriter(QueueHeader);
     }
 
     for (ListEntry = QueueHeader->CopyQueue.Flink;
@@ -855,6 +1359,18 @@ EndRename:
     {
         Entry = CONTAINING_RECORD(ListEntry, QUEUEENTRY, ListEntry);
 
+        /* The pending write uses the current cabinet, complete it before leaving it */
+        if (QueueHeader->WritePending &&
+            (Entry->SourceCabinet == NULL ||
+             Entry->CabinetGroup != QueueHeader->WriteJob.CabinetGroup))
+        {
+            if (!SetupFinishPendingCopy(QueueHeader, MsgHandler, Context))
+            {
+                Success = FALSE;
+                goto Quit;
+            }
+        }
+
         //
         // TODO: Send a SPFILENOTIFY_NEEDMEDIA notification
         // when we switch to a new installation media.
@@ -961,6 +1477,24 @@ RetryCopy:
 
             Success = FALSE;
         }
+        else if (QueueHeader->ExtractBuffer != NULL)
+        {
+            /*
+             * The file has been extracted in memory: complete the previous
+             * file, then let the writer thread create this one while we go on.
+             * Its SPFILENOTIFY_ENDCOPY notification is sent once it is written.
+             */
+            if (!SetupFinishPendingCopy(QueueHeader, MsgHandler, Context))
+            {
+                RtlFreeHeap(ProcessHeap, 0, QueueHeader->ExtractBuffer);
+                QueueHeader->ExtractBuffer = NULL;
+                Success = FALSE;
+                goto EndCopy;
+            }
+
+            SetupSubmitWrite(QueueHeader, Entry, FileSrcPath, FileDstPath);
+            continue;
+        }
 
 EndCopy:
         /* This notification is always sent, even in case of error */
@@ -973,8 +1507,21 @@ EndCopy:
             goto Quit;
     }
 
+    if (!SetupFinishPendingCopy(QueueHeader, MsgHandler, Context))
+    {
+        Success = FALSE;
+        goto Quit;
+    }
+
     if (!IsListEmpty(&QueueHeader->CopyQueue))
     {
+        NtQueryPerformanceCounter(&EndTime, NULL);
+        if (Frequency.QuadPart != 0)
+        {
+            DPRINT1("Copied %lu files in %lu ms\n", QueueHeader->CopyCount,
+                    (ULONG)((EndTime.QuadPart - StartTime.QuadPart) * 1000 / Frequency.QuadPart));
+        }
+
         MsgHandler(Context,
                    SPFILENOTIFY_ENDSUBQUEUE,
                    FILEOP_COPY,
@@ -983,6 +1530,10 @@ EndCopy:
 
 
 Quit:
+    /* Complete the pending write, if we stopped in the middle of the copy queue */
+    SetupFinishPendingCopy(QueueHeader, MsgHandler, Context);
+    SetupStopWriter(QueueHeader);
+
     /* All the queues have been committed */
     MsgHandler(Context,
                SPFILENOTIFY_ENDQUEUE,
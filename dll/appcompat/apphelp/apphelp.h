@@ -90,6 +90,20 @@ typedef struct _DB_INFORMATION
 #include "sdbpapi.h"
 #endif
 
+/* Iteration state for SdbpFindFirstIndexedTag / SdbpFindNextIndexedTag */
+typedef struct _SDBINDEXFIND {
+    TAGID parent;
+    TAGID parent_end;
+    TAG find;
+    TAG nametag;
+    LPCWSTR find_name;
+    TAGID current;          /* last tag returned by a linear scan */
+    const BYTE* entries;    /* TAG_INDEX_BITS, or NULL when scanning linearly */
+    DWORD count;
+    DWORD next;
+    QWORD key;
+} SDBINDEXFIND, *PSDBINDEXFIND;
+
 /* sdbapi.c */
 PWSTR SdbpStrDup(LPCWSTR string);
 DWORD SdbpStrsize(PCWSTR string);
@@ -104,6 +118,8 @@ BOOL WINAPI SdbIsNullGUID(CONST GUID *Guid);
 HRESULT WINAPI SdbGetAppPatchDir(HSDB db, LPWSTR path, DWORD size);
 LPWSTR WINAPI SdbGetStringTagPtr(PDB pdb, TAGID tagid);
 TAGID WINAPI SdbFindFirstNamedTag(PDB pdb, TAGID root, TAGID find, TAGID nametag, LPCWSTR find_name);
+TAGID WINAPI SdbpFindFirstIndexedTag(PDB pdb, TAGID parent, TAG find, TAG nametag, LPCWSTR find_name, PSDBINDEXFIND state);
+TAGID WINAPI SdbpFindNextIndexedTag(PDB pdb, PSDBINDEXFIND state);
 DWORD WINAPI SdbQueryDataExTagID(PDB pdb, TAGID tiExe, LPCWSTR lpszDataName, LPDWORD lpdwDataType, LPVOID lpBuffer, LPDWORD lpcbBufferSize, TAGID *ptiData);
 BOOL WINAPI SdbGetDatabaseInformation(PDB pdb, PDB_INFORMATION information);
 VOID WINAPI SdbFreeDatabaseInformation(PDB_INFORMATION information);
@@ -115,12 +131,14 @@ TAG WINAPI SdbGetTagFromTagID(PDB pdb, TAGID tagid);
 TAGID WINAPI SdbFindFirstTag(PDB pdb, TAGID parent, TAG tag);
 TAGID WINAPI SdbFindNextTag(PDB pdb, TAGID parent, TAGID prev_child);
 BOOL WINAPI SdbGetDatabaseID(PDB pdb, GUID* Guid);
+WORD WINAPI SdbReadWORDTag(PDB pdb, TAGID tagid, WORD ret);
 DWORD WINAPI SdbReadDWORDTag(PDB pdb, TAGID tagid, DWORD ret);
 QWORD WINAPI SdbReadQWORDTag(PDB pdb, TAGID tagid, QWORD ret);
 TAGID WINAPI SdbGetFirstChild(PDB pdb, TAGID parent);
 TAGID WINAPI SdbGetNextChild(PDB pdb, TAGID parent, TAGID prev_child);
 DWORD WINAPI SdbGetTagDataSize(PDB pdb, TAGID tagid);
 LPWSTR WINAPI SdbpGetString(PDB pdb, TAGID tagid, PDWORD size);
+PVOID WINAPI SdbGetBinaryTagData(PDB pdb, TAGID tagid);
 
 
 /* sdbfileattr.c*/
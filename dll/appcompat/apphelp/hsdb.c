@@ -440,7 +440,8 @@ BOOL WINAPI SdbGetMatchingExe(HSDB hsdb, LPCWSTR path, LPCWSTR module_name,
                               LPCWSTR env, DWORD flags, PSDBQUERYRESULT result)
 {
     BOOL ret = FALSE;
-    TAGID database, iter, name;
+    TAGID database, iter;
+    SDBINDEXFIND find;
     PATTRINFO attribs = NULL;
     DWORD attr_count;
     RTL_UNICODE_STRING_BUFFER DosApplicationName = { { 0 } };
@@ -508,37 +509,28 @@ BOOL WINAPI SdbGetMatchingExe(HSDB hsdb, LPCWSTR path, LPCWSTR module_name,
         goto Cleanup;
     }
 
-    /* EXE is list TAG which contains data required to match executable */
-    iter = SdbFindFirstTag(pdb, database, TAG_EXE);
-
-    /* Search for entry in database, we should look into indexing tags! */
+    /* EXE is list TAG which contains data required to match executable,
+       look it up by name through the database index when there is one. */
+    iter = SdbpFindFirstIndexedTag(pdb, database, TAG_EXE, TAG_NAME, file_name, &find);
     while (iter != TAGID_NULL)
     {
-        LPWSTR foundName;
-        /* Check if exe name matches */
-        name = SdbFindFirstTag(pdb, iter, TAG_NAME);
-        /* If this is a malformed DB, (no TAG_NAME), we should not crash. */
-        foundName = SdbGetStringTagPtr(pdb, name);
-        if (foundName && !wcsicmp(foundName, file_name))
+        /* Get information about executable required to match it with database entry */
+        if (!attribs)
         {
-            /* Get information about executable required to match it with database entry */
-            if (!attribs)
-            {
-                if (!SdbGetFileAttributes(path, &attribs, &attr_count))
-                    goto Cleanup;
-            }
+            if (!SdbGetFileAttributes(path, &attribs, &attr_count))
+                goto Cleanup;
+        }
 
 
-            /* We have a null terminator before the application name, so DosApplicationName only contains the path. */
-            if (SdbpMatchExe(pdb, iter, DosApplicationName.String.Buffer, attribs, attr_count))
-            {
-                ret = TRUE;
-                SdbpAddExeMatch(hsdb, pdb, iter, result);
-            }
+        /* We have a null terminator before the application name, so DosApplicationName only contains the path. */
+        if (SdbpMatchExe(pdb, iter, DosApplicationName.String.Buffer, attribs, attr_count))
+        {
+            ret = TRUE;
+            SdbpAddExeMatch(hsdb, pdb, iter, result);
         }
 
         /* Continue iterating */
-        iter = SdbFindNextTag(pdb, database, iter);
+        iter = SdbpFindNextIndexedTag(pdb, &find);
     }
 
     /* Restore the full path. */
@@ -530,37 +530,194 @@ VOID WINAPI SdbFreeDatabaseInformation(PDB_INFORMATION information)
 }
 
 
+/* Entry of TAG_INDEX_BITS: the key of the indexed tag followed by its TAGID,
+   sorted by key and then by TAGID. The data is not necessarily aligned. */
+#include <pshpack1.h>
+typedef struct _SDBINDEXENTRY {
+    QWORD key;
+    TAGID tagid;
+} SDBINDEXENTRY;
+#include <poppack.h>
+
+#define SHIMDB_INDEX_UNIQUE_KEY 0x1
+
+/* Build the index key of an ASCII name, see SdbMakeIndexKeyFromString.
+   Names that need a locale for case folding are not looked up in the index. */
+static BOOL SdbpMakeAsciiIndexKey(LPCWSTR name, QWORD* key)
+{
+    QWORD result = 0;
+    int shift = 56;
+
+    for (; *name && shift >= 0; ++name, shift -= 8)
+    {
+        WCHAR c = *name;
+        if (c >= 0x80)
+            return FALSE;
+        if (c >= 'a' && c <= 'z')
+            c -= 'a' - 'A';
+        result |= ((QWORD)c) << shift;
+    }
+
+    *key = result;
+    return TRUE;
+}
+
+static const BYTE* SdbpGetIndexEntries(PDB pdb, TAG find, TAG nametag, PDWORD count)
+{
+    TAGID indexes, index, bits;
+    DWORD size;
+
+    indexes = SdbFindFirstTag(pdb, TAGID_ROOT, TAG_INDEXES);
+    if (indexes == TAGID_NULL)
+        return NULL;
+
+    for (index = SdbFindFirstTag(pdb, indexes, TAG_INDEX); index != TAGID_NULL;
+         index = SdbFindNextTag(pdb, indexes, index))
+    {
+        if (SdbReadWORDTag(pdb, SdbFindFirstTag(pdb, index, TAG_INDEX_TAG), TAG_NULL) != find ||
+            SdbReadWORDTag(pdb, SdbFindFirstTag(pdb, index, TAG_INDEX_KEY), TAG_NULL) != nametag)
+        {
+            continue;
+        }
+
+        /* Unique-key indexes only reference the first of a run of tags */
+        if (SdbReadDWORDTag(pdb, SdbFindFirstTag(pdb, index, TAG_INDEX_FLAGS), 0) & SHIMDB_INDEX_UNIQUE_KEY)
+            return NULL;
+
+        bits = SdbFindFirstTag(pdb, index, TAG_INDEX_BITS);
+        size = SdbGetTagDataSize(pdb, bits);
+        if (bits == TAGID_NULL || size > pdb->size - bits - sizeof(TAG) - sizeof(DWORD))
+            return NULL;
+
+        *count = size / sizeof(SDBINDEXENTRY);
+        return SdbGetBinaryTagData(pdb, bits);
+    }
+
+    return NULL;
+}
+
+static BOOL SdbpIsNamedTag(PDB pdb, TAGID tagid, TAG nametag, LPCWSTR find_name)
+{
+    LPCWSTR name = SdbGetStringTagPtr(pdb, SdbFindFirstTag(pdb, tagid, nametag));
+    return name && !wcsicmp(name, find_name);
+}
+
 /**
- * Find the first named child tag.
+ * Find the first child tag with the specified name, using the database index when one is available.
  *
  * @param [in]  pdb         The database.
- * @param [in]  root        The tag to start at
+ * @param [in]  parent      The tag to start at
  * @param [in]  find        The tag type to find
  * @param [in]  nametag     The child of 'find' that contains the name
  * @param [in]  find_name   The name to find
+ * @param [out] state       Iteration state for SdbpFindNextIndexedTag
  *
  * @return  The found tag, or TAGID_NULL on failure
  */
-TAGID WINAPI SdbFindFirstNamedTag(PDB pdb, TAGID root, TAGID find, TAGID nametag, LPCWSTR find_name)
+TAGID WINAPI SdbpFindFirstIndexedTag(PDB pdb, TAGID parent, TAG find, TAG nametag, LPCWSTR find_name, PSDBINDEXFIND state)
 {
-    TAGID iter;
+    DWORD lo, hi;
+
+    ZeroMemory(state, sizeof(*state));
+    state->parent = parent;
+    state->find = find;
+    state->nametag = nametag;
+    state->find_name = find_name;
+
+    /* The index covers the whole database, so it is only used for children of a list */
+    if (parent != TAGID_ROOT && SdbpMakeAsciiIndexKey(find_name, &state->key))
+        state->entries = SdbpGetIndexEntries(pdb, find, nametag, &state->count);
+
+    if (!state->entries)
+    {
+        state->current = SdbFindFirstTag(pdb, parent, find);
+        if (state->current != TAGID_NULL && !SdbpIsNamedTag(pdb, state->current, nametag, find_name))
+            return SdbpFindNextIndexedTag(pdb, state);
+        return state->current;
+    }
 
-    iter = SdbFindFirstTag(pdb, root, find);
+    state->parent_end = parent + sizeof(TAG) + sizeof(DWORD) + SdbGetTagDataSize(pdb, parent);
 
-    while (iter != TAGID_NULL)
+    /* Lower bound of the key */
+    lo = 0;
+    hi = state->count;
+    while (lo < hi)
     {
-        TAGID tmp = SdbFindFirstTag(pdb, iter, nametag);
-        if (tmp != TAGID_NULL)
+        DWORD mid = lo + (hi - lo) / 2;
+        const SDBINDEXENTRY* entry = (const SDBINDEXENTRY*)state->entries + mid;
+        if (entry->key < state->key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    state->next = lo;
+
+    return SdbpFindNextIndexedTag(pdb, state);
+}
+
+/**
+ * Find the next child tag with the name passed to SdbpFindFirstIndexedTag.
+ *
+ * @param [in]  pdb         The database.
+ * @param [in,out] state    Iteration state from SdbpFindFirstIndexedTag
+ *
+ * @return  The found tag, or TAGID_NULL when there are no more matches
+ */
+TAGID WINAPI SdbpFindNextIndexedTag(PDB pdb, PSDBINDEXFIND state)
+{
+    if (!state->entries)
+    {
+        while (state->current != TAGID_NULL)
         {
-            LPCWSTR name = SdbGetStringTagPtr(pdb, tmp);
-            if (name && !wcsicmp(name, find_name))
-                return iter;
+            state->current = SdbFindNextTag(pdb, state->parent, state->current);
+            if (state->current != TAGID_NULL &&
+                SdbpIsNamedTag(pdb, state->current, state->nametag, state->find_name))
+            {
+                break;
+            }
         }
-        iter = SdbFindNextTag(pdb, root, iter);
+        return state->current;
     }
+
+    while (state->next < state->count)
+    {
+        const SDBINDEXENTRY* entry = (const SDBINDEXENTRY*)state->entries + state->next;
+        TAGID tagid = entry->tagid;
+
+        if (entry->key != state->key)
+            break;
+        state->next++;
+
+        /* Keys only cover a prefix of the name, and the index may cover other parents */
+        if (tagid > state->parent && tagid < state->parent_end &&
+            SdbGetTagFromTagID(pdb, tagid) == state->find &&
+            SdbpIsNamedTag(pdb, tagid, state->nametag, state->find_name))
+        {
+            return tagid;
+        }
+    }
+
+    state->next = state->count;
     return TAGID_NULL;
 }
 
+/**
+ * Find the first named child tag.
+ *
+ * @param [in]  pdb         The database.
+ * @param [in]  root        The tag to start at
+ * @param [in]  find        The tag type to find
+ * @param [in]  nametag     The child of 'find' that contains the name
+ * @param [in]  find_name   The name to find
+ *
+ * @return  The found tag, or TAGID_NULL on failure
+ */
+TAGID WINAPI SdbFindFirstNamedTag(PDB pdb, TAGID root, TAGID find, TAGID nametag, LPCWSTR find_name)
+{
+    SDBINDEXFIND state;
+    return SdbpFindFirstIndexedTag(pdb, root, find, nametag, find_name, &state);
+}
+
 
 /**
  * Find a named layer in a multi-db.
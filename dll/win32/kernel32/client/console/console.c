@@ -1147,6 +1147,9 @@ CloseConsoleHandle(HANDLE hHandle)
     CloseHandleRequest->ConsoleHandle = NtCurrentPeb()->ProcessParameters->ConsoleHandle;
     CloseHandleRequest->Handle        = hHandle;
 
+    /* Stop queuing output for this handle (the server writes out what is queued first) */
+    ForgetConsoleOutputRing(hHandle);
+
     CsrClientCallServer((PCSR_API_MESSAGE)&ApiMessage,
                         NULL,
                         CSR_CREATE_API_NUMBER(CONSRV_SERVERDLL_INDEX, ConsolepCloseHandle),
@@ -1460,6 +1463,9 @@ FreeConsole(VOID)
         goto Quit;
     }
 
+    /* Stop using our output ring, the server writes out what is left in it and unmaps it */
+    ForgetConsoleOutputRing(NULL);
+
     /* Set up the data to send to the Console Server */
     FreeConsoleRequest->ConsoleHandle = ConsoleHandle;
 
@@ -22,6 +22,7 @@
 /* GLOBALS ********************************************************************/
 
 RTL_CRITICAL_SECTION ConsoleLock;
+RTL_CRITICAL_SECTION ConsoleOutputRingLock;
 BOOLEAN ConsoleInitialized = FALSE;
 extern HANDLE InputWaitHandle;
 
@@ -356,7 +357,11 @@ ConDllInitialize(IN ULONG Reason,
             /* Free our resources */
             if (ConsoleInitialized != FALSE)
             {
+                /* Have what is still queued for output written out before we go */
+                FlushConsoleOutputRing();
+
                 ConsoleInitialized = FALSE;
+                RtlDeleteCriticalSection(&ConsoleOutputRingLock);
                 RtlDeleteCriticalSection(&ConsoleLock);
             }
         }
@@ -375,6 +380,12 @@ ConDllInitialize(IN ULONG Reason,
     /* Initialize our global console DLL lock */
     Status = RtlInitializeCriticalSection(&ConsoleLock);
     if (!NT_SUCCESS(Status)) return FALSE;
+    Status = RtlInitializeCriticalSection(&ConsoleOutputRingLock);
+    if (!NT_SUCCESS(Status))
+    {
+        RtlDeleteCriticalSection(&ConsoleLock);
+        return FALSE;
+    }
     ConsoleInitialized = TRUE;
 
     /* Show by default the console window when applicable */
@@ -25,6 +25,21 @@
     (((Rect)->Left > (Rect)->Right) ? 0 : ((Rect)->Right - (Rect)->Left + 1))
 
 
+extern RTL_CRITICAL_SECTION ConsoleOutputRingLock;
+
+/*
+ * Shared memory ring through which WriteConsole text is queued for the
+ * server without calling it, see CONSOLE_OUTPUT_RING. It is only used for
+ * the output handle of the last write that went through the server, so that
+ * the server has validated it. All these are protected by ConsoleOutputRingLock.
+ */
+static PCONSOLE_OUTPUT_RING OutputRing = NULL;
+static HANDLE OutputRingEvent = NULL;
+static HANDLE OutputRingConsole = NULL;
+static HANDLE OutputRingHandle = NULL;
+static BOOLEAN OutputRingRequested = FALSE;
+
+
 /* PRIVATE FUNCTIONS **********************************************************/
 
 /******************
@@ -593,6 +608,154 @@ IntReadConsoleOutputCode(IN HANDLE hConsoleOutput,
  * Write functions *
  *******************/
 
+/* Queues text in the output ring. Returns FALSE if it must go through the server. */
+static
+BOOLEAN
+IntWriteConsoleRing(IN HANDLE hConsoleOutput,
+                    IN PVOID lpBuffer,
+                    IN ULONG SizeBytes,
+                    IN BOOLEAN bUnicode)
+{
+    PCONSOLE_OUTPUT_RECORD Record;
+    ULONG WriteOffset, Position, RecordSize, Skip;
+    BOOLEAN Queued = FALSE;
+
+    if (SizeBytes > CONSOLE_OUTPUT_RING_MAX_WRITE)
+        return FALSE;
+
+    RtlEnterCriticalSection(&ConsoleOutputRingLock);
+
+    /* While the console is paused the server makes our writes wait */
+    if (!OutputRing ||
+        hConsoleOutput != OutputRingHandle ||
+        OutputRingConsole != NtCurrentPeb()->ProcessParameters->ConsoleHandle ||
+        (OutputRing->Flags & CONSOLE_OUTPUT_RING_PAUSED))
+    {
+        goto Quit;
+    }
+
+    /* A record does not wrap around, skip what is left at the end if it does not fit */
+    WriteOffset = OutputRing->WriteOffset;
+    Position = WriteOffset % CONSOLE_OUTPUT_RING_SIZE;
+    RecordSize = ALIGN_UP_BY(sizeof(*Record) + SizeBytes, CONSOLE_OUTPUT_RING_ALIGN);
+    Skip = (RecordSize > CONSOLE_OUTPUT_RING_SIZE - Position) ? CONSOLE_OUTPUT_RING_SIZE - Position : 0;
+
+    if (WriteOffset - OutputRing->ReadOffset + Skip + RecordSize > CONSOLE_OUTPUT_RING_SIZE)
+        goto Quit;
+
+    if (Skip)
+    {
+        ((PCONSOLE_OUTPUT_RECORD)&OutputRing->Data[Position])->OutputHandle = NULL;
+        Position = 0;
+    }
+
+    Record = (PCONSOLE_OUTPUT_RECORD)&OutputRing->Data[Position];
+    _SEH2_TRY
+    {
+        RtlCopyMemory(Record + 1, lpBuffer, SizeBytes);
+        Queued = TRUE;
+    }
+    _SEH2_EXCEPT(EXCEPTION_EXECUTE_HANDLER)
+    {
+        /* Let the server path report the error */
+        Queued = FALSE;
+    }
+    _SEH2_END;
+
+    if (!Queued) goto Quit;
+
+    Record->OutputHandle = hConsoleOutput;
+    Record->NumBytes = SizeBytes;
+    Record->Unicode = bUnicode;
+
+    /*
+     * Publish the record, then wake the server up if it had emptied the ring:
+     * otherwise it is still draining it and will see the record.
+     */
+    InterlockedExchange((PLONG)&OutputRing->WriteOffset, WriteOffset + Skip + RecordSize);
+    if (OutputRing->ReadOffset == WriteOffset)
+        NtSetEvent(OutputRingEvent, NULL);
+
+Quit:
+    RtlLeaveCriticalSection(&ConsoleOutputRingLock);
+    return Queued;
+}
+
+/* Sets up the output ring if needed, and uses it for this handle from now on */
+static
+VOID
+IntUseConsoleOutputRing(IN HANDLE hConsoleOutput)
+{
+    CONSOLE_API_MESSAGE ApiMessage;
+    PCONSOLE_MAPOUTPUTRING MapOutputRingRequest = &ApiMessage.Data.MapOutputRingRequest;
+
+    RtlEnterCriticalSection(&ConsoleOutputRingLock);
+
+    if (!OutputRingRequested)
+    {
+        /* Ask only once, the server may not want to give us one */
+        OutputRingRequested = TRUE;
+
+        MapOutputRingRequest->ConsoleHandle = NtCurrentPeb()->ProcessParameters->ConsoleHandle;
+        CsrClientCallServer((PCSR_API_MESSAGE)&ApiMessage,
+                            NULL,
+                            CSR_CREATE_API_NUMBER(CONSRV_SERVERDLL_INDEX, ConsolepMapOutputRing),
+                            sizeof(*MapOutputRingRequest));
+        if (NT_SUCCESS(ApiMessage.Status))
+        {
+            OutputRing = MapOutputRingRequest->Ring;
+            OutputRingEvent = MapOutputRingRequest->Event;
+            OutputRingConsole = MapOutputRingRequest->ConsoleHandle;
+        }
+    }
+
+    OutputRingHandle = hConsoleOutput;
+
+    RtlLeaveCriticalSection(&ConsoleOutputRingLock);
+}
+
+/* Stops using the output ring for a handle, or altogether if none is given */
+VOID
+ForgetConsoleOutputRing(IN HANDLE hConsoleOutput OPTIONAL)
+{
+    RtlEnterCriticalSection(&ConsoleOutputRingLock);
+
+    if (hConsoleOutput == NULL || hConsoleOutput == OutputRingHandle)
+        OutputRingHandle = NULL;
+
+    if (hConsoleOutput == NULL)
+    {
+        if (OutputRingEvent) NtClose(OutputRingEvent);
+        OutputRing = NULL;
+        OutputRingEvent = NULL;
+        OutputRingConsole = NULL;
+        OutputRingRequested = FALSE;
+    }
+
+    RtlLeaveCriticalSection(&ConsoleOutputRingLock);
+}
+
+/* Has the server write out what is queued in the output ring */
+VOID
+FlushConsoleOutputRing(VOID)
+{
+    CONSOLE_API_MESSAGE ApiMessage;
+    PCONSOLE_FLUSHOUTPUTRING FlushOutputRingRequest = &ApiMessage.Data.FlushOutputRingRequest;
+    BOOLEAN Queued;
+
+    RtlEnterCriticalSection(&ConsoleOutputRingLock);
+    Queued = (OutputRing && OutputRing->ReadOffset != OutputRing->WriteOffset);
+    RtlLeaveCriticalSection(&ConsoleOutputRingLock);
+
+    if (!Queued) return;
+
+    FlushOutputRingRequest->ConsoleHandle = NtCurrentPeb()->ProcessParameters->ConsoleHandle;
+    CsrClientCallServer((PCSR_API_MESSAGE)&ApiMessage,
+                        NULL,
+                        CSR_CREATE_API_NUMBER(CONSRV_SERVERDLL_INDEX, ConsolepFlushOutputRing),
+                        sizeof(*FlushOutputRingRequest));
+}
+
 static
 BOOL
 IntWriteConsole(IN HANDLE hConsoleOutput,
@@ -623,6 +786,23 @@ IntWriteConsole(IN HANDLE hConsoleOutput,
     CharSize  = (bUnicode ? sizeof(WCHAR) : sizeof(CHAR));
     SizeBytes = nNumberOfCharsToWrite * CharSize;
 
+    /* Queue it without calling the server if we can */
+    if (IntWriteConsoleRing(hConsoleOutput, lpBuffer, SizeBytes, bUnicode))
+    {
+        _SEH2_TRY
+        {
+            *lpNumberOfCharsWritten = nNumberOfCharsToWrite;
+        }
+        _SEH2_EXCEPT(EXCEPTION_EXECUTE_HANDLER)
+        {
+            SetLastError(ERROR_INVALID_ACCESS);
+            _SEH2_YIELD(return FALSE);
+        }
+        _SEH2_END;
+
+        return TRUE;
+    }
+
     WriteConsoleRequest->NumBytes = SizeBytes;
 
     /*
@@ -684,6 +864,9 @@ IntWriteConsole(IN HANDLE hConsoleOutput,
     /* Retrieve the results */
     if (Success)
     {
+        /* The server accepted this handle, queue the next writes to it */
+        IntUseConsoleOutputRing(hConsoleOutput);
+
         _SEH2_TRY
         {
             *lpNumberOfCharsWritten = WriteConsoleRequest->NumBytes / CharSize;
@@ -19,9 +19,137 @@
 DEBUG_CHANNEL(kernel32file);
 #endif
 
+/* DEFINES *****************************************************************/
+
+/* Number of chunks in flight: one being written, the others being read */
+#define COPY_BUFFER_COUNT   4
+
+/* Bounds of the chunk size for files that need more than one chunk */
+#define COPY_MIN_CHUNK_SIZE 0x10000
+#define COPY_MAX_CHUNK_SIZE 0x100000
+
+typedef struct _COPY_BUFFER
+{
+    PUCHAR Data;
+    HANDLE Event;
+    LARGE_INTEGER ByteOffset;
+    IO_STATUS_BLOCK IoStatusBlock;
+    NTSTATUS Status;
+    BOOLEAN Pending;
+} COPY_BUFFER, *PCOPY_BUFFER;
+
 /* FUNCTIONS ****************************************************************/
 
+/*
+ * Picks the size of the chunks a file is copied in. Small files get a single
+ * chunk one byte larger than them, so their only read also finds the end of
+ * file. Larger files are read in up to 1 MB chunks, aligned for the
+ * unbuffered reads on the source.
+ */
+static ULONG
+CopyGetChunkSize(
+    HANDLE			FileHandleSource,
+    LARGE_INTEGER		SourceFileSize
+)
+{
+    NTSTATUS errCode;
+    IO_STATUS_BLOCK IoStatusBlock;
+    FILE_FS_SIZE_INFORMATION FileFsSize;
+    ULONG Alignment = PAGE_SIZE;
+    ULONG ChunkSize;
+
+    errCode = NtQueryVolumeInformationFile(FileHandleSource,
+                                           &IoStatusBlock,
+                                           &FileFsSize,
+                                           sizeof(FILE_FS_SIZE_INFORMATION),
+                                           FileFsSizeInformation);
+    if (NT_SUCCESS(errCode) && FileFsSize.BytesPerSector > Alignment)
+    {
+        Alignment = FileFsSize.BytesPerSector;
+    }
+
+    if (SourceFileSize.QuadPart < COPY_MIN_CHUNK_SIZE)
+    {
+        return ROUND_UP(SourceFileSize.LowPart + 1, Alignment);
+    }
+
+    if (SourceFileSize.QuadPart / 8 >= COPY_MAX_CHUNK_SIZE)
+    {
+        ChunkSize = COPY_MAX_CHUNK_SIZE;
+    }
+    else
+    {
+        ChunkSize = max((ULONG)(SourceFileSize.QuadPart / 8) & ~(COPY_MIN_CHUNK_SIZE - 1),
+                        COPY_MIN_CHUNK_SIZE);
+    }
+
+    return ROUND_UP(ChunkSize, Alignment);
+}
 
+static NTSTATUS
+CopyStartIo(
+    HANDLE			FileHandle,
+    PCOPY_BUFFER		Buffer,
+    ULONG			Length,
+    BOOL			Write
+)
+{
+    if (Write)
+    {
+        Buffer->Status = NtWriteFile(FileHandle,
+                                     Buffer->Event,
+                                     NULL,
+                                     NULL,
+                                     &Buffer->IoStatusBlock,
+                                     Buffer->Data,
+                                     Length,
+                                     &Buffer->ByteOffset,
+                                     NULL);
+    }
+    else
+    {
+        Buffer->Status = NtReadFile(FileHandle,
+                                    Buffer->Event,
+                                    NULL,
+                                    NULL,
+                                    &Buffer->IoStatusBlock,
+                                    Buffer->Data,
+                                    Length,
+                                    &Buffer->ByteOffset,
+                                    NULL);
+    }
+
+    Buffer->Pending = (Buffer->Status == STATUS_PENDING);
+    if (!Buffer->Pending && !NT_SUCCESS(Buffer->Status))
+    {
+        /* Failed right away, the I/O status block may not have been written */
+        Buffer->IoStatusBlock.Status = Buffer->Status;
+        Buffer->IoStatusBlock.Information = 0;
+    }
+
+    return Buffer->Status;
+}
+
+static NTSTATUS
+CopyWaitIo(
+    PCOPY_BUFFER		Buffer
+)
+{
+    if (Buffer->Pending)
+    {
+        NtWaitForSingleObject(Buffer->Event, FALSE, NULL);
+        Buffer->Status = Buffer->IoStatusBlock.Status;
+        Buffer->Pending = FALSE;
+    }
+
+    return Buffer->Status;
+}
+
+/*
+ * Copies the file through a ring of buffers. While a chunk is written to the
+ * destination, the chunks after it are already being read from the source,
+ * so neither side waits for the other.
+ */
 static NTSTATUS
 CopyLoop (
     HANDLE			FileHandleSource,
@@ -35,130 +163,228 @@ CopyLoop (
 {
     NTSTATUS errCode;
     IO_STATUS_BLOCK IoStatusBlock;
+    FILE_ALLOCATION_INFORMATION FileAllocation;
+    COPY_BUFFER Buffers[COPY_BUFFER_COUNT];
+    PCOPY_BUFFER Buffer;
     UCHAR *lpBuffer = NULL;
-    SIZE_T RegionSize = 0x10000;
-    LARGE_INTEGER BytesCopied;
-    DWORD CallbackReason;
+    SIZE_T RegionSize;
+    ULONG ChunkSize, BufferCount, Head, Length, i;
+    LARGE_INTEGER BytesCopied, ReadOffset;
     DWORD ProgressResult;
     BOOL EndOfFileFound;
 
     *KeepDest = FALSE;
+
+    ChunkSize = CopyGetChunkSize(FileHandleSource, SourceFileSize);
+    if (SourceFileSize.QuadPart / ChunkSize >= COPY_BUFFER_COUNT - 1)
+    {
+        BufferCount = COPY_BUFFER_COUNT;
+    }
+    else
+    {
+        BufferCount = (ULONG)(SourceFileSize.QuadPart / ChunkSize) + 1;
+    }
+
+    RegionSize = (SIZE_T)ChunkSize * BufferCount;
     errCode = NtAllocateVirtualMemory(NtCurrentProcess(),
                                       (PVOID *)&lpBuffer,
                                       0,
                                       &RegionSize,
                                       MEM_RESERVE | MEM_COMMIT,
                                       PAGE_READWRITE);
+    if (!NT_SUCCESS(errCode))
+    {
+        TRACE("Error 0x%08x allocating buffer of %lu bytes\n", errCode, RegionSize);
+        return errCode;
+    }
 
-    if (NT_SUCCESS(errCode))
+    for (i = 0; i < BufferCount; i++)
     {
-        BytesCopied.QuadPart = 0;
-        EndOfFileFound = FALSE;
-        CallbackReason = CALLBACK_STREAM_SWITCH;
-        while (! EndOfFileFound &&
-                NT_SUCCESS(errCode) &&
-                (NULL == pbCancel || ! *pbCancel))
+        Buffers[i].Data = lpBuffer + i * ChunkSize;
+        Buffers[i].Pending = FALSE;
+        errCode = NtCreateEvent(&Buffers[i].Event,
+                                EVENT_ALL_ACCESS,
+                                NULL,
+                                NotificationEvent,
+                                FALSE);
+        if (!NT_SUCCESS(errCode))
         {
-            if (NULL != lpProgressRoutine)
-            {
-                ProgressResult = (*lpProgressRoutine)(SourceFileSize,
-                                                      BytesCopied,
-                                                      SourceFileSize,
-                                                      BytesCopied,
-                                                      0,
-                                                      CallbackReason,
-                                                      FileHandleSource,
-                                                      FileHandleDest,
-                                                      lpData);
-                switch (ProgressResult)
-                {
-                case PROGRESS_CANCEL:
-                    TRACE("Progress callback requested cancel\n");
-                    errCode = STATUS_REQUEST_ABORTED;
-                    break;
-                case PROGRESS_STOP:
-                    TRACE("Progress callback requested stop\n");
-                    errCode = STATUS_REQUEST_ABORTED;
-                    *KeepDest = TRUE;
-                    break;
-                case PROGRESS_QUIET:
-                    lpProgressRoutine = NULL;
-                    break;
-                case PROGRESS_CONTINUE:
-                default:
-                    break;
-                }
-                CallbackReason = CALLBACK_CHUNK_FINISHED;
-            }
-            if (NT_SUCCESS(errCode))
+            TRACE("Error 0x%08x creating event\n", errCode);
+            BufferCount = i;
+            break;
+        }
+    }
+
+    /* Let the file system lay out the whole destination at once */
+    if (NT_SUCCESS(errCode) && SourceFileSize.QuadPart > ChunkSize)
+    {
+        FileAllocation.AllocationSize = SourceFileSize;
+        if (!NT_SUCCESS(NtSetInformationFile(FileHandleDest,
+                                             &IoStatusBlock,
+                                             &FileAllocation,
+                                             sizeof(FILE_ALLOCATION_INFORMATION),
+                                             FileAllocationInformation)))
+        {
+            TRACE("Cannot preallocate %I64u bytes for dest\n", SourceFileSize.QuadPart);
+        }
+    }
+
+    BytesCopied.QuadPart = 0;
+    EndOfFileFound = FALSE;
+    if (NT_SUCCESS(errCode) && NULL != lpProgressRoutine)
+    {
+        ProgressResult = (*lpProgressRoutine)(SourceFileSize,
+                                              BytesCopied,
+                                              SourceFileSize,
+                                              BytesCopied,
+                                              0,
+                                              CALLBACK_STREAM_SWITCH,
+                                              FileHandleSource,
+                                              FileHandleDest,
+                                              lpData);
+        switch (ProgressResult)
+        {
+        case PROGRESS_CANCEL:
+            TRACE("Progress callback requested cancel\n");
+            errCode = STATUS_REQUEST_ABORTED;
+            break;
+        case PROGRESS_STOP:
+            TRACE("Progress callback requested stop\n");
+            errCode = STATUS_REQUEST_ABORTED;
+            *KeepDest = TRUE;
+            break;
+        case PROGRESS_QUIET:
+            lpProgressRoutine = NULL;
+            break;
+        case PROGRESS_CONTINUE:
+        default:
+            break;
+        }
+    }
+
+    /* Start reading ahead into every buffer */
+    ReadOffset.QuadPart = 0;
+    for (i = 0; i < BufferCount && NT_SUCCESS(errCode); i++)
+    {
+        if (NULL != pbCancel && *pbCancel)
+            break;
+
+        Buffers[i].ByteOffset = ReadOffset;
+        CopyStartIo(FileHandleSource, &Buffers[i], ChunkSize, FALSE);
+        ReadOffset.QuadPart += ChunkSize;
+    }
+
+    Head = 0;
+    while (NT_SUCCESS(errCode) &&
+           (NULL == pbCancel || ! *pbCancel))
+    {
+        Buffer = &Buffers[Head];
+
+        errCode = CopyWaitIo(Buffer);
+        /* With sync read, 0 length + status success mean EOF:
+         * https://msdn.microsoft.com/en-us/library/windows/desktop/aa365467(v=vs.85).aspx
+         */
+        if (STATUS_END_OF_FILE == errCode ||
+            (NT_SUCCESS(errCode) && Buffer->IoStatusBlock.Information == 0))
+        {
+            EndOfFileFound = TRUE;
+            errCode = STATUS_SUCCESS;
+            break;
+        }
+        if (!NT_SUCCESS(errCode))
+        {
+            WARN("Error 0x%08x reading from source\n", errCode);
+            break;
+        }
+        if (NULL != pbCancel && *pbCancel)
+        {
+            break;
+        }
+
+        /* The reads of the next chunks go on while this one is written */
+        Length = (ULONG)Buffer->IoStatusBlock.Information;
+        errCode = CopyStartIo(FileHandleDest, Buffer, Length, TRUE);
+        if (NT_SUCCESS(errCode))
+        {
+            errCode = CopyWaitIo(Buffer);
+        }
+        if (!NT_SUCCESS(errCode))
+        {
+            WARN("Error 0x%08x reading writing to dest\n", errCode);
+            break;
+        }
+        BytesCopied.QuadPart += Buffer->IoStatusBlock.Information;
+
+        if (NULL != lpProgressRoutine)
+        {
+            ProgressResult = (*lpProgressRoutine)(SourceFileSize,
+                                                  BytesCopied,
+                                                  SourceFileSize,
+                                                  BytesCopied,
+                                                  0,
+                                                  CALLBACK_CHUNK_FINISHED,
+                                                  FileHandleSource,
+                                                  FileHandleDest,
+                                                  lpData);
+            switch (ProgressResult)
             {
-                errCode = NtReadFile(FileHandleSource,
-                                     NULL,
-                                     NULL,
-                                     NULL,
-                                     (PIO_STATUS_BLOCK)&IoStatusBlock,
-                                     lpBuffer,
-                                     RegionSize,
-                                     NULL,
-                                     NULL);
-                /* With sync read, 0 length + status success mean EOF:
-                 * https://msdn.microsoft.com/en-us/library/windows/desktop/aa365467(v=vs.85).aspx
-                 */
-                if (NT_SUCCESS(errCode) && IoStatusBlock.Information == 0)
-                {
-                    errCode = STATUS_END_OF_FILE;
-                }
-                if (NT_SUCCESS(errCode) && (NULL == pbCancel || ! *pbCancel))
-                {
-                    errCode = NtWriteFile(FileHandleDest,
-                                          NULL,
-                                          NULL,
-                                          NULL,
-                                          (PIO_STATUS_BLOCK)&IoStatusBlock,
-                                          lpBuffer,
-                                          IoStatusBlock.Information,
-                                          NULL,
-                                          NULL);
-                    if (NT_SUCCESS(errCode))
-                    {
-                        BytesCopied.QuadPart += IoStatusBlock.Information;
-                    }
-                    else
-                    {
-                        WARN("Error 0x%08x reading writing to dest\n", errCode);
-                    }
-                }
-                else if (!NT_SUCCESS(errCode))
-                {
-                    if (STATUS_END_OF_FILE == errCode)
-                    {
-                        EndOfFileFound = TRUE;
-                        errCode = STATUS_SUCCESS;
-                    }
-                    else
-                    {
-                        WARN("Error 0x%08x reading from source\n", errCode);
-                    }
-                }
+            case PROGRESS_CANCEL:
+                TRACE("Progress callback requested cancel\n");
+                errCode = STATUS_REQUEST_ABORTED;
+                break;
+            case PROGRESS_STOP:
+                TRACE("Progress callback requested stop\n");
+                errCode = STATUS_REQUEST_ABORTED;
+                *KeepDest = TRUE;
+                break;
+            case PROGRESS_QUIET:
+                lpProgressRoutine = NULL;
+                break;
+            case PROGRESS_CONTINUE:
+            default:
+                break;
             }
         }
 
-        if (! EndOfFileFound && (NULL != pbCancel && *pbCancel))
+        /* Unbuffered reads only come back short at the end of the file */
+        if (Length < ChunkSize)
         {
-            TRACE("User requested cancel\n");
-            errCode = STATUS_REQUEST_ABORTED;
+            EndOfFileFound = TRUE;
+            break;
         }
 
-        NtFreeVirtualMemory(NtCurrentProcess(),
-                            (PVOID *)&lpBuffer,
-                            &RegionSize,
-                            MEM_RELEASE);
+        if (NT_SUCCESS(errCode))
+        {
+            Buffer->ByteOffset = ReadOffset;
+            CopyStartIo(FileHandleSource, Buffer, ChunkSize, FALSE);
+            ReadOffset.QuadPart += ChunkSize;
+            Head = (Head + 1) % BufferCount;
+        }
     }
-    else
+
+    if (! EndOfFileFound && (NULL != pbCancel && *pbCancel))
     {
-        TRACE("Error 0x%08x allocating buffer of %lu bytes\n", errCode, RegionSize);
+        TRACE("User requested cancel\n");
+        errCode = STATUS_REQUEST_ABORTED;
+    }
+
+    /* Reads past the end of the file or past a failure may still be going on */
+    if (!NT_SUCCESS(errCode))
+    {
+        NtCancelIoFile(FileHandleSource, &IoStatusBlock);
+    }
+    for (i = 0; i < BufferCount; i++)
+    {
+        CopyWaitIo(&Buffers[i]);
+        NtClose(Buffers[i].Event);
     }
 
+    RegionSize = 0;
+    NtFreeVirtualMemory(NtCurrentProcess(),
+                        (PVOID *)&lpBuffer,
+                        &RegionSize,
+                        MEM_RELEASE);
+
     return errCode;
 }
 
@@ -223,7 +449,7 @@ BasepCopyFileExW(IN LPCWSTR lpExistingFileName,
                                    FILE_SHARE_READ | FILE_SHARE_WRITE,
                                    NULL,
                                    OPEN_EXISTING,
-                                   FILE_ATTRIBUTE_NORMAL|FILE_FLAG_NO_BUFFERING,
+                                   FILE_ATTRIBUTE_NORMAL|FILE_FLAG_NO_BUFFERING|FILE_FLAG_OVERLAPPED,
                                    NULL);
     if (INVALID_HANDLE_VALUE != FileHandleSource)
     {
@@ -255,7 +481,7 @@ BasepCopyFileExW(IN LPCWSTR lpExistingFileName,
                                              FILE_SHARE_WRITE,
                                              NULL,
                                              dwCopyFlags ? CREATE_NEW : CREATE_ALWAYS,
-                                             FileBasic.FileAttributes,
+                                             FileBasic.FileAttributes|FILE_FLAG_OVERLAPPED,
                                              NULL);
                 if (INVALID_HANDLE_VALUE != FileHandleDest)
                 {
@@ -54,6 +54,12 @@ VerifyConsoleIoHandle(HANDLE Handle);
 BOOL WINAPI
 CloseConsoleHandle(HANDLE Handle);
 
+VOID
+FlushConsoleOutputRing(VOID);
+
+VOID
+ForgetConsoleOutputRing(IN HANDLE hConsoleOutput OPTIONAL);
+
 HANDLE WINAPI
 GetConsoleInputWaitHandle(VOID);
 
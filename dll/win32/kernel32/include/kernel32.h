@@ -66,6 +66,7 @@ typedef struct _CODEPAGE_ENTRY
     HANDLE SectionHandle;
     PBYTE SectionMapping;
     CPTABLEINFO CodePageTable;
+    BOOLEAN AsciiIdentity; /* 0x00-0x7F map to U+0000-U+007F and back */
 } CODEPAGE_ENTRY, *PCODEPAGE_ENTRY;
 
 typedef struct tagLOADPARMS32
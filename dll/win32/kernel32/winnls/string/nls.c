@@ -41,6 +41,10 @@ static const unsigned char UTF8Mask[6] = {0x7f, 0x1f, 0x0f, 0x07, 0x03, 0x01};
 static const unsigned long UTF8LBound[] =
     {0, 0x80, 0x800, 0x10000, 0x200000, 0x2000000, 0xFFFFFFFF};
 
+/* High bits of every byte, or of every WCHAR, in a machine word */
+#define ASCII_BYTE_MASK (~(ULONG_PTR)0 / 0xFF * 0x80)
+#define ASCII_WCHAR_MASK (~(ULONG_PTR)0 / 0xFFFF * 0xFF80)
+
 /* FIXME: Change to HASH table or linear array. */
 static LIST_ENTRY CodePageListHead;
 static CODEPAGE_ENTRY AnsiCodePage;
@@ -58,6 +62,118 @@ GetCPFileNameFromRegistry(UINT CodePage, LPWSTR FileName, ULONG FileNameSize);
 
 /* PRIVATE FUNCTIONS **********************************************************/
 
+/**
+ * @name IntWidenAscii
+ *
+ * Internal function to copy the ASCII characters a string starts with, a
+ * machine word at a time, to a wide string. Returns how many there were.
+ * WideCharString can be NULL to only count them.
+ */
+
+static
+SIZE_T
+IntWidenAscii(LPWSTR WideCharString, LPCSTR MultiByteString, SIZE_T Count)
+{
+    ULONG_PTR Word;
+    SIZE_T i, j;
+
+    for (i = 0; i + sizeof(ULONG_PTR) <= Count; i += sizeof(ULONG_PTR))
+    {
+        Word = *(const ULONG_PTR UNALIGNED *)&MultiByteString[i];
+        if (Word & ASCII_BYTE_MASK)
+            break;
+
+        if (WideCharString)
+        {
+            for (j = 0; j < sizeof(ULONG_PTR); j++, Word >>= 8)
+                WideCharString[i + j] = (WCHAR)(Word & 0xFF);
+        }
+    }
+
+    for (; i < Count && (UCHAR)MultiByteString[i] < 0x80; i++)
+    {
+        if (WideCharString)
+            WideCharString[i] = (WCHAR)MultiByteString[i];
+    }
+
+    return i;
+}
+
+/**
+ * @name IntNarrowAscii
+ *
+ * Internal function to copy the ASCII characters a wide string starts with,
+ * a machine word at a time, to a string. Returns how many there were.
+ * MultiByteString can be NULL to only count them.
+ */
+
+static
+SIZE_T
+IntNarrowAscii(LPSTR MultiByteString, LPCWSTR WideCharString, SIZE_T Count)
+{
+    ULONG_PTR Word;
+    SIZE_T i, j;
+
+    for (i = 0; i + sizeof(ULONG_PTR) / sizeof(WCHAR) <= Count; i += sizeof(ULONG_PTR) / sizeof(WCHAR))
+    {
+        Word = *(const ULONG_PTR UNALIGNED *)&WideCharString[i];
+        if (Word & ASCII_WCHAR_MASK)
+            break;
+
+        if (MultiByteString)
+        {
+            for (j = 0; j < sizeof(ULONG_PTR) / sizeof(WCHAR); j++, Word >>= 16)
+                MultiByteString[i + j] = (CHAR)(Word & 0x7F);
+        }
+    }
+
+    for (; i < Count && WideCharString[i] < 0x80; i++)
+    {
+        if (MultiByteString)
+            MultiByteString[i] = (CHAR)WideCharString[i];
+    }
+
+    return i;
+}
+
+/**
+ * @name IntCheckAsciiIdentity
+ *
+ * Internal function to find out if a code page maps ASCII to itself, so
+ * that the conversions can skip its tables for ASCII text.
+ */
+
+static
+VOID
+IntCheckAsciiIdentity(PCODEPAGE_ENTRY CodePageEntry)
+{
+    PCPTABLEINFO CodePageTable = &CodePageEntry->CodePageTable;
+    USHORT Char;
+
+    CodePageEntry->AsciiIdentity = FALSE;
+
+    for (Char = 0; Char < 0x80; Char++)
+    {
+        if (CodePageTable->MultiByteTable[Char] != Char)
+            return;
+
+        if (CodePageTable->DBCSCodePage)
+        {
+            if (CodePageTable->DBCSOffsets[Char] ||
+                ((PUSHORT)CodePageTable->WideCharTable)[Char] != Char)
+            {
+                return;
+            }
+        }
+        else if (((PUCHAR)CodePageTable->WideCharTable)[Char] != Char)
+        {
+            return;
+        }
+    }
+
+    CodePageEntry->AsciiIdentity = TRUE;
+}
+
 /**
  * @name NlsInit
  *
@@ -100,6 +216,7 @@ NlsInit(VOID)
     RtlInitCodePageTable((PUSHORT)AnsiCodePage.SectionMapping,
                          &AnsiCodePage.CodePageTable);
     AnsiCodePage.CodePage = AnsiCodePage.CodePageTable.CodePage;
+    IntCheckAsciiIdentity(&AnsiCodePage);
 
     InsertTailList(&CodePageListHead, &AnsiCodePage.Entry);
 
@@ -110,6 +227,7 @@ NlsInit(VOID)
     RtlInitCodePageTable((PUSHORT)OemCodePage.SectionMapping,
                          &OemCodePage.CodePageTable);
     OemCodePage.CodePage = OemCodePage.CodePageTable.CodePage;
+    IntCheckAsciiIdentity(&OemCodePage);
     InsertTailList(&CodePageListHead, &OemCodePage.Entry);
 
     return TRUE;
@@ -343,6 +461,7 @@ IntGetCodePageEntry(UINT CodePage)
     CodePageEntry->SectionMapping = SectionMapping;
 
     RtlInitCodePageTable((PUSHORT)SectionMapping, &CodePageEntry->CodePageTable);
+    IntCheckAsciiIdentity(CodePageEntry);
 
     /* Insert the new entry to list and unlock. Uff. */
     InsertTailList(&CodePageListHead, &CodePageEntry->Entry);
@@ -369,9 +488,10 @@ IntMultiByteToWideCharUTF8(DWORD Flags,
                            INT WideCharCount)
 {
     LPCSTR MbsEnd, MbsPtrSave;
-    UCHAR Char, TrailLength;
+    UCHAR Char, TrailLength = 0;
     WCHAR WideChar;
     LONG Count;
+    SIZE_T Ascii;
     BOOL CharIsValid, StringIsValid = TRUE;
     const WCHAR InvalidChar = 0xFFFD;
 
@@ -391,6 +511,10 @@ IntMultiByteToWideCharUTF8(DWORD Flags,
             Char = *MultiByteString++;
             if (Char < 0x80)
             {
+                /* Count the rest of an ASCII run in one go */
+                Ascii = IntWidenAscii(NULL, MultiByteString, MbsEnd - MultiByteString);
+                MultiByteString += Ascii;
+                WideCharCount += (INT)Ascii;
                 TrailLength = 0;
                 continue;
             }
@@ -453,6 +577,13 @@ IntMultiByteToWideCharUTF8(DWORD Flags,
         if (Char < 0x80)
         {
             *WideCharString++ = Char;
+
+            /* Copy the rest of an ASCII run in one go */
+            Ascii = IntWidenAscii(WideCharString, MultiByteString,
+                                  min(MbsEnd - MultiByteString, WideCharCount - Count - 1));
+            MultiByteString += Ascii;
+            WideCharString += Ascii;
+            Count += (LONG)Ascii;
             TrailLength = 0;
             continue;
         }
@@ -547,6 +678,8 @@ IntMultiByteToWideCharCP(UINT CodePage,
     LPCSTR TempString;
     INT TempLength;
     USHORT WideChar;
+    BOOL AsciiIdentity;
+    SIZE_T Ascii;
 
     /* Get code page table. */
     CodePageEntry = IntGetCodePageEntry(CodePage);
@@ -569,6 +702,10 @@ IntMultiByteToWideCharCP(UINT CodePage,
         MultiByteTable = CodePageTable->MultiByteTable;
     }
 
+    /* ASCII runs can be copied without looking at the tables */
+    AsciiIdentity = CodePageEntry->AsciiIdentity &&
+                    MultiByteTable == CodePageTable->MultiByteTable;
+
     /* Different handling for DBCS code pages. */
     if (CodePageTable->DBCSCodePage)
     {
@@ -630,6 +767,14 @@ IntMultiByteToWideCharCP(UINT CodePage,
             {
                 Char = *MultiByteString++;
 
+                if (AsciiIdentity && Char < 0x80)
+                {
+                    Ascii = IntWidenAscii(NULL, MultiByteString, MbsEnd - MultiByteString);
+                    MultiByteString += Ascii;
+                    WideCharCount += (INT)Ascii;
+                    continue;
+                }
+
                 DBCSOffset = CodePageTable->DBCSOffsets[Char];
 
                 if (!DBCSOffset)
@@ -646,6 +791,17 @@ IntMultiByteToWideCharCP(UINT CodePage,
         {
             Char = *MultiByteString++;
 
+            if (AsciiIdentity && Char < 0x80)
+            {
+                *WideCharString++ = Char;
+                Ascii = IntWidenAscii(WideCharString, MultiByteString,
+                                      min(MbsEnd - MultiByteString, WideCharCount - Count - 1));
+                MultiByteString += Ascii;
+                WideCharString += Ascii;
+                Count += (INT)Ascii;
+                continue;
+            }
+
             DBCSOffset = CodePageTable->DBCSOffsets[Char];
 
             if (!DBCSOffset)
@@ -703,6 +859,16 @@ IntMultiByteToWideCharCP(UINT CodePage,
             TempLength > 0;
             MultiByteString++, TempLength--)
         {
+            if (AsciiIdentity && (UCHAR)*MultiByteString < 0x80)
+            {
+                Ascii = IntWidenAscii(WideCharString, MultiByteString, TempLength);
+                MultiByteString += Ascii;
+                WideCharString += Ascii;
+                TempLength -= (INT)Ascii;
+                if (TempLength == 0)
+                    break;
+            }
+
             *WideCharString++ = MultiByteTable[(UCHAR)*MultiByteString];
         }
 
@@ -856,6 +1022,7 @@ IntWideCharToMultiByteUTF8(UINT CodePage,
 {
     INT TempLength;
     DWORD Char;
+    SIZE_T Ascii;
 
     if (Flags)
     {
@@ -869,6 +1036,16 @@ IntWideCharToMultiByteUTF8(UINT CodePage,
         for (TempLength = 0; WideCharCount;
             WideCharCount--, WideCharString++)
         {
+            if (*WideCharString < 0x80)
+            {
+                /* Count a run of ASCII characters in one go */
+                Ascii = IntNarrowAscii(NULL, WideCharString, WideCharCount);
+                TempLength += (INT)Ascii;
+                WideCharCount -= (INT)Ascii - 1;
+                WideCharString += Ascii - 1;
+                continue;
+            }
+
             TempLength++;
             if (*WideCharString >= 0x80)
             {
@@ -900,8 +1077,13 @@ IntWideCharToMultiByteUTF8(UINT CodePage,
                 SetLastError(ERROR_INSUFFICIENT_BUFFER);
                 break;
             }
-            TempLength--;
-            *MultiByteString++ = (CHAR)Char;
+
+            /* Copy a run of ASCII characters in one go */
+            Ascii = IntNarrowAscii(MultiByteString, WideCharString, min(WideCharCount, TempLength));
+            MultiByteString += Ascii;
+            TempLength -= (INT)Ascii;
+            WideCharCount -= (INT)Ascii - 1;
+            WideCharString += Ascii - 1;
             continue;
         }
 
@@ -1043,6 +1225,7 @@ IntWideCharToMultiByteCP(UINT CodePage,
     PCODEPAGE_ENTRY CodePageEntry;
     PCPTABLEINFO CodePageTable;
     INT TempLength;
+    SIZE_T Ascii;
 
     /* Get code page table. */
     CodePageEntry = IntGetCodePageEntry(CodePage);
@@ -1158,6 +1341,15 @@ IntWideCharToMultiByteCP(UINT CodePage,
         {
             for (TempLength = 0; WideCharCount; WideCharCount--, WideCharString++, TempLength++)
             {
+                if (CodePageEntry->AsciiIdentity && *WideCharString < 0x80)
+                {
+                    Ascii = IntNarrowAscii(NULL, WideCharString, WideCharCount);
+                    TempLength += (INT)Ascii - 1;
+                    WideCharCount -= (INT)Ascii - 1;
+                    WideCharString += Ascii - 1;
+                    continue;
+                }
+
                 /* Increment TempLength again if this is a double-byte character */
                 if (((PWCHAR)CodePageTable->WideCharTable)[*WideCharString] & 0xff00)
                     TempLength++;
@@ -1171,7 +1363,20 @@ IntWideCharToMultiByteCP(UINT CodePage,
              WideCharCount && TempLength;
              TempLength--, WideCharString++, WideCharCount--)
         {
-            USHORT uChar = ((PUSHORT) CodePageTable->WideCharTable)[*WideCharString];
+            USHORT uChar;
+
+            if (CodePageEntry->AsciiIdentity && *WideCharString < 0x80)
+            {
+                /* Copy a run of ASCII characters in one go */
+                Ascii = IntNarrowAscii(MultiByteString, WideCharString, min(WideCharCount, TempLength));
+                MultiByteString += Ascii;
+                TempLength -= (INT)Ascii - 1;
+                WideCharCount -= (INT)Ascii - 1;
+                WideCharString += Ascii - 1;
+                continue;
+            }
+
+            uChar = ((PUSHORT) CodePageTable->WideCharTable)[*WideCharString];
 
             /* Is this a double-byte character? */
             if (uChar & 0xff00)
@@ -1292,6 +1497,16 @@ IntWideCharToMultiByteCP(UINT CodePage,
         /* Convert the WideCharString to the MultiByteString */
         for (TempLength = WideCharCount; --TempLength >= 0; WideCharString++, MultiByteString++)
         {
+            if (CodePageEntry->AsciiIdentity && *WideCharString < 0x80)
+            {
+                /* Copy a run of ASCII characters in one go */
+                Ascii = IntNarrowAscii(MultiByteString, WideCharString, TempLength + 1);
+                TempLength -= (INT)Ascii - 1;
+                WideCharString += Ascii - 1;
+                MultiByteString += Ascii - 1;
+                continue;
+            }
+
             *MultiByteString = ((PCHAR)CodePageTable->WideCharTable)[*WideCharString];
         }
 
@@ -178,6 +178,19 @@ FindFile(
         }
     }
 
+    if (WildCard == FALSE &&
+        vfatNameIndexLookup(DeviceExt, Parent, FileToFindU, DirContext, &Context, &Page, &Status))
+    {
+        DPRINT("FindFile: indexed Name %wZ, DirIndex %u, Status %x\n",
+            &DirContext->LongNameU, DirContext->DirIndex, Status);
+        if (Context)
+        {
+            CcUnpinData(Context);
+        }
+        ExFreePoolWithTag(PathNameBuffer, TAG_NAME);
+        return Status;
+    }
+
     /* FsRtlIsNameInExpression need the searched string to be upcase,
     * even if IgnoreCase is specified */
     Status = RtlUpcaseUnicodeString(&FileToFindUpcase, FileToFindU, TRUE);
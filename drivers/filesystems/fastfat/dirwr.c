@@ -285,41 +285,45 @@ vfatFindDirSpace(
 
     count = pDirFcb->RFCB.FileSize.u.LowPart / SizeDirEntry;
     size = DeviceExt->FatInfo.BytesPerCluster / SizeDirEntry;
-    for (i = 0; i < count; i++, pFatEntry = (PDIR_ENTRY)((ULONG_PTR)pFatEntry + SizeDirEntry))
+    /* Large directories know where their free slots are */
+    if (!vfatNameIndexFindSpace(DeviceExt, pDirFcb, nbSlots, &i, &nbFree))
     {
-        if (Context == NULL || (i % size) == 0)
+        for (i = 0; i < count; i++, pFatEntry = (PDIR_ENTRY)((ULONG_PTR)pFatEntry + SizeDirEntry))
         {
-            if (Context)
+            if (Context == NULL || (i % size) == 0)
             {
-                CcUnpinData(Context);
+                if (Context)
+                {
+                    CcUnpinData(Context);
+                }
+                _SEH2_TRY
+                {
+                    CcPinRead(pDirFcb->FileObject, &FileOffset, DeviceExt->FatInfo.BytesPerCluster, PIN_WAIT, &Context, (PVOID*)&pFatEntry);
+                }
+                _SEH2_EXCEPT(EXCEPTION_EXECUTE_HANDLER)
+                {
+                    _SEH2_YIELD(return FALSE);
+                }
+                _SEH2_END;
+
+                FileOffset.u.LowPart += DeviceExt->FatInfo.BytesPerCluster;
             }
-            _SEH2_TRY
+            if (ENTRY_END(IsFatX, pFatEntry))
             {
-                CcPinRead(pDirFcb->FileObject, &FileOffset, DeviceExt->FatInfo.BytesPerCluster, PIN_WAIT, &Context, (PVOID*)&pFatEntry);
+                break;
             }
-            _SEH2_EXCEPT(EXCEPTION_EXECUTE_HANDLER)
+            if (ENTRY_DELETED(IsFatX, pFatEntry))
             {
-                _SEH2_YIELD(return FALSE);
+                nbFree++;
+            }
+            else
+            {
+                nbFree = 0;
+            }
+            if (nbFree == nbSlots)
+            {
+                break;
             }
-            _SEH2_END;
-
-            FileOffset.u.LowPart += DeviceExt->FatInfo.BytesPerCluster;
-        }
-        if (ENTRY_END(IsFatX, pFatEntry))
-        {
-            break;
-        }
-        if (ENTRY_DELETED(IsFatX, pFatEntry))
-        {
-            nbFree++;
-        }
-        else
-        {
-            nbFree = 0;
-        }
-        if (nbFree == nbSlots)
-        {
-            break;
         }
     }
     if (Context)
@@ -395,6 +399,7 @@ vfatFindDirSpace(
         }
     }
     DPRINT("nbSlots %u nbFree %u, entry number %u\n", nbSlots, nbFree, *start);
+    vfatNameIndexUseSlots(pDirFcb, *start, nbSlots);
     return TRUE;
 }
 
@@ -762,6 +767,7 @@ FATAddEntry(
     }
     CcSetDirtyPinnedData(Context, NULL);
     CcUnpinData(Context);
+    vfatNameIndexAddEntry(ParentFcb, &DirContext);
 
     if (MoveContext != NULL)
     {
@@ -1022,10 +1028,12 @@ FATDelEntry(
         CcSetDirtyPinnedData(Context, NULL);
         CcUnpinData(Context);
     }
+    vfatNameIndexRemoveEntry(pFcb);
 
     /* In case of moving, don't delete data */
     if (MoveContext == NULL)
     {
+        ForgetClusterRuns(pFcb, 0);
         while (CurrentCluster && CurrentCluster != 0xffffffff)
         {
             GetNextCluster(DeviceExt, CurrentCluster, &NextCluster);
@@ -1105,6 +1113,7 @@ FATXDelEntry(
     /* In case of moving, don't delete data */
     if (MoveContext == NULL)
     {
+        ForgetClusterRuns(pFcb, 0);
         while (CurrentCluster && CurrentCluster != 0xffffffff)
         {
             GetNextCluster(DeviceExt, CurrentCluster, &NextCluster);
@@ -303,6 +303,123 @@ FAT12FindAndMarkAvailableCluster(
     return STATUS_DISK_FULL;
 }
 
+/*
+ * FUNCTION: Remembers a run of free FAT32 clusters, merging it with a run
+ *           it extends. When all the slots are taken, it replaces the
+ *           smallest run if it is larger than that.
+ */
+static
+VOID
+FAT32AddFreeRun(
+    PDEVICE_EXTENSION DeviceExt,
+    ULONG Cluster,
+    ULONG Count)
+{
+    PVFAT_FREE_RUN Run, Smallest = NULL;
+    ULONG i;
+
+    for (i = 0; i < DeviceExt->FreeRunCount; i++)
+    {
+        Run = &DeviceExt->FreeRuns[i];
+        if (Run->Cluster + Run->Count == Cluster)
+        {
+            Run->Count += Count;
+            return;
+        }
+        if (Cluster + Count == Run->Cluster)
+        {
+            Run->Cluster = Cluster;
+            Run->Count += Count;
+            return;
+        }
+        if (Smallest == NULL || Run->Count < Smallest->Count)
+            Smallest = Run;
+    }
+
+    if (DeviceExt->FreeRunCount < VFAT_FREE_RUNS)
+        Run = &DeviceExt->FreeRuns[DeviceExt->FreeRunCount++];
+    else if (Smallest->Count < Count)
+        Run = Smallest;
+    else
+        return;
+
+    Run->Cluster = Cluster;
+    Run->Count = Count;
+}
+
+/*
+ * FUNCTION: Marks the first cluster of a remembered free run as used,
+ *           preferring the run which continues the last allocation. Runs
+ *           whose cluster turns out to be used are dropped.
+ *           Returns STATUS_DISK_FULL when no run is left.
+ */
+static
+NTSTATUS
+FAT32AllocateFromFreeRuns(
+    PDEVICE_EXTENSION DeviceExt,
+    PULONG Cluster)
+{
+    PVFAT_FREE_RUN Run;
+    ULONG i, Candidate;
+    PVOID BaseAddress;
+    ULONG ChunkSize;
+    PVOID Context;
+    LARGE_INTEGER Offset;
+    PULONG Block;
+
+    ChunkSize = CACHEPAGESIZE(DeviceExt);
+
+    while (DeviceExt->FreeRunCount > 0)
+    {
+        for (i = DeviceExt->FreeRunCount - 1; i > 0; i--)
+        {
+            if (DeviceExt->FreeRuns[i].Cluster == DeviceExt->LastAvailableCluster + 1)
+                break;
+        }
+        Run = &DeviceExt->FreeRuns[i];
+        Candidate = Run->Cluster;
+
+        if (Candidate >= 2 && Candidate < DeviceExt->FatInfo.NumberOfClusters + 2)
+        {
+            Offset.QuadPart = ROUND_DOWN(Candidate * 4, ChunkSize);
+            _SEH2_TRY
+            {
+                CcPinRead(DeviceExt->FATFileObject, &Offset, ChunkSize, PIN_WAIT, &Context, &BaseAddress);
+            }
+            _SEH2_EXCEPT(EXCEPTION_EXECUTE_HANDLER)
+            {
+                DPRINT1("CcPinRead(Offset %x, Length %u) failed\n", (ULONG)Offset.QuadPart, ChunkSize);
+                _SEH2_YIELD(return _SEH2_GetExceptionCode());
+            }
+            _SEH2_END;
+            Block = (PULONG)((ULONG_PTR)BaseAddress + (Candidate * 4) % ChunkSize);
+
+            if ((*Block & 0x0fffffff) == 0)
+            {
+                DPRINT("Took available cluster 0x%x from a free run\n", Candidate);
+                DeviceExt->LastAvailableCluster = *Cluster = Candidate;
+                *Block = 0x0fffffff;
+                CcSetDirtyPinnedData(Context, NULL);
+                CcUnpinData(Context);
+                if (DeviceExt->AvailableClustersValid)
+                    InterlockedDecrement((PLONG)&DeviceExt->AvailableClusters);
+
+                Run->Cluster++;
+                if (--Run->Count == 0)
+                    *Run = DeviceExt->FreeRuns[--DeviceExt->FreeRunCount];
+                return STATUS_SUCCESS;
+            }
+
+            CcUnpinData(Context);
+        }
+
+        /* The FAT changed behind our back, forget about the whole run */
+        *Run = DeviceExt->FreeRuns[--DeviceExt->FreeRunCount];
+    }
+
+    return STATUS_DISK_FULL;
+}
+
 /*
  * FUNCTION: Finds the first available cluster in a FAT32 table
  */
@@ -320,6 +437,16 @@ FAT32FindAndMarkAvailableCluster(
     LARGE_INTEGER Offset;
     PULONG Block;
     PULONG BlockEnd;
+    PULONG Next;
+    ULONG Count;
+    NTSTATUS Status;
+
+    /* Don't scan as long as there are free clusters we know of */
+    Status = FAT32AllocateFromFreeRuns(DeviceExt, Cluster);
+    if (Status != STATUS_DISK_FULL)
+    {
+        return Status;
+    }
 
     ChunkSize = CACHEPAGESIZE(DeviceExt);
     FatLength = (DeviceExt->FatInfo.NumberOfClusters + 2);
@@ -352,6 +479,16 @@ FAT32FindAndMarkAvailableCluster(
                     DPRINT("Found available cluster 0x%x\n", i);
                     DeviceExt->LastAvailableCluster = *Cluster = i;
                     *Block = 0x0fffffff;
+
+                    /* Remember the free clusters right after it for the next allocations */
+                    for (Next = Block + 1, Count = 0; Next < BlockEnd && i + 1 + Count < FatLength; Next++, Count++)
+                    {
+                        if ((*Next & 0x0fffffff) != 0)
+                            break;
+                    }
+                    if (Count > 0)
+                        FAT32AddFreeRun(DeviceExt, i + 1, Count);
+
                     CcSetDirtyPinnedData(Context, NULL);
                     CcUnpinData(Context);
                     if (DeviceExt->AvailableClustersValid)
@@ -692,6 +829,10 @@ FAT32WriteCluster(
     CcSetDirtyPinnedData(Context, NULL);
     CcUnpinData(Context);
 
+    /* Freed clusters can be handed out again without scanning for them */
+    if (*OldValue != 0 && (NewValue & 0x0fffffff) == 0)
+        FAT32AddFreeRun(DeviceExt, ClusterToWrite, 1);
+
     return STATUS_SUCCESS;
 }
 
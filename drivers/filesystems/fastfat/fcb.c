@@ -152,6 +152,7 @@ vfatNewFCB(
     ExInitializeResourceLite(&rcFCB->MainResource);
     FsRtlInitializeFileLock(&rcFCB->FileLock, NULL, NULL);
     ExInitializeFastMutex(&rcFCB->LastMutex);
+    FsRtlInitializeLargeMcb(&rcFCB->Mcb, NonPagedPool);
     rcFCB->RFCB.PagingIoResource = &rcFCB->PagingIoResource;
     rcFCB->RFCB.Resource = &rcFCB->MainResource;
     rcFCB->RFCB.IsFastIoPossible = FastIoIsNotPossible;
@@ -277,6 +278,8 @@ vfatDestroyFCB(
 #endif
 
     FsRtlUninitializeFileLock(&pFCB->FileLock);
+    FsRtlUninitializeLargeMcb(&pFCB->Mcb);
+    vfatFreeNameIndex(pFCB);
 
     if (!vfatFCBIsRoot(pFCB) &&
         !BooleanFlagOn(pFCB->Flags, FCB_IS_FAT) && !BooleanFlagOn(pFCB->Flags, FCB_IS_VOLUME))
@@ -787,6 +790,628 @@ vfatAttachFCBToFileObject(
     return STATUS_SUCCESS;
 }
 
+static
+ULONG
+vfatNameIndexHash(
+    PUNICODE_STRING NameU)
+{
+    WCHAR Buffer[260];
+    UNICODE_STRING UpcaseU;
+
+    /* Hash the upcased name, so that it matches whatever case-insensitive compare says */
+    UpcaseU.Buffer = Buffer;
+    UpcaseU.Length = 0;
+    UpcaseU.MaximumLength = sizeof(Buffer);
+    if (!NT_SUCCESS(RtlUpcaseUnicodeString(&UpcaseU, NameU, FALSE)))
+    {
+        /* Too long to be in any directory anyway */
+        return vfatNameHash(0, NameU);
+    }
+
+    return vfatNameHash(0, &UpcaseU);
+}
+
+static
+BOOLEAN
+vfatNameIndexGrow(
+    PVFAT_NAME_INDEX Index)
+{
+    PVFAT_NAME_INDEX_ENTRY Entries;
+    PULONG Buckets;
+    ULONG EntryCount, BucketCount, i;
+
+    EntryCount = Index->EntryCount * 2;
+    BucketCount = EntryCount / 2;
+
+    Entries = ExAllocatePoolWithTag(PagedPool, EntryCount * sizeof(VFAT_NAME_INDEX_ENTRY), TAG_NAME_INDEX);
+    if (Entries == NULL)
+    {
+        return FALSE;
+    }
+    Buckets = ExAllocatePoolWithTag(PagedPool, BucketCount * sizeof(ULONG), TAG_NAME_INDEX);
+    if (Buckets == NULL)
+    {
+        ExFreePoolWithTag(Entries, TAG_NAME_INDEX);
+        return FALSE;
+    }
+
+    /* Only called with the free list empty, so all the old entries are in use */
+    RtlCopyMemory(Entries, Index->Entries, Index->EntryCount * sizeof(VFAT_NAME_INDEX_ENTRY));
+    RtlFillMemory(Buckets, BucketCount * sizeof(ULONG), 0xff);
+    for (i = 0; i < Index->EntryCount; i++)
+    {
+        Entries[i].Next = Buckets[Entries[i].Hash & (BucketCount - 1)];
+        Buckets[Entries[i].Hash & (BucketCount - 1)] = i;
+    }
+    for (; i < EntryCount; i++)
+    {
+        Entries[i].DirIndex = VFAT_NAME_INDEX_NONE;
+        Entries[i].Next = (i + 1 < EntryCount) ? i + 1 : VFAT_NAME_INDEX_NONE;
+    }
+
+    ExFreePoolWithTag(Index->Entries, TAG_NAME_INDEX);
+    ExFreePoolWithTag(Index->Buckets, TAG_NAME_INDEX);
+    Index->FreeEntry = Index->EntryCount;
+    Index->EntryCount = EntryCount;
+    Index->Entries = Entries;
+    Index->BucketCount = BucketCount;
+    Index->Buckets = Buckets;
+    return TRUE;
+}
+
+static
+BOOLEAN
+vfatNameIndexInsert(
+    PVFAT_NAME_INDEX Index,
+    ULONG Hash,
+    ULONG StartIndex,
+    ULONG DirIndex)
+{
+    PULONG Bucket;
+    ULONG Entry;
+
+    if (Index->FreeEntry == VFAT_NAME_INDEX_NONE && !vfatNameIndexGrow(Index))
+    {
+        return FALSE;
+    }
+
+    Entry = Index->FreeEntry;
+    Index->FreeEntry = Index->Entries[Entry].Next;
+
+    Bucket = &Index->Buckets[Hash & (Index->BucketCount - 1)];
+    Index->Entries[Entry].Hash = Hash;
+    Index->Entries[Entry].StartIndex = StartIndex;
+    Index->Entries[Entry].DirIndex = DirIndex;
+    Index->Entries[Entry].Next = *Bucket;
+    *Bucket = Entry;
+    return TRUE;
+}
+
+static
+BOOLEAN
+vfatNameIndexInsertNames(
+    PVFAT_NAME_INDEX Index,
+    PVFAT_DIRENTRY_CONTEXT DirContext)
+{
+    ULONG LongHash, ShortHash;
+
+    LongHash = vfatNameIndexHash(&DirContext->LongNameU);
+    ShortHash = vfatNameIndexHash(&DirContext->ShortNameU);
+
+    if (!vfatNameIndexInsert(Index, LongHash, DirContext->StartIndex, DirContext->DirIndex))
+    {
+        return FALSE;
+    }
+    /* 8.3 names only have one, whatever their case */
+    if (ShortHash != LongHash &&
+        !vfatNameIndexInsert(Index, ShortHash, DirContext->StartIndex, DirContext->DirIndex))
+    {
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static
+ULONG
+vfatNameIndexRemove(
+    PVFAT_NAME_INDEX Index,
+    ULONG Hash,
+    ULONG DirIndex)
+{
+    PVFAT_NAME_INDEX_ENTRY Entry;
+    PULONG Link;
+    ULONG Free, Removed = 0;
+
+    Link = &Index->Buckets[Hash & (Index->BucketCount - 1)];
+    while (*Link != VFAT_NAME_INDEX_NONE)
+    {
+        Entry = &Index->Entries[*Link];
+        if (Entry->Hash == Hash && Entry->DirIndex == DirIndex)
+        {
+            Free = *Link;
+            *Link = Entry->Next;
+            Entry->DirIndex = VFAT_NAME_INDEX_NONE;
+            Entry->Next = Index->FreeEntry;
+            Index->FreeEntry = Free;
+            Removed++;
+        }
+        else
+        {
+            Link = &Entry->Next;
+        }
+    }
+    return Removed;
+}
+
+static
+VOID
+vfatNameIndexAddFreeSlots(
+    PVFAT_NAME_INDEX Index,
+    ULONG Start,
+    ULONG Count)
+{
+    PVFAT_FREE_SLOTS Run;
+    ULONG i, Smallest = 0;
+
+    /* Merge with the runs right before and right after */
+    for (i = 0; i < Index->FreeRunCount; i++)
+    {
+        Run = &Index->FreeRuns[i];
+        if (Run->Index + Run->Count == Start || Start + Count == Run->Index)
+        {
+            Start = min(Start, Run->Index);
+            Count += Run->Count;
+            *Run = Index->FreeRuns[--Index->FreeRunCount];
+            i--;
+        }
+    }
+
+    if (Index->FreeRunCount < VFAT_NAME_INDEX_FREE_RUNS)
+    {
+        Run = &Index->FreeRuns[Index->FreeRunCount++];
+    }
+    else
+    {
+        /* Full, only the largest runs are worth remembering */
+        for (i = 1; i < Index->FreeRunCount; i++)
+        {
+            if (Index->FreeRuns[i].Count < Index->FreeRuns[Smallest].Count)
+            {
+                Smallest = i;
+            }
+        }
+        Run = &Index->FreeRuns[Smallest];
+        if (Run->Count >= Count)
+        {
+            return;
+        }
+    }
+    Run->Index = Start;
+    Run->Count = Count;
+}
+
+static
+BOOLEAN
+vfatNameIndexCheckSlots(
+    PDEVICE_EXTENSION DeviceExt,
+    PVFATFCB pDirFcb,
+    ULONG Start,
+    ULONG Count,
+    BOOLEAN End)
+{
+    LARGE_INTEGER FileOffset;
+    PFAT_DIR_ENTRY Entries = NULL;
+    PVOID Context = NULL;
+    BOOLEAN Free = TRUE;
+    ULONG i;
+
+    for (i = Start; i < Start + Count && Free; i++)
+    {
+        if (Context == NULL || (i % FAT_ENTRIES_PER_PAGE) == 0)
+        {
+            if (Context != NULL)
+            {
+                CcUnpinData(Context);
+            }
+
+            FileOffset.QuadPart = ROUND_DOWN(i * sizeof(FAT_DIR_ENTRY), PAGE_SIZE);
+            _SEH2_TRY
+            {
+                CcMapData(pDirFcb->FileObject, &FileOffset, PAGE_SIZE, MAP_WAIT, &Context, (PVOID*)&Entries);
+            }
+            _SEH2_EXCEPT(EXCEPTION_EXECUTE_HANDLER)
+            {
+                _SEH2_YIELD(return FALSE);
+            }
+            _SEH2_END;
+        }
+
+        if (End)
+            Free = FAT_ENTRY_END(&Entries[i % FAT_ENTRIES_PER_PAGE]);
+        else
+            Free = FAT_ENTRY_DELETED(&Entries[i % FAT_ENTRIES_PER_PAGE]);
+    }
+
+    if (Context != NULL)
+    {
+        CcUnpinData(Context);
+    }
+    return Free;
+}
+
+VOID
+vfatFreeNameIndex(
+    PVFATFCB pDirFcb)
+{
+    PVFAT_NAME_INDEX Index = pDirFcb->NameIndex;
+
+    if (Index != NULL)
+    {
+        pDirFcb->NameIndex = NULL;
+        ExFreePoolWithTag(Index->Entries, TAG_NAME_INDEX);
+        ExFreePoolWithTag(Index->Buckets, TAG_NAME_INDEX);
+        ExFreePoolWithTag(Index, TAG_NAME_INDEX);
+    }
+}
+
+/*
+ * Scans a large directory once, and indexes its entries by name.
+ */
+static
+BOOLEAN
+vfatBuildNameIndex(
+    PDEVICE_EXTENSION DeviceExt,
+    PVFATFCB pDirFcb)
+{
+    PVFAT_NAME_INDEX Index;
+    VFAT_DIRENTRY_CONTEXT DirContext;
+    WCHAR LongNameBuffer[260];
+    WCHAR ShortNameBuffer[13];
+    PVOID Context = NULL;
+    PVOID Page;
+    BOOLEAN First = TRUE;
+    ULONG Slots, EntryCount, NextIndex = 0, i;
+    NTSTATUS Status;
+
+    ASSERT(ExIsResourceAcquiredExclusive(&DeviceExt->DirResource));
+
+    /* Small directories are scanned quickly enough, and FATX ones are left alone */
+    Slots = pDirFcb->RFCB.FileSize.u.LowPart / sizeof(FAT_DIR_ENTRY);
+    if (vfatVolumeIsFatX(DeviceExt) || Slots < VFAT_NAME_INDEX_MIN_SLOTS)
+    {
+        return FALSE;
+    }
+
+    /* Every entry takes at least one slot per name it is hashed under */
+    EntryCount = VFAT_NAME_INDEX_MIN_SLOTS;
+    while (EntryCount < Slots)
+    {
+        EntryCount *= 2;
+    }
+
+    Index = ExAllocatePoolWithTag(PagedPool, sizeof(VFAT_NAME_INDEX), TAG_NAME_INDEX);
+    if (Index == NULL)
+    {
+        return FALSE;
+    }
+    RtlZeroMemory(Index, sizeof(VFAT_NAME_INDEX));
+    Index->EntryCount = EntryCount;
+    Index->BucketCount = EntryCount / 2;
+    Index->Entries = ExAllocatePoolWithTag(PagedPool, EntryCount * sizeof(VFAT_NAME_INDEX_ENTRY), TAG_NAME_INDEX);
+    Index->Buckets = ExAllocatePoolWithTag(PagedPool, Index->BucketCount * sizeof(ULONG), TAG_NAME_INDEX);
+    if (Index->Entries == NULL || Index->Buckets == NULL)
+    {
+        goto Fail;
+    }
+    RtlFillMemory(Index->Buckets, Index->BucketCount * sizeof(ULONG), 0xff);
+    for (i = 0; i < EntryCount; i++)
+    {
+        Index->Entries[i].DirIndex = VFAT_NAME_INDEX_NONE;
+        Index->Entries[i].Next = (i + 1 < EntryCount) ? i + 1 : VFAT_NAME_INDEX_NONE;
+    }
+    Index->FreeEntry = 0;
+
+    DirContext.DirIndex = 0;
+    DirContext.LongNameU.Buffer = LongNameBuffer;
+    DirContext.LongNameU.Length = 0;
+    DirContext.LongNameU.MaximumLength = sizeof(LongNameBuffer);
+    DirContext.ShortNameU.Buffer = ShortNameBuffer;
+    DirContext.ShortNameU.Length = 0;
+    DirContext.ShortNameU.MaximumLength = sizeof(ShortNameBuffer);
+    DirContext.DeviceExt = DeviceExt;
+
+    while (TRUE)
+    {
+        Status = VfatGetNextDirEntry(DeviceExt, &Context, &Page, pDirFcb, &DirContext, First);
+        First = FALSE;
+        if (Status == STATUS_NO_MORE_ENTRIES)
+        {
+            break;
+        }
+        if (!NT_SUCCESS(Status))
+        {
+            goto Fail;
+        }
+
+        /* Whatever lies between two entries was deleted */
+        if (DirContext.StartIndex > NextIndex)
+        {
+            vfatNameIndexAddFreeSlots(Index, NextIndex, DirContext.StartIndex - NextIndex);
+        }
+        NextIndex = DirContext.DirIndex + 1;
+
+        /* Same entries as vfatDirFindFile() would consider */
+        if (!ENTRY_VOLUME(FALSE, &DirContext.DirEntry) &&
+            DirContext.LongNameU.Length != 0 &&
+            DirContext.ShortNameU.Length != 0)
+        {
+            if (!vfatNameIndexInsertNames(Index, &DirContext))
+            {
+                goto Fail;
+            }
+        }
+        DirContext.DirIndex++;
+    }
+
+    /* The scan stops on the end marker, or at the end of the directory */
+    Index->EndIndex = min(DirContext.DirIndex, Slots);
+    if (Index->EndIndex > NextIndex)
+    {
+        vfatNameIndexAddFreeSlots(Index, NextIndex, Index->EndIndex - NextIndex);
+    }
+
+    DPRINT("Indexed '%wZ', %u slots, end at %u\n", &pDirFcb->PathNameU, Slots, Index->EndIndex);
+    pDirFcb->NameIndex = Index;
+    return TRUE;
+
+Fail:
+    if (Context != NULL)
+    {
+        CcUnpinData(Context);
+    }
+    if (Index->Entries != NULL)
+    {
+        ExFreePoolWithTag(Index->Entries, TAG_NAME_INDEX);
+    }
+    if (Index->Buckets != NULL)
+    {
+        ExFreePoolWithTag(Index->Buckets, TAG_NAME_INDEX);
+    }
+    ExFreePoolWithTag(Index, TAG_NAME_INDEX);
+    return FALSE;
+}
+
+/*
+ * Looks a name up in the index of a large directory, building it if needed.
+ * Returns FALSE when the directory has to be scanned instead. Otherwise
+ * Status is STATUS_SUCCESS with the entry in DirContext and its page pinned
+ * in *pContext, or STATUS_NO_MORE_ENTRIES if there is no such name at or
+ * after DirContext->DirIndex.
+ */
+BOOLEAN
+vfatNameIndexLookup(
+    PDEVICE_EXTENSION DeviceExt,
+    PVFATFCB pDirFcb,
+    PUNICODE_STRING FileToFindU,
+    PVFAT_DIRENTRY_CONTEXT DirContext,
+    PVOID *pContext,
+    PVOID *pPage,
+    PNTSTATUS Status)
+{
+    PVFAT_NAME_INDEX Index;
+    ULONG Hash, Entry, DirIndex, MinIndex;
+
+    if (pDirFcb->NameIndex == NULL && !vfatBuildNameIndex(DeviceExt, pDirFcb))
+    {
+        return FALSE;
+    }
+
+    Index = pDirFcb->NameIndex;
+    Hash = vfatNameIndexHash(FileToFindU);
+    MinIndex = DirContext->DirIndex;
+
+    for (Entry = Index->Buckets[Hash & (Index->BucketCount - 1)];
+         Entry != VFAT_NAME_INDEX_NONE;
+         Entry = Index->Entries[Entry].Next)
+    {
+        if (Index->Entries[Entry].Hash != Hash ||
+            Index->Entries[Entry].DirIndex < MinIndex)
+        {
+            continue;
+        }
+
+        /* Read the entry back, that also checks the index is still right */
+        DirIndex = Index->Entries[Entry].DirIndex;
+        DirContext->DirIndex = Index->Entries[Entry].StartIndex;
+        if (*pContext != NULL)
+        {
+            CcUnpinData(*pContext);
+            *pContext = NULL;
+        }
+        *Status = VfatGetNextDirEntry(DeviceExt, pContext, pPage, pDirFcb, DirContext, TRUE);
+        if (!NT_SUCCESS(*Status) || DirContext->DirIndex != DirIndex)
+        {
+            DPRINT1("Name index of '%wZ' is out of date at %u\n", &pDirFcb->PathNameU, DirIndex);
+            if (*pContext != NULL)
+            {
+                CcUnpinData(*pContext);
+                *pContext = NULL;
+            }
+            vfatFreeNameIndex(pDirFcb);
+            DirContext->DirIndex = MinIndex;
+            return FALSE;
+        }
+
+        if (RtlEqualUnicodeString(FileToFindU, &DirContext->LongNameU, TRUE) ||
+            RtlEqualUnicodeString(FileToFindU, &DirContext->ShortNameU, TRUE))
+        {
+            *Status = STATUS_SUCCESS;
+            return TRUE;
+        }
+    }
+
+    if (*pContext != NULL)
+    {
+        CcUnpinData(*pContext);
+        *pContext = NULL;
+    }
+    DirContext->DirIndex = MinIndex;
+    *Status = STATUS_NO_MORE_ENTRIES;
+    return TRUE;
+}
+
+VOID
+vfatNameIndexAddEntry(
+    PVFATFCB pDirFcb,
+    PVFAT_DIRENTRY_CONTEXT DirContext)
+{
+    if (pDirFcb->NameIndex != NULL &&
+        !vfatNameIndexInsertNames(pDirFcb->NameIndex, DirContext))
+    {
+        /* Can't be trusted anymore, it will be rebuilt */
+        vfatFreeNameIndex(pDirFcb);
+    }
+}
+
+VOID
+vfatNameIndexRemoveEntry(
+    PVFATFCB pFcb)
+{
+    PVFAT_NAME_INDEX Index = pFcb->parentFcb->NameIndex;
+    ULONG LongHash, ShortHash, Removed;
+
+    if (Index == NULL)
+    {
+        return;
+    }
+
+    LongHash = vfatNameIndexHash(&pFcb->LongNameU);
+    ShortHash = vfatNameIndexHash(&pFcb->ShortNameU);
+    Removed = vfatNameIndexRemove(Index, LongHash, pFcb->dirIndex);
+    if (ShortHash != LongHash)
+    {
+        Removed += vfatNameIndexRemove(Index, ShortHash, pFcb->dirIndex);
+    }
+    if (Removed == 0)
+    {
+        DPRINT1("'%wZ' is missing from the name index\n", &pFcb->PathNameU);
+        vfatFreeNameIndex(pFcb->parentFcb);
+        return;
+    }
+
+    vfatNameIndexAddFreeSlots(Index, pFcb->startIndex, pFcb->dirIndex - pFcb->startIndex + 1);
+}
+
+/*
+ * Finds room for nbSlots entries in an indexed directory, reporting it the
+ * way the scan in vfatFindDirSpace() does: either nbFree == nbSlots deleted
+ * slots ending at *Last, or the end marker at *Last.
+ */
+BOOLEAN
+vfatNameIndexFindSpace(
+    PDEVICE_EXTENSION DeviceExt,
+    PVFATFCB pDirFcb,
+    ULONG nbSlots,
+    PULONG Last,
+    PULONG nbFree)
+{
+    PVFAT_NAME_INDEX Index = pDirFcb->NameIndex;
+    ULONG Count, Best, Start, i;
+
+    if (Index == NULL)
+    {
+        return FALSE;
+    }
+
+    Count = pDirFcb->RFCB.FileSize.u.LowPart / sizeof(FAT_DIR_ENTRY);
+    while (TRUE)
+    {
+        /* Best fit, to keep the large runs for long names */
+        Best = VFAT_NAME_INDEX_NONE;
+        for (i = 0; i < Index->FreeRunCount; i++)
+        {
+            if (Index->FreeRuns[i].Count >= nbSlots &&
+                (Best == VFAT_NAME_INDEX_NONE || Index->FreeRuns[i].Count < Index->FreeRuns[Best].Count))
+            {
+                Best = i;
+            }
+        }
+        if (Best == VFAT_NAME_INDEX_NONE)
+        {
+            break;
+        }
+
+        Start = Index->FreeRuns[Best].Index;
+        if (Start + nbSlots <= Count &&
+            vfatNameIndexCheckSlots(DeviceExt, pDirFcb, Start, nbSlots, FALSE))
+        {
+            *Last = Start + nbSlots - 1;
+            *nbFree = nbSlots;
+            return TRUE;
+        }
+
+        /* Not all deleted, like orphaned long name slots: forget about it */
+        Index->FreeRuns[Best] = Index->FreeRuns[--Index->FreeRunCount];
+    }
+
+    if (Index->EndIndex > Count ||
+        (Index->EndIndex < Count && !vfatNameIndexCheckSlots(DeviceExt, pDirFcb, Index->EndIndex, 1, TRUE)))
+    {
+        DPRINT1("Name index of '%wZ' lost the end marker\n", &pDirFcb->PathNameU);
+        vfatFreeNameIndex(pDirFcb);
+        return FALSE;
+    }
+
+    *Last = Index->EndIndex;
+    *nbFree = 0;
+    return TRUE;
+}
+
+/*
+ * Takes the slots given to a new entry out of the free ones.
+ */
+VOID
+vfatNameIndexUseSlots(
+    PVFATFCB pDirFcb,
+    ULONG Start,
+    ULONG Count)
+{
+    PVFAT_NAME_INDEX Index = pDirFcb->NameIndex;
+    PVFAT_FREE_SLOTS Run;
+    ULONG i;
+
+    if (Index == NULL)
+    {
+        return;
+    }
+
+    for (i = 0; i < Index->FreeRunCount; i++)
+    {
+        Run = &Index->FreeRuns[i];
+        if (Start >= Run->Index + Run->Count || Start + Count <= Run->Index)
+        {
+            continue;
+        }
+
+        /* Slots are taken from the start of a run, keep what follows */
+        if (Start + Count >= Run->Index + Run->Count)
+        {
+            *Run = Index->FreeRuns[--Index->FreeRunCount];
+            i--;
+        }
+        else
+        {
+            Run->Count = Run->Index + Run->Count - (Start + Count);
+            Run->Index = Start + Count;
+        }
+    }
+
+    if (Start + Count > Index->EndIndex)
+    {
+        Index->EndIndex = Start + Count;
+    }
+}
+
 NTSTATUS
 vfatDirFindFile(
     PDEVICE_EXTENSION pDeviceExt,
@@ -824,6 +1449,20 @@ vfatDirFindFile(
     DirContext.ShortNameU.MaximumLength = sizeof(ShortNameBuffer);
     DirContext.DeviceExt = pDeviceExt;
 
+    if (vfatNameIndexLookup(pDeviceExt, pDirectoryFCB, FileToFindU, &DirContext, &Context, &Page, &status))
+    {
+        if (status == STATUS_NO_MORE_ENTRIES)
+        {
+            return STATUS_OBJECT_NAME_NOT_FOUND;
+        }
+        status = vfatMakeFCBFromDirEntry(pDeviceExt,
+            pDirectoryFCB,
+            &DirContext,
+            pFoundFCB);
+        CcUnpinData(Context);
+        return status;
+    }
+
     while (TRUE)
     {
         status = VfatGetNextDirEntry(pDeviceExt,
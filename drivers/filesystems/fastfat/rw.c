@@ -113,6 +113,172 @@ OffsetToCluster(
    }
 }
 
+/*
+ * Append a run of clusters to the FCB's cluster map, provided that the map
+ * still ends where the walk which found them started
+ */
+static
+BOOLEAN
+AddClusterRun(
+    PVFATFCB Fcb,
+    ULONG Index,
+    ULONG PreviousCluster,
+    ULONG Cluster,
+    ULONG Count)
+{
+    BOOLEAN Added = FALSE;
+
+    ExAcquireFastMutex(&Fcb->LastMutex);
+    if (Fcb->MappedClusters == Index && Fcb->LastCluster == PreviousCluster &&
+        FsRtlAddLargeMcbEntry(&Fcb->Mcb, Index, Cluster, Count))
+    {
+        Fcb->MappedClusters += Count;
+        Fcb->LastCluster = Cluster + Count - 1;
+        Added = TRUE;
+    }
+    ExReleaseFastMutex(&Fcb->LastMutex);
+
+    return Added;
+}
+
+/*
+ * Return the cluster holding a file offset and how many clusters of the file
+ * follow it contiguously on disk. Only the part of the chain which the FCB's
+ * cluster map doesn't cover yet is walked, and it gets added to the map.
+ * Past the end of the chain, the cluster is 0xffffffff.
+ */
+NTSTATUS
+OffsetToClusterRun(
+    PDEVICE_EXTENSION DeviceExt,
+    PVFATFCB Fcb,
+    ULONG FirstCluster,
+    ULONG FileOffset,
+    PULONG Cluster,
+    PULONG RunLength)
+{
+    ULONG Index, CurrentIndex, CurrentCluster, NewCluster;
+    ULONG RunIndex = 0, RunStart = 0, RunClusters = 0, PreviousCluster;
+    LONGLONG Lbn, Count;
+    BOOLEAN Recording = TRUE;
+    NTSTATUS Status = STATUS_SUCCESS;
+
+    if (FirstCluster == 0)
+    {
+        DbgPrint("OffsetToClusterRun is called with FirstCluster = 0!\n");
+        ASSERT(FALSE);
+        return STATUS_FILE_CORRUPT_ERROR;
+    }
+
+    /* The root of FAT12 and FAT16 isn't a chain */
+    ASSERT(FirstCluster != 1);
+
+    Index = FileOffset / DeviceExt->FatInfo.BytesPerCluster;
+
+    ExAcquireFastMutex(&Fcb->LastMutex);
+    if (Index < Fcb->MappedClusters &&
+        FsRtlLookupLargeMcbEntry(&Fcb->Mcb, Index, &Lbn, &Count, NULL, NULL, NULL))
+    {
+        ExReleaseFastMutex(&Fcb->LastMutex);
+        *Cluster = (ULONG)Lbn;
+        *RunLength = (ULONG)Count;
+        return STATUS_SUCCESS;
+    }
+    CurrentIndex = Fcb->MappedClusters;
+    CurrentCluster = PreviousCluster = Fcb->LastCluster;
+    ExReleaseFastMutex(&Fcb->LastMutex);
+
+    if (CurrentIndex > Index)
+    {
+        /* The map should have known it, walk from the start without it */
+        CurrentIndex = 0;
+        CurrentCluster = PreviousCluster = 0;
+        Recording = FALSE;
+    }
+
+    /* Carry on walking the chain from the end of the map */
+    while (CurrentIndex <= Index)
+    {
+        if (CurrentIndex == 0)
+        {
+            NewCluster = FirstCluster;
+        }
+        else
+        {
+            Status = GetNextCluster(DeviceExt, CurrentCluster, &NewCluster);
+            if (!NT_SUCCESS(Status) || NewCluster == 0xffffffff)
+                break;
+        }
+
+        if (RunClusters != 0 && RunStart + RunClusters != NewCluster)
+        {
+            if (Recording)
+                Recording = AddClusterRun(Fcb, RunIndex, PreviousCluster, RunStart, RunClusters);
+            PreviousCluster = CurrentCluster;
+            RunClusters = 0;
+        }
+        if (RunClusters == 0)
+        {
+            RunIndex = CurrentIndex;
+            RunStart = NewCluster;
+        }
+        RunClusters++;
+
+        CurrentCluster = NewCluster;
+        CurrentIndex++;
+    }
+
+    if (RunClusters != 0 && Recording)
+        AddClusterRun(Fcb, RunIndex, PreviousCluster, RunStart, RunClusters);
+
+    if (!NT_SUCCESS(Status))
+        return Status;
+
+    if (CurrentIndex <= Index)
+    {
+        *Cluster = 0xffffffff;
+        *RunLength = 0;
+    }
+    else
+    {
+        *Cluster = CurrentCluster;
+        *RunLength = 1;
+    }
+    return STATUS_SUCCESS;
+}
+
+/*
+ * Cut the FCB's cluster map back to the first clusters of the file, when
+ * its chain gets shortened
+ */
+VOID
+ForgetClusterRuns(
+    PVFATFCB Fcb,
+    ULONG KeepClusters)
+{
+    LONGLONG Lbn;
+
+    ExAcquireFastMutex(&Fcb->LastMutex);
+    if (KeepClusters < Fcb->MappedClusters)
+    {
+        FsRtlTruncateLargeMcb(&Fcb->Mcb, KeepClusters);
+        Fcb->MappedClusters = KeepClusters;
+        Fcb->LastCluster = 0;
+        if (KeepClusters > 0)
+        {
+            if (FsRtlLookupLargeMcbEntry(&Fcb->Mcb, KeepClusters - 1, &Lbn, NULL, NULL, NULL, NULL))
+            {
+                Fcb->LastCluster = (ULONG)Lbn;
+            }
+            else
+            {
+                FsRtlTruncateLargeMcb(&Fcb->Mcb, 0);
+                Fcb->MappedClusters = 0;
+            }
+        }
+    }
+    ExReleaseFastMutex(&Fcb->LastMutex);
+}
+
 /*
  * FUNCTION: Reads data from a file
  */
@@ -136,8 +302,7 @@ VfatReadFileData(
     ULONG BytesDone;
     ULONG BytesPerSector;
     ULONG BytesPerCluster;
-    ULONG LastCluster;
-    ULONG LastOffset;
+    ULONG RunLength;
 
     /* PRECONDITION */
     ASSERT(IrpContext);
@@ -215,46 +380,25 @@ VfatReadFileData(
         return Status;
     }
 
-    ExAcquireFastMutex(&Fcb->LastMutex);
-    LastCluster = Fcb->LastCluster;
-    LastOffset = Fcb->LastOffset;
-    ExReleaseFastMutex(&Fcb->LastMutex);
-
     /* Find the cluster to start the read from */
-    if (LastCluster > 0 && ReadOffset.u.LowPart >= LastOffset)
-    {
-        Status = OffsetToCluster(DeviceExt, LastCluster,
-                                 ROUND_DOWN(ReadOffset.u.LowPart, BytesPerCluster) -
-                                 LastOffset,
-                                 &CurrentCluster, FALSE);
-#ifdef DEBUG_VERIFY_OFFSET_CACHING
-        /* DEBUG VERIFICATION */
-        {
-            ULONG CorrectCluster;
-            OffsetToCluster(DeviceExt, FirstCluster,
-                            ROUND_DOWN(ReadOffset.u.LowPart, BytesPerCluster),
-                            &CorrectCluster, FALSE);
-            if (CorrectCluster != CurrentCluster)
-                KeBugCheck(FAT_FILE_SYSTEM);
-        }
-#endif
-    }
-    else
-    {
-        Status = OffsetToCluster(DeviceExt, FirstCluster,
-                                 ROUND_DOWN(ReadOffset.u.LowPart, BytesPerCluster),
-                                 &CurrentCluster, FALSE);
-    }
-
+    Status = OffsetToClusterRun(DeviceExt, Fcb, FirstCluster,
+                                ROUND_DOWN(ReadOffset.u.LowPart, BytesPerCluster),
+                                &CurrentCluster, &RunLength);
     if (!NT_SUCCESS(Status))
     {
         return Status;
     }
-
-    ExAcquireFastMutex(&Fcb->LastMutex);
-    Fcb->LastCluster = CurrentCluster;
-    Fcb->LastOffset = ROUND_DOWN (ReadOffset.u.LowPart, BytesPerCluster);
-    ExReleaseFastMutex(&Fcb->LastMutex);
+#ifdef DEBUG_VERIFY_OFFSET_CACHING
+    /* DEBUG VERIFICATION */
+    {
+        ULONG CorrectCluster;
+        OffsetToCluster(DeviceExt, FirstCluster,
+                        ROUND_DOWN(ReadOffset.u.LowPart, BytesPerCluster),
+                        &CorrectCluster, FALSE);
+        if (CorrectCluster != CurrentCluster)
+            KeBugCheck(FAT_FILE_SYSTEM);
+    }
+#endif
 
     KeInitializeEvent(&IrpContext->Event, NotificationEvent, FALSE);
     IrpContext->RefCount = 1;
@@ -286,17 +430,28 @@ VfatReadFileData(
                     BytesDone = Length;
                 }
             }
-            Status = NextCluster(DeviceExt, FirstCluster, &CurrentCluster, FALSE);
+
+            /* Move on within the run, or look the next one up */
+            if (Length > BytesDone)
+            {
+                if (--RunLength > 0)
+                {
+                    CurrentCluster++;
+                }
+                else
+                {
+                    Status = OffsetToClusterRun(DeviceExt, Fcb, FirstCluster,
+                                                ROUND_DOWN(ReadOffset.u.LowPart, BytesPerCluster) + ClusterCount * BytesPerCluster,
+                                                &CurrentCluster, &RunLength);
+                    if (!NT_SUCCESS(Status))
+                        CurrentCluster = 0xffffffff;
+                }
+            }
         }
         while (StartCluster + ClusterCount == CurrentCluster && NT_SUCCESS(Status) && Length > BytesDone);
         DPRINT("start %08x, next %08x, count %u\n",
                StartCluster, CurrentCluster, ClusterCount);
 
-        ExAcquireFastMutex(&Fcb->LastMutex);
-        Fcb->LastCluster = StartCluster + (ClusterCount - 1);
-        Fcb->LastOffset = ROUND_DOWN(ReadOffset.u.LowPart, BytesPerCluster) + (ClusterCount - 1) * BytesPerCluster;
-        ExReleaseFastMutex(&Fcb->LastMutex);
-
         /* Fire up the read command */
         Status = VfatReadDiskPartial (IrpContext, &StartOffset, BytesDone, *LengthRead, FALSE);
         if (!NT_SUCCESS(Status) && Status != STATUS_PENDING)
@@ -349,8 +504,7 @@ VfatWriteFileData(
     ULONG BytesPerCluster;
     LARGE_INTEGER StartOffset;
     ULONG BufferOffset;
-    ULONG LastCluster;
-    ULONG LastOffset;
+    ULONG RunLength;
 
     /* PRECONDITION */
     ASSERT(IrpContext);
@@ -428,48 +582,27 @@ VfatWriteFileData(
         return Status;
     }
 
-    ExAcquireFastMutex(&Fcb->LastMutex);
-    LastCluster = Fcb->LastCluster;
-    LastOffset = Fcb->LastOffset;
-    ExReleaseFastMutex(&Fcb->LastMutex);
-
     /*
      * Find the cluster to start the write from
      */
-    if (LastCluster > 0 && WriteOffset.u.LowPart >= LastOffset)
-    {
-        Status = OffsetToCluster(DeviceExt, LastCluster,
-                                 ROUND_DOWN(WriteOffset.u.LowPart, BytesPerCluster) -
-                                 LastOffset,
-                                 &CurrentCluster, FALSE);
-#ifdef DEBUG_VERIFY_OFFSET_CACHING
-        /* DEBUG VERIFICATION */
-        {
-            ULONG CorrectCluster;
-            OffsetToCluster(DeviceExt, FirstCluster,
-                            ROUND_DOWN(WriteOffset.u.LowPart, BytesPerCluster),
-                            &CorrectCluster, FALSE);
-            if (CorrectCluster != CurrentCluster)
-                KeBugCheck(FAT_FILE_SYSTEM);
-        }
-#endif
-    }
-    else
-    {
-        Status = OffsetToCluster(DeviceExt, FirstCluster,
-                                 ROUND_DOWN(WriteOffset.u.LowPart, BytesPerCluster),
-                                 &CurrentCluster, FALSE);
-    }
-
+    Status = OffsetToClusterRun(DeviceExt, Fcb, FirstCluster,
+                                ROUND_DOWN(WriteOffset.u.LowPart, BytesPerCluster),
+                                &CurrentCluster, &RunLength);
     if (!NT_SUCCESS(Status))
     {
         return Status;
     }
-
-    ExAcquireFastMutex(&Fcb->LastMutex);
-    Fcb->LastCluster = CurrentCluster;
-    Fcb->LastOffset = ROUND_DOWN (WriteOffset.u.LowPart, BytesPerCluster);
-    ExReleaseFastMutex(&Fcb->LastMutex);
+#ifdef DEBUG_VERIFY_OFFSET_CACHING
+    /* DEBUG VERIFICATION */
+    {
+        ULONG CorrectCluster;
+        OffsetToCluster(DeviceExt, FirstCluster,
+                        ROUND_DOWN(WriteOffset.u.LowPart, BytesPerCluster),
+                        &CorrectCluster, FALSE);
+        if (CorrectCluster != CurrentCluster)
+            KeBugCheck(FAT_FILE_SYSTEM);
+    }
+#endif
 
     IrpContext->RefCount = 1;
     BufferOffset = 0;
@@ -501,17 +634,28 @@ VfatWriteFileData(
                     BytesDone = Length;
                 }
             }
-            Status = NextCluster(DeviceExt, FirstCluster, &CurrentCluster, FALSE);
+
+            /* Move on within the run, or look the next one up */
+            if (Length > BytesDone)
+            {
+                if (--RunLength > 0)
+                {
+                    CurrentCluster++;
+                }
+                else
+                {
+                    Status = OffsetToClusterRun(DeviceExt, Fcb, FirstCluster,
+                                                ROUND_DOWN(WriteOffset.u.LowPart, BytesPerCluster) + ClusterCount * BytesPerCluster,
+                                                &CurrentCluster, &RunLength);
+                    if (!NT_SUCCESS(Status))
+                        CurrentCluster = 0xffffffff;
+                }
+            }
         }
         while (StartCluster + ClusterCount == CurrentCluster && NT_SUCCESS(Status) && Length > BytesDone);
         DPRINT("start %08x, next %08x, count %u\n",
                StartCluster, CurrentCluster, ClusterCount);
 
-        ExAcquireFastMutex(&Fcb->LastMutex);
-        Fcb->LastCluster = StartCluster + (ClusterCount - 1);
-        Fcb->LastOffset = ROUND_DOWN(WriteOffset.u.LowPart, BytesPerCluster) + (ClusterCount - 1) * BytesPerCluster;
-        ExReleaseFastMutex(&Fcb->LastMutex);
-
         // Fire up the write command
         Status = VfatWriteDiskPartial (IrpContext, &StartOffset, BytesDone, BufferOffset, FALSE);
         if (!NT_SUCCESS(Status) && Status != STATUS_PENDING)
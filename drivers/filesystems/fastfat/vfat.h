@@ -280,6 +280,51 @@ typedef struct _HASHENTRY
 }
 HASHENTRY;
 
+typedef struct _VFAT_FREE_RUN
+{
+    ULONG Cluster;
+    ULONG Count;
+} VFAT_FREE_RUN, *PVFAT_FREE_RUN;
+
+#define VFAT_FREE_RUNS 8
+
+/*
+ * Name index of a large directory: every entry is hashed under its long
+ * and its short name, and the runs of deleted slots are remembered so
+ * that new entries don't need a scan either. Only kept for FAT volumes,
+ * and only used with DirResource held exclusively.
+ */
+typedef struct _VFAT_NAME_INDEX_ENTRY
+{
+    ULONG Hash;
+    ULONG Next;
+    ULONG StartIndex;
+    ULONG DirIndex;
+} VFAT_NAME_INDEX_ENTRY, *PVFAT_NAME_INDEX_ENTRY;
+
+typedef struct _VFAT_FREE_SLOTS
+{
+    ULONG Index;
+    ULONG Count;
+} VFAT_FREE_SLOTS, *PVFAT_FREE_SLOTS;
+
+#define VFAT_NAME_INDEX_NONE        0xffffffff
+#define VFAT_NAME_INDEX_MIN_SLOTS   512
+#define VFAT_NAME_INDEX_FREE_RUNS   16
+
+typedef struct _VFAT_NAME_INDEX
+{
+    ULONG BucketCount;
+    PULONG Buckets;
+    ULONG EntryCount;
+    ULONG FreeEntry;
+    PVFAT_NAME_INDEX_ENTRY Entries;
+    /* First slot past the last entry, normally the end marker */
+    ULONG EndIndex;
+    ULONG FreeRunCount;
+    VFAT_FREE_SLOTS FreeRuns[VFAT_NAME_INDEX_FREE_RUNS];
+} VFAT_NAME_INDEX, *PVFAT_NAME_INDEX;
+
 typedef struct DEVICE_EXTENSION *PDEVICE_EXTENSION;
 
 typedef NTSTATUS (*PGET_NEXT_CLUSTER)(PDEVICE_EXTENSION,ULONG,PULONG);
@@ -325,6 +370,9 @@ typedef struct DEVICE_EXTENSION
     ULONG LastAvailableCluster;
     ULONG AvailableClusters;
     BOOLEAN AvailableClustersValid;
+    /* FAT32: runs of free clusters seen while scanning or freeing, allocated before scanning again */
+    ULONG FreeRunCount;
+    VFAT_FREE_RUN FreeRuns[VFAT_FREE_RUNS];
     ULONG Flags;
     struct _VFATFCB *VolumeFcb;
     struct _VFATFCB *RootFcb;
@@ -514,13 +562,19 @@ typedef struct _VFATFCB
     FILE_LOCK FileLock;
 
     /*
-     * Optimization: caching of last read/write cluster+offset pair. Can't
-     * be in VFATCCB because it must be reset everytime the allocated clusters
-     * change.
+     * Optimization: map of the file clusters to the disk clusters, filled
+     * in as the cluster chain gets walked. It always covers the first
+     * MappedClusters clusters of the chain, LastCluster being the last of
+     * them. Can't be in VFATCCB because it must be cut back everytime the
+     * allocated clusters change.
      */
     FAST_MUTEX LastMutex;
+    LARGE_MCB Mcb;
+    ULONG MappedClusters;
     ULONG LastCluster;
-    ULONG LastOffset;
+
+    /* Index of the entries of a large directory, built on first lookup */
+    PVFAT_NAME_INDEX NameIndex;
 
     struct _VFAT_CLOSE_CONTEXT * CloseContext;
 } VFATFCB, *PVFATFCB;
@@ -547,6 +601,7 @@ typedef struct _VFATCCB
 #define TAG_NAME 'ntaF'
 #define TAG_SEARCH 'LtaF'
 #define TAG_DIRENT 'DtaF'
+#define TAG_NAME_INDEX 'HtaF'
 
 #define ENTRIES_PER_SECTOR (BLOCKSIZE / sizeof(FATDirEntry))
 
@@ -1073,6 +1128,43 @@ vfatMakeFCBFromDirEntry(
     PVFAT_DIRENTRY_CONTEXT DirContext,
     PVFATFCB *fileFCB);
 
+VOID
+vfatFreeNameIndex(
+    PVFATFCB pDirFcb);
+
+BOOLEAN
+vfatNameIndexLookup(
+    PDEVICE_EXTENSION DeviceExt,
+    PVFATFCB pDirFcb,
+    PUNICODE_STRING FileToFindU,
+    PVFAT_DIRENTRY_CONTEXT DirContext,
+    PVOID *pContext,
+    PVOID *pPage,
+    PNTSTATUS Status);
+
+VOID
+vfatNameIndexAddEntry(
+    PVFATFCB pDirFcb,
+    PVFAT_DIRENTRY_CONTEXT DirContext);
+
+VOID
+vfatNameIndexRemoveEntry(
+    PVFATFCB pFcb);
+
+BOOLEAN
+vfatNameIndexFindSpace(
+    PDEVICE_EXTENSION DeviceExt,
+    PVFATFCB pDirFcb,
+    ULONG nbSlots,
+    PULONG Last,
+    PULONG nbFree);
+
+VOID
+vfatNameIndexUseSlots(
+    PVFATFCB pDirFcb,
+    ULONG Start,
+    ULONG Count);
+
 /* finfo.c */
 
 NTSTATUS
@@ -1198,6 +1290,20 @@ NextCluster(
     PULONG CurrentCluster,
     BOOLEAN Extend);
 
+NTSTATUS
+OffsetToClusterRun(
+    PDEVICE_EXTENSION DeviceExt,
+    PVFATFCB Fcb,
+    ULONG FirstCluster,
+    ULONG FileOffset,
+    PULONG Cluster,
+    PULONG RunLength);
+
+VOID
+ForgetClusterRuns(
+    PVFATFCB Fcb,
+    ULONG KeepClusters);
+
 /* shutdown.c */
 
 DRIVER_DISPATCH
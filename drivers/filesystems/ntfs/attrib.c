@@ -636,6 +636,14 @@ AddRun(PNTFS_VCB Vcb,
     }
     _SEH2_END;
 
+    Status = AddAttributeExtent(AttrContext, NextVBN, NextAssignedCluster, RunLength);
+    if (!NT_SUCCESS(Status))
+    {
+        DPRINT1("Failed to add the extent!\n");
+        FsRtlRemoveLargeMcbEntry(&AttrContext->DataRunsMCB, NextVBN, RunLength);
+        return Status;
+    }
+
     RunBuffer = ExAllocatePoolWithTag(NonPagedPool, Vcb->NtfsInfo.BytesPerFileRecord, TAG_NTFS);
     if (!RunBuffer)
     {
@@ -1142,6 +1150,7 @@ FreeClusters(PNTFS_VCB Vcb,
             RtlClearBits(&Bitmap, LargeLbn, 1);
         }
         FsRtlTruncateLargeMcb(&AttrContext->DataRunsMCB, AttrContext->pRecord->NonResident.HighestVCN);
+        TruncateAttributeExtents(AttrContext, AttrContext->pRecord->NonResident.HighestVCN);
 
         // decrement HighestVCN, but don't let it go below 0
         AttrContext->pRecord->NonResident.HighestVCN = min(AttrContext->pRecord->NonResident.HighestVCN, AttrContext->pRecord->NonResident.HighestVCN - 1);
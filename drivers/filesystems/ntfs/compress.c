@@ -0,0 +1,352 @@
+/*
+ * PROJECT:     ReactOS NTFS filesystem driver
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Reading compressed attributes
+ */
+
+/* INCLUDES *****************************************************************/
+
+#include "ntfs.h"
+
+#define NDEBUG
+#include <debug.h>
+
+/* FUNCTIONS ****************************************************************/
+
+/**
+* @name CheckCompressedAttribute
+* @implemented
+*
+* Checks that a compressed attribute uses a compression unit ReadCompressedAttribute()
+* can handle, before anything gets computed from the values on disk.
+*
+* @param Vcb
+* Volume Control Block of the volume the attribute is on.
+*
+* @param AttrRecord
+* Pointer to the compressed attribute record.
+*
+* @return
+* STATUS_SUCCESS if the attribute can be read, STATUS_FILE_CORRUPT_ERROR if its compression
+* unit isn't the one NTFS uses, STATUS_NOT_IMPLEMENTED if the volume has clusters larger than 4KB.
+*
+*/
+NTSTATUS
+CheckCompressedAttribute(PDEVICE_EXTENSION Vcb,
+                         PNTFS_ATTR_RECORD AttrRecord)
+{
+    if (AttrRecord->NonResident.CompressionUnit != NTFS_COMPRESSION_UNIT)
+    {
+        DPRINT1("Compression unit of 2^%u clusters!\n", AttrRecord->NonResident.CompressionUnit);
+        return STATUS_FILE_CORRUPT_ERROR;
+    }
+
+    if (Vcb->NtfsInfo.BytesPerCluster > NTFS_MAX_COMPRESSED_CLUSTER)
+    {
+        DPRINT1("Compressed attribute on a volume with %lu bytes per cluster!\n", Vcb->NtfsInfo.BytesPerCluster);
+        return STATUS_NOT_IMPLEMENTED;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+
+/**
+* @name ReadCompressionUnit
+* @implemented
+*
+* Reads one compression unit of a compressed attribute, and decompresses it.
+*
+* @param Vcb
+* Volume Control Block of the volume the attribute is on.
+*
+* @param Context
+* Pointer to an NTFS_ATTR_CONTEXT describing the compressed attribute.
+*
+* @param UnitVcn
+* First VCN of the compression unit.
+*
+* @param UnitBuffer
+* Pointer to a buffer the size of a compression unit, receiving its data.
+*
+* @param CompressedBuffer
+* Pointer to another buffer the size of a compression unit, used for the compressed data.
+*
+* @return
+* STATUS_SUCCESS on success, or the error returned by NtfsReadDisk() or RtlDecompressBuffer().
+*
+* @remarks
+* The allocated clusters of a unit come first, the sparse ones after them: a unit with no
+* sparse cluster is stored as is, one with only sparse clusters reads as zeroes, and any other
+* one holds LZNT1 compressed data.
+*/
+static
+NTSTATUS
+ReadCompressionUnit(PDEVICE_EXTENSION Vcb,
+                    PNTFS_ATTR_CONTEXT Context,
+                    ULONGLONG UnitVcn,
+                    PUCHAR UnitBuffer,
+                    PUCHAR CompressedBuffer)
+{
+    ULONG BytesPerCluster = Vcb->NtfsInfo.BytesPerCluster;
+    ULONG UnitClusters = 1 << NTFS_COMPRESSION_UNIT;
+    ULONG UnitSize = UnitClusters * BytesPerCluster;
+    ULONG Allocated, Clusters, FinalSize;
+    LONGLONG Lcn, Count;
+    PUCHAR ReadBuffer;
+    NTSTATUS Status;
+
+    // count the allocated clusters
+    for (Allocated = 0; Allocated < UnitClusters; Allocated += (ULONG)Count)
+    {
+        if (!FsRtlLookupLargeMcbEntry(&Context->DataRunsMCB, UnitVcn + Allocated, &Lcn, &Count, NULL, NULL, NULL) ||
+            Lcn == -1)
+        {
+            break;
+        }
+        Count = min(Count, UnitClusters - Allocated);
+    }
+
+    if (Allocated == 0)
+    {
+        RtlZeroMemory(UnitBuffer, UnitSize);
+        return STATUS_SUCCESS;
+    }
+
+    // read them, one piece of run at a time
+    ReadBuffer = (Allocated == UnitClusters) ? UnitBuffer : CompressedBuffer;
+    for (Clusters = 0; Clusters < Allocated; Clusters += (ULONG)Count)
+    {
+        FsRtlLookupLargeMcbEntry(&Context->DataRunsMCB, UnitVcn + Clusters, &Lcn, &Count, NULL, NULL, NULL);
+        Count = min(Count, Allocated - Clusters);
+
+        Status = NtfsReadDisk(Vcb->StorageDevice,
+                              Lcn * BytesPerCluster,
+                              (ULONG)Count * BytesPerCluster,
+                              Vcb->NtfsInfo.BytesPerSector,
+                              ReadBuffer + Clusters * BytesPerCluster,
+                              FALSE);
+        if (!NT_SUCCESS(Status))
+        {
+            return Status;
+        }
+    }
+
+    if (Allocated == UnitClusters)
+    {
+        return STATUS_SUCCESS;
+    }
+
+    Status = RtlDecompressBuffer(COMPRESSION_FORMAT_LZNT1,
+                                 UnitBuffer,
+                                 UnitSize,
+                                 CompressedBuffer,
+                                 Allocated * BytesPerCluster,
+                                 &FinalSize);
+    if (!NT_SUCCESS(Status))
+    {
+        DPRINT1("Bad compression unit at VCN %I64u (%lx)\n", UnitVcn, Status);
+        return Status;
+    }
+
+    // the zeroes at the end of the unit don't get stored
+    if (FinalSize < UnitSize)
+    {
+        RtlZeroMemory(UnitBuffer + FinalSize, UnitSize - FinalSize);
+    }
+
+    return STATUS_SUCCESS;
+}
+
+static
+BOOLEAN
+ReadFromCompressionCache(PNTFS_COMPRESSION_CACHE Cache,
+                         ULONGLONG UnitVcn,
+                         ULONG UnitOffset,
+                         PCHAR Buffer,
+                         ULONG Length)
+{
+    BOOLEAN Found = FALSE;
+    ULONG i;
+
+    ExAcquireFastMutex(&Cache->Lock);
+    for (i = 0; i < NTFS_COMPRESSION_CACHE_UNITS; i++)
+    {
+        if (Cache->Data[i] != NULL && Cache->UnitVcn[i] == UnitVcn)
+        {
+            RtlCopyMemory(Buffer, Cache->Data[i] + UnitOffset, Length);
+            Found = TRUE;
+            break;
+        }
+    }
+    ExReleaseFastMutex(&Cache->Lock);
+
+    return Found;
+}
+
+/*
+ * Keeps a decompressed unit, and hands back the buffer it replaces (if any)
+ * so the caller can use it for the next unit.
+ */
+static
+PUCHAR
+AddToCompressionCache(PNTFS_COMPRESSION_CACHE Cache,
+                      ULONGLONG UnitVcn,
+                      PUCHAR Data)
+{
+    PUCHAR Evicted;
+    ULONG i;
+
+    ExAcquireFastMutex(&Cache->Lock);
+    for (i = 0; i < NTFS_COMPRESSION_CACHE_UNITS; i++)
+    {
+        // another reader got there first
+        if (Cache->Data[i] != NULL && Cache->UnitVcn[i] == UnitVcn)
+        {
+            ExReleaseFastMutex(&Cache->Lock);
+            return Data;
+        }
+    }
+
+    Evicted = Cache->Data[Cache->Next];
+    Cache->Data[Cache->Next] = Data;
+    Cache->UnitVcn[Cache->Next] = UnitVcn;
+    Cache->Next = (Cache->Next + 1) % NTFS_COMPRESSION_CACHE_UNITS;
+    ExReleaseFastMutex(&Cache->Lock);
+
+    return Evicted;
+}
+
+VOID
+NtfsFreeCompressionCache(PNTFS_COMPRESSION_CACHE Cache)
+{
+    ULONG i;
+
+    for (i = 0; i < NTFS_COMPRESSION_CACHE_UNITS; i++)
+    {
+        if (Cache->Data[i] != NULL)
+        {
+            ExFreePoolWithTag(Cache->Data[i], TAG_NTFS);
+            Cache->Data[i] = NULL;
+        }
+    }
+}
+
+/**
+* @name ReadCompressedAttribute
+* @implemented
+*
+* Reads data from a compressed non-resident attribute.
+*
+* @param Vcb
+* Volume Control Block of the volume the attribute is on.
+*
+* @param Context
+* Pointer to an NTFS_ATTR_CONTEXT describing the compressed attribute.
+*
+* @param Cache
+* Optional pointer to the NTFS_COMPRESSION_CACHE of the stream, so that sequential reads
+* don't decompress the same unit over and over.
+*
+* @param Offset
+* Offset, in bytes, from the beginning of the attribute to start reading at. Needs no alignment.
+*
+* @param Buffer
+* Pointer to the buffer receiving the data.
+*
+* @param Length
+* Number of bytes to read. Needs no alignment.
+*
+* @return
+* The number of bytes read, which may be less than Length at the end of the attribute or
+* if a compression unit can't be read.
+*
+* @remarks
+* Called by ReadAttribute() and NtfsReadFile().
+*/
+ULONG
+ReadCompressedAttribute(PDEVICE_EXTENSION Vcb,
+                        PNTFS_ATTR_CONTEXT Context,
+                        PNTFS_COMPRESSION_CACHE Cache,
+                        ULONGLONG Offset,
+                        PCHAR Buffer,
+                        ULONG Length)
+{
+    ULONGLONG DataSize = Context->pRecord->NonResident.DataSize;
+    PUCHAR UnitBuffer = NULL;
+    PUCHAR CompressedBuffer;
+    ULONG AlreadyRead = 0;
+    ULONG UnitClusters;
+    ULONG UnitSize;
+    ULONG UnitOffset;
+    ULONG ReadLength;
+    ULONGLONG UnitVcn;
+    NTSTATUS Status;
+
+    ASSERT(AttributeIsCompressed(Context->pRecord));
+
+    if (!NT_SUCCESS(CheckCompressedAttribute(Vcb, Context->pRecord)))
+        return 0;
+
+    // At most 16 clusters of 4KB
+    UnitClusters = 1 << NTFS_COMPRESSION_UNIT;
+    UnitSize = UnitClusters * Vcb->NtfsInfo.BytesPerCluster;
+
+    if (Offset >= DataSize)
+        return 0;
+    if (Offset + Length > DataSize)
+        Length = (ULONG)(DataSize - Offset);
+
+    CompressedBuffer = ExAllocatePoolWithTag(PagedPool, UnitSize, TAG_NTFS);
+    if (CompressedBuffer == NULL)
+    {
+        return 0;
+    }
+
+    while (AlreadyRead < Length)
+    {
+        UnitVcn = ((Offset + AlreadyRead) / UnitSize) * UnitClusters;
+        UnitOffset = (ULONG)((Offset + AlreadyRead) % UnitSize);
+        ReadLength = min(UnitSize - UnitOffset, Length - AlreadyRead);
+
+        if (Cache != NULL &&
+            ReadFromCompressionCache(Cache, UnitVcn, UnitOffset, Buffer + AlreadyRead, ReadLength))
+        {
+            AlreadyRead += ReadLength;
+            continue;
+        }
+
+        if (UnitBuffer == NULL)
+        {
+            UnitBuffer = ExAllocatePoolWithTag(PagedPool, UnitSize, TAG_NTFS);
+            if (UnitBuffer == NULL)
+            {
+                break;
+            }
+        }
+
+        Status = ReadCompressionUnit(Vcb, Context, UnitVcn, UnitBuffer, CompressedBuffer);
+        if (!NT_SUCCESS(Status))
+        {
+            break;
+        }
+
+        RtlCopyMemory(Buffer + AlreadyRead, UnitBuffer + UnitOffset, ReadLength);
+        AlreadyRead += ReadLength;
+
+        if (Cache != NULL)
+        {
+            UnitBuffer = AddToCompressionCache(Cache, UnitVcn, UnitBuffer);
+        }
+    }
+
+    if (UnitBuffer != NULL)
+    {
+        ExFreePoolWithTag(UnitBuffer, TAG_NTFS);
+    }
+    ExFreePoolWithTag(CompressedBuffer, TAG_NTFS);
+
+    return AlreadyRead;
+}
+
+/* EOF */
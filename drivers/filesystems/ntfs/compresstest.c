@@ -0,0 +1,262 @@
+/*
+ * PROJECT:     ReactOS NTFS filesystem driver
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Host test for reading compressed attributes
+ *
+ * Builds compress.c against a fake run list and an in-memory disk, and
+ * feeds ReadCompressionUnit() stored, sparse and LZNT1 compressed units.
+ * Run with no arguments; the exit code is the number of failed checks.
+ */
+
+#include "host/ntfshost.h"
+#include "compress.c"
+
+#define CLUSTER_SIZE    512
+#define UNIT_CLUSTERS   (1 << NTFS_COMPRESSION_UNIT)
+#define UNIT_SIZE       (UNIT_CLUSTERS * CLUSTER_SIZE)
+#define DISK_CLUSTERS   600
+
+static UCHAR Disk[DISK_CLUSTERS * CLUSTER_SIZE];
+static ULONG DiskReads;
+static ULONG Failures;
+
+/*
+ * The attribute, one compression unit after the other:
+ *  0  stored as is, in two runs
+ *  1  one cluster of LZNT1 data (a compressed chunk, then the zero tail)
+ *  2  sparse, in the same sparse run as the tail of unit 1
+ *  3  LZNT1 data across two runs (a compressed chunk and a stored chunk)
+ *  4  one cluster of LZNT1 data that doesn't decompress
+ *  5  stored as is, in two runs, the second going on into unit 6
+ */
+static NTFS_ATTR_RECORD Record =
+{
+    TRUE, ATTR_RECORD_FLAG_COMPRESSED, { NTFS_COMPRESSION_UNIT, 7 * UNIT_SIZE - 100 }
+};
+
+static NTFS_ATTR_CONTEXT Context =
+{
+    {
+        10,
+        {
+            {  0, 100, 10 },
+            { 10, 200,  6 },
+            { 16, 300,  1 },
+            { 17,  -1, 31 },
+            { 48, 400,  4 },
+            { 52, 500,  5 },
+            { 57,  -1,  7 },
+            { 64, 310,  1 },
+            { 80, 320,  8 },
+            { 88, 340, 24 },
+        }
+    },
+    &Record
+};
+
+static DEVICE_EXTENSION Vcb = { NULL, { CLUSTER_SIZE, CLUSTER_SIZE } };
+
+/* What the units read as, but for unit 4 */
+static UCHAR Expected[6 * UNIT_SIZE];
+
+BOOLEAN
+FsRtlLookupLargeMcbEntry(PLARGE_MCB Mcb,
+                         LONGLONG Vbn,
+                         PLONGLONG Lbn,
+                         PLONGLONG SectorCountFromLbn,
+                         PLONGLONG StartingLbn,
+                         PLONGLONG SectorCountFromStartingLbn,
+                         PULONG Index)
+{
+    ULONG i;
+
+    for (i = 0; i < Mcb->RunCount; i++)
+    {
+        NTFS_HOST_RUN *Run = &Mcb->Runs[i];
+
+        if (Vbn >= Run->Vcn && Vbn < Run->Vcn + Run->Count)
+        {
+            *Lbn = (Run->Lcn == -1) ? -1 : Run->Lcn + (Vbn - Run->Vcn);
+            *SectorCountFromLbn = Run->Count - (Vbn - Run->Vcn);
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+NTSTATUS
+NtfsReadDisk(PDEVICE_OBJECT DeviceObject,
+             LONGLONG StartingOffset,
+             ULONG Length,
+             ULONG SectorSize,
+             PUCHAR Buffer,
+             BOOLEAN Override)
+{
+    if (StartingOffset % SectorSize != 0 || Length % SectorSize != 0 ||
+        StartingOffset + Length > sizeof(Disk))
+    {
+        return STATUS_DEVICE_DATA_ERROR;
+    }
+
+    memcpy(Buffer, Disk + StartingOffset, Length);
+    DiskReads++;
+    return STATUS_SUCCESS;
+}
+
+BOOLEAN
+AttributeIsCompressed(PNTFS_ATTR_RECORD AttrRecord)
+{
+    return (AttrRecord->IsNonResident &&
+            (AttrRecord->Flags & ATTR_RECORD_FLAG_COMPRESSED) &&
+            AttrRecord->NonResident.CompressionUnit != 0);
+}
+
+static VOID
+Check(BOOLEAN Condition, const char *What)
+{
+    if (!Condition)
+    {
+        printf("FAILED: %s\n", What);
+        Failures++;
+    }
+}
+
+static VOID
+PutWord(PUCHAR Where, WORD Value)
+{
+    Where[0] = (UCHAR)Value;
+    Where[1] = (UCHAR)(Value >> 8);
+}
+
+/* A compressed chunk: "ABCD", then a back reference repeating it up to 4KB */
+static ULONG
+PutCompressedChunk(PUCHAR Where)
+{
+    static const UCHAR Data[] = { 0x10, 'A', 'B', 'C', 'D', 0xF9, 0x3F };
+
+    PutWord(Where, 0xB000 | (sizeof(Data) - 1));
+    memcpy(Where + 2, Data, sizeof(Data));
+    return 2 + sizeof(Data);
+}
+
+static VOID
+BuildVolume(VOID)
+{
+    PUCHAR Unit;
+    PUCHAR Stored;
+    ULONG i;
+
+    /* unit 0 */
+    Unit = Expected;
+    for (i = 0; i < UNIT_SIZE; i++)
+        Unit[i] = (UCHAR)(i * 13 + 1);
+    memcpy(Disk + 100 * CLUSTER_SIZE, Unit, 10 * CLUSTER_SIZE);
+    memcpy(Disk + 200 * CLUSTER_SIZE, Unit + 10 * CLUSTER_SIZE, 6 * CLUSTER_SIZE);
+
+    /* unit 1, unit 2 stays zeroed */
+    Unit = Expected + UNIT_SIZE;
+    for (i = 0; i < 4096; i++)
+        Unit[i] = "ABCD"[i % 4];
+    PutCompressedChunk(Disk + 300 * CLUSTER_SIZE);
+
+    /* unit 3, the stored chunk straddles the two runs */
+    Unit = Expected + 3 * UNIT_SIZE;
+    for (i = 0; i < 4096; i++)
+    {
+        Unit[i] = "ABCD"[i % 4];
+        Unit[4096 + i] = (UCHAR)(i * 7 + 3);
+    }
+    Stored = malloc(9 * CLUSTER_SIZE);
+    memset(Stored, 0, 9 * CLUSTER_SIZE);
+    i = PutCompressedChunk(Stored);
+    PutWord(Stored + i, 0x3FFF);
+    memcpy(Stored + i + 2, Unit + 4096, 4096);
+    memcpy(Disk + 400 * CLUSTER_SIZE, Stored, 4 * CLUSTER_SIZE);
+    memcpy(Disk + 500 * CLUSTER_SIZE, Stored + 4 * CLUSTER_SIZE, 5 * CLUSTER_SIZE);
+    free(Stored);
+
+    /* unit 4: a back reference before the start of the chunk */
+    PutWord(Disk + 310 * CLUSTER_SIZE, 0xB002);
+    Disk[310 * CLUSTER_SIZE + 2] = 0x01;
+
+    /* unit 5 */
+    Unit = Expected + 5 * UNIT_SIZE;
+    for (i = 0; i < UNIT_SIZE; i++)
+        Unit[i] = (UCHAR)(i * 5 + 2);
+    memcpy(Disk + 320 * CLUSTER_SIZE, Unit, 8 * CLUSTER_SIZE);
+    memcpy(Disk + 340 * CLUSTER_SIZE, Unit + 8 * CLUSTER_SIZE, 8 * CLUSTER_SIZE);
+}
+
+static VOID
+TestUnit(ULONG Unit, ULONG Reads, const char *What)
+{
+    static UCHAR UnitBuffer[UNIT_SIZE], CompressedBuffer[UNIT_SIZE];
+    char Message[128];
+    NTSTATUS Status;
+
+    memset(UnitBuffer, 0xCC, sizeof(UnitBuffer));
+    DiskReads = 0;
+    Status = ReadCompressionUnit(&Vcb, &Context, Unit * UNIT_CLUSTERS, UnitBuffer, CompressedBuffer);
+
+    sprintf(Message, "%s unit: status %lx", What, (unsigned long)Status);
+    Check(Status == STATUS_SUCCESS, Message);
+    sprintf(Message, "%s unit: data", What);
+    Check(memcmp(UnitBuffer, Expected + Unit * UNIT_SIZE, UNIT_SIZE) == 0, Message);
+    sprintf(Message, "%s unit: %lu disk reads, expected %lu", What, (unsigned long)DiskReads, (unsigned long)Reads);
+    Check(DiskReads == Reads, Message);
+}
+
+static VOID
+TestBadUnit(VOID)
+{
+    static UCHAR UnitBuffer[UNIT_SIZE], CompressedBuffer[UNIT_SIZE];
+
+    Check(ReadCompressionUnit(&Vcb, &Context, 4 * UNIT_CLUSTERS, UnitBuffer, CompressedBuffer) ==
+          STATUS_BAD_COMPRESSION_BUFFER, "bad unit: status");
+}
+
+static VOID
+TestReadAttribute(VOID)
+{
+    NTFS_COMPRESSION_CACHE Cache;
+    static UCHAR Buffer[5 * UNIT_SIZE];
+    ULONG Read;
+
+    memset(&Cache, 0, sizeof(Cache));
+
+    /* unaligned, across units 0 to 2, keeping units 1 and 2 in the cache */
+    Read = ReadCompressedAttribute(&Vcb, &Context, &Cache, UNIT_SIZE - 10, (PCHAR)Buffer, UNIT_SIZE + 20);
+    Check(Read == UNIT_SIZE + 20, "attribute: length across units");
+    Check(memcmp(Buffer, Expected + UNIT_SIZE - 10, UNIT_SIZE + 20) == 0, "attribute: data across units");
+
+    DiskReads = 0;
+    Read = ReadCompressedAttribute(&Vcb, &Context, &Cache, UNIT_SIZE + 5, (PCHAR)Buffer, 100);
+    Check(Read == 100 && memcmp(Buffer, Expected + UNIT_SIZE + 5, 100) == 0, "attribute: cached data");
+    Check(DiskReads == 0, "attribute: cached unit read from disk");
+
+    /* up to the bad unit */
+    Read = ReadCompressedAttribute(&Vcb, &Context, &Cache, 3 * UNIT_SIZE + 1, (PCHAR)Buffer, 2 * UNIT_SIZE);
+    Check(Read == UNIT_SIZE - 1, "attribute: stops at the bad unit");
+    Check(memcmp(Buffer, Expected + 3 * UNIT_SIZE + 1, UNIT_SIZE - 1) == 0, "attribute: data before the bad unit");
+
+    NtfsFreeCompressionCache(&Cache);
+}
+
+int main(int argc, char *argv[])
+{
+    BuildVolume();
+
+    TestUnit(0, 2, "stored");
+    TestUnit(1, 1, "compressed");
+    TestUnit(2, 0, "sparse");
+    TestUnit(3, 2, "compressed split");
+    TestUnit(5, 2, "stored long run");
+    TestBadUnit();
+    TestReadAttribute();
+
+    printf("%lu failures\n", (unsigned long)Failures);
+    return (int)Failures;
+}
+
+/* EOF */
@@ -104,6 +104,7 @@ NtfsCreateFCB(PCWSTR FileName,
     }
 
     ExInitializeResourceLite(&Fcb->MainResource);
+    ExInitializeFastMutex(&Fcb->CompressionCache.Lock);
 
     Fcb->RFCB.Resource = &(Fcb->MainResource);
 
@@ -118,6 +119,7 @@ NtfsDestroyFCB(PNTFS_FCB Fcb)
     ASSERT(Fcb->Identifier.Type == NTFS_TYPE_FCB);
 
     ExDeleteResourceLite(&Fcb->MainResource);
+    NtfsFreeCompressionCache(&Fcb->CompressionCache);
 
     ExFreeToNPagedLookasideList(&NtfsGlobalData->FcbLookasideList, Fcb);
 }
@@ -276,10 +276,12 @@ NtfsGetVolumeData(PDEVICE_OBJECT DeviceObject,
 
     ExInitializeNPagedLookasideList(&DeviceExt->FileRecLookasideList,
                                     NULL, NULL, 0, NtfsInfo->BytesPerFileRecord, TAG_FILE_REC, 0);
+    NtfsInitializeMftCache(DeviceExt);
 
     DeviceExt->MasterFileTable = ExAllocateFromNPagedLookasideList(&DeviceExt->FileRecLookasideList);
     if (DeviceExt->MasterFileTable == NULL)
     {
+        NtfsFreeMftCache(DeviceExt);
         ExDeleteNPagedLookasideList(&DeviceExt->FileRecLookasideList);
         return STATUS_INSUFFICIENT_RESOURCES;
     }
@@ -294,6 +296,7 @@ NtfsGetVolumeData(PDEVICE_OBJECT DeviceObject,
     {
         DPRINT1("Failed reading MFT.\n");
         ExFreeToNPagedLookasideList(&DeviceExt->FileRecLookasideList, DeviceExt->MasterFileTable);
+        NtfsFreeMftCache(DeviceExt);
         ExDeleteNPagedLookasideList(&DeviceExt->FileRecLookasideList);
         return Status;
     }
@@ -309,6 +312,7 @@ NtfsGetVolumeData(PDEVICE_OBJECT DeviceObject,
     {
         DPRINT1("Can't find data attribute for Master File Table.\n");
         ExFreeToNPagedLookasideList(&DeviceExt->FileRecLookasideList, DeviceExt->MasterFileTable);
+        NtfsFreeMftCache(DeviceExt);
         ExDeleteNPagedLookasideList(&DeviceExt->FileRecLookasideList);
         return Status;
     }
@@ -318,6 +322,7 @@ NtfsGetVolumeData(PDEVICE_OBJECT DeviceObject,
     {
         DPRINT1("Allocation failed for volume record\n");
         ExFreeToNPagedLookasideList(&DeviceExt->FileRecLookasideList, DeviceExt->MasterFileTable);
+        NtfsFreeMftCache(DeviceExt);
         ExDeleteNPagedLookasideList(&DeviceExt->FileRecLookasideList);
         return STATUS_INSUFFICIENT_RESOURCES;
     }
@@ -332,6 +337,7 @@ NtfsGetVolumeData(PDEVICE_OBJECT DeviceObject,
         DPRINT1("Failed reading volume file\n");
         ExFreeToNPagedLookasideList(&DeviceExt->FileRecLookasideList, VolumeRecord);
         ExFreeToNPagedLookasideList(&DeviceExt->FileRecLookasideList, DeviceExt->MasterFileTable);
+        NtfsFreeMftCache(DeviceExt);
         ExDeleteNPagedLookasideList(&DeviceExt->FileRecLookasideList);
         return Status;
     }
@@ -373,6 +379,7 @@ NtfsGetVolumeData(PDEVICE_OBJECT DeviceObject,
         DPRINT1("Failed allocating volume FCB\n");
         ExFreeToNPagedLookasideList(&DeviceExt->FileRecLookasideList, VolumeRecord);
         ExFreeToNPagedLookasideList(&DeviceExt->FileRecLookasideList, DeviceExt->MasterFileTable);
+        NtfsFreeMftCache(DeviceExt);
         ExDeleteNPagedLookasideList(&DeviceExt->FileRecLookasideList);
         return STATUS_INSUFFICIENT_RESOURCES;
     }
@@ -565,7 +572,10 @@ ByeBye:
             ExFreePool(Ccb);
 
         if (Lookaside)
+        {
+            NtfsFreeMftCache(Vcb);
             ExDeleteNPagedLookasideList(&Vcb->FileRecLookasideList);
+        }
 
         if (NewDeviceObject)
             IoDeleteDevice(NewDeviceObject);
@@ -0,0 +1,152 @@
+/*
+ * PROJECT:     ReactOS NTFS filesystem driver
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Minimal stand-in for ntfs.h, to build compress.c as a host test
+ */
+
+#pragma once
+
+/* Keep the real ntfs.h out, compress.c includes it */
+#define NTFS_H
+
+#include <typedefs.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef min
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+
+typedef LONGLONG *PLONGLONG;
+
+#define STATUS_SUCCESS                   ((NTSTATUS)0x00000000)
+#define STATUS_NOT_IMPLEMENTED           ((NTSTATUS)0xC0000002)
+#define STATUS_ACCESS_VIOLATION          ((NTSTATUS)0xC0000005)
+#define STATUS_INVALID_PARAMETER         ((NTSTATUS)0xC000000D)
+#define STATUS_BUFFER_TOO_SMALL          ((NTSTATUS)0xC0000023)
+#define STATUS_UNSUPPORTED_COMPRESSION   ((NTSTATUS)0xC000025F)
+#define STATUS_BAD_COMPRESSION_BUFFER    ((NTSTATUS)0xC0000242)
+#define STATUS_NOT_SUPPORTED             ((NTSTATUS)0xC00000BB)
+#define STATUS_FILE_CORRUPT_ERROR        ((NTSTATUS)0xC0000102)
+#define STATUS_DEVICE_DATA_ERROR         ((NTSTATUS)0xC000009C)
+
+#define COMPRESSION_FORMAT_NONE          0x0000
+#define COMPRESSION_FORMAT_DEFAULT       0x0001
+#define COMPRESSION_FORMAT_LZNT1         0x0002
+#define COMPRESSION_ENGINE_STANDARD      0x0000
+#define COMPRESSION_ENGINE_MAXIMUM       0x0100
+
+typedef struct _COMPRESSED_DATA_INFO *PCOMPRESSED_DATA_INFO;
+
+NTSTATUS NTAPI
+RtlDecompressBuffer(USHORT CompressionFormat,
+                    PUCHAR UncompressedBuffer,
+                    ULONG UncompressedBufferSize,
+                    PUCHAR CompressedBuffer,
+                    ULONG CompressedBufferSize,
+                    PULONG FinalUncompressedSize);
+
+/* Pool and locks */
+#define PagedPool 1
+#define TAG_NTFS 'SFTN'
+#define ExAllocatePoolWithTag(Type, Size, Tag) malloc(Size)
+#define ExFreePoolWithTag(P, Tag) free(P)
+
+typedef LONG FAST_MUTEX;
+#define ExAcquireFastMutex(M) ((void)(M))
+#define ExReleaseFastMutex(M) ((void)(M))
+
+/* A run list, in place of the FsRtl large MCB; Lcn -1 is a sparse run */
+typedef struct _NTFS_HOST_RUN
+{
+    LONGLONG Vcn;
+    LONGLONG Lcn;
+    LONGLONG Count;
+} NTFS_HOST_RUN;
+
+typedef struct _LARGE_MCB
+{
+    ULONG RunCount;
+    NTFS_HOST_RUN Runs[16];
+} LARGE_MCB, *PLARGE_MCB;
+
+BOOLEAN
+FsRtlLookupLargeMcbEntry(PLARGE_MCB Mcb,
+                         LONGLONG Vbn,
+                         PLONGLONG Lbn,
+                         PLONGLONG SectorCountFromLbn,
+                         PLONGLONG StartingLbn,
+                         PLONGLONG SectorCountFromStartingLbn,
+                         PULONG Index);
+
+/* The fields of the driver structures compress.c uses */
+#define ATTR_RECORD_FLAG_COMPRESSED 0x0001
+
+typedef struct
+{
+    UCHAR IsNonResident;
+    USHORT Flags;
+    struct
+    {
+        USHORT CompressionUnit;
+        ULONGLONG DataSize;
+    } NonResident;
+} NTFS_ATTR_RECORD, *PNTFS_ATTR_RECORD;
+
+typedef struct
+{
+    LARGE_MCB DataRunsMCB;
+    PNTFS_ATTR_RECORD pRecord;
+} NTFS_ATTR_CONTEXT, *PNTFS_ATTR_CONTEXT;
+
+typedef struct _DEVICE_OBJECT *PDEVICE_OBJECT;
+
+typedef struct
+{
+    PDEVICE_OBJECT StorageDevice;
+    struct
+    {
+        ULONG BytesPerSector;
+        ULONG BytesPerCluster;
+    } NtfsInfo;
+} DEVICE_EXTENSION, *PDEVICE_EXTENSION;
+
+#define NTFS_COMPRESSION_CACHE_UNITS    2
+#define NTFS_COMPRESSION_UNIT           4
+#define NTFS_MAX_COMPRESSED_CLUSTER     4096
+
+typedef struct _NTFS_COMPRESSION_CACHE
+{
+    FAST_MUTEX Lock;
+    ULONG Next;
+    ULONGLONG UnitVcn[NTFS_COMPRESSION_CACHE_UNITS];
+    PUCHAR Data[NTFS_COMPRESSION_CACHE_UNITS];
+} NTFS_COMPRESSION_CACHE, *PNTFS_COMPRESSION_CACHE;
+
+BOOLEAN
+AttributeIsCompressed(PNTFS_ATTR_RECORD AttrRecord);
+
+NTSTATUS
+NtfsReadDisk(PDEVICE_OBJECT DeviceObject,
+             LONGLONG StartingOffset,
+             ULONG Length,
+             ULONG SectorSize,
+             PUCHAR Buffer,
+             BOOLEAN Override);
+
+NTSTATUS
+CheckCompressedAttribute(PDEVICE_EXTENSION Vcb,
+                         PNTFS_ATTR_RECORD AttrRecord);
+
+ULONG
+ReadCompressedAttribute(PDEVICE_EXTENSION Vcb,
+                        PNTFS_ATTR_CONTEXT Context,
+                        PNTFS_COMPRESSION_CACHE Cache,
+                        ULONGLONG Offset,
+                        PCHAR Buffer,
+                        ULONG Length);
+
+VOID
+NtfsFreeCompressionCache(PNTFS_COMPRESSION_CACHE Cache);
+
+/* EOF */
@@ -0,0 +1,11 @@
+/*
+ * PROJECT:     ReactOS NTFS filesystem driver
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Minimal rtl.h, to build the RTL LZNT1 code into the host test
+ */
+
+#pragma once
+
+#include "ntfshost.h"
+
+/* EOF */
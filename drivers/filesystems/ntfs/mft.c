@@ -49,6 +49,11 @@ PrepareAttributeContext(PNTFS_ATTR_RECORD AttrRecord)
         return NULL;
     }
 
+    ExInitializeFastMutex(&Context->ExtentLock);
+    Context->ExtentCount = 0;
+    Context->ExtentCapacity = 0;
+    Context->Extents = NULL;
+
     // Allocate memory for a copy of the attribute
     Context->pRecord = ExAllocatePoolWithTag(NonPagedPool, AttrRecord->Length, TAG_NTFS);
     if(!Context->pRecord)
@@ -66,6 +71,7 @@ PrepareAttributeContext(PNTFS_ATTR_RECORD AttrRecord)
         LONGLONG DataRunOffset;
         ULONGLONG DataRunLength;
         ULONGLONG NextVBN = 0;
+        LONGLONG LastLCN;
         PUCHAR DataRun = (PUCHAR)((ULONG_PTR)Context->pRecord + Context->pRecord->NonResident.MappingPairsOffset);
 
         Context->CacheRun = DataRun;
@@ -94,6 +100,29 @@ PrepareAttributeContext(PNTFS_ATTR_RECORD AttrRecord)
             ExFreeToNPagedLookasideList(&NtfsGlobalData->AttrCtxtLookasideList, Context);
             return NULL;
         }
+
+        // Also keep them as extents for ReadAttribute(), decoding the runs in one go
+        NextVBN = 0;
+        LastLCN = 0;
+        while (*DataRun != 0)
+        {
+            DataRun = DecodeRun(DataRun, &DataRunOffset, &DataRunLength);
+            if (DataRunOffset != -1)
+                LastLCN += DataRunOffset;
+
+            if (!NT_SUCCESS(AddAttributeExtent(Context, NextVBN, (DataRunOffset != -1) ? LastLCN : -1, DataRunLength)))
+            {
+                DPRINT1("Unable to allocate the extents of the attribute!\n");
+                FsRtlUninitializeLargeMcb(&Context->DataRunsMCB);
+                if (Context->Extents)
+                    ExFreePoolWithTag(Context->Extents, TAG_EXTENTS);
+                ExFreePoolWithTag(Context->pRecord, TAG_NTFS);
+                ExFreeToNPagedLookasideList(&NtfsGlobalData->AttrCtxtLookasideList, Context);
+                return NULL;
+            }
+
+            NextVBN += DataRunLength;
+        }
     }
 
     return Context;
@@ -103,6 +132,11 @@ PrepareAttributeContext(PNTFS_ATTR_RECORD AttrRecord)
 VOID
 ReleaseAttributeContext(PNTFS_ATTR_CONTEXT Context)
 {
+    if (Context->Extents)
+    {
+        ExFreePoolWithTag(Context->Extents, TAG_EXTENTS);
+    }
+
     if (Context->pRecord)
     {
         if (Context->pRecord->IsNonResident)
@@ -117,6 +151,225 @@ ReleaseAttributeContext(PNTFS_ATTR_CONTEXT Context)
 }
 
 
+/**
+* @name TruncateAttributeExtents
+* @implemented
+*
+* Drops the clusters at and beyond a given VCN from the extents of an attribute context.
+* Must be called along with FsRtlTruncateLargeMcb() on its DataRunsMCB.
+*
+* @param Context
+* Pointer to the attribute context.
+*
+* @param Vcn
+* The first cluster to drop.
+*
+*/
+VOID
+TruncateAttributeExtents(PNTFS_ATTR_CONTEXT Context,
+                         ULONGLONG Vcn)
+{
+    PNTFS_EXTENT Last;
+
+    ExAcquireFastMutex(&Context->ExtentLock);
+
+    while (Context->ExtentCount > 0)
+    {
+        Last = &Context->Extents[Context->ExtentCount - 1];
+        if (Last->Vcn + Last->Length <= Vcn)
+            break;
+
+        if (Last->Vcn < Vcn)
+        {
+            Last->Length = Vcn - Last->Vcn;
+            break;
+        }
+
+        Context->ExtentCount--;
+    }
+
+    ExReleaseFastMutex(&Context->ExtentLock);
+}
+
+
+/* Called with the ExtentLock held */
+static
+NTSTATUS
+AppendExtent(PNTFS_ATTR_CONTEXT Context,
+             ULONGLONG Vcn,
+             LONGLONG Lcn,
+             ULONGLONG Length)
+{
+    PNTFS_EXTENT Extents, Last;
+    ULONG Capacity;
+
+    // Merge with the last extent if the clusters follow it on disk too
+    Last = Context->ExtentCount ? &Context->Extents[Context->ExtentCount - 1] : NULL;
+    if (Last && Last->Vcn + Last->Length == Vcn &&
+        ((Last->Lcn == -1 && Lcn == -1) ||
+         (Last->Lcn != -1 && Lcn != -1 && Last->Lcn + Last->Length == (ULONGLONG)Lcn)))
+    {
+        Last->Length += Length;
+        return STATUS_SUCCESS;
+    }
+
+    if (Context->ExtentCount == Context->ExtentCapacity)
+    {
+        Capacity = max(Context->ExtentCapacity * 2, 8);
+        Extents = ExAllocatePoolWithTag(NonPagedPool, Capacity * sizeof(NTFS_EXTENT), TAG_EXTENTS);
+        if (!Extents)
+            return STATUS_INSUFFICIENT_RESOURCES;
+
+        if (Context->Extents)
+        {
+            RtlCopyMemory(Extents, Context->Extents, Context->ExtentCount * sizeof(NTFS_EXTENT));
+            ExFreePoolWithTag(Context->Extents, TAG_EXTENTS);
+        }
+        Context->Extents = Extents;
+        Context->ExtentCapacity = Capacity;
+    }
+
+    Context->Extents[Context->ExtentCount].Vcn = Vcn;
+    Context->Extents[Context->ExtentCount].Lcn = Lcn;
+    Context->Extents[Context->ExtentCount].Length = Length;
+    Context->ExtentCount++;
+    return STATUS_SUCCESS;
+}
+
+
+/**
+* @name AddAttributeExtent
+* @implemented
+*
+* Maps clusters at the end of an attribute in the extents of its context, merging them
+* with the last extent when they follow it on disk. Clusters between the current end
+* and Vcn become sparse. Must be called along with FsRtlAddLargeMcbEntry() on its
+* DataRunsMCB, which gets the same runs.
+*
+* @param Context
+* Pointer to the attribute context.
+*
+* @param Vcn
+* First cluster of the attribute to map.
+*
+* @param Lcn
+* Cluster on disk Vcn maps to, or -1 for a sparse run.
+*
+* @param Length
+* Number of clusters to map.
+*
+* @return
+* STATUS_SUCCESS on success, STATUS_INSUFFICIENT_RESOURCES if the extents couldn't grow.
+* The extents are left unchanged on failure.
+*
+*/
+NTSTATUS
+AddAttributeExtent(PNTFS_ATTR_CONTEXT Context,
+                   ULONGLONG Vcn,
+                   LONGLONG Lcn,
+                   ULONGLONG Length)
+{
+    ULONGLONG End = 0, LastLength = 0;
+    ULONG OldCount;
+    NTSTATUS Status = STATUS_SUCCESS;
+
+    if (Length == 0)
+        return STATUS_SUCCESS;
+
+    ExAcquireFastMutex(&Context->ExtentLock);
+
+    OldCount = Context->ExtentCount;
+    if (OldCount > 0)
+    {
+        LastLength = Context->Extents[OldCount - 1].Length;
+        End = Context->Extents[OldCount - 1].Vcn + LastLength;
+    }
+
+    if (Vcn < End)
+    {
+        DPRINT1("Clusters %I64u-%I64u are already mapped!\n", Vcn, End - 1);
+        ExReleaseFastMutex(&Context->ExtentLock);
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    if (Vcn > End)
+        Status = AppendExtent(Context, End, -1, Vcn - End);
+    if (NT_SUCCESS(Status))
+        Status = AppendExtent(Context, Vcn, Lcn, Length);
+
+    if (!NT_SUCCESS(Status))
+    {
+        // Undo the sparse extent, which may have been merged into the last one
+        Context->ExtentCount = OldCount;
+        if (OldCount > 0)
+            Context->Extents[OldCount - 1].Length = LastLength;
+    }
+
+    ExReleaseFastMutex(&Context->ExtentLock);
+    return Status;
+}
+
+
+/**
+* @name LookupAttributeExtent
+* @implemented
+*
+* Finds the extent of a non-resident attribute that holds a given cluster, with a
+* binary search.
+*
+* @param Context
+* Pointer to the attribute context.
+*
+* @param Vcn
+* The cluster of the attribute to look for.
+*
+* @param Extent
+* Pointer to an NTFS_EXTENT that receives a copy of the extent.
+*
+* @return
+* TRUE if the cluster is mapped by the attribute, FALSE if it lies beyond its last run.
+*
+* @remarks
+* The extent is copied out because another thread may grow or truncate the array as
+* soon as the lock is released.
+*
+*/
+static
+BOOLEAN
+LookupAttributeExtent(PNTFS_ATTR_CONTEXT Context,
+                      ULONGLONG Vcn,
+                      PNTFS_EXTENT Extent)
+{
+    ULONG Low, High, Middle;
+    BOOLEAN Found = FALSE;
+
+    ExAcquireFastMutex(&Context->ExtentLock);
+
+    // Find the last extent starting at or before Vcn
+    Low = 0;
+    High = Context->ExtentCount;
+    while (High - Low > 1)
+    {
+        Middle = Low + (High - Low) / 2;
+        if (Context->Extents[Middle].Vcn <= Vcn)
+            Low = Middle;
+        else
+            High = Middle;
+    }
+
+    if (Low < Context->ExtentCount &&
+        Context->Extents[Low].Vcn <= Vcn &&
+        Vcn < Context->Extents[Low].Vcn + Context->Extents[Low].Length)
+    {
+        *Extent = Context->Extents[Low];
+        Found = TRUE;
+    }
+
+    ExReleaseFastMutex(&Context->ExtentLock);
+    return Found;
+}
+
+
 /**
 * @name FindAttribute
 * @implemented
@@ -264,6 +517,16 @@ AttributeDataLength(PNTFS_ATTR_RECORD AttrRecord)
         return AttrRecord->Resident.ValueLength;
 }
 
+
+BOOLEAN
+AttributeIsCompressed(PNTFS_ATTR_RECORD AttrRecord)
+{
+    // Only non-resident attributes are ever stored compressed
+    return (AttrRecord->IsNonResident &&
+            (AttrRecord->Flags & ATTR_RECORD_FLAG_COMPRESSED) &&
+            AttrRecord->NonResident.CompressionUnit != 0);
+}
+
 /**
 * @name IncreaseMftSize
 * @implemented
@@ -746,6 +1009,7 @@ SetFileRecordEnd(PFILE_RECORD_HEADER FileRecord,
 * STATUS_SUCCESS on success;
 * STATUS_INSUFFICIENT_RESOURCES if an allocation fails.
 * STATUS_INVALID_PARAMETER if we can't find the last cluster in the data run.
+* STATUS_NOT_IMPLEMENTED if the attribute is compressed.
 *
 * @remarks
 * Called by SetAttributeDataLength() and IncreaseMftSize(). Use SetAttributeDataLength() unless you have a good 
@@ -767,6 +1031,13 @@ SetNonResidentAttributeDataLength(PDEVICE_EXTENSION Vcb,
 
     ASSERT(AttrContext->pRecord->IsNonResident);
 
+    // compression units would need to be rewritten
+    if (AttributeIsCompressed(AttrContext->pRecord))
+    {
+        DPRINT1("FIXME: Can't resize compressed attributes!\n");
+        return STATUS_NOT_IMPLEMENTED;
+    }
+
     // do we need to increase the allocation size?
     if (AttrContext->pRecord->NonResident.AllocatedSize < AllocationSize)
     {
@@ -833,7 +1104,7 @@ SetNonResidentAttributeDataLength(PDEVICE_EXTENSION Vcb,
         Status = FreeClusters(Vcb, AttrContext, AttrOffset, FileRecord, ClustersToFree);
     }
 
-    // TODO: is the file compressed, encrypted, or sparse?
+    // TODO: is the file encrypted, or sparse?
 
     AttrContext->pRecord->NonResident.AllocatedSize = AllocationSize;
     AttrContext->pRecord->NonResident.DataSize = DataSize->QuadPart;
@@ -1068,18 +1339,11 @@ ReadAttribute(PDEVICE_EXTENSION Vcb,
               PCHAR Buffer,
               ULONG Length)
 {
-    ULONGLONG LastLCN;
-    PUCHAR DataRun;
-    LONGLONG DataRunOffset;
-    ULONGLONG DataRunLength;
-    LONGLONG DataRunStartLCN;
-    ULONGLONG CurrentOffset;
+    NTFS_EXTENT Extent;
+    ULONGLONG ExtentOffset;
     ULONG ReadLength;
     ULONG AlreadyRead;
     NTSTATUS Status;
-    
-    //TEMPTEMP
-    PUCHAR TempBuffer;
 
     if (!Context->pRecord->IsNonResident)
     {
@@ -1101,170 +1365,48 @@ ReadAttribute(PDEVICE_EXTENSION Vcb,
      * Non-resident attribute
      */
 
+    if (AttributeIsCompressed(Context->pRecord))
+    {
+        return ReadCompressedAttribute(Vcb, Context, NULL, Offset, Buffer, Length);
+    }
+
     /*
-     * I. Find the corresponding start data run.
+     * Go through the extents of the attribute, starting with the one holding Offset.
+     * Runs that follow each other on disk were merged into one extent, so each
+     * extent takes a single read no matter how the run list was split.
      */
 
     AlreadyRead = 0;
-
-    // FIXME: Cache seems to be non-working. Disable it for now
-    //if(Context->CacheRunOffset <= Offset && Offset < Context->CacheRunOffset + Context->CacheRunLength * Volume->ClusterSize)
-    if (0)
-    {
-        DataRun = Context->CacheRun;
-        LastLCN = Context->CacheRunLastLCN;
-        DataRunStartLCN = Context->CacheRunStartLCN;
-        DataRunLength = Context->CacheRunLength;
-        CurrentOffset = Context->CacheRunCurrentOffset;
-    }
-    else
+    while (Length > 0)
     {
-        //TEMPTEMP
-        ULONG UsedBufferSize;
-        TempBuffer = ExAllocatePoolWithTag(NonPagedPool, Vcb->NtfsInfo.BytesPerFileRecord, TAG_NTFS);
-        if (TempBuffer == NULL)
-        {
-            return STATUS_INSUFFICIENT_RESOURCES;
-        }
-
-        LastLCN = 0;
-        CurrentOffset = 0;
-
-        // This will be rewritten in the next iteration to just use the DataRuns MCB directly
-        ConvertLargeMCBToDataRuns(&Context->DataRunsMCB,
-                                  TempBuffer,
-                                  Vcb->NtfsInfo.BytesPerFileRecord,
-                                  &UsedBufferSize);
+        if (!LookupAttributeExtent(Context, Offset / Vcb->NtfsInfo.BytesPerCluster, &Extent))
+            break;
 
-        DataRun = TempBuffer;
+        ExtentOffset = Offset - Extent.Vcn * Vcb->NtfsInfo.BytesPerCluster;
+        ReadLength = (ULONG)min(Extent.Length * Vcb->NtfsInfo.BytesPerCluster - ExtentOffset, Length);
 
-        while (1)
+        if (Extent.Lcn == -1)
         {
-            DataRun = DecodeRun(DataRun, &DataRunOffset, &DataRunLength);
-            if (DataRunOffset != -1)
-            {
-                /* Normal data run. */
-                DataRunStartLCN = LastLCN + DataRunOffset;
-                LastLCN = DataRunStartLCN;
-            }
-            else
-            {
-                /* Sparse data run. */
-                DataRunStartLCN = -1;
-            }
-
-            if (Offset >= CurrentOffset &&
-                Offset < CurrentOffset + (DataRunLength * Vcb->NtfsInfo.BytesPerCluster))
-            {
+            /* Sparse extent. */
+            RtlZeroMemory(Buffer, ReadLength);
+        }
+        else
+        {
+            Status = NtfsReadDisk(Vcb->StorageDevice,
+                                  Extent.Lcn * Vcb->NtfsInfo.BytesPerCluster + ExtentOffset,
+                                  ReadLength,
+                                  Vcb->NtfsInfo.BytesPerSector,
+                                  (PVOID)Buffer,
+                                  FALSE);
+            if (!NT_SUCCESS(Status))
                 break;
-            }
-
-            if (*DataRun == 0)
-            {
-                ExFreePoolWithTag(TempBuffer, TAG_NTFS);
-                return AlreadyRead;
-            }
-
-            CurrentOffset += DataRunLength * Vcb->NtfsInfo.BytesPerCluster;
         }
-    }
-
-    /*
-     * II. Go through the run list and read the data
-     */
 
-    ReadLength = (ULONG)min(DataRunLength * Vcb->NtfsInfo.BytesPerCluster - (Offset - CurrentOffset), Length);
-    if (DataRunStartLCN == -1)
-    {
-        RtlZeroMemory(Buffer, ReadLength);
-        Status = STATUS_SUCCESS;
-    }
-    else
-    {
-        Status = NtfsReadDisk(Vcb->StorageDevice,
-                              DataRunStartLCN * Vcb->NtfsInfo.BytesPerCluster + Offset - CurrentOffset,
-                              ReadLength,
-                              Vcb->NtfsInfo.BytesPerSector,
-                              (PVOID)Buffer,
-                              FALSE);
-    }
-    if (NT_SUCCESS(Status))
-    {
         Length -= ReadLength;
         Buffer += ReadLength;
+        Offset += ReadLength;
         AlreadyRead += ReadLength;
-
-        if (ReadLength == DataRunLength * Vcb->NtfsInfo.BytesPerCluster - (Offset - CurrentOffset))
-        {
-            CurrentOffset += DataRunLength * Vcb->NtfsInfo.BytesPerCluster;
-            DataRun = DecodeRun(DataRun, &DataRunOffset, &DataRunLength);
-            if (DataRunOffset != (ULONGLONG)-1)
-            {
-                DataRunStartLCN = LastLCN + DataRunOffset;
-                LastLCN = DataRunStartLCN;
-            }
-            else
-                DataRunStartLCN = -1;
-        }
-
-        while (Length > 0)
-        {
-            ReadLength = (ULONG)min(DataRunLength * Vcb->NtfsInfo.BytesPerCluster, Length);
-            if (DataRunStartLCN == -1)
-                RtlZeroMemory(Buffer, ReadLength);
-            else
-            {
-                Status = NtfsReadDisk(Vcb->StorageDevice,
-                                      DataRunStartLCN * Vcb->NtfsInfo.BytesPerCluster,
-                                      ReadLength,
-                                      Vcb->NtfsInfo.BytesPerSector,
-                                      (PVOID)Buffer,
-                                      FALSE);
-                if (!NT_SUCCESS(Status))
-                    break;
-            }
-
-            Length -= ReadLength;
-            Buffer += ReadLength;
-            AlreadyRead += ReadLength;
-
-            /* We finished this request, but there still data in this data run. */
-            if (Length == 0 && ReadLength != DataRunLength * Vcb->NtfsInfo.BytesPerCluster)
-                break;
-
-            /*
-             * Go to next run in the list.
-             */
-
-            if (*DataRun == 0)
-                break;
-            CurrentOffset += DataRunLength * Vcb->NtfsInfo.BytesPerCluster;
-            DataRun = DecodeRun(DataRun, &DataRunOffset, &DataRunLength);
-            if (DataRunOffset != -1)
-            {
-                /* Normal data run. */
-                DataRunStartLCN = LastLCN + DataRunOffset;
-                LastLCN = DataRunStartLCN;
-            }
-            else
-            {
-                /* Sparse data run. */
-                DataRunStartLCN = -1;
-            }
-        } /* while */
-
-    } /* if Disk */
-
-    // TEMPTEMP
-    if (Context->pRecord->IsNonResident)
-        ExFreePoolWithTag(TempBuffer, TAG_NTFS);
-
-    Context->CacheRun = DataRun;
-    Context->CacheRunOffset = Offset + AlreadyRead;
-    Context->CacheRunStartLCN = DataRunStartLCN;
-    Context->CacheRunLength = DataRunLength;
-    Context->CacheRunLastLCN = LastLCN;
-    Context->CacheRunCurrentOffset = CurrentOffset;
+    }
 
     return AlreadyRead;
 }
@@ -1627,15 +1769,194 @@ Cleanup:
     return Status;
 }
 
+/**
+* @name NtfsInitializeMftCache
+* @implemented
+*
+* Sets up the cache of recently used file records of a volume. Must be called once
+* NtfsInfo.BytesPerFileRecord is known, before the first call to ReadFileRecord().
+*
+* @param Vcb
+* Pointer to the device extension of the volume.
+*
+*/
+VOID
+NtfsInitializeMftCache(PDEVICE_EXTENSION Vcb)
+{
+    ExInitializeFastMutex(&Vcb->MftCache.Lock);
+    InitializeListHead(&Vcb->MftCache.LruListHead);
+    Vcb->MftCache.Count = 0;
+    Vcb->MftCache.Generation = 0;
+}
+
+/**
+* @name NtfsFreeMftCache
+* @implemented
+*
+* Frees all the file records held by the cache of a volume.
+*
+* @param Vcb
+* Pointer to the device extension of the volume.
+*
+*/
+VOID
+NtfsFreeMftCache(PDEVICE_EXTENSION Vcb)
+{
+    PNTFS_MFT_CACHE_ENTRY Entry;
+
+    ExAcquireFastMutex(&Vcb->MftCache.Lock);
+    while (!IsListEmpty(&Vcb->MftCache.LruListHead))
+    {
+        Entry = CONTAINING_RECORD(RemoveHeadList(&Vcb->MftCache.LruListHead), NTFS_MFT_CACHE_ENTRY, LruEntry);
+        ExFreePoolWithTag(Entry, TAG_MFT_CACHE);
+    }
+    Vcb->MftCache.Count = 0;
+    ExReleaseFastMutex(&Vcb->MftCache.Lock);
+}
+
+/* Called with the cache lock held */
+static
+PNTFS_MFT_CACHE_ENTRY
+FindMftCacheEntry(PDEVICE_EXTENSION Vcb,
+                  ULONGLONG MftIndex)
+{
+    PLIST_ENTRY ListEntry;
+    PNTFS_MFT_CACHE_ENTRY Entry;
+
+    for (ListEntry = Vcb->MftCache.LruListHead.Flink;
+         ListEntry != &Vcb->MftCache.LruListHead;
+         ListEntry = ListEntry->Flink)
+    {
+        Entry = CONTAINING_RECORD(ListEntry, NTFS_MFT_CACHE_ENTRY, LruEntry);
+        if (Entry->MftIndex == MftIndex)
+            return Entry;
+    }
+
+    return NULL;
+}
+
+/**
+* @name ReadFromMftCache
+* @implemented
+*
+* Copies a file record out of the cache, and makes it the most recently used one.
+*
+* @param Generation
+* On a miss, receives the generation of the cache, to be passed to UpdateMftCache()
+* once the record was read from disk.
+*
+* @return
+* TRUE if the record was in the cache, FALSE otherwise.
+*
+*/
+static
+BOOLEAN
+ReadFromMftCache(PDEVICE_EXTENSION Vcb,
+                 ULONGLONG MftIndex,
+                 PFILE_RECORD_HEADER FileRecord,
+                 PULONG Generation)
+{
+    PNTFS_MFT_CACHE_ENTRY Entry;
+
+    ExAcquireFastMutex(&Vcb->MftCache.Lock);
+
+    Entry = FindMftCacheEntry(Vcb, MftIndex);
+    if (Entry)
+    {
+        RemoveEntryList(&Entry->LruEntry);
+        InsertHeadList(&Vcb->MftCache.LruListHead, &Entry->LruEntry);
+        RtlCopyMemory(FileRecord, Entry->Record, Vcb->NtfsInfo.BytesPerFileRecord);
+    }
+    *Generation = Vcb->MftCache.Generation;
+
+    ExReleaseFastMutex(&Vcb->MftCache.Lock);
+    return (Entry != NULL);
+}
+
+/**
+* @name UpdateMftCache
+* @implemented
+*
+* Stores a copy of a file record, as it is on disk after fixups were applied, in the
+* cache of the volume. Once the cache is full, the least recently used record is
+* replaced. If FileRecord is NULL, the record is removed from the cache instead.
+*
+* @param ReadGeneration
+* For a record that was just read from disk, the generation ReadFromMftCache() returned.
+* If a file record was written since, what was read may already be stale and isn't
+* cached. NULL when called for a write.
+*
+*/
+static
+VOID
+UpdateMftCache(PDEVICE_EXTENSION Vcb,
+               ULONGLONG MftIndex,
+               PFILE_RECORD_HEADER FileRecord,
+               PULONG ReadGeneration)
+{
+    PNTFS_MFT_CACHE_ENTRY Entry, NewEntry = NULL;
+
+    // Allocate before taking the lock, we will usually need it
+    if (FileRecord)
+    {
+        NewEntry = ExAllocatePoolWithTag(NonPagedPool,
+                                         FIELD_OFFSET(NTFS_MFT_CACHE_ENTRY, Record[Vcb->NtfsInfo.BytesPerFileRecord]),
+                                         TAG_MFT_CACHE);
+    }
+
+    ExAcquireFastMutex(&Vcb->MftCache.Lock);
+
+    if (ReadGeneration && *ReadGeneration != Vcb->MftCache.Generation)
+    {
+        ExReleaseFastMutex(&Vcb->MftCache.Lock);
+        if (NewEntry)
+            ExFreePoolWithTag(NewEntry, TAG_MFT_CACHE);
+        return;
+    }
+
+    if (!ReadGeneration)
+        Vcb->MftCache.Generation++;
+
+    Entry = FindMftCacheEntry(Vcb, MftIndex);
+    if (Entry)
+    {
+        RemoveEntryList(&Entry->LruEntry);
+        Vcb->MftCache.Count--;
+    }
+    else if (NewEntry && Vcb->MftCache.Count >= NTFS_MFT_CACHE_RECORDS)
+    {
+        Entry = CONTAINING_RECORD(RemoveTailList(&Vcb->MftCache.LruListHead), NTFS_MFT_CACHE_ENTRY, LruEntry);
+        Vcb->MftCache.Count--;
+    }
+
+    if (NewEntry)
+    {
+        NewEntry->MftIndex = MftIndex;
+        RtlCopyMemory(NewEntry->Record, FileRecord, Vcb->NtfsInfo.BytesPerFileRecord);
+        InsertHeadList(&Vcb->MftCache.LruListHead, &NewEntry->LruEntry);
+        Vcb->MftCache.Count++;
+    }
+
+    ExReleaseFastMutex(&Vcb->MftCache.Lock);
+
+    if (Entry)
+        ExFreePoolWithTag(Entry, TAG_MFT_CACHE);
+}
+
 NTSTATUS
 ReadFileRecord(PDEVICE_EXTENSION Vcb,
                ULONGLONG index,
                PFILE_RECORD_HEADER file)
 {
     ULONGLONG BytesRead;
+    ULONG Generation;
+    NTSTATUS Status;
 
     DPRINT("ReadFileRecord(%p, %I64x, %p)\n", Vcb, index, file);
 
+    if (ReadFromMftCache(Vcb, index, file, &Generation))
+        return STATUS_SUCCESS;
+
     BytesRead = ReadAttribute(Vcb, Vcb->MFTContext, index * Vcb->NtfsInfo.BytesPerFileRecord, (PCHAR)file, Vcb->NtfsInfo.BytesPerFileRecord);
     if (BytesRead != Vcb->NtfsInfo.BytesPerFileRecord)
     {
@@ -1645,7 +1966,11 @@ ReadFileRecord(PDEVICE_EXTENSION Vcb,
 
     /* Apply update sequence array fixups. */
     DPRINT("Sequence number: %u\n", file->SequenceNumber);
-    return FixupUpdateSequenceArray(Vcb, &file->Ntfs);
+    Status = FixupUpdateSequenceArray(Vcb, &file->Ntfs);
+    if (NT_SUCCESS(Status))
+        UpdateMftCache(Vcb, index, file, &Generation);
+
+    return Status;
 }
 
 
@@ -1957,6 +2282,9 @@ UpdateFileRecord(PDEVICE_EXTENSION Vcb,
     // remove the fixup array (so the file record pointer can still be used)
     FixupUpdateSequenceArray(Vcb, &FileRecord->Ntfs);
 
+    // Keep the cached copy in line with the disk; if the write failed we don't know what's there
+    UpdateMftCache(Vcb, MftIndex, NT_SUCCESS(Status) ? FileRecord : NULL, NULL);
+
     return Status;
 }
 
@@ -15,6 +15,8 @@
 #define TAG_IRP_CTXT 'iftN'
 #define TAG_ATT_CTXT 'aftN'
 #define TAG_FILE_REC 'rftN'
+#define TAG_EXTENTS 'eftN'
+#define TAG_MFT_CACHE 'mftN'
 
 #define ROUND_UP(N, S) ((((N) + (S) - 1) / (S)) * (S))
 #define ROUND_DOWN(N, S) ((N) - ((N) % (S)))
@@ -96,6 +98,24 @@ typedef struct
     ULONG Size;
 } NTFSIDENTIFIER, *PNTFSIDENTIFIER;
 
+/* Most recently used file records, see ReadFileRecord() */
+#define NTFS_MFT_CACHE_RECORDS  64
+
+typedef struct _NTFS_MFT_CACHE_ENTRY
+{
+    LIST_ENTRY LruEntry;
+    ULONGLONG MftIndex;
+    UCHAR Record[ANYSIZE_ARRAY];
+} NTFS_MFT_CACHE_ENTRY, *PNTFS_MFT_CACHE_ENTRY;
+
+typedef struct _NTFS_MFT_CACHE
+{
+    FAST_MUTEX Lock;
+    LIST_ENTRY LruListHead;
+    ULONG Count;
+    ULONG Generation; /* Bumped by every UpdateFileRecord() */
+} NTFS_MFT_CACHE, *PNTFS_MFT_CACHE;
+
 typedef struct
 {
     NTFSIDENTIFIER Identifier;
@@ -117,6 +137,7 @@ typedef struct
     NTFS_INFO NtfsInfo;
 
     NPAGED_LOOKASIDE_LIST FileRecLookasideList;
+    NTFS_MFT_CACHE MftCache;
 
     ULONG MftDataOffset;
     ULONG Flags;
@@ -311,6 +332,9 @@ typedef struct
     USHORT Instance;
 } NTFS_ATTRIBUTE_LIST_ITEM, *PNTFS_ATTRIBUTE_LIST_ITEM;
 
+// NTFS_ATTR_RECORD.Flags
+#define ATTR_RECORD_FLAG_COMPRESSED 0x0001
+
 // The beginning and length of an attribute record are always aligned to an 8-byte boundary,
 // relative to the beginning of the file record.
 #define ATTR_RECORD_ALIGNMENT 8
@@ -487,6 +511,14 @@ typedef struct
     CCHAR PriorityBoost;
 } NTFS_IRP_CONTEXT, *PNTFS_IRP_CONTEXT;
 
+/* A stretch of clusters that is contiguous both in the attribute and on disk */
+typedef struct _NTFS_EXTENT
+{
+    ULONGLONG Vcn;
+    LONGLONG Lcn; /* -1 for sparse */
+    ULONGLONG Length;
+} NTFS_EXTENT, *PNTFS_EXTENT;
+
 typedef struct _NTFS_ATTR_CONTEXT
 {
     PUCHAR            CacheRun;
@@ -499,8 +531,27 @@ typedef struct _NTFS_ATTR_CONTEXT
     ULONGLONG           FileMFTIndex;
     ULONGLONG           FileOwnerMFTIndex; /* If attribute list attribute, reference the original file */
     PNTFS_ATTR_RECORD    pRecord;
+    FAST_MUTEX          ExtentLock;
+    ULONG               ExtentCount;
+    ULONG               ExtentCapacity;
+    PNTFS_EXTENT        Extents; /* Same runs as DataRunsMCB, sorted for ReadAttribute() */
 } NTFS_ATTR_CONTEXT, *PNTFS_ATTR_CONTEXT;
 
+/* Last compression units decompressed for a stream, see ReadCompressedAttribute() */
+#define NTFS_COMPRESSION_CACHE_UNITS    2
+
+/* The only compression unit NTFS uses (16 clusters), on volumes with clusters up to 4KB */
+#define NTFS_COMPRESSION_UNIT           4
+#define NTFS_MAX_COMPRESSED_CLUSTER     4096
+
+typedef struct _NTFS_COMPRESSION_CACHE
+{
+    FAST_MUTEX Lock;
+    ULONG Next;
+    ULONGLONG UnitVcn[NTFS_COMPRESSION_CACHE_UNITS];
+    PUCHAR Data[NTFS_COMPRESSION_CACHE_UNITS];
+} NTFS_COMPRESSION_CACHE, *PNTFS_COMPRESSION_CACHE;
+
 #define FCB_CACHE_INITIALIZED   0x0001
 #define FCB_IS_VOLUME_STREAM    0x0002
 #define FCB_IS_VOLUME           0x0004
@@ -537,6 +588,8 @@ typedef struct _FCB
 
     FILENAME_ATTRIBUTE Entry;
 
+    NTFS_COMPRESSION_CACHE CompressionCache;
+
 } NTFS_FCB, *PNTFS_FCB;
 
 typedef struct _FIND_ATTR_CONTXT
@@ -844,6 +897,24 @@ NTSTATUS
 NtfsClose(PNTFS_IRP_CONTEXT IrpContext);
 
 
+/* compress.c */
+
+NTSTATUS
+CheckCompressedAttribute(PDEVICE_EXTENSION Vcb,
+                         PNTFS_ATTR_RECORD AttrRecord);
+
+ULONG
+ReadCompressedAttribute(PDEVICE_EXTENSION Vcb,
+                        PNTFS_ATTR_CONTEXT Context,
+                        PNTFS_COMPRESSION_CACHE Cache,
+                        ULONGLONG Offset,
+                        PCHAR Buffer,
+                        ULONG Length);
+
+VOID
+NtfsFreeCompressionCache(PNTFS_COMPRESSION_CACHE Cache);
+
+
 /* create.c */
 
 NTSTATUS
@@ -1035,6 +1106,16 @@ PrepareAttributeContext(PNTFS_ATTR_RECORD AttrRecord);
 VOID
 ReleaseAttributeContext(PNTFS_ATTR_CONTEXT Context);
 
+NTSTATUS
+AddAttributeExtent(PNTFS_ATTR_CONTEXT Context,
+                   ULONGLONG Vcn,
+                   LONGLONG Lcn,
+                   ULONGLONG Length);
+
+VOID
+TruncateAttributeExtents(PNTFS_ATTR_CONTEXT Context,
+                         ULONGLONG Vcn);
+
 ULONG
 ReadAttribute(PDEVICE_EXTENSION Vcb,
               PNTFS_ATTR_CONTEXT Context,
@@ -1054,6 +1135,9 @@ WriteAttribute(PDEVICE_EXTENSION Vcb,
 ULONGLONG
 AttributeDataLength(PNTFS_ATTR_RECORD AttrRecord);
 
+BOOLEAN
+AttributeIsCompressed(PNTFS_ATTR_RECORD AttrRecord);
+
 NTSTATUS
 InternalSetResidentAttributeLength(PDEVICE_EXTENSION DeviceExt,
                                    PNTFS_ATTR_CONTEXT AttrContext,
@@ -1111,6 +1195,12 @@ ReadFileRecord(PDEVICE_EXTENSION Vcb,
                ULONGLONG index,
                PFILE_RECORD_HEADER file);
 
+VOID
+NtfsInitializeMftCache(PDEVICE_EXTENSION Vcb);
+
+VOID
+NtfsFreeMftCache(PDEVICE_EXTENSION Vcb);
+
 NTSTATUS
 UpdateIndexEntryFileNameSize(PDEVICE_EXTENSION Vcb,
                              PFILE_RECORD_HEADER MftRecord,
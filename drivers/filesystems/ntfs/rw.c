@@ -72,13 +72,6 @@ NtfsReadFile(PDEVICE_EXTENSION DeviceExt,
 
     Fcb = (PNTFS_FCB)FileObject->FsContext;
 
-    if (NtfsFCBIsCompressed(Fcb))
-    {
-        DPRINT1("Compressed file!\n");
-        UNIMPLEMENTED;
-        return STATUS_NOT_IMPLEMENTED;
-    }
-
     FileRecord = ExAllocateFromNPagedLookasideList(&DeviceExt->FileRecLookasideList);
     if (FileRecord == NULL)
     {
@@ -126,6 +119,17 @@ NtfsReadFile(PDEVICE_EXTENSION DeviceExt,
         return Status;
     }
 
+    if (AttributeIsCompressed(DataContext->pRecord))
+    {
+        Status = CheckCompressedAttribute(DeviceExt, DataContext->pRecord);
+        if (!NT_SUCCESS(Status))
+        {
+            ReleaseAttributeContext(DataContext);
+            ExFreeToNPagedLookasideList(&DeviceExt->FileRecLookasideList, FileRecord);
+            return Status;
+        }
+    }
+
     StreamSize = AttributeDataLength(DataContext->pRecord);
     if (ReadOffset >= StreamSize)
     {
@@ -142,7 +146,9 @@ NtfsReadFile(PDEVICE_EXTENSION DeviceExt,
     RealReadOffset = ReadOffset;
     RealLength = ToRead;
 
-    if ((ReadOffset % DeviceExt->NtfsInfo.BytesPerSector) != 0 || (ToRead % DeviceExt->NtfsInfo.BytesPerSector) != 0)
+    /* Compressed data gets copied out of decompressed units, no alignment needed */
+    if (!AttributeIsCompressed(DataContext->pRecord) &&
+        ((ReadOffset % DeviceExt->NtfsInfo.BytesPerSector) != 0 || (ToRead % DeviceExt->NtfsInfo.BytesPerSector) != 0))
     {
         RealReadOffset = ROUND_DOWN(ReadOffset, DeviceExt->NtfsInfo.BytesPerSector);
         RealLength = ROUND_UP(ToRead, DeviceExt->NtfsInfo.BytesPerSector);
@@ -166,7 +172,15 @@ NtfsReadFile(PDEVICE_EXTENSION DeviceExt,
     }
 
     DPRINT("Effective read: %lu at %lu for stream '%S'\n", RealLength, RealReadOffset, Fcb->Stream);
-    RealLengthRead = ReadAttribute(DeviceExt, DataContext, RealReadOffset, (PCHAR)ReadBuffer, RealLength);
+    if (AttributeIsCompressed(DataContext->pRecord))
+    {
+        RealLengthRead = ReadCompressedAttribute(DeviceExt, DataContext, &Fcb->CompressionCache,
+                                                 RealReadOffset, (PCHAR)ReadBuffer, RealLength);
+    }
+    else
+    {
+        RealLengthRead = ReadAttribute(DeviceExt, DataContext, RealReadOffset, (PCHAR)ReadBuffer, RealLength);
+    }
     if (RealLengthRead == 0)
     {
         DPRINT1("Read failure!\n");
@@ -90,6 +90,13 @@
 #define TAG_LINK (0xE | TAG_TYPE_LIST)
 #define TAG_DATA (0xF | TAG_TYPE_LIST)
 #define TAG_STRINGTABLE (0x801 | TAG_TYPE_LIST)
+#define TAG_INDEXES (0x802 | TAG_TYPE_LIST)
+#define TAG_INDEX (0x803 | TAG_TYPE_LIST)
+
+#define TAG_INDEX_TAG (0x802 | TAG_TYPE_WORD)
+#define TAG_INDEX_KEY (0x803 | TAG_TYPE_WORD)
+#define TAG_INDEX_FLAGS (0x16 | TAG_TYPE_DWORD)
+#define TAG_INDEX_BITS (0x801 | TAG_TYPE_BINARY)
 
 #define TAG_STRINGTABLE_ITEM (0x801 | TAG_TYPE_STRING)
 
@@ -143,6 +150,7 @@ static BOOL (WINAPI *pSdbWriteNULLTag)(PDB, TAG);
 static BOOL (WINAPI *pSdbWriteWORDTag)(PDB, TAG, WORD);
 static BOOL (WINAPI *pSdbWriteDWORDTag)(PDB, TAG, DWORD);
 static BOOL (WINAPI *pSdbWriteQWORDTag)(PDB, TAG, QWORD);
+static BOOL (WINAPI *pSdbWriteBinaryTag)(PDB, TAG, const BYTE*, DWORD);
 static BOOL (WINAPI *pSdbWriteBinaryTagFromFile)(PDB, TAG, LPCWSTR);
 static BOOL (WINAPI *pSdbWriteStringTag)(PDB, TAG, LPCWSTR);
 static BOOL (WINAPI *pSdbWriteStringRefTag)(PDB, TAG, TAGID);
@@ -1593,6 +1601,158 @@ static void test_MatchApplicationsEx(void)
 
 
 
+#define BENCH_EXE_COUNT     10000
+#define BENCH_ITERATIONS    200
+
+#include <pshpack1.h>
+typedef struct _BENCH_INDEX_ENTRY
+{
+    QWORD Key;
+    TAGID Tagid;
+} BENCH_INDEX_ENTRY;
+#include <poppack.h>
+
+static BENCH_INDEX_ENTRY g_BenchIndex[BENCH_EXE_COUNT];
+
+static int __cdecl bench_index_cmp(const void* lhs, const void* rhs)
+{
+    const BENCH_INDEX_ENTRY* a = (const BENCH_INDEX_ENTRY*)lhs;
+    const BENCH_INDEX_ENTRY* b = (const BENCH_INDEX_ENTRY*)rhs;
+    if (a->Key != b->Key)
+        return a->Key < b->Key ? -1 : 1;
+    return a->Tagid < b->Tagid ? -1 : (a->Tagid > b->Tagid);
+}
+
+/* A database with BENCH_EXE_COUNT exe entries, optionally followed by an exe name index */
+static BOOL write_bench_db(LPCWSTR path, BOOL bIndexed)
+{
+    TAGID tagdb, tagexe, tagindexes, tagindex;
+    WCHAR name[32];
+    DWORD n;
+    PDB pdb;
+
+    pdb = pSdbCreateDatabase(path, DOS_PATH);
+    ok(pdb != NULL, "failed to create database\n");
+    if (!pdb)
+        return FALSE;
+
+    tagdb = pSdbBeginWriteListTag(pdb, TAG_DATABASE);
+    pSdbWriteStringTag(pdb, TAG_NAME, L"apphelp_bench");
+    for (n = 0; n < BENCH_EXE_COUNT; ++n)
+    {
+        swprintf(name, L"x%05u.exe", n);
+        tagexe = pSdbBeginWriteListTag(pdb, TAG_EXE);
+        pSdbWriteStringTag(pdb, TAG_NAME, name);
+        pSdbWriteStringTag(pdb, TAG_APP_NAME, name);
+        pSdbEndWriteListTag(pdb, tagexe);
+
+        g_BenchIndex[n].Key = pSdbMakeIndexKeyFromString(name);
+        g_BenchIndex[n].Tagid = tagexe;
+    }
+    pSdbEndWriteListTag(pdb, tagdb);
+
+    if (bIndexed)
+    {
+        qsort(g_BenchIndex, BENCH_EXE_COUNT, sizeof(g_BenchIndex[0]), bench_index_cmp);
+
+        tagindexes = pSdbBeginWriteListTag(pdb, TAG_INDEXES);
+        tagindex = pSdbBeginWriteListTag(pdb, TAG_INDEX);
+        pSdbWriteWORDTag(pdb, TAG_INDEX_TAG, TAG_EXE);
+        pSdbWriteWORDTag(pdb, TAG_INDEX_KEY, TAG_NAME);
+        pSdbWriteDWORDTag(pdb, TAG_INDEX_FLAGS, 0);
+        pSdbWriteBinaryTag(pdb, TAG_INDEX_BITS, (const BYTE*)g_BenchIndex, sizeof(g_BenchIndex));
+        pSdbEndWriteListTag(pdb, tagindex);
+        pSdbEndWriteListTag(pdb, tagindexes);
+    }
+
+    pSdbCloseDatabaseWrite(pdb);
+    return TRUE;
+}
+
+static void bench_matching(const WCHAR* workdir, const WCHAR* dbpath, BOOL bIndexed)
+{
+    LARGE_INTEGER Frequency, Start, End;
+    SDBQUERYRESULT_VISTA query;
+    WCHAR exename[MAX_PATH], missname[MAX_PATH];
+    DWORD n, hits = 0, misses = 0;
+    DOUBLE HitSeconds, MissSeconds;
+    HSDB hsdb;
+
+    if (!write_bench_db(dbpath + 4, bIndexed))
+        return;
+
+    hsdb = pSdbInitDatabase(HID_DATABASE_FULLPATH, dbpath);
+    ok(hsdb != NULL, "Expected a valid database handle\n");
+    if (!hsdb)
+    {
+        DeleteFileW(dbpath + 4);
+        return;
+    }
+
+    /* The last entry is the worst case for a linear scan */
+    swprintf(exename, L"%s\\x%05u.exe", workdir, BENCH_EXE_COUNT - 1);
+    swprintf(missname, L"%s\\notindb.exe", workdir);
+    test_create_exe(exename, 0);
+
+    QueryPerformanceFrequency(&Frequency);
+
+    QueryPerformanceCounter(&Start);
+    for (n = 0; n < BENCH_ITERATIONS; ++n)
+    {
+        if (pSdbGetMatchingExe(hsdb, exename, NULL, NULL, 0, &query) && query.dwExeCount == 1)
+            hits++;
+    }
+    QueryPerformanceCounter(&End);
+    HitSeconds = (DOUBLE)(End.QuadPart - Start.QuadPart) / (DOUBLE)Frequency.QuadPart;
+
+    QueryPerformanceCounter(&Start);
+    for (n = 0; n < BENCH_ITERATIONS; ++n)
+    {
+        if (!pSdbGetMatchingExe(hsdb, missname, NULL, NULL, 0, &query) && query.dwExeCount == 0)
+            misses++;
+    }
+    QueryPerformanceCounter(&End);
+    MissSeconds = (DOUBLE)(End.QuadPart - Start.QuadPart) / (DOUBLE)Frequency.QuadPart;
+
+    if (!hits && g_WinVersion == _WIN32_WINNT_WS03)
+        skip("W2k3 does not find exes in this database layout\n");
+    else
+        ok_int(hits, BENCH_ITERATIONS);
+    ok_int(misses, BENCH_ITERATIONS);
+
+    trace("%s, %u exes: %.1f us per match, %.1f us per miss\n",
+          bIndexed ? "indexed" : "no index", BENCH_EXE_COUNT,
+          HitSeconds * 1e6 / BENCH_ITERATIONS, MissSeconds * 1e6 / BENCH_ITERATIONS);
+
+    pSdbReleaseDatabase(hsdb);
+    DeleteFileW(exename);
+    DeleteFileW(dbpath + 4);
+}
+
+/* Launch-time matching against a large database, with and without an exe name index */
+static void test_MatchBenchmark(void)
+{
+    WCHAR workdir[MAX_PATH], dbpath[MAX_PATH];
+    BOOL ret;
+
+    ret = GetTempPathW(_countof(workdir), workdir);
+    ok(ret, "GetTempPathW error: %d\n", GetLastError());
+    lstrcatW(workdir, L"apphelp_bench");
+
+    ret = CreateDirectoryW(workdir, NULL);
+    ok(ret, "CreateDirectoryW error: %d\n", GetLastError());
+
+    /* SdbInitDatabase needs an nt-path */
+    swprintf(dbpath, L"\\??\\%s\\bench.sdb", workdir);
+
+    bench_matching(workdir, dbpath, FALSE);
+    bench_matching(workdir, dbpath, TRUE);
+
+    ret = RemoveDirectoryW(workdir);
+    ok(ret, "RemoveDirectoryW error: %d\n", GetLastError());
+}
+
+
 static void test_TagRef(void)
 {
     WCHAR tmpdir[MAX_PATH], dbpath[MAX_PATH];
@@ -2107,6 +2267,7 @@ START_TEST(db)
     *(void**)&pSdbWriteWORDTag = (void *)GetProcAddress(hdll, "SdbWriteWORDTag");
     *(void**)&pSdbWriteDWORDTag = (void *)GetProcAddress(hdll, "SdbWriteDWORDTag");
     *(void**)&pSdbWriteQWORDTag = (void *)GetProcAddress(hdll, "SdbWriteQWORDTag");
+    *(void**)&pSdbWriteBinaryTag = (void *)GetProcAddress(hdll, "SdbWriteBinaryTag");
     *(void**)&pSdbWriteBinaryTagFromFile = (void *)GetProcAddress(hdll, "SdbWriteBinaryTagFromFile");
     *(void**)&pSdbWriteStringTag = (void *)GetProcAddress(hdll, "SdbWriteStringTag");
     *(void**)&pSdbWriteStringRefTag = (void *)GetProcAddress(hdll, "SdbWriteStringRefTag");
@@ -2160,6 +2321,7 @@ START_TEST(db)
     }
     test_TagRef();
     test_Data();
+    test_MatchBenchmark();
     skip("test_SecondaryDB()\n");
     test_IndexKeyFromString();
 }
@@ -0,0 +1,202 @@
+/*
+ * PROJECT:     ReactOS api tests
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Multi-threaded stress test and benchmark for GetTextExtentPoint32W and ExtTextOutW
+ */
+
+#include "precomp.h"
+
+#define STRESS_ITERATIONS   2000
+#define STRESS_MAX_THREADS  8
+
+static const WCHAR s_szText[] = L"The quick brown fox jumps over the lazy dog 0123456789";
+
+static const struct
+{
+    LPCWSTR pszFaceName;
+    LONG lfHeight;
+} s_Fonts[STRESS_MAX_THREADS] =
+{
+    { L"Tahoma", -11 },
+    { L"Tahoma", -11 },
+    { L"Tahoma", -16 },
+    { L"Arial", -13 },
+    { L"Courier New", -13 },
+    { L"Times New Roman", -20 },
+    { L"Tahoma", -11 },
+    { L"Arial", -24 },
+};
+
+typedef struct STRESS_THREAD
+{
+    HANDLE hThread;
+    HANDLE hStartEvent;
+    INT iFont;
+    SIZE sizeExpected;
+    LONG cMismatches;
+    LONG cFailures;
+} STRESS_THREAD, *PSTRESS_THREAD;
+
+static HFONT
+CreateStressFont(INT iFont)
+{
+    LOGFONTW lf;
+
+    ZeroMemory(&lf, sizeof(lf));
+    lf.lfHeight = s_Fonts[iFont].lfHeight;
+    lf.lfCharSet = DEFAULT_CHARSET;
+    StringCchCopyW(lf.lfFaceName, _countof(lf.lfFaceName), s_Fonts[iFont].pszFaceName);
+    return CreateFontIndirectW(&lf);
+}
+
+static HDC
+CreateStressDC(HBITMAP *phbm)
+{
+    BITMAPINFO bmi;
+    PVOID pvBits;
+    HDC hdc;
+
+    ZeroMemory(&bmi, sizeof(bmi));
+    bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+    bmi.bmiHeader.biWidth = 512;
+    bmi.bmiHeader.biHeight = -64;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    hdc = CreateCompatibleDC(NULL);
+    if (!hdc)
+        return NULL;
+
+    *phbm = CreateDIBSection(hdc, &bmi, DIB_RGB_COLORS, &pvBits, NULL, 0);
+    if (!*phbm)
+    {
+        DeleteDC(hdc);
+        return NULL;
+    }
+
+    SelectObject(hdc, *phbm);
+    return hdc;
+}
+
+static DWORD WINAPI
+StressThreadProc(LPVOID lpParameter)
+{
+    PSTRESS_THREAD pThread = lpParameter;
+    HBITMAP hbm;
+    HFONT hFont, hFontOld;
+    HDC hdc;
+    SIZE size;
+    RECT rc = { 0, 0, 512, 64 };
+    INT i;
+
+    hdc = CreateStressDC(&hbm);
+    if (!hdc)
+    {
+        pThread->cFailures++;
+        return 0;
+    }
+    hFont = CreateStressFont(pThread->iFont);
+    hFontOld = SelectObject(hdc, hFont);
+
+    WaitForSingleObject(pThread->hStartEvent, INFINITE);
+
+    for (i = 0; i < STRESS_ITERATIONS; ++i)
+    {
+        if (!GetTextExtentPoint32W(hdc, s_szText, lstrlenW(s_szText), &size))
+        {
+            pThread->cFailures++;
+            continue;
+        }
+
+        if (size.cx != pThread->sizeExpected.cx || size.cy != pThread->sizeExpected.cy)
+            pThread->cMismatches++;
+
+        if (!ExtTextOutW(hdc, 0, 0, ETO_OPAQUE, &rc, s_szText, lstrlenW(s_szText), NULL))
+            pThread->cFailures++;
+    }
+
+    SelectObject(hdc, hFontOld);
+    DeleteObject(hFont);
+    DeleteDC(hdc);
+    DeleteObject(hbm);
+    return 0;
+}
+
+static VOID
+RunStress(INT cThreads)
+{
+    STRESS_THREAD Threads[STRESS_MAX_THREADS];
+    HANDLE hThreads[STRESS_MAX_THREADS];
+    HANDLE hStartEvent;
+    LARGE_INTEGER Frequency, Start, End;
+    HBITMAP hbm;
+    HFONT hFont, hFontOld;
+    HDC hdc;
+    DOUBLE Seconds;
+    INT i;
+
+    QueryPerformanceFrequency(&Frequency);
+    hStartEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    ok(hStartEvent != NULL, "CreateEventW failed\n");
+    if (!hStartEvent)
+        return;
+
+    /* Measure the reference extents on this thread */
+    hdc = CreateStressDC(&hbm);
+    ok(hdc != NULL, "CreateStressDC failed\n");
+    if (!hdc)
+    {
+        CloseHandle(hStartEvent);
+        return;
+    }
+
+    ZeroMemory(Threads, sizeof(Threads));
+    for (i = 0; i < cThreads; ++i)
+    {
+        Threads[i].iFont = i;
+        Threads[i].hStartEvent = hStartEvent;
+
+        hFont = CreateStressFont(i);
+        hFontOld = SelectObject(hdc, hFont);
+        ok(GetTextExtentPoint32W(hdc, s_szText, lstrlenW(s_szText), &Threads[i].sizeExpected),
+           "GetTextExtentPoint32W failed\n");
+        SelectObject(hdc, hFontOld);
+        DeleteObject(hFont);
+    }
+    DeleteDC(hdc);
+    DeleteObject(hbm);
+
+    for (i = 0; i < cThreads; ++i)
+    {
+        Threads[i].hThread = CreateThread(NULL, 0, StressThreadProc, &Threads[i], 0, NULL);
+        ok(Threads[i].hThread != NULL, "CreateThread failed\n");
+        hThreads[i] = Threads[i].hThread;
+    }
+
+    QueryPerformanceCounter(&Start);
+    SetEvent(hStartEvent);
+    WaitForMultipleObjects(cThreads, hThreads, TRUE, INFINITE);
+    QueryPerformanceCounter(&End);
+
+    for (i = 0; i < cThreads; ++i)
+    {
+        ok_long(Threads[i].cFailures, 0);
+        ok_long(Threads[i].cMismatches, 0);
+        CloseHandle(Threads[i].hThread);
+    }
+    CloseHandle(hStartEvent);
+
+    Seconds = (DOUBLE)(End.QuadPart - Start.QuadPart) / (DOUBLE)Frequency.QuadPart;
+    trace("%d thread(s): %d calls in %.3f s, %.0f calls/s\n",
+          cThreads, cThreads * STRESS_ITERATIONS * 2, Seconds,
+          Seconds > 0 ? (cThreads * STRESS_ITERATIONS * 2) / Seconds : 0.0);
+}
+
+START_TEST(TextStress)
+{
+    RunStress(1);
+    RunStress(2);
+    RunStress(4);
+    RunStress(STRESS_MAX_THREADS);
+}
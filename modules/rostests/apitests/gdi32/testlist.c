@@ -75,6 +75,7 @@ extern void func_SetPixel(void);
 extern void func_SetSysColors(void);
 extern void func_SetWindowExtEx(void);
 extern void func_SetWorldTransform(void);
+extern void func_TextStress(void);
 extern void func_TextTransform(void);
 
 const struct test winetest_testlist[] =
@@ -151,6 +152,7 @@ const struct test winetest_testlist[] =
     { "SetSysColors", func_SetSysColors },
     { "SetWindowExtEx", func_SetWindowExtEx },
     { "SetWorldTransform", func_SetWorldTransform },
+    { "TextStress", func_TextStress },
     { "TextTransform", func_TextTransform },
 
     { 0, 0 }
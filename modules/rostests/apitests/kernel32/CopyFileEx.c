@@ -0,0 +1,259 @@
+/*
+ * PROJECT:     ReactOS api tests
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Tests for CopyFileExW
+ */
+
+#include "precomp.h"
+
+typedef struct _PROGRESS_DATA
+{
+    ULONG Calls;
+    DWORD FirstReason;
+    LONGLONG LastTransferred;
+    LONGLONG TotalSize;
+    BOOL Monotonic;
+    ULONG StopAt;
+    DWORD StopResult;
+    BOOL *pbCancel;
+} PROGRESS_DATA, *PPROGRESS_DATA;
+
+static WCHAR SourceName[MAX_PATH];
+static WCHAR DestName[MAX_PATH];
+
+static
+DWORD
+CALLBACK
+ProgressRoutine(
+    LARGE_INTEGER TotalFileSize,
+    LARGE_INTEGER TotalBytesTransferred,
+    LARGE_INTEGER StreamSize,
+    LARGE_INTEGER StreamBytesTransferred,
+    DWORD dwStreamNumber,
+    DWORD dwCallbackReason,
+    HANDLE hSourceFile,
+    HANDLE hDestinationFile,
+    LPVOID lpData)
+{
+    PPROGRESS_DATA Data = lpData;
+
+    if (Data->Calls == 0)
+        Data->FirstReason = dwCallbackReason;
+    else if (dwCallbackReason != CALLBACK_CHUNK_FINISHED)
+        Data->Monotonic = FALSE;
+
+    if (TotalBytesTransferred.QuadPart < Data->LastTransferred)
+        Data->Monotonic = FALSE;
+    Data->LastTransferred = TotalBytesTransferred.QuadPart;
+    Data->TotalSize = TotalFileSize.QuadPart;
+
+    if (++Data->Calls == Data->StopAt)
+    {
+        if (Data->pbCancel)
+        {
+            *Data->pbCancel = TRUE;
+            return PROGRESS_CONTINUE;
+        }
+        return Data->StopResult;
+    }
+
+    return PROGRESS_CONTINUE;
+}
+
+static
+BOOL
+CreateSourceFile(ULONG Size)
+{
+    HANDLE hFile;
+    PULONG Buffer;
+    ULONG i;
+    DWORD Written;
+    BOOL Ret;
+
+    Buffer = HeapAlloc(GetProcessHeap(), 0, Size + sizeof(ULONG));
+    if (!Buffer)
+        return FALSE;
+    for (i = 0; i <= Size / sizeof(ULONG); i++)
+        Buffer[i] = i * 2654435761U;
+
+    hFile = CreateFileW(SourceName, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        HeapFree(GetProcessHeap(), 0, Buffer);
+        return FALSE;
+    }
+
+    Ret = WriteFile(hFile, Buffer, Size, &Written, NULL) && Written == Size;
+    CloseHandle(hFile);
+    HeapFree(GetProcessHeap(), 0, Buffer);
+    return Ret;
+}
+
+static
+BOOL
+CompareFiles(ULONG Size)
+{
+    HANDLE hSource, hDest;
+    PUCHAR Buffer1, Buffer2;
+    DWORD Read1, Read2;
+    BOOL Same = FALSE;
+
+    hSource = CreateFileW(SourceName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+    hDest = CreateFileW(DestName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+    Buffer1 = HeapAlloc(GetProcessHeap(), 0, Size + 1);
+    Buffer2 = HeapAlloc(GetProcessHeap(), 0, Size + 1);
+
+    if (hSource != INVALID_HANDLE_VALUE && hDest != INVALID_HANDLE_VALUE && Buffer1 && Buffer2 &&
+        GetFileSize(hDest, NULL) == Size &&
+        ReadFile(hSource, Buffer1, Size + 1, &Read1, NULL) &&
+        ReadFile(hDest, Buffer2, Size + 1, &Read2, NULL))
+    {
+        Same = (Read1 == Size && Read2 == Size && !memcmp(Buffer1, Buffer2, Size));
+    }
+
+    if (Buffer2) HeapFree(GetProcessHeap(), 0, Buffer2);
+    if (Buffer1) HeapFree(GetProcessHeap(), 0, Buffer1);
+    if (hDest != INVALID_HANDLE_VALUE) CloseHandle(hDest);
+    if (hSource != INVALID_HANDLE_VALUE) CloseHandle(hSource);
+    return Same;
+}
+
+static
+void
+Test_Sizes(void)
+{
+    static const ULONG Sizes[] = { 0, 1, 511, 4095, 4096, 65535, 65536, 65537,
+                                   3 * 65536, 1024 * 1024 + 123, 4 * 1024 * 1024 };
+    PROGRESS_DATA Data;
+    ULONG i;
+    BOOL Ret;
+
+    for (i = 0; i < _countof(Sizes); i++)
+    {
+        if (!CreateSourceFile(Sizes[i]))
+        {
+            skip("Cannot create a %lu bytes file\n", Sizes[i]);
+            continue;
+        }
+
+        ZeroMemory(&Data, sizeof(Data));
+        Data.Monotonic = TRUE;
+        Ret = CopyFileExW(SourceName, DestName, ProgressRoutine, &Data, NULL, 0);
+        ok(Ret == TRUE, "Copy of %lu bytes failed with %lu\n", Sizes[i], GetLastError());
+        ok(CompareFiles(Sizes[i]), "Copy of %lu bytes differs\n", Sizes[i]);
+        ok(Data.Calls >= 2, "%lu progress calls for %lu bytes\n", Data.Calls, Sizes[i]);
+        ok(Data.FirstReason == CALLBACK_STREAM_SWITCH, "First reason %lu\n", Data.FirstReason);
+        ok(Data.Monotonic, "Progress went back for %lu bytes\n", Sizes[i]);
+        ok(Data.LastTransferred == Sizes[i], "Last progress %I64d for %lu bytes\n", Data.LastTransferred, Sizes[i]);
+        ok(Data.TotalSize == Sizes[i], "Total size %I64d for %lu bytes\n", Data.TotalSize, Sizes[i]);
+        DeleteFileW(DestName);
+    }
+}
+
+static
+void
+Test_Cancel(void)
+{
+    PROGRESS_DATA Data;
+    BOOL Cancel;
+    BOOL Ret;
+
+    if (!CreateSourceFile(8 * 1024 * 1024))
+    {
+        skip("Cannot create the source file\n");
+        return;
+    }
+
+    /* Cancel from the progress routine deletes the destination */
+    ZeroMemory(&Data, sizeof(Data));
+    Data.StopAt = 2;
+    Data.StopResult = PROGRESS_CANCEL;
+    SetLastError(0xdeadbeef);
+    Ret = CopyFileExW(SourceName, DestName, ProgressRoutine, &Data, NULL, 0);
+    ok(Ret == FALSE, "Copy succeeded\n");
+    ok(GetLastError() == ERROR_REQUEST_ABORTED, "Error %lu\n", GetLastError());
+    ok(Data.Calls == 2, "%lu progress calls\n", Data.Calls);
+    ok(GetFileAttributesW(DestName) == INVALID_FILE_ATTRIBUTES, "Destination kept\n");
+
+    /* Stop keeps what was copied */
+    ZeroMemory(&Data, sizeof(Data));
+    Data.StopAt = 2;
+    Data.StopResult = PROGRESS_STOP;
+    SetLastError(0xdeadbeef);
+    Ret = CopyFileExW(SourceName, DestName, ProgressRoutine, &Data, NULL, 0);
+    ok(Ret == FALSE, "Copy succeeded\n");
+    ok(GetLastError() == ERROR_REQUEST_ABORTED, "Error %lu\n", GetLastError());
+    ok(GetFileAttributesW(DestName) != INVALID_FILE_ATTRIBUTES, "Destination deleted\n");
+    DeleteFileW(DestName);
+
+    /* And so does the cancel flag */
+    ZeroMemory(&Data, sizeof(Data));
+    Cancel = FALSE;
+    Data.StopAt = 2;
+    Data.pbCancel = &Cancel;
+    SetLastError(0xdeadbeef);
+    Ret = CopyFileExW(SourceName, DestName, ProgressRoutine, &Data, &Cancel, 0);
+    ok(Ret == FALSE, "Copy succeeded\n");
+    ok(GetLastError() == ERROR_REQUEST_ABORTED, "Error %lu\n", GetLastError());
+    ok(GetFileAttributesW(DestName) == INVALID_FILE_ATTRIBUTES, "Destination kept\n");
+    DeleteFileW(DestName);
+}
+
+static
+void
+Test_Speed(void)
+{
+    ULONG Size = 32 * 1024 * 1024;
+    ULONG i, Start, Large, Small;
+    BOOL Ret;
+
+    if (!CreateSourceFile(Size))
+    {
+        skip("Cannot create the source file\n");
+        return;
+    }
+
+    Start = GetTickCount();
+    Ret = CopyFileExW(SourceName, DestName, NULL, NULL, NULL, 0);
+    Large = GetTickCount() - Start;
+    ok(Ret == TRUE, "Copy failed with %lu\n", GetLastError());
+    DeleteFileW(DestName);
+
+    if (!CreateSourceFile(2000))
+    {
+        skip("Cannot create the source file\n");
+        return;
+    }
+
+    Start = GetTickCount();
+    for (i = 0; i < 200; i++)
+    {
+        Ret = CopyFileExW(SourceName, DestName, NULL, NULL, NULL, 0);
+        ok(Ret == TRUE, "Copy failed with %lu\n", GetLastError());
+        DeleteFileW(DestName);
+    }
+    Small = GetTickCount() - Start;
+
+    trace("Copied %lu MB in %lu ms, 200 small files in %lu ms\n", Size / (1024 * 1024), Large, Small);
+}
+
+START_TEST(CopyFileEx)
+{
+    WCHAR TempPath[MAX_PATH];
+
+    if (!GetTempPathW(_countof(TempPath), TempPath) ||
+        !GetTempFileNameW(TempPath, L"cfs", 0, SourceName) ||
+        !GetTempFileNameW(TempPath, L"cfd", 0, DestName))
+    {
+        skip("No temporary files\n");
+        return;
+    }
+    DeleteFileW(DestName);
+
+    Test_Sizes();
+    Test_Cancel();
+    Test_Speed();
+
+    DeleteFileW(DestName);
+    DeleteFileW(SourceName);
+}
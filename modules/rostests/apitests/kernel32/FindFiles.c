@@ -479,6 +479,119 @@ static void Test_FindFirstFileW(void)
 }
 
 
+#define LARGE_DIR_FILES 1500
+
+static BOOL LargeDirFile(LPCWSTR pszDir, UINT Number, LPCWSTR pszKind, LPWSTR pszPath)
+{
+    return SUCCEEDED(StringCchPrintfW(pszPath, MAX_PATH, L"%s\\%s file number %04u.txt",
+                                      pszDir, pszKind, Number));
+}
+
+/*
+ * Large directories get their entries indexed by the file system,
+ * make sure that lookups stay right while entries come and go.
+ */
+static void Test_LargeDirectory(void)
+{
+    WCHAR szDir[MAX_PATH], szPath[MAX_PATH], szNewPath[MAX_PATH];
+    WIN32_FIND_DATAW fd;
+    HANDLE h;
+    UINT i, Missing;
+
+    GetTempPathW(_countof(szDir), szDir);
+    StringCchCatW(szDir, _countof(szDir), L"FindFilesLargeDir");
+    if (!CreateDirectoryW(szDir, NULL))
+    {
+        skip("Cannot create '%S', error %lu\n", szDir, GetLastError());
+        return;
+    }
+
+    for (i = 0; i < LARGE_DIR_FILES; i++)
+    {
+        LargeDirFile(szDir, i, L"Some", szPath);
+        h = CreateFileW(szPath, GENERIC_WRITE, 0, NULL, CREATE_NEW, 0, NULL);
+        if (h == INVALID_HANDLE_VALUE)
+        {
+            ok(FALSE, "Cannot create '%S', error %lu\n", szPath, GetLastError());
+            break;
+        }
+        CloseHandle(h);
+    }
+
+    /* Look them up backwards, in another case */
+    for (Missing = 0, i = LARGE_DIR_FILES; i-- > 0;)
+    {
+        LargeDirFile(szDir, i, L"SOME", szPath);
+        if (GetFileAttributesW(szPath) == INVALID_FILE_ATTRIBUTES)
+            Missing++;
+    }
+    ok_int(Missing, 0);
+
+    /* Find one by its short name */
+    LargeDirFile(szDir, LARGE_DIR_FILES / 2, L"Some", szPath);
+    h = FindFirstFileW(szPath, &fd);
+    ok(h != INVALID_HANDLE_VALUE, "FindFirstFileW failed with %lu\n", GetLastError());
+    if (h != INVALID_HANDLE_VALUE)
+    {
+        FindClose(h);
+        if (fd.cAlternateFileName[0] != 0)
+        {
+            StringCchPrintfW(szNewPath, _countof(szNewPath), L"%s\\%s", szDir, fd.cAlternateFileName);
+            ok(GetFileAttributesW(szNewPath) != INVALID_FILE_ATTRIBUTES, "'%S' not found\n", szNewPath);
+        }
+    }
+
+    /* Delete a third of them, rename another third */
+    for (i = 0; i < LARGE_DIR_FILES; i++)
+    {
+        LargeDirFile(szDir, i, L"Some", szPath);
+        if (i % 3 == 0)
+        {
+            ok(DeleteFileW(szPath), "Cannot delete '%S', error %lu\n", szPath, GetLastError());
+        }
+        else if (i % 3 == 1)
+        {
+            LargeDirFile(szDir, i, L"Other", szNewPath);
+            ok(MoveFileW(szPath, szNewPath), "Cannot rename '%S', error %lu\n", szPath, GetLastError());
+        }
+    }
+
+    /* Some new ones, that can go where the deleted ones were */
+    for (i = 0; i < LARGE_DIR_FILES / 3; i++)
+    {
+        LargeDirFile(szDir, i, L"New", szPath);
+        h = CreateFileW(szPath, GENERIC_WRITE, 0, NULL, CREATE_NEW, 0, NULL);
+        ok(h != INVALID_HANDLE_VALUE, "Cannot create '%S', error %lu\n", szPath, GetLastError());
+        CloseHandle(h);
+    }
+
+    for (Missing = 0, i = 0; i < LARGE_DIR_FILES; i++)
+    {
+        LargeDirFile(szDir, i, L"Some", szPath);
+        if ((GetFileAttributesW(szPath) == INVALID_FILE_ATTRIBUTES) != (i % 3 != 2))
+            Missing++;
+        LargeDirFile(szDir, i, L"Other", szPath);
+        if ((GetFileAttributesW(szPath) == INVALID_FILE_ATTRIBUTES) != (i % 3 != 1))
+            Missing++;
+        LargeDirFile(szDir, i, L"New", szPath);
+        if ((GetFileAttributesW(szPath) == INVALID_FILE_ATTRIBUTES) != (i >= LARGE_DIR_FILES / 3))
+            Missing++;
+    }
+    ok_int(Missing, 0);
+
+    /* Clean up */
+    for (i = 0; i < LARGE_DIR_FILES; i++)
+    {
+        LargeDirFile(szDir, i, L"Some", szPath);
+        DeleteFileW(szPath);
+        LargeDirFile(szDir, i, L"Other", szPath);
+        DeleteFileW(szPath);
+        LargeDirFile(szDir, i, L"New", szPath);
+        DeleteFileW(szPath);
+    }
+    ok(RemoveDirectoryW(szDir), "Cannot remove '%S', error %lu\n", szDir, GetLastError());
+}
+
 static int init(void)
 {
     LPSTR p;
@@ -525,4 +638,5 @@ START_TEST(FindFiles)
 
     Test_FindFirstFileA();
     Test_FindFirstFileW();
+    Test_LargeDirectory();
 }
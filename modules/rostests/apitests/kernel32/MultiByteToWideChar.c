@@ -294,6 +294,138 @@ static void TestEntry(const ENTRY *pEntry)
     }
 }
 
+/* Characters that break up the ASCII runs, per code page */
+typedef struct RUN_PIECE
+{
+    UINT CodePage;
+    const char *MultiByte;
+    const WCHAR *Wide;
+} RUN_PIECE;
+
+static const RUN_PIECE RunPieces[] =
+{
+    { CP_UTF8, "\xC3\xA9", L"\x00E9" },
+    { CP_UTF8, "\xE6\x97\xA5", L"\x65E5" },
+    { 1252, "\xE9", L"\x00E9" },
+    { 1252, "\x80", L"\x20AC" },
+    { CP932, "\x93\xFA", L"\x65E5" },
+    { CP932, "\xB1", L"\xFF71" },
+};
+
+#define RUN_LENGTH  600
+
+static ULONG RunSeed = 12345;
+
+static
+ULONG
+RunRandom(ULONG Range)
+{
+    RunSeed = RunSeed * 1103515245 + 12345;
+    return (RunSeed >> 16) % Range;
+}
+
+/* ASCII runs of all lengths at all alignments, between other characters */
+static
+void
+TestRuns(UINT CodePage)
+{
+    char Src[RUN_LENGTH + 8];
+    WCHAR Expected[RUN_LENGTH + 8], Dest[RUN_LENGTH + 8];
+    int SrcLen, ExpectedLen, Ret, Fails = 0;
+    const RUN_PIECE *Piece;
+    ULONG Test, Run, Pieces[8], PieceCount = 0;
+    size_t i;
+
+    for (i = 0; i < _countof(RunPieces); i++)
+    {
+        if (RunPieces[i].CodePage == CodePage)
+            Pieces[PieceCount++] = (ULONG)i;
+    }
+
+    for (Test = 0; Test < 2000 && Fails < 10; Test++)
+    {
+        SrcLen = ExpectedLen = 0;
+        while (SrcLen < RUN_LENGTH - 40)
+        {
+            Run = RunRandom((Test & 1) ? 40 : 4);
+            while (Run--)
+            {
+                Src[SrcLen] = (char)(0x20 + RunRandom(0x5F));
+                Expected[ExpectedLen++] = (UCHAR)Src[SrcLen++];
+            }
+
+            Piece = &RunPieces[Pieces[RunRandom(PieceCount)]];
+            memcpy(&Src[SrcLen], Piece->MultiByte, strlen(Piece->MultiByte));
+            SrcLen += (int)strlen(Piece->MultiByte);
+            memcpy(&Expected[ExpectedLen], Piece->Wide, wcslen(Piece->Wide) * sizeof(WCHAR));
+            ExpectedLen += (int)wcslen(Piece->Wide);
+        }
+
+        Ret = MultiByteToWideChar(CodePage, 0, Src, SrcLen, NULL, 0);
+        if (Ret != ExpectedLen)
+        {
+            ok(FALSE, "CP %u, test %lu: counted %d characters, expected %d\n", CodePage, Test, Ret, ExpectedLen);
+            Fails++;
+            continue;
+        }
+
+        Ret = MultiByteToWideChar(CodePage, 0, Src, SrcLen, Dest, _countof(Dest));
+        if (Ret != ExpectedLen || memcmp(Dest, Expected, ExpectedLen * sizeof(WCHAR)))
+        {
+            ok(FALSE, "CP %u, test %lu: converted %d characters, expected %d\n", CodePage, Test, Ret, ExpectedLen);
+            Fails++;
+            continue;
+        }
+
+        /* A short buffer is filled up to its end */
+        memset(Dest, 0x7F, sizeof(Dest));
+        Ret = MultiByteToWideChar(CodePage, 0, Src, SrcLen, Dest, ExpectedLen / 2);
+        if (Ret != 0 || memcmp(Dest, Expected, (ExpectedLen / 2) * sizeof(WCHAR)) ||
+            Dest[ExpectedLen / 2] != 0x7F7F)
+        {
+            ok(FALSE, "CP %u, test %lu: short buffer conversion returned %d\n", CodePage, Test, Ret);
+            Fails++;
+        }
+    }
+
+    ok(Fails == 0, "CP %u: %d failures\n", CodePage, Fails);
+}
+
+static
+void
+TestThroughput(UINT CodePage, const char *Name, const char *Sample)
+{
+    char *Src;
+    WCHAR *Dest;
+    int SrcLen, SampleLen, Ret = 0;
+    ULONG i, Start, Elapsed;
+
+    SampleLen = (int)strlen(Sample);
+    SrcLen = (1024 * 1024 / SampleLen) * SampleLen;
+    Src = HeapAlloc(GetProcessHeap(), 0, SrcLen);
+    Dest = HeapAlloc(GetProcessHeap(), 0, SrcLen * sizeof(WCHAR));
+    if (!Src || !Dest)
+    {
+        skip("Out of memory\n");
+        goto Cleanup;
+    }
+
+    for (i = 0; i < (ULONG)SrcLen; i += SampleLen)
+        memcpy(&Src[i], Sample, SampleLen);
+
+    Start = GetTickCount();
+    for (i = 0; i < 20; i++)
+        Ret = MultiByteToWideChar(CodePage, 0, Src, SrcLen, Dest, SrcLen);
+    Elapsed = GetTickCount() - Start;
+
+    ok(Ret > 0, "CP %u: conversion failed with %lu\n", CodePage, GetLastError());
+    trace("CP %u, %s: 20 MB in %lu ms\n", CodePage, Name, Elapsed);
+
+Cleanup:
+    if (Dest) HeapFree(GetProcessHeap(), 0, Dest);
+    if (Src) HeapFree(GetProcessHeap(), 0, Src);
+}
+
 START_TEST(MultiByteToWideChar)
 {
     RTL_OSVERSIONINFOW vi;
@@ -312,4 +444,22 @@ START_TEST(MultiByteToWideChar)
     {
         TestEntry(&Entries[i]);
     }
+
+    TestRuns(CP_UTF8);
+    TestRuns(1252);
+    if (IsValidCodePage(CP932))
+        TestRuns(CP932);
+    else
+        skip("Code page 932 is not installed\n");
+
+    TestThroughput(CP_UTF8, "ASCII", "The quick brown fox jumps over the lazy dog. ");
+    TestThroughput(CP_UTF8, "Latin-1", "Le c\xC5\x93ur d\xC3\xA9\xC3\xA7u \xC3\xA0 l'\xC3\xA9t\xC3\xA9. ");
+    TestThroughput(CP_UTF8, "CJK", UTF8_Japanese);
+    TestThroughput(1252, "ASCII", "The quick brown fox jumps over the lazy dog. ");
+    TestThroughput(1252, "Latin-1", "Le c\x9Cur d\xE9\xE7u \xE0 l'\xE9t\xE9. ");
+    if (IsValidCodePage(CP932))
+    {
+        TestThroughput(CP932, "ASCII", "The quick brown fox jumps over the lazy dog. ");
+        TestThroughput(CP932, "CJK", SJIS_Japanese);
+    }
 }
@@ -167,7 +167,151 @@ TestUtf8(VOID)
     Utf8Convert(L"\x0063\x0301\x0327", "\x63\xcc\x81\xcc\xa7", FALSE);
 }
 
+/* Characters that break up the ASCII runs, per code page */
+typedef struct RUN_PIECE
+{
+    UINT CodePage;
+    const WCHAR *Wide;
+    const char *MultiByte;
+} RUN_PIECE;
+
+static const RUN_PIECE RunPieces[] =
+{
+    { CP_UTF8, L"\x00e9", "\xc3\xa9" },
+    { CP_UTF8, L"\x65e5", "\xe6\x97\xa5" },
+    { CP_UTF8, L"\xd83d\xde00", "\xf0\x9f\x98\x80" },
+    { 1252, L"\x00e9", "\xe9" },
+    { 1252, L"\x20ac", "\x80" },
+    { 932, L"\x65e5", "\x93\xfa" },
+    { 932, L"\xff71", "\xb1" },
+};
+
+#define RUN_LENGTH  600
+
+static ULONG RunSeed = 12345;
+
+static
+ULONG
+RunRandom(ULONG Range)
+{
+    RunSeed = RunSeed * 1103515245 + 12345;
+    return (RunSeed >> 16) % Range;
+}
+
+/* ASCII runs of all lengths at all alignments, between other characters */
+static
+VOID
+TestRuns(
+    _In_ UINT CodePage)
+{
+    WCHAR Src[RUN_LENGTH + 8];
+    char Expected[RUN_LENGTH + 8], Dest[RUN_LENGTH + 8];
+    int SrcLen, ExpectedLen, Ret, Fails = 0;
+    const RUN_PIECE *Piece;
+    ULONG Test, Run, Pieces[8], PieceCount = 0;
+    ULONG i;
+
+    for (i = 0; i < RTL_NUMBER_OF(RunPieces); i++)
+    {
+        if (RunPieces[i].CodePage == CodePage)
+            Pieces[PieceCount++] = i;
+    }
+
+    for (Test = 0; Test < 2000 && Fails < 10; Test++)
+    {
+        SrcLen = ExpectedLen = 0;
+        while (ExpectedLen < RUN_LENGTH - 40)
+        {
+            Run = RunRandom((Test & 1) ? 40 : 4);
+            while (Run--)
+            {
+                Expected[ExpectedLen] = (char)(0x20 + RunRandom(0x5f));
+                Src[SrcLen++] = Expected[ExpectedLen++];
+            }
+
+            Piece = &RunPieces[Pieces[RunRandom(PieceCount)]];
+            memcpy(&Src[SrcLen], Piece->Wide, wcslen(Piece->Wide) * sizeof(WCHAR));
+            SrcLen += (int)wcslen(Piece->Wide);
+            memcpy(&Expected[ExpectedLen], Piece->MultiByte, strlen(Piece->MultiByte));
+            ExpectedLen += (int)strlen(Piece->MultiByte);
+        }
+
+        Ret = WideCharToMultiByte(CodePage, 0, Src, SrcLen, NULL, 0, NULL, NULL);
+        if (Ret != ExpectedLen)
+        {
+            ok(FALSE, "CP %u, test %lu: counted %d bytes, expected %d\n", CodePage, Test, Ret, ExpectedLen);
+            Fails++;
+            continue;
+        }
+
+        Ret = WideCharToMultiByte(CodePage, 0, Src, SrcLen, Dest, sizeof(Dest), NULL, NULL);
+        if (Ret != ExpectedLen || memcmp(Dest, Expected, ExpectedLen))
+        {
+            ok(FALSE, "CP %u, test %lu: converted %d bytes, expected %d\n", CodePage, Test, Ret, ExpectedLen);
+            Fails++;
+        }
+    }
+
+    ok(Fails == 0, "CP %u: %d failures\n", CodePage, Fails);
+}
+
+static
+VOID
+TestThroughput(
+    _In_ UINT CodePage,
+    _In_ PCSTR Name,
+    _In_ PCWSTR Sample)
+{
+    PWSTR Src;
+    PSTR Dest;
+    int SrcLen, SampleLen, Ret = 0;
+    ULONG i, Start, Elapsed;
+
+    SampleLen = (int)wcslen(Sample);
+    SrcLen = (1024 * 1024 / SampleLen) * SampleLen;
+    Src = HeapAlloc(GetProcessHeap(), 0, SrcLen * sizeof(WCHAR));
+    Dest = HeapAlloc(GetProcessHeap(), 0, SrcLen * 4);
+    if (!Src || !Dest)
+    {
+        skip("Out of memory\n");
+        goto Cleanup;
+    }
+
+    for (i = 0; i < (ULONG)SrcLen; i += SampleLen)
+        memcpy(&Src[i], Sample, SampleLen * sizeof(WCHAR));
+
+    Start = GetTickCount();
+    for (i = 0; i < 20; i++)
+        Ret = WideCharToMultiByte(CodePage, 0, Src, SrcLen, Dest, SrcLen * 4, NULL, NULL);
+    Elapsed = GetTickCount() - Start;
+
+    ok(Ret > 0, "CP %u: conversion failed with %lu\n", CodePage, GetLastError());
+    trace("CP %u, %s: 20M characters in %lu ms\n", CodePage, Name, Elapsed);
+
+Cleanup:
+    if (Dest) HeapFree(GetProcessHeap(), 0, Dest);
+    if (Src) HeapFree(GetProcessHeap(), 0, Src);
+}
+
 START_TEST(WideCharToMultiByte)
 {
     TestUtf8();
+
+    TestRuns(CP_UTF8);
+    TestRuns(1252);
+    if (IsValidCodePage(932))
+        TestRuns(932);
+    else
+        skip("Code page 932 is not installed\n");
+
+    TestThroughput(CP_UTF8, "ASCII", L"The quick brown fox jumps over the lazy dog. ");
+    TestThroughput(CP_UTF8, "Latin-1", L"Le c\x0153ur d\x00e9\x00e7u \x00e0 l'\x00e9t\x00e9. ");
+    TestThroughput(CP_UTF8, "CJK", L"\x65e5\x672c\x8a9e");
+    TestThroughput(1252, "ASCII", L"The quick brown fox jumps over the lazy dog. ");
+    TestThroughput(1252, "Latin-1", L"Le c\x0153ur d\x00e9\x00e7u \x00e0 l'\x00e9t\x00e9. ");
+    if (IsValidCodePage(932))
+    {
+        TestThroughput(932, "ASCII", L"The quick brown fox jumps over the lazy dog. ");
+        TestThroughput(932, "CJK", L"\x65e5\x672c\x8a9e");
+    }
 }
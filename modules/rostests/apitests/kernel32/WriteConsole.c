@@ -0,0 +1,179 @@
+/*
+ * PROJECT:     ReactOS api tests
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Tests for WriteConsoleW, and how fast its output shows up
+ */
+
+#include "precomp.h"
+
+#define LINE_COUNT  20000
+
+static
+void
+FormatLine(PWCHAR Line, SIZE_T cchLine, ULONG Number)
+{
+    /* Some colour changes, like compiler output, and some lines that wrap */
+    StringCchPrintfW(Line, cchLine,
+                     (Number % 7 != 3) ? L"line %05lu: the quick brown fox jumps over the lazy dog\r\n"
+                                       : L"line %05lu: the quick brown fox jumps over the lazy dog "
+                                         L"and keeps on running until the end of the line and beyond it\r\n",
+                     Number);
+}
+
+static
+void
+Test_Flood(HANDLE hConOut)
+{
+    CONSOLE_SCREEN_BUFFER_INFO csbi;
+    WCHAR Line[160], Read[160];
+    COORD Coord;
+    DWORD Written, Length;
+    ULONG i, Start, Elapsed;
+    BOOL Ret;
+
+    Start = GetTickCount();
+    for (i = 0; i < LINE_COUNT; i++)
+    {
+        if ((i % 16) == 0)
+            SetConsoleTextAttribute(hConOut, (WORD)(FOREGROUND_INTENSITY | ((i / 16) % 7 + 1)));
+
+        FormatLine(Line, _countof(Line), i);
+        Length = (DWORD)wcslen(Line);
+        Ret = WriteConsoleW(hConOut, Line, Length, &Written, NULL);
+        if (!Ret || Written != Length)
+        {
+            ok(FALSE, "Line %lu: WriteConsoleW returned %d, wrote %lu of %lu\n", i, Ret, Written, Length);
+            return;
+        }
+    }
+    Elapsed = GetTickCount() - Start;
+    SetConsoleTextAttribute(hConOut, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
+
+    trace("Wrote %u lines in %lu ms, %lu lines per second\n",
+          LINE_COUNT, Elapsed, Elapsed ? (LINE_COUNT * 1000UL / Elapsed) : 0);
+
+    /* The last line written sits right above the cursor */
+    Ret = GetConsoleScreenBufferInfo(hConOut, &csbi);
+    ok(Ret, "GetConsoleScreenBufferInfo failed with %lu\n", GetLastError());
+    if (!Ret)
+        return;
+    ok(csbi.dwCursorPosition.X == 0, "Cursor at column %d\n", csbi.dwCursorPosition.X);
+
+    FormatLine(Line, _countof(Line), LINE_COUNT - 1);
+    Length = (DWORD)wcslen(Line) - 2;
+    if (Length > (DWORD)csbi.dwSize.X || csbi.dwCursorPosition.Y < 1)
+    {
+        skip("Screen buffer too narrow\n");
+        return;
+    }
+
+    Coord.X = 0;
+    Coord.Y = csbi.dwCursorPosition.Y - 1;
+    Ret = ReadConsoleOutputCharacterW(hConOut, Read, Length, Coord, &Written);
+    ok(Ret && Written == Length, "ReadConsoleOutputCharacterW failed with %lu\n", GetLastError());
+    ok(!memcmp(Read, Line, Length * sizeof(WCHAR)), "Last line is '%.*S'\n", (int)Written, Read);
+}
+
+static
+void
+Test_Order(HANDLE hConOut)
+{
+    CONSOLE_SCREEN_BUFFER_INFO csbi;
+    WORD Attributes[3];
+    WCHAR Read[3];
+    DWORD Written;
+    BOOL Ret;
+
+    Ret = GetConsoleScreenBufferInfo(hConOut, &csbi);
+    ok(Ret, "GetConsoleScreenBufferInfo failed with %lu\n", GetLastError());
+    if (!Ret || csbi.dwCursorPosition.X + 3 > csbi.dwSize.X)
+    {
+        skip("No room for the text\n");
+        return;
+    }
+
+    /* Writes may be queued, but must reach the screen before what the next calls do */
+    SetConsoleTextAttribute(hConOut, FOREGROUND_RED);
+    WriteConsoleW(hConOut, L"R", 1, &Written, NULL);
+    WriteConsoleW(hConOut, L"R", 1, &Written, NULL);
+    SetConsoleTextAttribute(hConOut, FOREGROUND_GREEN);
+    WriteConsoleW(hConOut, L"G", 1, &Written, NULL);
+    SetConsoleTextAttribute(hConOut, csbi.wAttributes);
+
+    Ret = ReadConsoleOutputCharacterW(hConOut, Read, 3, csbi.dwCursorPosition, &Written);
+    ok(Ret && Written == 3, "ReadConsoleOutputCharacterW failed with %lu\n", GetLastError());
+    ok(!memcmp(Read, L"RRG", sizeof(Read)), "Read '%.*S'\n", (int)Written, Read);
+
+    Ret = ReadConsoleOutputAttribute(hConOut, Attributes, 3, csbi.dwCursorPosition, &Written);
+    ok(Ret && Written == 3, "ReadConsoleOutputAttribute failed with %lu\n", GetLastError());
+    ok(Attributes[0] == FOREGROUND_RED, "Attribute 0 is 0x%x\n", Attributes[0]);
+    ok(Attributes[1] == FOREGROUND_RED, "Attribute 1 is 0x%x\n", Attributes[1]);
+    ok(Attributes[2] == FOREGROUND_GREEN, "Attribute 2 is 0x%x\n", Attributes[2]);
+
+    WriteConsoleW(hConOut, L"\r\n", 2, &Written, NULL);
+}
+
+static
+void
+Test_Throughput(HANDLE hConOut)
+{
+    HANDLE hConOut2, hOut;
+    WCHAR Line[160];
+    DWORD Written;
+    ULONG i, Start, Server, Queued;
+
+    hConOut2 = CreateFileA("CONOUT$", GENERIC_READ | GENERIC_WRITE,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
+    if (hConOut2 == INVALID_HANDLE_VALUE)
+    {
+        skip("Cannot open a second output handle\n");
+        return;
+    }
+
+    /*
+     * Writes are only queued for the handle of the last write that went
+     * through the server, so alternating handles makes every write call it.
+     */
+    Start = GetTickCount();
+    for (i = 0; i < LINE_COUNT / 4; i++)
+    {
+        hOut = (i & 1) ? hConOut2 : hConOut;
+        FormatLine(Line, _countof(Line), i);
+        WriteConsoleW(hOut, Line, (DWORD)wcslen(Line), &Written, NULL);
+    }
+    Server = GetTickCount() - Start;
+
+    Start = GetTickCount();
+    for (i = 0; i < LINE_COUNT / 4; i++)
+    {
+        FormatLine(Line, _countof(Line), i);
+        WriteConsoleW(hConOut, Line, (DWORD)wcslen(Line), &Written, NULL);
+    }
+    /* Include the time to get it all on the screen */
+    GetConsoleMode(hConOut, &Written);
+    Queued = GetTickCount() - Start;
+
+    trace("Wrote %u lines through the server in %lu ms, queued in %lu ms\n",
+          LINE_COUNT / 4, Server, Queued);
+
+    CloseHandle(hConOut2);
+}
+
+START_TEST(WriteConsole)
+{
+    HANDLE hConOut;
+
+    hConOut = CreateFileA("CONOUT$", GENERIC_READ | GENERIC_WRITE,
+                          FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
+    if (hConOut == INVALID_HANDLE_VALUE)
+    {
+        skip("No console\n");
+        return;
+    }
+
+    Test_Flood(hConOut);
+    Test_Order(hConOut);
+    Test_Throughput(hConOut);
+
+    CloseHandle(hConOut);
+}
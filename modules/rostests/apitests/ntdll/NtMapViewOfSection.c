@@ -1626,6 +1626,225 @@ Test_Truncate(VOID)
     ok(Success == TRUE, "DeleteFileW failed with %lu\n", GetLastError());
 }
 
+/* Faults on file mappings read in the pages around the faulting one too */
+static void
+Test_ReadAround(VOID)
+{
+    WCHAR TempPath[MAX_PATH];
+    WCHAR FileName[MAX_PATH];
+    NTSTATUS Status;
+    HANDLE Handle, SectionHandle;
+    PULONG Buffer, Data;
+    PVOID BaseAddress;
+    SIZE_T ViewSize;
+    DWORD Length, Written;
+    ULONG Page, i, Errors;
+    const ULONG PageCount = 512;
+    const ULONG WordsPerPage = PAGE_SIZE / sizeof(ULONG);
+    BOOL Success;
+
+    Length = GetTempPathW(MAX_PATH, TempPath);
+    ok(Length != 0, "GetTempPathW failed with %lu\n", GetLastError());
+    Length = GetTempFileNameW(TempPath, L"nta", 0, FileName);
+    ok(Length != 0, "GetTempFileNameW failed with %lu\n", GetLastError());
+    Handle = CreateFileW(FileName, FILE_ALL_ACCESS, 0, NULL, CREATE_ALWAYS, 0, NULL);
+    if (Handle == INVALID_HANDLE_VALUE)
+    {
+        skip("Failed to create temp file %ls, error %lu\n", FileName, GetLastError());
+        return;
+    }
+
+    /* Every ULONG of the file holds its own offset */
+    Buffer = HeapAlloc(GetProcessHeap(), 0, PAGE_SIZE);
+    if (!Buffer)
+    {
+        skip("Out of memory\n");
+        CloseHandle(Handle);
+        DeleteFileW(FileName);
+        return;
+    }
+    for (Page = 0; Page < PageCount; Page++)
+    {
+        for (i = 0; i < WordsPerPage; i++)
+            Buffer[i] = Page * PAGE_SIZE + i * sizeof(ULONG);
+        Success = WriteFile(Handle, Buffer, PAGE_SIZE, &Written, NULL);
+        ok(Success && Written == PAGE_SIZE, "WriteFile failed with %lu\n", GetLastError());
+    }
+    HeapFree(GetProcessHeap(), 0, Buffer);
+
+    Status = NtCreateSection(&SectionHandle,
+                             STANDARD_RIGHTS_REQUIRED | SECTION_QUERY | SECTION_MAP_READ,
+                             0, 0, PAGE_READONLY, SEC_COMMIT, Handle);
+    ok_ntstatus(Status, STATUS_SUCCESS);
+    if (!NT_SUCCESS(Status))
+    {
+        CloseHandle(Handle);
+        DeleteFileW(FileName);
+        return;
+    }
+
+    BaseAddress = NULL;
+    ViewSize = 0;
+    Status = NtMapViewOfSection(SectionHandle, NtCurrentProcess(), &BaseAddress, 0,
+                                0, 0, &ViewSize, ViewShare, 0, PAGE_READONLY);
+    ok_ntstatus(Status, STATUS_SUCCESS);
+    if (NT_SUCCESS(Status))
+    {
+        Data = BaseAddress;
+
+        /* Fault the second half backward, the first one in steps of a few pages */
+        Errors = 0;
+        for (Page = PageCount; Page-- > PageCount / 2;)
+            Errors += (Data[Page * WordsPerPage] != Page * PAGE_SIZE);
+        for (Page = 0; Page < PageCount / 2; Page += 5)
+            Errors += (Data[Page * WordsPerPage] != Page * PAGE_SIZE);
+        ok(Errors == 0, "%lu pages read wrong on first touch\n", Errors);
+
+        /* Now every word of every page must be right */
+        Errors = 0;
+        for (i = 0; i < PageCount * WordsPerPage; i++)
+            Errors += (Data[i] != i * sizeof(ULONG));
+        ok(Errors == 0, "%lu words read wrong\n", Errors);
+
+        Status = NtUnmapViewOfSection(NtCurrentProcess(), BaseAddress);
+        ok_ntstatus(Status, STATUS_SUCCESS);
+    }
+
+    NtClose(SectionHandle);
+    CloseHandle(Handle);
+    Success = DeleteFileW(FileName);
+    ok(Success == TRUE, "DeleteFileW failed with %lu\n", GetLastError());
+}
+
+/* Tells whether a section gets patched when the image is relocated */
+static BOOLEAN
+SectionHasRelocations(PVOID Image, PIMAGE_SECTION_HEADER SectionHeader)
+{
+    PIMAGE_BASE_RELOCATION Relocation;
+    ULONG Size, BlockEnd;
+
+    Relocation = RtlImageDirectoryEntryToData(Image, TRUE, IMAGE_DIRECTORY_ENTRY_BASERELOC, &Size);
+    if (!Relocation)
+        return FALSE;
+
+    while (Size >= sizeof(*Relocation) && Relocation->SizeOfBlock >= sizeof(*Relocation) &&
+           Relocation->SizeOfBlock <= Size)
+    {
+        /* Each block covers one page */
+        BlockEnd = Relocation->VirtualAddress + PAGE_SIZE;
+        if (Relocation->SizeOfBlock > sizeof(*Relocation) &&
+            Relocation->VirtualAddress < SectionHeader->VirtualAddress + SectionHeader->Misc.VirtualSize &&
+            BlockEnd > SectionHeader->VirtualAddress)
+        {
+            return TRUE;
+        }
+
+        Size -= Relocation->SizeOfBlock;
+        Relocation = (PIMAGE_BASE_RELOCATION)((PUCHAR)Relocation + Relocation->SizeOfBlock);
+    }
+
+    return FALSE;
+}
+
+/* Maps a large system image and touches all of its pages, as its startup would */
+static void
+Test_ImageStartup(VOID)
+{
+    WCHAR FileName[MAX_PATH];
+    NTSTATUS Status;
+    HANDLE Handle, SectionHandle;
+    PIMAGE_NT_HEADERS NtHeaders;
+    PIMAGE_SECTION_HEADER SectionHeader;
+    PUCHAR Image, File;
+    PVOID BaseAddress;
+    SIZE_T ViewSize;
+    DWORD FileSize, Read;
+    ULONG Offset, Size, i, Errors;
+    ULONG StartTime, TouchTime;
+    volatile UCHAR Byte;
+
+    GetSystemDirectoryW(FileName, MAX_PATH);
+    StringCbCatW(FileName, sizeof(FileName), L"\\shell32.dll");
+    Handle = CreateFileW(FileName, GENERIC_READ | GENERIC_EXECUTE, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+    if (Handle == INVALID_HANDLE_VALUE)
+    {
+        skip("Failed to open %ls, error %lu\n", FileName, GetLastError());
+        return;
+    }
+
+    Status = NtCreateSection(&SectionHandle, SECTION_ALL_ACCESS, NULL, NULL,
+                             PAGE_EXECUTE_READ, SEC_IMAGE, Handle);
+    ok_ntstatus(Status, STATUS_SUCCESS);
+    if (!NT_SUCCESS(Status))
+    {
+        CloseHandle(Handle);
+        return;
+    }
+
+    BaseAddress = NULL;
+    ViewSize = 0;
+    Status = NtMapViewOfSection(SectionHandle, NtCurrentProcess(), &BaseAddress, 0,
+                                0, NULL, &ViewSize, ViewShare, 0, PAGE_EXECUTE_READ);
+    ok(NT_SUCCESS(Status), "NtMapViewOfSection failed with 0x%lx\n", Status);
+    if (!NT_SUCCESS(Status))
+    {
+        NtClose(SectionHandle);
+        CloseHandle(Handle);
+        return;
+    }
+
+    /* Touch every page, first with the cold file if this runs early enough */
+    Image = BaseAddress;
+    StartTime = GetTickCount();
+    for (Offset = 0; Offset < ViewSize; Offset += PAGE_SIZE)
+        Byte = Image[Offset];
+    TouchTime = GetTickCount() - StartTime;
+    trace("Touched %lu pages of %ls in %lu ms\n", (ULONG)(ViewSize / PAGE_SIZE), FileName, TouchTime);
+
+    /*
+     * The sections must match the file, wherever their pages came from.
+     * Those with relocations are skipped, as they differ if the image
+     * had to be relocated.
+     */
+    FileSize = GetFileSize(Handle, NULL);
+    File = HeapAlloc(GetProcessHeap(), 0, FileSize);
+    if (File && ReadFile(Handle, File, FileSize, &Read, NULL) && Read == FileSize)
+    {
+        NtHeaders = RtlImageNtHeader(Image);
+        ok(NtHeaders != NULL, "No NT headers\n");
+        if (NtHeaders)
+        {
+            Size = min(NtHeaders->OptionalHeader.SizeOfHeaders, FileSize);
+            ok(memcmp(Image, File, Size) == 0, "Headers differ from the file\n");
+
+            SectionHeader = IMAGE_FIRST_SECTION(NtHeaders);
+            for (i = 0; i < NtHeaders->FileHeader.NumberOfSections; i++, SectionHeader++)
+            {
+                Size = min(SectionHeader->SizeOfRawData, SectionHeader->Misc.VirtualSize);
+                if (!Size || SectionHeader->PointerToRawData + Size > FileSize)
+                    continue;
+                if (SectionHasRelocations(Image, SectionHeader))
+                    continue;
+
+                Errors = (memcmp(Image + SectionHeader->VirtualAddress,
+                                 File + SectionHeader->PointerToRawData,
+                                 Size) != 0);
+                ok(Errors == 0, "Section %.8s differs from the file\n", SectionHeader->Name);
+            }
+        }
+    }
+    else
+    {
+        skip("Failed to read %ls\n", FileName);
+    }
+    if (File) HeapFree(GetProcessHeap(), 0, File);
+
+    Status = NtUnmapViewOfSection(NtCurrentProcess(), BaseAddress);
+    ok_ntstatus(Status, STATUS_SUCCESS);
+    NtClose(SectionHandle);
+    CloseHandle(Handle);
+}
+
 START_TEST(NtMapViewOfSection)
 {
     Test_PageFileSection();
@@ -1635,4 +1854,6 @@ START_TEST(NtMapViewOfSection)
     Test_SectionContents(TRUE);
     Test_EmptyFile();
     Test_Truncate();
+    Test_ReadAround();
+    Test_ImageStartup();
 }
@@ -1,5 +1,6 @@
 #include <windows.h>
 #include <string.h>
+#include <stdio.h>
 
 BOOL WINAPI GdiAlphaBlend(HDC hdcDst, int xDst, int yDst, int widthDst, int heightDst,
                           HDC hdcSrc, int xSrc, int ySrc, int widthSrc, int heightSrc,
@@ -14,6 +15,138 @@ const char* WndClassName = "GMainWnd";
 LRESULT CALLBACK MainWndProc(HWND HWnd, UINT Msg, WPARAM WParam,
    LPARAM LParam);
 
+/* Throughput benchmark, run with "alphablend /bench" or by double
+   clicking the window */
+#define BENCH_WIDTH       512
+#define BENCH_HEIGHT      512
+#define BENCH_ITERATIONS  100
+
+HBITMAP CreateBenchBitmap(HDC hDC, int BitCount, PVOID *ppvBits)
+{
+  struct
+  {
+    BITMAPINFOHEADER bmiHeader;
+    DWORD Masks[3];
+  } bmi;
+
+  ZeroMemory(&bmi, sizeof(bmi));
+  bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+  bmi.bmiHeader.biWidth = BENCH_WIDTH;
+  bmi.bmiHeader.biHeight = BENCH_HEIGHT;
+  bmi.bmiHeader.biPlanes = 1;
+  bmi.bmiHeader.biBitCount = BitCount;
+  bmi.bmiHeader.biCompression = BI_RGB;
+  if (BitCount == 16)
+  {
+    /* 565 */
+    bmi.bmiHeader.biCompression = BI_BITFIELDS;
+    bmi.Masks[0] = 0xF800;
+    bmi.Masks[1] = 0x07E0;
+    bmi.Masks[2] = 0x001F;
+  }
+  return CreateDIBSection(hDC, (BITMAPINFO*)&bmi, DIB_RGB_COLORS, ppvBits, 0, 0);
+}
+
+double BenchAlphaBlend(HDC hdcDst, HDC hdcSrc, BYTE ConstAlpha, BYTE AlphaFormat)
+{
+  BLENDFUNCTION BlendFunc;
+  LARGE_INTEGER Frequency, Start, End;
+  int i;
+
+  BlendFunc.BlendOp = AC_SRC_OVER;
+  BlendFunc.BlendFlags = 0;
+  BlendFunc.SourceConstantAlpha = ConstAlpha;
+  BlendFunc.AlphaFormat = AlphaFormat;
+
+  QueryPerformanceFrequency(&Frequency);
+  QueryPerformanceCounter(&Start);
+  for (i = 0; i < BENCH_ITERATIONS; i++)
+  {
+    GdiAlphaBlend(hdcDst, 0, 0, BENCH_WIDTH, BENCH_HEIGHT,
+                  hdcSrc, 0, 0, BENCH_WIDTH, BENCH_HEIGHT,
+                  BlendFunc);
+  }
+  GdiFlush();
+  QueryPerformanceCounter(&End);
+
+  /* Megapixels per second */
+  return ((double)BENCH_WIDTH * BENCH_HEIGHT * BENCH_ITERATIONS / 1000000.0) /
+         ((double)(End.QuadPart - Start.QuadPart) / (double)Frequency.QuadPart);
+}
+
+void RunBenchmark(HWND HWnd)
+{
+  static const struct
+  {
+    const char *Name;
+    int DstBitCount;
+    BYTE ConstAlpha;
+    BYTE AlphaFormat;
+  } Cases[] =
+  {
+    { "BGRA -> BGRA, per pixel alpha", 32, 255, AC_SRC_ALPHA },
+    { "BGRA -> BGRA, per pixel and constant alpha", 32, 128, AC_SRC_ALPHA },
+    { "BGRA -> BGRA, constant alpha", 32, 128, 0 },
+    { "BGRA -> 565, per pixel alpha", 16, 255, AC_SRC_ALPHA },
+    { "BGRA -> 565, constant alpha", 16, 128, 0 },
+  };
+  char Result[1024];
+  int Length = 0, i, x, y;
+  HDC hdcSrc, hdcDst;
+  HBITMAP hbmSrc, hbmDst;
+  PVOID pvSrc, pvDst;
+  DWORD *Pixel;
+
+  hdcSrc = CreateCompatibleDC(NULL);
+  hdcDst = CreateCompatibleDC(NULL);
+  hbmSrc = CreateBenchBitmap(hdcSrc, 32, &pvSrc);
+  if (!hdcSrc || !hdcDst || !hbmSrc)
+    goto Cleanup;
+  SelectObject(hdcSrc, hbmSrc);
+
+  /* Premultiplied gradient with opaque, transparent and translucent parts */
+  Pixel = pvSrc;
+  for (y = 0; y < BENCH_HEIGHT; y++)
+  {
+    for (x = 0; x < BENCH_WIDTH; x++)
+    {
+      DWORD Alpha = (x < BENCH_WIDTH / 4) ? 0 : (x < BENCH_WIDTH / 2) ? 255 : (x + y) & 0xFF;
+      *Pixel++ = (Alpha << 24) | ((((x & 0xFF) * Alpha) / 255) << 16) |
+                 (((y * Alpha) / 511) << 8) | ((0x80 * Alpha) / 255);
+    }
+  }
+
+  for (i = 0; i < sizeof(Cases) / sizeof(Cases[0]); i++)
+  {
+    hbmDst = CreateBenchBitmap(hdcDst, Cases[i].DstBitCount, &pvDst);
+    if (!hbmDst)
+      continue;
+    SelectObject(hdcDst, hbmDst);
+    memset(pvDst, 0x5A, BENCH_WIDTH * BENCH_HEIGHT * (Cases[i].DstBitCount / 8));
+
+    Length += _snprintf(Result + Length, sizeof(Result) - Length, "%s: %.1f Mpixels/s\n",
+                        Cases[i].Name,
+                        BenchAlphaBlend(hdcDst, hdcSrc, Cases[i].ConstAlpha, Cases[i].AlphaFormat));
+
+    SelectObject(hdcDst, GetStockObject(DEFAULT_BITMAP));
+    DeleteObject(hbmDst);
+  }
+
+  OutputDebugStringA(Result);
+  MessageBoxA(HWnd, Result, "AlphaBlend throughput", MB_OK);
+
+Cleanup:
+  if (hbmSrc)
+  {
+    SelectObject(hdcSrc, GetStockObject(DEFAULT_BITMAP));
+    DeleteObject(hbmSrc);
+  }
+  if (hdcSrc)
+    DeleteDC(hdcSrc);
+  if (hdcDst)
+    DeleteDC(hdcDst);
+}
+
 int APIENTRY WinMain(HINSTANCE HInstance, HINSTANCE HPrevInstance,
     LPTSTR lpCmdLine, int nCmdShow)
 {
@@ -48,6 +181,9 @@ int APIENTRY WinMain(HINSTANCE HInstance, HINSTANCE HPrevInstance,
          ShowWindow(HWnd, nCmdShow);
          UpdateWindow(HWnd);
 
+         if (lpCmdLine && strstr(lpCmdLine, "bench"))
+            RunBenchmark(HWnd);
+
          while (GetMessage(&msg, NULL, 0, 0))
          {
              TranslateMessage(&msg);
@@ -197,6 +333,11 @@ LRESULT CALLBACK MainWndProc(HWND HWnd, UINT Msg, WPARAM WParam,
          EndPaint(HWnd, &ps);
          break;
       }
+      case WM_LBUTTONDBLCLK:
+      {
+         RunBenchmark(HWnd);
+         return 0;
+      }
       case WM_DESTROY:
       {
          /* clean up */
@@ -712,6 +712,45 @@ static VOID FsRtlLargeMcbTestsFastFat()
     ok_eq_longlong(Lbn, -1);
     ok_eq_ulong(Index, (ULONG) -1);
 
+    /* A fragmented cluster chain, made of 1024 runs of two clusters each */
+    for (Vbn = 0; Vbn < 2048; Vbn += 2)
+    {
+        Result = FsRtlAddLargeMcbEntry(&FirstMcb, Vbn, 2 * Vbn + 100, 2);
+        if (!Result)
+        {
+            ok_bool_true(Result, "FsRtlAddLargeMcbEntry returned");
+            break;
+        }
+    }
+    ok_eq_ulong(FsRtlNumberOfRunsInLargeMcb(&FirstMcb), 1024);
+
+    for (Vbn = 0; Vbn < 2048; Vbn++)
+    {
+        Result = FsRtlLookupLargeMcbEntry(&FirstMcb, Vbn, &Lbn, &SectorCount, NULL, NULL, NULL);
+        if (!Result || Lbn != 2 * (Vbn & ~1) + 100 + (Vbn & 1) || SectorCount != 2 - (Vbn & 1))
+        {
+            ok(FALSE, "Vbn %I64d: returned %d, Lbn %I64d, SectorCount %I64d\n", Vbn, Result, Lbn, SectorCount);
+            break;
+        }
+    }
+
+    Result = FsRtlLookupLargeMcbEntry(&FirstMcb, 2048, &Lbn, &SectorCount, NULL, NULL, NULL);
+    ok_bool_false(Result, "FsRtlLookupLargeMcbEntry returned");
+    ok_eq_longlong(Lbn, -1);
+
+    /* Cutting the chain back leaves the start of it alone */
+    FsRtlTruncateLargeMcb(&FirstMcb, 1001);
+    Result = FsRtlLookupLargeMcbEntry(&FirstMcb, 1000, &Lbn, &SectorCount, NULL, NULL, NULL);
+    ok_bool_true(Result, "FsRtlLookupLargeMcbEntry returned");
+    ok_eq_longlong(Lbn, 2100);
+    ok_eq_longlong(SectorCount, 1);
+    Result = FsRtlLookupLargeMcbEntry(&FirstMcb, 1001, &Lbn, &SectorCount, NULL, NULL, NULL);
+    ok_bool_false(Result, "FsRtlLookupLargeMcbEntry returned");
+    Result = FsRtlLookupLastLargeMcbEntry(&FirstMcb, &Vbn, &Lbn);
+    ok_bool_true(Result, "FsRtlLookupLastLargeMcbEntry returned");
+    ok_eq_longlong(Vbn, 1000);
+    ok_eq_longlong(Lbn, 2100);
+
     FsRtlUninitializeLargeMcb(&FirstMcb);
 }
 
@@ -208,6 +208,13 @@ INIT_SECTION CM_SYSTEM_CONTROL_VECTOR CmControlVector[] =
         NULL,
         NULL
     },
+    {
+        L"Session Manager\\Configuration Manager",
+        L"MaxSubKeyHint",
+        &CmpMaxSubKeyHint,
+        NULL,
+        NULL
+    },
     {
         L"Session Manager\\Memory Management",
         L"PagedPoolQuota",
@@ -425,6 +432,13 @@ INIT_SECTION CM_SYSTEM_CONTROL_VECTOR CmControlVector[] =
         NULL,
         NULL
     },
+    {
+        L"Session Manager\\Memory Management",
+        L"TraceReadAround",
+        &MmTraceReadAround,
+        NULL,
+        NULL
+    },
     {
         L"Session Manager\\Memory Management",
         L"VerifyDrivers",
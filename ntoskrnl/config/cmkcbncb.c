@@ -15,6 +15,7 @@
 /* GLOBALS *******************************************************************/
 
 ULONG CmpHashTableSize = 2048;
+ULONG CmpMaxSubKeyHint = 32768;
 PCM_KEY_HASH_TABLE_ENTRY CmpCacheTable;
 PCM_NAME_HASH_TABLE_ENTRY CmpNameCacheTable;
 
@@ -566,6 +567,66 @@ CmpCleanUpSubKeyInfo(IN PCM_KEY_CONTROL_BLOCK Kcb)
     }
 }
 
+HCELL_INDEX
+NTAPI
+CmpFindSubKeyByNameWithKcb(IN PCM_KEY_CONTROL_BLOCK Kcb,
+                           IN PCM_KEY_NODE Node,
+                           IN PCUNICODE_STRING SearchName)
+{
+    PCM_INDEX_HINT_BLOCK IndexHint;
+    HCELL_INDEX Cell;
+    ULONG SubKeyCount;
+
+    /* Sanity check */
+    ASSERT(Kcb->KeyHive && (Kcb->KeyCell != HCELL_NIL));
+
+    /* The subkey cache is protected by the KCB lock */
+    CmpAcquireKcbLockExclusive(Kcb);
+
+    /* Check if we don't know anything about the subkeys yet */
+    if (!(Kcb->ExtFlags & (CM_KCB_NO_SUBKEY |
+                           CM_KCB_SUBKEY_ONE |
+                           CM_KCB_SUBKEY_HINT |
+                           CM_KCB_INVALID_CACHED_INFO)))
+    {
+        SubKeyCount = Node->SubKeyCounts[Stable] + Node->SubKeyCounts[Volatile];
+        if (!SubKeyCount)
+        {
+            /* Remember that there's nothing to look for */
+            Kcb->ExtFlags |= CM_KCB_NO_SUBKEY;
+        }
+        else if ((SubKeyCount >= CMP_MIN_SUBKEY_HINT) &&
+                 (SubKeyCount <= CmpMaxSubKeyHint))
+        {
+            /* Build the hint, or keep using the index if we can't */
+            IndexHint = CmpCreateIndexHint(Kcb->KeyHive, Node);
+            if (IndexHint)
+            {
+                Kcb->IndexHint = IndexHint;
+                Kcb->ExtFlags |= CM_KCB_SUBKEY_HINT;
+            }
+        }
+    }
+
+    /* Use the cached information if we have it */
+    if (Kcb->ExtFlags & CM_KCB_NO_SUBKEY)
+    {
+        Cell = HCELL_NIL;
+    }
+    else if (Kcb->ExtFlags & CM_KCB_SUBKEY_HINT)
+    {
+        Cell = CmpFindSubKeyInIndexHint(Kcb->KeyHive, Kcb->IndexHint, SearchName);
+    }
+    else
+    {
+        Cell = CmpFindSubKeyByName(Kcb->KeyHive, Node, SearchName);
+    }
+
+    /* Release the lock and return the cell */
+    CmpReleaseKcbLock(Kcb);
+    return Cell;
+}
+
 VOID
 NTAPI
 CmpDereferenceKeyControlBlock(IN PCM_KEY_CONTROL_BLOCK Kcb)
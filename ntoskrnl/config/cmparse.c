@@ -490,6 +490,11 @@ CmpDoCreate(IN PHHIVE Hive,
             ASSERT(FALSE);
         }
 
+        /* The cached subkey information of the parent is now stale */
+        CmpAcquireKcbLockExclusive(ParentKcb);
+        CmpCleanUpSubKeyInfo(ParentKcb);
+        CmpReleaseKcbLock(ParentKcb);
+
         /* Get the key node */
         KeyNode = (PCM_KEY_NODE)HvGetCell(Hive, Cell);
         if (!KeyNode)
@@ -905,6 +910,11 @@ CmpCreateLinkNode(IN PHHIVE Hive,
             ASSERT(FALSE);
         }
 
+        /* The cached subkey information of the parent is now stale */
+        CmpAcquireKcbLockExclusive(ParentKcb);
+        CmpCleanUpSubKeyInfo(ParentKcb);
+        CmpReleaseKcbLock(ParentKcb);
+
         /* Get the key body */
         KeyBody = (PCM_KEY_BODY)*Object;
 
@@ -1171,7 +1181,7 @@ CmpParseKey(IN PVOID ParseObject,
             if (!(Kcb->Flags & KEY_SYM_LINK))
             {
                 /* Find the subkey */
-                NextCell = CmpFindSubKeyByName(Hive, Node, &NextName);
+                NextCell = CmpFindSubKeyByNameWithKcb(ParentKcb, Node, &NextName);
                 if (NextCell != HCELL_NIL)
                 {
                     /* Get the new node */
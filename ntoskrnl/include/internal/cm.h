@@ -79,6 +79,12 @@
 #define CMP_SECURITY_HASH_LISTS                         64
 #define CMP_MAX_CALLBACKS                               100
 
+//
+// Keys with fewer subkeys are searched faster through their index than
+// through a subkey hint
+//
+#define CMP_MIN_SUBKEY_HINT                             64
+
 //
 // Hashing Constants
 //
@@ -212,15 +218,6 @@ typedef struct _CACHED_CHILD_LIST
     };
 } CACHED_CHILD_LIST, *PCACHED_CHILD_LIST;
 
-//
-// Index Hint Block
-//
-typedef struct _CM_INDEX_HINT_BLOCK
-{
-    ULONG Count;
-    ULONG HashKey[ANYSIZE_ARRAY];
-} CM_INDEX_HINT_BLOCK, *PCM_INDEX_HINT_BLOCK;
-
 //
 // Key Body
 //
@@ -1027,6 +1024,14 @@ CmpCleanUpSubKeyInfo(
     IN PCM_KEY_CONTROL_BLOCK Kcb
 );
 
+HCELL_INDEX
+NTAPI
+CmpFindSubKeyByNameWithKcb(
+    IN PCM_KEY_CONTROL_BLOCK Kcb,
+    IN PCM_KEY_NODE Node,
+    IN PCUNICODE_STRING SearchName
+);
+
 PUNICODE_STRING
 NTAPI
 CmpConstructName(
@@ -1533,6 +1538,7 @@ extern HANDLE CmpRegistryRootHandle;
 extern BOOLEAN ExpInTextModeSetup;
 extern BOOLEAN InitIsWinPEMode;
 extern ULONG CmpHashTableSize;
+extern ULONG CmpMaxSubKeyHint;
 extern ULONG CmpDelayedCloseSize, CmpDelayedCloseIndex;
 extern BOOLEAN CmpNoWrite;
 extern BOOLEAN CmpForceForceFlush;
@@ -151,6 +151,11 @@ typedef ULONG_PTR SWAPENTRY;
 //
 #define MM_WAIT_ENTRY            0x7ffffc00
 
+//
+// Maximum number of pages read in around a faulting one
+//
+#define MM_MAXIMUM_READ_CLUSTER_SIZE    15
+
 #define InterlockedCompareExchangePte(PointerPte, Exchange, Comperand) \
     InterlockedCompareExchange((PLONG)(PointerPte), Exchange, Comperand)
 
@@ -179,6 +184,9 @@ typedef struct _MM_SECTION_SEGMENT
 
 	LIST_ENTRY ListOfSegments;
 	RTL_GENERIC_TABLE PageTable;
+
+    ULONG PageFaults;		/* pages read in from the file on a fault */
+    ULONG ReadAroundPages;	/* of which read in around another faulting page */
 } MM_SECTION_SEGMENT, *PMM_SECTION_SEGMENT;
 
 typedef struct _MM_IMAGE_SECTION_OBJECT
@@ -653,6 +653,8 @@ extern PVOID MiSessionPoolStart;   // 0xBD000000
 extern PVOID MiSessionViewStart;   // 0xBE000000
 extern PVOID MiSessionSpaceWs;
 extern ULONG MmMaximumDeadKernelStacks;
+extern ULONG MmReadClusterSize;
+extern ULONG MmTraceReadAround;
 extern SLIST_HEADER MmDeadStackSListHead;
 extern MM_AVL_TABLE MmSectionBasedRoot;
 extern KGUARDED_MUTEX MmSectionBasedMutex;
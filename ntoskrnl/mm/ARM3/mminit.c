@@ -2411,6 +2411,7 @@ MmArmInitSystem(IN ULONG Phase,
             /* Set small system */
             MmSystemSize = MmSmallSystem;
             MmMaximumDeadKernelStacks = 0;
+            MmReadClusterSize = 2;
         }
         else if (MmNumberOfPhysicalPages <= ((19 * _1MB) / PAGE_SIZE))
         {
@@ -2418,6 +2419,7 @@ MmArmInitSystem(IN ULONG Phase,
             MmSystemSize = MmSmallSystem;
             MmSystemCacheWsMinimum += 100;
             MmMaximumDeadKernelStacks = 2;
+            MmReadClusterSize = 3;
         }
         else
         {
@@ -2425,6 +2427,7 @@ MmArmInitSystem(IN ULONG Phase,
             MmSystemSize = MmMediumSystem;
             MmSystemCacheWsMinimum += 400;
             MmMaximumDeadKernelStacks = 5;
+            MmReadClusterSize = 7;
         }
 
         /* Check for less than 24MB */
@@ -137,6 +137,9 @@ POBJECT_TYPE MmSectionObjectType = NULL;
 
 ULONG_PTR MmSubsectionBase;
 
+/* Print the read-around statistics of the segments as they are freed */
+ULONG MmTraceReadAround;
+
 static ULONG SectionCharacteristicsToProtect[16] =
 {
     PAGE_NOACCESS,          /* 0 = NONE */
@@ -824,6 +827,11 @@ MmFreeSectionSegments(PFILE_OBJECT FileObject)
                         SectionSegments[i].ReferenceCount);
                 KeBugCheck(MEMORY_MANAGEMENT);
             }
+            if (MmTraceReadAround && SectionSegments[i].PageFaults != 0)
+            {
+                DPRINT1("Image segment %lu: %lu pages faulted in, %lu of them read around\n", i,
+                        SectionSegments[i].PageFaults, SectionSegments[i].ReadAroundPages);
+            }
             MmFreePageTablesSectionSegment(&SectionSegments[i], NULL);
         }
         ExFreePool(ImageSectionObject->Segments);
@@ -842,6 +850,11 @@ MmFreeSectionSegments(PFILE_OBJECT FileObject)
             DPRINT1("Data segment still referenced\n");
             KeBugCheck(MEMORY_MANAGEMENT);
         }
+        if (MmTraceReadAround && Segment->PageFaults != 0)
+        {
+            DPRINT1("Data segment: %lu pages faulted in, %lu of them read around\n",
+                    Segment->PageFaults, Segment->ReadAroundPages);
+        }
         MmFreePageTablesSectionSegment(Segment, NULL);
         ExFreePool(Segment);
         FileObject->SectionObjectPointer->DataSectionObject = NULL;
@@ -1359,6 +1372,87 @@ MmAlterViewAttributes(PMMSUPPORT AddressSpace,
     MmUnlockSectionSegment(Segment);
 }
 
+static
+BOOLEAN
+MiIsReadAroundPage(PEPROCESS Process,
+                   PMM_SECTION_SEGMENT Segment,
+                   PVOID Address,
+                   LONGLONG SegOffset)
+{
+    LARGE_INTEGER Offset;
+
+    /* The page must be neither resident in the segment nor mapped in any way */
+    Offset.QuadPart = SegOffset;
+    if (MmGetPageEntrySectionSegment(Segment, &Offset) != 0)
+        return FALSE;
+
+    return !MmIsPagePresent(Process, Address) &&
+           !MmIsPageSwapEntry(Process, Address) &&
+           !MmIsDisabledPage(Process, Address);
+}
+
+/*
+ * Finds the pages around a faulting one that can be read in along with it:
+ * not yet resident, in the same view and region, and backed by the file.
+ * Called with the segment locked; returns the number of pages, the faulting
+ * one included, starting at *ClusterStart.
+ */
+static
+ULONG
+MiGetReadAroundCluster(PEPROCESS Process,
+                       PMEMORY_AREA MemoryArea,
+                       PVOID RegionBase,
+                       SIZE_T RegionLength,
+                       PVOID PAddress,
+                       LONGLONG SegOffset,
+                       PVOID *ClusterStart)
+{
+    PMM_SECTION_SEGMENT Segment = MemoryArea->Data.SectionData.Segment;
+    ULONG_PTR Start, End, Low, High;
+    LONGLONG SegEnd;
+    ULONG ClusterSize;
+
+    *ClusterStart = PAddress;
+
+    /* Don't make things worse when memory is short */
+    ClusterSize = min(MmReadClusterSize, MM_MAXIMUM_READ_CLUSTER_SIZE) + 1;
+    if ((ClusterSize == 1) || (MmAvailablePages < MmLowMemoryThreshold + ClusterSize))
+        return 1;
+
+    /* Stay within the view and the region, they share the protection */
+    Start = max(MA_GetStartingAddress(MemoryArea), (ULONG_PTR)RegionBase);
+    End = min(MA_GetEndingAddress(MemoryArea), (ULONG_PTR)RegionBase + RegionLength);
+
+    /* And within the part of the segment that comes from the file */
+    SegEnd = min(Segment->Length.QuadPart, (LONGLONG)PAGE_ROUND_UP(Segment->RawLength.QuadPart));
+    if (SegEnd - SegOffset < (LONGLONG)(End - (ULONG_PTR)PAddress))
+        End = (ULONG_PTR)PAddress + (ULONG_PTR)(SegEnd - SegOffset);
+
+    /* Grow forward first, faults mostly go that way */
+    High = (ULONG_PTR)PAddress + PAGE_SIZE;
+    while (((High - (ULONG_PTR)PAddress) >> PAGE_SHIFT) < ClusterSize &&
+           (High < End) &&
+           MiIsReadAroundPage(Process, Segment, (PVOID)High,
+                              SegOffset + (High - (ULONG_PTR)PAddress)))
+    {
+        High += PAGE_SIZE;
+    }
+
+    /* Then backward with what is left */
+    Low = (ULONG_PTR)PAddress;
+    while (((High - Low) >> PAGE_SHIFT) < ClusterSize &&
+           (Low > Start) &&
+           (SegOffset >= (LONGLONG)((ULONG_PTR)PAddress - Low + PAGE_SIZE)) &&
+           MiIsReadAroundPage(Process, Segment, (PVOID)(Low - PAGE_SIZE),
+                              SegOffset - ((ULONG_PTR)PAddress - Low + PAGE_SIZE)))
+    {
+        Low -= PAGE_SIZE;
+    }
+
+    *ClusterStart = (PVOID)Low;
+    return (ULONG)((High - Low) >> PAGE_SHIFT);
+}
+
 NTSTATUS
 NTAPI
 MmNotPresentFaultSectionView(PMMSUPPORT AddressSpace,
@@ -1375,6 +1469,7 @@ MmNotPresentFaultSectionView(PMMSUPPORT AddressSpace,
     ULONG_PTR Entry1;
     ULONG Attributes;
     PMM_REGION Region;
+    PVOID RegionBase;
     BOOLEAN HasSwapEntry;
     PVOID PAddress;
     PEPROCESS Process = MmGetAddressSpaceOwner(AddressSpace);
@@ -1411,7 +1506,7 @@ MmNotPresentFaultSectionView(PMMSUPPORT AddressSpace,
     Section = MemoryArea->Data.SectionData.Section;
     Region = MmFindRegion((PVOID)MA_GetStartingAddress(MemoryArea),
                           &MemoryArea->Data.SectionData.RegionListHead,
-                          Address, NULL);
+                          Address, &RegionBase);
     ASSERT(Region != NULL);
 
     /* Check for a NOACCESS mapping */
@@ -1602,23 +1697,56 @@ MmNotPresentFaultSectionView(PMMSUPPORT AddressSpace,
     if (Entry == 0)
     {
         SWAPENTRY FakeSwapEntry;
+        BOOLEAN ReadFromFile;
+        PVOID ClusterStart, ClusterAddress;
+        ULONG ClusterSize, i;
+        LARGE_INTEGER ClusterOffset;
+        PFN_NUMBER ClusterPages[MM_MAXIMUM_READ_CLUSTER_SIZE + 1];
 
         /*
          * If the entry is zero (and it can't change because we have
          * locked the segment) then we need to load the page.
          */
+        ReadFromFile = !(Segment->Flags & MM_PAGEFILE_SEGMENT) &&
+                       !((Offset.QuadPart >= (LONGLONG)PAGE_ROUND_UP(Segment->RawLength.QuadPart) &&
+                          (Section->AllocationAttributes & SEC_IMAGE)));
+
+        /*
+         * Pages of the file are read in a cluster, along with the not yet
+         * resident pages around them. This saves a fault for each of them,
+         * and the read of the cache view they share.
+         */
+        ClusterStart = PAddress;
+        ClusterSize = 1;
+        if (ReadFromFile)
+        {
+            ClusterSize = MiGetReadAroundCluster(Process,
+                                                 MemoryArea,
+                                                 RegionBase,
+                                                 Region->Length,
+                                                 PAddress,
+                                                 Offset.QuadPart,
+                                                 &ClusterStart);
+        }
 
         /*
-         * Release all our locks and read in the page from disk
+         * Release all our locks and read in the pages from disk
          */
-        MmSetPageEntrySectionSegment(Segment, &Offset, MAKE_SWAP_SSE(MM_WAIT_ENTRY));
+        for (i = 0; i < ClusterSize; i++)
+        {
+            ClusterOffset.QuadPart = Offset.QuadPart + ((ULONG_PTR)ClusterStart - (ULONG_PTR)PAddress) + i * PAGE_SIZE;
+            MmSetPageEntrySectionSegment(Segment, &ClusterOffset, MAKE_SWAP_SSE(MM_WAIT_ENTRY));
+            ClusterPages[i] = 0;
+        }
         MmUnlockSectionSegment(Segment);
-        MmCreatePageFileMapping(Process, PAddress, MM_WAIT_ENTRY);
+        for (i = 0; i < ClusterSize; i++)
+        {
+            ClusterAddress = (PVOID)((ULONG_PTR)ClusterStart + i * PAGE_SIZE);
+            MmCreatePageFileMapping(Process, ClusterAddress, MM_WAIT_ENTRY);
+        }
         MmUnlockAddressSpace(AddressSpace);
 
-        if ((Segment->Flags & MM_PAGEFILE_SEGMENT) ||
-                ((Offset.QuadPart >= (LONGLONG)PAGE_ROUND_UP(Segment->RawLength.QuadPart) &&
-                  (Section->AllocationAttributes & SEC_IMAGE))))
+        if (!ReadFromFile)
         {
             MI_SET_USAGE(MI_USAGE_SECTION);
             if (Process) MI_SET_PROCESS2(Process->ImageFileName);
@@ -1638,6 +1766,58 @@ MmNotPresentFaultSectionView(PMMSUPPORT AddressSpace,
                 DPRINT1("MiReadPage failed (Status %x)\n", Status);
             }
         }
+
+        /* Read the rest of the cluster, stopping at the first failure */
+        for (i = 0; i < ClusterSize; i++)
+        {
+            ClusterAddress = (PVOID)((ULONG_PTR)ClusterStart + i * PAGE_SIZE);
+            ClusterOffset.QuadPart = Offset.QuadPart + ((ULONG_PTR)ClusterAddress - (ULONG_PTR)PAddress);
+            if (ClusterAddress == PAddress)
+                continue;
+
+            if (!NT_SUCCESS(Status) ||
+                !NT_SUCCESS(MiReadPage(MemoryArea, ClusterOffset.QuadPart, &ClusterPages[i])))
+            {
+                ClusterPages[i] = 0;
+                break;
+            }
+        }
+
+        /* Lock both segment and process address space while we proceed. */
+        MmLockAddressSpace(AddressSpace);
+        MmLockSectionSegment(Segment);
+
+        /* Map the pages read around the faulting one, or forget about them */
+        for (i = 0; i < ClusterSize; i++)
+        {
+            ClusterAddress = (PVOID)((ULONG_PTR)ClusterStart + i * PAGE_SIZE);
+            ClusterOffset.QuadPart = Offset.QuadPart + ((ULONG_PTR)ClusterAddress - (ULONG_PTR)PAddress);
+            if (ClusterAddress == PAddress)
+                continue;
+
+            MmDeletePageFileMapping(Process, ClusterAddress, &FakeSwapEntry);
+            if (!ClusterPages[i])
+            {
+                MmSetPageEntrySectionSegment(Segment, &ClusterOffset, 0);
+                continue;
+            }
+
+            Status = MmCreateVirtualMapping(Process,
+                                            ClusterAddress,
+                                            Attributes,
+                                            &ClusterPages[i],
+                                            1);
+            if (!NT_SUCCESS(Status))
+            {
+                DPRINT1("Unable to create virtual mapping\n");
+                KeBugCheck(MEMORY_MANAGEMENT);
+            }
+            MmInsertRmap(ClusterPages[i], Process, ClusterAddress);
+            MmSetPageEntrySectionSegment(Segment, &ClusterOffset, MAKE_SSE(ClusterPages[i] << PAGE_SHIFT, 1));
+            Segment->PageFaults++;
+            Segment->ReadAroundPages++;
+        }
+
         if (!NT_SUCCESS(Status))
         {
             /*
@@ -1646,16 +1826,12 @@ MmNotPresentFaultSectionView(PMMSUPPORT AddressSpace,
             /*
              * Cleanup and release locks
              */
-            MmLockAddressSpace(AddressSpace);
+            MmUnlockSectionSegment(Segment);
             MiSetPageEvent(Process, Address);
             DPRINT("Address 0x%p\n", Address);
             return(Status);
         }
 
-        /* Lock both segment and process address space while we proceed. */
-        MmLockAddressSpace(AddressSpace);
-        MmLockSectionSegment(Segment);
-
         MmDeletePageFileMapping(Process, PAddress, &FakeSwapEntry);
         DPRINT("CreateVirtualMapping Page %x Process %p PAddress %p Attributes %x\n",
                Page, Process, PAddress, Attributes);
@@ -1675,6 +1851,7 @@ MmNotPresentFaultSectionView(PMMSUPPORT AddressSpace,
         /* Set this section offset has being backed by our new page. */
         Entry = MAKE_SSE(Page << PAGE_SHIFT, 1);
         MmSetPageEntrySectionSegment(Segment, &Offset, Entry);
+        if (ReadFromFile) Segment->PageFaults++;
         MmUnlockSectionSegment(Segment);
 
         MiSetPageEvent(Process, Address);
@@ -3065,6 +3242,8 @@ MmCreateDataFileSection(PROS_SECTION_OBJECT *SectionObject,
         }
         Segment->Image.VirtualAddress = 0;
         Segment->Locked = TRUE;
+        Segment->PageFaults = 0;
+        Segment->ReadAroundPages = 0;
         MiInitializeSectionPageTable(Segment);
     }
     else
@@ -160,6 +160,16 @@ typedef enum _FAST486_DBG_REGS
     FAST486_REG_DR7 = 5  // alias to DR5
 } FAST486_DBG_REGS, *PFAST486_DBG_REGS;
 
+typedef enum _FAST486_LAZY_OPERATION
+{
+    FAST486_LAZY_NONE,
+    FAST486_LAZY_ADD,   // ADD and ADC
+    FAST486_LAZY_SUB,   // SUB, SBB and CMP
+    FAST486_LAZY_INC,
+    FAST486_LAZY_DEC,
+    FAST486_LAZY_LOGIC  // AND, OR, XOR and TEST
+} FAST486_LAZY_OPERATION, *PFAST486_LAZY_OPERATION;
+
 typedef enum _FAST486_EXCEPTIONS
 {
     FAST486_EXCEPTION_DE = 0x00,
@@ -511,6 +521,22 @@ typedef union _FAST486_FPU_CONTROL_REG
     };
 } FAST486_FPU_CONTROL_REG, *PFAST486_FPU_CONTROL_REG;
 
+/*
+ * The arithmetic instructions don't compute CF, PF, AF, ZF, SF and OF right
+ * away, they only record their operands and result here. The flags are
+ * computed from them when something needs them. Carry is the carry (or
+ * borrow) in for ADD and SUB, and the preserved CF for INC and DEC.
+ */
+typedef struct _FAST486_LAZY_FLAGS
+{
+    FAST486_LAZY_OPERATION Operation;
+    ULONG FirstValue;
+    ULONG SecondValue;
+    ULONG Result;
+    ULONG SignFlag;
+    BOOLEAN Carry;
+} FAST486_LAZY_FLAGS, *PFAST486_LAZY_FLAGS;
+
 struct _FAST486_STATE
 {
     FAST486_MEM_READ_PROC MemReadCallback;
@@ -525,6 +551,7 @@ struct _FAST486_STATE
     FAST486_REG InstPtr, SavedInstPtr;
     FAST486_REG SavedStackPtr;
     FAST486_FLAGS_REG Flags;
+    FAST486_LAZY_FLAGS LazyFlags;
     FAST486_TABLE_REG Gdtr, Idtr;
     FAST486_LDT_REG Ldtr;
     FAST486_TASK_REG TaskReg;
@@ -619,6 +646,15 @@ VOID
 NTAPI
 Fast486Rewind(PFAST486_STATE State);
 
+/*
+ * Must be called before the host reads or changes CF, PF, AF, ZF, SF or OF
+ * in State->Flags. The BOP callback is entered with the flags already
+ * resolved; the other callbacks are not.
+ */
+VOID
+NTAPI
+Fast486UpdateFlags(PFAST486_STATE State);
+
 #endif // _FAST486_H_
 
 /* EOF */
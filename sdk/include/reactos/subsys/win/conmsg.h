@@ -111,6 +111,9 @@ typedef enum _CONSRV_API_NUMBER
     // ConsolepSetScreenBufferInfo,            // Added in Vista+
     // ConsolepClientConnect,                  // Added in Win7
 
+    ConsolepMapOutputRing,                  // ReactOS-specific
+    ConsolepFlushOutputRing,                // ReactOS-specific
+
     ConsolepMaxApiNumber
 } CONSRV_API_NUMBER, *PCONSRV_API_NUMBER;
 
@@ -231,6 +234,50 @@ typedef struct _CONSOLE_NOTIFYLASTCLOSE
 
 
 
+/*
+ * Shared memory ring through which a client process appends WriteConsole
+ * text without calling the server. The client owns WriteOffset, the server
+ * owns ReadOffset, both count bytes since the ring was created. Each write
+ * is a CONSOLE_OUTPUT_RECORD followed by its text, CONSOLE_OUTPUT_RING_ALIGN
+ * aligned; a record with a NULL OutputHandle means that the next record
+ * starts back at the beginning of the data.
+ */
+#define CONSOLE_OUTPUT_RING_SIZE        0x10000
+#define CONSOLE_OUTPUT_RING_ALIGN       16
+#define CONSOLE_OUTPUT_RING_MAX_WRITE   0x1000  // Bigger writes go through ConsolepWriteConsole
+
+#define CONSOLE_OUTPUT_RING_PAUSED      0x1     // Set by the server while the console is paused
+
+typedef struct _CONSOLE_OUTPUT_RECORD
+{
+    HANDLE  OutputHandle;
+    ULONG   NumBytes;
+    BOOLEAN Unicode;
+} CONSOLE_OUTPUT_RECORD, *PCONSOLE_OUTPUT_RECORD;
+
+C_ASSERT(sizeof(CONSOLE_OUTPUT_RECORD) <= CONSOLE_OUTPUT_RING_ALIGN);
+
+typedef struct _CONSOLE_OUTPUT_RING
+{
+    volatile ULONG WriteOffset;
+    volatile ULONG ReadOffset;
+    volatile ULONG Flags;
+    ULONG Reserved;
+    UCHAR Data[CONSOLE_OUTPUT_RING_SIZE];
+} CONSOLE_OUTPUT_RING, *PCONSOLE_OUTPUT_RING;
+
+typedef struct _CONSOLE_MAPOUTPUTRING
+{
+    HANDLE ConsoleHandle;
+    PCONSOLE_OUTPUT_RING Ring;  // Client view
+    HANDLE Event;               // Set by the client when it appends to an empty ring
+} CONSOLE_MAPOUTPUTRING, *PCONSOLE_MAPOUTPUTRING;
+
+typedef struct _CONSOLE_FLUSHOUTPUTRING
+{
+    HANDLE ConsoleHandle;
+} CONSOLE_FLUSHOUTPUTRING, *PCONSOLE_FLUSHOUTPUTRING;
+
 typedef struct _CONSOLE_WRITECONSOLE
 {
     HANDLE ConsoleHandle;
@@ -966,6 +1013,8 @@ typedef struct _CONSOLE_API_MESSAGE
 
         /* Write */
         CONSOLE_WRITECONSOLE WriteConsoleRequest;       // SrvWriteConsole / WriteConsole
+        CONSOLE_MAPOUTPUTRING MapOutputRingRequest;
+        CONSOLE_FLUSHOUTPUTRING FlushOutputRingRequest;
         CONSOLE_WRITEINPUT WriteInputRequest;
         CONSOLE_WRITEOUTPUT WriteOutputRequest;
         CONSOLE_WRITEOUTPUTCODE WriteOutputCodeRequest;
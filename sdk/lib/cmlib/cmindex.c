@@ -24,6 +24,9 @@
     ((HBLOCK_SIZE - (sizeof(HBIN) + sizeof(HCELL) +     \
                      FIELD_OFFSET(CM_KEY_INDEX, List))) / sizeof(HCELL_INDEX) - 1)
 
+#define CmpIndexHintSlot(HashKey, Bits)                 \
+    (((ULONG)(HashKey) * 2654435761U) >> (32 - (Bits)))
+
 /* FUNCTIONS *****************************************************************/
 
 LONG
@@ -113,10 +116,11 @@ CmpCompareInIndex(IN PHHIVE Hive,
                 /* Get one char from each buffer */
                 p = SearchName->Buffer[i];
                 pp = FastEntry->NameHint[i];
+                if (p == pp) continue;
 
                 /* See if they match and return result if they don't */
-                Result = (LONG)RtlUpcaseUnicodeChar(p) -
-                         (LONG)RtlUpcaseUnicodeChar(pp);
+                Result = (LONG)CmpUpcaseChar(p) -
+                         (LONG)CmpUpcaseChar(pp);
                 if (Result) return (Result > 0) ? 1 : -1;
             }
         }
@@ -645,17 +649,15 @@ static HCELL_INDEX
 NTAPI
 CmpFindSubKeyByHash(IN PHHIVE Hive,
                     IN PCM_KEY_FAST_INDEX FastIndex,
-                    IN PCUNICODE_STRING SearchName)
+                    IN PCUNICODE_STRING SearchName,
+                    IN ULONG HashKey)
 {
-    ULONG HashKey, i;
+    ULONG i;
     PCM_INDEX FastEntry;
 
     /* Make sure it's really a hash */
     ASSERT(FastIndex->Signature == CM_KEY_HASH_LEAF);
 
-    /* Compute the hash key for the name */
-    HashKey = CmpComputeHashKey(0, SearchName, FALSE);
-
     /* Loop all the entries */
     for (i = 0; i < FastIndex->Count; i++)
     {
@@ -688,6 +690,8 @@ CmpFindSubKeyByName(IN PHHIVE Hive,
     PCM_KEY_INDEX IndexRoot;
     HCELL_INDEX SubKey, CellToRelease;
     ULONG Found;
+    ULONG HashKey = 0;
+    BOOLEAN Hashed = FALSE;
 
     /* Loop each storage type */
     for (i = 0; i < Hive->StorageTypeCount; i++)
@@ -747,10 +751,18 @@ CmpFindSubKeyByName(IN PHHIVE Hive,
             }
             else
             {
+                /* Compute the hash key for the name, once for all the leaves */
+                if (!Hashed)
+                {
+                    HashKey = CmpComputeHashKey(0, SearchName, FALSE);
+                    Hashed = TRUE;
+                }
+
                 /* Find the subkey in the hash */
                 SubKey = CmpFindSubKeyByHash(Hive,
                                              (PCM_KEY_FAST_INDEX)IndexRoot,
-                                             SearchName);
+                                             SearchName,
+                                             HashKey);
 
                 /* Release the previous cell */
                 ASSERT(CellToRelease != HCELL_NIL);
@@ -766,6 +778,206 @@ CmpFindSubKeyByName(IN PHHIVE Hive,
     return HCELL_NIL;
 }
 
+static ULONG
+CmpComputeNodeHashKey(IN PCM_KEY_NODE Node)
+{
+    UNICODE_STRING KeyName;
+    PUCHAR Name;
+    ULONG Hash = 0, i;
+
+    /* Check if it's compressed */
+    if (!(Node->Flags & KEY_COMP_NAME))
+    {
+        /* Hash the Unicode name directly */
+        KeyName.Buffer = Node->Name;
+        KeyName.Length = Node->NameLength;
+        KeyName.MaximumLength = KeyName.Length;
+        return CmpComputeHashKey(0, &KeyName, FALSE);
+    }
+
+    /* Same hash as CmpComputeHashKey(), one byte per character */
+    Name = (PUCHAR)Node->Name;
+    for (i = 0; i < Node->NameLength; i++)
+    {
+        Hash *= 37;
+        Hash += CmpUpcaseChar((WCHAR)Name[i]);
+    }
+
+    return Hash;
+}
+
+static BOOLEAN
+CmpAddLeafToIndexHint(IN PHHIVE Hive,
+                      IN PCM_INDEX_HINT_BLOCK IndexHint,
+                      IN PCM_KEY_INDEX Leaf,
+                      IN OUT PULONG Added)
+{
+    PCM_KEY_FAST_INDEX FastIndex = (PCM_KEY_FAST_INDEX)Leaf;
+    ULONG Mask = (1 << IndexHint->TableBits) - 1;
+    HCELL_INDEX Cell;
+    PCM_KEY_NODE Node;
+    ULONG HashKey, Slot, i;
+
+    /* Make sure the leaf is valid */
+    if ((Leaf->Signature != CM_KEY_INDEX_LEAF) &&
+        (Leaf->Signature != CM_KEY_FAST_LEAF) &&
+        (Leaf->Signature != CM_KEY_HASH_LEAF))
+    {
+        return FALSE;
+    }
+
+    for (i = 0; i < Leaf->Count; i++)
+    {
+        /* Don't trust the index beyond the subkey counts of the node */
+        if (*Added == IndexHint->Count) return FALSE;
+
+        if (Leaf->Signature == CM_KEY_HASH_LEAF)
+        {
+            /* The hash is already there */
+            Cell = FastIndex->List[i].Cell;
+            HashKey = FastIndex->List[i].HashKey;
+        }
+        else
+        {
+            /* Compute it from the name of the key */
+            Cell = (Leaf->Signature == CM_KEY_FAST_LEAF) ?
+                   FastIndex->List[i].Cell : Leaf->List[i];
+            Node = (PCM_KEY_NODE)HvGetCell(Hive, Cell);
+            if (!Node) return FALSE;
+            HashKey = CmpComputeNodeHashKey(Node);
+            HvReleaseCell(Hive, Cell);
+        }
+
+        /* Find a free slot */
+        Slot = CmpIndexHintSlot(HashKey, IndexHint->TableBits);
+        while (IndexHint->Table[Slot].Cell != HCELL_NIL) Slot = (Slot + 1) & Mask;
+
+        IndexHint->Table[Slot].HashKey = HashKey;
+        IndexHint->Table[Slot].Cell = Cell;
+        (*Added)++;
+    }
+
+    return TRUE;
+}
+
+PCM_INDEX_HINT_BLOCK
+NTAPI
+CmpCreateIndexHint(IN PHHIVE Hive,
+                   IN PCM_KEY_NODE Node)
+{
+    PCM_INDEX_HINT_BLOCK IndexHint;
+    PCM_KEY_INDEX IndexRoot, Leaf;
+    HCELL_INDEX LeafCell;
+    ULONG Count, Bits, Added = 0, i, Type;
+    BOOLEAN Success = TRUE;
+
+    /* Count the subkeys */
+    Count = 0;
+    for (Type = 0; Type < Hive->StorageTypeCount; Type++)
+    {
+        Count += Node->SubKeyCounts[Type];
+    }
+
+    /* Keep the table at most half full, so that lookups stay short */
+    for (Bits = 1; (1UL << Bits) < 2 * Count; Bits++);
+
+    IndexHint = CmpAllocate(FIELD_OFFSET(CM_INDEX_HINT_BLOCK, Table) +
+                            (sizeof(CM_INDEX_HINT_ENTRY) << Bits),
+                            TRUE,
+                            TAG_CM);
+    if (!IndexHint) return NULL;
+
+    IndexHint->Count = Count;
+    IndexHint->TableBits = Bits;
+    for (i = 0; i < (1UL << Bits); i++)
+    {
+        IndexHint->Table[i].Cell = HCELL_NIL;
+    }
+
+    /* Loop each storage type */
+    for (Type = 0; Success && (Type < Hive->StorageTypeCount); Type++)
+    {
+        /* Make sure the node has subkeys of this type */
+        if (!Node->SubKeyCounts[Type]) continue;
+
+        /* Get the Index */
+        IndexRoot = (PCM_KEY_INDEX)HvGetCell(Hive, Node->SubKeyLists[Type]);
+        if (!IndexRoot)
+        {
+            Success = FALSE;
+            break;
+        }
+
+        /* Check if this is an index root */
+        if (IndexRoot->Signature == CM_KEY_INDEX_ROOT)
+        {
+            /* Add all of its leaves */
+            for (i = 0; Success && (i < IndexRoot->Count); i++)
+            {
+                LeafCell = IndexRoot->List[i];
+                Leaf = (PCM_KEY_INDEX)HvGetCell(Hive, LeafCell);
+                if (!Leaf)
+                {
+                    Success = FALSE;
+                    break;
+                }
+
+                Success = CmpAddLeafToIndexHint(Hive, IndexHint, Leaf, &Added);
+                HvReleaseCell(Hive, LeafCell);
+            }
+        }
+        else
+        {
+            /* The index is the leaf itself */
+            Success = CmpAddLeafToIndexHint(Hive, IndexHint, IndexRoot, &Added);
+        }
+
+        HvReleaseCell(Hive, Node->SubKeyLists[Type]);
+    }
+
+    /* Make sure we got all the subkeys */
+    if (!Success || (Added != Count))
+    {
+        CmpFree(IndexHint, 0);
+        return NULL;
+    }
+
+    return IndexHint;
+}
+
+HCELL_INDEX
+NTAPI
+CmpFindSubKeyInIndexHint(IN PHHIVE Hive,
+                         IN PCM_INDEX_HINT_BLOCK IndexHint,
+                         IN PCUNICODE_STRING SearchName)
+{
+    ULONG Mask = (1 << IndexHint->TableBits) - 1;
+    PCM_INDEX_HINT_ENTRY Entry;
+    ULONG HashKey, Slot;
+
+    /* Compute the hash key for the name */
+    HashKey = CmpComputeHashKey(0, SearchName, FALSE);
+
+    /* Loop the entries until a free slot */
+    for (Slot = CmpIndexHintSlot(HashKey, IndexHint->TableBits);
+         IndexHint->Table[Slot].Cell != HCELL_NIL;
+         Slot = (Slot + 1) & Mask)
+    {
+        Entry = &IndexHint->Table[Slot];
+
+        /* Compare the hash first, then go ahead for a full compare */
+        if ((Entry->HashKey == HashKey) &&
+            !CmpDoCompareKeyName(Hive, SearchName, Entry->Cell))
+        {
+            /* It matched, return the cell */
+            return Entry->Cell;
+        }
+    }
+
+    /* If we got here then we failed */
+    return HCELL_NIL;
+}
+
 BOOLEAN
 NTAPI
 CmpMarkIndexDirty(IN PHHIVE Hive,
@@ -308,6 +308,23 @@ typedef struct _HV_TRACK_CELL_REF
     USHORT StaticCount;
 } HV_TRACK_CELL_REF, *PHV_TRACK_CELL_REF;
 
+//
+// Index Hint Block: the name hash and cell of every subkey of a key,
+// in an open-addressed table indexed by the hash
+//
+typedef struct _CM_INDEX_HINT_ENTRY
+{
+    ULONG HashKey;
+    HCELL_INDEX Cell;
+} CM_INDEX_HINT_ENTRY, *PCM_INDEX_HINT_ENTRY;
+
+typedef struct _CM_INDEX_HINT_BLOCK
+{
+    ULONG Count;
+    ULONG TableBits;
+    CM_INDEX_HINT_ENTRY Table[ANYSIZE_ARRAY];
+} CM_INDEX_HINT_BLOCK, *PCM_INDEX_HINT_BLOCK;
+
 extern ULONG CmlibTraceLevel;
 
 //
@@ -360,6 +377,18 @@ CmpIsKeyValueBig(IN PHHIVE Hive,
     return FALSE;
 }
 
+//
+// Upcases a name character, without going through the tables for ASCII
+//
+static inline
+WCHAR
+CmpUpcaseChar(IN WCHAR Char)
+{
+    if (Char < L'a') return Char;
+    if (Char <= L'z') return Char - L'a' + L'A';
+    return RtlUpcaseUnicodeChar(Char);
+}
+
 /*
  * Public Hive functions.
  */
@@ -523,6 +552,21 @@ CmpComputeHashKey(
     IN BOOLEAN AllowSeparators
 );
 
+PCM_INDEX_HINT_BLOCK
+NTAPI
+CmpCreateIndexHint(
+    IN PHHIVE Hive,
+    IN PCM_KEY_NODE Node
+);
+
+HCELL_INDEX
+NTAPI
+CmpFindSubKeyInIndexHint(
+    IN PHHIVE Hive,
+    IN PCM_INDEX_HINT_BLOCK IndexHint,
+    IN PCUNICODE_STRING SearchName
+);
+
 BOOLEAN
 NTAPI
 CmpAddSubKey(
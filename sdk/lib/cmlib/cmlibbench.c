@@ -0,0 +1,382 @@
+/*
+ * PROJECT:     ReactOS Registry Library
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Host benchmark for subkey lookups in keys with many subkeys
+ *
+ * Usage: cmlibbench [-n:subkeys] [-r:rounds]
+ *
+ * A volatile hive gets one key with CLSID-like subkeys, once with fast leaves
+ * (version 3 hives) and once with hash leaves (version 5 hives). Every subkey
+ * and as many missing names are then looked up through the index, and through
+ * the index hint the kernel keeps in the KCB. Both must agree on every name.
+ */
+
+/* INCLUDES *******************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <time.h>
+
+/* gcc defaults to cdecl */
+#if defined(__GNUC__)
+#undef __cdecl
+#define __cdecl
+#endif
+
+#include <typedefs.h>
+
+unsigned char BitScanForward(ULONG * Index, unsigned long Mask);
+unsigned char BitScanReverse(ULONG * const Index, unsigned long Mask);
+#define RtlFillMemoryUlong(dst, len, val) memset(dst, val, len)
+
+#ifdef _M_AMD64
+#define BitScanForward64 _BitScanForward64
+#define BitScanReverse64 _BitScanReverse64
+#endif
+
+WCHAR NTAPI
+RtlUpcaseUnicodeChar(
+    IN WCHAR Source);
+
+#include <cmlib.h>
+#include <bitmap.c>
+
+/* DEFINES ********************************************************************/
+
+#define BENCH_NAME_LENGTH   38
+
+typedef struct _BENCH_NAME
+{
+    UNICODE_STRING Name;
+    WCHAR Buffer[BENCH_NAME_LENGTH];
+} BENCH_NAME, *PBENCH_NAME;
+
+/* RUNTIME ********************************************************************/
+
+VOID NTAPI
+RtlInitUnicodeString(
+    IN OUT PUNICODE_STRING DestinationString,
+    IN PCWSTR SourceString)
+{
+    SIZE_T Length = 0;
+
+    if (SourceString)
+    {
+        while (SourceString[Length])
+            Length++;
+    }
+
+    DestinationString->Length = (USHORT)(Length * sizeof(WCHAR));
+    DestinationString->MaximumLength = DestinationString->Length + (SourceString ? sizeof(WCHAR) : 0);
+    DestinationString->Buffer = (PWCHAR)SourceString;
+}
+
+LONG NTAPI
+RtlCompareUnicodeString(
+    IN PCUNICODE_STRING String1,
+    IN PCUNICODE_STRING String2,
+    IN BOOLEAN CaseInSensitive)
+{
+    USHORT i, Length;
+    WCHAR c1, c2;
+
+    Length = min(String1->Length, String2->Length) / sizeof(WCHAR);
+    for (i = 0; i < Length; i++)
+    {
+        c1 = String1->Buffer[i];
+        c2 = String2->Buffer[i];
+        if (CaseInSensitive)
+        {
+            c1 = RtlUpcaseUnicodeChar(c1);
+            c2 = RtlUpcaseUnicodeChar(c2);
+        }
+
+        if (c1 != c2)
+            return (LONG)c1 - (LONG)c2;
+    }
+
+    return (LONG)String1->Length - (LONG)String2->Length;
+}
+
+WCHAR NTAPI
+RtlUpcaseUnicodeChar(
+    IN WCHAR Source)
+{
+    if (Source < 'a')
+        return Source;
+
+    if (Source <= 'z')
+        return (Source - ('a' - 'A'));
+
+    return Source;
+}
+
+VOID NTAPI
+KeQuerySystemTime(
+    OUT PLARGE_INTEGER CurrentTime)
+{
+    CurrentTime->QuadPart = 0;
+}
+
+ULONG
+__cdecl
+DbgPrint(
+    IN CHAR *Format,
+    IN ...)
+{
+    va_list ap;
+    va_start(ap, Format);
+    vprintf(Format, ap);
+    va_end(ap);
+
+    return 0;
+}
+
+VOID
+NTAPI
+RtlAssert(IN PVOID FailedAssertion,
+          IN PVOID FileName,
+          IN ULONG LineNumber,
+          IN PCHAR Message OPTIONAL)
+{
+    DbgPrint("Assertion \'%s\' failed at %s line %u\n",
+             (PCHAR)FailedAssertion,
+             (PCHAR)FileName,
+             LineNumber);
+    abort();
+}
+
+VOID
+NTAPI
+KeBugCheckEx(
+    IN ULONG BugCheckCode,
+    IN ULONG_PTR BugCheckParameter1,
+    IN ULONG_PTR BugCheckParameter2,
+    IN ULONG_PTR BugCheckParameter3,
+    IN ULONG_PTR BugCheckParameter4)
+{
+    printf("*** STOP: 0x%08X\n", BugCheckCode);
+    abort();
+}
+
+unsigned char BitScanForward(ULONG * Index, unsigned long Mask)
+{
+    *Index = 0;
+    while (Mask && ((Mask & 1) == 0))
+    {
+        Mask >>= 1;
+        ++(*Index);
+    }
+    return Mask ? 1 : 0;
+}
+
+unsigned char BitScanReverse(ULONG * const Index, unsigned long Mask)
+{
+    *Index = 0;
+    while (Mask && ((Mask & (1 << 31)) == 0))
+    {
+        Mask <<= 1;
+        ++(*Index);
+    }
+    return Mask ? 1 : 0;
+}
+
+PVOID
+NTAPI
+CmpAllocate(
+    IN SIZE_T Size,
+    IN BOOLEAN Paged,
+    IN ULONG Tag)
+{
+    return malloc(Size);
+}
+
+VOID
+NTAPI
+CmpFree(
+    IN PVOID Ptr,
+    IN ULONG Quota)
+{
+    free(Ptr);
+}
+
+/* FUNCTIONS ******************************************************************/
+
+static VOID
+MakeName(PBENCH_NAME Name, ULONG Seed)
+{
+    char Buffer[BENCH_NAME_LENGTH + 1];
+    ULONG Hash = Seed * 2654435761U;
+    ULONG i;
+
+    /* Mixed case, like CLSIDs written by different installers */
+    sprintf(Buffer, (Seed & 2) ? "{%08X-%04X-11D0-%04x-00A0C9%06X}" : "{%08x-%04x-11d0-%04X-00a0c9%06x}",
+            Hash, Seed & 0xFFFF, (Hash >> 7) & 0xFFFF, Seed);
+
+    for (i = 0; i < BENCH_NAME_LENGTH; i++)
+        Name->Buffer[i] = (WCHAR)(UCHAR)Buffer[i];
+    Name->Name.Buffer = Name->Buffer;
+    Name->Name.Length = Name->Name.MaximumLength = sizeof(Name->Buffer);
+}
+
+static HCELL_INDEX
+CreateKey(PHHIVE Hive, HCELL_INDEX Parent, PUNICODE_STRING Name)
+{
+    PCM_KEY_NODE Node;
+    HCELL_INDEX Cell;
+
+    Cell = HvAllocateCell(Hive, FIELD_OFFSET(CM_KEY_NODE, Name) + CmpNameSize(Hive, Name), Volatile, HCELL_NIL);
+    if (Cell == HCELL_NIL)
+        return HCELL_NIL;
+
+    Node = (PCM_KEY_NODE)HvGetCell(Hive, Cell);
+    RtlZeroMemory(Node, sizeof(*Node));
+    Node->Signature = CM_KEY_NODE_SIGNATURE;
+    Node->Parent = Parent;
+    Node->SubKeyLists[Stable] = Node->SubKeyLists[Volatile] = HCELL_NIL;
+    Node->ValueList.List = HCELL_NIL;
+    Node->Security = Node->Class = HCELL_NIL;
+    Node->NameLength = CmpCopyName(Hive, Node->Name, Name);
+    if (Node->NameLength < Name->Length) Node->Flags |= KEY_COMP_NAME;
+    HvReleaseCell(Hive, Cell);
+
+    if (!CmpAddSubKey(Hive, Parent, Cell))
+        return HCELL_NIL;
+
+    return Cell;
+}
+
+static double
+Nanoseconds(clock_t Start, ULONG Lookups)
+{
+    return (double)(clock() - Start) * 1e9 / CLOCKS_PER_SEC / Lookups;
+}
+
+static int
+BenchHive(USHORT Version, PBENCH_NAME Names, ULONG Count, ULONG Rounds)
+{
+    HHIVE Hive;
+    PCM_KEY_NODE Node;
+    PCM_INDEX_HINT_BLOCK IndexHint;
+    HCELL_INDEX Root, Key, Cell;
+    UNICODE_STRING KeyName;
+    ULONG i, r, Errors = 0;
+    clock_t Start;
+    double Index, Hint, Build;
+
+    if (!NT_SUCCESS(HvInitialize(&Hive, HINIT_CREATE, HIVE_VOLATILE, HFILE_TYPE_PRIMARY, 0,
+                                 CmpAllocate, CmpFree, NULL, NULL, NULL, NULL, 1, NULL)))
+    {
+        printf("Cannot create the hive\n");
+        return 1;
+    }
+    Hive.Version = Version;
+
+    RtlInitUnicodeString(&KeyName, L"CLSID");
+    if (!CmCreateRootNode(&Hive, L"BENCH") ||
+        (Root = Hive.BaseBlock->RootCell, Key = CreateKey(&Hive, Root, &KeyName)) == HCELL_NIL)
+    {
+        printf("Cannot create the key\n");
+        return 1;
+    }
+
+    /* The even names exist, the odd ones are looked up but missing */
+    for (i = 0; i < 2 * Count; i += 2)
+    {
+        if (CreateKey(&Hive, Key, &Names[i].Name) == HCELL_NIL)
+        {
+            printf("Cannot create subkey %u\n", (unsigned)i / 2);
+            return 1;
+        }
+    }
+
+    Node = (PCM_KEY_NODE)HvGetCell(&Hive, Key);
+
+    Start = clock();
+    for (r = 0; r < Rounds; r++)
+    {
+        IndexHint = CmpCreateIndexHint(&Hive, Node);
+        if (!IndexHint)
+        {
+            printf("Cannot create the index hint\n");
+            return 1;
+        }
+        CmpFree(IndexHint, 0);
+    }
+    Build = (double)(clock() - Start) * 1e3 / CLOCKS_PER_SEC / Rounds;
+    IndexHint = CmpCreateIndexHint(&Hive, Node);
+
+    /* Make sure both ways find the same subkeys */
+    for (i = 0; i < 2 * Count; i++)
+    {
+        Cell = CmpFindSubKeyByName(&Hive, Node, &Names[i].Name);
+        if (((Cell == HCELL_NIL) != (i & 1)) ||
+            (Cell != CmpFindSubKeyInIndexHint(&Hive, IndexHint, &Names[i].Name)))
+        {
+            Errors++;
+        }
+    }
+
+    Start = clock();
+    for (r = 0; r < Rounds; r++)
+    {
+        for (i = 0; i < 2 * Count; i++)
+            CmpFindSubKeyByName(&Hive, Node, &Names[i].Name);
+    }
+    Index = Nanoseconds(Start, Rounds * 2 * Count);
+
+    Start = clock();
+    for (r = 0; r < Rounds; r++)
+    {
+        for (i = 0; i < 2 * Count; i++)
+            CmpFindSubKeyInIndexHint(&Hive, IndexHint, &Names[i].Name);
+    }
+    Hint = Nanoseconds(Start, Rounds * 2 * Count);
+
+    printf("%s leaves, %u subkeys: index %.0f ns, hint %.0f ns per lookup, hint built in %.2f ms%s\n",
+           (Version >= 5) ? "hash" : "fast", (unsigned)Count, Index, Hint, Build,
+           Errors ? ", MISMATCHES" : "");
+
+    CmpFree(IndexHint, 0);
+    HvReleaseCell(&Hive, Key);
+    HvFree(&Hive);
+    return Errors ? 2 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    PBENCH_NAME Names;
+    ULONG Count = 20000, Rounds = 20, i;
+    int Result;
+
+    for (i = 1; i < (ULONG)argc; i++)
+    {
+        if (!strncmp(argv[i], "-n:", 3))
+            Count = strtoul(argv[i] + 3, NULL, 0);
+        else if (!strncmp(argv[i], "-r:", 3))
+            Rounds = strtoul(argv[i] + 3, NULL, 0);
+        else
+        {
+            printf("Usage: %s [-n:subkeys] [-r:rounds]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (!Count || !Rounds)
+        return 1;
+
+    Names = malloc(2 * Count * sizeof(BENCH_NAME));
+    if (!Names)
+        return 1;
+    for (i = 0; i < 2 * Count; i++)
+        MakeName(&Names[i], i);
+
+    Result = BenchHive(HSYS_MINOR, Names, Count, Rounds);
+    if (!Result)
+        Result = BenchHive(HSYS_WHISTLER, Names, Count, Rounds);
+
+    free(Names);
+    return Result;
+}
+
+/* EOF */
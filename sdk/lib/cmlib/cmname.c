@@ -130,8 +130,8 @@ CmpCompareCompressedName(IN PCUNICODE_STRING SearchName,
         if (chr1 != chr2)
         {
             /* See if they match and return result if they don't */
-            Result = (LONG)RtlUpcaseUnicodeChar(chr1) -
-                     (LONG)RtlUpcaseUnicodeChar(chr2);
+            Result = (LONG)CmpUpcaseChar(chr1) -
+                     (LONG)CmpUpcaseChar(chr2);
             if (Result) return Result;
         }
 
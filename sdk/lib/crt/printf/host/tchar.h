@@ -0,0 +1,19 @@
+/*
+ * PROJECT:     ReactOS crt library
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Minimal tchar.h for building streamout as a host tool
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+
+typedef char TCHAR;
+
+#define _T(x) x
+#define _TEOF EOF
+#define _tcslen strlen
+#define _tcscpy strcpy
+
+/* EOF */
@@ -0,0 +1,455 @@
+/*
+ * PROJECT:     ReactOS crt library
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Host conformance and throughput tests for streamout
+ *
+ * Usage: printfbench [-n:random cases] [-r:rounds]
+ *
+ * streamout is built the way the kernel mode CRT uses it and writes into
+ * string streams. The fixed cases hold what the crt printed before it got
+ * a span buffer and exact float digits; where that was wrong they hold what
+ * msvcrt prints. Random numbers are then checked against the host printf,
+ * which agrees with us as long as no more than 17 significant digits are
+ * asked for and the value is no exact tie, and every %.16e has to read back
+ * as the same double. Last comes the time per call, ours and the host's.
+ */
+
+/* INCLUDES *******************************************************************/
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <wchar.h>
+#include <time.h>
+
+/* gcc defaults to cdecl */
+#if defined(__GNUC__)
+#undef __cdecl
+#define __cdecl
+#define __declspec(x) __attribute__((x))
+#endif
+#define __int64 long long
+
+/* The parts of the CRT's FILE that streamout looks at */
+typedef struct _CRTFILE
+{
+    char *_ptr;
+    int _cnt;
+    char *_base;
+    int _flag;
+} CRTFILE;
+
+#define _IOWRT  0x0002
+#define _IOSTRG 0x0040
+
+#define FILE CRTFILE
+#include "streamout.c"
+#undef FILE
+#undef MB_CUR_MAX
+
+#include <stdlib.h>
+
+/* DEFINES ********************************************************************/
+
+static unsigned long Failures;
+static unsigned long Checks;
+
+/* FUNCTIONS ******************************************************************/
+
+static int
+CrtVsnprintf(char *Buffer, size_t Size, const char *Format, va_list Args)
+{
+    CRTFILE Stream;
+    int Result;
+
+    Stream._base = Buffer;
+    Stream._ptr = Buffer;
+    Stream._cnt = (int)Size;
+    Stream._flag = _IOSTRG | _IOWRT;
+
+    Result = streamout(&Stream, Format, Args);
+
+    /* Only zero terminate if there is enough space left */
+    if (Buffer && Stream._cnt > 0)
+        *Stream._ptr = '\0';
+
+    return Result;
+}
+
+static int
+CrtSnprintf(char *Buffer, size_t Size, const char *Format, ...)
+{
+    va_list Args;
+    int Result;
+
+    va_start(Args, Format);
+    Result = CrtVsnprintf(Buffer, Size, Format, Args);
+    va_end(Args);
+
+    return Result;
+}
+
+static void
+Check(int Line, const char *Expected, const char *Format, ...)
+{
+    char Buffer[1024];
+    va_list Args, Args2;
+    int Result, Count;
+
+    va_start(Args, Format);
+    va_copy(Args2, Args);
+    Result = CrtVsnprintf(Buffer, sizeof(Buffer), Format, Args);
+    Count = CrtVsnprintf(NULL, 0, Format, Args2);
+    va_end(Args2);
+    va_end(Args);
+
+    Checks++;
+    if (Result != (int)strlen(Expected) || Count != Result || strcmp(Buffer, Expected))
+    {
+        printf("line %d: \"%s\" gave \"%s\" (%d, counted %d), expected \"%s\"\n",
+               Line, Format, Buffer, Result, Count, Expected);
+        Failures++;
+    }
+}
+
+#define CHECK(Expected, ...) Check(__LINE__, Expected, __VA_ARGS__)
+
+static void
+TestIntegers(void)
+{
+    int Count;
+
+    CHECK("0", "%d", 0);
+    CHECK("7 -7 +7  7", "%d %i %+d % d", 7, -7, 7, 7);
+    CHECK("2147483647 -2147483648", "%d %d", 2147483647, (int)0x80000000);
+    CHECK("4294967295", "%u", 0xFFFFFFFF);
+    CHECK("9223372036854775807", "%I64d", 0x7FFFFFFFFFFFFFFFLL);
+    CHECK("-9223372036854775808", "%lld", (long long)0x8000000000000000ULL);
+    CHECK("18446744073709551615", "%I64u", 0xFFFFFFFFFFFFFFFFULL);
+    CHECK("4294967296 99 100 1000000000000", "%I64u %I64u %I64u %I64u",
+          0x100000000ULL, 99ULL, 100ULL, 1000000000000ULL);
+    CHECK("ff FF 0xff 0XFF", "%x %X %#x %#X", 255, 255, 255, 255);
+    CHECK("17 017 0", "%o %#o %o", 15, 15, 0);
+    CHECK("ffffffffffffffff", "%I64x", 0xFFFFFFFFFFFFFFFFULL);
+    CHECK("1777777777777777777777", "%I64o", 0xFFFFFFFFFFFFFFFFULL);
+    CHECK("-32768 65535", "%hd %hu", 0x18000, 0xFFFF);
+    CHECK("[   42] [42   ] [00042] [-0042] [  -42]", "[%5d] [%-5d] [%05d] [%05d] [%5d]", 42, 42, 42, -42, -42);
+    CHECK("[  00042] [00042  ] [] []", "[%7.5d] [%-7.5d] [%.0d] [%.0o]", 42, 42, 0, 0);
+    CHECK("[  -42] [+0042]", "[%*d] [%+.*d]", 5, -42, 4, 42);
+    CHECK("[42   ]", "[%*d]", -5, 42);
+    CHECK("abc12345", "abc%n%d", &Count, 12345);
+    if (Count != 3) { printf("%%n stored %d\n", Count); Failures++; }
+    CHECK("100% done", "%d%% done", 100);
+}
+
+static void
+TestStrings(void)
+{
+    static const struct { unsigned short Length, MaximumLength; const char *Buffer; } Nt = { 5, 6, "Hello!" };
+    static const wchar_t Wide[] = L"wide";
+
+    CHECK("", "");
+    CHECK("plain text without any specifications, longer than one span of output characters, "
+          "so that it has to be written out in more than one piece along the way",
+          "plain text without any specifications, longer than one span of output characters, "
+          "so that it has to be written out in more than one piece along the way");
+    CHECK("[abc] [  abc] [abc  ] [ab]", "[%s] [%5s] [%-5s] [%.2s]", "abc", "abc", "abc", "abc");
+    CHECK("(null) (nu", "%s %.3s", (char*)NULL, (char*)NULL);
+    CHECK("x [  y] [z  ]", "%c [%3c] [%-3c]", 'x', 'y', 'z');
+    CHECK("wide w", "%S %C", Wide, L'w');
+    CHECK("wide [  wi]", "%ls [%4.2ls]", Wide, Wide);
+    CHECK("Hello", "%Z", &Nt);
+    CHECK("[00abc]", "[%05s]", "abc");
+    CHECK("y", "%y%");
+}
+
+static void
+TestFloats(void)
+{
+    double Zero = 0.0;
+    double Inf = 1.0 / Zero;
+    double NaN = Zero / Zero;
+    char Large[320];
+
+    CHECK("0.000000 1.000000 -1.500000", "%f %f %f", 0.0, 1.0, -1.5);
+    CHECK("3.141593 3.14159 3.141593e+000", "%f %g %e", 3.14159265358979, 3.14159265358979, 3.14159265358979);
+    CHECK("0.1 0.100000 1.000000e-001", "%g %f %e", 0.1, 0.1, 0.1);
+    CHECK("123.456 123.456000 1.234560E+002", "%G %f %E", 123.456, 123.456, 123.456);
+    CHECK("0.13 2.67 1.00 3", "%.2f %.2f %.2f %.0f", 0.125, 2.675, 1.005, 2.5);
+    CHECK("1 0 10.0 100", "%.0f %.0f %.1f %.0f", 0.6, 0.4, 9.96, 99.5);
+    CHECK("0.000010 0.000 0.001", "%f %.3f %.3f", 1e-5, 0.0004, 0.0005);
+    CHECK("1e+010 1e-005 0.0001 100000 1e+006", "%g %g %g %g %g", 1e10, 1e-5, 1e-4, 1e5, 1e6);
+    CHECK("123457 1.23457e+006 1.5 0", "%g %g %g %g", 123456.7, 1234567.0, 1.5, 0.0);
+    CHECK("123.457 1.00000 1.e+010", "%g %#g %#.0e", 123.456789, 1.0, 1e10);
+    CHECK("1 2. 1.e+000", "%.0f %#.0f %#.0e", 1.0, 2.0, 1.0);
+    CHECK("1.797693e+308 2.225074e-308 4.940656e-324", "%e %e %e", 1.7976931348623157e308, 2.2250738585072014e-308, 4.9406564584124654e-324);
+    CHECK("1.7976931348623157e+308", "%.16e", 1.7976931348623157e308);
+    CHECK("0.10000000000000001000 0.3333333333333333100", "%.20f %.19f", 0.1, 1.0 / 3);
+    CHECK("[    -2.50] [-2.50    ] [-00002.50] [   +2.50] [    2.50]", "[%9.2f] [%-9.2f] [%09.2f] [%+8.2f] [% 8.2f]", -2.5, -2.5, -2.5, 2.5, 2.5);
+    CHECK("1.#INF -1.#INF 1.#QNAN 1#INF", "%f %f %f %.0f", Inf, -Inf, NaN, Inf);
+    CHECK("1.#INF 1.#QNAN [  1.#INF]", "%e %g [%8G]", Inf, NaN, Inf);
+    CHECK("9.9999999999999995e-008 1e+100 1e-100", "%.16e %g %g", 1e-7, 1e100, 1e-100);
+    CHECK("18446744073709552000.000000", "%f", 18446744073709551616.0);
+
+    /* Only the first 17 digits of DBL_MAX are printed */
+    memset(Large, '0', 309);
+    memcpy(Large, "17976931348623157", 17);
+    strcpy(Large + 309, ".000000");
+    CHECK(Large, "%f", 1.7976931348623157e308);
+}
+
+static void
+TestSizes(void)
+{
+    char Buffer[16];
+    int Result;
+
+    /* Too small buffers get what fits and -1 */
+    memset(Buffer, 'x', sizeof(Buffer));
+    Result = CrtSnprintf(Buffer, 5, "%d%s", 12345678, "abc");
+    Checks++;
+    if (Result != -1 || memcmp(Buffer, "12345x", 6))
+    {
+        printf("Short buffer: %d \"%.6s\"\n", Result, Buffer);
+        Failures++;
+    }
+
+    memset(Buffer, 'x', sizeof(Buffer));
+    Result = CrtSnprintf(Buffer, 8, "%d", 12345678);
+    Checks++;
+    if (Result != 8 || memcmp(Buffer, "12345678x", 9))
+    {
+        printf("Exact buffer: %d \"%.9s\"\n", Result, Buffer);
+        Failures++;
+    }
+
+    Result = CrtSnprintf(NULL, 0, "%300d|%.300f", 1, 1.0);
+    Checks++;
+    if (Result != 300 + 1 + 302)
+    {
+        printf("Counted %d characters\n", Result);
+        Failures++;
+    }
+}
+
+static unsigned long long
+Random64(unsigned long long *Seed)
+{
+    /* xorshift64* */
+    *Seed ^= *Seed >> 12;
+    *Seed ^= *Seed << 25;
+    *Seed ^= *Seed >> 27;
+    return *Seed * 2685821657736338717ULL;
+}
+
+static double
+RandomDouble(unsigned long long *Seed)
+{
+    union { double d; unsigned long long u; } Value;
+
+    /* Any finite double, and often ones of a human sized magnitude */
+    do
+    {
+        Value.u = Random64(Seed);
+        if (Value.u & 1)
+            Value.u = (Value.u & 0x800FFFFFFFFFFFFFULL) | ((1023ULL - 30 + (Value.u >> 53) % 60) << 52);
+    }
+    while (((Value.u >> 52) & 0x7FF) == 0x7FF);
+
+    return Value.d;
+}
+
+/* The host prints at least 2 exponent digits, we always print 3 */
+static void
+HostExponent(char *String)
+{
+    char *Exponent = strpbrk(String, "eE");
+    size_t Length;
+
+    if (Exponent && (Exponent[1] == '+' || Exponent[1] == '-') && strlen(Exponent + 2) == 2)
+    {
+        Length = strlen(Exponent + 2);
+        memmove(Exponent + 3, Exponent + 2, Length + 1);
+        Exponent[2] = '0';
+    }
+}
+
+/* We round half up like msvcrt, the host rounds exact ties to even */
+static int
+IsTie(double Number, int Keep)
+{
+    char Digits[80], *Next;
+
+    if (Keep < 0 || Keep > FP_DIGITS_MAX)
+        return 0;
+
+    snprintf(Digits, sizeof(Digits), "%.60e", Number < 0 ? -Number : Number);
+    Next = Digits + Keep + (Keep > 0);
+    if (*Next++ != '5')
+        return 0;
+    while (*Next == '0')
+        Next++;
+    return *Next == 'e';
+}
+
+static void
+Compare(const char *Format, const char *HostFormat, const char *Ours, const char *Host)
+{
+    Checks++;
+    if (strcmp(Ours, Host))
+    {
+        printf("%s: \"%s\", host %s \"%s\"\n", Format, Ours, HostFormat, Host);
+        Failures++;
+    }
+}
+
+static void
+TestRandom(unsigned long Count)
+{
+    static const char *IntFormats[][2] =
+    {
+        { "%d", "%d" }, { "%u", "%u" }, { "%x", "%x" }, { "%o", "%o" }, { "%+12d", "%+12d" },
+        { "%-9X|", "%-9X|" }, { "%.7u", "%.7u" }, { "%I64d", "%lld" }, { "%I64x", "%llx" },
+        { "%020I64u", "%020llu" }
+    };
+    unsigned long long Seed = 0x2545F4914F6CDD1DULL, Value;
+    char Format[16], Ours[512], Host[512];
+    union { double d; unsigned long long u; } Number, Back;
+    unsigned long i;
+    int Precision, Decimal;
+
+    for (i = 0; i < Count; i++)
+    {
+        Number.d = RandomDouble(&Seed);
+        Precision = (int)(Random64(&Seed) % 17);
+
+        /* 17 digits are always enough to get the same double back */
+        CrtSnprintf(Ours, sizeof(Ours), "%.16e", Number.d);
+        Back.d = strtod(Ours, NULL);
+        Decimal = atoi(strchr(Ours, 'e') + 1);
+        Checks++;
+        if (Back.u != Number.u)
+        {
+            printf("%s does not read back as %.17g\n", Ours, Number.d);
+            Failures++;
+        }
+
+        /* %e and %g with up to 17 significant digits */
+        if (!IsTie(Number.d, Precision + 1))
+        {
+            sprintf(Format, "%%.%de", Precision);
+            CrtSnprintf(Ours, sizeof(Ours), Format, Number.d);
+            snprintf(Host, sizeof(Host), Format, Number.d);
+            HostExponent(Host);
+            Compare(Format, Format, Ours, Host);
+
+            sprintf(Format, "%%.%dg", Precision + 1);
+            CrtSnprintf(Ours, sizeof(Ours), Format, Number.d);
+            snprintf(Host, sizeof(Host), Format, Number.d);
+            HostExponent(Host);
+            Compare(Format, Format, Ours, Host);
+        }
+
+        /* %f where that is 17 significant digits or less */
+        if (Decimal + 1 + Precision <= FP_DIGITS_MAX && !IsTie(Number.d, Decimal + 1 + Precision))
+        {
+            sprintf(Format, "%%.%df", Precision);
+            CrtSnprintf(Ours, sizeof(Ours), Format, Number.d);
+            snprintf(Host, sizeof(Host), Format, Number.d);
+            Compare(Format, Format, Ours, Host);
+        }
+
+        /* Integers of all sizes */
+        Value = Random64(&Seed) >> (Random64(&Seed) % 64);
+        Precision = (int)(i % (sizeof(IntFormats) / sizeof(IntFormats[0])));
+        if (strstr(IntFormats[Precision][0], "I64"))
+        {
+            CrtSnprintf(Ours, sizeof(Ours), IntFormats[Precision][0], Value);
+            snprintf(Host, sizeof(Host), IntFormats[Precision][1], Value);
+        }
+        else
+        {
+            CrtSnprintf(Ours, sizeof(Ours), IntFormats[Precision][0], (unsigned)Value);
+            snprintf(Host, sizeof(Host), IntFormats[Precision][1], (unsigned)Value);
+        }
+        Compare(IntFormats[Precision][0], IntFormats[Precision][1], Ours, Host);
+    }
+}
+
+static double
+Nanoseconds(clock_t Start, unsigned long Calls)
+{
+    return (double)(clock() - Start) * 1e9 / CLOCKS_PER_SEC / Calls;
+}
+
+static void
+Bench(const char *Name, unsigned long Rounds, const char *Format, ...)
+{
+    char Buffer[256];
+    va_list Args, Copy;
+    unsigned long r;
+    clock_t Start;
+    double Ours, Host;
+
+    va_start(Args, Format);
+
+    Start = clock();
+    for (r = 0; r < Rounds; r++)
+    {
+        va_copy(Copy, Args);
+        CrtVsnprintf(Buffer, sizeof(Buffer), Format, Copy);
+        va_end(Copy);
+    }
+    Ours = Nanoseconds(Start, Rounds);
+
+    Start = clock();
+    for (r = 0; r < Rounds; r++)
+    {
+        va_copy(Copy, Args);
+        vsnprintf(Buffer, sizeof(Buffer), Format, Copy);
+        va_end(Copy);
+    }
+    Host = Nanoseconds(Start, Rounds);
+
+    va_end(Args);
+
+    printf("%-10s %8.0f ns per call, host %8.0f ns\n", Name, Ours, Host);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long Count = 200000, Rounds = 200000;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strncmp(argv[i], "-n:", 3))
+            Count = strtoul(argv[i] + 3, NULL, 0);
+        else if (!strncmp(argv[i], "-r:", 3))
+            Rounds = strtoul(argv[i] + 3, NULL, 0);
+        else
+        {
+            printf("Usage: %s [-n:random cases] [-r:rounds]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    TestIntegers();
+    TestStrings();
+    TestFloats();
+    TestSizes();
+    TestRandom(Count);
+    printf("%lu checks, %lu failures\n", Checks, Failures);
+
+    if (Rounds)
+    {
+        Bench("text", Rounds, "The quick brown fox jumps over the lazy dog, %s times in a row\n", "many");
+        Bench("integers", Rounds, "%d %u %08x %lld %5d\n", -123456, 4000000000U, 0xBEEF, 1234567890123456789LL, 42);
+        Bench("log line", Rounds, "(%s:%d) Status 0x%08lx for %s at %p\n", "file.c", 1234, 0xC0000034UL, "\\Device\\Harddisk0", (void*)argv);
+        Bench("floats", Rounds, "%f %e %g %.2f\n", 3.14159265358979, 6.02214076e23, 1e-5, 123.456);
+    }
+
+    return Failures ? 2 : 0;
+}
+
+/* EOF */
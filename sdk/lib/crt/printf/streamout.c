@@ -9,10 +9,9 @@
 
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
 #include <tchar.h>
 #include <strings.h>
-#include <math.h>
-#include <float.h>
 
 #ifdef _UNICODE
 # define streamout wstreamout
@@ -20,7 +19,16 @@
 #endif
 
 #define MB_CUR_MAX 10
-#define BUFFER_SIZE (32 + 17)
+#define BUFFER_SIZE 32
+
+/* Output is gathered in a span on the stack and handed to the stream in one go */
+#define SPAN_SIZE 128
+
+/* Like msvcrt, print at most 17 significant digits and zeros after them */
+#define FP_DIGITS_MAX 17
+
+/* Words of 9 decimal digits needed for the longest exact double, 2^53 * 5^1074 */
+#define FP_BIG_WORDS 88
 
 int mbtowc(wchar_t *wchar, const char *mbchar, size_t count);
 int wctomb(char *mbchar, wchar_t wchar);
@@ -32,6 +40,27 @@ typedef struct _STRING
   void *Buffer;
 } STRING;
 
+typedef struct _SPAN
+{
+    FILE *stream;
+    size_t length;
+    TCHAR buffer[SPAN_SIZE];
+} SPAN;
+
+/* A formatted floating point number. Positions are powers of ten, the digits
+   from position 'high' down to 'low' are printed, then the suffix. */
+typedef struct _FPNUM
+{
+    char digits[FP_DIGITS_MAX + 1];
+    int count;
+    int exponent;
+    int high;
+    int low;
+    int point;
+    TCHAR suffix[8];
+    int suffixlen;
+} FPNUM;
+
 enum
 {
     /* Formatting flags */
@@ -68,11 +97,113 @@ enum
     (flags & FLAG_LONGDOUBLE) ? va_arg(argptr, long double) : \
     va_arg(argptr, double)
 
-#define get_exp(f) (int)floor(f == 0 ? 0 : (f >= 0 ? log10(f) : log10(-f)))
-#define round(x) floor((x) + 0.5)
+static const char digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
 
 #ifndef _USER32_WSPRINTF
 
+/* Gets the leading FP_DIGITS_MAX + 1 decimal digits of mantissa * 2^exponent,
+   exactly, and returns the decimal exponent of the first one */
+static
+int
+fp_digits(unsigned __int64 mantissa, int exponent, char *digits)
+{
+    static const unsigned long pow5[] =
+        { 1, 5, 25, 125, 625, 3125, 15625, 78125, 390625, 1953125, 9765625,
+          48828125, 244140625, 1220703125 };
+    unsigned long big[FP_BIG_WORDS], word;
+    unsigned __int64 carry;
+    char text[9];
+    int words, shift, count, decimal = 0, i, j, k;
+
+    big[0] = (unsigned long)(mantissa % 1000000000);
+    big[1] = (unsigned long)(mantissa / 1000000000);
+    words = big[1] ? 2 : 1;
+
+    /* Multiply by 2^exponent, or by 5^-exponent and divide by 10^-exponent */
+    while (exponent > 0)
+    {
+        shift = exponent < 29 ? exponent : 29;
+        carry = 0;
+        for (i = 0; i < words; i++)
+        {
+            carry += (unsigned __int64)big[i] << shift;
+            big[i] = (unsigned long)(carry % 1000000000);
+            carry /= 1000000000;
+        }
+        if (carry) big[words++] = (unsigned long)carry;
+        exponent -= shift;
+    }
+    while (exponent < 0)
+    {
+        shift = -exponent < 13 ? -exponent : 13;
+        carry = 0;
+        for (i = 0; i < words; i++)
+        {
+            carry += (unsigned __int64)big[i] * pow5[shift];
+            big[i] = (unsigned long)(carry % 1000000000);
+            carry /= 1000000000;
+        }
+        while (carry)
+        {
+            big[words++] = (unsigned long)(carry % 1000000000);
+            carry /= 1000000000;
+        }
+        decimal -= shift;
+        exponent += shift;
+    }
+
+    /* The top word has no leading zeros, all others have 9 digits */
+    for (count = 0, word = big[words - 1]; word; word /= 10) count++;
+    decimal += count - 1 + 9 * (words - 1);
+
+    for (i = words - 1, j = 0; i >= 0 && j <= FP_DIGITS_MAX; i--, count = 9)
+    {
+        for (word = big[i], k = count; k-- > 0; word /= 10)
+            text[k] = '0' + (char)(word % 10);
+        for (k = 0; k < count && j <= FP_DIGITS_MAX; k++)
+            digits[j++] = text[k];
+    }
+    while (j <= FP_DIGITS_MAX) digits[j++] = '0';
+
+    return decimal;
+}
+
+/* Keeps the first 'keep' digits, rounded half up. Returns 1 when that
+   carries into a new leading digit, which moves the exponent. */
+static
+int
+fp_round(FPNUM *fp, int keep)
+{
+    int i;
+
+    if (keep > FP_DIGITS_MAX) keep = FP_DIGITS_MAX;
+    if (keep < 0)
+    {
+        fp->count = 0;
+        return 0;
+    }
+
+    fp->count = keep;
+    if (fp->digits[keep] < '5') return 0;
+
+    for (i = keep - 1; i >= 0; i--)
+    {
+        if (fp->digits[i] != '9')
+        {
+            fp->digits[i]++;
+            return 0;
+        }
+        fp->digits[i] = '0';
+    }
+
+    fp->digits[0] = '1';
+    if (keep == 0) fp->count = 1;
+    return 1;
+}
+
 void
 #ifdef _LIBCNT_
 /* Due to restrictions in kernel mode regarding the use of floating point,
@@ -83,213 +214,274 @@ format_float(
     TCHAR chr,
     unsigned int flags,
     int precision,
-    TCHAR **string,
+    FPNUM *fp,
     const TCHAR **prefix,
     va_list *argptr)
 {
-    static const TCHAR digits_l[] = _T("0123456789abcdef0x");
-    static const TCHAR digits_u[] = _T("0123456789ABCDEF0X");
     static const TCHAR _nan[] = _T("#QNAN");
     static const TCHAR _infinity[] = _T("#INF");
-    const TCHAR *digits = digits_l;
-    int exponent = 0, sign;
-    long double fpval, fpval2;
-    int padding = 0, num_digits, val32, base = 10;
+    union
+    {
+        double d;
+        unsigned __int64 u;
+    } fpval;
+    unsigned __int64 mantissa;
+    int exponent, decimal, style_e = 0, last, val32;
+    TCHAR e = _T('e');
 
     /* Normalize the precision */
     if (precision < 0) precision = 6;
-    else if (precision > 17)
+
+    /* Get the float value and split it up, everything else is integer math */
+    fpval.d = va_arg_ffp(*argptr, flags);
+    exponent = (int)(fpval.u >> 52) & 0x7ff;
+    mantissa = fpval.u & (((unsigned __int64)1 << 52) - 1);
+
+    /* Handle sign, NaN and zero have none */
+    if ((fpval.u >> 63) && (exponent || mantissa) && !(exponent == 0x7ff && mantissa))
+    {
+        *prefix = _T("-");
+    }
+    else if (flags & FLAG_FORCE_SIGN)
+        *prefix = _T("+");
+    else if (flags & FLAG_FORCE_SIGNSP)
+        *prefix = _T(" ");
+
+    /* Handle special cases first, they look like "1.#INF" */
+    if (exponent == 0x7ff)
     {
-        padding = precision - 17;
-        precision = 17;
+        if ((chr == _T('g') || chr == _T('G')) && precision > 0) precision--;
+
+        fp->digits[0] = '1';
+        fp->count = 1;
+        fp->exponent = fp->high = fp->low = 0;
+        fp->point = precision > 0 || (flags & FLAG_SPECIAL);
+        _tcscpy(fp->suffix, mantissa ? _nan : _infinity);
+        fp->suffixlen = (int)_tcslen(fp->suffix);
+        return;
     }
 
-    /* Get the float value and calculate the exponent */
-    fpval = va_arg_ffp(*argptr, flags);
-    exponent = get_exp(fpval);
-    sign = fpval < 0 ? -1 : 1;
+    if (mantissa || exponent)
+    {
+        if (exponent) mantissa |= (unsigned __int64)1 << 52;
+        else exponent = 1;
+        decimal = fp_digits(mantissa, exponent - 1075, fp->digits);
+    }
+    else
+    {
+        memset(fp->digits, '0', sizeof(fp->digits));
+        decimal = 0;
+    }
 
     switch (chr)
     {
         case _T('G'):
-            digits = digits_u;
+            e = _T('E');
         case _T('g'):
-            if (precision > 0) precision--;
-            if (exponent < -4 || exponent >= precision) goto case_e;
-
-            /* Shift the decimal point and round */
-            fpval2 = round(sign * fpval * pow(10., precision));
-
-            /* Skip trailing zeroes */
-            while (precision && (unsigned __int64)fpval2 % 10 == 0)
+            /* Precision is the number of significant digits */
+            if (precision == 0) precision = 1;
+            decimal += fp_round(fp, precision);
+            if (decimal < -4 || decimal >= precision)
             {
+                style_e = 1;
                 precision--;
-                fpval2 /= 10;
             }
+            else
+                precision -= decimal + 1;
             break;
 
         case _T('E'):
-            digits = digits_u;
+            e = _T('E');
         case _T('e'):
-        case_e:
-            /* Shift the decimal point and round */
-            fpval2 = round(sign * fpval * pow(10., precision - exponent));
-
-            /* Compensate for changed exponent through rounding */
-            if (fpval2 >= (unsigned __int64)pow(10., precision + 1))
-            {
-                exponent++;
-                fpval2 = round(sign * fpval * pow(10., precision - exponent));
-            }
-
-            val32 = exponent >= 0 ? exponent : -exponent;
-
-            // FIXME: handle length of exponent field:
-            // http://msdn.microsoft.com/de-de/library/0fatw238%28VS.80%29.aspx
-            num_digits = 3;
-            while (num_digits--)
-            {
-                *--(*string) = digits[val32 % 10];
-                val32 /= 10;
-            }
-
-            /* Sign for the exponent */
-            *--(*string) = exponent >= 0 ? _T('+') : _T('-');
-
-            /* Add 'e' or 'E' separator */
-            *--(*string) = digits[0xe];
+            decimal += fp_round(fp, precision + 1);
+            style_e = 1;
             break;
 
         case _T('A'):
-            digits = digits_u;
         case _T('a'):
-//            base = 16;
             // FIXME: TODO
 
         case _T('f'):
         default:
-            /* Shift the decimal point and round */
-            fpval2 = round(sign * fpval * pow(10., precision));
+            decimal += fp_round(fp, decimal + 1 + precision);
             break;
     }
 
-    /* Handle sign */
-    if (fpval < 0)
-    {
-        *prefix = _T("-");
-    }
-    else if (flags & FLAG_FORCE_SIGN)
-        *prefix = _T("+");
-    else if (flags & FLAG_FORCE_SIGNSP)
-        *prefix = _T(" ");
-
-    /* Handle special cases first */
-    if (_isnan(fpval))
-    {
-        (*string) -= sizeof(_nan) / sizeof(TCHAR) - 1;
-        _tcscpy((*string), _nan);
-        fpval2 = 1;
-    }
-    else if (!_finite(fpval))
+    fp->suffixlen = 0;
+    if (style_e)
     {
-        (*string) -= sizeof(_infinity) / sizeof(TCHAR) - 1;
-        _tcscpy((*string), _infinity);
-        fpval2 = 1;
+        /* One digit before the point, then the exponent */
+        fp->exponent = 0;
+
+        // FIXME: handle length of exponent field:
+        // http://msdn.microsoft.com/de-de/library/0fatw238%28VS.80%29.aspx
+        val32 = decimal >= 0 ? decimal : -decimal;
+        fp->suffix[0] = e;
+        fp->suffix[1] = decimal >= 0 ? _T('+') : _T('-');
+        fp->suffix[2] = _T('0') + val32 / 100;
+        fp->suffix[3] = digit_pairs[2 * (val32 % 100)];
+        fp->suffix[4] = digit_pairs[2 * (val32 % 100) + 1];
+        fp->suffixlen = 5;
     }
     else
-    {
-        /* Zero padding */
-        while (padding-- > 0) *--(*string) = _T('0');
+        fp->exponent = decimal;
 
-        /* Digits after the decimal point */
-        num_digits = precision;
-        while (num_digits-- > 0)
-        {
-            *--(*string) = digits[(unsigned __int64)fpval2 % 10];
-            fpval2 /= base;
-        }
-    }
+    fp->high = fp->exponent > 0 ? fp->exponent : 0;
+    fp->low = -precision;
 
-    if (precision > 0 || flags & FLAG_SPECIAL)
-        *--(*string) = _T('.');
-
-    /* Digits before the decimal point */
-    do
+    /* %g drops the trailing zeros, unless asked not to */
+    if ((chr == _T('g') || chr == _T('G')) && !(flags & FLAG_SPECIAL))
     {
-        *--(*string) = digits[(unsigned __int64)fpval2 % base];
-        fpval2 /= base;
+        for (last = fp->count; last > 0 && fp->digits[last - 1] == '0'; last--);
+        if (last == 0 || fp->exponent - last + 1 >= 0)
+            fp->low = 0;
+        else if (fp->low < fp->exponent - last + 1)
+            fp->low = fp->exponent - last + 1;
     }
-    while ((unsigned __int64)fpval2);
 
+    fp->point = fp->low < 0 || (flags & FLAG_SPECIAL);
 }
 #endif
 
+/* Writes out what was gathered. String streams take as much as fits. */
 static
 int
-streamout_char(FILE *stream, int chr)
+streamout_flush(SPAN *span)
 {
+    FILE *stream = span->stream;
+    size_t length = span->length, count;
+
+    span->length = 0;
+
 #if !defined(_USER32_WSPRINTF)
-     if ((stream->_flag & _IOSTRG) && (stream->_base == NULL))
+    if ((stream->_flag & _IOSTRG) && (stream->_base == NULL))
         return 1;
 #endif
-#if defined(_USER32_WSPRINTF) || defined(_LIBCNT_)
+#if !defined(_USER32_WSPRINTF) && !defined(_LIBCNT_)
+    if (!(stream->_flag & _IOSTRG))
+    {
+#ifdef _UNICODE
+        /* Let _fputwc do the text mode conversion */
+        for (count = 0; count < length; count++)
+        {
+            if (_fputtc(span->buffer[count], stream) == _TEOF) return 0;
+        }
+#else
+        if (fwrite(span->buffer, 1, length, stream) != length) return 0;
+
+        /* fputc flushes on every new line, so did we when we used it */
+        if (memchr(span->buffer, '\n', length) && fflush(stream)) return 0;
+#endif
+        return 1;
+    }
+#endif
+
     /* Check if the buffer is full */
-    if (stream->_cnt < sizeof(TCHAR))
-        return 0;
+    count = (stream->_cnt > 0) ? stream->_cnt / sizeof(TCHAR) : 0;
+    if (count > length) count = length;
+
+    memcpy(stream->_ptr, span->buffer, count * sizeof(TCHAR));
+    stream->_ptr += count * sizeof(TCHAR);
+    stream->_cnt -= (int)(count * sizeof(TCHAR));
 
-    *(TCHAR*)stream->_ptr = chr;
-    stream->_ptr += sizeof(TCHAR);
-    stream->_cnt -= sizeof(TCHAR);
+    return count == length;
+}
 
+static
+int
+streamout_char(SPAN *span, int chr)
+{
+    if ((span->length == SPAN_SIZE) && !streamout_flush(span))
+        return 0;
+
+    span->buffer[span->length++] = (TCHAR)chr;
     return 1;
-#else
-    return _fputtc((TCHAR)chr, stream) != _TEOF;
-#endif
 }
 
 static
 int
-streamout_astring(FILE *stream, const char *string, size_t count)
+streamout_chars(SPAN *span, int chr, int count)
+{
+    int written;
+
+    for (written = 0; written < count; written++)
+    {
+        if (streamout_char(span, chr) == 0) return -1;
+    }
+
+    return written;
+}
+
+static
+int
+streamout_copy(SPAN *span, const TCHAR *string, size_t count)
+{
+    size_t chunk;
+    int written = (int)count;
+
+    while (count)
+    {
+        if ((span->length == SPAN_SIZE) && !streamout_flush(span))
+            return -1;
+
+        chunk = SPAN_SIZE - span->length;
+        if (chunk > count) chunk = count;
+        memcpy(&span->buffer[span->length], string, chunk * sizeof(TCHAR));
+        span->length += chunk;
+        string += chunk;
+        count -= chunk;
+    }
+
+    return written;
+}
+
+static
+int
+streamout_astring(SPAN *span, const char *string, size_t count)
 {
+#ifdef _UNICODE
     TCHAR chr;
     int written = 0;
+#endif
 
 #if !defined(_USER32_WSPRINTF)
-     if ((stream->_flag & _IOSTRG) && (stream->_base == NULL))
+     if ((span->stream->_flag & _IOSTRG) && (span->stream->_base == NULL))
         return count;
 #endif
 
+#ifdef _UNICODE
     while (count--)
     {
-#ifdef _UNICODE
         int len;
         if ((len = mbtowc(&chr, string, MB_CUR_MAX)) < 1) break;
         string += len;
-#else
-        chr = *string++;
-#endif
-        if (streamout_char(stream, chr) == 0) return -1;
+        if (streamout_char(span, chr) == 0) return -1;
         written++;
     }
 
     return written;
+#else
+    return streamout_copy(span, string, count);
+#endif
 }
 
 static
 int
-streamout_wstring(FILE *stream, const wchar_t *string, size_t count)
+streamout_wstring(SPAN *span, const wchar_t *string, size_t count)
 {
-    wchar_t chr;
+#ifndef _UNICODE
+    char chr;
     int written = 0;
+#endif
 
 #if defined(_UNICODE) && !defined(_USER32_WSPRINTF)
-     if ((stream->_flag & _IOSTRG) && (stream->_base == NULL))
+     if ((span->stream->_flag & _IOSTRG) && (span->stream->_base == NULL))
         return count;
 #endif
 
+#ifndef _UNICODE
     while (count--)
     {
-#ifndef _UNICODE
         char mbchar[MB_CUR_MAX], *ptr = mbchar;
         int mblen;
 
@@ -297,16 +489,87 @@ streamout_wstring(FILE *stream, const wchar_t *string, size_t count)
         if (mblen <= 0) return written;
 
         while (chr = *ptr++, mblen--)
-#else
-        chr = *string++;
-#endif
         {
-            if (streamout_char(stream, chr) == 0) return -1;
+            if (streamout_char(span, chr) == 0) return -1;
             written++;
         }
     }
 
     return written;
+#else
+    return streamout_copy(span, string, count);
+#endif
+}
+
+#ifndef _USER32_WSPRINTF
+static
+int
+streamout_float(SPAN *span, const FPNUM *fp)
+{
+    int position, index;
+
+    for (position = fp->high; position >= fp->low; position--)
+    {
+        index = fp->exponent - position;
+        if (streamout_char(span, (index >= 0 && index < fp->count) ? fp->digits[index] : '0') == 0)
+            return -1;
+
+        if ((position == 0) && fp->point && (streamout_char(span, _T('.')) == 0))
+            return -1;
+    }
+
+    if (streamout_copy(span, fp->suffix, fp->suffixlen) == -1)
+        return -1;
+
+    return fp->high - fp->low + 1 + fp->point + fp->suffixlen;
+}
+#endif
+
+/* Writes the digits of val64 backwards, ending at string */
+static
+TCHAR *
+format_integer(unsigned __int64 val64, int base, const TCHAR *digits, TCHAR *string)
+{
+    unsigned long val32;
+    unsigned int pair, shift = (base == 16) ? 4 : 3;
+
+    if (base != 10)
+    {
+        while (val64)
+        {
+            *--string = digits[val64 & (base - 1)];
+            val64 >>= shift;
+        }
+        return string;
+    }
+
+    /* Two digits at a time, 64 bit divisions only while they are needed */
+    while (val64 > 0xFFFFFFFF)
+    {
+        pair = (unsigned int)(val64 % 100);
+        val64 /= 100;
+        *--string = digit_pairs[2 * pair + 1];
+        *--string = digit_pairs[2 * pair];
+    }
+
+    val32 = (unsigned long)val64;
+    while (val32 >= 100)
+    {
+        pair = val32 % 100;
+        val32 /= 100;
+        *--string = digit_pairs[2 * pair + 1];
+        *--string = digit_pairs[2 * pair];
+    }
+
+    if (val32 >= 10)
+    {
+        *--string = digit_pairs[2 * val32 + 1];
+        *--string = digit_pairs[2 * val32];
+    }
+    else if (val32)
+        *--string = _T('0') + (TCHAR)val32;
+
+    return string;
 }
 
 #ifdef _UNICODE
@@ -323,13 +586,14 @@ streamout_wstring(FILE *stream, const wchar_t *string, size_t count)
 
 int
 __cdecl
-streamout(FILE *stream, const TCHAR *format, va_list argptr)
+streamout(FILE *stream, const TCHAR *format, va_list args)
 {
     static const TCHAR digits_l[] = _T("0123456789abcdef0x");
     static const TCHAR digits_u[] = _T("0123456789ABCDEF0X");
     static const char *_nullstring = "(null)";
     TCHAR buffer[BUFFER_SIZE + 1];
     TCHAR chr, *string;
+    const TCHAR *literal;
     STRING *nt_string;
     const TCHAR *digits, *prefix;
     int base, fieldwidth, precision, padding;
@@ -337,8 +601,19 @@ streamout(FILE *stream, const TCHAR *format, va_list argptr)
     int written = 1, written_all = 0;
     unsigned int flags;
     unsigned __int64 val64;
+    va_list argptr;
+    SPAN span;
+#ifndef _USER32_WSPRINTF
+    FPNUM fp;
+    int is_float;
+#endif
 
     buffer[BUFFER_SIZE] = '\0';
+    span.stream = stream;
+    span.length = 0;
+
+    /* Work on a copy, format_float needs a pointer to it */
+    va_copy(argptr, args);
 
     while (written >= 0)
     {
@@ -347,12 +622,20 @@ streamout(FILE *stream, const TCHAR *format, va_list argptr)
         /* Check for end of format string */
         if (chr == _T('\0')) break;
 
-        /* Check for 'normal' character or double % */
-        if ((chr != _T('%')) ||
-            (chr = *format++) == _T('%'))
+        /* Copy 'normal' characters up to the next '%' at once */
+        if (chr != _T('%'))
         {
-            /* Write the character to the stream */
-            if ((written = streamout_char(stream, chr)) == 0) return -1;
+            literal = format - 1;
+            while (*format != _T('\0') && *format != _T('%')) format++;
+            if ((written = streamout_copy(&span, literal, format - literal)) == -1) goto failed;
+            written_all += written;
+            continue;
+        }
+
+        /* Check for double % */
+        if ((chr = *format++) == _T('%'))
+        {
+            if ((written = streamout_char(&span, chr)) == 0) goto failed;
             written_all += written;
             continue;
         }
@@ -374,7 +657,7 @@ streamout(FILE *stream, const TCHAR *format, va_list argptr)
         if (chr == _T('*'))
         {
 #ifdef _USER32_WSPRINTF
-            if ((written = streamout_char(stream, chr)) == 0) return -1;
+            if ((written = streamout_char(&span, chr)) == 0) goto failed;
             written_all += written;
             continue;
 #else
@@ -405,7 +688,7 @@ streamout(FILE *stream, const TCHAR *format, va_list argptr)
             if (chr == _T('*'))
             {
 #ifdef _USER32_WSPRINTF
-                if ((written = streamout_char(stream, chr)) == 0) return -1;
+                if ((written = streamout_char(&span, chr)) == 0) goto failed;
                 written_all += written;
                 continue;
 #else
@@ -467,6 +750,9 @@ streamout(FILE *stream, const TCHAR *format, va_list argptr)
         string = &buffer[BUFFER_SIZE];
         base = 10;
         prefix = 0;
+#ifndef _USER32_WSPRINTF
+        is_float = 0;
+#endif
         switch (chr)
         {
             case _T('n'):
@@ -549,14 +835,10 @@ streamout(FILE *stream, const TCHAR *format, va_list argptr)
             case _T('e'):
             case _T('a'):
             case _T('f'):
-#ifdef _UNICODE
-                flags |= FLAG_WIDECHAR;
-#else
-                flags &= ~FLAG_WIDECHAR;
-#endif
                 /* Use external function, one for kernel one for user mode */
-                format_float(chr, flags, precision, &string, &prefix, &argptr);
-                len = _tcslen(string);
+                format_float(chr, flags, precision, &fp, &prefix, &argptr);
+                len = fp.high - fp.low + 1 + fp.point + fp.suffixlen;
+                is_float = 1;
                 precision = 0;
                 break;
 #endif
@@ -619,14 +901,9 @@ streamout(FILE *stream, const TCHAR *format, va_list argptr)
                 if (precision < 0) precision = 1;
 
                 /* Gather digits in reverse order */
-                while (val64)
-                {
-                    *--string = digits[val64 % base];
-                    val64 /= base;
-                    precision--;
-                }
-
-                len = _tcslen(string);
+                string = format_integer(val64, base, digits, string);
+                len = &buffer[BUFFER_SIZE] - string;
+                precision -= (int)len;
                 break;
 
             default:
@@ -644,61 +921,55 @@ streamout(FILE *stream, const TCHAR *format, va_list argptr)
         /* Optional left space padding */
         if ((flags & (FLAG_ALIGN_LEFT | FLAG_PAD_ZERO)) == 0)
         {
-            for (; padding > 0; padding--)
-            {
-                if ((written = streamout_char(stream, _T(' '))) == 0) return -1;
-                written_all += written;
-            }
+            if ((written = streamout_chars(&span, _T(' '), padding)) == -1) goto failed;
+            written_all += written;
+            padding = 0;
         }
 
         /* Optional prefix */
         if (prefix)
         {
-            written = streamout_string(stream, prefix, prefixlen);
-            if (written == -1) return -1;
+            written = streamout_string(&span, prefix, prefixlen);
+            if (written == -1) goto failed;
             written_all += written;
         }
 
         /* Optional left '0' padding */
         if ((flags & FLAG_ALIGN_LEFT) == 0) precision += padding;
-        while (precision-- > 0)
-        {
-            if ((written = streamout_char(stream, _T('0'))) == 0) return -1;
-            written_all += written;
-        }
+        if ((written = streamout_chars(&span, _T('0'), precision)) == -1) goto failed;
+        written_all += written;
 
         /* Output the string */
+#ifndef _USER32_WSPRINTF
+        if (is_float)
+            written = streamout_float(&span, &fp);
+        else
+#endif
         if (flags & FLAG_WIDECHAR)
-            written = streamout_wstring(stream, (wchar_t*)string, len);
+            written = streamout_wstring(&span, (wchar_t*)string, len);
         else
-            written = streamout_astring(stream, (char*)string, len);
-        if (written == -1) return -1;
+            written = streamout_astring(&span, (char*)string, len);
+        if (written == -1) goto failed;
         written_all += written;
 
-#if 0 && SUPPORT_FLOAT
-        /* Optional right '0' padding */
-        while (precision-- > 0)
-        {
-            if ((written = streamout_char(stream, _T('0'))) == 0) return -1;
-            written_all += written;
-            len++;
-        }
-#endif
-
         /* Optional right padding */
         if (flags & FLAG_ALIGN_LEFT)
         {
-            while (padding-- > 0)
-            {
-                if ((written = streamout_char(stream, _T(' '))) == 0) return -1;
-                written_all += written;
-            }
+            if ((written = streamout_chars(&span, _T(' '), padding)) == -1) goto failed;
+            written_all += written;
         }
 
     }
 
-    if (written == -1) return -1;
+    /* Hand the rest to the stream */
+    if ((written != -1) && streamout_flush(&span))
+    {
+        va_end(argptr);
+        return written_all;
+    }
 
-    return written_all;
+failed:
+    va_end(argptr);
+    return -1;
 }
 
@@ -304,9 +304,13 @@ Fast486InterruptInternal(PFAST486_STATE State,
                        (IdtEntry->Type == FAST486_IDT_TRAP_GATE_32);
     USHORT OldCs = State->SegmentRegs[FAST486_REG_CS].Selector;
     ULONG OldEip = State->InstPtr.Long;
-    ULONG OldFlags = State->Flags.Long;
+    ULONG OldFlags;
     UCHAR OldCpl = State->Cpl;
 
+    /* The pending arithmetic flags get pushed too */
+    Fast486ResolveFlags(State);
+    OldFlags = State->Flags.Long;
+
     /* Check for protected mode */
     if (State->ControlRegisters[FAST486_REG_CR0] & FAST486_CR0_PE)
     {
@@ -802,6 +806,9 @@ Fast486TaskSwitch(PFAST486_STATE State, FAST486_TASK_SWITCH_TYPE Type, USHORT Se
         }
     }
 
+    /* The pending arithmetic flags get saved too */
+    Fast486ResolveFlags(State);
+
     /* Save the current task into the TSS */
     if (State->TaskReg.Modern)
     {
@@ -1310,4 +1317,21 @@ Fast486CallGate(PFAST486_STATE State,
     return TRUE;
 }
 
+VOID
+FASTCALL
+Fast486ComputeFlags(PFAST486_STATE State)
+{
+    ULONG Result = State->LazyFlags.Result;
+
+    State->Flags.Cf = Fast486GetCarryFlag(State);
+    State->Flags.Of = Fast486GetOverflowFlag(State);
+    State->Flags.Af = Fast486GetAuxFlag(State);
+    State->Flags.Zf = (Result == 0);
+    State->Flags.Sf = ((Result & State->LazyFlags.SignFlag) != 0);
+    State->Flags.Pf = Fast486CalculateParity(LOBYTE(Result));
+
+    /* The flags are up to date now */
+    State->LazyFlags.Operation = FAST486_LAZY_NONE;
+}
+
 /* EOF */
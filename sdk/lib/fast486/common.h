@@ -194,6 +194,13 @@ Fast486CallGate
     BOOLEAN Call
 );
 
+VOID
+FASTCALL
+Fast486ComputeFlags
+(
+    PFAST486_STATE State
+);
+
 /* INLINED FUNCTIONS **********************************************************/
 
 #include "common.inl"
@@ -1013,6 +1013,172 @@ Fast486CalculateParity(UCHAR Number)
     return (0x9669 >> ((Number & 0x0F) ^ (Number >> 4))) & 1;
 }
 
+/*
+ * Lazy flags. The getters below return a single flag without computing
+ * the others, whether the last arithmetic operation is still pending or not.
+ */
+
+FORCEINLINE
+BOOLEAN
+FASTCALL
+Fast486GetCarryFlag(PFAST486_STATE State)
+{
+    PFAST486_LAZY_FLAGS LazyFlags = &State->LazyFlags;
+
+    switch (LazyFlags->Operation)
+    {
+        case FAST486_LAZY_ADD:
+        {
+            return (LazyFlags->Result < LazyFlags->FirstValue)
+                   || (LazyFlags->Carry && (LazyFlags->Result == LazyFlags->FirstValue));
+        }
+
+        case FAST486_LAZY_SUB:
+        {
+            return LazyFlags->Carry
+                   ? (LazyFlags->FirstValue <= LazyFlags->SecondValue)
+                   : (LazyFlags->FirstValue < LazyFlags->SecondValue);
+        }
+
+        case FAST486_LAZY_INC:
+        case FAST486_LAZY_DEC:
+        {
+            /* INC and DEC keep CF */
+            return LazyFlags->Carry;
+        }
+
+        case FAST486_LAZY_LOGIC:
+        {
+            return FALSE;
+        }
+
+        default:
+        {
+            return State->Flags.Cf;
+        }
+    }
+}
+
+FORCEINLINE
+BOOLEAN
+FASTCALL
+Fast486GetOverflowFlag(PFAST486_STATE State)
+{
+    PFAST486_LAZY_FLAGS LazyFlags = &State->LazyFlags;
+    ULONG FirstValue = LazyFlags->FirstValue;
+    ULONG SecondValue = LazyFlags->SecondValue;
+    ULONG Result = LazyFlags->Result;
+
+    switch (LazyFlags->Operation)
+    {
+        case FAST486_LAZY_ADD:
+        case FAST486_LAZY_INC:
+        {
+            /* The operands have the same sign, and the result the other one */
+            return (((FirstValue ^ Result) & (SecondValue ^ Result) & LazyFlags->SignFlag) != 0);
+        }
+
+        case FAST486_LAZY_SUB:
+        case FAST486_LAZY_DEC:
+        {
+            /* The operands have different signs, and the result is not that of the first */
+            return (((FirstValue ^ SecondValue) & (FirstValue ^ Result) & LazyFlags->SignFlag) != 0);
+        }
+
+        case FAST486_LAZY_LOGIC:
+        {
+            return FALSE;
+        }
+
+        default:
+        {
+            return State->Flags.Of;
+        }
+    }
+}
+
+FORCEINLINE
+BOOLEAN
+FASTCALL
+Fast486GetAuxFlag(PFAST486_STATE State)
+{
+    PFAST486_LAZY_FLAGS LazyFlags = &State->LazyFlags;
+
+    /* The logical operations keep AF */
+    if ((LazyFlags->Operation == FAST486_LAZY_NONE)
+        || (LazyFlags->Operation == FAST486_LAZY_LOGIC))
+    {
+        return State->Flags.Af;
+    }
+
+    /* Carry or borrow out of the low nibble, INC and DEC use 1 as the second value */
+    return (((LazyFlags->FirstValue ^ LazyFlags->SecondValue ^ LazyFlags->Result) & 0x10) != 0);
+}
+
+FORCEINLINE
+BOOLEAN
+FASTCALL
+Fast486GetZeroFlag(PFAST486_STATE State)
+{
+    if (State->LazyFlags.Operation == FAST486_LAZY_NONE) return State->Flags.Zf;
+    return (State->LazyFlags.Result == 0);
+}
+
+FORCEINLINE
+BOOLEAN
+FASTCALL
+Fast486GetSignFlag(PFAST486_STATE State)
+{
+    if (State->LazyFlags.Operation == FAST486_LAZY_NONE) return State->Flags.Sf;
+    return ((State->LazyFlags.Result & State->LazyFlags.SignFlag) != 0);
+}
+
+FORCEINLINE
+VOID
+FASTCALL
+Fast486SetLazyFlags(PFAST486_STATE State,
+                    FAST486_LAZY_OPERATION Operation,
+                    ULONG FirstValue,
+                    ULONG SecondValue,
+                    ULONG Result,
+                    ULONG SignFlag,
+                    BOOLEAN Carry)
+{
+    PFAST486_LAZY_FLAGS LazyFlags = &State->LazyFlags;
+
+    LazyFlags->Operation = Operation;
+    LazyFlags->FirstValue = FirstValue;
+    LazyFlags->SecondValue = SecondValue;
+    LazyFlags->Result = Result;
+    LazyFlags->SignFlag = SignFlag;
+    LazyFlags->Carry = Carry;
+
+#ifdef FAST486_NO_LAZY_FLAGS
+    Fast486ComputeFlags(State);
+#endif
+}
+
+/* Used by AND, OR, XOR and TEST, which clear CF and OF and keep AF */
+FORCEINLINE
+VOID
+FASTCALL
+Fast486SetLogicFlags(PFAST486_STATE State,
+                     ULONG Result,
+                     ULONG SignFlag)
+{
+    State->Flags.Af = Fast486GetAuxFlag(State);
+    Fast486SetLazyFlags(State, FAST486_LAZY_LOGIC, 0, 0, Result, SignFlag, FALSE);
+}
+
+/* Compute the pending flags, before anything reads or changes State->Flags */
+FORCEINLINE
+VOID
+FASTCALL
+Fast486ResolveFlags(PFAST486_STATE State)
+{
+    if (State->LazyFlags.Operation != FAST486_LAZY_NONE) Fast486ComputeFlags(State);
+}
+
 FORCEINLINE
 BOOLEAN
 FASTCALL
@@ -126,6 +126,8 @@ VOID
 NTAPI
 Fast486DumpState(PFAST486_STATE State)
 {
+    Fast486ResolveFlags(State);
+
     DbgPrint("\nFast486DumpState -->\n");
     DbgPrint("\nCPU currently executing in %s mode at %04X:%08X\n",
             (State->ControlRegisters[FAST486_REG_CR0] & FAST486_CR0_PE) ? "protected" : "real",
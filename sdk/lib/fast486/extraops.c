@@ -375,6 +375,8 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeLar)
         return;
     }
 
+    Fast486ResolveFlags(State);
+
     if (!Valid)
     {
         State->Flags.Zf = FALSE;
@@ -459,6 +461,8 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeLsl)
         return;
     }
 
+    Fast486ResolveFlags(State);
+
     if (!Valid)
     {
         State->Flags.Zf = FALSE;
@@ -758,6 +762,8 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeBitTest)
     /* Normalize the bit number */
     BitNumber %= DataSize;
 
+    Fast486ResolveFlags(State);
+
     if (OperandSize)
     {
         ULONG Value;
@@ -829,6 +835,8 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeShld)
     /* Do nothing if the count is zero */
     if (Count == 0) return;
 
+    Fast486ResolveFlags(State);
+
     if (OperandSize)
     {
         ULONG Source, Destination, Result;
@@ -942,6 +950,8 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeBts)
     /* Normalize the bit number */
     BitNumber %= DataSize;
 
+    Fast486ResolveFlags(State);
+
     if (OperandSize)
     {
         ULONG Value;
@@ -1025,6 +1035,8 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeShrd)
     /* Do nothing if the count is zero */
     if (Count == 0) return;
 
+    Fast486ResolveFlags(State);
+
     if (OperandSize)
     {
         ULONG Source, Destination, Result;
@@ -1096,6 +1108,8 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeImul)
         return;
     }
 
+    Fast486ResolveFlags(State);
+
     if (OperandSize)
     {
         LONG Source, Destination;
@@ -1172,6 +1186,8 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeCmpXchgByte)
     /* Compare AL with the destination */
     Result = Accumulator - Destination;
 
+    Fast486ResolveFlags(State);
+
     /* Update the flags */
     State->Flags.Cf = (Accumulator < Destination);
     State->Flags.Of = ((Accumulator & SIGN_FLAG_BYTE) != (Destination & SIGN_FLAG_BYTE))
@@ -1210,6 +1226,8 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeCmpXchg)
         return;
     }
 
+    Fast486ResolveFlags(State);
+
     if (OperandSize)
     {
         ULONG Source, Destination, Result;
@@ -1384,6 +1402,8 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeBtr)
     /* Normalize the bit number */
     BitNumber %= DataSize;
 
+    Fast486ResolveFlags(State);
+
     if (OperandSize)
     {
         ULONG Value;
@@ -1598,6 +1618,8 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeBtc)
     /* Normalize the bit number */
     BitNumber %= DataSize;
 
+    Fast486ResolveFlags(State);
+
     if (OperandSize)
     {
         ULONG Value;
@@ -1688,6 +1710,8 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeBsf)
         }
     }
 
+    Fast486ResolveFlags(State);
+
     /* Set ZF */
     State->Flags.Zf = (Value == 0);
     if (State->Flags.Zf) return;
@@ -1757,6 +1781,8 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeBsr)
         }
     }
 
+    Fast486ResolveFlags(State);
+
     /* Set ZF according to the value */
     State->Flags.Zf = (Value == 0);
     if (State->Flags.Zf) return;
@@ -1882,41 +1908,42 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeConditionalJmp)
         /* JO / JNO */
         case 0:
         {
-            Jump = State->Flags.Of;
+            Jump = Fast486GetOverflowFlag(State);
             break;
         }
 
         /* JC / JNC */
         case 1:
         {
-            Jump = State->Flags.Cf;
+            Jump = Fast486GetCarryFlag(State);
             break;
         }
 
         /* JZ / JNZ */
         case 2:
         {
-            Jump = State->Flags.Zf;
+            Jump = Fast486GetZeroFlag(State);
             break;
         }
 
         /* JBE / JNBE */
         case 3:
         {
-            Jump = State->Flags.Cf || State->Flags.Zf;
+            Jump = Fast486GetCarryFlag(State) || Fast486GetZeroFlag(State);
             break;
         }
 
         /* JS / JNS */
         case 4:
         {
-            Jump = State->Flags.Sf;
+            Jump = Fast486GetSignFlag(State);
             break;
         }
 
         /* JP / JNP */
         case 5:
         {
+            Fast486ResolveFlags(State);
             Jump = State->Flags.Pf;
             break;
         }
@@ -1924,14 +1951,15 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeConditionalJmp)
         /* JL / JNL */
         case 6:
         {
-            Jump = State->Flags.Sf != State->Flags.Of;
+            Jump = Fast486GetSignFlag(State) != Fast486GetOverflowFlag(State);
             break;
         }
 
         /* JLE / JNLE */
         case 7:
         {
-            Jump = (State->Flags.Sf != State->Flags.Of) || State->Flags.Zf;
+            Jump = (Fast486GetSignFlag(State) != Fast486GetOverflowFlag(State))
+                   || Fast486GetZeroFlag(State);
             break;
         }
     }
@@ -1972,41 +2000,42 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeConditionalSet)
         /* SETO / SETNO */
         case 0:
         {
-            Value = State->Flags.Of;
+            Value = Fast486GetOverflowFlag(State);
             break;
         }
 
         /* SETC / SETNC */
         case 1:
         {
-            Value = State->Flags.Cf;
+            Value = Fast486GetCarryFlag(State);
             break;
         }
 
         /* SETZ / SETNZ */
         case 2:
         {
-            Value = State->Flags.Zf;
+            Value = Fast486GetZeroFlag(State);
             break;
         }
 
         /* SETBE / SETNBE */
         case 3:
         {
-            Value = State->Flags.Cf || State->Flags.Zf;
+            Value = Fast486GetCarryFlag(State) || Fast486GetZeroFlag(State);
             break;
         }
 
         /* SETS / SETNS */
         case 4:
         {
-            Value = State->Flags.Sf;
+            Value = Fast486GetSignFlag(State);
             break;
         }
 
         /* SETP / SETNP */
         case 5:
         {
+            Fast486ResolveFlags(State);
             Value = State->Flags.Pf;
             break;
         }
@@ -2014,14 +2043,15 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeConditionalSet)
         /* SETL / SETNL */
         case 6:
         {
-            Value = State->Flags.Sf != State->Flags.Of;
+            Value = Fast486GetSignFlag(State) != Fast486GetOverflowFlag(State);
             break;
         }
 
         /* SETLE / SETNLE */
         case 7:
         {
-            Value = (State->Flags.Sf != State->Flags.Of) || State->Flags.Zf;
+            Value = (Fast486GetSignFlag(State) != Fast486GetOverflowFlag(State))
+                    || Fast486GetZeroFlag(State);
             break;
         }
     }
@@ -2066,6 +2096,8 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeXaddByte)
     /* Calculate the result */
     Result = Source + Destination;
 
+    Fast486ResolveFlags(State);
+
     /* Update the flags */
     State->Flags.Cf = (Result < Source) && (Result < Destination);
     State->Flags.Of = ((Source & SIGN_FLAG_BYTE) == (Destination & SIGN_FLAG_BYTE))
@@ -2106,6 +2138,8 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeXadd)
         return;
     }
 
+    Fast486ResolveFlags(State);
+
     /* Check the operand size */
     if (OperandSize)
     {
@@ -260,4 +260,12 @@ Fast486Rewind(PFAST486_STATE State)
 #endif
 }
 
+VOID
+NTAPI
+Fast486UpdateFlags(PFAST486_STATE State)
+{
+    /* Compute the flags of the last arithmetic instruction */
+    Fast486ResolveFlags(State);
+}
+
 /* EOF */
@@ -0,0 +1,362 @@
+/*
+ * PROJECT:     Fast486 386/486 CPU Emulation Library
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Host benchmark running instruction-mix programs and reporting MIPS
+ *
+ * Usage: fast486bench [-n:iterations] [-s] [program]
+ *
+ * With -s, the programs run once and their final state is printed instead,
+ * so that differently configured builds (e.g. with FAST486_NO_LAZY_FLAGS)
+ * can be diffed against each other.
+ */
+
+/* INCLUDES *******************************************************************/
+
+#include <windef.h>
+
+#include <fast486.h>
+
+#include <time.h>
+
+/* DEFINES ********************************************************************/
+
+#define BENCH_MEMORY_SIZE   0x110000
+#define BENCH_CODE_SEGMENT  0x1000
+#define BENCH_DATA_SEGMENT  0x2000
+#define BENCH_STACK_SEGMENT 0x3000
+
+typedef struct _BENCH_PROGRAM
+{
+    const char *Name;
+    const UCHAR *Code;
+    ULONG CodeSize;
+} BENCH_PROGRAM, *PBENCH_PROGRAM;
+
+/*
+ * Every program is 16-bit real mode code that runs its loop
+ * CX (or ECX) times and ends with HLT. DS = ES points to the
+ * data segment, SS:SP to the stack segment.
+ */
+
+/* Register arithmetic and conditional jumps */
+static const UCHAR AluCode[] =
+{
+    0xB9, 0x00, 0x00,               /* mov cx, 0            */
+    0x01, 0xD8,                     /* add ax, bx       l:  */
+    0x31, 0xC2,                     /* xor dx, ax           */
+    0x46,                           /* inc si               */
+    0x29, 0xF3,                     /* sub bx, si           */
+    0xD1, 0xE0,                     /* shl ax, 1            */
+    0x39, 0xD0,                     /* cmp ax, dx           */
+    0x75, 0x01,                     /* jne +1               */
+    0x90,                           /* nop                  */
+    0x49,                           /* dec cx               */
+    0x75, 0xEF,                     /* jnz l                */
+    0xF4                            /* hlt                  */
+};
+
+/* ModRM memory operands, loads and stores */
+static const UCHAR MemoryCode[] =
+{
+    0xB9, 0x00, 0x00,               /* mov cx, 0            */
+    0x31, 0xF6,                     /* xor si, si           */
+    0x89, 0x04,                     /* mov [si], ax     l:  */
+    0x8B, 0x5C, 0x02,               /* mov bx, [si+2]       */
+    0x01, 0x1C,                     /* add [si], bx         */
+    0x8B, 0x87, 0x00, 0x01,         /* mov ax, [bx+0x100]   */
+    0x83, 0xC6, 0x02,               /* add si, 2            */
+    0x81, 0xE6, 0xFF, 0x0F,         /* and si, 0x0fff       */
+    0xE2, 0xEC,                     /* loop l               */
+    0xF4                            /* hlt                  */
+};
+
+/* Operand size and segment override prefixes */
+static const UCHAR PrefixCode[] =
+{
+    0x66, 0xB9, 0x00, 0x00, 0x00, 0x00, /* mov ecx, 0           */
+    0x66, 0x01, 0xD8,               /* add eax, ebx     l:  */
+    0x66, 0x35, 0x78, 0x56, 0x34, 0x12, /* xor eax, 0x12345678 */
+    0x26, 0x8B, 0x1E, 0x10, 0x00,   /* mov bx, es:[0x10]    */
+    0x66, 0x43,                     /* inc ebx              */
+    0x2E, 0x8B, 0x16, 0x00, 0x00,   /* mov dx, cs:[0]       */
+    0x66, 0x49,                     /* dec ecx              */
+    0x75, 0xE7,                     /* jnz l                */
+    0xF4                            /* hlt                  */
+};
+
+/* Stack, calls and returns */
+static const UCHAR CallCode[] =
+{
+    0xB9, 0x00, 0x00,               /* mov cx, 0            */
+    0xEB, 0x06,                     /* jmp l                */
+    0x50,                           /* push ax          f:  */
+    0x01, 0xD8,                     /* add ax, bx           */
+    0x5B,                           /* pop bx               */
+    0xC3,                           /* ret                  */
+    0x00,
+    0x51,                           /* push cx          l:  */
+    0xE8, 0xF6, 0xFF,               /* call f               */
+    0x59,                           /* pop cx               */
+    0xE2, 0xF9,                     /* loop l               */
+    0xF4                            /* hlt                  */
+};
+
+/* String instructions, one per iteration and repeated */
+static const UCHAR StringCode[] =
+{
+    0xB9, 0x00, 0x00,               /* mov cx, 0            */
+    0xFC,                           /* cld                  */
+    0x51,                           /* push cx          l:  */
+    0x31, 0xF6,                     /* xor si, si           */
+    0xBF, 0x00, 0x08,               /* mov di, 0x800        */
+    0xB9, 0x10, 0x00,               /* mov cx, 16           */
+    0xF3, 0xA5,                     /* rep movsw            */
+    0xAD,                           /* lodsw                */
+    0xAB,                           /* stosw                */
+    0x59,                           /* pop cx               */
+    0xE2, 0xF0,                     /* loop l               */
+    0xF4                            /* hlt                  */
+};
+
+/* Code patching itself, the prefetch cache must see every write */
+static const UCHAR SelfModCode[] =
+{
+    0xB9, 0x00, 0x00,               /* mov cx, 0            */
+    0x2E, 0x80, 0x36, 0x09, 0x00, 0x03, /* xor byte cs:[9], 3 l: */
+    0x40,                           /* inc ax / inc bx      */
+    0xE2, 0xF7,                     /* loop l               */
+    0xF4                            /* hlt                  */
+};
+
+/* Arithmetic flags, read back through PUSHF, LAHF, SETcc, Jcc, ADC and DAA */
+static const UCHAR FlagsCode[] =
+{
+    0xB9, 0x00, 0x00,               /* mov cx, 0            */
+    0x05, 0x34, 0x12,               /* add ax, 0x1234   l:  */
+    0x11, 0xC3,                     /* adc bx, ax           */
+    0x9C,                           /* pushf                */
+    0x5A,                           /* pop dx               */
+    0x31, 0xD6,                     /* xor si, dx           */
+    0x19, 0xCB,                     /* sbb bx, cx           */
+    0x47,                           /* inc di               */
+    0x9F,                           /* lahf                 */
+    0x01, 0xC6,                     /* add si, ax           */
+    0x4D,                           /* dec bp               */
+    0x9C,                           /* pushf                */
+    0x5A,                           /* pop dx               */
+    0x01, 0xD6,                     /* add si, dx           */
+    0x04, 0x0F,                     /* add al, 0x0f         */
+    0x21, 0xDB,                     /* and bx, bx           */
+    0x9C,                           /* pushf                */
+    0x5A,                           /* pop dx               */
+    0x31, 0xD6,                     /* xor si, dx           */
+    0x27,                           /* daa                  */
+    0x39, 0xF3,                     /* cmp bx, si           */
+    0x7C, 0x01,                     /* jl +1                */
+    0x46,                           /* inc si               */
+    0x7A, 0x01,                     /* jp +1                */
+    0x47,                           /* inc di               */
+    0x0F, 0x90, 0xC2,               /* seto dl              */
+    0x01, 0xD6,                     /* add si, dx           */
+    0x83, 0xC3, 0xFD,               /* add bx, -3           */
+    0x83, 0xD7, 0x00,               /* adc di, 0            */
+    0x85, 0xD8,                     /* test ax, bx          */
+    0x76, 0x01,                     /* jbe +1               */
+    0x46,                           /* inc si               */
+    0x7E, 0x01,                     /* jle +1               */
+    0x47,                           /* inc di               */
+    0x83, 0xDD, 0x07,               /* sbb bp, 7            */
+    0x9C,                           /* pushf                */
+    0x5A,                           /* pop dx               */
+    0x01, 0xD6,                     /* add si, dx           */
+    0xE2, 0xBF,                     /* loop l               */
+    0xF4                            /* hlt                  */
+};
+
+static const BENCH_PROGRAM Programs[] =
+{
+    { "alu",    AluCode,    sizeof(AluCode)    },
+    { "memory", MemoryCode, sizeof(MemoryCode) },
+    { "prefix", PrefixCode, sizeof(PrefixCode) },
+    { "call",   CallCode,   sizeof(CallCode)   },
+    { "string", StringCode, sizeof(StringCode) },
+    { "selfmod", SelfModCode, sizeof(SelfModCode) },
+    { "flags",  FlagsCode,  sizeof(FlagsCode)  },
+};
+
+static PUCHAR Memory;
+
+/* PRIVATE FUNCTIONS **********************************************************/
+
+static VOID
+FASTCALL
+BenchMemRead(PFAST486_STATE State, ULONG Address, PVOID Buffer, ULONG Size)
+{
+    UNREFERENCED_PARAMETER(State);
+
+    if (Address < BENCH_MEMORY_SIZE && Size <= BENCH_MEMORY_SIZE - Address)
+        RtlCopyMemory(Buffer, &Memory[Address], Size);
+    else
+        RtlFillMemory(Buffer, Size, 0xFF);
+}
+
+static VOID
+FASTCALL
+BenchMemWrite(PFAST486_STATE State, ULONG Address, PVOID Buffer, ULONG Size)
+{
+    UNREFERENCED_PARAMETER(State);
+
+    if (Address < BENCH_MEMORY_SIZE && Size <= BENCH_MEMORY_SIZE - Address)
+        RtlCopyMemory(&Memory[Address], Buffer, Size);
+}
+
+/* Run the program once, counting the instructions like NTVDM steps them */
+static ULONGLONG
+RunProgram(PFAST486_STATE State, const BENCH_PROGRAM *Program, USHORT Count)
+{
+    ULONG CodeBase = BENCH_CODE_SEGMENT << 4;
+    ULONGLONG Instructions = 0;
+
+    RtlZeroMemory(Memory, BENCH_MEMORY_SIZE);
+    RtlCopyMemory(&Memory[CodeBase], Program->Code, Program->CodeSize);
+
+    /* The loop count is the immediate of the leading mov (e)cx */
+    if (Program->Code[0] == 0x66)
+        *(PUSHORT)&Memory[CodeBase + 2] = Count;
+    else
+        *(PUSHORT)&Memory[CodeBase + 1] = Count;
+
+    Fast486Reset(State);
+    Fast486SetSegment(State, FAST486_REG_DS, BENCH_DATA_SEGMENT);
+    Fast486SetSegment(State, FAST486_REG_ES, BENCH_DATA_SEGMENT);
+    Fast486SetStack(State, BENCH_STACK_SEGMENT, 0xFFFE);
+    Fast486ExecuteAt(State, BENCH_CODE_SEGMENT, 0);
+
+    while (!State->Halted)
+    {
+        Fast486StepInto(State);
+        Instructions++;
+    }
+
+    return Instructions;
+}
+
+static ULONGLONG
+BenchProgram(PFAST486_STATE State,
+             const BENCH_PROGRAM *Program,
+             int Iterations,
+             double *Seconds)
+{
+    ULONGLONG Instructions = 0;
+    clock_t Start;
+    int i;
+
+    Start = clock();
+    for (i = 0; i < Iterations; i++)
+        Instructions += RunProgram(State, Program, 10000);
+    *Seconds = (double)(clock() - Start) / CLOCKS_PER_SEC;
+
+    return Instructions;
+}
+
+/* Print the final registers, flags and a checksum of the memory */
+static VOID
+PrintState(const BENCH_PROGRAM *Program, PFAST486_STATE State)
+{
+    ULONG Checksum = 0;
+    ULONG i;
+
+    Fast486UpdateFlags(State);
+
+    for (i = 0; i < BENCH_MEMORY_SIZE; i++) Checksum = Checksum * 31 + Memory[i];
+
+    printf("%-8s", Program->Name);
+    for (i = 0; i < FAST486_NUM_GEN_REGS; i++) printf(" %08X", State->GeneralRegs[i].Long);
+    printf(" EIP=%08X EFLAGS=%08X MEM=%08X\n",
+           State->InstPtr.Long, State->Flags.Long, Checksum);
+}
+
+static double
+Mips(ULONGLONG Instructions, double Seconds)
+{
+    return Seconds > 0 ? Instructions / Seconds / 1e6 : 0.0;
+}
+
+/* PUBLIC FUNCTIONS ***********************************************************/
+
+int main(int argc, char *argv[])
+{
+    FAST486_STATE State;
+    const char *Only = NULL;
+    BOOLEAN ShowState = FALSE;
+    int Iterations = 200;
+    ULONGLONG Instructions, Total = 0;
+    double Seconds, TotalSeconds = 0;
+    size_t i;
+    int j;
+
+    for (j = 1; j < argc; j++)
+    {
+        if (argv[j][0] == '-' && argv[j][1] == 'n' && argv[j][2] == ':')
+            Iterations = atoi(argv[j] + 3);
+        else if (argv[j][0] == '-' && argv[j][1] == 's' && argv[j][2] == '\0')
+            ShowState = TRUE;
+        else if (argv[j][0] != '-')
+            Only = argv[j];
+        else
+            break;
+    }
+
+    if (j < argc || Iterations <= 0)
+    {
+        printf("Usage: fast486bench [-n:iterations] [-s] [program]\n");
+        return 1;
+    }
+
+    Memory = malloc(BENCH_MEMORY_SIZE);
+    if (Memory == NULL)
+        return 1;
+
+    Fast486Initialize(&State, BenchMemRead, BenchMemWrite,
+                      NULL, NULL, NULL, NULL, NULL, NULL);
+
+    if (ShowState)
+    {
+        for (i = 0; i < sizeof(Programs) / sizeof(Programs[0]); i++)
+        {
+            if (Only && strcmp(Only, Programs[i].Name) != 0)
+                continue;
+
+            RunProgram(&State, &Programs[i], 10000);
+            PrintState(&Programs[i], &State);
+        }
+
+        free(Memory);
+        return 0;
+    }
+
+    printf("%-8s %12s %16s\n", "program", "instructions", "MIPS");
+
+    for (i = 0; i < sizeof(Programs) / sizeof(Programs[0]); i++)
+    {
+        if (Only && strcmp(Only, Programs[i].Name) != 0)
+            continue;
+
+        Instructions = BenchProgram(&State, &Programs[i], Iterations, &Seconds);
+
+        printf("%-8s %12llu %16.2f\n",
+               Programs[i].Name, (unsigned long long)Instructions,
+               Mips(Instructions, Seconds));
+
+        Total += Instructions;
+        TotalSeconds += Seconds;
+    }
+
+    printf("%-8s %12llu %16.2f\n",
+           "total", (unsigned long long)Total, Mips(Total, TotalSeconds));
+
+    free(Memory);
+    return 0;
+}
+
+/* EOF */
@@ -0,0 +1,376 @@
+/*
+ * PROJECT:     Fast486 386/486 CPU Emulation Library
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Host harness running random flag-heavy programs and printing
+ *              their final state, for diffing the lazy and eager flag builds
+ *
+ * Usage: fast486diff [-n:programs] [-r:seed]
+ *
+ * The build produces this tool twice, as fast486diff with the lazy flags
+ * and as fast486diff_eager with FAST486_NO_LAZY_FLAGS. Both must print
+ * the same output for the same seed:
+ *
+ *   fast486diff -r:1 > lazy.txt
+ *   fast486diff_eager -r:1 > eager.txt
+ *   diff lazy.txt eager.txt
+ */
+
+/* INCLUDES *******************************************************************/
+
+#include <windef.h>
+
+#include <fast486.h>
+
+/* DEFINES ********************************************************************/
+
+#define DIFF_MEMORY_SIZE    0x110000
+#define DIFF_CODE_SEGMENT   0x1000
+#define DIFF_DATA_SEGMENT   0x2000
+#define DIFF_STACK_SEGMENT  0x3000
+#define DIFF_HALT_ADDRESS   0x0500
+#define DIFF_MAX_STEPS      100000
+
+static PUCHAR Memory;
+static ULONG Seed;
+static ULONG BopChecksum;
+
+/* PRIVATE FUNCTIONS **********************************************************/
+
+static ULONG
+Random(VOID)
+{
+    /* xorshift32, so that every host generates the same programs */
+    Seed ^= Seed << 13;
+    Seed ^= Seed >> 17;
+    Seed ^= Seed << 5;
+    return Seed;
+}
+
+static ULONG
+RandomBelow(ULONG Limit)
+{
+    return Random() % Limit;
+}
+
+static VOID
+FASTCALL
+DiffMemRead(PFAST486_STATE State, ULONG Address, PVOID Buffer, ULONG Size)
+{
+    UNREFERENCED_PARAMETER(State);
+
+    if (Address < DIFF_MEMORY_SIZE && Size <= DIFF_MEMORY_SIZE - Address)
+        RtlCopyMemory(Buffer, &Memory[Address], Size);
+    else
+        RtlFillMemory(Buffer, Size, 0xFF);
+}
+
+static VOID
+FASTCALL
+DiffMemWrite(PFAST486_STATE State, ULONG Address, PVOID Buffer, ULONG Size)
+{
+    UNREFERENCED_PARAMETER(State);
+
+    if (Address < DIFF_MEMORY_SIZE && Size <= DIFF_MEMORY_SIZE - Address)
+        RtlCopyMemory(&Memory[Address], Buffer, Size);
+}
+
+/* Read the flags without resolving them, like the NTVDM BOP handlers do */
+static VOID
+FASTCALL
+DiffBopCallback(PFAST486_STATE State, UCHAR BopCode)
+{
+    BopChecksum = BopChecksum * 31 + (State->Flags.Long ^ BopCode);
+
+    /* Change CF too, the following instructions must see it */
+    State->Flags.Cf = !State->Flags.Cf;
+}
+
+static VOID
+EmitImmediate(PUCHAR *Code, ULONG Size)
+{
+    while (Size--) *(*Code)++ = (UCHAR)Random();
+}
+
+/* Emit one random instruction, mostly ones that set or consume the flags */
+static VOID
+EmitInstruction(PUCHAR *Code)
+{
+    PUCHAR p = *Code;
+    BOOLEAN OperandSize = (RandomBelow(10) < 3);
+    ULONG Kind = RandomBelow(36);
+
+    /* Only prefix the instruction kinds that take a 16/32-bit operand */
+    if (OperandSize && (Kind < 16 || Kind == 23 || Kind == 24 || Kind == 26
+                        || Kind == 29 || Kind == 30 || Kind == 32 || Kind >= 34))
+    {
+        *p++ = 0x66;
+    }
+    else
+    {
+        OperandSize = FALSE;
+    }
+
+    if (Kind < 8)
+    {
+        /* ALU r/m, reg and reg, r/m */
+        *p++ = (UCHAR)((RandomBelow(8) << 3) | RandomBelow(4));
+        if (RandomBelow(10) < 3)
+        {
+            *p++ = (UCHAR)((RandomBelow(8) << 3) | 0x06);
+            *p++ = (UCHAR)Random();
+            *p++ = (UCHAR)RandomBelow(0x10);
+        }
+        else
+        {
+            *p++ = (UCHAR)(0xC0 | RandomBelow(64));
+        }
+    }
+    else if (Kind < 11)
+    {
+        /* ALU accumulator, immediate */
+        UCHAR Operation = (UCHAR)(RandomBelow(8) << 3);
+
+        if (!OperandSize && RandomBelow(2))
+        {
+            *p++ = Operation | 4;
+            EmitImmediate(&p, 1);
+        }
+        else
+        {
+            *p++ = Operation | 5;
+            EmitImmediate(&p, OperandSize ? 4 : 2);
+        }
+    }
+    else if (Kind < 14)
+    {
+        /* ALU groups 80, 81 and 83 */
+        static const UCHAR Groups[] = { 0x80, 0x81, 0x83 };
+        UCHAR Group = Groups[RandomBelow(3)];
+
+        *p++ = Group;
+        *p++ = (UCHAR)(0xC0 | RandomBelow(64));
+        EmitImmediate(&p, (Group != 0x81) ? 1 : (OperandSize ? 4 : 2));
+    }
+    else if (Kind < 16)
+    {
+        /* INC and DEC, which keep CF */
+        *p++ = (UCHAR)(0x40 + RandomBelow(16));
+    }
+    else if (Kind == 16)
+    {
+        /* TEST */
+        *p++ = (UCHAR)(0x84 + RandomBelow(2));
+        *p++ = (UCHAR)(0xC0 | RandomBelow(64));
+    }
+    else if (Kind < 19)
+    {
+        /* pushf; pop dx; add si, dx */
+        *p++ = 0x9C;
+        *p++ = 0x5A;
+        *p++ = 0x01;
+        *p++ = 0xD6;
+    }
+    else if (Kind == 19)
+    {
+        /* BOP, the callback reads and changes the flags */
+        *p++ = 0xC4;
+        *p++ = 0xC4;
+        *p++ = (UCHAR)Random();
+    }
+    else if (Kind == 20)
+    {
+        /* DAA, DAS, AAA, AAS, LAHF, CMC, CLC and STC */
+        static const UCHAR Opcodes[] = { 0x27, 0x2F, 0x37, 0x3F, 0x9F, 0xF5, 0xF8, 0xF9 };
+        *p++ = Opcodes[RandomBelow(8)];
+    }
+    else if (Kind == 21)
+    {
+        /* jcc +1; inc di */
+        *p++ = (UCHAR)(0x70 + RandomBelow(16));
+        *p++ = 0x01;
+        *p++ = 0x47;
+    }
+    else if (Kind == 22)
+    {
+        /* SETcc */
+        *p++ = 0x0F;
+        *p++ = (UCHAR)(0x90 + RandomBelow(16));
+        *p++ = (UCHAR)(0xC0 | RandomBelow(8));
+    }
+    else if (Kind == 23)
+    {
+        /* Shifts and rotates by 1 and CL */
+        static const UCHAR Opcodes[] = { 0xD0, 0xD1, 0xD3 };
+        *p++ = Opcodes[RandomBelow(3)];
+        *p++ = (UCHAR)(0xC0 | RandomBelow(64));
+    }
+    else if (Kind == 24)
+    {
+        /* BT, BTS, BTR and BTC */
+        static const UCHAR Opcodes[] = { 0xA3, 0xAB, 0xB3, 0xBB };
+        *p++ = 0x0F;
+        *p++ = Opcodes[RandomBelow(4)];
+        *p++ = (UCHAR)(0xC0 | RandomBelow(64));
+    }
+    else if (Kind == 25)
+    {
+        /* loopcc +1; inc si */
+        *p++ = (UCHAR)(0xE0 + RandomBelow(3));
+        *p++ = 0x01;
+        *p++ = 0x46;
+    }
+    else if (Kind == 26)
+    {
+        /* NOT, NEG, MUL and IMUL */
+        *p++ = (UCHAR)(0xF6 + RandomBelow(2));
+        *p++ = (UCHAR)(0xC0 | ((2 + RandomBelow(4)) << 3) | RandomBelow(8));
+    }
+    else if (Kind == 27)
+    {
+        /* MOV, which keeps the flags pending */
+        *p++ = (UCHAR)(0x88 + RandomBelow(4));
+        *p++ = (UCHAR)(0xC0 | RandomBelow(64));
+    }
+    else if (Kind == 28)
+    {
+        /* BSF, BSR and two-operand IMUL */
+        static const UCHAR Opcodes[] = { 0xBC, 0xBD, 0xAF };
+        *p++ = 0x0F;
+        *p++ = Opcodes[RandomBelow(3)];
+        *p++ = (UCHAR)(0xC0 | RandomBelow(64));
+    }
+    else if (Kind == 29)
+    {
+        /* INC and DEC through group FE/FF */
+        *p++ = (UCHAR)(0xFE + RandomBelow(2));
+        *p++ = (UCHAR)(0xC0 | (RandomBelow(2) << 3) | RandomBelow(8));
+    }
+    else if (Kind == 30)
+    {
+        /* jcc near +1; inc di */
+        *p++ = 0x0F;
+        *p++ = (UCHAR)(0x80 + RandomBelow(16));
+        *p++ = 0x01;
+        *p++ = 0x00;
+        if (OperandSize)
+        {
+            *p++ = 0x00;
+            *p++ = 0x00;
+        }
+        *p++ = 0x47;
+    }
+    else if (Kind == 31)
+    {
+        /* Change CF, then ADC or SBB */
+        static const UCHAR Opcodes[] = { 0xF5, 0xF8, 0xF9 };
+        *p++ = Opcodes[RandomBelow(3)];
+        *p++ = (UCHAR)(0x11 + RandomBelow(2) * 8);
+        *p++ = (UCHAR)(0xC0 | RandomBelow(64));
+    }
+    else if (Kind == 32)
+    {
+        /* Shifts and rotates by an immediate */
+        *p++ = (UCHAR)(0xC0 + RandomBelow(2));
+        *p++ = (UCHAR)(0xC0 | RandomBelow(64));
+        *p++ = (UCHAR)RandomBelow(40);
+    }
+    else if (Kind == 33)
+    {
+        /* mov cx, count; repe cmpsb */
+        *p++ = 0xB9;
+        *p++ = (UCHAR)RandomBelow(16);
+        *p++ = 0x00;
+        *p++ = 0xF3;
+        *p++ = 0xA6;
+    }
+    else
+    {
+        /* CMPS and SCAS */
+        *p++ = (UCHAR)(RandomBelow(2) ? 0xA7 : 0xAF);
+    }
+
+    *Code = p;
+}
+
+static VOID
+RunProgram(PFAST486_STATE State, ULONG Number)
+{
+    ULONG CodeBase = DIFF_CODE_SEGMENT << 4;
+    PUCHAR Code = &Memory[CodeBase];
+    ULONG Count = 20 + RandomBelow(180);
+    ULONG Checksum = 0;
+    ULONG Steps;
+    ULONG i;
+
+    RtlZeroMemory(Memory, DIFF_MEMORY_SIZE);
+
+    /* Stack faults and the like end the program through a HLT handler */
+    for (i = 0; i < 256; i++) ((PULONG)Memory)[i] = DIFF_HALT_ADDRESS;
+    Memory[DIFF_HALT_ADDRESS] = 0xF4;
+
+    for (i = 0; i < Count; i++) EmitInstruction(&Code);
+    *Code++ = 0xF4;
+
+    Fast486Reset(State);
+    for (i = 0; i < FAST486_NUM_GEN_REGS; i++) State->GeneralRegs[i].Long = Random();
+    State->Flags.Long = 0x0002 | (Random() & 0x08D5);
+    Fast486SetSegment(State, FAST486_REG_DS, DIFF_DATA_SEGMENT);
+    Fast486SetSegment(State, FAST486_REG_ES, DIFF_DATA_SEGMENT);
+    Fast486SetStack(State, DIFF_STACK_SEGMENT, 0xFFFE);
+    Fast486ExecuteAt(State, DIFF_CODE_SEGMENT, 0);
+
+    BopChecksum = 0;
+    for (Steps = 0; !State->Halted && Steps < DIFF_MAX_STEPS; Steps++)
+        Fast486StepInto(State);
+
+    Fast486UpdateFlags(State);
+
+    for (i = 0; i < DIFF_MEMORY_SIZE; i++) Checksum = Checksum * 31 + Memory[i];
+
+    printf("%04lu", (unsigned long)Number);
+    for (i = 0; i < FAST486_NUM_GEN_REGS; i++) printf(" %08X", State->GeneralRegs[i].Long);
+    printf(" EIP=%08X EFLAGS=%08X MEM=%08X BOP=%08X STEPS=%lu\n",
+           State->InstPtr.Long, State->Flags.Long, Checksum, BopChecksum, (unsigned long)Steps);
+}
+
+/* PUBLIC FUNCTIONS ***********************************************************/
+
+int main(int argc, char *argv[])
+{
+    FAST486_STATE State;
+    int Programs = 1000;
+    ULONG i;
+    int j;
+
+    Seed = 1;
+
+    for (j = 1; j < argc; j++)
+    {
+        if (argv[j][0] == '-' && argv[j][1] == 'n' && argv[j][2] == ':')
+            Programs = atoi(argv[j] + 3);
+        else if (argv[j][0] == '-' && argv[j][1] == 'r' && argv[j][2] == ':')
+            Seed = strtoul(argv[j] + 3, NULL, 0);
+        else
+            break;
+    }
+
+    if (j < argc || Programs <= 0 || Seed == 0)
+    {
+        printf("Usage: fast486diff [-n:programs] [-r:seed]\n");
+        return 1;
+    }
+
+    Memory = malloc(DIFF_MEMORY_SIZE);
+    if (Memory == NULL)
+        return 1;
+
+    Fast486Initialize(&State, DiffMemRead, DiffMemWrite,
+                      NULL, NULL, DiffBopCallback, NULL, NULL, NULL);
+
+    for (i = 0; i < (ULONG)Programs; i++) RunProgram(&State, i);
+
+    free(Memory);
+    return 0;
+}
+
+/* EOF */
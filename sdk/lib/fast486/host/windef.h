@@ -0,0 +1,36 @@
+/*
+ * PROJECT:     Fast486 386/486 CPU Emulation Library
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Minimal windef.h for building Fast486 as a host library
+ */
+
+#pragma once
+
+#include <typedefs.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FASTCALL
+#ifdef _MSC_VER
+#define FORCEINLINE __forceinline
+#else
+#define FORCEINLINE static inline __attribute__((always_inline))
+#endif
+
+#define C_ASSERT(e) typedef char __C_ASSERT__[(e) ? 1 : -1]
+#define UNREFERENCED_PARAMETER(P) ((void)(P))
+#define DbgPrint printf
+
+#ifndef min
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+#define RtlFillMemory(Destination, Length, Fill) memset(Destination, Fill, Length)
+#define UlongToPtr(ul) ((PVOID)(ULONG_PTR)(ul))
+
+typedef ULONGLONG *PULONGLONG;
+typedef LONGLONG *PLONGLONG;
+
+/* EOF */
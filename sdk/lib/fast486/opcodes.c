@@ -410,7 +410,8 @@ FAST486_OPCODE_HANDLER(Fast486OpcodePrefix)
 
 FAST486_OPCODE_HANDLER(Fast486OpcodeIncrement)
 {
-    ULONG Value;
+    ULONG Value, Result, SignFlag;
+    INT Reg = Opcode & 0x07;
     BOOLEAN Size = State->SegmentRegs[FAST486_REG_CS].Size;
 
     TOGGLE_OPSIZE(Size);
@@ -421,27 +422,31 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeIncrement)
 
     if (Size)
     {
-        Value = ++State->GeneralRegs[Opcode & 0x07].Long;
-
-        State->Flags.Of = (Value == SIGN_FLAG_LONG);
-        State->Flags.Sf = ((Value & SIGN_FLAG_LONG) != 0);
+        Value = State->GeneralRegs[Reg].Long;
+        Result = ++State->GeneralRegs[Reg].Long;
+        SignFlag = SIGN_FLAG_LONG;
     }
     else
     {
-        Value = ++State->GeneralRegs[Opcode & 0x07].LowWord;
-
-        State->Flags.Of = (Value == SIGN_FLAG_WORD);
-        State->Flags.Sf = ((Value & SIGN_FLAG_WORD) != 0);
-    }
-
-    State->Flags.Zf = (Value == 0);
-    State->Flags.Af = ((Value & 0x0F) == 0);
-    State->Flags.Pf = Fast486CalculateParity(LOBYTE(Value));
+        Value = State->GeneralRegs[Reg].LowWord;
+        Result = ++State->GeneralRegs[Reg].LowWord;
+        SignFlag = SIGN_FLAG_WORD;
+    }
+
+    /* Update the flags, INC keeps CF */
+    Fast486SetLazyFlags(State,
+                        FAST486_LAZY_INC,
+                        Value,
+                        1,
+                        Result,
+                        SignFlag,
+                        Fast486GetCarryFlag(State));
 }
 
 FAST486_OPCODE_HANDLER(Fast486OpcodeDecrement)
 {
-    ULONG Value;
+    ULONG Value, Result, SignFlag;
+    INT Reg = Opcode & 0x07;
     BOOLEAN Size = State->SegmentRegs[FAST486_REG_CS].Size;
 
     TOGGLE_OPSIZE(Size);
@@ -452,22 +457,25 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeDecrement)
 
     if (Size)
     {
-        Value = --State->GeneralRegs[Opcode & 0x07].Long;
-
-        State->Flags.Of = (Value == (SIGN_FLAG_LONG - 1));
-        State->Flags.Sf = ((Value & SIGN_FLAG_LONG) != 0);
+        Value = State->GeneralRegs[Reg].Long;
+        Result = --State->GeneralRegs[Reg].Long;
+        SignFlag = SIGN_FLAG_LONG;
     }
     else
     {
-        Value = --State->GeneralRegs[Opcode & 0x07].LowWord;
-
-        State->Flags.Of = (Value == (SIGN_FLAG_WORD - 1));
-        State->Flags.Sf = ((Value & SIGN_FLAG_WORD) != 0);
-    }
-
-    State->Flags.Zf = (Value == 0);
-    State->Flags.Af = ((Value & 0x0F) == 0x0F);
-    State->Flags.Pf = Fast486CalculateParity(LOBYTE(Value));
+        Value = State->GeneralRegs[Reg].LowWord;
+        Result = --State->GeneralRegs[Reg].LowWord;
+        SignFlag = SIGN_FLAG_WORD;
+    }
+
+    /* Update the flags, DEC keeps CF */
+    Fast486SetLazyFlags(State,
+                        FAST486_LAZY_DEC,
+                        Value,
+                        1,
+                        Result,
+                        SignFlag,
+                        Fast486GetCarryFlag(State));
 }
 
 FAST486_OPCODE_HANDLER(Fast486OpcodePushReg)
@@ -557,41 +565,42 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeShortConditionalJmp)
         /* JO / JNO */
         case 0:
         {
-            Jump = State->Flags.Of;
+            Jump = Fast486GetOverflowFlag(State);
             break;
         }
 
         /* JC / JNC */
         case 1:
         {
-            Jump = State->Flags.Cf;
+            Jump = Fast486GetCarryFlag(State);
             break;
         }
 
         /* JZ / JNZ */
         case 2:
         {
-            Jump = State->Flags.Zf;
+            Jump = Fast486GetZeroFlag(State);
             break;
         }
 
         /* JBE / JNBE */
         case 3:
         {
-            Jump = State->Flags.Cf || State->Flags.Zf;
+            Jump = Fast486GetCarryFlag(State) || Fast486GetZeroFlag(State);
             break;
         }
 
         /* JS / JNS */
         case 4:
         {
-            Jump = State->Flags.Sf;
+            Jump = Fast486GetSignFlag(State);
             break;
         }
 
         /* JP / JNP */
         case 5:
         {
+            Fast486ResolveFlags(State);
             Jump = State->Flags.Pf;
             break;
         }
@@ -599,14 +608,15 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeShortConditionalJmp)
         /* JL / JNL */
         case 6:
         {
-            Jump = State->Flags.Sf != State->Flags.Of;
+            Jump = Fast486GetSignFlag(State) != Fast486GetOverflowFlag(State);
             break;
         }
 
         /* JLE / JNLE */
         case 7:
         {
-            Jump = (State->Flags.Sf != State->Flags.Of) || State->Flags.Zf;
+            Jump = (Fast486GetSignFlag(State) != Fast486GetOverflowFlag(State))
+                   || Fast486GetZeroFlag(State);
             break;
         }
     }
@@ -637,6 +647,8 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeClearCarry)
 
     NO_LOCK_PREFIX();
 
+    Fast486ResolveFlags(State);
+
     /* Clear CF and return success */
     State->Flags.Cf = FALSE;
 }
@@ -648,6 +660,8 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeSetCarry)
 
     NO_LOCK_PREFIX();
 
+    Fast486ResolveFlags(State);
+
     /* Set CF and return success*/
     State->Flags.Cf = TRUE;
 }
@@ -659,6 +673,8 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeComplCarry)
 
     NO_LOCK_PREFIX();
 
+    Fast486ResolveFlags(State);
+
     /* Toggle CF and return success */
     State->Flags.Cf = !State->Flags.Cf;
     return;
@@ -1066,13 +1082,13 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAddByteModrm)
     Result = FirstValue + SecondValue;
 
     /* Update the flags */
-    State->Flags.Cf = (Result < FirstValue) && (Result < SecondValue);
-    State->Flags.Of = ((FirstValue & SIGN_FLAG_BYTE) == (SecondValue & SIGN_FLAG_BYTE))
-                      && ((FirstValue & SIGN_FLAG_BYTE) != (Result & SIGN_FLAG_BYTE));
-    State->Flags.Af = ((((FirstValue & 0x0F) + (SecondValue & 0x0F)) & 0x10) != 0);
-    State->Flags.Zf = (Result == 0);
-    State->Flags.Sf = ((Result & SIGN_FLAG_BYTE) != 0);
-    State->Flags.Pf = Fast486CalculateParity(Result);
+    Fast486SetLazyFlags(State,
+                        FAST486_LAZY_ADD,
+                        FirstValue,
+                        SecondValue,
+                        Result,
+                        SIGN_FLAG_BYTE,
+                        FALSE);
 
     /* Write back the result */
     Fast486WriteModrmByteOperands(State,
@@ -1119,13 +1135,13 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAddModrm)
         Result = FirstValue + SecondValue;
 
         /* Update the flags */
-        State->Flags.Cf = (Result < FirstValue) && (Result < SecondValue);
-        State->Flags.Of = ((FirstValue & SIGN_FLAG_LONG) == (SecondValue & SIGN_FLAG_LONG))
-                          && ((FirstValue & SIGN_FLAG_LONG) != (Result & SIGN_FLAG_LONG));
-        State->Flags.Af = ((((FirstValue & 0x0F) + (SecondValue & 0x0F)) & 0x10) != 0);
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_LONG) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLazyFlags(State,
+                            FAST486_LAZY_ADD,
+                            FirstValue,
+                            SecondValue,
+                            Result,
+                            SIGN_FLAG_LONG,
+                            FALSE);
 
         /* Write back the result */
         Fast486WriteModrmDwordOperands(State,
@@ -1150,13 +1166,13 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAddModrm)
         Result = FirstValue + SecondValue;
 
         /* Update the flags */
-        State->Flags.Cf = (Result < FirstValue) && (Result < SecondValue);
-        State->Flags.Of = ((FirstValue & SIGN_FLAG_WORD) == (SecondValue & SIGN_FLAG_WORD))
-                          && ((FirstValue & SIGN_FLAG_WORD) != (Result & SIGN_FLAG_WORD));
-        State->Flags.Af = ((((FirstValue & 0x0F) + (SecondValue & 0x0F)) & 0x10) != 0);
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_WORD) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLazyFlags(State,
+                            FAST486_LAZY_ADD,
+                            FirstValue,
+                            SecondValue,
+                            Result,
+                            SIGN_FLAG_WORD,
+                            FALSE);
 
         /* Write back the result */
         Fast486WriteModrmWordOperands(State,
@@ -1186,13 +1202,13 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAddAl)
     Result = FirstValue + SecondValue;
 
     /* Update the flags */
-    State->Flags.Cf = (Result < FirstValue) && (Result < SecondValue);
-    State->Flags.Of = ((FirstValue & SIGN_FLAG_BYTE) == (SecondValue & SIGN_FLAG_BYTE))
-                      && ((FirstValue & SIGN_FLAG_BYTE) != (Result & SIGN_FLAG_BYTE));
-    State->Flags.Af = ((((FirstValue & 0x0F) + (SecondValue & 0x0F)) & 0x10) != 0);
-    State->Flags.Zf = (Result == 0);
-    State->Flags.Sf = ((Result & SIGN_FLAG_BYTE) != 0);
-    State->Flags.Pf = Fast486CalculateParity(Result);
+    Fast486SetLazyFlags(State,
+                        FAST486_LAZY_ADD,
+                        FirstValue,
+                        SecondValue,
+                        Result,
+                        SIGN_FLAG_BYTE,
+                        FALSE);
 
     /* Write back the result */
     State->GeneralRegs[FAST486_REG_EAX].LowByte = Result;
@@ -1223,13 +1239,13 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAddEax)
         Result = FirstValue + SecondValue;
 
         /* Update the flags */
-        State->Flags.Cf = (Result < FirstValue) && (Result < SecondValue);
-        State->Flags.Of = ((FirstValue & SIGN_FLAG_LONG) == (SecondValue & SIGN_FLAG_LONG))
-                          && ((FirstValue & SIGN_FLAG_LONG) != (Result & SIGN_FLAG_LONG));
-        State->Flags.Af = ((((FirstValue & 0x0F) + (SecondValue & 0x0F)) & 0x10) != 0);
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_LONG) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLazyFlags(State,
+                            FAST486_LAZY_ADD,
+                            FirstValue,
+                            SecondValue,
+                            Result,
+                            SIGN_FLAG_LONG,
+                            FALSE);
 
         /* Write back the result */
         State->GeneralRegs[FAST486_REG_EAX].Long = Result;
@@ -1249,13 +1265,13 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAddEax)
         Result = FirstValue + SecondValue;
 
         /* Update the flags */
-        State->Flags.Cf = (Result < FirstValue) && (Result < SecondValue);
-        State->Flags.Of = ((FirstValue & SIGN_FLAG_WORD) == (SecondValue & SIGN_FLAG_WORD))
-                          && ((FirstValue & SIGN_FLAG_WORD) != (Result & SIGN_FLAG_WORD));
-        State->Flags.Af = ((((FirstValue & 0x0F) + (SecondValue & 0x0F)) & 0x10) != 0);
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_WORD) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLazyFlags(State,
+                            FAST486_LAZY_ADD,
+                            FirstValue,
+                            SecondValue,
+                            Result,
+                            SIGN_FLAG_WORD,
+                            FALSE);
 
         /* Write back the result */
         State->GeneralRegs[FAST486_REG_EAX].LowWord = Result;
@@ -1293,11 +1309,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeOrByteModrm)
     Result = FirstValue | SecondValue;
 
     /* Update the flags */
-    State->Flags.Cf = FALSE;
-    State->Flags.Of = FALSE;
-    State->Flags.Zf = (Result == 0);
-    State->Flags.Sf = ((Result & SIGN_FLAG_BYTE) != 0);
-    State->Flags.Pf = Fast486CalculateParity(Result);
+    Fast486SetLogicFlags(State, Result, SIGN_FLAG_BYTE);
 
     /* Write back the result */
     Fast486WriteModrmByteOperands(State,
@@ -1344,11 +1356,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeOrModrm)
         Result = FirstValue | SecondValue;
 
         /* Update the flags */
-        State->Flags.Cf = FALSE;
-        State->Flags.Of = FALSE;
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_LONG) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLogicFlags(State, Result, SIGN_FLAG_LONG);
 
         /* Write back the result */
         Fast486WriteModrmDwordOperands(State,
@@ -1373,11 +1381,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeOrModrm)
         Result = FirstValue | SecondValue;
 
         /* Update the flags */
-        State->Flags.Cf = FALSE;
-        State->Flags.Of = FALSE;
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_WORD) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLogicFlags(State, Result, SIGN_FLAG_WORD);
 
         /* Write back the result */
         Fast486WriteModrmWordOperands(State,
@@ -1407,11 +1411,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeOrAl)
     Result = FirstValue | SecondValue;
 
     /* Update the flags */
-    State->Flags.Cf = FALSE;
-    State->Flags.Of = FALSE;
-    State->Flags.Zf = (Result == 0);
-    State->Flags.Sf = ((Result & SIGN_FLAG_BYTE) != 0);
-    State->Flags.Pf = Fast486CalculateParity(Result);
+    Fast486SetLogicFlags(State, Result, SIGN_FLAG_BYTE);
 
     /* Write back the result */
     State->GeneralRegs[FAST486_REG_EAX].LowByte = Result;
@@ -1442,11 +1442,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeOrEax)
         Result = FirstValue | SecondValue;
 
         /* Update the flags */
-        State->Flags.Cf = FALSE;
-        State->Flags.Of = FALSE;
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_LONG) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLogicFlags(State, Result, SIGN_FLAG_LONG);
 
         /* Write back the result */
         State->GeneralRegs[FAST486_REG_EAX].Long = Result;
@@ -1466,11 +1462,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeOrEax)
         Result = FirstValue | SecondValue;
 
         /* Update the flags */
-        State->Flags.Cf = FALSE;
-        State->Flags.Of = FALSE;
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_WORD) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLogicFlags(State, Result, SIGN_FLAG_WORD);
 
         /* Write back the result */
         State->GeneralRegs[FAST486_REG_EAX].LowWord = Result;
@@ -1508,11 +1500,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAndByteModrm)
     Result = FirstValue & SecondValue;
 
     /* Update the flags */
-    State->Flags.Cf = FALSE;
-    State->Flags.Of = FALSE;
-    State->Flags.Zf = (Result == 0);
-    State->Flags.Sf = ((Result & SIGN_FLAG_BYTE) != 0);
-    State->Flags.Pf = Fast486CalculateParity(Result);
+    Fast486SetLogicFlags(State, Result, SIGN_FLAG_BYTE);
 
     /* Write back the result */
     Fast486WriteModrmByteOperands(State,
@@ -1559,11 +1547,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAndModrm)
         Result = FirstValue & SecondValue;
 
         /* Update the flags */
-        State->Flags.Cf = FALSE;
-        State->Flags.Of = FALSE;
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_LONG) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLogicFlags(State, Result, SIGN_FLAG_LONG);
 
         /* Write back the result */
         Fast486WriteModrmDwordOperands(State,
@@ -1588,11 +1572,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAndModrm)
         Result = FirstValue & SecondValue;
 
         /* Update the flags */
-        State->Flags.Cf = FALSE;
-        State->Flags.Of = FALSE;
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_WORD) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLogicFlags(State, Result, SIGN_FLAG_WORD);
 
         /* Write back the result */
         Fast486WriteModrmWordOperands(State,
@@ -1622,11 +1602,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAndAl)
     Result = FirstValue & SecondValue;
 
     /* Update the flags */
-    State->Flags.Cf = FALSE;
-    State->Flags.Of = FALSE;
-    State->Flags.Zf = (Result == 0);
-    State->Flags.Sf = ((Result & SIGN_FLAG_BYTE) != 0);
-    State->Flags.Pf = Fast486CalculateParity(Result);
+    Fast486SetLogicFlags(State, Result, SIGN_FLAG_BYTE);
 
     /* Write back the result */
     State->GeneralRegs[FAST486_REG_EAX].LowByte = Result;
@@ -1657,11 +1633,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAndEax)
         Result = FirstValue & SecondValue;
 
         /* Update the flags */
-        State->Flags.Cf = FALSE;
-        State->Flags.Of = FALSE;
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_LONG) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLogicFlags(State, Result, SIGN_FLAG_LONG);
 
         /* Write back the result */
         State->GeneralRegs[FAST486_REG_EAX].Long = Result;
@@ -1681,11 +1653,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAndEax)
         Result = FirstValue & SecondValue;
 
         /* Update the flags */
-        State->Flags.Cf = FALSE;
-        State->Flags.Of = FALSE;
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_WORD) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLogicFlags(State, Result, SIGN_FLAG_WORD);
 
         /* Write back the result */
         State->GeneralRegs[FAST486_REG_EAX].LowWord = Result;
@@ -1723,11 +1691,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeXorByteModrm)
     Result = FirstValue ^ SecondValue;
 
     /* Update the flags */
-    State->Flags.Cf = FALSE;
-    State->Flags.Of = FALSE;
-    State->Flags.Zf = (Result == 0);
-    State->Flags.Sf = ((Result & SIGN_FLAG_BYTE) != 0);
-    State->Flags.Pf = Fast486CalculateParity(Result);
+    Fast486SetLogicFlags(State, Result, SIGN_FLAG_BYTE);
 
     /* Write back the result */
     Fast486WriteModrmByteOperands(State,
@@ -1774,11 +1738,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeXorModrm)
         Result = FirstValue ^ SecondValue;
 
         /* Update the flags */
-        State->Flags.Cf = FALSE;
-        State->Flags.Of = FALSE;
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_LONG) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLogicFlags(State, Result, SIGN_FLAG_LONG);
 
         /* Write back the result */
         Fast486WriteModrmDwordOperands(State,
@@ -1803,11 +1763,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeXorModrm)
         Result = FirstValue ^ SecondValue;
 
         /* Update the flags */
-        State->Flags.Cf = FALSE;
-        State->Flags.Of = FALSE;
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_WORD) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLogicFlags(State, Result, SIGN_FLAG_WORD);
 
         /* Write back the result */
         Fast486WriteModrmWordOperands(State,
@@ -1837,11 +1793,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeXorAl)
     Result = FirstValue ^ SecondValue;
 
     /* Update the flags */
-    State->Flags.Cf = FALSE;
-    State->Flags.Of = FALSE;
-    State->Flags.Zf = (Result == 0);
-    State->Flags.Sf = ((Result & SIGN_FLAG_BYTE) != 0);
-    State->Flags.Pf = Fast486CalculateParity(Result);
+    Fast486SetLogicFlags(State, Result, SIGN_FLAG_BYTE);
 
     /* Write back the result */
     State->GeneralRegs[FAST486_REG_EAX].LowByte = Result;
@@ -1872,11 +1824,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeXorEax)
         Result = FirstValue ^ SecondValue;
 
         /* Update the flags */
-        State->Flags.Cf = FALSE;
-        State->Flags.Of = FALSE;
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_LONG) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLogicFlags(State, Result, SIGN_FLAG_LONG);
 
         /* Write back the result */
         State->GeneralRegs[FAST486_REG_EAX].Long = Result;
@@ -1896,11 +1844,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeXorEax)
         Result = FirstValue ^ SecondValue;
 
         /* Update the flags */
-        State->Flags.Cf = FALSE;
-        State->Flags.Of = FALSE;
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_WORD) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLogicFlags(State, Result, SIGN_FLAG_WORD);
 
         /* Write back the result */
         State->GeneralRegs[FAST486_REG_EAX].LowWord = Result;
@@ -1937,11 +1881,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeTestByteModrm)
     Result = FirstValue & SecondValue;
 
     /* Update the flags */
-    State->Flags.Cf = FALSE;
-    State->Flags.Of = FALSE;
-    State->Flags.Zf = (Result == 0);
-    State->Flags.Sf = ((Result & SIGN_FLAG_BYTE) != 0);
-    State->Flags.Pf = Fast486CalculateParity(Result);
+    Fast486SetLogicFlags(State, Result, SIGN_FLAG_BYTE);
 }
 
 FAST486_OPCODE_HANDLER(Fast486OpcodeTestModrm)
@@ -1982,11 +1922,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeTestModrm)
         Result = FirstValue & SecondValue;
 
         /* Update the flags */
-        State->Flags.Cf = FALSE;
-        State->Flags.Of = FALSE;
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_LONG) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLogicFlags(State, Result, SIGN_FLAG_LONG);
     }
     else
     {
@@ -2005,11 +1941,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeTestModrm)
         Result = FirstValue & SecondValue;
 
         /* Update the flags */
-        State->Flags.Cf = FALSE;
-        State->Flags.Of = FALSE;
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_WORD) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLogicFlags(State, Result, SIGN_FLAG_WORD);
     }
 }
 
@@ -2033,11 +1965,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeTestAl)
     Result = FirstValue & SecondValue;
 
     /* Update the flags */
-    State->Flags.Cf = FALSE;
-    State->Flags.Of = FALSE;
-    State->Flags.Zf = (Result == 0);
-    State->Flags.Sf = ((Result & SIGN_FLAG_BYTE) != 0);
-    State->Flags.Pf = Fast486CalculateParity(Result);
+    Fast486SetLogicFlags(State, Result, SIGN_FLAG_BYTE);
 }
 
 FAST486_OPCODE_HANDLER(Fast486OpcodeTestEax)
@@ -2065,11 +1993,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeTestEax)
         Result = FirstValue & SecondValue;
 
         /* Update the flags */
-        State->Flags.Cf = FALSE;
-        State->Flags.Of = FALSE;
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_LONG) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLogicFlags(State, Result, SIGN_FLAG_LONG);
     }
     else
     {
@@ -2086,11 +2010,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeTestEax)
         Result = FirstValue & SecondValue;
 
         /* Update the flags */
-        State->Flags.Cf = FALSE;
-        State->Flags.Of = FALSE;
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_WORD) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLogicFlags(State, Result, SIGN_FLAG_WORD);
     }
 }
 
@@ -2250,6 +2170,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAdcByteModrm)
     UCHAR FirstValue, SecondValue, Result;
     FAST486_MOD_REG_RM ModRegRm;
     BOOLEAN AddressSize = State->SegmentRegs[FAST486_REG_CS].Size;
+    INT Carry = Fast486GetCarryFlag(State) ? 1 : 0;
 
     /* Make sure this is the right instruction */
     ASSERT((Opcode & 0xFD) == 0x10);
@@ -2273,20 +2194,16 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAdcByteModrm)
     }
 
     /* Calculate the result */
-    Result = FirstValue + SecondValue + State->Flags.Cf;
-
-    /* Special exception for CF */
-    State->Flags.Cf = State->Flags.Cf
-                      && ((FirstValue == 0xFF) || (SecondValue == 0xFF));
+    Result = FirstValue + SecondValue + Carry;
 
     /* Update the flags */
-    State->Flags.Cf = State->Flags.Cf || ((Result < FirstValue) && (Result < SecondValue));
-    State->Flags.Of = ((FirstValue & SIGN_FLAG_BYTE) == (SecondValue & SIGN_FLAG_BYTE))
-                      && ((FirstValue & SIGN_FLAG_BYTE) != (Result & SIGN_FLAG_BYTE));
-    State->Flags.Af = ((FirstValue ^ SecondValue ^ Result) & 0x10) != 0;
-    State->Flags.Zf = (Result == 0);
-    State->Flags.Sf = ((Result & SIGN_FLAG_BYTE) != 0);
-    State->Flags.Pf = Fast486CalculateParity(Result);
+    Fast486SetLazyFlags(State,
+                        FAST486_LAZY_ADD,
+                        FirstValue,
+                        SecondValue,
+                        Result,
+                        SIGN_FLAG_BYTE,
+                        Carry);
 
     /* Write back the result */
     Fast486WriteModrmByteOperands(State,
@@ -2299,6 +2216,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAdcModrm)
 {
     FAST486_MOD_REG_RM ModRegRm;
     BOOLEAN OperandSize, AddressSize;
+    INT Carry = Fast486GetCarryFlag(State) ? 1 : 0;
 
     /* Make sure this is the right instruction */
     ASSERT((Opcode & 0xFD) == 0x11);
@@ -2330,20 +2248,16 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAdcModrm)
         }
 
         /* Calculate the result */
-        Result = FirstValue + SecondValue + State->Flags.Cf;
-
-        /* Special exception for CF */
-        State->Flags.Cf = State->Flags.Cf
-                          && ((FirstValue == 0xFFFFFFFF) || (SecondValue == 0xFFFFFFFF));
+        Result = FirstValue + SecondValue + Carry;
 
         /* Update the flags */
-        State->Flags.Cf = State->Flags.Cf || ((Result < FirstValue) && (Result < SecondValue));
-        State->Flags.Of = ((FirstValue & SIGN_FLAG_LONG) == (SecondValue & SIGN_FLAG_LONG))
-                          && ((FirstValue & SIGN_FLAG_LONG) != (Result & SIGN_FLAG_LONG));
-        State->Flags.Af = ((FirstValue ^ SecondValue ^ Result) & 0x10) != 0;
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_LONG) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLazyFlags(State,
+                            FAST486_LAZY_ADD,
+                            FirstValue,
+                            SecondValue,
+                            Result,
+                            SIGN_FLAG_LONG,
+                            Carry);
 
         /* Write back the result */
         Fast486WriteModrmDwordOperands(State,
@@ -2365,20 +2279,16 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAdcModrm)
         }
 
         /* Calculate the result */
-        Result = FirstValue + SecondValue + State->Flags.Cf;
-
-        /* Special exception for CF */
-        State->Flags.Cf = State->Flags.Cf
-                          && ((FirstValue == 0xFFFF) || (SecondValue == 0xFFFF));
+        Result = FirstValue + SecondValue + Carry;
 
         /* Update the flags */
-        State->Flags.Cf = State->Flags.Cf || ((Result < FirstValue) && (Result < SecondValue));
-        State->Flags.Of = ((FirstValue & SIGN_FLAG_WORD) == (SecondValue & SIGN_FLAG_WORD))
-                          && ((FirstValue & SIGN_FLAG_WORD) != (Result & SIGN_FLAG_WORD));
-        State->Flags.Af = ((FirstValue ^ SecondValue ^ Result) & 0x10) != 0;
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_WORD) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLazyFlags(State,
+                            FAST486_LAZY_ADD,
+                            FirstValue,
+                            SecondValue,
+                            Result,
+                            SIGN_FLAG_WORD,
+                            Carry);
 
         /* Write back the result */
         Fast486WriteModrmWordOperands(State,
@@ -2393,6 +2303,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAdcAl)
 {
     UCHAR FirstValue = State->GeneralRegs[FAST486_REG_EAX].LowByte;
     UCHAR SecondValue, Result;
+    INT Carry = Fast486GetCarryFlag(State) ? 1 : 0;
 
     /* Make sure this is the right instruction */
     ASSERT(Opcode == 0x14);
@@ -2406,20 +2317,16 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAdcAl)
     }
 
     /* Calculate the result */
-    Result = FirstValue + SecondValue + State->Flags.Cf;
-
-    /* Special exception for CF */
-    State->Flags.Cf = State->Flags.Cf &&
-                      ((FirstValue == 0xFF) || (SecondValue == 0xFF));
+    Result = FirstValue + SecondValue + Carry;
 
     /* Update the flags */
-    State->Flags.Cf = State->Flags.Cf || ((Result < FirstValue) && (Result < SecondValue));
-    State->Flags.Of = ((FirstValue & SIGN_FLAG_BYTE) == (SecondValue & SIGN_FLAG_BYTE))
-                      && ((FirstValue & SIGN_FLAG_BYTE) != (Result & SIGN_FLAG_BYTE));
-    State->Flags.Af = ((FirstValue ^ SecondValue ^ Result) & 0x10) != 0;
-    State->Flags.Zf = (Result == 0);
-    State->Flags.Sf = ((Result & SIGN_FLAG_BYTE) != 0);
-    State->Flags.Pf = Fast486CalculateParity(Result);
+    Fast486SetLazyFlags(State,
+                        FAST486_LAZY_ADD,
+                        FirstValue,
+                        SecondValue,
+                        Result,
+                        SIGN_FLAG_BYTE,
+                        Carry);
 
     /* Write back the result */
     State->GeneralRegs[FAST486_REG_EAX].LowByte = Result;
@@ -2428,6 +2335,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAdcAl)
 FAST486_OPCODE_HANDLER(Fast486OpcodeAdcEax)
 {
     BOOLEAN Size = State->SegmentRegs[FAST486_REG_CS].Size;
+    INT Carry = Fast486GetCarryFlag(State) ? 1 : 0;
 
     /* Make sure this is the right instruction */
     ASSERT(Opcode == 0x15);
@@ -2447,20 +2355,16 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAdcEax)
         }
 
         /* Calculate the result */
-        Result = FirstValue + SecondValue + State->Flags.Cf;
-
-        /* Special exception for CF */
-        State->Flags.Cf = State->Flags.Cf &&
-                          ((FirstValue == 0xFFFFFFFF) || (SecondValue == 0xFFFFFFFF));
+        Result = FirstValue + SecondValue + Carry;
 
         /* Update the flags */
-        State->Flags.Cf = State->Flags.Cf || ((Result < FirstValue) && (Result < SecondValue));
-        State->Flags.Of = ((FirstValue & SIGN_FLAG_LONG) == (SecondValue & SIGN_FLAG_LONG))
-                          && ((FirstValue & SIGN_FLAG_LONG) != (Result & SIGN_FLAG_LONG));
-        State->Flags.Af = ((FirstValue ^ SecondValue ^ Result) & 0x10) != 0;
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_LONG) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLazyFlags(State,
+                            FAST486_LAZY_ADD,
+                            FirstValue,
+                            SecondValue,
+                            Result,
+                            SIGN_FLAG_LONG,
+                            Carry);
 
         /* Write back the result */
         State->GeneralRegs[FAST486_REG_EAX].Long = Result;
@@ -2477,20 +2381,16 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAdcEax)
         }
 
         /* Calculate the result */
-        Result = FirstValue + SecondValue + State->Flags.Cf;
-
-        /* Special exception for CF */
-        State->Flags.Cf = State->Flags.Cf &&
-                          ((FirstValue == 0xFFFF) || (SecondValue == 0xFFFF));
+        Result = FirstValue + SecondValue + Carry;
 
         /* Update the flags */
-        State->Flags.Cf = State->Flags.Cf || ((Result < FirstValue) && (Result < SecondValue));
-        State->Flags.Of = ((FirstValue & SIGN_FLAG_WORD) == (SecondValue & SIGN_FLAG_WORD))
-                          && ((FirstValue & SIGN_FLAG_WORD) != (Result & SIGN_FLAG_WORD));
-        State->Flags.Af = ((FirstValue ^ SecondValue ^ Result) & 0x10) != 0;
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_WORD) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLazyFlags(State,
+                            FAST486_LAZY_ADD,
+                            FirstValue,
+                            SecondValue,
+                            Result,
+                            SIGN_FLAG_WORD,
+                            Carry);
 
         /* Write back the result */
         State->GeneralRegs[FAST486_REG_EAX].LowWord = Result;
@@ -2526,7 +2426,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeSbbByteModrm)
     UCHAR FirstValue, SecondValue, Result;
     FAST486_MOD_REG_RM ModRegRm;
     BOOLEAN AddressSize = State->SegmentRegs[FAST486_REG_CS].Size;
-    INT Carry = State->Flags.Cf ? 1 : 0;
+    INT Carry = Fast486GetCarryFlag(State) ? 1 : 0;
 
     /* Make sure this is the right instruction */
     ASSERT((Opcode & 0xFD) == 0x18);
@@ -2560,13 +2460,13 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeSbbByteModrm)
     Result = FirstValue - SecondValue - Carry;
 
     /* Update the flags */
-    State->Flags.Cf = Carry ? (FirstValue <= SecondValue) : (FirstValue < SecondValue);
-    State->Flags.Of = ((FirstValue & SIGN_FLAG_BYTE) != (SecondValue & SIGN_FLAG_BYTE))
-                      && ((FirstValue & SIGN_FLAG_BYTE) != (Result & SIGN_FLAG_BYTE));
-    State->Flags.Af = ((FirstValue ^ SecondValue ^ Result) & 0x10) != 0;
-    State->Flags.Zf = (Result == 0);
-    State->Flags.Sf = ((Result & SIGN_FLAG_BYTE) != 0);
-    State->Flags.Pf = Fast486CalculateParity(Result);
+    Fast486SetLazyFlags(State,
+                        FAST486_LAZY_SUB,
+                        FirstValue,
+                        SecondValue,
+                        Result,
+                        SIGN_FLAG_BYTE,
+                        Carry);
 
     /* Write back the result */
     Fast486WriteModrmByteOperands(State,
@@ -2579,7 +2479,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeSbbModrm)
 {
     FAST486_MOD_REG_RM ModRegRm;
     BOOLEAN OperandSize, AddressSize;
-    INT Carry = State->Flags.Cf ? 1 : 0;
+    INT Carry = Fast486GetCarryFlag(State) ? 1 : 0;
 
     /* Make sure this is the right instruction */
     ASSERT((Opcode & 0xFD) == 0x19);
@@ -2621,13 +2521,13 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeSbbModrm)
         Result = FirstValue - SecondValue - Carry;
 
         /* Update the flags */
-        State->Flags.Cf = Carry ? (FirstValue <= SecondValue) : (FirstValue < SecondValue);
-        State->Flags.Of = ((FirstValue & SIGN_FLAG_LONG) != (SecondValue & SIGN_FLAG_LONG))
-                          && ((FirstValue & SIGN_FLAG_LONG) != (Result & SIGN_FLAG_LONG));
-        State->Flags.Af = ((FirstValue ^ SecondValue ^ Result) & 0x10) != 0;
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_LONG) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLazyFlags(State,
+                            FAST486_LAZY_SUB,
+                            FirstValue,
+                            SecondValue,
+                            Result,
+                            SIGN_FLAG_LONG,
+                            Carry);
 
         /* Write back the result */
         Fast486WriteModrmDwordOperands(State,
@@ -2659,13 +2559,13 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeSbbModrm)
         Result = FirstValue - SecondValue - Carry;
 
         /* Update the flags */
-        State->Flags.Cf = Carry ? (FirstValue <= SecondValue) : (FirstValue < SecondValue);
-        State->Flags.Of = ((FirstValue & SIGN_FLAG_WORD) != (SecondValue & SIGN_FLAG_WORD))
-                          && ((FirstValue & SIGN_FLAG_WORD) != (Result & SIGN_FLAG_WORD));
-        State->Flags.Af = ((FirstValue ^ SecondValue ^ Result) & 0x10) != 0;
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_WORD) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLazyFlags(State,
+                            FAST486_LAZY_SUB,
+                            FirstValue,
+                            SecondValue,
+                            Result,
+                            SIGN_FLAG_WORD,
+                            Carry);
 
         /* Write back the result */
         Fast486WriteModrmWordOperands(State,
@@ -2679,7 +2579,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeSbbAl)
 {
     UCHAR FirstValue = State->GeneralRegs[FAST486_REG_EAX].LowByte;
     UCHAR SecondValue, Result;
-    INT Carry = State->Flags.Cf ? 1 : 0;
+    INT Carry = Fast486GetCarryFlag(State) ? 1 : 0;
 
     /* Make sure this is the right instruction */
     ASSERT(Opcode == 0x1C);
@@ -2696,13 +2596,13 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeSbbAl)
     Result = FirstValue - SecondValue - Carry;
 
     /* Update the flags */
-    State->Flags.Cf = Carry ? (FirstValue <= SecondValue) : (FirstValue < SecondValue);
-    State->Flags.Of = ((FirstValue & SIGN_FLAG_BYTE) != (SecondValue & SIGN_FLAG_BYTE))
-                      && ((FirstValue & SIGN_FLAG_BYTE) != (Result & SIGN_FLAG_BYTE));
-    State->Flags.Af = ((FirstValue ^ SecondValue ^ Result) & 0x10) != 0;
-    State->Flags.Zf = (Result == 0);
-    State->Flags.Sf = ((Result & SIGN_FLAG_BYTE) != 0);
-    State->Flags.Pf = Fast486CalculateParity(Result);
+    Fast486SetLazyFlags(State,
+                        FAST486_LAZY_SUB,
+                        FirstValue,
+                        SecondValue,
+                        Result,
+                        SIGN_FLAG_BYTE,
+                        Carry);
 
     /* Write back the result */
     State->GeneralRegs[FAST486_REG_EAX].LowByte = Result;
@@ -2711,7 +2611,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeSbbAl)
 FAST486_OPCODE_HANDLER(Fast486OpcodeSbbEax)
 {
     BOOLEAN Size = State->SegmentRegs[FAST486_REG_CS].Size;
-    INT Carry = State->Flags.Cf ? 1 : 0;
+    INT Carry = Fast486GetCarryFlag(State) ? 1 : 0;
 
     /* Make sure this is the right instruction */
     ASSERT(Opcode == 0x1D);
@@ -2734,13 +2634,13 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeSbbEax)
         Result = FirstValue - SecondValue - Carry;
 
         /* Update the flags */
-        State->Flags.Cf = Carry ? (FirstValue <= SecondValue) : (FirstValue < SecondValue);
-        State->Flags.Of = ((FirstValue & SIGN_FLAG_LONG) != (SecondValue & SIGN_FLAG_LONG))
-                          && ((FirstValue & SIGN_FLAG_LONG) != (Result & SIGN_FLAG_LONG));
-        State->Flags.Af = ((FirstValue ^ SecondValue ^ Result) & 0x10) != 0;
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_LONG) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLazyFlags(State,
+                            FAST486_LAZY_SUB,
+                            FirstValue,
+                            SecondValue,
+                            Result,
+                            SIGN_FLAG_LONG,
+                            Carry);
 
         /* Write back the result */
         State->GeneralRegs[FAST486_REG_EAX].Long = Result;
@@ -2760,13 +2660,13 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeSbbEax)
         Result = FirstValue - SecondValue - Carry;
 
         /* Update the flags */
-        State->Flags.Cf = Carry ? (FirstValue <= SecondValue) : (FirstValue < SecondValue);
-        State->Flags.Of = ((FirstValue & SIGN_FLAG_WORD) != (SecondValue & SIGN_FLAG_WORD))
-                          && ((FirstValue & SIGN_FLAG_WORD) != (Result & SIGN_FLAG_WORD));
-        State->Flags.Af = ((FirstValue ^ SecondValue ^ Result) & 0x10) != 0;
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_WORD) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLazyFlags(State,
+                            FAST486_LAZY_SUB,
+                            FirstValue,
+                            SecondValue,
+                            Result,
+                            SIGN_FLAG_WORD,
+                            Carry);
 
         /* Write back the result */
         State->GeneralRegs[FAST486_REG_EAX].LowWord = Result;
@@ -2796,7 +2696,10 @@ FAST486_OPCODE_HANDLER(Fast486OpcodePopDs)
 FAST486_OPCODE_HANDLER(Fast486OpcodeDaa)
 {
     UCHAR Value = State->GeneralRegs[FAST486_REG_EAX].LowByte;
-    BOOLEAN Carry = State->Flags.Cf;
+    BOOLEAN Carry;
+
+    Fast486ResolveFlags(State);
+    Carry = State->Flags.Cf;
 
     /* Clear the carry flag */
     State->Flags.Cf = FALSE;
@@ -2872,13 +2775,13 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeCmpSubByteModrm)
     Result = FirstValue - SecondValue;
 
     /* Update the flags */
-    State->Flags.Cf = (FirstValue < SecondValue);
-    State->Flags.Of = ((FirstValue & SIGN_FLAG_BYTE) != (SecondValue & SIGN_FLAG_BYTE))
-                      && ((FirstValue & SIGN_FLAG_BYTE) != (Result & SIGN_FLAG_BYTE));
-    State->Flags.Af = (FirstValue & 0x0F) < (SecondValue & 0x0F);
-    State->Flags.Zf = (Result == 0);
-    State->Flags.Sf = ((Result & SIGN_FLAG_BYTE) != 0);
-    State->Flags.Pf = Fast486CalculateParity(Result);
+    Fast486SetLazyFlags(State,
+                        FAST486_LAZY_SUB,
+                        FirstValue,
+                        SecondValue,
+                        Result,
+                        SIGN_FLAG_BYTE,
+                        FALSE);
 
     /* Check if this is not a CMP */
     if (!(Opcode & 0x10))
@@ -2936,13 +2839,13 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeCmpSubModrm)
         Result = FirstValue - SecondValue;
 
         /* Update the flags */
-        State->Flags.Cf = (FirstValue < SecondValue);
-        State->Flags.Of = ((FirstValue & SIGN_FLAG_LONG) != (SecondValue & SIGN_FLAG_LONG))
-                          && ((FirstValue & SIGN_FLAG_LONG) != (Result & SIGN_FLAG_LONG));
-        State->Flags.Af = (FirstValue & 0x0F) < (SecondValue & 0x0F);
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_LONG) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLazyFlags(State,
+                            FAST486_LAZY_SUB,
+                            FirstValue,
+                            SecondValue,
+                            Result,
+                            SIGN_FLAG_LONG,
+                            FALSE);
 
         /* Check if this is not a CMP */
         if (!(Opcode & 0x10))
@@ -2978,13 +2881,13 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeCmpSubModrm)
         Result = FirstValue - SecondValue;
 
         /* Update the flags */
-        State->Flags.Cf = (FirstValue < SecondValue);
-        State->Flags.Of = ((FirstValue & SIGN_FLAG_WORD) != (SecondValue & SIGN_FLAG_WORD))
-                          && ((FirstValue & SIGN_FLAG_WORD) != (Result & SIGN_FLAG_WORD));
-        State->Flags.Af = (FirstValue & 0x0F) < (SecondValue & 0x0F);
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_WORD) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLazyFlags(State,
+                            FAST486_LAZY_SUB,
+                            FirstValue,
+                            SecondValue,
+                            Result,
+                            SIGN_FLAG_WORD,
+                            FALSE);
 
         /* Check if this is not a CMP */
         if (!(Opcode & 0x10))
@@ -3018,13 +2921,13 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeCmpSubAl)
     Result = FirstValue - SecondValue;
 
     /* Update the flags */
-    State->Flags.Cf = (FirstValue < SecondValue);
-    State->Flags.Of = ((FirstValue & SIGN_FLAG_BYTE) != (SecondValue & SIGN_FLAG_BYTE))
-                      && ((FirstValue & SIGN_FLAG_BYTE) != (Result & SIGN_FLAG_BYTE));
-    State->Flags.Af = (FirstValue & 0x0F) < (SecondValue & 0x0F);
-    State->Flags.Zf = (Result == 0);
-    State->Flags.Sf = ((Result & SIGN_FLAG_BYTE) != 0);
-    State->Flags.Pf = Fast486CalculateParity(Result);
+    Fast486SetLazyFlags(State,
+                        FAST486_LAZY_SUB,
+                        FirstValue,
+                        SecondValue,
+                        Result,
+                        SIGN_FLAG_BYTE,
+                        FALSE);
 
     /* Check if this is not a CMP */
     if (!(Opcode & 0x10))
@@ -3059,13 +2962,13 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeCmpSubEax)
         Result = FirstValue - SecondValue;
 
         /* Update the flags */
-        State->Flags.Cf = (FirstValue < SecondValue);
-        State->Flags.Of = ((FirstValue & SIGN_FLAG_LONG) != (SecondValue & SIGN_FLAG_LONG))
-                          && ((FirstValue & SIGN_FLAG_LONG) != (Result & SIGN_FLAG_LONG));
-        State->Flags.Af = (FirstValue & 0x0F) < (SecondValue & 0x0F);
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_LONG) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLazyFlags(State,
+                            FAST486_LAZY_SUB,
+                            FirstValue,
+                            SecondValue,
+                            Result,
+                            SIGN_FLAG_LONG,
+                            FALSE);
 
         /* Check if this is not a CMP */
         if (!(Opcode & 0x10))
@@ -3089,13 +2992,13 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeCmpSubEax)
         Result = FirstValue - SecondValue;
 
         /* Update the flags */
-        State->Flags.Cf = (FirstValue < SecondValue);
-        State->Flags.Of = ((FirstValue & SIGN_FLAG_WORD) != (SecondValue & SIGN_FLAG_WORD))
-                          && ((FirstValue & SIGN_FLAG_WORD) != (Result & SIGN_FLAG_WORD));
-        State->Flags.Af = (FirstValue & 0x0F) < (SecondValue & 0x0F);
-        State->Flags.Zf = (Result == 0);
-        State->Flags.Sf = ((Result & SIGN_FLAG_WORD) != 0);
-        State->Flags.Pf = Fast486CalculateParity(Result);
+        Fast486SetLazyFlags(State,
+                            FAST486_LAZY_SUB,
+                            FirstValue,
+                            SecondValue,
+                            Result,
+                            SIGN_FLAG_WORD,
+                            FALSE);
 
         /* Check if this is not a CMP */
         if (!(Opcode & 0x10))
@@ -3109,7 +3012,10 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeCmpSubEax)
 FAST486_OPCODE_HANDLER(Fast486OpcodeDas)
 {
     UCHAR Value = State->GeneralRegs[FAST486_REG_EAX].LowByte;
-    BOOLEAN Carry = State->Flags.Cf;
+    BOOLEAN Carry;
+
+    Fast486ResolveFlags(State);
+    Carry = State->Flags.Cf;
 
     /* Clear the carry flag */
     State->Flags.Cf = FALSE;
@@ -3151,6 +3057,8 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAaa)
 {
     UCHAR Value = State->GeneralRegs[FAST486_REG_EAX].LowByte;
 
+    Fast486ResolveFlags(State);
+
     /*
      * Check if the value in AL is not a valid BCD digit,
      * or there was a carry from the lowest 4 bits of AL
@@ -3178,6 +3086,8 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAas)
 {
     UCHAR Value = State->GeneralRegs[FAST486_REG_EAX].LowByte;
 
+    Fast486ResolveFlags(State);
+
     /*
      * Check if the value in AL is not a valid BCD digit,
      * or there was a borrow from the lowest 4 bits of AL
@@ -3399,6 +3309,8 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeArpl)
         return;
     }
 
+    Fast486ResolveFlags(State);
+
     /* Check if the RPL needs adjusting */
     if ((SecondValue & 3) < (FirstValue & 3))
     {
@@ -3521,6 +3433,8 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeImulModrmImm)
         }
     }
 
+    Fast486ResolveFlags(State);
+
     if (OperandSize)
     {
         LONG RegValue, Multiplicand;
@@ -4001,6 +3915,8 @@ FAST486_OPCODE_HANDLER(Fast486OpcodePushFlags)
         return;
     }
 
+    Fast486ResolveFlags(State);
+
     /* Push the flags */
     if (Size) Fast486StackPush(State, State->Flags.Long);
     else Fast486StackPush(State, LOWORD(State->Flags.Long));
@@ -4015,6 +3931,8 @@ FAST486_OPCODE_HANDLER(Fast486OpcodePopFlags)
     NO_LOCK_PREFIX();
     TOGGLE_OPSIZE(Size);
 
+    Fast486ResolveFlags(State);
+
     /* Pop the new flags */
     if (!Fast486StackPop(State, &NewFlags.Long))
     {
@@ -4050,6 +3968,8 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeSahf)
     /* Make sure this is the right instruction */
     ASSERT(Opcode == 0x9E);
 
+    Fast486ResolveFlags(State);
+
     /* Set the low-order byte of FLAGS to AH */
     State->Flags.Long &= 0xFFFFFF00;
     State->Flags.Long |= State->GeneralRegs[FAST486_REG_EAX].HighByte;
@@ -4064,6 +3984,8 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeLahf)
     /* Make sure this is the right instruction */
     ASSERT(Opcode == 0x9F);
 
+    Fast486ResolveFlags(State);
+
     /* Set AH to the low-order byte of FLAGS */
     State->GeneralRegs[FAST486_REG_EAX].HighByte = LOBYTE(State->Flags.Long);
 }
@@ -4145,6 +4067,9 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeLdsLes)
             State->PrefetchValid = FALSE;
 #endif
 
+            /* BOP handlers read and change the arithmetic flags directly */
+            Fast486ResolveFlags(State);
+
             /* Call the BOP handler */
             State->BopCallback(State, BopCode);
 
@@ -4455,7 +4380,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeInt)
         case 0xCE:  // INTO
         {
             /* Don't do anything if OF is cleared */
-            if (!State->Flags.Of) return;
+            if (!Fast486GetOverflowFlag(State)) return;
 
             /* Exception #OF */
             IntNum = FAST486_EXCEPTION_OF;
@@ -4512,6 +4437,8 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeIret)
         return;
     }
 
+    Fast486ResolveFlags(State);
+
     /* Pop EFLAGS */
     if (!Fast486StackPop(State, &NewFlags.Long))
     {
@@ -4724,6 +4651,8 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAam)
     State->GeneralRegs[FAST486_REG_EAX].HighByte = Value / Base;
     State->GeneralRegs[FAST486_REG_EAX].LowByte = Value %= Base;
 
+    Fast486ResolveFlags(State);
+
     /* Update flags */
     State->Flags.Af = FALSE;
     State->Flags.Zf = (Value == 0);
@@ -4749,6 +4678,8 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeAad)
     Value += State->GeneralRegs[FAST486_REG_EAX].HighByte * Base;
     State->GeneralRegs[FAST486_REG_EAX].LowWord = Value;
 
+    Fast486ResolveFlags(State);
+
     /* Update flags */
     State->Flags.Af = FALSE;
     State->Flags.Zf = (Value == 0);
@@ -4800,12 +4731,12 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeLoop)
     if (Opcode == 0xE0)
     {
         /* Additional rule for LOOPNZ */
-        if (State->Flags.Zf) Condition = FALSE;
+        if (Fast486GetZeroFlag(State)) Condition = FALSE;
     }
     else if (Opcode == 0xE1)
     {
         /* Additional rule for LOOPZ */
-        if (!State->Flags.Zf) Condition = FALSE;
+        if (!Fast486GetZeroFlag(State)) Condition = FALSE;
     }
 
     /* Fetch the offset */
@@ -5252,6 +5183,8 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeSalc)
 
     NO_LOCK_PREFIX();
 
+    Fast486ResolveFlags(State);
+
     /* Set all the bits of AL to CF */
     State->GeneralRegs[FAST486_REG_EAX].LowByte = State->Flags.Cf ? 0xFF : 0x00;
 }
@@ -5436,6 +5369,8 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeCmps)
     SecondValue &= DataMask;
     Result = (FirstValue - SecondValue) & DataMask;
 
+    Fast486ResolveFlags(State);
+
     /* Update the flags */
     State->Flags.Cf = (FirstValue < SecondValue);
     State->Flags.Of = ((FirstValue & SignFlag) != (SecondValue & SignFlag))
@@ -5772,6 +5707,8 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeScas)
     SecondValue &= DataMask;
     Result = (FirstValue - SecondValue) & DataMask;
 
+    Fast486ResolveFlags(State);
+
     /* Update the flags */
     State->Flags.Cf = (FirstValue < SecondValue);
     State->Flags.Of = ((FirstValue & SignFlag) != (SecondValue & SignFlag))
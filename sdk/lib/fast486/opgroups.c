@@ -56,13 +56,13 @@ Fast486ArithmeticOperation(PFAST486_STATE State,
         case 0:
         {
             Result = (FirstValue + SecondValue) & MaxValue;
-
-            /* Update CF, OF and AF */
-            State->Flags.Cf = (Result < FirstValue) && (Result < SecondValue);
-            State->Flags.Of = ((FirstValue & SignFlag) == (SecondValue & SignFlag))
-                              && ((FirstValue & SignFlag) != (Result & SignFlag));
-            State->Flags.Af = ((((FirstValue & 0x0F) + (SecondValue & 0x0F)) & 0x10) != 0);
-
+            Fast486SetLazyFlags(State,
+                                FAST486_LAZY_ADD,
+                                FirstValue,
+                                SecondValue,
+                                Result,
+                                SignFlag,
+                                FALSE);
             break;
         }
 
@@ -70,42 +70,39 @@ Fast486ArithmeticOperation(PFAST486_STATE State,
         case 1:
         {
             Result = FirstValue | SecondValue;
-            State->Flags.Cf = State->Flags.Of = FALSE;
+            Fast486SetLogicFlags(State, Result, SignFlag);
             break;
         }
 
         /* ADC */
         case 2:
         {
-            INT Carry = State->Flags.Cf ? 1 : 0;
+            INT Carry = Fast486GetCarryFlag(State) ? 1 : 0;
 
             Result = (FirstValue + SecondValue + Carry) & MaxValue;
-
-            /* Update CF, OF and AF */
-            State->Flags.Cf = ((SecondValue == MaxValue) && (Carry == 1))
-                              || ((Result < FirstValue) && (Result < (SecondValue + Carry)));
-            State->Flags.Of = ((FirstValue & SignFlag) == (SecondValue & SignFlag))
-                              && ((FirstValue & SignFlag) != (Result & SignFlag));
-            State->Flags.Af = ((FirstValue ^ SecondValue ^ Result) & 0x10) != 0;
-
+            Fast486SetLazyFlags(State,
+                                FAST486_LAZY_ADD,
+                                FirstValue,
+                                SecondValue,
+                                Result,
+                                SignFlag,
+                                Carry);
             break;
         }
 
         /* SBB */
         case 3:
         {
-            INT Carry = State->Flags.Cf ? 1 : 0;
+            INT Carry = Fast486GetCarryFlag(State) ? 1 : 0;
 
             Result = (FirstValue - SecondValue - Carry) & MaxValue;
-
-            /* Update CF, OF and AF */
-            State->Flags.Cf = Carry
-                              ? (FirstValue <= SecondValue)
-                              : (FirstValue < SecondValue);
-            State->Flags.Of = ((FirstValue & SignFlag) != (SecondValue & SignFlag))
-                              && ((FirstValue & SignFlag) != (Result & SignFlag));
-            State->Flags.Af = ((FirstValue ^ SecondValue ^ Result) & 0x10) != 0;
-
+            Fast486SetLazyFlags(State,
+                                FAST486_LAZY_SUB,
+                                FirstValue,
+                                SecondValue,
+                                Result,
+                                SignFlag,
+                                Carry);
             break;
         }
 
@@ -113,7 +110,7 @@ Fast486ArithmeticOperation(PFAST486_STATE State,
         case 4:
         {
             Result = FirstValue & SecondValue;
-            State->Flags.Cf = State->Flags.Of = FALSE;
+            Fast486SetLogicFlags(State, Result, SignFlag);
             break;
         }
 
@@ -122,13 +119,13 @@ Fast486ArithmeticOperation(PFAST486_STATE State,
         case 7:
         {
             Result = (FirstValue - SecondValue) & MaxValue;
-
-            /* Update CF, OF and AF */
-            State->Flags.Cf = (FirstValue < SecondValue);
-            State->Flags.Of = ((FirstValue & SignFlag) != (SecondValue & SignFlag))
-                              && ((FirstValue & SignFlag) != (Result & SignFlag));
-            State->Flags.Af = (FirstValue & 0x0F) < (SecondValue & 0x0F);
-
+            Fast486SetLazyFlags(State,
+                                FAST486_LAZY_SUB,
+                                FirstValue,
+                                SecondValue,
+                                Result,
+                                SignFlag,
+                                FALSE);
             break;
         }
 
@@ -136,7 +133,7 @@ Fast486ArithmeticOperation(PFAST486_STATE State,
         case 6:
         {
             Result = FirstValue ^ SecondValue;
-            State->Flags.Cf = State->Flags.Of = FALSE;
+            Fast486SetLogicFlags(State, Result, SignFlag);
             break;
         }
 
@@ -147,11 +144,6 @@ Fast486ArithmeticOperation(PFAST486_STATE State,
         }
     }
 
-    /* Update ZF, SF and PF */
-    State->Flags.Zf = (Result == 0);
-    State->Flags.Sf = ((Result & SignFlag) != 0);
-    State->Flags.Pf = Fast486CalculateParity(LOBYTE(Result));
-
     /* Return the result */
     return Result;
 }
@@ -177,6 +169,8 @@ Fast486RotateOperation(PFAST486_STATE State,
     /* If the count is zero, do nothing */
     if (Count == 0) return Value;
 
+    Fast486ResolveFlags(State);
+
     /* Check which operation is this */
     switch (Operation)
     {
@@ -892,6 +886,8 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeGroupF6)
         return;
     }
 
+    Fast486ResolveFlags(State);
+
     switch (ModRegRm.Register)
     {
         /* TEST */
@@ -1080,6 +1076,8 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeGroupF7)
         }
     }
 
+    Fast486ResolveFlags(State);
+
     switch (ModRegRm.Register)
     {
         /* TEST */
@@ -1330,7 +1328,7 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeGroupF7)
 
 FAST486_OPCODE_HANDLER(Fast486OpcodeGroupFE)
 {
-    UCHAR Value;
+    UCHAR Value, Result;
     FAST486_MOD_REG_RM ModRegRm;
     BOOLEAN AddressSize = State->SegmentRegs[FAST486_REG_CS].Size;
 
@@ -1356,28 +1354,32 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeGroupFE)
         return;
     }
 
+    /* Update the flags, INC and DEC keep CF */
     if (ModRegRm.Register == 0)
     {
-        /* Increment and update OF and AF */
-        Value++;
-        State->Flags.Of = (Value == SIGN_FLAG_BYTE);
-        State->Flags.Af = ((Value & 0x0F) == 0);
+        Result = Value + 1;
+        Fast486SetLazyFlags(State,
+                            FAST486_LAZY_INC,
+                            Value,
+                            1,
+                            Result,
+                            SIGN_FLAG_BYTE,
+                            Fast486GetCarryFlag(State));
     }
     else
     {
-        /* Decrement and update OF and AF */
-        State->Flags.Of = (Value == SIGN_FLAG_BYTE);
-        Value--;
-        State->Flags.Af = ((Value & 0x0F) == 0x0F);
+        Result = Value - 1;
+        Fast486SetLazyFlags(State,
+                            FAST486_LAZY_DEC,
+                            Value,
+                            1,
+                            Result,
+                            SIGN_FLAG_BYTE,
+                            Fast486GetCarryFlag(State));
     }
 
-    /* Update flags */
-    State->Flags.Zf = (Value == 0);
-    State->Flags.Sf = ((Value & SIGN_FLAG_BYTE) != 0);
-    State->Flags.Pf = Fast486CalculateParity(Value);
-
     /* Write back the result */
-    Fast486WriteModrmByteOperands(State, &ModRegRm, FALSE, Value);
+    Fast486WriteModrmByteOperands(State, &ModRegRm, FALSE, Result);
 }
 
 FAST486_OPCODE_HANDLER(Fast486OpcodeGroupFF)
@@ -1416,17 +1418,27 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeGroupFF)
 
         if (ModRegRm.Register == 0)
         {
-            /* Increment and update OF and AF */
+            /* Increment, INC keeps CF */
+            Fast486SetLazyFlags(State,
+                                FAST486_LAZY_INC,
+                                Value,
+                                1,
+                                Value + 1,
+                                SIGN_FLAG_LONG,
+                                Fast486GetCarryFlag(State));
             Value++;
-            State->Flags.Of = (Value == SIGN_FLAG_LONG);
-            State->Flags.Af = ((Value & 0x0F) == 0);
         }
         else if (ModRegRm.Register == 1)
         {
-            /* Decrement and update OF and AF */
-            State->Flags.Of = (Value == SIGN_FLAG_LONG);
+            /* Decrement, DEC keeps CF */
+            Fast486SetLazyFlags(State,
+                                FAST486_LAZY_DEC,
+                                Value,
+                                1,
+                                Value - 1,
+                                SIGN_FLAG_LONG,
+                                Fast486GetCarryFlag(State));
             Value--;
-            State->Flags.Af = ((Value & 0x0F) == 0x0F);
         }
         else if (ModRegRm.Register == 2)
         {
@@ -1556,11 +1568,6 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeGroupFF)
 
         if (ModRegRm.Register <= 1)
         {
-            /* Update flags */
-            State->Flags.Sf = ((Value & SIGN_FLAG_LONG) != 0);
-            State->Flags.Zf = (Value == 0);
-            State->Flags.Pf = Fast486CalculateParity(Value);
-
             /* Write back the result */
             Fast486WriteModrmDwordOperands(State, &ModRegRm, FALSE, Value);
         }
@@ -1577,17 +1584,27 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeGroupFF)
 
         if (ModRegRm.Register == 0)
         {
-            /* Increment and update OF */
+            /* Increment, INC keeps CF */
+            Fast486SetLazyFlags(State,
+                                FAST486_LAZY_INC,
+                                Value,
+                                1,
+                                (USHORT)(Value + 1),
+                                SIGN_FLAG_WORD,
+                                Fast486GetCarryFlag(State));
             Value++;
-            State->Flags.Of = (Value == SIGN_FLAG_WORD);
-            State->Flags.Af = ((Value & 0x0F) == 0);
         }
         else if (ModRegRm.Register == 1)
         {
-            /* Decrement and update OF */
-            State->Flags.Of = (Value == SIGN_FLAG_WORD);
+            /* Decrement, DEC keeps CF */
+            Fast486SetLazyFlags(State,
+                                FAST486_LAZY_DEC,
+                                Value,
+                                1,
+                                (USHORT)(Value - 1),
+                                SIGN_FLAG_WORD,
+                                Fast486GetCarryFlag(State));
             Value--;
-            State->Flags.Af = ((Value & 0x0F) == 0x0F);
         }
         else if (ModRegRm.Register == 2)
         {
@@ -1735,11 +1752,6 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeGroupFF)
 
         if (ModRegRm.Register <= 1)
         {
-            /* Update flags */
-            State->Flags.Sf = ((Value & SIGN_FLAG_WORD) != 0);
-            State->Flags.Zf = (Value == 0);
-            State->Flags.Pf = Fast486CalculateParity(Value);
-
             /* Write back the result */
             Fast486WriteModrmWordOperands(State, &ModRegRm, FALSE, Value);
         }
@@ -1760,6 +1772,8 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeGroup0F00)
         return;
     }
 
+    Fast486ResolveFlags(State);
+
     /* Check which operation this is */
     switch (ModRegRm.Register)
     {
@@ -2361,6 +2375,8 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeGroup0FBA)
     /* Normalize the bit number */
     BitNumber %= DataSize;
 
+    Fast486ResolveFlags(State);
+
     if (OperandSize)
     {
         ULONG Value;
@@ -0,0 +1,169 @@
+/*
+ * PROJECT:     .inf file parser
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Host benchmark for parsing and querying INF files
+ *
+ * Usage: infbench [-n:iterations] [-c:cachedir] <inffiles>
+ * e.g.   infbench -c:/tmp/infcache boot/bootdata/hive*.inf boot/bootdata/livecd.inf
+ */
+
+/* INCLUDES *****************************************************************/
+
+#include "inflib.h"
+#include "infhost.h"
+
+#include <time.h>
+
+/* FUNCTIONS ****************************************************************/
+
+static double
+Elapsed(clock_t Start)
+{
+    return (double)(clock() - Start) / CLOCKS_PER_SEC;
+}
+
+static int
+OpenAll(int FileCount, char **FileNames, const char *CachePath, HINF *Handles)
+{
+    ULONG ErrorLine;
+    int i;
+
+    for (i = 0; i < FileCount; i++)
+    {
+        if (InfHostOpenCachedFile(&Handles[i], FileNames[i], CachePath, 0, &ErrorLine) != 0)
+        {
+            fprintf(stderr, "Cannot open %s (error line %lu)\n",
+                    FileNames[i], (unsigned long)ErrorLine);
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static void
+CloseAll(int FileCount, HINF *Handles)
+{
+    int i;
+
+    for (i = 0; i < FileCount; i++)
+        InfHostCloseFile(Handles[i]);
+}
+
+/* Walk every line of every section through the public context API */
+static unsigned long
+QueryAll(HINF hInf)
+{
+    PINFCACHESECTION Section;
+    PINFCONTEXT Context;
+    unsigned long Lines = 0;
+    WCHAR *Key, *Data;
+
+    for (Section = ((PINFCACHE)hInf)->FirstSection;
+         Section != NULL;
+         Section = Section->Next)
+    {
+        if (InfHostGetLineCount(hInf, Section->Name) < 0)
+            continue;
+
+        if (InfHostFindFirstLine(hInf, Section->Name, NULL, &Context) != 0)
+            continue;
+
+        do
+        {
+            InfHostGetData(Context, &Key, &Data);
+            InfHostGetFieldCount(Context);
+            Lines++;
+        } while (InfHostFindNextLine(Context, Context) == 0);
+
+        InfHostFreeContext(Context);
+    }
+
+    return Lines;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *CachePath = NULL;
+    int Iterations = 20;
+    HINF *Handles;
+    unsigned long Lines = 0;
+    clock_t Start;
+    double Seconds;
+    int i, j;
+
+    for (i = 1; i < argc && *argv[i] == '-'; i++)
+    {
+        if (argv[i][1] == 'n' && argv[i][2] == ':')
+            Iterations = atoi(argv[i] + 3);
+        else if (argv[i][1] == 'c' && argv[i][2] == ':')
+            CachePath = argv[i] + 3;
+        else
+            break;
+    }
+
+    if (i >= argc || Iterations <= 0)
+    {
+        printf("Usage: infbench [-n:iterations] [-c:cachedir] <inffiles>\n");
+        return 1;
+    }
+
+    argc -= i;
+    argv += i;
+
+    Handles = malloc(argc * sizeof(HINF));
+    if (Handles == NULL)
+        return 1;
+
+    /* Parse from scratch */
+    Start = clock();
+    for (j = 0; j < Iterations; j++)
+    {
+        if (!OpenAll(argc, argv, NULL, Handles))
+            return 1;
+        CloseAll(argc, Handles);
+    }
+    Seconds = Elapsed(Start);
+    printf("parse:  %8.3f ms per pass over %d files\n",
+           Seconds * 1000 / Iterations, argc);
+
+    /* Load through the binary cache, after one pass to populate it */
+    if (CachePath != NULL)
+    {
+        if (!OpenAll(argc, argv, CachePath, Handles))
+            return 1;
+        CloseAll(argc, Handles);
+
+        Start = clock();
+        for (j = 0; j < Iterations; j++)
+        {
+            if (!OpenAll(argc, argv, CachePath, Handles))
+                return 1;
+            CloseAll(argc, Handles);
+        }
+        Seconds = Elapsed(Start);
+        printf("cached: %8.3f ms per pass over %d files\n",
+               Seconds * 1000 / Iterations, argc);
+    }
+
+    /* Context lookups on the parsed files */
+    if (!OpenAll(argc, argv, NULL, Handles))
+        return 1;
+
+    Start = clock();
+    for (j = 0; j < Iterations; j++)
+    {
+        for (i = 0; i < argc; i++)
+            Lines += QueryAll(Handles[i]);
+    }
+    Seconds = Elapsed(Start);
+    printf("query:  %8.3f ms per pass, %lu lines, %.1f ns per line\n",
+           Seconds * 1000 / Iterations, Lines / Iterations,
+           Lines ? Seconds * 1e9 / Lines : 0.0);
+
+    CloseAll(argc, Handles);
+    free(Handles);
+    return 0;
+}
+
+/* EOF */
@@ -19,6 +19,9 @@
 /* actual string limit is MAX_INF_STRING_LENGTH+1 (plus terminating null) under Windows */
 #define MAX_STRING_LEN        (MAX_INF_STRING_LENGTH+1)
 
+#define INF_INITIAL_TABLE_SIZE  16  /* Id-indexed section and line tables */
+#define INF_INITIAL_HASH_SIZE   64  /* section name buckets, power of two */
+
 
 /* parser definitions */
 
@@ -133,34 +136,168 @@ InfpFreeSection (PINFCACHESECTION Section)
     }
   Section->LastLine = NULL;
 
+  if (Section->LineTable != NULL)
+    {
+      FREE (Section->LineTable);
+    }
+
   FREE (Section);
 
   return Next;
 }
 
 
+VOID
+InfpFreeCache(PINFCACHE Cache)
+{
+  if (Cache == NULL)
+    {
+      return;
+    }
+
+  while (Cache->FirstSection != NULL)
+    {
+      Cache->FirstSection = InfpFreeSection(Cache->FirstSection);
+    }
+  Cache->LastSection = NULL;
+
+  if (Cache->SectionTable != NULL)
+    {
+      FREE(Cache->SectionTable);
+    }
+
+  if (Cache->HashTable != NULL)
+    {
+      FREE(Cache->HashTable);
+    }
+
+  FREE(Cache);
+}
+
+
+static ULONG
+InfpHashName(PCWSTR Name)
+{
+  ULONG Hash = 2166136261U;
+
+  /* FNV-1a over the lowercased name, to match strcmpiW() */
+  while (*Name != 0)
+    {
+      Hash ^= tolowerW(*Name++);
+      Hash *= 16777619U;
+    }
+
+  return Hash;
+}
+
+
+/* Make sure an Id-indexed table can hold at least Count entries */
+static BOOLEAN
+InfpGrowTable(PVOID **Table,
+              UINT *TableSize,
+              UINT Count)
+{
+  PVOID *NewTable;
+  UINT NewSize;
+
+  if (Count <= *TableSize)
+    {
+      return TRUE;
+    }
+
+  NewSize = (*TableSize != 0) ? *TableSize : INF_INITIAL_TABLE_SIZE;
+  while (NewSize < Count)
+    {
+      NewSize *= 2;
+    }
+
+  NewTable = (PVOID *)MALLOC(NewSize * sizeof(PVOID));
+  if (NewTable == NULL)
+    {
+      DPRINT("MALLOC() failed\n");
+      return FALSE;
+    }
+  ZEROMEMORY(NewTable,
+             NewSize * sizeof(PVOID));
+
+  if (*Table != NULL)
+    {
+      MEMCPY(NewTable, *Table, *TableSize * sizeof(PVOID));
+      FREE(*Table);
+    }
+
+  *Table = NewTable;
+  *TableSize = NewSize;
+
+  return TRUE;
+}
+
+
+static BOOLEAN
+InfpRehashSections(PINFCACHE Cache,
+                   ULONG NewSize)
+{
+  PINFCACHESECTION *NewTable;
+  PINFCACHESECTION Section;
+  ULONG Bucket;
+
+  NewTable = (PINFCACHESECTION *)MALLOC(NewSize * sizeof(PINFCACHESECTION));
+  if (NewTable == NULL)
+    {
+      DPRINT("MALLOC() failed\n");
+      return FALSE;
+    }
+  ZEROMEMORY(NewTable,
+             NewSize * sizeof(PINFCACHESECTION));
+
+  for (Section = Cache->FirstSection;
+       Section != NULL;
+       Section = Section->Next)
+    {
+      Bucket = Section->Hash & (NewSize - 1);
+      Section->HashNext = NewTable[Bucket];
+      NewTable[Bucket] = Section;
+    }
+
+  if (Cache->HashTable != NULL)
+    {
+      FREE(Cache->HashTable);
+    }
+
+  Cache->HashTable = NewTable;
+  Cache->HashTableSize = NewSize;
+
+  return TRUE;
+}
+
+
 PINFCACHESECTION
 InfpFindSection(PINFCACHE Cache,
                 PCWSTR Name)
 {
-  PINFCACHESECTION Section = NULL;
+  PINFCACHESECTION Section;
+  ULONG Hash;
 
   if (Cache == NULL || Name == NULL)
     {
       return NULL;
     }
 
-  /* iterate through list of sections */
-  Section = Cache->FirstSection;
-  while (Section != NULL)
+  if (Cache->HashTable == NULL)
     {
-      if (strcmpiW(Section->Name, Name) == 0)
+      return NULL;
+    }
+
+  /* Section names are unique, so the first match in the bucket is it */
+  Hash = InfpHashName(Name);
+  for (Section = Cache->HashTable[Hash & (Cache->HashTableSize - 1)];
+       Section != NULL;
+       Section = Section->HashNext)
+    {
+      if (Section->Hash == Hash && strcmpiW(Section->Name, Name) == 0)
         {
           return Section;
         }
-
-      /* get the next section*/
-      Section = Section->Next;
     }
 
   return NULL;
@@ -173,6 +310,7 @@ InfpAddSection(PINFCACHE Cache,
 {
   PINFCACHESECTION Section = NULL;
   ULONG Size;
+  ULONG Bucket;
 
   if (Cache == NULL || Name == NULL)
     {
@@ -180,6 +318,24 @@ InfpAddSection(PINFCACHE Cache,
       return NULL;
     }
 
+  /* Make room in the Id table and keep the hash load factor below one */
+  if (!InfpGrowTable((PVOID **)&Cache->SectionTable,
+                     &Cache->SectionTableSize,
+                     Cache->NextSectionId + 1))
+    {
+      return NULL;
+    }
+
+  if (Cache->NextSectionId + 1 > Cache->HashTableSize)
+    {
+      if (!InfpRehashSections(Cache,
+                              (Cache->HashTableSize != 0) ?
+                              Cache->HashTableSize * 2 : INF_INITIAL_HASH_SIZE))
+        {
+          return NULL;
+        }
+    }
+
   /* Allocate and initialize the new section */
   Size = (ULONG)FIELD_OFFSET(INFCACHESECTION,
                              Name[strlenW(Name) + 1]);
@@ -209,6 +365,13 @@ InfpAddSection(PINFCACHE Cache,
       Cache->LastSection = Section;
     }
 
+  /* Index it */
+  Cache->SectionTable[Section->Id - 1] = Section;
+  Section->Hash = InfpHashName(Name);
+  Bucket = Section->Hash & (Cache->HashTableSize - 1);
+  Section->HashNext = Cache->HashTable[Bucket];
+  Cache->HashTable[Bucket] = Section;
+
   return Section;
 }
 
@@ -224,6 +387,13 @@ InfpAddLine(PINFCACHESECTION Section)
       return NULL;
     }
 
+  if (!InfpGrowTable((PVOID **)&Section->LineTable,
+                     &Section->LineTableSize,
+                     Section->NextLineId + 1))
+    {
+      return NULL;
+    }
+
   Line = (PINFCACHELINE)MALLOC(sizeof(INFCACHELINE));
   if (Line == NULL)
     {
@@ -233,6 +403,7 @@ InfpAddLine(PINFCACHESECTION Section)
   ZEROMEMORY(Line,
              sizeof(INFCACHELINE));
   Line->Id = ++Section->NextLineId;
+  Section->LineTable[Line->Id - 1] = Line;
 
   /* Append line */
   if (Section->FirstLine == NULL)
@@ -254,19 +425,12 @@ InfpAddLine(PINFCACHESECTION Section)
 PINFCACHESECTION
 InfpFindSectionById(PINFCACHE Cache, UINT Id)
 {
-    PINFCACHESECTION Section;
-
-    for (Section = Cache->FirstSection;
-         Section != NULL;
-         Section = Section->Next)
+    if (Id == 0 || Id > Cache->NextSectionId)
     {
-        if (Section->Id == Id)
-        {
-            return Section;
-        }
+        return NULL;
     }
 
-    return NULL;
+    return Cache->SectionTable[Id - 1];
 }
 
 PINFCACHESECTION
@@ -291,19 +455,12 @@ InfpGetSectionForContext(PINFCONTEXT Context)
 PINFCACHELINE
 InfpFindLineById(PINFCACHESECTION Section, UINT Id)
 {
-    PINFCACHELINE Line;
-
-    for (Line = Section->FirstLine;
-         Line != NULL;
-         Line = Line->Next)
+    if (Id == 0 || Id > Section->NextLineId)
     {
-        if (Line->Id == Id)
-        {
-            return Line;
-        }
+        return NULL;
     }
 
-    return NULL;
+    return Section->LineTable[Id - 1];
 }
 
 PINFCACHELINE
@@ -338,18 +338,10 @@ InfpGetLineCount(HINF InfHandle,
 
   Cache = (PINFCACHE)InfHandle;
 
-  /* Iterate through list of sections */
-  CacheSection = Cache->FirstSection;
-  while (CacheSection != NULL)
+  CacheSection = InfpFindSection(Cache, Section);
+  if (CacheSection != NULL)
     {
-      /* Are the section names the same? */
-      if (strcmpiW(CacheSection->Name, Section) == 0)
-        {
-          return CacheSection->LineCount;
-        }
-
-      /* Get the next section */
-      CacheSection = CacheSection->Next;
+      return CacheSection->LineCount;
     }
 
   DPRINT("Section not found\n");
@@ -23,6 +23,11 @@ extern int InfHostOpenFile(PHINF InfHandle,
                            const CHAR *FileName,
                            LANGID LanguageId,
                            ULONG *ErrorLine);
+extern int InfHostOpenCachedFile(PHINF InfHandle,
+                                 const CHAR *FileName,
+                                 const CHAR *CacheDirectory,
+                                 LANGID LanguageId,
+                                 ULONG *ErrorLine);
 extern int InfHostWriteFile(HINF InfHandle,
                             const CHAR *FileName,
                             const CHAR *HeaderComment);
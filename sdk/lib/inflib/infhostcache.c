@@ -0,0 +1,509 @@
+/*
+ * PROJECT:     .inf file parser
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Parse-once binary cache of INF files for the host tools
+ */
+
+/* INCLUDES *****************************************************************/
+
+#include "inflib.h"
+#include "infhost.h"
+
+#include <limits.h>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#ifndef PATH_MAX
+#define PATH_MAX 260
+#endif
+
+#define NDEBUG
+#include <debug.h>
+
+/*
+ * The cache file is named after a hash of the INF contents, so an INF that
+ * is shared between several mkhive invocations (or builds) is tokenized only
+ * once. The file holds a header followed by a flat stream of ULONGs:
+ *
+ *   for each section: <string Name> <LineCount>
+ *     for each line:  <string Key> <FieldCount> <string Field>...
+ *
+ * where a string is its length in WCHARs including the terminating NUL
+ * (0 for a line without a key) followed by the characters, padded to a
+ * ULONG boundary. Strings are handed to the cache builders in place.
+ */
+
+#define INF_CACHE_MAGIC      0x43464E49  /* 'INFC' */
+#define INF_CACHE_VERSION    1
+
+typedef struct _INF_CACHE_HEADER
+{
+  ULONG Magic;
+  ULONG Version;
+  ULONG LanguageId;
+  ULONG SourceSize;
+  ULONGLONG SourceHash;
+  ULONG SectionCount;
+  ULONG DataSize;
+} INF_CACHE_HEADER, *PINF_CACHE_HEADER;
+
+typedef struct _INF_CACHE_READER
+{
+  const ULONG *Position;
+  const ULONG *End;
+} INF_CACHE_READER, *PINF_CACHE_READER;
+
+
+/* PRIVATE FUNCTIONS ********************************************************/
+
+static ULONGLONG
+InfpCacheHash(const void *Data,
+              ULONG Size)
+{
+  const UCHAR *Bytes = (const UCHAR *)Data;
+  ULONGLONG Hash = 0xCBF29CE484222325ULL;
+  ULONGLONG Word;
+
+  /* Multiplicative hash eight bytes at a time, the source is hashed on
+   * every lookup so this has to stay well below the cost of parsing it */
+  for (; Size >= sizeof(Word); Size -= sizeof(Word), Bytes += sizeof(Word))
+    {
+      MEMCPY(&Word, Bytes, sizeof(Word));
+      Hash = (Hash ^ Word) * 0x9E3779B97F4A7C15ULL;
+      Hash ^= Hash >> 32;
+    }
+
+  while (Size-- != 0)
+    {
+      Hash = (Hash ^ *Bytes++) * 0x100000001B3ULL;
+    }
+
+  return Hash;
+}
+
+
+static CHAR *
+InfpReadWholeFile(const CHAR *FileName,
+                  ULONG *FileSize)
+{
+  FILE *File;
+  CHAR *Buffer;
+  long Length;
+
+  File = fopen(FileName, "rb");
+  if (File == NULL)
+    {
+      return NULL;
+    }
+
+  if (fseek(File, 0, SEEK_END) != 0 ||
+      (Length = ftell(File)) < 0 ||
+      fseek(File, 0, SEEK_SET) != 0)
+    {
+      fclose(File);
+      return NULL;
+    }
+
+  /* Keep at least one byte so that empty files still get a buffer */
+  Buffer = MALLOC(Length + 1);
+  if (Buffer == NULL)
+    {
+      fclose(File);
+      return NULL;
+    }
+
+  if ((size_t)Length != fread(Buffer, 1, (size_t)Length, File))
+    {
+      FREE(Buffer);
+      fclose(File);
+      return NULL;
+    }
+
+  fclose(File);
+
+  *FileSize = (ULONG)Length;
+  return Buffer;
+}
+
+
+static void
+InfpBuildCacheFileName(CHAR *CacheFileName,
+                       size_t CacheFileNameSize,
+                       const CHAR *CacheDirectory,
+                       ULONGLONG SourceHash,
+                       ULONG SourceSize,
+                       LANGID LanguageId)
+{
+  snprintf(CacheFileName, CacheFileNameSize,
+           "%s/%08lx%08lx-%lx-%x.infc",
+           CacheDirectory,
+           (unsigned long)(SourceHash >> 32),
+           (unsigned long)(SourceHash & 0xFFFFFFFF),
+           (unsigned long)SourceSize,
+           (unsigned int)LanguageId);
+}
+
+
+static BOOLEAN
+InfpReadCacheUlong(PINF_CACHE_READER Reader,
+                   ULONG *Value)
+{
+  if (Reader->Position >= Reader->End)
+    {
+      return FALSE;
+    }
+
+  *Value = *Reader->Position++;
+  return TRUE;
+}
+
+
+/* Returns a pointer to the string in the cache buffer, or NULL if absent */
+static BOOLEAN
+InfpReadCacheString(PINF_CACHE_READER Reader,
+                    PCWSTR *String)
+{
+  ULONG Length;
+  ULONG Units;
+
+  if (!InfpReadCacheUlong(Reader, &Length))
+    {
+      return FALSE;
+    }
+
+  if (Length == 0)
+    {
+      *String = NULL;
+      return TRUE;
+    }
+
+  Units = (Length * sizeof(WCHAR) + sizeof(ULONG) - 1) / sizeof(ULONG);
+  if (Length > MAX_INF_STRING_LENGTH + 1 ||
+      Units > (ULONG)(Reader->End - Reader->Position))
+    {
+      return FALSE;
+    }
+
+  *String = (PCWSTR)Reader->Position;
+  if ((*String)[Length - 1] != 0)
+    {
+      return FALSE;
+    }
+
+  Reader->Position += Units;
+  return TRUE;
+}
+
+
+static PINFCACHE
+InfpLoadCacheFile(const CHAR *CacheFileName,
+                  ULONGLONG SourceHash,
+                  ULONG SourceSize,
+                  LANGID LanguageId)
+{
+  INF_CACHE_READER Reader;
+  PINF_CACHE_HEADER Header;
+  PINFCACHESECTION Section;
+  PINFCACHELINE Line;
+  PINFCACHE Cache;
+  CHAR *Buffer;
+  ULONG BufferSize;
+  ULONG SectionIndex, LineCount, FieldCount;
+  PCWSTR String;
+
+  Buffer = InfpReadWholeFile(CacheFileName, &BufferSize);
+  if (Buffer == NULL)
+    {
+      return NULL;
+    }
+
+  /* Reject anything that was written for another file or only partially */
+  Header = (PINF_CACHE_HEADER)Buffer;
+  if (BufferSize < sizeof(INF_CACHE_HEADER) ||
+      Header->Magic != INF_CACHE_MAGIC ||
+      Header->Version != INF_CACHE_VERSION ||
+      Header->LanguageId != LanguageId ||
+      Header->SourceSize != SourceSize ||
+      Header->SourceHash != SourceHash ||
+      Header->DataSize != BufferSize - sizeof(INF_CACHE_HEADER) ||
+      (Header->DataSize % sizeof(ULONG)) != 0)
+    {
+      DPRINT1("Discarding stale INF cache %s\n", CacheFileName);
+      FREE(Buffer);
+      return NULL;
+    }
+
+  Cache = (PINFCACHE)MALLOC(sizeof(INFCACHE));
+  if (Cache == NULL)
+    {
+      FREE(Buffer);
+      return NULL;
+    }
+  ZEROMEMORY(Cache,
+             sizeof(INFCACHE));
+  Cache->LanguageId = LanguageId;
+
+  Reader.Position = (const ULONG *)(Header + 1);
+  Reader.End = Reader.Position + Header->DataSize / sizeof(ULONG);
+
+  for (SectionIndex = 0; SectionIndex < Header->SectionCount; SectionIndex++)
+    {
+      if (!InfpReadCacheString(&Reader, &String) ||
+          String == NULL ||
+          !InfpReadCacheUlong(&Reader, &LineCount))
+        {
+          goto Corrupt;
+        }
+
+      Section = InfpAddSection(Cache, String);
+      if (Section == NULL)
+        {
+          goto Corrupt;
+        }
+
+      while (LineCount-- != 0)
+        {
+          Line = InfpAddLine(Section);
+          if (Line == NULL ||
+              !InfpReadCacheString(&Reader, &String))
+            {
+              goto Corrupt;
+            }
+
+          if (String != NULL && InfpAddKeyToLine(Line, String) == NULL)
+            {
+              goto Corrupt;
+            }
+
+          if (!InfpReadCacheUlong(&Reader, &FieldCount))
+            {
+              goto Corrupt;
+            }
+
+          while (FieldCount-- != 0)
+            {
+              if (!InfpReadCacheString(&Reader, &String) ||
+                  String == NULL ||
+                  InfpAddFieldToLine(Line, String) == NULL)
+                {
+                  goto Corrupt;
+                }
+            }
+        }
+    }
+
+  if (Reader.Position != Reader.End)
+    {
+      goto Corrupt;
+    }
+
+  Cache->StringsSection = InfpFindSection(Cache, L"Strings");
+
+  FREE(Buffer);
+  return Cache;
+
+Corrupt:
+  DPRINT1("Corrupted INF cache %s\n", CacheFileName);
+  InfpFreeCache(Cache);
+  FREE(Buffer);
+  return NULL;
+}
+
+
+static BOOLEAN
+InfpWriteCacheData(FILE *File,
+                   ULONG *DataSize,
+                   const void *Data,
+                   ULONG Size)
+{
+  if (Size != fwrite(Data, 1, Size, File))
+    {
+      return FALSE;
+    }
+
+  *DataSize += Size;
+  return TRUE;
+}
+
+
+static BOOLEAN
+InfpWriteCacheString(FILE *File,
+                     ULONG *DataSize,
+                     PCWSTR String)
+{
+  static const UCHAR Padding[sizeof(ULONG)] = { 0 };
+  ULONG Length;
+  ULONG Size;
+
+  if (String == NULL)
+    {
+      Length = 0;
+      return InfpWriteCacheData(File, DataSize, &Length, sizeof(Length));
+    }
+
+  Length = (ULONG)strlenW(String) + 1;
+  Size = Length * sizeof(WCHAR);
+
+  return InfpWriteCacheData(File, DataSize, &Length, sizeof(Length)) &&
+         InfpWriteCacheData(File, DataSize, String, Size) &&
+         InfpWriteCacheData(File, DataSize, Padding,
+                            (sizeof(ULONG) - Size % sizeof(ULONG)) % sizeof(ULONG));
+}
+
+
+static void
+InfpSaveCacheFile(PINFCACHE Cache,
+                  const CHAR *CacheFileName,
+                  ULONGLONG SourceHash,
+                  ULONG SourceSize,
+                  LANGID LanguageId)
+{
+  INF_CACHE_HEADER Header;
+  PINFCACHESECTION Section;
+  PINFCACHELINE Line;
+  PINFCACHEFIELD Field;
+  CHAR TempFileName[PATH_MAX + 16];
+  FILE *File;
+  BOOLEAN Success;
+  ULONG Count;
+
+  /*
+   * Write to a temporary file, so that readers never see a partial cache.
+   * Its name is unique to this process, as parallel builds may be writing
+   * the same cache.
+   */
+  snprintf(TempFileName, sizeof(TempFileName), "%s.%lu.tmp",
+           CacheFileName, (unsigned long)getpid());
+  File = fopen(TempFileName, "wb");
+  if (File == NULL)
+    {
+      DPRINT1("Cannot create INF cache %s (errno %d)\n", TempFileName, errno);
+      return;
+    }
+
+  ZEROMEMORY(&Header, sizeof(Header));
+  Header.Magic = INF_CACHE_MAGIC;
+  Header.Version = INF_CACHE_VERSION;
+  Header.LanguageId = LanguageId;
+  Header.SourceSize = SourceSize;
+  Header.SourceHash = SourceHash;
+
+  /* The header is rewritten once the data size is known */
+  Success = (fwrite(&Header, sizeof(Header), 1, File) == 1);
+
+  for (Section = Cache->FirstSection;
+       Success && Section != NULL;
+       Section = Section->Next)
+    {
+      Count = (ULONG)Section->LineCount;
+      Success = InfpWriteCacheString(File, &Header.DataSize, Section->Name) &&
+                InfpWriteCacheData(File, &Header.DataSize, &Count, sizeof(Count));
+      Header.SectionCount++;
+
+      for (Line = Section->FirstLine;
+           Success && Line != NULL;
+           Line = Line->Next)
+        {
+          Count = (ULONG)Line->FieldCount;
+          Success = InfpWriteCacheString(File, &Header.DataSize, Line->Key) &&
+                    InfpWriteCacheData(File, &Header.DataSize, &Count, sizeof(Count));
+
+          for (Field = Line->FirstField;
+               Success && Field != NULL;
+               Field = Field->Next)
+            {
+              Success = InfpWriteCacheString(File, &Header.DataSize, Field->Data);
+            }
+        }
+    }
+
+  if (Success)
+    {
+      Success = (fseek(File, 0, SEEK_SET) == 0 &&
+                 fwrite(&Header, sizeof(Header), 1, File) == 1);
+    }
+
+  if (fclose(File) != 0)
+    {
+      Success = FALSE;
+    }
+
+  if (Success && rename(TempFileName, CacheFileName) != 0)
+    {
+      /* Another invocation may have stored the same contents already */
+      remove(CacheFileName);
+      Success = (rename(TempFileName, CacheFileName) == 0);
+    }
+
+  if (!Success)
+    {
+      DPRINT1("Failed to write INF cache %s\n", CacheFileName);
+      remove(TempFileName);
+    }
+}
+
+
+/* PUBLIC FUNCTIONS *********************************************************/
+
+int
+InfHostOpenCachedFile(PHINF InfHandle,
+                      const CHAR *FileName,
+                      const CHAR *CacheDirectory,
+                      LANGID LanguageId,
+                      ULONG *ErrorLine)
+{
+  CHAR CacheFileName[PATH_MAX];
+  PINFCACHE Cache;
+  CHAR *FileBuffer;
+  ULONG FileLength;
+  ULONGLONG SourceHash;
+  int Result;
+
+  if (CacheDirectory == NULL || *CacheDirectory == 0)
+    {
+      return InfHostOpenFile(InfHandle, FileName, LanguageId, ErrorLine);
+    }
+
+  *InfHandle = NULL;
+  *ErrorLine = (ULONG)-1;
+
+  FileBuffer = InfpReadWholeFile(FileName, &FileLength);
+  if (FileBuffer == NULL)
+    {
+      DPRINT1("Cannot read %s (errno %d)\n", FileName, errno);
+      return -1;
+    }
+
+  SourceHash = InfpCacheHash(FileBuffer, FileLength);
+  InfpBuildCacheFileName(CacheFileName, sizeof(CacheFileName),
+                         CacheDirectory, SourceHash, FileLength, LanguageId);
+
+  Cache = InfpLoadCacheFile(CacheFileName, SourceHash, FileLength, LanguageId);
+  if (Cache != NULL)
+    {
+      DPRINT("Loaded %s from INF cache %s\n", FileName, CacheFileName);
+      FREE(FileBuffer);
+      *InfHandle = (HINF)Cache;
+      return 0;
+    }
+
+  /* Cache miss: parse the contents we already have and store the result */
+  Result = InfHostOpenBufferedFile(InfHandle, FileBuffer, FileLength,
+                                   LanguageId, ErrorLine);
+  FREE(FileBuffer);
+
+  if (Result == 0)
+    {
+      InfpSaveCacheFile((PINFCACHE)*InfHandle, CacheFileName,
+                        SourceHash, FileLength, LanguageId);
+    }
+
+  return Result;
+}
+
+/* EOF */
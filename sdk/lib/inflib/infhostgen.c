@@ -25,7 +25,7 @@ InfHostOpenBufferedFile(PHINF InfHandle,
 {
   INFSTATUS Status;
   PINFCACHE Cache;
-  WCHAR *FileBuffer;
+  CHAR *FileBuffer;
   ULONG FileBufferSize;
 
   *InfHandle = NULL;
@@ -111,7 +111,7 @@ InfHostOpenBufferedFile(PHINF InfHandle,
 
   if (!INF_SUCCESS(Status))
     {
-      FREE(Cache);
+      InfpFreeCache(Cache);
       Cache = NULL;
     }
 
@@ -266,7 +266,7 @@ InfHostOpenFile(PHINF InfHandle,
 
   if (!INF_SUCCESS(Status))
     {
-      FREE(Cache);
+      InfpFreeCache(Cache);
       Cache = NULL;
     }
 
@@ -291,13 +291,7 @@ InfHostCloseFile(HINF InfHandle)
       return;
     }
 
-  while (Cache->FirstSection != NULL)
-    {
-      Cache->FirstSection = InfpFreeSection(Cache->FirstSection);
-    }
-  Cache->LastSection = NULL;
-
-  FREE(Cache);
+  InfpFreeCache(Cache);
 }
 
 /* EOF */
@@ -45,14 +45,20 @@ typedef struct _INFCACHESECTION
 {
   struct _INFCACHESECTION *Next;
   struct _INFCACHESECTION *Prev;
+  struct _INFCACHESECTION *HashNext;
 
   PINFCACHELINE FirstLine;
   PINFCACHELINE LastLine;
   UINT Id;
+  ULONG Hash;
 
   LONG LineCount;
   UINT NextLineId;
 
+  /* Lines indexed by Id - 1 */
+  PINFCACHELINE *LineTable;
+  UINT LineTableSize;
+
   WCHAR Name[1];
 } INFCACHESECTION, *PINFCACHESECTION;
 
@@ -64,6 +70,14 @@ typedef struct _INFCACHE
   UINT NextSectionId;
 
   PINFCACHESECTION StringsSection;
+
+  /* Sections indexed by Id - 1 */
+  PINFCACHESECTION *SectionTable;
+  UINT SectionTableSize;
+
+  /* Case-insensitive hash of the section names */
+  PINFCACHESECTION *HashTable;
+  ULONG HashTableSize;
 } INFCACHE, *PINFCACHE;
 
 typedef struct _INFCONTEXT
@@ -83,6 +97,7 @@ extern INFSTATUS InfpParseBuffer(PINFCACHE file,
                                  const WCHAR *end,
                                  PULONG error_line);
 extern PINFCACHESECTION InfpFreeSection(PINFCACHESECTION Section);
+extern VOID InfpFreeCache(PINFCACHE Cache);
 extern PINFCACHESECTION InfpAddSection(PINFCACHE Cache,
                                        PCWSTR Name);
 extern PINFCACHELINE InfpAddLine(PINFCACHESECTION Section);
@@ -146,6 +161,8 @@ extern INFSTATUS InfpAddLineWithKey(PINFCONTEXT Context, PCWSTR Key);
 extern INFSTATUS InfpAddField(PINFCONTEXT Context, PCWSTR Data);
 
 extern VOID InfpFreeContext(PINFCONTEXT Context);
+PINFCACHESECTION
+InfpFindSectionById(PINFCACHE Cache, UINT Id);
 PINFCACHELINE
 InfpFindLineById(PINFCACHESECTION Section, UINT Id);
 PINFCACHESECTION
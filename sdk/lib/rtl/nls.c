@@ -35,6 +35,67 @@ PUSHORT NlsOemLeadByteInfo = NULL; /* exported */
 USHORT NlsOemDefaultChar = '\0';
 USHORT NlsUnicodeDefaultChar = 0;
 
+/* TRUE if the ANSI code page maps 0x00-0x7F to U+0000-U+007F and back */
+static BOOLEAN NlsAnsiIsAscii = FALSE;
+
+/* High bits of every byte, or of every WCHAR, in a machine word */
+#define ASCII_BYTE_MASK (~(ULONG_PTR)0 / 0xFF * 0x80)
+#define ASCII_WCHAR_MASK (~(ULONG_PTR)0 / 0xFFFF * 0xFF80)
+
+
+/* PRIVATE FUNCTIONS *********************************************************/
+
+/* Copies the ASCII characters MbString starts with, a machine word at a time */
+static
+ULONG
+RtlpWidenAscii(OUT PWCHAR UnicodeString,
+               IN PCSTR MbString,
+               IN ULONG Count)
+{
+    ULONG_PTR Word;
+    ULONG i, j;
+
+    for (i = 0; i + sizeof(ULONG_PTR) <= Count; i += sizeof(ULONG_PTR))
+    {
+        Word = *(const ULONG_PTR UNALIGNED *)&MbString[i];
+        if (Word & ASCII_BYTE_MASK)
+            break;
+
+        for (j = 0; j < sizeof(ULONG_PTR); j++, Word >>= 8)
+            UnicodeString[i + j] = (WCHAR)(Word & 0xFF);
+    }
+
+    for (; i < Count && (UCHAR)MbString[i] < 0x80; i++)
+        UnicodeString[i] = (WCHAR)MbString[i];
+
+    return i;
+}
+
+/* Copies the ASCII characters UnicodeString starts with, a machine word at a time */
+static
+ULONG
+RtlpNarrowAscii(OUT PCHAR MbString,
+                IN PCWCH UnicodeString,
+                IN ULONG Count)
+{
+    ULONG_PTR Word;
+    ULONG i, j;
+
+    for (i = 0; i + sizeof(ULONG_PTR) / sizeof(WCHAR) <= Count; i += sizeof(ULONG_PTR) / sizeof(WCHAR))
+    {
+        Word = *(const ULONG_PTR UNALIGNED *)&UnicodeString[i];
+        if (Word & ASCII_WCHAR_MASK)
+            break;
+
+        for (j = 0; j < sizeof(ULONG_PTR) / sizeof(WCHAR); j++, Word >>= 16)
+            MbString[i + j] = (CHAR)(Word & 0x7F);
+    }
+
+    for (; i < Count && UnicodeString[i] < 0x80; i++)
+        MbString[i] = (CHAR)UnicodeString[i];
+
+    return i;
+}
 
 /* FUNCTIONS *****************************************************************/
 
@@ -251,7 +312,16 @@ RtlMultiByteToUnicodeN(OUT PWCHAR UnicodeString,
             *ResultSize = Size * sizeof(WCHAR);
 
         for (i = 0; i < Size; i++)
+        {
+            if (NlsAnsiIsAscii && (UCHAR)MbString[i] < 0x80)
+            {
+                i += RtlpWidenAscii(&UnicodeString[i], &MbString[i], Size - i);
+                if (i == Size)
+                    break;
+            }
+
             UnicodeString[i] = NlsAnsiToUnicodeTable[(UCHAR)MbString[i]];
+        }
     }
     else
     {
@@ -261,17 +331,24 @@ RtlMultiByteToUnicodeN(OUT PWCHAR UnicodeString,
         UCHAR Char;
         USHORT LeadByteInfo;
         PCSTR MbEnd = MbString + MbSize;
+        ULONG Ascii;
 
         for (i = 0; i < UnicodeSize / sizeof(WCHAR) && MbString < MbEnd; i++)
         {
-            Char = *(PUCHAR)MbString++;
+            Char = *(PUCHAR)MbString;
 
             if (Char < 0x80)
             {
-                *UnicodeString++ = Char;
+                Ascii = RtlpWidenAscii(UnicodeString, MbString,
+                                       min((ULONG)(MbEnd - MbString), UnicodeSize / sizeof(WCHAR) - i));
+                UnicodeString += Ascii;
+                MbString += Ascii;
+                i += Ascii - 1;
                 continue;
             }
 
+            MbString++;
+
             LeadByteInfo = NlsLeadByteInfo[Char];
 
             if (!LeadByteInfo)
@@ -442,6 +519,8 @@ RtlOemToUnicodeN(OUT PWCHAR UnicodeString,
 VOID NTAPI
 RtlResetRtlTranslations(IN PNLSTABLEINFO NlsTable)
 {
+    ULONG i;
+
     PAGED_CODE_RTL();
 
     DPRINT("RtlResetRtlTranslations() called\n");
@@ -455,6 +534,19 @@ RtlResetRtlTranslations(IN PNLSTABLEINFO NlsTable)
     NlsAnsiCodePage = NlsTable->AnsiTableInfo.CodePage;
     DPRINT("Ansi codepage %hu\n", NlsAnsiCodePage);
 
+    /* Check if ASCII text can skip the ANSI tables */
+    NlsAnsiIsAscii = TRUE;
+    for (i = 0; i < 0x80; i++)
+    {
+        if (NlsAnsiToUnicodeTable[i] != i ||
+            (NlsMbCodePageTag ? (NlsLeadByteInfo[i] || NlsUnicodeToMbAnsiTable[i] != i)
+                              : (UCHAR)NlsUnicodeToAnsiTable[i] != i))
+        {
+            NlsAnsiIsAscii = FALSE;
+            break;
+        }
+    }
+
     /* Set OEM data */
     NlsOemToUnicodeTable = (PUSHORT)NlsTable->OemTableInfo.MultiByteTable;
     NlsUnicodeToOemTable = NlsTable->OemTableInfo.WideCharTable;
@@ -543,6 +635,17 @@ RtlUnicodeToMultiByteN(OUT PCHAR MbString,
 
         for (i = 0; i < Size; i++)
         {
+            if (NlsAnsiIsAscii && *UnicodeString < 0x80)
+            {
+                ULONG Ascii = RtlpNarrowAscii(MbString, UnicodeString, Size - i);
+
+                MbString += Ascii;
+                UnicodeString += Ascii;
+                i += Ascii;
+                if (i == Size)
+                    break;
+            }
+
             *MbString++ = NlsUnicodeToAnsiTable[*UnicodeString++];
         }
     }
@@ -553,17 +656,24 @@ RtlUnicodeToMultiByteN(OUT PCHAR MbString,
 
         USHORT WideChar;
         USHORT MbChar;
+        ULONG Ascii;
 
         for (i = MbSize, Size = UnicodeSize / sizeof(WCHAR); i && Size; i--, Size--)
         {
-            WideChar = *UnicodeString++;
+            WideChar = *UnicodeString;
 
             if (WideChar < 0x80)
             {
-                *MbString++ = LOBYTE(WideChar);
+                Ascii = RtlpNarrowAscii(MbString, UnicodeString, min(i, Size));
+                MbString += Ascii;
+                UnicodeString += Ascii;
+                i -= Ascii - 1;
+                Size -= Ascii - 1;
                 continue;
             }
 
+            UnicodeString++;
+
             MbChar = NlsUnicodeToMbAnsiTable[WideChar];
 
             if (!HIBYTE(MbChar))
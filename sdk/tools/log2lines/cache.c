@@ -22,6 +22,8 @@ static char CacheName[PATH_MAX];
 static char *cache_name = CacheName;
 static char TmpName[PATH_MAX];
 static char *tmp_name = TmpName;
+static char SymCacheName[PATH_MAX];
+char *symcache_name = SymCacheName;
 
 static int
 unpack_iso(char *dir, char *iso)
@@ -144,10 +146,17 @@ check_directory(int force)
         }
     }
     strcpy(cache_name, opt_dir);
+    strcpy(symcache_name, opt_dir);
     if (cleanable(opt_dir))
+    {
         strcat(cache_name, ALT_PATH_STR CACHEFILE);
+        strcat(symcache_name, ALT_PATH_STR SYMCACHEFILE);
+    }
     else
+    {
         strcat(cache_name, PATH_STR CACHEFILE);
+        strcat(symcache_name, PATH_STR SYMCACHEFILE);
+    }
     strcpy(tmp_name, cache_name);
     strcat(tmp_name, "~");
     return 0;
@@ -169,7 +178,7 @@ read_cache(void)
         l2l_dbg(1, "Open %s failed\n", cache_name);
         return 2;
     }
-    cache.phead = cache.ptail = NULL;
+    list_clear(&cache);
 
     while (fgets(Line, LINESIZE, fr) != NULL)
     {
@@ -199,6 +208,7 @@ create_cache(int force, int skipImageBase)
         l2l_dbg(1, "Apparently %s is not writable (mounted ISO?), using current dir\n", tmp_name);
         cache_name = basename(cache_name);
         tmp_name = basename(tmp_name);
+        symcache_name = basename(symcache_name);
     }
     else
     {
@@ -211,6 +221,7 @@ create_cache(int force, int skipImageBase)
     {
         l2l_dbg(3, "Removing %s ...\n", cache_name);
         remove(cache_name);
+        remove(symcache_name);
     }
     else
     {
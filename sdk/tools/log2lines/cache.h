@@ -12,4 +12,6 @@ int read_cache(void);
 int create_cache(int force, int skipImageBase);
 int cleanable(char *path);
 
+extern char *symcache_name;
+
 /* EOF */
@@ -8,6 +8,7 @@
 #define DEF_OPT_DIR     "output-i386"
 #define SOURCES_ENV     "_ROSBE_ROSSOURCEDIR"
 #define CACHEFILE       "log2lines.cache"
+#define SYMCACHEFILE    "log2lines.symcache"
 #define TRKBUILDPREFIX  "bootcd-"
 #define SVN_PREFIX      "/trunk/reactos/"
 #define PIPEREAD_CMD    "piperead -c"
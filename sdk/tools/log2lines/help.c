@@ -29,7 +29,10 @@ char *verboseUsage =
 "  - The offset of a relocated image MUST be relative.\n\n"
 "  log2lines uses a cache in order to avoid a directory scan at each\n"
 "  image lookup, greatly increasing performance. Only image path and its\n"
-"  base address are cached.\n\n"
+"  base address are cached.\n"
+"  The symbols of each image used are kept in a second, symbol cache\n"
+"  (" SYMCACHEFILE "), so later runs do not need to read and index\n"
+"  the images again. Entries are refreshed when an image changes.\n\n"
 "Options:\n"
 "  -b   Use this combined with '-l'. Enable buffering on logFile.\n"
 "       This may solve loosing output on real hardware (ymmv).\n\n"
@@ -46,7 +49,7 @@ char *verboseUsage =
 "       - Combined with -f the file will be re-unpacked.\n"
 "       - NOTE: this ISO unpack feature needs 7z to be in the PATH.\n"
 "       Default: " DEF_OPT_DIR "\n\n"
-"  -f   Force creating new cache.\n\n"
+"  -f   Force creating new cache. This also discards the symbol cache.\n\n"
 "  -F   As -f but exits immediately after creating cache.\n\n"
 "  -h   This text.\n\n"
 "  -l <logFile>\n"
@@ -58,6 +61,7 @@ char *verboseUsage =
 "  -m   Prefix (mark) each translated line with '* '.\n\n"
 "  -M   Prefix (mark) each NOT translated line with '? '.\n"
 "       ( Only for lines of the form: <IMAGENAME:ADDRESS> )\n\n"
+"  -n   Do not use (read or update) the symbol cache.\n\n"
 "  -P <cmd line>\n"
 "       Pipeline command line. Spawn <cmd line> and pipeline its output to\n"
 "       log2lines (as stdin). This is for shells lacking support of (one of):\n"
@@ -76,6 +80,8 @@ char *verboseUsage =
 "       - Reg candidates:  Regression candidates. See '-R regscan'\n"
 "       - Offset error:    Image exists, but error retrieving offset info.\n"
 "       - Total:           Total number of lines attempted to translate.\n"
+"       - Lines:           Input lines processed.\n"
+"       - Lines per second:Input lines processed per second of CPU time.\n"
 "       Also some version info is displayed.\n\n"
 "  -S <context>[+<add>][,<sources>]\n"
 "       Source line options:\n"
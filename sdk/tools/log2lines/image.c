@@ -7,13 +7,20 @@
 
 #include <errno.h>
 #include <string.h>
+#include <stdlib.h>
 #include <rsym.h>
 
 #include "compat.h"
 #include "util.h"
 #include "options.h"
+#include "image.h"
+#include "symcache.h"
 #include "log2lines.h"
 
+#define IMAGE_BUCKETS   1024
+
+static PIMAGE_SYMBOLS images[IMAGE_BUCKETS];
+
 static PIMAGE_SECTION_HEADER
 find_rossym_section(PIMAGE_FILE_HEADER PEFileHeader, PIMAGE_SECTION_HEADER PESectionHeaders)
 {
@@ -34,25 +41,25 @@ fixup_offset(size_t ImageBase, size_t offset)
     return offset;
 }
 
+/* Last symbol at or below offset, from the address sorted index */
 PROSSYM_ENTRY
-find_offset(void *data, size_t offset)
+find_offset(PIMAGE_SYMBOLS image, size_t offset)
 {
-    PSYMBOLFILE_HEADER RosSymHeader = (PSYMBOLFILE_HEADER)data;
-    PROSSYM_ENTRY Entries = (PROSSYM_ENTRY)((char *)data + RosSymHeader->SymbolsOffset);
-    size_t symbols = RosSymHeader->SymbolsLength / sizeof(ROSSYM_ENTRY);
-    size_t i;
+    size_t lo = 0, hi = image->Count;
 
-    for (i = 0; i < symbols; i++)
+    while (lo < hi)
     {
-        if (Entries[i].Address > offset)
-        {
-            if (!i--)
-                return NULL;
-            else
-                return &Entries[i];
-        }
+        size_t mid = lo + (hi - lo) / 2;
+        if (image->Entries[mid].Address > offset)
+            hi = mid;
+        else
+            lo = mid + 1;
     }
-    return NULL;
+
+    /* Like a linear scan: nothing before the first or after the last symbol */
+    if (lo == 0 || lo == image->Count)
+        return NULL;
+    return &image->Entries[lo - 1];
 }
 
 PIMAGE_SECTION_HEADER
@@ -70,7 +77,6 @@ get_sectionheader(const void *FileData)
     if (PEDosHeader->e_magic != IMAGE_DOS_MAGIC || PEDosHeader->e_lfanew == 0L)
     {
         l2l_dbg(0, "Input file is not a PE image.\n");
-        summ.offset_errors++;
         return NULL;
     }
 
@@ -90,7 +96,6 @@ get_sectionheader(const void *FileData)
     if (!PERosSymSectionHeader)
     {
         l2l_dbg(0, "Couldn't find rossym section in executable\n");
-        summ.offset_errors++;
         return NULL;
     }
 
@@ -165,4 +170,129 @@ get_ImageBase(char *fname, size_t *ImageBase)
     return 0;
 }
 
+static int
+compare_entries(const void *a, const void *b)
+{
+    const ROSSYM_ENTRY *e1 = a, *e2 = b;
+
+    if (e1->Address != e2->Address)
+        return e1->Address < e2->Address ? -1 : 1;
+    return 0;
+}
+
+/* Point the image at its .rossym data, sorting a private copy when needed */
+static int
+index_rossym(PIMAGE_SYMBOLS image)
+{
+    PIMAGE_SECTION_HEADER PERosSymSectionHeader;
+    PSYMBOLFILE_HEADER RosSymHeader;
+    char *RosSym;
+    size_t RosSymSize, i;
+
+    PERosSymSectionHeader = get_sectionheader(image->FileData);
+    if (!PERosSymSectionHeader)
+        return 2;
+
+    RosSym = (char *)image->FileData + PERosSymSectionHeader->PointerToRawData;
+    RosSymSize = PERosSymSectionHeader->SizeOfRawData;
+    RosSymHeader = (PSYMBOLFILE_HEADER)RosSym;
+    if (PERosSymSectionHeader->PointerToRawData + (size_t)RosSymSize > image->FileSize ||
+        RosSymSize < sizeof(SYMBOLFILE_HEADER) ||
+        RosSymHeader->SymbolsOffset + (size_t)RosSymHeader->SymbolsLength > RosSymSize ||
+        RosSymHeader->StringsOffset + (size_t)RosSymHeader->StringsLength > RosSymSize)
+    {
+        l2l_dbg(0, "Invalid rossym section in %s\n", image->path);
+        return 2;
+    }
+
+    image->Entries = (PROSSYM_ENTRY)(RosSym + RosSymHeader->SymbolsOffset);
+    image->Count = RosSymHeader->SymbolsLength / sizeof(ROSSYM_ENTRY);
+    image->Strings = RosSym + RosSymHeader->StringsOffset;
+    image->StringsLength = RosSymHeader->StringsLength;
+
+    /* rsym emits sorted symbols, only older images need a copy */
+    for (i = 1; i < image->Count; i++)
+    {
+        if (image->Entries[i].Address < image->Entries[i - 1].Address)
+            break;
+    }
+    if (i < image->Count)
+    {
+        l2l_dbg(2, "Sorting %u symbols of %s\n", (unsigned int)image->Count, image->path);
+        image->Sorted = malloc(image->Count * sizeof(ROSSYM_ENTRY));
+        if (!image->Sorted)
+            return 1;
+        memcpy(image->Sorted, image->Entries, image->Count * sizeof(ROSSYM_ENTRY));
+        qsort(image->Sorted, image->Count, sizeof(ROSSYM_ENTRY), compare_entries);
+        image->Entries = image->Sorted;
+    }
+    return 0;
+}
+
+/* Symbols of an image, loaded and indexed on first use and kept
+   (mapped) until image_clear(). Failures are remembered as well. */
+PIMAGE_SYMBOLS
+image_symbols(const char *path)
+{
+    PIMAGE_SYMBOLS image;
+    unsigned int hash = path_hash(path);
+    unsigned long long mtime = 0, size = 0;
+    int stamped;
+
+    for (image = images[hash % IMAGE_BUCKETS]; image; image = image->pnext)
+    {
+        if (image->hash == hash && strcmp(image->path, path) == 0)
+            return image;
+    }
+
+    image = calloc(1, sizeof(IMAGE_SYMBOLS) + strlen(path) + 1);
+    if (!image)
+        return NULL;
+    image->path = (char *)(image + 1);
+    strcpy(image->path, path);
+    image->hash = hash;
+    image->pnext = images[hash % IMAGE_BUCKETS];
+    images[hash % IMAGE_BUCKETS] = image;
+
+    stamped = !file_stamp(path, &mtime, &size);
+    if (stamped && !symcache_lookup(path, mtime, size, image))
+    {
+        l2l_dbg(3, "Symbols of %s from symbol cache\n", path);
+        image->status = 0;
+        return image;
+    }
+
+    image->FileData = map_file(path, &image->FileSize);
+    if (!image->FileData)
+    {
+        l2l_dbg(0, "An error occured loading '%s'\n", path);
+        image->status = 1;
+        return image;
+    }
+
+    image->status = index_rossym(image);
+    if (!image->status && stamped)
+        symcache_add(path, mtime, size, image);
+    return image;
+}
+
+void
+image_clear(void)
+{
+    PIMAGE_SYMBOLS image, pnext;
+    size_t i;
+
+    for (i = 0; i < IMAGE_BUCKETS; i++)
+    {
+        for (image = images[i]; image; image = pnext)
+        {
+            pnext = image->pnext;
+            unmap_file(image->FileData, image->FileSize);
+            free(image->Sorted);
+            free(image);
+        }
+        images[i] = NULL;
+    }
+}
+
 /* EOF */
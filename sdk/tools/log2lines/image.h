@@ -11,7 +11,26 @@
 
 size_t fixup_offset(size_t ImageBase, size_t offset);
 
-PROSSYM_ENTRY find_offset(void *data, size_t offset);
+typedef struct image_symbols_struct
+{
+    char *path;
+    unsigned int hash;
+    struct image_symbols_struct *pnext;
+    int status;                 // 0: symbols available
+    void *FileData;             // mapped image, NULL when served from the symbol cache
+    size_t FileSize;
+    PROSSYM_ENTRY Entries;      // sorted by Address
+    size_t Count;
+    char *Strings;
+    size_t StringsLength;
+    PROSSYM_ENTRY Sorted;       // private copy, when .rossym was not sorted
+} IMAGE_SYMBOLS, *PIMAGE_SYMBOLS;
+
+PROSSYM_ENTRY find_offset(PIMAGE_SYMBOLS image, size_t offset);
+
+PIMAGE_SYMBOLS image_symbols(const char *path);
+
+void image_clear(void);
 
 PIMAGE_SECTION_HEADER get_sectionheader(const void *FileData);
 
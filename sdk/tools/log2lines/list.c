@@ -8,6 +8,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <ctype.h>
 
 #include "config.h"
 #include "compat.h"
@@ -15,30 +16,83 @@
 #include "util.h"
 #include "options.h"
 
+#define LIST_INITIAL_BUCKETS    256
+
+/* Case insensitive (PATHCMP) FNV-1a hash */
+unsigned int
+path_hash(const char *name)
+{
+    unsigned int hash = 2166136261u;
+
+    while (*name)
+    {
+        hash ^= (unsigned char)tolower((unsigned char)*name++);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void
+list_rehash(PLIST list, unsigned int nbuckets)
+{
+    PLIST_MEMBER *buckets;
+    PLIST_MEMBER pentry;
+    unsigned int i;
+
+    buckets = calloc(nbuckets, sizeof(PLIST_MEMBER));
+    if (!buckets)
+        return; // keep the old (longer) chains
+
+    /* Rebuild from the list so entries inserted last stay in front */
+    for (i = 0; i < list->nbuckets; i++)
+    {
+        pentry = list->buckets[i];
+        while (pentry)
+        {
+            PLIST_MEMBER pnext = pentry->phnext;
+            PLIST_MEMBER *pslot = &buckets[pentry->hash & (nbuckets - 1)];
+
+            /* append, keeping the chain order */
+            while (*pslot)
+                pslot = &(*pslot)->phnext;
+            pentry->phnext = NULL;
+            *pslot = pentry;
+            pentry = pnext;
+        }
+    }
+    free(list->buckets);
+    list->buckets = buckets;
+    list->nbuckets = nbuckets;
+}
+
 PLIST_MEMBER
 entry_lookup(PLIST list, char *name)
 {
     PLIST_MEMBER pprev = NULL;
     PLIST_MEMBER pnext;
+    PLIST_MEMBER *pslot;
+    unsigned int hash;
 
-    if (!name || !name[0])
+    if (!name || !name[0] || !list->buckets)
         return NULL;
 
-    pnext = list->phead;
+    hash = path_hash(name);
+    pslot = &list->buckets[hash & (list->nbuckets - 1)];
+    pnext = *pslot;
     while (pnext != NULL)
     {
-        if (PATHCMP(name, pnext->name) == 0)
+        if (pnext->hash == hash && PATHCMP(name, pnext->name) == 0)
         {
             if (pprev)
-            {   // move to head for faster lookup next time
-                pprev->pnext = pnext->pnext;
-                pnext->pnext = list->phead;
-                list->phead = pnext;
+            {   // move to head of the bucket for faster lookup next time
+                pprev->phnext = pnext->phnext;
+                pnext->phnext = *pslot;
+                *pslot = pnext;
             }
             return pnext;
         }
         pprev = pnext;
-        pnext = pnext->pnext;
+        pnext = pnext->phnext;
     }
     return NULL;
 }
@@ -57,13 +111,30 @@ entry_delete(PLIST_MEMBER pentry)
 PLIST_MEMBER
 entry_insert(PLIST list, PLIST_MEMBER pentry)
 {
+    PLIST_MEMBER *pslot;
+
     if (!pentry)
         return NULL;
 
+    if (!list->buckets)
+        list_rehash(list, LIST_INITIAL_BUCKETS);
+    else if (list->count >= list->nbuckets)
+        list_rehash(list, list->nbuckets * 2);
+
     pentry->pnext = list->phead;
     list->phead = pentry;
     if (!list->ptail)
         list->ptail = pentry;
+
+    pentry->hash = path_hash(pentry->name);
+    pentry->phnext = NULL;
+    if (list->buckets)
+    {
+        pslot = &list->buckets[pentry->hash & (list->nbuckets - 1)];
+        pentry->phnext = *pslot;
+        *pslot = pentry;
+        list->count++;
+    }
     return pentry;
 }
 
@@ -77,7 +148,8 @@ void list_clear(PLIST list)
         entry_delete(pentry);
         pentry = pnext;
     }
-    list->phead = list->ptail = NULL;
+    free(list->buckets);
+    memset(list, 0, sizeof(LIST));
 }
 
 #if 0
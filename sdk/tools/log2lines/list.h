@@ -9,14 +9,21 @@ typedef struct entry_struct
     size_t RelBase;
     size_t Size;
     struct entry_struct *pnext;
+    struct entry_struct *phnext;    // next in hash bucket
+    unsigned int hash;
 } LIST_MEMBER, *PLIST_MEMBER;
 
 typedef struct list_struct
 {
     PLIST_MEMBER phead;
     PLIST_MEMBER ptail;
+    PLIST_MEMBER *buckets;          // hash on name, see entry_lookup()
+    unsigned int nbuckets;
+    unsigned int count;
 } LIST, *PLIST;
 
+unsigned int path_hash(const char *name);
+
 PLIST_MEMBER entry_lookup(PLIST list, char *name);
 PLIST_MEMBER entry_delete(PLIST_MEMBER pentry);
 PLIST_MEMBER entry_insert(PLIST list, PLIST_MEMBER pentry);
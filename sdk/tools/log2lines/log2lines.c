@@ -9,6 +9,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "util.h"
 #include "version.h"
@@ -16,6 +17,7 @@
 #include "options.h"
 #include "image.h"
 #include "cache.h"
+#include "symcache.h"
 #include "log2lines.h"
 #include "help.h"
 #include "cmd.h"
@@ -104,20 +106,19 @@ report(FILE *outFile)
 
 
 static int
-print_offset(void *data, size_t offset, char *toString)
+print_offset(PIMAGE_SYMBOLS image, size_t offset, char *toString)
 {
-    PSYMBOLFILE_HEADER RosSymHeader = (PSYMBOLFILE_HEADER)data;
     PROSSYM_ENTRY e = NULL;
     PROSSYM_ENTRY e2 = NULL;
     int bFileOffsetChanged = 0;
     char fmt[LINESIZE];
-    char *Strings = (char *)data + RosSymHeader->StringsOffset;
+    char *Strings = image->Strings;
 
     fmt[0] = '\0';
-    e = find_offset(data, offset);
+    e = find_offset(image, offset);
     if (opt_twice)
     {
-        e2 = find_offset(data, offset - 1);
+        e2 = find_offset(image, offset - 1);
 
         if (e == e2)
             e2 = NULL;
@@ -216,15 +217,21 @@ print_offset(void *data, size_t offset, char *toString)
 }
 
 static int
-process_data(const void *FileData, size_t offset, char *toString)
+process_file(const char *file_name, size_t offset, char *toString)
 {
+    PIMAGE_SYMBOLS image;
     int res;
 
-    PIMAGE_SECTION_HEADER PERosSymSectionHeader = get_sectionheader((char *)FileData);
-    if (!PERosSymSectionHeader)
+    image = image_symbols(file_name);
+    if (!image || image->status == 1)
+        return 1;
+    if (image->status)
+    {
+        summ.offset_errors++;
         return 2;
+    }
 
-    res = print_offset((char *)FileData + PERosSymSectionHeader->PointerToRawData, offset, toString);
+    res = print_offset(image, offset, toString);
     if (res)
     {
         if (toString)
@@ -238,26 +245,6 @@ process_data(const void *FileData, size_t offset, char *toString)
     return res;
 }
 
-static int
-process_file(const char *file_name, size_t offset, char *toString)
-{
-    void *FileData;
-    size_t FileSize;
-    int res = 1;
-
-    FileData = load_file(file_name, &FileSize);
-    if (!FileData)
-    {
-        l2l_dbg(0, "An error occured loading '%s'\n", file_name);
-    }
-    else
-    {
-        res = process_data(FileData, offset, toString);
-        free(FileData);
-    }
-    return res;
-}
-
 static int
 translate_file(const char *cpath, size_t offset, char *toString)
 {
@@ -417,6 +404,7 @@ translate_files(FILE *inFile, FILE *outFile)
     const char *pc    = kdbg_cont;
     const char *p     = kdbg_prompt;
     const char *p_eos = p + sizeof(KDBG_PROMPT) - 1; //end of string pos
+    clock_t start = clock();
 
     memset(Line, '\0', LINESIZE + 1);
     if (opt_console)
@@ -431,6 +419,7 @@ translate_files(FILE *inFile, FILE *outFile)
                 switch (ch)
                 {
                 case '\n':
+                    summ.lines++;
                     if ( strncmp(Line, KDBG_DISCARD, sizeof(KDBG_DISCARD)-1) == 0 )
                     {
                         memset(Line, '\0', LINESIZE);  // flushed
@@ -523,6 +512,7 @@ translate_files(FILE *inFile, FILE *outFile)
         {
             if (opt_quit)break;
 
+            summ.lines++;
             if (!opt_raw)
             {
                 translate_line(outFile, Line, path, LineOut);
@@ -533,6 +523,7 @@ translate_files(FILE *inFile, FILE *outFile)
         }
     }
 
+    summ.seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
     if (opt_stats)
     {
         stat_print(outFile, &summ);
@@ -587,6 +578,9 @@ main(int argc, const char **argv)
     read_cache();
     l2l_dbg(4, "Cache read complete\n");
 
+    if (!opt_nosymcache)
+        symcache_read(symcache_name);
+
     if (set_LogFile(&logFile))
     {
         res = 2;
@@ -664,6 +658,9 @@ cleanup:
         opt_Pipe = NULL;
     }
 
+    symcache_write();
+    image_clear();
+    symcache_clear();
     list_clear(&sources);
     list_clear(&cache);
 
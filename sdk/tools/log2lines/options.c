@@ -17,7 +17,7 @@
 #include "log2lines.h"
 #include "options.h"
 
-char *optchars       = "bcd:fFhl:L:mMP:rsS:tTuUvz:";
+char *optchars       = "bcd:fFhl:L:mMnP:rsS:tTuUvz:";
 int   opt_buffered   = 0;        // -b
 int   opt_help       = 0;        // -h
 int   opt_force      = 0;        // -f
@@ -26,6 +26,7 @@ int   opt_verbose    = 0;        // -v
 int   opt_console    = 0;        // -c
 int   opt_mark       = 0;        // -m
 int   opt_Mark       = 0;        // -M
+int   opt_nosymcache = 0;        // -n
 char *opt_Pipe       = NULL;     // -P
 int   opt_quit       = 0;        // -q (cli only)
 int   opt_cli        = 0;        // (cli internal)
@@ -151,6 +152,9 @@ int optionParse(int argc, const char **argv)
         case 'M':
             opt_Mark++;
             break;
+        case 'n':
+            opt_nosymcache++;
+            break;
         case 'r':
             opt_raw++;
             break;
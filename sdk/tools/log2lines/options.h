@@ -16,6 +16,7 @@ extern int   opt_verbose;   // -v
 extern int   opt_console;   // -c
 extern int   opt_mark;      // -m
 extern int   opt_Mark;      // -M
+extern int   opt_nosymcache;// -n
 extern char *opt_Pipe;      // -P
 extern int   opt_quit;      // -q (cli only)
 extern int   opt_cli;       // (cli internal)
@@ -21,6 +21,8 @@ typedef struct summ_struct
     int regfound;
     int offset_errors;
     int total;
+    int lines;
+    double seconds;
 } SUMM, *PSUMM;
 
 void stat_print(FILE *outFile, PSUMM psumm);
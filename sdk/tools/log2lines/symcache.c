@@ -0,0 +1,329 @@
+/*
+ * ReactOS log2lines
+ *
+ * - Persistent symbol cache
+ *
+ * Keeps the sorted .rossym symbols and strings of every image used so far
+ * in one file, keyed by image path, modification time and size. Later runs
+ * map this file once instead of mapping and indexing each image again.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "util.h"
+#include "compat.h"
+#include "options.h"
+#include "image.h"
+#include "symcache.h"
+#include "log2lines.h"
+
+#define SYMCACHE_MAGIC      0x534C324C  /* 'L2LS' */
+#define SYMCACHE_VERSION    1
+#define SYMCACHE_BUCKETS    1024
+#define SYMCACHE_ALIGN(n)   (((n) + 7) & ~(size_t)7)
+
+typedef struct symcache_header
+{
+    unsigned int Magic;
+    unsigned int Version;
+    unsigned int EntrySize;         // sizeof(ROSSYM_ENTRY) of the writer
+    unsigned int Count;
+} SYMCACHE_HEADER;
+
+/* Followed by the path, the symbols and the strings, each 8 byte aligned */
+typedef struct symcache_record
+{
+    unsigned int RecordSize;
+    unsigned int PathLength;        // including '\0'
+    unsigned long long MTime;
+    unsigned long long FileSize;
+    unsigned int SymbolCount;
+    unsigned int StringsLength;
+} SYMCACHE_RECORD;
+
+typedef struct symcache_entry
+{
+    struct symcache_entry *pnext;
+    unsigned int hash;
+    char *path;
+    char *buf;                      // path copy for entries not from the file
+    unsigned long long MTime;
+    unsigned long long FileSize;
+    PROSSYM_ENTRY Entries;
+    size_t Count;
+    char *Strings;
+    size_t StringsLength;
+} SYMCACHE_ENTRY, *PSYMCACHE_ENTRY;
+
+static char SymCacheName[PATH_MAX];
+static void *SymCacheData = NULL;
+static size_t SymCacheSize = 0;
+static PSYMCACHE_ENTRY buckets[SYMCACHE_BUCKETS];
+static unsigned int count = 0;
+static int dirty = 0;
+
+static PSYMCACHE_ENTRY
+symcache_find(const char *path, unsigned int hash)
+{
+    PSYMCACHE_ENTRY pentry;
+
+    for (pentry = buckets[hash % SYMCACHE_BUCKETS]; pentry; pentry = pentry->pnext)
+    {
+        if (pentry->hash == hash && strcmp(pentry->path, path) == 0)
+            return pentry;
+    }
+    return NULL;
+}
+
+static PSYMCACHE_ENTRY
+symcache_insert(char *path)
+{
+    PSYMCACHE_ENTRY pentry;
+    unsigned int hash = path_hash(path);
+
+    pentry = symcache_find(path, hash);
+    if (pentry)
+        return pentry;
+
+    pentry = calloc(1, sizeof(SYMCACHE_ENTRY));
+    if (!pentry)
+        return NULL;
+    pentry->hash = hash;
+    pentry->path = path;
+    pentry->pnext = buckets[hash % SYMCACHE_BUCKETS];
+    buckets[hash % SYMCACHE_BUCKETS] = pentry;
+    count++;
+    return pentry;
+}
+
+int
+symcache_read(const char *name)
+{
+    SYMCACHE_HEADER *header;
+    SYMCACHE_RECORD *record;
+    PSYMCACHE_ENTRY pentry;
+    size_t pos, need;
+    char *data;
+    unsigned int i;
+
+    strncpy(SymCacheName, name, sizeof(SymCacheName) - 1);
+    SymCacheData = map_file(SymCacheName, &SymCacheSize);
+    if (!SymCacheData)
+    {
+        l2l_dbg(1, "No symbol cache %s\n", SymCacheName);
+        return 1;
+    }
+
+    data = SymCacheData;
+    header = SymCacheData;
+    if (SymCacheSize < sizeof(SYMCACHE_HEADER) ||
+        header->Magic != SYMCACHE_MAGIC ||
+        header->Version != SYMCACHE_VERSION ||
+        header->EntrySize != sizeof(ROSSYM_ENTRY))
+    {
+        l2l_dbg(1, "Ignoring incompatible symbol cache %s\n", SymCacheName);
+        unmap_file(SymCacheData, SymCacheSize);
+        SymCacheData = NULL;
+        return 2;
+    }
+
+    pos = SYMCACHE_ALIGN(sizeof(SYMCACHE_HEADER));
+    for (i = 0; i < header->Count; i++)
+    {
+        if (pos + sizeof(SYMCACHE_RECORD) > SymCacheSize)
+            break;
+        record = (SYMCACHE_RECORD *)(data + pos);
+        need = SYMCACHE_ALIGN(sizeof(SYMCACHE_RECORD)) +
+               SYMCACHE_ALIGN(record->PathLength) +
+               SYMCACHE_ALIGN((size_t)record->SymbolCount * sizeof(ROSSYM_ENTRY)) +
+               SYMCACHE_ALIGN(record->StringsLength);
+        if (record->RecordSize != need || pos + need > SymCacheSize || !record->PathLength ||
+            data[pos + SYMCACHE_ALIGN(sizeof(SYMCACHE_RECORD)) + record->PathLength - 1] != '\0')
+        {
+            break;
+        }
+
+        pentry = symcache_insert(data + pos + SYMCACHE_ALIGN(sizeof(SYMCACHE_RECORD)));
+        if (!pentry)
+            break;
+        pentry->MTime = record->MTime;
+        pentry->FileSize = record->FileSize;
+        pentry->Entries = (PROSSYM_ENTRY)(pentry->path + SYMCACHE_ALIGN(record->PathLength));
+        pentry->Count = record->SymbolCount;
+        pentry->Strings = (char *)pentry->Entries + SYMCACHE_ALIGN(pentry->Count * sizeof(ROSSYM_ENTRY));
+        pentry->StringsLength = record->StringsLength;
+        pos += need;
+    }
+    if (i < header->Count)
+    {
+        l2l_dbg(1, "Symbol cache %s truncated at record %u\n", SymCacheName, i);
+        dirty = 1;
+    }
+
+    l2l_dbg(2, "Symbol cache %s: %u images\n", SymCacheName, count);
+    return 0;
+}
+
+int
+symcache_lookup(const char *path, unsigned long long mtime, unsigned long long size, PIMAGE_SYMBOLS image)
+{
+    PSYMCACHE_ENTRY pentry = symcache_find(path, path_hash(path));
+
+    if (!pentry || pentry->MTime != mtime || pentry->FileSize != size)
+        return 1;
+
+    image->Entries = pentry->Entries;
+    image->Count = pentry->Count;
+    image->Strings = pentry->Strings;
+    image->StringsLength = pentry->StringsLength;
+    return 0;
+}
+
+/* The image symbols must stay valid until symcache_write() */
+int
+symcache_add(const char *path, unsigned long long mtime, unsigned long long size, PIMAGE_SYMBOLS image)
+{
+    PSYMCACHE_ENTRY pentry;
+    char *buf;
+
+    if (!SymCacheName[0])
+        return 1;
+
+    pentry = symcache_find(path, path_hash(path));
+    if (!pentry)
+    {
+        buf = malloc(strlen(path) + 1);
+        if (!buf)
+            return 1;
+        strcpy(buf, path);
+        pentry = symcache_insert(buf);
+        if (!pentry)
+        {
+            free(buf);
+            return 1;
+        }
+        pentry->buf = buf;
+    }
+
+    pentry->MTime = mtime;
+    pentry->FileSize = size;
+    pentry->Entries = image->Entries;
+    pentry->Count = image->Count;
+    pentry->Strings = image->Strings;
+    pentry->StringsLength = image->StringsLength;
+    dirty = 1;
+    return 0;
+}
+
+static int
+write_padded(FILE *fw, const void *data, size_t len)
+{
+    static const char zero[8];
+
+    if (len && fwrite(data, len, 1, fw) != 1)
+        return 1;
+    if (SYMCACHE_ALIGN(len) != len && fwrite(zero, SYMCACHE_ALIGN(len) - len, 1, fw) != 1)
+        return 1;
+    return 0;
+}
+
+int
+symcache_write(void)
+{
+    char TmpName[PATH_MAX + 1];
+    SYMCACHE_HEADER header;
+    SYMCACHE_RECORD record;
+    PSYMCACHE_ENTRY pentry;
+    FILE *fw;
+    int res = 0;
+    size_t i;
+
+    if (!dirty || !SymCacheName[0])
+        return 0;
+
+    snprintf(TmpName, sizeof(TmpName), "%s~", SymCacheName);
+    fw = fopen(TmpName, "wb");
+    if (!fw)
+    {
+        l2l_dbg(1, "Cannot write symbol cache %s\n", TmpName);
+        return 1;
+    }
+
+    header.Magic = SYMCACHE_MAGIC;
+    header.Version = SYMCACHE_VERSION;
+    header.EntrySize = sizeof(ROSSYM_ENTRY);
+    header.Count = count;
+    res |= write_padded(fw, &header, sizeof(header));
+
+    for (i = 0; i < SYMCACHE_BUCKETS && !res; i++)
+    {
+        for (pentry = buckets[i]; pentry && !res; pentry = pentry->pnext)
+        {
+            memset(&record, 0, sizeof(record));
+            record.PathLength = strlen(pentry->path) + 1;
+            record.MTime = pentry->MTime;
+            record.FileSize = pentry->FileSize;
+            record.SymbolCount = pentry->Count;
+            record.StringsLength = pentry->StringsLength;
+            record.RecordSize = SYMCACHE_ALIGN(sizeof(record)) +
+                                SYMCACHE_ALIGN(record.PathLength) +
+                                SYMCACHE_ALIGN(pentry->Count * sizeof(ROSSYM_ENTRY)) +
+                                SYMCACHE_ALIGN(pentry->StringsLength);
+
+            res |= write_padded(fw, &record, sizeof(record));
+            res |= write_padded(fw, pentry->path, record.PathLength);
+            res |= write_padded(fw, pentry->Entries, pentry->Count * sizeof(ROSSYM_ENTRY));
+            res |= write_padded(fw, pentry->Strings, pentry->StringsLength);
+        }
+    }
+
+    if (fclose(fw) != 0)
+        res = 1;
+    if (res)
+    {
+        l2l_dbg(1, "Error writing symbol cache %s\n", TmpName);
+        remove(TmpName);
+        return 2;
+    }
+
+#if defined(_WIN32)
+    remove(SymCacheName);
+#endif
+    if (rename(TmpName, SymCacheName) != 0)
+    {
+        l2l_dbg(1, "Cannot replace symbol cache %s\n", SymCacheName);
+        remove(TmpName);
+        return 3;
+    }
+
+    l2l_dbg(2, "Symbol cache %s: wrote %u images\n", SymCacheName, count);
+    dirty = 0;
+    return 0;
+}
+
+void
+symcache_clear(void)
+{
+    PSYMCACHE_ENTRY pentry, pnext;
+    size_t i;
+
+    for (i = 0; i < SYMCACHE_BUCKETS; i++)
+    {
+        for (pentry = buckets[i]; pentry; pentry = pnext)
+        {
+            pnext = pentry->pnext;
+            free(pentry->buf);
+            free(pentry);
+        }
+        buckets[i] = NULL;
+    }
+    unmap_file(SymCacheData, SymCacheSize);
+    SymCacheData = NULL;
+    SymCacheSize = 0;
+    count = 0;
+    dirty = 0;
+}
+
+/* EOF */
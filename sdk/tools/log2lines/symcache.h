@@ -0,0 +1,17 @@
+/*
+ * ReactOS log2lines
+ *
+ * - Persistent symbol cache
+ */
+
+#pragma once
+
+#include "image.h"
+
+int symcache_read(const char *name);
+int symcache_lookup(const char *path, unsigned long long mtime, unsigned long long size, PIMAGE_SYMBOLS image);
+int symcache_add(const char *path, unsigned long long mtime, unsigned long long size, PIMAGE_SYMBOLS image);
+int symcache_write(void);
+void symcache_clear(void);
+
+/* EOF */
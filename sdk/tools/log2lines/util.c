@@ -9,6 +9,14 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+#include <rsym.h>
 
 #include "config.h"
 #include "compat.h"
@@ -187,4 +195,57 @@ copy_file(char *src, char *dst)
     return 0;
 }
 
+int
+file_stamp(const char *name, unsigned long long *mtime, unsigned long long *size)
+{
+    struct stat st;
+
+    if (stat(name, &st) != 0)
+        return 1;
+    *mtime = (unsigned long long)st.st_mtime;
+    *size = (unsigned long long)st.st_size;
+    return 0;
+}
+
+/* Map a whole file read-only. Falls back to reading it when mapping is not
+   available, in both cases release it with unmap_file(). */
+void *
+map_file(const char *name, size_t *size)
+{
+#if !defined(_WIN32)
+    struct stat st;
+    void *data;
+    int fd;
+
+    fd = open(name, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return NULL;
+    }
+    data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return NULL;
+    *size = st.st_size;
+    return data;
+#else
+    return load_file(name, size);
+#endif
+}
+
+void
+unmap_file(void *data, size_t size)
+{
+    if (!data)
+        return;
+#if !defined(_WIN32)
+    munmap(data, size);
+#else
+    free(data);
+#endif
+}
+
 /* EOF */
@@ -46,5 +46,8 @@ long my_atoi(const char *a);
 int isOffset(const char *a);
 int copy_file(char *src, char *dst);
 int set_LogFile(FILE **plogFile);
+int file_stamp(const char *name, unsigned long long *mtime, unsigned long long *size);
+void *map_file(const char *name, size_t *size);
+void unmap_file(void *data, size_t size);
 
 /* EOF */
@@ -0,0 +1,1092 @@
+/*
+ * PROJECT:     ReactOS hive maker
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Bulk registry import: in-memory key tree and one-pass hive layout
+ */
+
+/*
+ * In bulk import mode the registry operations of the INF files work on a
+ * plain in-memory tree instead of the hive cells, so that the cmlib index
+ * leaves are not split and reallocated for every new key. Once all the
+ * files are imported, every hive is laid out in one pass: its bins are
+ * allocated up front for the whole tree, and the subkeys of each key are
+ * sorted and put in index leaves of exactly the right size.
+ *
+ * The in-memory tree lives in a simple pool that is only freed as a whole
+ * by BulkShutdown(): the few keys and values that the INF files delete or
+ * overwrite are just left in it.
+ */
+
+/* INCLUDES *****************************************************************/
+
+#define NDEBUG
+#include "mkhive.h"
+
+/* DATA *********************************************************************/
+
+/* Same leaf limits as CmpAddSubKey() */
+#define BULK_MAX_FAST_INDEX                             \
+    ((HBLOCK_SIZE - (sizeof(HBIN) + sizeof(HCELL) +     \
+                     FIELD_OFFSET(CM_KEY_FAST_INDEX, List))) / sizeof(CM_INDEX))
+
+#define BULK_MAX_INDEX                                  \
+    ((HBLOCK_SIZE - (sizeof(HBIN) + sizeof(HCELL) +     \
+                     FIELD_OFFSET(CM_KEY_INDEX, List))) / sizeof(HCELL_INDEX) - 1)
+
+/* Size of a cell once allocated by HvAllocateCell() */
+#define BULK_CELL_SIZE(Size)    ROUND_UP((Size) + sizeof(HCELL), 16)
+
+#define BULK_HASH_MIN_BITS      10
+#define BULK_POOL_BLOCK_SIZE    (256 * 1024)
+
+typedef struct _BULK_VALUE
+{
+    ULONG Type;
+    ULONG DataLength;
+    PUCHAR Data;
+    USHORT NameLength;
+    PWCHAR Name;
+} BULK_VALUE, *PBULK_VALUE;
+
+typedef struct _BULK_KEY
+{
+    struct _BULK_KEY *Parent;
+    struct _BULK_KEY *HashNext;
+    struct _BULK_KEY *Link;         /* Mounted hive root or symbolic link target */
+    PCMHIVE RegistryHive;
+    HCELL_INDEX KeyCellOffset;      /* HCELL_NIL until laid out, except for hive roots */
+    ULONG Hash;
+    BOOLEAN Volatile;
+    BOOLEAN NoDelete;
+
+    ULONG SubKeyCount;
+    ULONG SubKeyMax;
+    struct _BULK_KEY **SubKeys;
+
+    ULONG ValueCount;
+    ULONG ValueMax;
+    PBULK_VALUE Values;
+
+    ULONG MaxNameLen;
+    ULONG MaxValueNameLen;
+    ULONG MaxValueDataLen;
+
+    USHORT NameLength;
+    WCHAR Name[ANYSIZE_ARRAY];
+} BULK_KEY, *PBULK_KEY;
+
+typedef struct _BULK_POOL_BLOCK
+{
+    struct _BULK_POOL_BLOCK *Next;
+} BULK_POOL_BLOCK, *PBULK_POOL_BLOCK;
+
+#define HKEY_TO_BULKKEY(hKey) ((PBULK_KEY)(hKey))
+#define BULKKEY_TO_HKEY(Key) ((HKEY)(Key))
+
+static PBULK_KEY BulkRoot;
+static PBULK_KEY BulkHiveRoots[MAX_NUMBER_OF_REGISTRY_HIVES];
+static ULONG BulkHiveCount;
+
+/* All the keys, hashed by parent and case-insensitive name */
+static PBULK_KEY *BulkHashTable;
+static ULONG BulkHashBits;
+static ULONG BulkKeyCount;
+
+static PBULK_POOL_BLOCK BulkPoolBlocks;
+static PUCHAR BulkPoolNext;
+static SIZE_T BulkPoolLeft;
+
+/* FUNCTIONS ****************************************************************/
+
+static PVOID
+BulkAllocate(
+    IN SIZE_T Size)
+{
+    PBULK_POOL_BLOCK Block;
+    SIZE_T BlockSize;
+    PVOID Buffer;
+
+    Size = ROUND_UP(Size, sizeof(PVOID));
+    if (Size > BulkPoolLeft)
+    {
+        /* Large buffers get their own block, so that the current one is kept */
+        BlockSize = (Size > BULK_POOL_BLOCK_SIZE) ? Size : BULK_POOL_BLOCK_SIZE;
+        Block = malloc(sizeof(BULK_POOL_BLOCK) + BlockSize);
+        if (!Block)
+            return NULL;
+        Block->Next = BulkPoolBlocks;
+        BulkPoolBlocks = Block;
+
+        if (BlockSize > Size)
+        {
+            BulkPoolNext = (PUCHAR)(Block + 1);
+            BulkPoolLeft = BlockSize;
+        }
+        else
+        {
+            return Block + 1;
+        }
+    }
+
+    Buffer = BulkPoolNext;
+    BulkPoolNext += Size;
+    BulkPoolLeft -= Size;
+    return Buffer;
+}
+
+/* Grow an array of the pool, the old one is left behind */
+static PVOID
+BulkGrowArray(
+    IN PVOID Array,
+    IN OUT PULONG MaxCount,
+    IN SIZE_T ElementSize)
+{
+    ULONG NewMax = *MaxCount ? 2 * *MaxCount : 4;
+    PVOID NewArray;
+
+    NewArray = BulkAllocate(NewMax * ElementSize);
+    if (!NewArray)
+        return NULL;
+
+    if (*MaxCount)
+        memcpy(NewArray, Array, *MaxCount * ElementSize);
+    *MaxCount = NewMax;
+    return NewArray;
+}
+
+static WCHAR
+BulkUpcaseChar(
+    IN WCHAR Char)
+{
+    /* Most of the names are plain ASCII */
+    if (Char < 'a')
+        return Char;
+    if (Char <= 'z')
+        return Char - ('a' - 'A');
+    if (Char < 0x80)
+        return Char;
+    return RtlUpcaseUnicodeChar(Char);
+}
+
+static ULONG
+BulkHashBucket(
+    IN PBULK_KEY Parent,
+    IN ULONG Hash)
+{
+    Hash ^= (ULONG)((ULONG_PTR)Parent >> 4);
+    return (Hash * 2654435761U) >> (32 - BulkHashBits);
+}
+
+static BOOL
+BulkGrowHashTable(VOID)
+{
+    PBULK_KEY *OldTable = BulkHashTable;
+    PBULK_KEY Key, Next;
+    ULONG OldSize = OldTable ? (1 << BulkHashBits) : 0;
+    ULONG Bits = OldTable ? BulkHashBits + 1 : BULK_HASH_MIN_BITS;
+    ULONG i, Bucket;
+
+    BulkHashTable = calloc(1 << Bits, sizeof(PBULK_KEY));
+    if (!BulkHashTable)
+    {
+        BulkHashTable = OldTable;
+        return FALSE;
+    }
+    BulkHashBits = Bits;
+
+    for (i = 0; i < OldSize; i++)
+    {
+        for (Key = OldTable[i]; Key; Key = Next)
+        {
+            Next = Key->HashNext;
+            Bucket = BulkHashBucket(Key->Parent, Key->Hash);
+            Key->HashNext = BulkHashTable[Bucket];
+            BulkHashTable[Bucket] = Key;
+        }
+    }
+
+    free(OldTable);
+    return TRUE;
+}
+
+static BOOLEAN
+BulkNameEqual(
+    IN PCWSTR Name,
+    IN USHORT NameLength,
+    IN PCUNICODE_STRING SearchName)
+{
+    USHORT i;
+
+    if (NameLength != SearchName->Length)
+        return FALSE;
+
+    for (i = 0; i < NameLength / sizeof(WCHAR); i++)
+    {
+        if (Name[i] != SearchName->Buffer[i] &&
+            BulkUpcaseChar(Name[i]) != BulkUpcaseChar(SearchName->Buffer[i]))
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+static PBULK_KEY
+BulkAllocateKey(
+    IN PCUNICODE_STRING Name,
+    IN ULONG Hash)
+{
+    PBULK_KEY Key;
+
+    Key = BulkAllocate(FIELD_OFFSET(BULK_KEY, Name) + Name->Length + sizeof(WCHAR));
+    if (!Key)
+        return NULL;
+
+    RtlZeroMemory(Key, FIELD_OFFSET(BULK_KEY, Name) + Name->Length + sizeof(WCHAR));
+    Key->KeyCellOffset = HCELL_NIL;
+    Key->Hash = Hash;
+    Key->NameLength = Name->Length;
+    memcpy(Key->Name, Name->Buffer, Name->Length);
+    return Key;
+}
+
+static PBULK_KEY
+BulkFindSubKey(
+    IN PBULK_KEY Parent,
+    IN PCUNICODE_STRING Name,
+    IN ULONG Hash)
+{
+    PBULK_KEY Key;
+
+    for (Key = BulkHashTable[BulkHashBucket(Parent, Hash)]; Key; Key = Key->HashNext)
+    {
+        if (Key->Parent == Parent && Key->Hash == Hash &&
+            BulkNameEqual(Key->Name, Key->NameLength, Name))
+        {
+            return Key;
+        }
+    }
+
+    return NULL;
+}
+
+static PBULK_KEY
+BulkAddSubKey(
+    IN PBULK_KEY Parent,
+    IN PCUNICODE_STRING Name,
+    IN ULONG Hash,
+    IN BOOL Volatile)
+{
+    PBULK_KEY Key, *SubKeys;
+    ULONG Bucket;
+
+    if (BulkKeyCount >= (2U << BulkHashBits) && !BulkGrowHashTable())
+        return NULL;
+
+    if (Parent->SubKeyCount == Parent->SubKeyMax)
+    {
+        SubKeys = BulkGrowArray(Parent->SubKeys, &Parent->SubKeyMax, sizeof(PBULK_KEY));
+        if (!SubKeys)
+            return NULL;
+        Parent->SubKeys = SubKeys;
+    }
+
+    Key = BulkAllocateKey(Name, Hash);
+    if (!Key)
+        return NULL;
+
+    Key->Parent = Parent;
+    Key->RegistryHive = Parent->RegistryHive;
+    Key->Volatile = !!Volatile;
+
+    Bucket = BulkHashBucket(Parent, Hash);
+    Key->HashNext = BulkHashTable[Bucket];
+    BulkHashTable[Bucket] = Key;
+    BulkKeyCount++;
+
+    Parent->SubKeys[Parent->SubKeyCount++] = Key;
+
+    /* Same bookkeeping as CmiAddSubKey() */
+    if (Parent->MaxNameLen < Name->Length)
+        Parent->MaxNameLen = Name->Length;
+
+    return Key;
+}
+
+static VOID
+BulkRemoveSubKey(
+    IN PBULK_KEY Key)
+{
+    PBULK_KEY Parent = Key->Parent;
+    PBULK_KEY *Entry;
+    ULONG i;
+
+    for (Entry = &BulkHashTable[BulkHashBucket(Parent, Key->Hash)];
+         *Entry != Key;
+         Entry = &(*Entry)->HashNext)
+    {
+        ;
+    }
+    *Entry = Key->HashNext;
+    BulkKeyCount--;
+
+    for (i = 0; Parent->SubKeys[i] != Key; i++)
+        ;
+    memmove(&Parent->SubKeys[i], &Parent->SubKeys[i + 1],
+            (Parent->SubKeyCount - i - 1) * sizeof(PBULK_KEY));
+
+    /* Same bookkeeping as CmpFreeKeyByCell() */
+    if (--Parent->SubKeyCount == 0)
+        Parent->MaxNameLen = 0;
+}
+
+LONG
+BulkCreateOrOpenKey(
+    IN HKEY hParentKey,
+    IN PCWSTR KeyName,
+    IN BOOL AllowCreation,
+    IN BOOL Volatile,
+    OUT PHKEY Key)
+{
+    PBULK_KEY Parent, SubKey;
+    PWSTR LocalKeyName;
+    PWSTR End;
+    UNICODE_STRING KeyString;
+    ULONG Hash;
+
+    DPRINT("BulkCreateOrOpenKey('%S')\n", KeyName);
+
+    if (*KeyName == OBJ_NAME_PATH_SEPARATOR)
+    {
+        KeyName++;
+        Parent = BulkRoot;
+    }
+    else if (hParentKey == NULL)
+    {
+        Parent = BulkRoot;
+    }
+    else
+    {
+        Parent = HKEY_TO_BULKKEY(hParentKey);
+    }
+
+    LocalKeyName = (PWSTR)KeyName;
+    for (;;)
+    {
+        End = (PWSTR)strchrW(LocalKeyName, OBJ_NAME_PATH_SEPARATOR);
+        if (End)
+        {
+            KeyString.Buffer = LocalKeyName;
+            KeyString.Length = KeyString.MaximumLength =
+                (USHORT)((ULONG_PTR)End - (ULONG_PTR)LocalKeyName);
+        }
+        else
+        {
+            RtlInitUnicodeString(&KeyString, LocalKeyName);
+            if (KeyString.Length == 0)
+            {
+                /* Trailing path separator: we're done */
+                break;
+            }
+        }
+
+        Hash = CmpComputeHashKey(0, &KeyString, TRUE);
+        SubKey = BulkFindSubKey(Parent, &KeyString, Hash);
+        if (SubKey)
+        {
+            /* Go through hive mount points and symbolic links */
+            if (SubKey->Link)
+                SubKey = SubKey->Link;
+        }
+        else if (AllowCreation)
+        {
+            SubKey = BulkAddSubKey(Parent, &KeyString, Hash, Volatile);
+        }
+
+        if (!SubKey)
+        {
+            DPRINT("BulkCreateOrOpenKey('%S'): Could not create or open subkey '%.*S'\n",
+                   KeyName, (int)(KeyString.Length / sizeof(WCHAR)), KeyString.Buffer);
+            return ERROR_GEN_FAILURE; // STATUS_UNSUCCESSFUL;
+        }
+
+        Parent = SubKey;
+        if (End)
+            LocalKeyName = End + 1;
+        else
+            break;
+    }
+
+    *Key = BULKKEY_TO_HKEY(Parent);
+    return ERROR_SUCCESS;
+}
+
+LONG
+BulkDeleteKey(
+    IN HKEY hKey,
+    IN PCWSTR lpSubKey OPTIONAL)
+{
+    PBULK_KEY Key;
+    HKEY hTargetKey;
+    LONG rc;
+
+    if (lpSubKey)
+    {
+        rc = BulkCreateOrOpenKey(hKey, lpSubKey, FALSE, FALSE, &hTargetKey);
+        if (rc != ERROR_SUCCESS)
+            return rc;
+    }
+    else
+    {
+        hTargetKey = hKey;
+    }
+
+    Key = HKEY_TO_BULKKEY(hTargetKey);
+
+    /* Keys with subkeys, the root and the hive roots cannot be deleted */
+    if (Key == BulkRoot || Key->NoDelete || Key->SubKeyCount)
+        return ERROR_ACCESS_DENIED; // STATUS_CANNOT_DELETE;
+
+    BulkRemoveSubKey(Key);
+    return ERROR_SUCCESS;
+}
+
+static PBULK_VALUE
+BulkFindValue(
+    IN PBULK_KEY Key,
+    IN PCUNICODE_STRING ValueName)
+{
+    ULONG i;
+
+    for (i = 0; i < Key->ValueCount; i++)
+    {
+        if (BulkNameEqual(Key->Values[i].Name, Key->Values[i].NameLength, ValueName))
+            return &Key->Values[i];
+    }
+
+    return NULL;
+}
+
+LONG
+BulkSetValue(
+    IN HKEY hKey,
+    IN PCWSTR lpValueName OPTIONAL,
+    IN ULONG dwType,
+    IN const UCHAR* lpData,
+    IN ULONG cbData)
+{
+    PBULK_KEY Key = HKEY_TO_BULKKEY(hKey);
+    PBULK_VALUE Value, Values;
+    UNICODE_STRING ValueNameString;
+    PUCHAR Data = NULL;
+    PWCHAR Name;
+
+    if (dwType == REG_LINK)
+    {
+        PBULK_KEY DestKey;
+
+        /* Special handling of registry links, as in RegSetValueExW() */
+        if (cbData != sizeof(PVOID))
+            return ERROR_INVALID_PARAMETER; // STATUS_INVALID_PARAMETER;
+
+        DestKey = HKEY_TO_BULKKEY(*(PHKEY)lpData);
+        if (Key->RegistryHive != DestKey->RegistryHive)
+            return ERROR_SUCCESS;
+
+        DPRINT1("Save link to registry\n");
+        return ERROR_INVALID_FUNCTION; // STATUS_NOT_IMPLEMENTED;
+    }
+
+    if ((cbData & ~CM_KEY_VALUE_SPECIAL_SIZE) != cbData)
+        return ERROR_GEN_FAILURE; // STATUS_UNSUCCESSFUL;
+
+    if (cbData)
+    {
+        Data = BulkAllocate(cbData);
+        if (!Data)
+            return ERROR_NOT_ENOUGH_MEMORY; // STATUS_NO_MEMORY;
+        memcpy(Data, lpData, cbData);
+    }
+
+    RtlInitUnicodeString(&ValueNameString, lpValueName);
+    Value = BulkFindValue(Key, &ValueNameString);
+    if (!Value)
+    {
+        /* New values go at the end of the list, as in CmiAddValueKey() */
+        if (Key->ValueCount == Key->ValueMax)
+        {
+            Values = BulkGrowArray(Key->Values, &Key->ValueMax, sizeof(BULK_VALUE));
+            if (!Values)
+                return ERROR_NOT_ENOUGH_MEMORY; // STATUS_NO_MEMORY;
+            Key->Values = Values;
+        }
+
+        Name = BulkAllocate(ValueNameString.Length + sizeof(WCHAR));
+        if (!Name)
+            return ERROR_NOT_ENOUGH_MEMORY; // STATUS_NO_MEMORY;
+        memcpy(Name, ValueNameString.Buffer, ValueNameString.Length);
+
+        Value = &Key->Values[Key->ValueCount++];
+        Value->Name = Name;
+        Value->NameLength = ValueNameString.Length;
+    }
+
+    Value->Type = dwType;
+    Value->Data = Data;
+    Value->DataLength = cbData;
+
+    /* Same bookkeeping as RegSetValueExW() */
+    if (Key->MaxValueNameLen < ValueNameString.Length)
+        Key->MaxValueNameLen = ValueNameString.Length;
+    if (Key->MaxValueDataLen < cbData)
+        Key->MaxValueDataLen = cbData;
+
+    return ERROR_SUCCESS;
+}
+
+LONG
+BulkQueryValue(
+    IN HKEY hKey,
+    IN PCWSTR lpValueName OPTIONAL,
+    OUT PULONG lpType OPTIONAL,
+    OUT PUCHAR lpData OPTIONAL,
+    IN OUT PULONG lpcbData OPTIONAL)
+{
+    PBULK_VALUE Value;
+    UNICODE_STRING ValueNameString;
+
+    RtlInitUnicodeString(&ValueNameString, lpValueName);
+    Value = BulkFindValue(HKEY_TO_BULKKEY(hKey), &ValueNameString);
+    if (!Value)
+        return ERROR_FILE_NOT_FOUND; // STATUS_OBJECT_NAME_NOT_FOUND;
+
+    if (lpType != NULL)
+        *lpType = Value->Type;
+
+    if (lpcbData != NULL)
+    {
+        if ((lpData != NULL) && (*lpcbData != 0))
+            memcpy(lpData, Value->Data, min(*lpcbData, Value->DataLength));
+        *lpcbData = Value->DataLength;
+    }
+
+    return ERROR_SUCCESS;
+}
+
+LONG
+BulkDeleteValue(
+    IN HKEY hKey,
+    IN PCWSTR lpValueName OPTIONAL)
+{
+    PBULK_KEY Key = HKEY_TO_BULKKEY(hKey);
+    PBULK_VALUE Value;
+    UNICODE_STRING ValueNameString;
+
+    RtlInitUnicodeString(&ValueNameString, lpValueName);
+    Value = BulkFindValue(Key, &ValueNameString);
+    if (!Value)
+        return ERROR_FILE_NOT_FOUND; // STATUS_OBJECT_NAME_NOT_FOUND;
+
+    memmove(Value, Value + 1,
+            (Key->ValueCount - (Value - Key->Values) - 1) * sizeof(BULK_VALUE));
+
+    /* Same bookkeeping as RegDeleteValueW() */
+    if (--Key->ValueCount == 0)
+    {
+        Key->MaxValueNameLen = 0;
+        Key->MaxValueDataLen = 0;
+    }
+
+    return ERROR_SUCCESS;
+}
+
+BOOL
+BulkInitialize(
+    IN PCMHIVE RootHive)
+{
+    UNICODE_STRING EmptyName = {0, 0, NULL};
+
+    if (!BulkGrowHashTable())
+        return FALSE;
+
+    BulkRoot = BulkAllocateKey(&EmptyName, 0);
+    if (!BulkRoot)
+        return FALSE;
+
+    BulkRoot->RegistryHive = RootHive;
+    BulkRoot->KeyCellOffset = RootHive->Hive.BaseBlock->RootCell;
+    BulkRoot->NoDelete = TRUE;
+    return TRUE;
+}
+
+BOOL
+BulkMountHive(
+    IN HKEY hMountKey,
+    IN PCMHIVE Hive)
+{
+    UNICODE_STRING EmptyName = {0, 0, NULL};
+    PBULK_KEY HiveRoot;
+
+    if (BulkHiveCount >= _countof(BulkHiveRoots))
+        return FALSE;
+
+    /* The root of the hive already has its cell, with its security */
+    HiveRoot = BulkAllocateKey(&EmptyName, 0);
+    if (!HiveRoot)
+        return FALSE;
+
+    HiveRoot->RegistryHive = Hive;
+    HiveRoot->KeyCellOffset = Hive->Hive.BaseBlock->RootCell;
+    HiveRoot->NoDelete = TRUE;
+
+    HKEY_TO_BULKKEY(hMountKey)->Link = HiveRoot;
+    BulkHiveRoots[BulkHiveCount++] = HiveRoot;
+    return TRUE;
+}
+
+BOOL
+BulkCreateLink(
+    IN HKEY hLinkKey,
+    IN HKEY hTargetKey)
+{
+    PBULK_KEY TargetKey = HKEY_TO_BULKKEY(hTargetKey);
+
+    /* Keep the link target alive as long as the link exists */
+    TargetKey->NoDelete = TRUE;
+    HKEY_TO_BULKKEY(hLinkKey)->Link = TargetKey;
+    return TRUE;
+}
+
+static int
+BulkCompareKeys(
+    const void *p1,
+    const void *p2)
+{
+    PBULK_KEY Key1 = *(PBULK_KEY*)p1;
+    PBULK_KEY Key2 = *(PBULK_KEY*)p2;
+    USHORT Length = min(Key1->NameLength, Key2->NameLength) / sizeof(WCHAR);
+    LONG Result;
+    USHORT i;
+
+    /* Same order as CmpCompareCompressedName() */
+    for (i = 0; i < Length; i++)
+    {
+        Result = (LONG)BulkUpcaseChar(Key1->Name[i]) -
+                 (LONG)BulkUpcaseChar(Key2->Name[i]);
+        if (Result)
+            return Result;
+    }
+
+    return (int)Key1->NameLength - (int)Key2->NameLength;
+}
+
+/* Choose the leaves the way CmpAddSubKey() ends up with them */
+static USHORT
+BulkLeafType(
+    IN PHHIVE Hive,
+    IN ULONG Count,
+    OUT PULONG EntrySize,
+    OUT PULONG LeafCount)
+{
+    USHORT Signature;
+
+    if (Hive->Version >= 5)
+        Signature = CM_KEY_HASH_LEAF;
+    else if (Hive->Version >= 3 && Count <= BULK_MAX_FAST_INDEX)
+        Signature = CM_KEY_FAST_LEAF;
+    else
+        Signature = CM_KEY_INDEX_LEAF;
+
+    *EntrySize = (Signature == CM_KEY_INDEX_LEAF) ? sizeof(HCELL_INDEX) : sizeof(CM_INDEX);
+    *LeafCount = (Count + BULK_MAX_INDEX - 1) / BULK_MAX_INDEX;
+    return Signature;
+}
+
+static ULONG
+BulkIndexSize(
+    IN PHHIVE Hive,
+    IN ULONG Count)
+{
+    ULONG EntrySize, LeafCount, Leaf, Size = 0;
+
+    BulkLeafType(Hive, Count, &EntrySize, &LeafCount);
+
+    for (Leaf = 0; Leaf < LeafCount; Leaf++)
+    {
+        Size += BULK_CELL_SIZE(FIELD_OFFSET(CM_KEY_INDEX, List) +
+                               (Count / LeafCount + (Leaf < Count % LeafCount)) * EntrySize);
+    }
+
+    if (LeafCount > 1)
+        Size += BULK_CELL_SIZE(FIELD_OFFSET(CM_KEY_INDEX, List) + LeafCount * sizeof(HCELL_INDEX));
+
+    return Size;
+}
+
+/* Add up the cells that BulkLayoutKey() will allocate below this key */
+static VOID
+BulkComputeSize(
+    IN PHHIVE Hive,
+    IN PBULK_KEY Key,
+    IN OUT PULONG Size)
+{
+    HSTORAGE_TYPE Storage = Key->Volatile ? Volatile : Stable;
+    ULONG Counts[HTYPE_COUNT] = {0};
+    UNICODE_STRING Name;
+    PBULK_KEY SubKey;
+    ULONG i;
+
+    if (Key->ValueCount)
+        Size[Storage] += BULK_CELL_SIZE(Key->ValueCount * sizeof(HCELL_INDEX));
+
+    for (i = 0; i < Key->ValueCount; i++)
+    {
+        Name.Buffer = Key->Values[i].Name;
+        Name.Length = Name.MaximumLength = Key->Values[i].NameLength;
+        Size[Storage] += BULK_CELL_SIZE(FIELD_OFFSET(CM_KEY_VALUE, Name) + CmpNameSize(Hive, &Name));
+
+        if (Key->Values[i].DataLength > sizeof(HCELL_INDEX))
+            Size[Storage] += BULK_CELL_SIZE(Key->Values[i].DataLength);
+    }
+
+    for (i = 0; i < Key->SubKeyCount; i++)
+    {
+        SubKey = Key->SubKeys[i];
+        Storage = SubKey->Volatile ? Volatile : Stable;
+        Counts[Storage]++;
+
+        Name.Buffer = SubKey->Name;
+        Name.Length = Name.MaximumLength = SubKey->NameLength;
+        Size[Storage] += BULK_CELL_SIZE(FIELD_OFFSET(CM_KEY_NODE, Name) + CmpNameSize(Hive, &Name));
+
+        if (!SubKey->Link)
+            BulkComputeSize(Hive, SubKey, Size);
+    }
+
+    for (i = 0; i < HTYPE_COUNT; i++)
+    {
+        if (Counts[i])
+            Size[i] += BulkIndexSize(Hive, Counts[i]);
+    }
+}
+
+static VOID
+BulkSetNameHint(
+    OUT PCM_INDEX Entry,
+    IN PBULK_KEY Key)
+{
+    ULONG j;
+
+    /* Same hint as CmpAddToLeaf() */
+    RtlZeroMemory(Entry->NameHint, sizeof(Entry->NameHint));
+    j = min(Key->NameLength / sizeof(WCHAR), 4);
+    while (j > 0)
+    {
+        if (Key->Name[j - 1] > (UCHAR)-1)
+            break;
+        Entry->NameHint[j - 1] = (UCHAR)Key->Name[j - 1];
+        j--;
+    }
+}
+
+/* Build the index of the (already sorted and created) subkeys in this storage */
+static HCELL_INDEX
+BulkBuildIndex(
+    IN PHHIVE Hive,
+    IN PBULK_KEY Key,
+    IN HSTORAGE_TYPE Storage,
+    IN ULONG Count)
+{
+    HCELL_INDEX RootCell = HCELL_NIL, LeafCell;
+    PCM_KEY_INDEX Root = NULL, Index;
+    PCM_KEY_FAST_INDEX FastIndex;
+    ULONG EntrySize, LeafCount, Leaf, Entries, i, j = 0;
+    UNICODE_STRING Name;
+    PBULK_KEY SubKey;
+    USHORT Signature;
+
+    Signature = BulkLeafType(Hive, Count, &EntrySize, &LeafCount);
+
+    if (LeafCount > 1)
+    {
+        RootCell = HvAllocateCell(Hive,
+                                  FIELD_OFFSET(CM_KEY_INDEX, List) + LeafCount * sizeof(HCELL_INDEX),
+                                  Storage,
+                                  HCELL_NIL);
+        if (RootCell == HCELL_NIL)
+            return HCELL_NIL;
+
+        Root = (PCM_KEY_INDEX)HvGetCell(Hive, RootCell);
+        Root->Signature = CM_KEY_INDEX_ROOT;
+        Root->Count = (USHORT)LeafCount;
+    }
+
+    for (Leaf = 0; Leaf < LeafCount; Leaf++)
+    {
+        /* Spread the subkeys evenly, so that every leaf has room to grow */
+        Entries = Count / LeafCount + (Leaf < Count % LeafCount);
+
+        LeafCell = HvAllocateCell(Hive,
+                                  FIELD_OFFSET(CM_KEY_INDEX, List) + Entries * EntrySize,
+                                  Storage,
+                                  HCELL_NIL);
+        if (LeafCell == HCELL_NIL)
+            return HCELL_NIL;
+
+        Index = (PCM_KEY_INDEX)HvGetCell(Hive, LeafCell);
+        FastIndex = (PCM_KEY_FAST_INDEX)Index;
+        Index->Signature = Signature;
+        Index->Count = (USHORT)Entries;
+
+        for (i = 0; i < Entries; i++)
+        {
+            do
+            {
+                SubKey = Key->SubKeys[j++];
+            } while ((SubKey->Volatile ? Volatile : Stable) != Storage);
+
+            if (Signature == CM_KEY_INDEX_LEAF)
+            {
+                Index->List[i] = SubKey->KeyCellOffset;
+            }
+            else if (Signature == CM_KEY_HASH_LEAF)
+            {
+                Name.Buffer = SubKey->Name;
+                Name.Length = Name.MaximumLength = SubKey->NameLength;
+                FastIndex->List[i].Cell = SubKey->KeyCellOffset;
+                FastIndex->List[i].HashKey = CmpComputeHashKey(0, &Name, FALSE);
+            }
+            else
+            {
+                FastIndex->List[i].Cell = SubKey->KeyCellOffset;
+                BulkSetNameHint(&FastIndex->List[i], SubKey);
+            }
+        }
+
+        HvReleaseCell(Hive, LeafCell);
+
+        if (Root)
+            Root->List[Leaf] = LeafCell;
+        else
+            RootCell = LeafCell;
+    }
+
+    if (Root)
+        HvReleaseCell(Hive, RootCell);
+
+    return RootCell;
+}
+
+static HCELL_INDEX
+BulkCreateValue(
+    IN PHHIVE Hive,
+    IN HSTORAGE_TYPE Storage,
+    IN PBULK_VALUE Value)
+{
+    HCELL_INDEX ValueCell, DataCell;
+    PCM_KEY_VALUE ValueData;
+    UNICODE_STRING Name;
+
+    Name.Buffer = Value->Name;
+    Name.Length = Name.MaximumLength = Value->NameLength;
+
+    ValueCell = HvAllocateCell(Hive,
+                               FIELD_OFFSET(CM_KEY_VALUE, Name) + CmpNameSize(Hive, &Name),
+                               Storage,
+                               HCELL_NIL);
+    if (ValueCell == HCELL_NIL)
+        return HCELL_NIL;
+
+    ValueData = (PCM_KEY_VALUE)HvGetCell(Hive, ValueCell);
+    ValueData->Signature = CM_KEY_VALUE_SIGNATURE;
+    ValueData->NameLength = CmpCopyName(Hive, ValueData->Name, &Name);
+    ValueData->Flags = (ValueData->NameLength < Name.Length) ? VALUE_COMP_NAME : 0;
+    ValueData->Type = Value->Type;
+    ValueData->Data = HCELL_NIL;
+
+    if (Value->DataLength <= sizeof(HCELL_INDEX))
+    {
+        /* Small data is stored in the data offset */
+        RtlCopyMemory(&ValueData->Data, Value->Data, Value->DataLength);
+        ValueData->DataLength = Value->DataLength | CM_KEY_VALUE_SPECIAL_SIZE;
+    }
+    else
+    {
+        DataCell = HvAllocateCell(Hive, Value->DataLength, Storage, HCELL_NIL);
+        if (DataCell == HCELL_NIL)
+        {
+            HvReleaseCell(Hive, ValueCell);
+            return HCELL_NIL;
+        }
+
+        RtlCopyMemory(HvGetCell(Hive, DataCell), Value->Data, Value->DataLength);
+        HvReleaseCell(Hive, DataCell);
+
+        ValueData->Data = DataCell;
+        ValueData->DataLength = Value->DataLength;
+    }
+
+    HvReleaseCell(Hive, ValueCell);
+    return ValueCell;
+}
+
+static BOOL
+BulkLayoutKey(
+    IN PHHIVE Hive,
+    IN PBULK_KEY Key)
+{
+    HSTORAGE_TYPE Storage = Key->Volatile ? Volatile : Stable;
+    ULONG Counts[HTYPE_COUNT] = {0};
+    UNICODE_STRING Name;
+    PCM_KEY_NODE KeyNode;
+    PHCELL_INDEX ValueList;
+    HCELL_INDEX ListCell, IndexCell;
+    PBULK_KEY SubKey;
+    NTSTATUS Status;
+    ULONG i;
+
+    /* The values, in the order they were created */
+    ListCell = HCELL_NIL;
+    if (Key->ValueCount)
+    {
+        ListCell = HvAllocateCell(Hive, Key->ValueCount * sizeof(HCELL_INDEX), Storage, HCELL_NIL);
+        if (ListCell == HCELL_NIL)
+            return FALSE;
+
+        ValueList = (PHCELL_INDEX)HvGetCell(Hive, ListCell);
+        for (i = 0; i < Key->ValueCount; i++)
+        {
+            ValueList[i] = BulkCreateValue(Hive, Storage, &Key->Values[i]);
+            if (ValueList[i] == HCELL_NIL)
+                return FALSE;
+        }
+        HvReleaseCell(Hive, ListCell);
+    }
+
+    /* The subkeys, in index order */
+    qsort(Key->SubKeys, Key->SubKeyCount, sizeof(PBULK_KEY), BulkCompareKeys);
+
+    for (i = 0; i < Key->SubKeyCount; i++)
+    {
+        SubKey = Key->SubKeys[i];
+        Counts[SubKey->Volatile ? Volatile : Stable]++;
+
+        Name.Buffer = SubKey->Name;
+        Name.Length = Name.MaximumLength = SubKey->NameLength;
+        Status = CmiCreateSubKey(Key->RegistryHive,
+                                 Key->KeyCellOffset,
+                                 &Name,
+                                 SubKey->Volatile,
+                                 &SubKey->KeyCellOffset);
+        if (!NT_SUCCESS(Status))
+            return FALSE;
+    }
+
+    KeyNode = (PCM_KEY_NODE)HvGetCell(Hive, Key->KeyCellOffset);
+    if (!KeyNode)
+        return FALSE;
+
+    HvMarkCellDirty(Hive, Key->KeyCellOffset, FALSE);
+
+    for (i = 0; i < HTYPE_COUNT; i++)
+    {
+        if (!Counts[i])
+            continue;
+
+        IndexCell = BulkBuildIndex(Hive, Key, (HSTORAGE_TYPE)i, Counts[i]);
+        if (IndexCell == HCELL_NIL)
+        {
+            HvReleaseCell(Hive, Key->KeyCellOffset);
+            return FALSE;
+        }
+
+        KeyNode->SubKeyCounts[i] = Counts[i];
+        KeyNode->SubKeyLists[i] = IndexCell;
+    }
+
+    KeyNode->ValueList.Count = Key->ValueCount;
+    KeyNode->ValueList.List = ListCell;
+    KeyNode->MaxNameLen = Key->MaxNameLen;
+    KeyNode->MaxValueNameLen = Key->MaxValueNameLen;
+    KeyNode->MaxValueDataLen = Key->MaxValueDataLen;
+    KeQuerySystemTime(&KeyNode->LastWriteTime);
+
+    HvReleaseCell(Hive, Key->KeyCellOffset);
+
+    for (i = 0; i < Key->SubKeyCount; i++)
+    {
+        /* Links have nothing below them */
+        if (!Key->SubKeys[i]->Link && !BulkLayoutKey(Hive, Key->SubKeys[i]))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+BOOL
+BulkLayoutHives(VOID)
+{
+    ULONG Size[HTYPE_COUNT];
+    PBULK_KEY HiveRoot;
+    PHHIVE Hive;
+    HCELL_INDEX Cell;
+    ULONG i, Type;
+
+    for (i = 0; i < BulkHiveCount; i++)
+    {
+        HiveRoot = BulkHiveRoots[i];
+        Hive = &HiveRoot->RegistryHive->Hive;
+
+        /*
+         * Pre-size the bins: allocate and free one cell as large as all
+         * the cells of the tree, which are then carved out of it in order.
+         */
+        Size[Stable] = Size[Volatile] = 0;
+        BulkComputeSize(Hive, HiveRoot, Size);
+
+        for (Type = 0; Type < HTYPE_COUNT; Type++)
+        {
+            if (!Size[Type])
+                continue;
+
+            Cell = HvAllocateCell(Hive, Size[Type] - sizeof(HCELL), (HSTORAGE_TYPE)Type, HCELL_NIL);
+            if (Cell == HCELL_NIL)
+                return FALSE;
+            HvFreeCell(Hive, Cell);
+        }
+
+        if (!BulkLayoutKey(Hive, HiveRoot))
+        {
+            DPRINT1("Failed to lay out hive %u\n", (unsigned)i);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+VOID
+BulkShutdown(VOID)
+{
+    PBULK_POOL_BLOCK Block;
+
+    while (BulkPoolBlocks)
+    {
+        Block = BulkPoolBlocks;
+        BulkPoolBlocks = Block->Next;
+        free(Block);
+    }
+    BulkPoolNext = NULL;
+    BulkPoolLeft = 0;
+
+    BulkRoot = NULL;
+    BulkHiveCount = 0;
+
+    free(BulkHashTable);
+    BulkHashTable = NULL;
+    BulkHashBits = 0;
+    BulkKeyCount = 0;
+}
+
+/* EOF */
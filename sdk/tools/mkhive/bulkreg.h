@@ -0,0 +1,63 @@
+/*
+ * PROJECT:     ReactOS hive maker
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Bulk registry import: in-memory key tree and one-pass hive layout
+ */
+
+#pragma once
+
+LONG
+BulkCreateOrOpenKey(
+    IN HKEY hParentKey,
+    IN PCWSTR KeyName,
+    IN BOOL AllowCreation,
+    IN BOOL Volatile,
+    OUT PHKEY Key);
+
+LONG
+BulkDeleteKey(
+    IN HKEY hKey,
+    IN PCWSTR lpSubKey OPTIONAL);
+
+LONG
+BulkSetValue(
+    IN HKEY hKey,
+    IN PCWSTR lpValueName OPTIONAL,
+    IN ULONG dwType,
+    IN const UCHAR* lpData,
+    IN ULONG cbData);
+
+LONG
+BulkQueryValue(
+    IN HKEY hKey,
+    IN PCWSTR lpValueName OPTIONAL,
+    OUT PULONG lpType OPTIONAL,
+    OUT PUCHAR lpData OPTIONAL,
+    IN OUT PULONG lpcbData OPTIONAL);
+
+LONG
+BulkDeleteValue(
+    IN HKEY hKey,
+    IN PCWSTR lpValueName OPTIONAL);
+
+BOOL
+BulkInitialize(
+    IN PCMHIVE RootHive);
+
+BOOL
+BulkMountHive(
+    IN HKEY hMountKey,
+    IN PCMHIVE Hive);
+
+BOOL
+BulkCreateLink(
+    IN HKEY hLinkKey,
+    IN HKEY hTargetKey);
+
+BOOL
+BulkLayoutHives(VOID);
+
+VOID
+BulkShutdown(VOID);
+
+/* EOF */
@@ -194,7 +194,7 @@ CmiCreateSecurityKey(
     return STATUS_SUCCESS;
 }
 
-static NTSTATUS
+NTSTATUS
 CmiCreateSubKey(
     IN PCMHIVE RegistryHive,
     IN HCELL_INDEX ParentKeyCellOffset,
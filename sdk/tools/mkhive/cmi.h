@@ -40,6 +40,14 @@ CmiCreateSecurityKey(
     IN PUCHAR Descriptor,
     IN ULONG DescriptorLength);
 
+NTSTATUS
+CmiCreateSubKey(
+    IN PCMHIVE RegistryHive,
+    IN HCELL_INDEX ParentKeyCellOffset,
+    IN PCUNICODE_STRING SubKeyName,
+    IN BOOLEAN VolatileKey,
+    OUT HCELL_INDEX* pNKBOffset);
+
 NTSTATUS
 CmiAddSubKey(
     IN PCMHIVE RegistryHive,
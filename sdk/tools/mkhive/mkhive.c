@@ -54,10 +54,14 @@
 
 void usage(void)
 {
-    printf("Usage: mkhive [-?] -h:hive1[,hiveN...] [-u] -d:<dstdir> <inffiles>\n\n"
+    printf("Usage: mkhive [-?] -h:hive1[,hiveN...] [-u] [-b] [-c:<cachedir>] -d:<dstdir> <inffiles>\n\n"
            "  -h:hiveN  - Comma-separated list of hives to create. Possible values are:\n"
            "              SETUPREG, SYSTEM, SOFTWARE, DEFAULT, SAM, SECURITY, BCD.\n"
            "  -u        - Generate file names in uppercase (default: lowercase) (TEMPORARY FLAG!).\n"
+           "  -b        - Bulk import: collect all the keys in memory first, then lay out\n"
+           "              each hive in one pass.\n"
+           "  -c:cachedir - Keep parsed copies of the INF files in this directory and\n"
+           "              reuse them while the INF files do not change.\n"
            "  -d:dstdir - The binary hive files are created in this directory.\n"
            "  inffiles  - List of INF files with full path.\n"
            "  -?        - Displays this help screen.\n");
@@ -97,8 +101,10 @@ int main(int argc, char *argv[])
     INT i;
     PSTR ptr;
     BOOL UpperCaseFileName = FALSE;
+    BOOL BulkImport = FALSE;
     PCSTR HiveList = NULL;
     CHAR DestPath[PATH_MAX] = "";
+    CHAR CachePath[PATH_MAX] = "";
     CHAR FileName[PATH_MAX];
 
     if (argc < 4)
@@ -122,6 +128,10 @@ int main(int argc, char *argv[])
         {
             UpperCaseFileName = TRUE;
         }
+        else if (argv[i][1] == 'b' && argv[i][2] == 0)
+        {
+            BulkImport = TRUE;
+        }
         else
         if (argv[i][1] == 'h' && (argv[i][2] == ':' || argv[i][2] == '='))
         {
@@ -131,6 +141,10 @@ int main(int argc, char *argv[])
         {
             convert_path(DestPath, argv[i] + 3);
         }
+        else if (argv[i][1] == 'c' && (argv[i][2] == ':' || argv[i][2] == '='))
+        {
+            convert_path(CachePath, argv[i] + 3);
+        }
         else
         {
             fprintf(stderr, "Unrecognized option: %s\n", argv[i]);
@@ -156,7 +170,7 @@ int main(int argc, char *argv[])
     }
 
     /* Initialize the registry */
-    RegInitializeRegistry(HiveList);
+    RegInitializeRegistry(HiveList, BulkImport);
 
     /* Default to failure */
     ret = -1;
@@ -165,10 +179,14 @@ int main(int argc, char *argv[])
     for (; i < argc; ++i)
     {
         convert_path(FileName, argv[i]);
-        if (!ImportRegistryFile(FileName))
+        if (!ImportRegistryFile(FileName, CachePath))
             goto Quit;
     }
 
+    /* In bulk import mode, write the collected keys to the hives */
+    if (!RegBuildHives())
+        goto Quit;
+
     for (i = 0; i < MAX_NUMBER_OF_REGISTRY_HIVES; ++i)
     {
         /* Skip this registry hive if it's not in the list */
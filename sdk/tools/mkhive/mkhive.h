@@ -122,6 +122,7 @@ RegOpenKeyW(
 #include "reginf.h"
 #include "cmi.h"
 #include "registry.h"
+#include "bulkreg.h"
 #include "binhive.h"
 
 #define OBJ_NAME_PATH_SEPARATOR           ((WCHAR)L'\\')
@@ -488,15 +488,15 @@ registry_callback(HINF hInf, PCWSTR Section, BOOL Delete)
 
 
 BOOL
-ImportRegistryFile(PCHAR FileName)
+ImportRegistryFile(PCHAR FileName, PCSTR CachePath)
 {
     HINF hInf;
     ULONG ErrorLine;
 
-    /* Load inf file from install media. */
-    if (InfHostOpenFile(&hInf, FileName, 0, &ErrorLine) != 0)
+    /* Load inf file from install media, or its parsed copy in the cache */
+    if (InfHostOpenCachedFile(&hInf, FileName, CachePath, 0, &ErrorLine) != 0)
     {
-        DPRINT1("InfHostOpenFile(%s) failed\n", FileName);
+        DPRINT1("InfHostOpenCachedFile(%s) failed\n", FileName);
         return FALSE;
     }
 
@@ -27,6 +27,6 @@
 #pragma once
 
 BOOL
-ImportRegistryFile(PCHAR Filename);
+ImportRegistryFile(PCHAR Filename, PCSTR CachePath);
 
 /* EOF */
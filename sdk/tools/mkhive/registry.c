@@ -54,6 +54,9 @@ typedef struct _MEMKEY
 static CMHIVE RootHive;
 static PMEMKEY RootKey;
 
+/* Import into the in-memory tree of bulkreg.c, laid out by RegBuildHives() */
+static BOOL BulkImport;
+
 static CMHIVE SystemHive;   /* \Registry\Machine\SYSTEM */
 static CMHIVE SoftwareHive; /* \Registry\Machine\SOFTWARE */
 static CMHIVE DefaultHive;  /* \Registry\User\.DEFAULT */
@@ -407,6 +410,9 @@ RegpCreateOrOpenKey(
 
     DPRINT("RegpCreateOrOpenKey('%S')\n", KeyName);
 
+    if (BulkImport)
+        return BulkCreateOrOpenKey(hParentKey, KeyName, AllowCreation, Volatile, Key);
+
     if (*KeyName == OBJ_NAME_PATH_SEPARATOR)
     {
         KeyName++;
@@ -514,6 +520,10 @@ RegCloseKey(
 {
     PMEMKEY Key = HKEY_TO_MEMKEY(hKey); // ParentKey
 
+    /* The bulk import keys are not per-handle objects */
+    if (BulkImport)
+        return ERROR_SUCCESS;
+
     /* Free the object */
     free(Key);
 
@@ -562,6 +572,9 @@ RegDeleteKeyW(
     PCM_KEY_NODE Parent;
     HCELL_INDEX ParentCell;
 
+    if (BulkImport)
+        return BulkDeleteKey(hKey, lpSubKey);
+
     if (lpSubKey)
     {
         rc = RegOpenKeyW(hKey, lpSubKey, &hTargetKey);
@@ -673,6 +686,9 @@ RegSetValueExW(
     ULONG DataCellSize;
     NTSTATUS Status;
 
+    if (BulkImport)
+        return BulkSetValue(hKey, lpValueName, dwType, lpData, cbData);
+
     if (dwType == REG_LINK)
     {
         PMEMKEY DestKey;
@@ -868,12 +884,16 @@ RegQueryValueExW(
     IN OUT PULONG lpcbData OPTIONAL)
 {
     PMEMKEY ParentKey = HKEY_TO_MEMKEY(hKey);
-    PHHIVE Hive = &ParentKey->RegistryHive->Hive;
+    PHHIVE Hive;
     PCM_KEY_NODE KeyNode;
     PCM_KEY_VALUE ValueCell;
     HCELL_INDEX CellIndex;
     UNICODE_STRING ValueNameString;
 
+    if (BulkImport)
+        return BulkQueryValue(hKey, lpValueName, lpType, lpData, lpcbData);
+
+    Hive = &ParentKey->RegistryHive->Hive;
     KeyNode = (PCM_KEY_NODE)HvGetCell(Hive, ParentKey->KeyCellOffset);
     if (!KeyNode)
         return ERROR_GEN_FAILURE; // STATUS_UNSUCCESSFUL;
@@ -905,13 +925,17 @@ RegDeleteValueW(
     LONG rc;
     NTSTATUS Status;
     PMEMKEY Key = HKEY_TO_MEMKEY(hKey); // ParentKey
-    PHHIVE Hive = &Key->RegistryHive->Hive;
+    PHHIVE Hive;
     PCM_KEY_NODE KeyNode; // ParentNode
     PCM_KEY_VALUE ValueCell;
     HCELL_INDEX CellIndex;
     ULONG ChildIndex;
     UNICODE_STRING ValueNameString;
 
+    if (BulkImport)
+        return BulkDeleteValue(hKey, lpValueName);
+
+    Hive = &Key->RegistryHive->Hive;
     KeyNode = (PCM_KEY_NODE)HvGetCell(Hive, Key->KeyCellOffset);
     if (!KeyNode)
         return ERROR_GEN_FAILURE; // STATUS_UNSUCCESSFUL;
@@ -1066,6 +1090,12 @@ ConnectRegistry(
         return FALSE;
     }
 
+    if (BulkImport)
+    {
+        free(ReparsePoint);
+        return BulkMountHive(MEMKEY_TO_HKEY(NewKey), HiveToConnect);
+    }
+
     ReparsePoint->SourceHive = NewKey->RegistryHive;
     ReparsePoint->SourceKeyCellOffset = NewKey->KeyCellOffset;
     NewKey->RegistryHive = HiveToConnect;
@@ -1119,6 +1149,12 @@ CreateSymLink(
     if (LinkKeyHandle)
         *LinkKeyHandle = MEMKEY_TO_HKEY(LinkKey);
 
+    if (BulkImport)
+    {
+        free(ReparsePoint);
+        return BulkCreateLink(MEMKEY_TO_HKEY(LinkKey), TargetKeyHandle);
+    }
+
     TargetKey = HKEY_TO_MEMKEY(TargetKeyHandle);
 
     ReparsePoint->SourceHive = LinkKey->RegistryHive;
@@ -1132,7 +1168,8 @@ CreateSymLink(
 
 VOID
 RegInitializeRegistry(
-    IN PCSTR HiveList)
+    IN PCSTR HiveList,
+    IN BOOL Bulk)
 {
     NTSTATUS Status;
     UINT i;
@@ -1148,6 +1185,13 @@ RegInitializeRegistry(
         return;
     }
 
+    BulkImport = Bulk;
+    if (BulkImport && !BulkInitialize(&RootHive))
+    {
+        DPRINT1("BulkInitialize() failed\n");
+        BulkImport = FALSE;
+    }
+
     RootKey = CreateInMemoryStructure(&RootHive,
                                       RootHive.Hive.BaseBlock->RootCell);
 
@@ -1189,6 +1233,16 @@ RegInitializeRegistry(
 #endif
 }
 
+BOOL
+RegBuildHives(VOID)
+{
+    /* Only the bulk import has something left to write to the hives */
+    if (!BulkImport)
+        return TRUE;
+
+    return BulkLayoutHives();
+}
+
 VOID
 RegShutdownRegistry(VOID)
 {
@@ -1205,6 +1259,9 @@ RegShutdownRegistry(VOID)
 
     /* FIXME: clean up the complete hive */
 
+    if (BulkImport)
+        BulkShutdown();
+
     free(RootKey);
 }
 
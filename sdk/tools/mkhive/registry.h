@@ -48,7 +48,11 @@ extern HIVE_LIST_ENTRY RegistryHives[];
 
 VOID
 RegInitializeRegistry(
-    IN PCSTR HiveList);
+    IN PCSTR HiveList,
+    IN BOOL Bulk);
+
+BOOL
+RegBuildHives(VOID);
 
 VOID
 RegShutdownRegistry(VOID);
@@ -27,23 +27,34 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <wchar.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 #include "rsym.h"
 
 #define MAX_PATH 260
 #define MAX_SYM_NAME 2000
 
+/*
+ * String table deduplication. The entries refer to the strings by offset,
+ * so that the strings area can be reallocated while it grows.
+ */
 struct StringEntry
 {
-    struct StringEntry *Next;
+    ULONG Next;         /* Index + 1 of the next entry in the bucket, 0 ends the chain */
+    ULONG Hash;
     ULONG Offset;
-    char *String;
 };
 
 struct StringHashTable
 {
-    ULONG TableSize;
-    struct StringEntry **Table;
+    ULONG TableSize;    /* Number of buckets, always a power of two */
+    ULONG TableBits;
+    ULONG *Table;       /* Index + 1 of the first entry of each bucket */
+    ULONG Count;
+    ULONG MaxCount;
+    struct StringEntry *Entries;
 };
 
 /* This is the famous DJB hash */
@@ -61,53 +72,101 @@ ComputeDJBHash(const char *name)
     return val;
 }
 
+/* The low bits of the DJB hash mostly depend on the last characters */
+static ULONG
+StringHashBucket(struct StringHashTable *StringTable, unsigned int hash)
+{
+    return (ULONG)((hash * 2654435761U) >> (32 - StringTable->TableBits));
+}
+
+static int
+StringHashTableResize(struct StringHashTable *StringTable, ULONG TableBits)
+{
+    ULONG *Table;
+    ULONG i, bucket;
+
+    Table = calloc((size_t)1 << TableBits, sizeof(ULONG));
+    if (!Table)
+        return 1;
+
+    free(StringTable->Table);
+    StringTable->Table = Table;
+    StringTable->TableBits = TableBits;
+    StringTable->TableSize = 1 << TableBits;
+
+    for (i = 0; i < StringTable->Count; i++)
+    {
+        bucket = StringHashBucket(StringTable, StringTable->Entries[i].Hash);
+        StringTable->Entries[i].Next = Table[bucket];
+        Table[bucket] = i + 1;
+    }
+
+    return 0;
+}
+
 static void
 AddStringToHash(struct StringHashTable *StringTable,
                 unsigned int hash,
-                ULONG Offset,
-                char *StringPtr)
+                ULONG Offset)
 {
-    struct StringEntry *entry = calloc(1, sizeof(struct StringEntry));
+    struct StringEntry *entry;
+    ULONG bucket;
+
+    if (StringTable->Count == StringTable->MaxCount)
+    {
+        ULONG MaxCount = StringTable->MaxCount ? StringTable->MaxCount * 2 : 1024;
+
+        entry = realloc(StringTable->Entries, MaxCount * sizeof(struct StringEntry));
+        if (!entry)
+        {
+            /* Not fatal: the string just won't be shared */
+            return;
+        }
+        StringTable->Entries = entry;
+        StringTable->MaxCount = MaxCount;
+    }
+
+    /* Keep the chains short. If growing fails, the old table still works. */
+    if (StringTable->Count >= 2 * StringTable->TableSize)
+        StringHashTableResize(StringTable, StringTable->TableBits + 1);
+
+    bucket = StringHashBucket(StringTable, hash);
+    entry = &StringTable->Entries[StringTable->Count];
+    entry->Hash = hash;
     entry->Offset = Offset;
-    entry->String = StringPtr;
-    entry->Next = StringTable->Table[hash];
-    StringTable->Table[hash] = entry;
+    entry->Next = StringTable->Table[bucket];
+    StringTable->Table[bucket] = ++StringTable->Count;
 }
 
-static void
+static int
 StringHashTableInit(struct StringHashTable *StringTable,
                     ULONG StringsLength,
                     char *StringsBase)
 {
     char *Start = StringsBase;
     char *End = StringsBase + StringsLength;
-    StringTable->TableSize = 1024;
-    StringTable->Table = calloc(1024, sizeof(struct StringEntry *));
+
+    memset(StringTable, 0, sizeof(*StringTable));
+    if (StringHashTableResize(StringTable, 10))
+        return 1;
+
     while (Start < End)
     {
         AddStringToHash(StringTable,
-                        ComputeDJBHash(Start) % StringTable->TableSize,
-                        Start - StringsBase,
-                        Start);
+                        ComputeDJBHash(Start),
+                        Start - StringsBase);
         Start += strlen(Start) + 1;
     }
+
+    return 0;
 }
 
 static void
 StringHashTableFree(struct StringHashTable *StringTable)
 {
-    int i;
-    struct StringEntry *entry;
-    for (i = 0; i < StringTable->TableSize; i++)
-    {
-        while ((entry = StringTable->Table[i]))
-        {
-            entry = entry->Next;
-            free(StringTable->Table[i]);
-            StringTable->Table[i] = entry;
-        }
-    }
+    free(StringTable->Entries);
     free(StringTable->Table);
+    memset(StringTable, 0, sizeof(*StringTable));
 }
 
 static int
@@ -198,33 +257,34 @@ GetCoffInfo(void *FileData, PIMAGE_FILE_HEADER PEFileHeader,
     return 0;
 }
 
+/* The strings area must have room for StringToFind */
 static ULONG
 FindOrAddString(struct StringHashTable *StringTable,
-                char *StringToFind,
+                const char *StringToFind,
                 ULONG *StringsLength,
                 void *StringsBase)
 {
-    unsigned int hash = ComputeDJBHash(StringToFind) % StringTable->TableSize;
-    struct StringEntry *entry = StringTable->Table[hash];
-
-    while (entry && strcmp(entry->String, StringToFind))
-        entry = entry->Next;
+    unsigned int hash = ComputeDJBHash(StringToFind);
+    ULONG index = StringTable->Table[StringHashBucket(StringTable, hash)];
+    struct StringEntry *entry;
+    char *End;
 
-    if (entry)
+    while (index)
     {
-        return entry->Offset;
+        entry = &StringTable->Entries[index - 1];
+        if (entry->Hash == hash && !strcmp((char *)StringsBase + entry->Offset, StringToFind))
+            return entry->Offset;
+        index = entry->Next;
     }
-    else
-    {
-        char *End = (char *)StringsBase + *StringsLength;
 
-        strcpy(End, StringToFind);
-        *StringsLength += strlen(StringToFind) + 1;
+    End = (char *)StringsBase + *StringsLength;
 
-        AddStringToHash(StringTable, hash, End - (char *)StringsBase, End);
+    strcpy(End, StringToFind);
+    *StringsLength += strlen(StringToFind) + 1;
 
-        return End - (char *)StringsBase;
-    }
+    AddStringToHash(StringTable, hash, End - (char *)StringsBase);
+
+    return End - (char *)StringsBase;
 }
 
 static int
@@ -265,7 +325,12 @@ ConvertStabs(ULONG *SymbolsCount, PROSSYM_ENTRY *SymbolsBase,
     Current = *SymbolsBase;
     memset(Current, 0, sizeof(*Current));
 
-    StringHashTableInit(&StringHash, *StringsLength, (char *)StringsBase);
+    if (StringHashTableInit(&StringHash, *StringsLength, (char *)StringsBase))
+    {
+        free(*SymbolsBase);
+        fprintf(stderr, "Failed to allocate memory for the strings hash table\n");
+        return 1;
+    }
 
     LastFunctionAddress = 0;
     for (i = 0; i < Count; i++)
@@ -328,6 +393,7 @@ ConvertStabs(ULONG *SymbolsCount, PROSSYM_ENTRY *SymbolsBase,
                 {
                     free(*SymbolsBase);
                     fprintf(stderr, "Function name too long\n");
+                    StringHashTableFree(&StringHash);
                     return 1;
                 }
                 memcpy(FuncName, Name, NameLen);
@@ -385,7 +451,8 @@ ConvertCoffs(ULONG *SymbolsCount, PROSSYM_ENTRY *SymbolsBase,
     CoffEntry = (PCOFF_SYMENT) CoffSymbolsBase;
     Count = CoffSymbolsLength / sizeof(COFF_SYMENT);
 
-    *SymbolsBase = malloc(Count * sizeof(ROSSYM_ENTRY));
+    /* One more for the empty entry that ends the list */
+    *SymbolsBase = malloc((Count + 1) * sizeof(ROSSYM_ENTRY));
     if (*SymbolsBase == NULL)
     {
         fprintf(stderr, "Unable to allocate memory for converted COFF symbols\n");
@@ -393,8 +460,14 @@ ConvertCoffs(ULONG *SymbolsCount, PROSSYM_ENTRY *SymbolsBase,
     }
     *SymbolsCount = 0;
     Current = *SymbolsBase;
+    memset(Current, 0, sizeof(*Current));
 
-    StringHashTableInit(&StringHash, *StringsLength, (char*)StringsBase);
+    if (StringHashTableInit(&StringHash, *StringsLength, (char*)StringsBase))
+    {
+        free(*SymbolsBase);
+        fprintf(stderr, "Failed to allocate memory for the strings hash table\n");
+        return 1;
+    }
 
     for (i = 0; i < Count; i++)
     {
@@ -410,6 +483,7 @@ ConvertCoffs(ULONG *SymbolsCount, PROSSYM_ENTRY *SymbolsBase,
                             "Invalid section number %d in COFF symbols (only %d sections present)\n",
                             CoffEntry[i].e_scnum,
                             PEFileHeader->NumberOfSections);
+                    StringHashTableFree(&StringHash);
                     return 1;
                 }
                 Current->Address += PESectionHeaders[CoffEntry[i].e_scnum - 1].VirtualAddress;
@@ -466,15 +540,19 @@ struct DbgHelpLineEntry {
 };
 
 struct DbgHelpStringTab {
-  ULONG Length;
-  ULONG Bytes;
-  char ***Table;
+  struct StringHashTable Hash;
+  char *Strings;
+  ULONG Bytes, MaxBytes;
   ULONG LineEntries, CurLineEntries;
   struct DbgHelpLineEntry *LineEntryData;
   void *process;
   DWORD module_base;
   char *PathChop;
   char *SourcePath;
+  PSYMBOL_INFO Symbol;
+  DWORD64 FunctionStart, FunctionEnd;
+  int functionId;
+  int Failed;
   struct DbgHelpLineEntry *lastLineEntry;
 };
 
@@ -498,141 +576,149 @@ DbgHelpAddLineEntry(struct DbgHelpStringTab *tab)
     return &tab->LineEntryData[tab->CurLineEntries++];
 }
 
+/* Returns the offset of the string in the string section, or -1 */
 static int
-DbgHelpAddStringToTable(struct DbgHelpStringTab *tab, char *name)
+DbgHelpAddStringToTable(struct DbgHelpStringTab *tab, const char *name)
 {
-    unsigned int bucket = ComputeDJBHash(name) % tab->Length;
-    char **tabEnt = tab->Table[bucket];
-    int i;
-    char **newBucket;
+    ULONG Length = strlen(name) + 1;
+    ULONG MaxBytes;
+    char *newStrings;
 
-    if (tabEnt)
+    /* FindOrAddString() appends new strings in place */
+    if (tab->Bytes + Length > tab->MaxBytes)
     {
-        for (i = 0; tabEnt[i] && strcmp(tabEnt[i], name); i++);
-        if (tabEnt[i])
+        MaxBytes = max(tab->MaxBytes * 2, tab->Bytes + Length);
+        newStrings = realloc(tab->Strings, MaxBytes);
+
+        if (!newStrings)
         {
-            free(name);
-            return (i << 10) | bucket;
+            fprintf(stderr, "realloc failed!\n");
+            return -1;
         }
-    }
-    else
-        i = 0;
 
-    /* At this point, we need to insert */
-    tab->Bytes += strlen(name) + 1;
-
-    newBucket = realloc(tab->Table[bucket], (i+2) * sizeof(char *));
-
-    if (!newBucket)
-    {
-        fprintf(stderr, "realloc failed!\n");
-        return -1;
+        tab->Strings = newStrings;
+        tab->MaxBytes = MaxBytes;
     }
 
-    tab->Table[bucket] = newBucket;
-    tab->Table[bucket][i+1] = 0;
-    tab->Table[bucket][i] = name;
-    return (i << 10) | bucket;
+    return FindOrAddString(&tab->Hash, name, &tab->Bytes, tab->Strings);
 }
 
 const char*
 DbgHelpGetString(struct DbgHelpStringTab *tab, int id)
 {
-    int i = id >> 10;
-    int bucket = id & 0x3ff;
-    return tab->Table[bucket][i];
+    return tab->Strings + id;
 }
 
-/* Remove a prefix of PathChop if it exists and return a copy of the tail. */
-static char *
-StrDupShortenPath(char *PathChop, char *FilePath)
+/* Remove a prefix of PathChop if it exists and return the tail. */
+static const char *
+ShortenPath(const char *PathChop, const char *FilePath)
 {
-    int pclen = strlen(PathChop);
-    if (!strncmp(FilePath, PathChop, pclen))
+    int pclen = PathChop ? strlen(PathChop) : 0;
+    if (pclen && !strncmp(FilePath, PathChop, pclen))
     {
-        return strdup(FilePath+pclen);
+        return FilePath + pclen;
     }
     else
     {
-        return strdup(FilePath);
+        return FilePath;
     }
 }
 
-static BOOL
-DbgHelpAddLineNumber(PSRCCODEINFO LineInfo, void *UserContext)
+/* If any file can be opened by relative path up to a certain level, then
+   record that path. */
+static void
+DbgHelpFindPathChop(struct DbgHelpStringTab *tab, const char *FileName)
 {
-    struct DbgHelpStringTab *tab = (struct DbgHelpStringTab *)UserContext;
-    DWORD64 disp;
-    int fileId, functionId;
-    PSYMBOL_INFO pSymbol = malloc(FIELD_OFFSET(SYMBOL_INFO, Name[MAX_SYM_NAME]));
-    if (!pSymbol) return FALSE;
-    memset(pSymbol, 0, FIELD_OFFSET(SYMBOL_INFO, Name[MAX_SYM_NAME]));
+    int i;
+    char *end = strrchr(FileName, '/');
 
-    /* If any file can be opened by relative path up to a certain level, then
-       record that path. */
-    if (!tab->PathChop)
-    {
-        int i, endLen;
-        char *end = strrchr(LineInfo->FileName, '/');
+    if (!end)
+        end = strrchr(FileName, '\\');
 
-        if (!end)
-            end = strrchr(LineInfo->FileName, '\\');
+    if (!end)
+        return;
 
-        if (end)
+    for (i = (end - FileName) - 1; i >= 0; i--)
+    {
+        if (FileName[i] == '/' || FileName[i] == '\\')
         {
-            for (i = (end - LineInfo->FileName) - 1; i >= 0; i--)
+            char *synthname = malloc(strlen(tab->SourcePath) +
+                                     strlen(FileName + i + 1)
+                                     + 2);
+            strcpy(synthname, tab->SourcePath);
+            strcat(synthname, "/");
+            strcat(synthname, FileName + i + 1);
+            FILE *f = fopen(synthname, "r");
+            free(synthname);
+            if (f)
             {
-                if (LineInfo->FileName[i] == '/' || LineInfo->FileName[i] == '\\')
-                {
-                    char *synthname = malloc(strlen(tab->SourcePath) +
-                                             strlen(LineInfo->FileName + i + 1)
-                                             + 2);
-                    strcpy(synthname, tab->SourcePath);
-                    strcat(synthname, "/");
-                    strcat(synthname, LineInfo->FileName + i + 1);
-                    FILE *f = fopen(synthname, "r");
-                    free(synthname);
-                    if (f)
-                    {
-                        fclose(f);
-                        break;
-                    }
-                }
+                fclose(f);
+                break;
             }
-
-            i++; /* Be in the string or past the next slash */
-            tab->PathChop = malloc(i + 1);
-            memcpy(tab->PathChop, LineInfo->FileName, i);
-            tab->PathChop[i] = 0;
         }
     }
 
-    fileId = DbgHelpAddStringToTable(tab,
-                                     StrDupShortenPath(tab->PathChop,
-                                                       LineInfo->FileName));
+    i++; /* Be in the string or past the next slash */
 
-    pSymbol->SizeOfStruct = sizeof(SYMBOL_INFO);
-    pSymbol->MaxNameLen = MAX_SYM_NAME;
+    tab->PathChop = malloc(i + 1);
+    memcpy(tab->PathChop, FileName, i);
+    tab->PathChop[i] = 0;
+}
+
+static BOOL
+DbgHelpAddLineNumber(PSRCCODEINFO LineInfo, void *UserContext)
+{
+    struct DbgHelpStringTab *tab = (struct DbgHelpStringTab *)UserContext;
+    DWORD64 disp;
+    int fileId;
+
+    if (!tab->PathChop)
+        DbgHelpFindPathChop(tab, LineInfo->FileName);
 
-    if (!SymFromAddr(tab->process, LineInfo->Address, &disp, pSymbol))
+    fileId = DbgHelpAddStringToTable(tab,
+                                     ShortenPath(tab->PathChop,
+                                                 LineInfo->FileName));
+    if (fileId < 0)
     {
-        //fprintf(stderr, "SymFromAddr failed.\n");
-        free(pSymbol);
+        tab->Failed = 1;
         return FALSE;
     }
 
-    functionId = DbgHelpAddStringToTable(tab, strdup(pSymbol->Name));
+    /* The lines come function by function: only look up the
+       function again when the address leaves the previous one */
+    if (LineInfo->Address < tab->FunctionStart || LineInfo->Address >= tab->FunctionEnd)
+    {
+        if (!SymFromAddr(tab->process, LineInfo->Address, &disp, tab->Symbol))
+        {
+            //fprintf(stderr, "SymFromAddr failed.\n");
+            return FALSE;
+        }
+
+        tab->functionId = DbgHelpAddStringToTable(tab, tab->Symbol->Name);
+        if (tab->functionId < 0)
+        {
+            tab->Failed = 1;
+            return FALSE;
+        }
+
+        tab->FunctionStart = tab->Symbol->Address;
+        tab->FunctionEnd = tab->Symbol->Address + tab->Symbol->Size;
+    }
 
     if (LineInfo->Address == 0)
         fprintf(stderr, "Address is 0.\n");
 
     tab->lastLineEntry = DbgHelpAddLineEntry(tab);
+    if (!tab->lastLineEntry)
+    {
+        tab->Failed = 1;
+        return FALSE;
+    }
     tab->lastLineEntry->vma = LineInfo->Address - LineInfo->ModBase;
-    tab->lastLineEntry->functionId = functionId;
+    tab->lastLineEntry->functionId = tab->functionId;
     tab->lastLineEntry->fileId = fileId;
     tab->lastLineEntry->line = LineInfo->LineNumber;
 
-    free(pSymbol);
     return TRUE;
 }
 
@@ -641,75 +727,80 @@ ConvertDbgHelp(void *process, DWORD module_base, char *SourcePath,
                ULONG *SymbolsCount, PROSSYM_ENTRY *SymbolsBase,
                ULONG *StringsLength, void **StringsBase)
 {
-    char *strings, *strings_copy;
-    int i, j, bucket, entry;
+    ULONG i;
     PROSSYM_ENTRY rossym;
     struct DbgHelpStringTab strtab = { 0 };
 
     strtab.process = process;
     strtab.module_base = module_base;
-    strtab.Bytes = 1;
-    strtab.Length = 1024;
-    strtab.Table = calloc(1024, sizeof(const char **));
-    strtab.Table[0] = calloc(2, sizeof(const char *));
-    strtab.Table[0][0] = strdup(""); // The zero string
+    strtab.MaxBytes = 65536;
+    strtab.Strings = malloc(strtab.MaxBytes);
     strtab.CurLineEntries = 0;
     strtab.LineEntries = 16384;
     strtab.LineEntryData = calloc(strtab.LineEntries, sizeof(struct DbgHelpLineEntry));
+    strtab.Symbol = calloc(1, FIELD_OFFSET(SYMBOL_INFO, Name[MAX_SYM_NAME]));
     strtab.PathChop = NULL;
     strtab.SourcePath = SourcePath ? SourcePath : "";
 
-    SymEnumLines(process, module_base, NULL, NULL, DbgHelpAddLineNumber, &strtab);
+    if (!strtab.Strings || !strtab.LineEntryData || !strtab.Symbol)
+    {
+        fprintf(stderr, "Failed to allocate memory for converted dbghelp symbols\n");
+        goto Failure;
+    }
 
-    /* Transcribe necessary strings */
-    *StringsLength = strtab.Bytes;
-    strings = strings_copy = ((char *)(*StringsBase = malloc(strtab.Bytes)));
+    strtab.Symbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+    strtab.Symbol->MaxNameLen = MAX_SYM_NAME;
 
-    /* Copy in strings */
-    for (i = 0; i < strtab.Length; i++)
+    /* The zero string */
+    strtab.Strings[0] = '\0';
+    strtab.Bytes = 1;
+    if (StringHashTableInit(&strtab.Hash, strtab.Bytes, strtab.Strings))
     {
-        for (j = 0; strtab.Table[i] && strtab.Table[i][j]; j++)
-        {
-            /* Each entry is replaced by its corresponding entry in our string
-               section. We can substract the strings origin to get an offset. */
-            char *toFree = strtab.Table[i][j];
-            strtab.Table[i][j] = strcpy(strings_copy, strtab.Table[i][j]);
-            free(toFree);
-            strings_copy += strlen(strings_copy) + 1;
-        }
+        fprintf(stderr, "Failed to allocate memory for converted dbghelp symbols\n");
+        goto Failure;
     }
 
-    assert(strings_copy == strings + strtab.Bytes);
+    SymEnumLines(process, module_base, NULL, NULL, DbgHelpAddLineNumber, &strtab);
+    if (strtab.Failed)
+        goto Failure;
 
-    *SymbolsBase = calloc(strtab.CurLineEntries, sizeof(ROSSYM_ENTRY));
+    *SymbolsBase = calloc(strtab.CurLineEntries + 1, sizeof(ROSSYM_ENTRY));
+    if (!*SymbolsBase)
+    {
+        fprintf(stderr, "Failed to allocate memory for converted dbghelp symbols\n");
+        goto Failure;
+    }
     *SymbolsCount = strtab.CurLineEntries;
 
-    /* Copy symbols into rossym entries */
+    /* Copy symbols into rossym entries, the ids are offsets in our string section */
     for (i = 0; i < strtab.CurLineEntries; i++)
     {
         rossym = &(*SymbolsBase)[i];
         rossym->Address = strtab.LineEntryData[i].vma;
-        bucket = strtab.LineEntryData[i].fileId & 0x3ff;
-        entry = strtab.LineEntryData[i].fileId >> 10;
-        rossym->FileOffset = strtab.Table[bucket][entry] - strings;
-        bucket = strtab.LineEntryData[i].functionId & 0x3ff;
-        entry = strtab.LineEntryData[i].functionId >> 10;
-        rossym->FunctionOffset = strtab.Table[bucket][entry] - strings;
+        rossym->FileOffset = strtab.LineEntryData[i].fileId;
+        rossym->FunctionOffset = strtab.LineEntryData[i].functionId;
         rossym->SourceLine = strtab.LineEntryData[i].line;
     }
 
-    /* Free stringtab */
-    for (i = 0; i < strtab.Length; i++)
-    {
-        free(strtab.Table[i]);
-    }
+    *StringsLength = strtab.Bytes;
+    *StringsBase = strtab.Strings;
 
+    StringHashTableFree(&strtab.Hash);
     free(strtab.LineEntryData);
     free(strtab.PathChop);
+    free(strtab.Symbol);
 
     qsort(*SymbolsBase, *SymbolsCount, sizeof(ROSSYM_ENTRY), (int (*)(const void *, const void *))CompareSymEntry);
 
     return 0;
+
+Failure:
+    StringHashTableFree(&strtab.Hash);
+    free(strtab.Strings);
+    free(strtab.LineEntryData);
+    free(strtab.PathChop);
+    free(strtab.Symbol);
+    return 1;
 }
 
 static int
@@ -718,7 +809,7 @@ MergeStabsAndCoffs(ULONG *MergedSymbolCount, PROSSYM_ENTRY *MergedSymbols,
                    ULONG CoffSymbolsCount, PROSSYM_ENTRY CoffSymbols)
 {
     ULONG StabIndex, j;
-    ULONG CoffIndex;
+    ULONG CoffIndex, LeftoverCount;
     ULONG_PTR StabFunctionStartAddress;
     ULONG StabFunctionStringOffset, NewStabFunctionStringOffset, CoffFunctionStringOffset;
     PROSSYM_ENTRY CoffFunctionSymbol;
@@ -789,17 +880,33 @@ MergeStabsAndCoffs(ULONG *MergedSymbolCount, PROSSYM_ENTRY *MergedSymbols,
         (*MergedSymbolCount)++;
     }
     /* Handle functions that have no analog in the upstream data */
+    LeftoverCount = 0;
     for (CoffIndex = 0; CoffIndex < CoffSymbolsCount; CoffIndex++)
     {
         if (CoffSymbols[CoffIndex].Address &&
             CoffSymbols[CoffIndex].FunctionOffset)
         {
-            (*MergedSymbols)[*MergedSymbolCount] = CoffSymbols[CoffIndex];
-            (*MergedSymbolCount)++;
+            CoffSymbols[LeftoverCount++] = CoffSymbols[CoffIndex];
         }
     }
 
-    qsort(*MergedSymbols, *MergedSymbolCount, sizeof(ROSSYM_ENTRY), (int (*)(const void *, const void *)) CompareSymEntry);
+    /* Both lists are sorted: merge them from the end, the COFF symbols
+       going after the stabs ones at the same address */
+    StabIndex = *MergedSymbolCount;
+    CoffIndex = LeftoverCount;
+    *MergedSymbolCount += LeftoverCount;
+    for (j = *MergedSymbolCount; CoffIndex > 0; j--)
+    {
+        if (StabIndex > 0 &&
+            CompareSymEntry(&(*MergedSymbols)[StabIndex - 1], &CoffSymbols[CoffIndex - 1]) > 0)
+        {
+            (*MergedSymbols)[j - 1] = (*MergedSymbols)[--StabIndex];
+        }
+        else
+        {
+            (*MergedSymbols)[j - 1] = CoffSymbols[--CoffIndex];
+        }
+    }
 
     return 0;
 }
@@ -1227,6 +1334,142 @@ CreateOutputFile(FILE *OutFile, void *InData,
     return 0;
 }
 
+/* ConvertCoffs() on its own strings, possibly on a second thread */
+struct CoffConversion
+{
+    ULONG CoffSymbolsLength;
+    void *CoffSymbolsBase;
+    ULONG CoffStringsLength;
+    void *CoffStringsBase;
+    ULONG_PTR ImageBase;
+    PIMAGE_FILE_HEADER PEFileHeader;
+    PIMAGE_SECTION_HEADER PESectionHeaders;
+
+    ULONG SymbolsCount;
+    PROSSYM_ENTRY Symbols;
+    ULONG StringsLength;
+    char *Strings;
+    int Result;
+#ifdef HAVE_PTHREAD
+    pthread_t Thread;
+    int Started;
+#endif
+};
+
+static void *
+CoffConversionThread(void *Context)
+{
+    struct CoffConversion *Conversion = Context;
+
+    Conversion->Strings = malloc(1 + Conversion->CoffStringsLength +
+                                 (Conversion->CoffSymbolsLength / sizeof(COFF_SYMENT)) * (E_SYMNMLEN + 1));
+    if (Conversion->Strings == NULL)
+    {
+        fprintf(stderr, "Failed to allocate memory for COFF strings table\n");
+        Conversion->Result = 1;
+        return NULL;
+    }
+    /* Make offset 0 into an empty string */
+    Conversion->Strings[0] = '\0';
+    Conversion->StringsLength = 1;
+
+    Conversion->Result = ConvertCoffs(&Conversion->SymbolsCount,
+                                      &Conversion->Symbols,
+                                      &Conversion->StringsLength,
+                                      Conversion->Strings,
+                                      Conversion->CoffSymbolsLength,
+                                      Conversion->CoffSymbolsBase,
+                                      Conversion->CoffStringsLength,
+                                      Conversion->CoffStringsBase,
+                                      Conversion->ImageBase,
+                                      Conversion->PEFileHeader,
+                                      Conversion->PESectionHeaders);
+    if (Conversion->Result)
+        Conversion->Symbols = NULL;
+    return NULL;
+}
+
+static void
+StartCoffConversion(struct CoffConversion *Conversion)
+{
+#ifdef HAVE_PTHREAD
+    Conversion->Started = !pthread_create(&Conversion->Thread, NULL,
+                                          CoffConversionThread, Conversion);
+    if (Conversion->Started)
+        return;
+#endif
+    CoffConversionThread(Conversion);
+}
+
+static int
+FinishCoffConversion(struct CoffConversion *Conversion)
+{
+#ifdef HAVE_PTHREAD
+    if (Conversion->Started)
+    {
+        pthread_join(Conversion->Thread, NULL);
+        Conversion->Started = 0;
+    }
+#endif
+    if (Conversion->Result)
+    {
+        free(Conversion->Strings);
+        Conversion->Strings = NULL;
+    }
+    return Conversion->Result;
+}
+
+/*
+ * Moves the strings of the converted COFF symbols to the end of the module
+ * strings, in the order ConvertCoffs() added them, and updates the symbols.
+ */
+static int
+AppendCoffStrings(struct CoffConversion *Conversion,
+                  ULONG *StringsLength, void **StringsBase)
+{
+    struct StringHashTable StringHash;
+    ULONG *NewOffsets;
+    void *NewStrings;
+    char *Start, *End;
+    ULONG i;
+
+    NewStrings = realloc(*StringsBase, *StringsLength + Conversion->StringsLength);
+    NewOffsets = malloc(Conversion->StringsLength * sizeof(ULONG));
+    if (NewStrings)
+        *StringsBase = NewStrings;
+    if (!NewStrings || !NewOffsets ||
+        StringHashTableInit(&StringHash, *StringsLength, *StringsBase))
+    {
+        fprintf(stderr, "Failed to allocate memory for strings table\n");
+        free(NewOffsets);
+        free(Conversion->Symbols);
+        free(Conversion->Strings);
+        return 1;
+    }
+
+    Start = Conversion->Strings;
+    End = Conversion->Strings + Conversion->StringsLength;
+    while (Start < End)
+    {
+        NewOffsets[Start - Conversion->Strings] = FindOrAddString(&StringHash,
+                                                                  Start,
+                                                                  StringsLength,
+                                                                  *StringsBase);
+        Start += strlen(Start) + 1;
+    }
+
+    for (i = 0; i < Conversion->SymbolsCount; i++)
+    {
+        Conversion->Symbols[i].FunctionOffset = NewOffsets[Conversion->Symbols[i].FunctionOffset];
+    }
+
+    StringHashTableFree(&StringHash);
+    free(NewOffsets);
+    free(Conversion->Strings);
+    Conversion->Strings = NULL;
+    return 0;
+}
+
 int main(int argc, char* argv[])
 {
     PSYMBOLFILE_HEADER SymbolFileHeader;
@@ -1261,9 +1504,9 @@ int main(int argc, char* argv[])
     DWORD module_base;
     void *file;
     char elfhdr[4] = { '\177', 'E', 'L', 'F' };
-    BOOLEAN UseDbgHelp = FALSE;
     int arg, argstate = 0;
     char *SourcePath = NULL;
+    struct CoffConversion CoffConversion;
 
     for (arg = 1; arg < argc; arg++)
     {
@@ -1350,6 +1593,29 @@ int main(int argc, char* argv[])
         exit(1);
     }
 
+    if (GetCoffInfo(FileData,
+                    PEFileHeader,
+                    PESectionHeaders,
+                    &CoffsLength,
+                    &CoffBase,
+                    &CoffStringsLength,
+                    &CoffStringBase))
+    {
+        free(FileData);
+        exit(1);
+    }
+
+    /* Convert the COFF symbols while we convert the stabs or the DWARF info */
+    memset(&CoffConversion, 0, sizeof(CoffConversion));
+    CoffConversion.CoffSymbolsLength = CoffsLength;
+    CoffConversion.CoffSymbolsBase = CoffBase;
+    CoffConversion.CoffStringsLength = CoffStringsLength;
+    CoffConversion.CoffStringsBase = CoffStringBase;
+    CoffConversion.ImageBase = ImageBase;
+    CoffConversion.PEFileHeader = PEFileHeader;
+    CoffConversion.PESectionHeaders = PESectionHeaders;
+    StartCoffConversion(&CoffConversion);
+
     if (StabsLength == 0)
     {
         // SYMOPT_AUTO_PUBLICS
@@ -1369,33 +1635,21 @@ int main(int argc, char* argv[])
                            &StringsLength,
                            &StringBase))
         {
+            FinishCoffConversion(&CoffConversion);
             free(FileData);
             exit(1);
         }
 
-        UseDbgHelp = TRUE;
         SymUnloadModule(FileData, module_base);
         SymCleanup(FileData);
     }
-
-    if (GetCoffInfo(FileData,
-                    PEFileHeader,
-                    PESectionHeaders,
-                    &CoffsLength,
-                    &CoffBase,
-                    &CoffStringsLength,
-                    &CoffStringBase))
-    {
-        free(FileData);
-        exit(1);
-    }
-
-    if (!UseDbgHelp)
+    else
     {
-        StringBase = malloc(1 + StringsLength + CoffStringsLength +
-                            (CoffsLength / sizeof(ROSSYM_ENTRY)) * (E_SYMNMLEN + 1));
+        /* Every string comes from .stabstr, possibly cut at the ':' */
+        StringBase = malloc(1 + 2 * StabStringsLength);
         if (StringBase == NULL)
         {
+            FinishCoffConversion(&CoffConversion);
             free(FileData);
             fprintf(stderr, "Failed to allocate memory for strings table\n");
             exit(1);
@@ -1416,34 +1670,16 @@ int main(int argc, char* argv[])
                          PEFileHeader,
                          PESectionHeaders))
         {
+            FinishCoffConversion(&CoffConversion);
             free(StringBase);
             free(FileData);
             fprintf(stderr, "Failed to allocate memory for strings table\n");
             exit(1);
         }
     }
-    else
-    {
-        StringBase = realloc(StringBase, StringsLength + CoffStringsLength);
-        if (!StringBase)
-        {
-            free(FileData);
-            fprintf(stderr, "Failed to allocate memory for strings table\n");
-            exit(1);
-        }
-    }
 
-    if (ConvertCoffs(&CoffSymbolsCount,
-                     &CoffSymbols,
-                     &StringsLength,
-                     StringBase,
-                     CoffsLength,
-                     CoffBase,
-                     CoffStringsLength,
-                     CoffStringBase,
-                     ImageBase,
-                     PEFileHeader,
-                     PESectionHeaders))
+    if (FinishCoffConversion(&CoffConversion) ||
+        AppendCoffStrings(&CoffConversion, &StringsLength, &StringBase))
     {
         if (StabSymbols)
         {
@@ -1453,6 +1689,8 @@ int main(int argc, char* argv[])
         free(FileData);
         exit(1);
     }
+    CoffSymbolsCount = CoffConversion.SymbolsCount;
+    CoffSymbols = CoffConversion.Symbols;
 
     if (MergeStabsAndCoffs(&MergedSymbolsCount,
                            &MergedSymbols,
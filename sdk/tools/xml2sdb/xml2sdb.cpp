@@ -586,6 +586,66 @@ bool Exe::toSdb(PDB pdb, Database& db)
  *   Database
  */
 
+#include <pshpack1.h>
+struct IndexEntry
+{
+    QWORD Key;
+    TAGID Tagid;
+};
+#include <poppack.h>
+
+C_ASSERT(sizeof(IndexEntry) == 12);
+
+static bool IndexEntryLess(const IndexEntry& lhs, const IndexEntry& rhs)
+{
+    if (lhs.Key != rhs.Key)
+        return lhs.Key < rhs.Key;
+    return lhs.Tagid < rhs.Tagid;
+}
+
+/* Same packing as SdbMakeIndexKeyFromString, with ASCII-only case folding */
+static QWORD MakeIndexKey(const std::string& name)
+{
+    QWORD result = 0;
+    int shift = 56;
+
+    for (std::string::const_iterator it = name.begin(); it != name.end() && shift >= 0; ++it)
+    {
+        WCHAR c = (BYTE)*it;
+        if (c >= 'a' && c <= 'z')
+            c -= 'a' - 'A';
+        if (c)
+        {
+            result |= ((QWORD)c) << shift;
+            shift -= 8;
+        }
+    }
+    return result;
+}
+
+template<typename T>
+static void WriteIndex(PDB pdb, TAG tag, const std::list<T>& items)
+{
+    std::vector<IndexEntry> entries;
+    for (typename std::list<T>::const_iterator it = items.begin(); it != items.end(); ++it)
+    {
+        IndexEntry entry;
+        entry.Key = MakeIndexKey(it->Name);
+        entry.Tagid = it->Tagid;
+        entries.push_back(entry);
+    }
+    std::sort(entries.begin(), entries.end(), IndexEntryLess);
+
+    TAGID tidIndex = SdbBeginWriteListTag(pdb, TAG_INDEX);
+    SdbWriteWORDTag(pdb, TAG_INDEX_TAG, tag);
+    SdbWriteWORDTag(pdb, TAG_INDEX_KEY, TAG_NAME);
+    SdbWriteDWORDTag(pdb, TAG_INDEX_FLAGS, 0);
+    SdbWriteBinaryTag(pdb, TAG_INDEX_BITS, (const BYTE*)(entries.empty() ? NULL : &entries[0]),
+                      (DWORD)(entries.size() * sizeof(IndexEntry)));
+    SdbEndWriteListTag(pdb, tidIndex);
+}
+
+
 void Database::WriteBinary(PDB pdb, TAG tag, const GUID& guid, bool always)
 {
     if (always || !IsEmptyGuid(guid))
@@ -704,6 +764,14 @@ bool Database::toSdb(LPCWSTR path)
         return false;
     EndWriteListTag(pdb, tidDatabase);
 
+    /* Name indexes for apphelp. They are written after the database (unlike the Windows
+       compiler), so the TAGIDs are known up front and do not shift when indexes are added. */
+    TAGID tidIndexes = BeginWriteListTag(pdb, TAG_INDEXES);
+    WriteIndex(pdb, TAG_EXE, Exes);
+    WriteIndex(pdb, TAG_LAYER, Layers);
+    WriteIndex(pdb, TAG_SHIM, Library.Shims);
+    EndWriteListTag(pdb, tidIndexes);
+
     SdbCloseDatabaseWrite(pdb);
     return true;
 }
@@ -405,6 +405,9 @@ static BOOL AttachToConsoleInternal(PCOORD Resolution)
         Address += ScanlineSize;
     }
 
+    /* Render the whole screen from the new contents */
+    FullUpdate = TRUE;
+
 #ifdef USE_REAL_REGISTERCONSOLEVDM
     if (CharBuff) RtlFreeHeap(RtlGetProcessHeap(), 0, CharBuff);
 #endif
@@ -81,6 +81,7 @@ getIntelRegistersPointer(VOID)
         IntelRegPtr.Ebp     = EmulatorContext.GeneralRegs[FAST486_REG_EBP].Long;
         IntelRegPtr.Eip     = EmulatorContext.InstPtr.Long;
         IntelRegPtr.SegCs   = EmulatorContext.SegmentRegs[FAST486_REG_CS].Selector;
+        Fast486UpdateFlags(&EmulatorContext);
         IntelRegPtr.EFlags  = EmulatorContext.Flags.Long;
         IntelRegPtr.Esp     = EmulatorContext.GeneralRegs[FAST486_REG_ESP].Long;
         IntelRegPtr.SegSs   = EmulatorContext.SegmentRegs[FAST486_REG_SS].Selector;
@@ -565,6 +566,7 @@ ULONG
 WINAPI
 getCF(VOID)
 {
+    Fast486UpdateFlags(&EmulatorContext);
     return EmulatorContext.Flags.Cf;
 }
 
@@ -572,6 +574,7 @@ VOID
 WINAPI
 setCF(ULONG Flag)
 {
+    Fast486UpdateFlags(&EmulatorContext);
     EmulatorContext.Flags.Cf = !!(Flag & 1);
 }
 
@@ -579,6 +582,7 @@ ULONG
 WINAPI
 getPF(VOID)
 {
+    Fast486UpdateFlags(&EmulatorContext);
     return EmulatorContext.Flags.Pf;
 }
 
@@ -586,6 +590,7 @@ VOID
 WINAPI
 setPF(ULONG Flag)
 {
+    Fast486UpdateFlags(&EmulatorContext);
     EmulatorContext.Flags.Pf = !!(Flag & 1);
 }
 
@@ -593,6 +598,7 @@ ULONG
 WINAPI
 getAF(VOID)
 {
+    Fast486UpdateFlags(&EmulatorContext);
     return EmulatorContext.Flags.Af;
 }
 
@@ -600,6 +606,7 @@ VOID
 WINAPI
 setAF(ULONG Flag)
 {
+    Fast486UpdateFlags(&EmulatorContext);
     EmulatorContext.Flags.Af = !!(Flag & 1);
 }
 
@@ -607,6 +614,7 @@ ULONG
 WINAPI
 getZF(VOID)
 {
+    Fast486UpdateFlags(&EmulatorContext);
     return EmulatorContext.Flags.Zf;
 }
 
@@ -614,6 +622,7 @@ VOID
 WINAPI
 setZF(ULONG Flag)
 {
+    Fast486UpdateFlags(&EmulatorContext);
     EmulatorContext.Flags.Zf = !!(Flag & 1);
 }
 
@@ -621,6 +630,7 @@ ULONG
 WINAPI
 getSF(VOID)
 {
+    Fast486UpdateFlags(&EmulatorContext);
     return EmulatorContext.Flags.Sf;
 }
 
@@ -628,6 +638,7 @@ VOID
 WINAPI
 setSF(ULONG Flag)
 {
+    Fast486UpdateFlags(&EmulatorContext);
     EmulatorContext.Flags.Sf = !!(Flag & 1);
 }
 
@@ -663,6 +674,7 @@ ULONG
 WINAPI
 getOF(VOID)
 {
+    Fast486UpdateFlags(&EmulatorContext);
     return EmulatorContext.Flags.Of;
 }
 
@@ -670,6 +682,7 @@ VOID
 WINAPI
 setOF(ULONG Flag)
 {
+    Fast486UpdateFlags(&EmulatorContext);
     EmulatorContext.Flags.Of = !!(Flag & 1);
 }
 
@@ -679,6 +692,7 @@ ULONG
 WINAPI
 getEFLAGS(VOID)
 {
+    Fast486UpdateFlags(&EmulatorContext);
     return EmulatorContext.Flags.Long;
 }
 
@@ -686,6 +700,7 @@ VOID
 WINAPI
 setEFLAGS(ULONG Flags)
 {
+    Fast486UpdateFlags(&EmulatorContext);
     EmulatorContext.Flags.Long = Flags;
 }
 
@@ -297,6 +297,56 @@ static COORD CurrResolution   = {0};
 
 static SMALL_RECT UpdateRectangle = { 0, 0, 0, 0 };
 
+/*
+ * Dirty tracking -- every write to the video memory sets the bit of its
+ * VGA_DIRTY_CHUNK_SIZE bytes (per plane) chunk, and each frame only renders
+ * the scanlines that show a dirty chunk. The bitmap is cleared after every
+ * frame. Any other change that affects the display is caught by comparing
+ * the render state with the one of the previous frame.
+ */
+#define VGA_DIRTY_SHIFT 6
+#define VGA_DIRTY_CHUNK_SIZE (1 << VGA_DIRTY_SHIFT)
+
+static ULONG VgaDirtyBitmap[(SVGA_BANK_SIZE >> VGA_DIRTY_SHIFT) / 32];
+static BOOLEAN FullUpdate = TRUE;
+
+typedef struct _VGA_RENDER_STATE
+{
+    PVOID Framebuffer;
+    SCREEN_MODE ScreenMode;
+    COORD Resolution;
+    DWORD StartAddress;
+    DWORD ScanlineSize;
+    DWORD AddressSize;
+    BOOLEAN AcPalDisable;
+    BYTE SeqExtMode;
+    BYTE GcMode;
+    BYTE GcMisc;
+    BYTE CrtcOverflow;
+    BYTE CrtcPresetRowScan;
+    BYTE CrtcMaxScanLine;
+    BYTE CrtcLineCompare;
+    BYTE CrtcExtDisplay;
+    BYTE AcRegisters[VGA_AC_MAX_REG];
+} VGA_RENDER_STATE, *PVGA_RENDER_STATE;
+
+static VGA_RENDER_STATE RenderState;
+
+/* Planar to chunky conversion of 8 pixels at a time */
+static ULONGLONG VgaPlanarTable[256];
+static BYTE VgaLineBuffer[4096];
+
+/* Frame update statistics, reported on cleanup */
+static struct
+{
+    ULONG Frames;
+    ULONG FullFrames;
+    ULONGLONG LinesDrawn;
+    ULONGLONG LinesSkipped;
+    ULONGLONG PixelsChanged;
+    LONGLONG Ticks;
+} VgaUpdateStats;
+
 
 
 
@@ -704,6 +754,7 @@ static VOID VgaChangeMode(VOID)
 Quit:
 
     /* Trigger a full update of the screen */
+    FullUpdate = TRUE;
     NeedsUpdate = TRUE;
     UpdateRectangle.Left = 0;
     UpdateRectangle.Top  = 0;
@@ -733,9 +784,259 @@ static inline VOID VgaMarkForUpdate(SHORT Row, SHORT Column)
     NeedsUpdate = TRUE;
 }
 
+static VOID VgaReportUpdateStats(VOID)
+{
+    LARGE_INTEGER Counter, Frequency;
+
+    if (VgaUpdateStats.Frames == 0) return;
+
+    NtQueryPerformanceCounter(&Counter, &Frequency);
+    DPRINT1("VGA: %lu frames (%lu full), %I64u scanlines drawn, %I64u skipped, "
+            "%I64u pixels changed, %I64u us per frame\n",
+            VgaUpdateStats.Frames,
+            VgaUpdateStats.FullFrames,
+            VgaUpdateStats.LinesDrawn,
+            VgaUpdateStats.LinesSkipped,
+            VgaUpdateStats.PixelsChanged,
+            Frequency.QuadPart
+            ? (ULONGLONG)VgaUpdateStats.Ticks * 1000000 / Frequency.QuadPart / VgaUpdateStats.Frames
+            : 0ULL);
+}
+
+static inline VOID VgaMarkMemoryDirty(DWORD Offset)
+{
+    DWORD Chunk = (Offset & (SVGA_BANK_SIZE - 1)) >> VGA_DIRTY_SHIFT;
+
+    VgaDirtyBitmap[Chunk / 32] |= 1 << (Chunk % 32);
+}
+
+static VOID VgaMarkMemoryRangeDirty(DWORD Offset, DWORD Length)
+{
+    DWORD i;
+
+    for (i = 0; i < Length; i += VGA_DIRTY_CHUNK_SIZE) VgaMarkMemoryDirty(Offset + i);
+    if (Length) VgaMarkMemoryDirty(Offset + Length - 1);
+}
+
+static BOOLEAN VgaIsMemoryDirty(DWORD Offset, DWORD Length, DWORD WrapMask)
+{
+    DWORD i = 0, Chunk;
+
+    if (Length == 0) return FALSE;
+
+    /*
+     * Sample the range once per chunk and at its last byte, wrapping each
+     * sample separately, so that no chunk touched by the range is skipped.
+     */
+    while (TRUE)
+    {
+        if (i >= Length) i = Length - 1;
+
+        Chunk = (((Offset + i) & WrapMask) & (SVGA_BANK_SIZE - 1)) >> VGA_DIRTY_SHIFT;
+        if (VgaDirtyBitmap[Chunk / 32] & (1 << (Chunk % 32))) return TRUE;
+
+        if (i == Length - 1) break;
+        i += VGA_DIRTY_CHUNK_SIZE;
+    }
+
+    return FALSE;
+}
+
+/*
+ * Compares everything besides the video memory that VgaUpdateFramebuffer
+ * depends on with the state used for the previous frame. Returns TRUE
+ * if it changed, in which case all the scanlines must be rendered again.
+ */
+static BOOLEAN VgaCheckRenderState(DWORD AddressSize)
+{
+    VGA_RENDER_STATE State;
+
+    RtlZeroMemory(&State, sizeof(State));
+    State.Framebuffer  = ActiveFramebuffer;
+    State.ScreenMode   = ScreenMode;
+    State.Resolution   = CurrResolution;
+    State.StartAddress = StartAddressLatch;
+    State.ScanlineSize = ScanlineSizeLatch;
+    State.AddressSize  = AddressSize;
+    State.AcPalDisable = VgaAcPalDisable;
+    State.SeqExtMode   = VgaSeqRegisters[SVGA_SEQ_EXT_MODE_REG];
+    State.GcMode       = VgaGcRegisters[VGA_GC_MODE_REG];
+    State.GcMisc       = VgaGcRegisters[VGA_GC_MISC_REG];
+    State.CrtcOverflow      = VgaCrtcRegisters[VGA_CRTC_OVERFLOW_REG];
+    State.CrtcPresetRowScan = VgaCrtcRegisters[VGA_CRTC_PRESET_ROW_SCAN_REG];
+    State.CrtcMaxScanLine   = VgaCrtcRegisters[VGA_CRTC_MAX_SCAN_LINE_REG];
+    State.CrtcLineCompare   = VgaCrtcRegisters[VGA_CRTC_LINE_COMPARE_REG];
+    State.CrtcExtDisplay    = VgaCrtcRegisters[SVGA_CRTC_EXT_DISPLAY_REG];
+    RtlCopyMemory(State.AcRegisters, VgaAcRegisters, sizeof(State.AcRegisters));
+
+    if (RtlCompareMemory(&State, &RenderState, sizeof(State)) == sizeof(State))
+        return FALSE;
+
+    RenderState = State;
+    return TRUE;
+}
+
+static VOID VgaInitializePlanarTable(VOID)
+{
+    ULONG i, j;
+
+    /*
+     * Entry i has byte j set to 1 if bit (7 - j) of i is set, so that
+     * ORing the entries of the four planes, each shifted left by the plane
+     * number, gives the 4-bit values of 8 consecutive pixels at once.
+     */
+    for (i = 0; i < ARRAYSIZE(VgaPlanarTable); i++)
+    {
+        VgaPlanarTable[i] = 0ULL;
+
+        for (j = 0; j < 8; j++)
+        {
+            if (i & (0x80 >> j)) VgaPlanarTable[i] |= 1ULL << (j * 8);
+        }
+    }
+}
+
+/*
+ * Converts Count bytes of each plane of a 16 color planar scanline into
+ * one byte per pixel, 8 pixels at a time.
+ */
+static VOID VgaConvertPlanarLine(DWORD Address, DWORD AddressSize, DWORD Count, PBYTE Pixels)
+{
+    DWORD i;
+    PBYTE Planes;
+    ULONGLONG Chunky;
+
+    for (i = 0; i < Count; i++)
+    {
+        Planes = &VgaMemory[WRAP_OFFSET((Address + i) * AddressSize) * VGA_NUM_BANKS];
+        Chunky = VgaPlanarTable[Planes[0]]
+                 | (VgaPlanarTable[Planes[1]] << 1)
+                 | (VgaPlanarTable[Planes[2]] << 2)
+                 | (VgaPlanarTable[Planes[3]] << 3);
+
+        /* Pixel j of this byte is in byte j of the value (little-endian) */
+        *(PULONGLONG)&Pixels[i * 8] = Chunky;
+    }
+}
+
+static inline BYTE VgaGetPixel(DWORD Address, DWORD AddressSize, SHORT X)
+{
+    BYTE PixelData = 0;
+    SHORT k;
+
+    if (VgaSeqRegisters[SVGA_SEQ_EXT_MODE_REG] & SVGA_SEQ_EXT_MODE_HIGH_RES)
+    {
+        // TODO: Check for high color modes
+
+        /* 256 color mode */
+        PixelData = VgaMemory[Address + X];
+    }
+    else
+    {
+        /* Check the shifting mode */
+        if (VgaGcRegisters[VGA_GC_MODE_REG] & VGA_GC_MODE_SHIFT256)
+        {
+            /* 4 bits shifted from each plane */
+
+            /* Check if this is 16 or 256 color mode */
+            if (VgaAcRegisters[VGA_AC_CONTROL_REG] & VGA_AC_CONTROL_8BIT)
+            {
+                /* One byte per pixel */
+                PixelData = VgaMemory[WRAP_OFFSET((Address + (X / VGA_NUM_BANKS)) * AddressSize)
+                                      * VGA_NUM_BANKS + (X % VGA_NUM_BANKS)];
+            }
+            else
+            {
+                /* 4-bits per pixel */
+
+                PixelData = VgaMemory[WRAP_OFFSET((Address + (X / (VGA_NUM_BANKS * 2))) * AddressSize)
+                                      * VGA_NUM_BANKS + ((X / 2) % VGA_NUM_BANKS)];
+
+                /* Check if we should use the highest 4 bits or lowest 4 */
+                if ((X % 2) == 0)
+                {
+                    /* Highest 4 */
+                    PixelData >>= 4;
+                }
+                else
+                {
+                    /* Lowest 4 */
+                    PixelData &= 0x0F;
+                }
+            }
+        }
+        else if (VgaGcRegisters[VGA_GC_MODE_REG] & VGA_GC_MODE_SHIFTREG)
+        {
+            /* Check if this is 16 or 256 color mode */
+            if (VgaAcRegisters[VGA_AC_CONTROL_REG] & VGA_AC_CONTROL_8BIT)
+            {
+                // TODO: NOT IMPLEMENTED
+                DPRINT1("8-bit interleaved mode is not implemented!\n");
+            }
+            else
+            {
+                /*
+                 * 2 bits shifted from plane 0 and 2 for the first 4 pixels,
+                 * then 2 bits shifted from plane 1 and 3 for the next 4
+                 */
+                DWORD BankNumber = (X / 4) % 2;
+                DWORD Offset = Address + (X / 8);
+                BYTE LowPlaneData = VgaMemory[WRAP_OFFSET(Offset * AddressSize) * VGA_NUM_BANKS + BankNumber];
+                BYTE HighPlaneData = VgaMemory[WRAP_OFFSET(Offset * AddressSize) * VGA_NUM_BANKS + (BankNumber + 2)];
+
+                /* Extract the two bits from each plane */
+                LowPlaneData  = (LowPlaneData  >> (6 - ((X % 4) * 2))) & 0x03;
+                HighPlaneData = (HighPlaneData >> (6 - ((X % 4) * 2))) & 0x03;
+
+                /* Combine them into the pixel */
+                PixelData = LowPlaneData | (HighPlaneData << 2);
+            }
+        }
+        else
+        {
+            /* 1 bit shifted from each plane */
+
+            /* Check if this is 16 or 256 color mode */
+            if (VgaAcRegisters[VGA_AC_CONTROL_REG] & VGA_AC_CONTROL_8BIT)
+            {
+                /* 8 bits per pixel, 2 on each plane */
+
+                for (k = 0; k < VGA_NUM_BANKS; k++)
+                {
+                    /* The data is on plane k, 4 pixels per byte */
+                    BYTE PlaneData = VgaMemory[WRAP_OFFSET((Address + (X >> 2)) * AddressSize) * VGA_NUM_BANKS + k];
+
+                    /* The mask of the first bit in the pair */
+                    BYTE BitMask = 1 << (((3 - (X % VGA_NUM_BANKS)) * 2) + 1);
+
+                    /* Bits 0, 1, 2 and 3 come from the first bit of the pair */
+                    if (PlaneData & BitMask) PixelData |= 1 << k;
+
+                    /* Bits 4, 5, 6 and 7 come from the second bit of the pair */
+                    if (PlaneData & (BitMask >> 1)) PixelData |= 1 << (k + 4);
+                }
+            }
+            else
+            {
+                /* 4 bits per pixel, 1 on each plane */
+
+                for (k = 0; k < VGA_NUM_BANKS; k++)
+                {
+                    BYTE PlaneData = VgaMemory[WRAP_OFFSET((Address + (X >> 3)) * AddressSize) * VGA_NUM_BANKS + k];
+
+                    /* If the bit on that plane is set, set it */
+                    if (PlaneData & (1 << (7 - (X % 8)))) PixelData |= 1 << k;
+                }
+            }
+        }
+    }
+
+    return PixelData;
+}
+
 static VOID VgaUpdateFramebuffer(VOID)
 {
-    SHORT i, j, k;
+    SHORT i, j;
     DWORD AddressSize = VgaGetAddressSize();
     DWORD Address = StartAddressLatch;
     BYTE BytePanning = (VgaCrtcRegisters[VGA_CRTC_PRESET_ROW_SCAN_REG] >> 5) & 3;
@@ -743,6 +1044,9 @@ static VOID VgaUpdateFramebuffer(VOID)
                        | ((VgaCrtcRegisters[VGA_CRTC_OVERFLOW_REG] & VGA_CRTC_OVERFLOW_LC8) << 4)
                        | ((VgaCrtcRegisters[VGA_CRTC_MAX_SCAN_LINE_REG] & VGA_CRTC_MAXSCANLINE_LC9) << 3);
     BYTE PixelShift = VgaAcRegisters[VGA_AC_HORZ_PANNING_REG] & 0x0F;
+    DWORD WrapMask = WRAP_OFFSET(0xFFFFFFFF);
+    BOOLEAN AllLines;
+    LARGE_INTEGER StartCount, EndCount;
 
     /*
      * If the console framebuffer is NULL, that means something
@@ -750,13 +1054,62 @@ static VOID VgaUpdateFramebuffer(VOID)
      */
     if (ActiveFramebuffer == NULL) return;
 
+    NtQueryPerformanceCounter(&StartCount, NULL);
+
+    /* Render everything if the mapping of the memory to the screen changed */
+    AllLines = VgaCheckRenderState(AddressSize) || FullUpdate;
+    VgaUpdateStats.Frames++;
+    if (AllLines) VgaUpdateStats.FullFrames++;
+
     /* Check if we are in text or graphics mode */
     if (ScreenMode == GRAPHICS_MODE)
     {
         /* Graphics mode */
         PBYTE GraphicsBuffer = (PBYTE)ActiveFramebuffer;
         DWORD InterlaceHighBit = VGA_INTERLACE_HIGH_BIT;
-        SHORT X;
+        BOOLEAN EightBit = !!(VgaAcRegisters[VGA_AC_CONTROL_REG] & VGA_AC_CONTROL_8BIT);
+        BOOLEAN Packed = !!(VgaSeqRegisters[SVGA_SEQ_EXT_MODE_REG] & SVGA_SEQ_EXT_MODE_HIGH_RES);
+        BOOLEAN Planar = !Packed && !EightBit
+                         && !(VgaGcRegisters[VGA_GC_MODE_REG] & (VGA_GC_MODE_SHIFT256 | VGA_GC_MODE_SHIFTREG));
+        DWORD PixelsPerAddress = EightBit ? 4 : 8;
+        DWORD Pitch = CurrResolution.X * (DoubleWidth ? 2 : 1);
+        DWORD PlanarCount = (CurrResolution.X + 7 + 7) / 8 + 1;
+        BYTE PaletteMap[16];
+        PBYTE Line;
+        SHORT X, Pan, Left, Right;
+        BYTE PixelData;
+
+        /*
+         * In 16 color mode, the value is an index to the AC registers
+         * if external palette access is disabled, otherwise (in case
+         * of palette loading) it is a blank pixel.
+         */
+        for (j = 0; j < ARRAYSIZE(PaletteMap); j++)
+        {
+            if (!VgaAcPalDisable)
+            {
+                PaletteMap[j] = 0;
+            }
+            else if (!(VgaAcRegisters[VGA_AC_CONTROL_REG] & VGA_AC_CONTROL_P54S))
+            {
+                /* Bits 4 and 5 are taken from the palette register */
+                PaletteMap[j] = ((VgaAcRegisters[VGA_AC_COLOR_SEL_REG] << 4) & 0xC0)
+                                | (VgaAcRegisters[j] & 0x3F);
+            }
+            else
+            {
+                /* Bits 4 and 5 are taken from the color select register */
+                PaletteMap[j] = (VgaAcRegisters[VGA_AC_COLOR_SEL_REG] << 4)
+                                | (VgaAcRegisters[j] & 0x0F);
+            }
+        }
+
+        /* The line buffer starts 8 pixels early for a pixel shift of -1 */
+        if (PlanarCount * 8 + 8 > sizeof(VgaLineBuffer)) Planar = FALSE;
+        RtlZeroMemory(VgaLineBuffer, 8);
+
+        /* Packed modes address the video memory directly and never wrap */
+        if (Packed) WrapMask = 0xFFFFFFFF;
 
         /*
          * Synchronize access to the graphics framebuffer
@@ -806,213 +1159,73 @@ static VOID VgaUpdateFramebuffer(VOID)
                 Address |= InterlaceHighBit;
             }
 
-            /* Loop through the pixels */
-            for (j = 0; j < CurrResolution.X; j++)
+            /* Skip the scanline if none of the memory it shows has been written */
+            if (!AllLines &&
+                !(Packed ? VgaIsMemoryDirty((Address - 1) >> 2,
+                                            (CurrResolution.X + 9) / 4 + 2,
+                                            WrapMask)
+                         : VgaIsMemoryDirty((Address - 1) * AddressSize,
+                                            ((CurrResolution.X + 8) / PixelsPerAddress + 3) * AddressSize,
+                                            WrapMask)))
             {
-                BYTE PixelData = 0;
+                VgaUpdateStats.LinesSkipped++;
+                goto NextLine;
+            }
 
-                /* Apply horizontal pixel panning */
-                if (VgaAcRegisters[VGA_AC_CONTROL_REG] & VGA_AC_CONTROL_8BIT)
-                {
-                    X = j + ((PixelShift >> 1) & 0x03);
-                }
-                else
-                {
-                    X = j + ((PixelShift < 8) ? PixelShift : -1);
-                }
+            VgaUpdateStats.LinesDrawn++;
 
-                if (VgaSeqRegisters[SVGA_SEQ_EXT_MODE_REG] & SVGA_SEQ_EXT_MODE_HIGH_RES)
-                {
-                    // TODO: Check for high color modes
+            /* Apply horizontal pixel panning */
+            if (EightBit) Pan = (PixelShift >> 1) & 0x03;
+            else Pan = (PixelShift < 8) ? PixelShift : -1;
 
-                    /* 256 color mode */
-                    PixelData = VgaMemory[Address + X];
-                }
-                else
-                {
-                    /* Check the shifting mode */
-                    if (VgaGcRegisters[VGA_GC_MODE_REG] & VGA_GC_MODE_SHIFT256)
-                    {
-                        /* 4 bits shifted from each plane */
-
-                        /* Check if this is 16 or 256 color mode */
-                        if (VgaAcRegisters[VGA_AC_CONTROL_REG] & VGA_AC_CONTROL_8BIT)
-                        {
-                            /* One byte per pixel */
-                            PixelData = VgaMemory[WRAP_OFFSET((Address + (X / VGA_NUM_BANKS)) * AddressSize)
-                                                  * VGA_NUM_BANKS + (X % VGA_NUM_BANKS)];
-                        }
-                        else
-                        {
-                            /* 4-bits per pixel */
-
-                            PixelData = VgaMemory[WRAP_OFFSET((Address + (X / (VGA_NUM_BANKS * 2))) * AddressSize)
-                                                  * VGA_NUM_BANKS + ((X / 2) % VGA_NUM_BANKS)];
-
-                            /* Check if we should use the highest 4 bits or lowest 4 */
-                            if ((X % 2) == 0)
-                            {
-                                /* Highest 4 */
-                                PixelData >>= 4;
-                            }
-                            else
-                            {
-                                /* Lowest 4 */
-                                PixelData &= 0x0F;
-                            }
-                        }
-                    }
-                    else if (VgaGcRegisters[VGA_GC_MODE_REG] & VGA_GC_MODE_SHIFTREG)
-                    {
-                        /* Check if this is 16 or 256 color mode */
-                        if (VgaAcRegisters[VGA_AC_CONTROL_REG] & VGA_AC_CONTROL_8BIT)
-                        {
-                            // TODO: NOT IMPLEMENTED
-                            DPRINT1("8-bit interleaved mode is not implemented!\n");
-                        }
-                        else
-                        {
-                            /*
-                             * 2 bits shifted from plane 0 and 2 for the first 4 pixels,
-                             * then 2 bits shifted from plane 1 and 3 for the next 4
-                             */
-                            DWORD BankNumber = (X / 4) % 2;
-                            DWORD Offset = Address + (X / 8);
-                            BYTE LowPlaneData = VgaMemory[WRAP_OFFSET(Offset * AddressSize) * VGA_NUM_BANKS + BankNumber];
-                            BYTE HighPlaneData = VgaMemory[WRAP_OFFSET(Offset * AddressSize) * VGA_NUM_BANKS + (BankNumber + 2)];
-
-                            /* Extract the two bits from each plane */
-                            LowPlaneData  = (LowPlaneData  >> (6 - ((X % 4) * 2))) & 0x03;
-                            HighPlaneData = (HighPlaneData >> (6 - ((X % 4) * 2))) & 0x03;
-
-                            /* Combine them into the pixel */
-                            PixelData = LowPlaneData | (HighPlaneData << 2);
-                        }
-                    }
-                    else
-                    {
-                        /* 1 bit shifted from each plane */
-
-                        /* Check if this is 16 or 256 color mode */
-                        if (VgaAcRegisters[VGA_AC_CONTROL_REG] & VGA_AC_CONTROL_8BIT)
-                        {
-                            /* 8 bits per pixel, 2 on each plane */
-
-                            for (k = 0; k < VGA_NUM_BANKS; k++)
-                            {
-                                /* The data is on plane k, 4 pixels per byte */
-                                BYTE PlaneData = VgaMemory[WRAP_OFFSET((Address + (X >> 2)) * AddressSize) * VGA_NUM_BANKS + k];
-
-                                /* The mask of the first bit in the pair */
-                                BYTE BitMask = 1 << (((3 - (X % VGA_NUM_BANKS)) * 2) + 1);
-
-                                /* Bits 0, 1, 2 and 3 come from the first bit of the pair */
-                                if (PlaneData & BitMask) PixelData |= 1 << k;
-
-                                /* Bits 4, 5, 6 and 7 come from the second bit of the pair */
-                                if (PlaneData & (BitMask >> 1)) PixelData |= 1 << (k + 4);
-                            }
-                        }
-                        else
-                        {
-                            /* 4 bits per pixel, 1 on each plane */
-
-                            for (k = 0; k < VGA_NUM_BANKS; k++)
-                            {
-                                BYTE PlaneData = VgaMemory[WRAP_OFFSET((Address + (X >> 3)) * AddressSize) * VGA_NUM_BANKS + k];
-
-                                /* If the bit on that plane is set, set it */
-                                if (PlaneData & (1 << (7 - (X % 8)))) PixelData |= 1 << k;
-                            }
-                        }
-                    }
-                }
+            /* Convert the whole scanline at once in the common 16 color planar modes */
+            if (Planar) VgaConvertPlanarLine(Address, AddressSize, PlanarCount, &VgaLineBuffer[8]);
 
-                if (!(VgaAcRegisters[VGA_AC_CONTROL_REG] & VGA_AC_CONTROL_8BIT))
-                {
-                    /*
-                     * In 16 color mode, the value is an index to the AC registers
-                     * if external palette access is disabled, otherwise (in case
-                     * of palette loading) it is a blank pixel.
-                     */
+            Line = &GraphicsBuffer[i * (DoubleHeight ? 2 : 1) * Pitch];
+            Left = MAXSHORT;
+            Right = MINSHORT;
 
-                    if (VgaAcPalDisable)
-                    {
-                        if (!(VgaAcRegisters[VGA_AC_CONTROL_REG] & VGA_AC_CONTROL_P54S))
-                        {
-                            /* Bits 4 and 5 are taken from the palette register */
-                            PixelData = ((VgaAcRegisters[VGA_AC_COLOR_SEL_REG] << 4) & 0xC0)
-                                        | (VgaAcRegisters[PixelData & 0x0F] & 0x3F);
-                        }
-                        else
-                        {
-                            /* Bits 4 and 5 are taken from the color select register */
-                            PixelData = (VgaAcRegisters[VGA_AC_COLOR_SEL_REG] << 4)
-                                        | (VgaAcRegisters[PixelData & 0x0F] & 0x0F);
-                        }
-                    }
-                    else
-                    {
-                        PixelData = 0;
-                    }
-                }
+            /* Loop through the pixels */
+            for (j = 0; j < CurrResolution.X; j++)
+            {
+                X = j + Pan;
+
+                if (Planar) PixelData = VgaLineBuffer[X + 8];
+                else PixelData = VgaGetPixel(Address, AddressSize, X);
+
+                if (!EightBit) PixelData = PaletteMap[PixelData & 0x0F];
 
                 /* Take into account DoubleVision mode when checking for pixel updates */
-                if (DoubleWidth && DoubleHeight)
-                {
-                    /* Now check if the resulting pixel data has changed */
-                    if (GraphicsBuffer[(i * 2 * CurrResolution.X * 2) + (j * 2)] != PixelData)
-                    {
-                        /* Yes, write the new value */
-                        GraphicsBuffer[(i * 2 * CurrResolution.X * 2) + (j * 2)] = PixelData;
-                        GraphicsBuffer[(i * 2 * CurrResolution.X * 2) + (j * 2 + 1)] = PixelData;
-                        GraphicsBuffer[((i * 2 + 1) * CurrResolution.X * 2) + (j * 2)] = PixelData;
-                        GraphicsBuffer[((i * 2 + 1) * CurrResolution.X * 2) + (j * 2 + 1)] = PixelData;
-
-                        /* Mark the specified pixel as changed */
-                        VgaMarkForUpdate(i, j);
-                    }
-                }
-                else if (DoubleWidth && !DoubleHeight)
-                {
-                    /* Now check if the resulting pixel data has changed */
-                    if (GraphicsBuffer[(i * CurrResolution.X * 2) + (j * 2)] != PixelData)
-                    {
-                        /* Yes, write the new value */
-                        GraphicsBuffer[(i * CurrResolution.X * 2) + (j * 2)] = PixelData;
-                        GraphicsBuffer[(i * CurrResolution.X * 2) + (j * 2 + 1)] = PixelData;
+                X = DoubleWidth ? j * 2 : j;
 
-                        /* Mark the specified pixel as changed */
-                        VgaMarkForUpdate(i, j);
-                    }
-                }
-                else if (!DoubleWidth && DoubleHeight)
+                /* Now check if the resulting pixel data has changed */
+                if (Line[X] != PixelData)
                 {
-                    /* Now check if the resulting pixel data has changed */
-                    if (GraphicsBuffer[(i * 2 * CurrResolution.X) + j] != PixelData)
-                    {
-                        /* Yes, write the new value */
-                        GraphicsBuffer[(i * 2 * CurrResolution.X) + j] = PixelData;
-                        GraphicsBuffer[((i * 2 + 1) * CurrResolution.X) + j] = PixelData;
+                    /* Yes, write the new value */
+                    Line[X] = PixelData;
+                    if (DoubleWidth) Line[X + 1] = PixelData;
 
-                        /* Mark the specified pixel as changed */
-                        VgaMarkForUpdate(i, j);
-                    }
-                }
-                else // if (!DoubleWidth && !DoubleHeight)
-                {
-                    /* Now check if the resulting pixel data has changed */
-                    if (GraphicsBuffer[i * CurrResolution.X + j] != PixelData)
+                    if (DoubleHeight)
                     {
-                        /* Yes, write the new value */
-                        GraphicsBuffer[i * CurrResolution.X + j] = PixelData;
-
-                        /* Mark the specified pixel as changed */
-                        VgaMarkForUpdate(i, j);
+                        Line[Pitch + X] = PixelData;
+                        if (DoubleWidth) Line[Pitch + X + 1] = PixelData;
                     }
+
+                    /* Extend the changed span of this scanline */
+                    if (j < Left) Left = j;
+                    Right = j;
+                    VgaUpdateStats.PixelsChanged++;
                 }
             }
 
+            if (Left <= Right)
+            {
+                /* Mark the changed span */
+                VgaMarkForUpdate(i, Left);
+                VgaMarkForUpdate(i, Right);
+            }
+
+NextLine:
             if ((VgaGcRegisters[VGA_GC_MISC_REG] & VGA_GC_MISC_OE) && (i & 1))
             {
                 /* Clear the high bit */
@@ -1048,6 +1261,17 @@ static VOID VgaUpdateFramebuffer(VOID)
         /* Loop through the scanlines */
         for (i = 0; i < CurrResolution.Y; i++)
         {
+            /* Skip the row if none of its characters have been written */
+            if (!AllLines &&
+                !VgaIsMemoryDirty(Address * AddressSize, CurrResolution.X * AddressSize, WrapMask))
+            {
+                VgaUpdateStats.LinesSkipped++;
+                Address += ScanlineSizeLatch;
+                continue;
+            }
+
+            VgaUpdateStats.LinesDrawn++;
+
             /* Loop through the characters */
             for (j = 0; j < CurrResolution.X; j++)
             {
@@ -1068,6 +1292,7 @@ static VOID VgaUpdateFramebuffer(VOID)
 
                     /* Mark the specified cell as changed */
                     VgaMarkForUpdate(i, j);
+                    VgaUpdateStats.PixelsChanged++;
                 }
             }
 
@@ -1075,6 +1300,13 @@ static VOID VgaUpdateFramebuffer(VOID)
             Address += ScanlineSizeLatch;
         }
     }
+
+    /* Everything written so far is now on the screen */
+    RtlZeroMemory(VgaDirtyBitmap, sizeof(VgaDirtyBitmap));
+    FullUpdate = FALSE;
+
+    NtQueryPerformanceCounter(&EndCount, NULL);
+    VgaUpdateStats.Ticks += EndCount.QuadPart - StartCount.QuadPart;
 }
 
 static VOID VgaUpdateTextCursor(VOID)
@@ -1796,6 +2028,9 @@ VOID VgaRefreshDisplay(VOID)
                         + (VgaCrtcRegisters[VGA_CRTC_PRESET_ROW_SCAN_REG] & 0x1F) * ScanlineSizeLatch
                         + ((VgaCrtcRegisters[VGA_CRTC_PRESET_ROW_SCAN_REG] >> 5) & 3);
 
+    /* Render everything again */
+    FullUpdate = TRUE;
+
     VgaVerticalRetrace();
 }
 
@@ -2028,6 +2263,8 @@ BOOLEAN FASTCALL VgaWriteMemory(ULONG Address, PVOID Buffer, ULONG Size)
                 /* Copy the value to the VGA memory */
                 VgaMemory[VideoAddress * VGA_NUM_BANKS + j] = VgaTranslateByteForWriting(BufPtr[i], j);
             }
+
+            VgaMarkMemoryDirty(VideoAddress);
         }
     }
     else
@@ -2041,6 +2278,11 @@ BOOLEAN FASTCALL VgaWriteMemory(ULONG Address, PVOID Buffer, ULONG Size)
         VideoAddress = VgaTranslateAddress(Address);
         VideoMemory = &VgaMemory[VideoAddress + (Address & 3)];
 
+        /* Packed pixels are stored linearly, one plane offset per 4 bytes */
+        VgaMarkMemoryRangeDirty((VideoAddress + (Address & 3)) >> 2,
+                                ((VideoAddress + (Address & 3) + Size - 1) >> 2)
+                                - ((VideoAddress + (Address & 3)) >> 2) + 1);
+
         switch (Size)
         {
             case sizeof(UCHAR):
@@ -2074,6 +2316,7 @@ BOOLEAN FASTCALL VgaWriteMemory(ULONG Address, PVOID Buffer, ULONG Size)
 VOID VgaClearMemory(VOID)
 {
     RtlZeroMemory(VgaMemory, sizeof(VgaMemory));
+    FullUpdate = TRUE;
 }
 
 VOID VgaWriteTextModeFont(UINT FontNumber, CONST UCHAR* FontData, UINT Height)
@@ -2095,6 +2338,9 @@ VOID VgaWriteTextModeFont(UINT FontNumber, CONST UCHAR* FontData, UINT Height)
             VgaMemory[(i * VGA_MAX_FONT_HEIGHT + j) * VGA_NUM_BANKS + VGA_FONT_BANK] = 0;
         }
     }
+
+    /* The font plane is also visible in the graphics modes */
+    FullUpdate = TRUE;
 }
 
 BOOLEAN VgaInitialize(HANDLE TextHandle)
@@ -2117,6 +2363,9 @@ BOOLEAN VgaInitialize(HANDLE TextHandle)
     /* Clear the VGA memory */
     VgaClearMemory();
 
+    /* Build the planar to chunky conversion table */
+    VgaInitializePlanarTable();
+
     /* Register the I/O Ports */
     RegisterIoPort(0x3CC, VgaReadPort,         NULL);   // VGA_MISC_READ
     RegisterIoPort(0x3C2, VgaReadPort, VgaWritePort);   // VGA_MISC_WRITE, VGA_INSTAT0_READ
@@ -2146,6 +2395,7 @@ VOID VgaCleanup(VOID)
 {
     /* Do a final display refresh */
     VgaRefreshDisplay();
+    VgaReportUpdateStats();
 
     DestroyHardwareTimer(HSyncTimer);
 
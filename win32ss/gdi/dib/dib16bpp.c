@@ -572,6 +572,56 @@ Clamp5(ULONG val)
    return (val > 31) ? 31 : (UCHAR)val;
 }
 
+/* Exact x / 255 for x <= 255 * 255, x / 31 for x <= 31 * 31 and
+   x / 63 for x <= 63 * 63, without dividing */
+#define DIV255(x)   (((x) + 1 + ((x) >> 8)) >> 8)
+#define DIV31(x)    (((x) * 2115) >> 16)
+#define DIV63(x)    (((x) * 2081) >> 17)
+
+/*
+ * Blends a row of 32bpp pixels onto a 565 row, with the same results as
+ * the per pixel code below. RedShift and BlueShift locate red and blue in
+ * the source pixels, which depends on the source palette.
+ */
+static VOID
+AlphaBlendRow565(PUSHORT Dst, PULONG Src, LONG Count, ULONG ConstAlpha,
+                 BOOLEAN UseSrcAlpha, ULONG RedShift, ULONG BlueShift)
+{
+  ULONG SrcPixel, DstPixel, Red, Green, Blue, Alpha, Alpha5, Alpha6;
+
+  Alpha5 = ConstAlpha >> 3;
+  Alpha6 = ConstAlpha >> 2;
+
+  while (Count-- > 0)
+  {
+    SrcPixel = *Src++;
+
+    Red = (SrcPixel >> RedShift) & 0xFF;
+    Green = (SrcPixel >> 8) & 0xFF;
+    Blue = (SrcPixel >> BlueShift) & 0xFF;
+    if (ConstAlpha != 255)
+    {
+      Red = DIV255(Red * ConstAlpha);
+      Green = DIV255(Green * ConstAlpha);
+      Blue = DIV255(Blue * ConstAlpha);
+    }
+
+    if (UseSrcAlpha)
+    {
+      Alpha = DIV255((SrcPixel >> 24) * ConstAlpha);
+      Alpha5 = Alpha >> 3;
+      Alpha6 = Alpha >> 2;
+    }
+
+    DstPixel = *Dst;
+    Red = DIV31(((DstPixel >> 11) & 0x1F) * (31 - Alpha5)) + (Red >> 3);
+    Green = DIV63(((DstPixel >> 5) & 0x3F) * (63 - Alpha6)) + (Green >> 2);
+    Blue = DIV31((DstPixel & 0x1F) * (31 - Alpha5)) + (Blue >> 3);
+
+    *Dst++ = (USHORT)((Clamp5(Red) << 11) | (Clamp6(Green) << 5) | Clamp5(Blue));
+  }
+}
+
 BOOLEAN
 DIB_16BPP_AlphaBlend(SURFOBJ* Dest, SURFOBJ* Source, RECTL* DestRect,
                      RECTL* SourceRect, CLIPOBJ* ClipRegion,
@@ -620,6 +670,37 @@ DIB_16BPP_AlphaBlend(SURFOBJ* Dest, SURFOBJ* Source, RECTL* DestRect,
   pexlo = CONTAINING_RECORD(ColorTranslation, EXLATEOBJ, xlo);
   EXLATEOBJ_vInitialize(&exloSrcRGB, pexlo->ppalSrc, &gpalRGB, 0, 0, 0);
 
+  /* Blend whole rows of RGB or BGR sources without going through the
+     pixel and translation functions for every pixel */
+  if ((pexlo->ppalDst->flFlags & PAL_RGB16_565) &&
+      Source->iBitmapFormat == BMF_32BPP &&
+      ((exloSrcRGB.xlo.flXlate & XO_TRIVIAL) ||
+       XLATEOBJ_pfnXlate(&exloSrcRGB.xlo) == EXLATEOBJ_iXlateRGBtoBGR) &&
+      SourceRect->right - SourceRect->left == DestRect->right - DestRect->left &&
+      SourceRect->bottom - SourceRect->top == DestRect->bottom - DestRect->top)
+  {
+    /* COLORREF order has red in the low byte */
+    BOOLEAN IsBGR = !(exloSrcRGB.xlo.flXlate & XO_TRIVIAL);
+    PUSHORT Dst = (PUSHORT)((ULONG_PTR)Dest->pvScan0 + DestRect->top * Dest->lDelta +
+                            DestRect->left * sizeof(USHORT));
+    PULONG Src = (PULONG)((ULONG_PTR)Source->pvScan0 + SourceRect->top * Source->lDelta +
+                          SourceRect->left * sizeof(ULONG));
+
+    for (DstY = DestRect->top; DstY < DestRect->bottom; DstY++)
+    {
+      AlphaBlendRow565(Dst, Src, DestRect->right - DestRect->left,
+                       BlendFunc.SourceConstantAlpha,
+                       (BlendFunc.AlphaFormat & AC_SRC_ALPHA) != 0,
+                       IsBGR ? 16 : 0, IsBGR ? 0 : 16);
+
+      Dst = (PUSHORT)((ULONG_PTR)Dst + Dest->lDelta);
+      Src = (PULONG)((ULONG_PTR)Src + Source->lDelta);
+    }
+
+    EXLATEOBJ_vCleanup(&exloSrcRGB);
+    return TRUE;
+  }
+
   if (pexlo->ppalDst->flFlags & PAL_RGB16_555)
   {
       NICEPIXEL16_555 DstPixel16;
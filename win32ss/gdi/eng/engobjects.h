@@ -126,11 +126,15 @@ typedef struct _SHARED_FACE_CACHE {
 } SHARED_FACE_CACHE, *PSHARED_FACE_CACHE;
 
 typedef struct _SHARED_FACE {
+  PFAST_MUTEX   Lock;       /* Serializes FreeType calls on Face */
   FT_Face       Face;
   LONG          RefCount;
   PSHARED_MEM   Memory;
+  LPWSTR        Filename;   /* Set if Face is loaded on first use */
+  FT_Long       FaceIndex;
   SHARED_FACE_CACHE EnglishUS;
   SHARED_FACE_CACHE UserLanguage;
+  LIST_ENTRY    GlyphCacheListHead;
 } SHARED_FACE, *PSHARED_FACE;
 
 typedef struct _FONTGDI {
@@ -8,8 +8,32 @@ typedef struct _FONT_ENTRY
     UNICODE_STRING FaceName;
     UNICODE_STRING StyleName;
     BYTE NotEnum;
+    ULONG Sequence;             /* Position in the global font list */
 } FONT_ENTRY, *PFONT_ENTRY;
 
+/*
+ * FONT_INDEX_ENTRY --- links a global FONT_ENTRY into the name or charset
+ * index used to narrow the candidates of the font mapper
+ */
+typedef struct _FONT_INDEX_ENTRY
+{
+    LIST_ENTRY ListEntry;
+    PFONT_ENTRY FontEntry;
+    ULONG Hash;
+} FONT_INDEX_ENTRY, *PFONT_INDEX_ENTRY;
+
+/*
+ * FONT_REALIZATION_ENTRY --- result of matching a LOGFONTW against the
+ * global font list
+ */
+typedef struct _FONT_REALIZATION_ENTRY
+{
+    LIST_ENTRY ListEntry;
+    LOGFONTW LogFont;
+    FONTOBJ *FontObj;
+    ULONG MatchPenalty;
+} FONT_REALIZATION_ENTRY, *PFONT_REALIZATION_ENTRY;
+
 typedef struct _FONT_ENTRY_MEM
 {
     LIST_ENTRY ListEntry;
@@ -25,9 +49,15 @@ typedef struct _FONT_ENTRY_COLL_MEM
 
 typedef struct _FONT_CACHE_ENTRY
 {
-    LIST_ENTRY ListEntry;
+    LIST_ENTRY ListEntry;       /* Eviction list, most recently inserted first */
+    LIST_ENTRY HashEntry;       /* Chain of the hash bucket */
+    LIST_ENTRY FaceEntry;       /* Chain of SHARED_FACE::GlyphCacheListHead */
+    ULONG RealizationId;        /* Hash of face, height, render mode and transform */
+    ULONG Hash;                 /* RealizationId combined with GlyphIndex */
+    SIZE_T CacheSize;           /* Bytes charged to the cache budget */
+    BOOLEAN Referenced;         /* Hit since it was last considered for eviction */
     int GlyphIndex;
-    FT_Face Face;
+    PSHARED_FACE SharedFace;
     FT_BitmapGlyph BitmapGlyph;
     int Height;
     int Width;
@@ -36,6 +66,16 @@ typedef struct _FONT_CACHE_ENTRY
     MATRIX mxWorldToDevice;
 } FONT_CACHE_ENTRY, *PFONT_CACHE_ENTRY;
 
+typedef struct _FONT_CACHE_STATS
+{
+    ULONG Hits;
+    ULONG Misses;
+    ULONG Evictions;
+    ULONG NumEntries;
+    SIZE_T CurrentSize;
+    SIZE_T MaxSize;
+} FONT_CACHE_STATS, *PFONT_CACHE_STATS;
+
 
 /*
  * FONTSUBST_... --- constants for font substitutes
@@ -55,6 +95,72 @@ typedef struct FONTSUBST_ENTRY
 } FONTSUBST_ENTRY, *PFONTSUBST_ENTRY;
 
 
+/*
+ * FONT_CATALOG_... --- the font catalog remembers what loading each font
+ * file told us, so that the fonts listed in the registry can be registered
+ * at boot without opening them. Their faces are loaded on first use.
+ *
+ * The file is a FONT_CATALOG_HEADER followed by FileCount FONT_CATALOG_FILE
+ * records. Each of them is followed by its path and EntryCount
+ * FONT_CATALOG_FACE records. Strings are not NUL terminated and records
+ * are ULONG aligned.
+ */
+#define FONT_CATALOG_MAGIC      'TACF'
+#define FONT_CATALOG_VERSION    1
+
+typedef struct FONT_CATALOG_HEADER
+{
+    ULONG           Magic;
+    ULONG           Version;
+    ULONG           LanguageID;     /* Of the localized names */
+    ULONG           FileCount;
+    ULONG           DataSize;       /* Of the records after the header */
+    ULONG           Checksum;       /* FNV-1a of the records */
+} FONT_CATALOG_HEADER, *PFONT_CATALOG_HEADER;
+
+typedef struct FONT_CATALOG_FILE
+{
+    ULONG           Size;           /* Including the path and the faces */
+    ULONG           EntryCount;     /* FONT_ENTRYs created from the file */
+    LONG            FontCount;      /* What IntGdiLoadFontsFromMemory returned */
+    USHORT          PathLength;     /* In bytes */
+    USHORT          Reserved;
+    LARGE_INTEGER   LastWriteTime;
+    LARGE_INTEGER   FileSize;
+} FONT_CATALOG_FILE, *PFONT_CATALOG_FILE;
+
+/* Followed by the face, style, localized family and localized full names */
+#define FONT_CATALOG_FACE_NAME      0
+#define FONT_CATALOG_STYLE_NAME     1
+#define FONT_CATALOG_FAMILY_NAME    2
+#define FONT_CATALOG_FULL_NAME      3
+#define FONT_CATALOG_NAMES          4
+
+typedef struct FONT_CATALOG_FACE
+{
+    ULONG           Size;           /* Including the names */
+    LONG            FaceIndex;
+    LONG            OriginalWeight;
+    BYTE            OriginalItalic;
+    BYTE            CharSet;
+    USHORT          NameLength[FONT_CATALOG_NAMES];   /* In bytes */
+} FONT_CATALOG_FACE, *PFONT_CATALOG_FACE;
+
+/* State of the catalog while InitFontSupport loads the fonts */
+typedef struct FONT_CATALOG
+{
+    PBYTE           OldData;        /* Records read from the disk */
+    ULONG           OldSize;
+    ULONG           OldFileCount;
+    ULONG           OldOffset;      /* Where the next lookup starts */
+    PBYTE           NewData;        /* Records to write back */
+    ULONG           NewSize;
+    ULONG           NewMaxSize;
+    ULONG           NewFileCount;
+    ULONG           FileOffset;     /* Record being built, or MAXULONG */
+    BOOL            Dirty;
+} FONT_CATALOG, *PFONT_CATALOG;
+
 typedef struct GDI_LOAD_FONT
 {
     PUNICODE_STRING     pFileName;
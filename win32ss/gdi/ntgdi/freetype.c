@@ -59,22 +59,45 @@ static UNICODE_STRING g_FontRegPath =
     RTL_CONSTANT_STRING(L"\\REGISTRY\\Machine\\Software\\Microsoft\\Windows NT\\CurrentVersion\\Fonts");
 
 
-/* The FreeType library is not thread safe, so we have
-   to serialize access to it */
+/* The FreeType library is not thread safe, so we have to serialize
+   creation and destruction of faces and the reference counts of the
+   shared faces and memory. Operations on a single face (size, transform,
+   glyph loading, tables) are serialized by the lock of its SHARED_FACE. */
 static PFAST_MUTEX      g_FreeTypeLock;
 
 static LIST_ENTRY       g_FontListHead;
-static PFAST_MUTEX      g_FontListLock;
+static PERESOURCE       g_FontListLock;
 static BOOL             g_RenderingEnabled = TRUE;
 
+/* Indexes of the global font list, protected by g_FontListLock */
+#define FONT_INDEX_HASH_SIZE        256     /* Must be a power of two */
+static LIST_ENTRY       g_FontNameIndex[FONT_INDEX_HASH_SIZE];
+static LIST_ENTRY       g_FontCharSetIndex[256];
+static ULONG            g_FontListSequence;
+static BOOL             g_FontIndexIncomplete = FALSE;
+
+/* Font catalog, only used while InitFontSupport loads the fonts */
+#define MAX_FONT_CATALOG_SIZE       (16 * 1024 * 1024)
+static UNICODE_STRING   g_FontCatalogPath = RTL_CONSTANT_STRING(L"\\SystemRoot\\System32\\FontCat.dat");
+static PFONT_CATALOG    g_FontCatalog = NULL;
+
+/* Cache of global font list matches for recently realized LOGFONTs */
+#define MAX_FONT_REALIZATION_CACHE  64
+static LIST_ENTRY       g_FontRealizationListHead;
+static UINT             g_FontRealizationNumEntries;
+static PFAST_MUTEX      g_FontRealizationLock;
+
 #define IntLockGlobalFonts() \
-    ExEnterCriticalRegionAndAcquireFastMutexUnsafe(g_FontListLock)
+    ExEnterCriticalRegionAndAcquireResourceExclusive(g_FontListLock)
+
+#define IntLockGlobalFontsShared() \
+    ExEnterCriticalRegionAndAcquireResourceShared(g_FontListLock)
 
 #define IntUnLockGlobalFonts() \
-    ExReleaseFastMutexUnsafeAndLeaveCriticalRegion(g_FontListLock)
+    ExReleaseResourceAndLeaveCriticalRegion(g_FontListLock)
 
 #define ASSERT_GLOBALFONTS_LOCK_HELD() \
-    ASSERT(g_FontListLock->Owner == KeGetCurrentThread())
+    ASSERT(ExIsResourceAcquiredExclusiveLite(g_FontListLock))
 
 #define IntLockFreeType() \
     ExEnterCriticalRegionAndAcquireFastMutexUnsafe(g_FreeTypeLock)
@@ -88,10 +111,44 @@ static BOOL             g_RenderingEnabled = TRUE;
 #define ASSERT_FREETYPE_LOCK_NOT_HELD() \
     ASSERT(g_FreeTypeLock->Owner != KeGetCurrentThread())
 
-#define MAX_FONT_CACHE 256
+#define IntLockFace(SharedFace) \
+    ExEnterCriticalRegionAndAcquireFastMutexUnsafe((SharedFace)->Lock)
+
+#define IntUnLockFace(SharedFace) \
+    ExReleaseFastMutexUnsafeAndLeaveCriticalRegion((SharedFace)->Lock)
+
+#define ASSERT_FACE_LOCK_HELD(SharedFace) \
+    ASSERT((SharedFace)->Lock->Owner == KeGetCurrentThread())
+
+#define ASSERT_FACE_LOCK_NOT_HELD(SharedFace) \
+    ASSERT((SharedFace)->Lock->Owner != KeGetCurrentThread())
+
+/* Glyph cache: hash buckets for lookup, a CLOCK (second chance) list for
+   eviction and a chain per SHARED_FACE for invalidation. The cache is
+   bounded by the memory its bitmaps use rather than by the number of
+   entries. Lookups only take g_FontCacheLock shared; a cached glyph stays
+   valid for as long as the caller holds the lock of its face, because
+   entries of a face are only evicted while holding that lock too. */
+#define FONT_CACHE_HASH_SIZE        1024    /* Must be a power of two */
+#define FONT_CACHE_DEFAULT_SIZE     (1024 * 1024)
+#define FONT_CACHE_MIN_SIZE         (64 * 1024)
 
+static PERESOURCE g_FontCacheLock;
 static LIST_ENTRY g_FontCacheListHead;
-static UINT g_FontCacheNumEntries;
+static LIST_ENTRY g_FontCacheHashTable[FONT_CACHE_HASH_SIZE];
+static FONT_CACHE_STATS g_FontCacheStats;
+
+#define IntLockGlyphCache() \
+    ExEnterCriticalRegionAndAcquireResourceExclusive(g_FontCacheLock)
+
+#define IntLockGlyphCacheShared() \
+    ExEnterCriticalRegionAndAcquireResourceShared(g_FontCacheLock)
+
+#define IntUnLockGlyphCache() \
+    ExReleaseResourceAndLeaveCriticalRegion(g_FontCacheLock)
+
+#define ASSERT_GLYPHCACHE_LOCK_HELD() \
+    ASSERT(ExIsResourceAcquiredExclusiveLite(g_FontCacheLock))
 
 static PWCHAR g_ElfScripts[32] =   /* These are in the order of the fsCsb[0] bits */
 {
@@ -217,14 +274,29 @@ SharedFace_Create(FT_Face Face, PSHARED_MEM Memory)
     Ptr = ExAllocatePoolWithTag(PagedPool, sizeof(SHARED_FACE), TAG_FONT);
     if (Ptr)
     {
+        /* Fast Mutexes must be allocated from non paged pool */
+        Ptr->Lock = ExAllocatePoolWithTag(NonPagedPool, sizeof(FAST_MUTEX), TAG_INTERNAL_SYNC);
+        if (Ptr->Lock == NULL)
+        {
+            ExFreePoolWithTag(Ptr, TAG_FONT);
+            return NULL;
+        }
+        ExInitializeFastMutex(Ptr->Lock);
+
         Ptr->Face = Face;
         Ptr->RefCount = 1;
         Ptr->Memory = Memory;
+        Ptr->Filename = NULL;
+        Ptr->FaceIndex = (Face ? Face->face_index : 0);
         SharedFaceCache_Init(&Ptr->EnglishUS);
         SharedFaceCache_Init(&Ptr->UserLanguage);
+        InitializeListHead(&Ptr->GlyphCacheListHead);
 
-        SharedMem_AddRef(Memory);
-        DPRINT("Creating SharedFace for %s\n", Face->family_name ? Face->family_name : "<NULL>");
+        /* A deferred face gets its memory when it is loaded */
+        if (Memory)
+            SharedMem_AddRef(Memory);
+        DPRINT("Creating SharedFace for %s\n",
+               (Face && Face->family_name) ? Face->family_name : "<NULL>");
     }
     return Ptr;
 }
@@ -256,35 +328,35 @@ SharedFace_AddRef(PSHARED_FACE Ptr)
 static void
 RemoveCachedEntry(PFONT_CACHE_ENTRY Entry)
 {
-    ASSERT_FREETYPE_LOCK_HELD();
+    ASSERT_GLYPHCACHE_LOCK_HELD();
 
     FT_Done_Glyph((FT_Glyph)Entry->BitmapGlyph);
     RemoveEntryList(&Entry->ListEntry);
+    RemoveEntryList(&Entry->HashEntry);
+    RemoveEntryList(&Entry->FaceEntry);
+    ASSERT(g_FontCacheStats.NumEntries > 0);
+    ASSERT(g_FontCacheStats.CurrentSize >= Entry->CacheSize);
+    g_FontCacheStats.NumEntries--;
+    g_FontCacheStats.CurrentSize -= Entry->CacheSize;
     ExFreePoolWithTag(Entry, TAG_FONT);
-    g_FontCacheNumEntries--;
-    ASSERT(g_FontCacheNumEntries <= MAX_FONT_CACHE);
 }
 
 static void
-RemoveCacheEntries(FT_Face Face)
+RemoveCacheEntries(PSHARED_FACE SharedFace)
 {
-    PLIST_ENTRY CurrentEntry, NextEntry;
+    PLIST_ENTRY CurrentEntry;
     PFONT_CACHE_ENTRY FontEntry;
 
     ASSERT_FREETYPE_LOCK_HELD();
 
-    for (CurrentEntry = g_FontCacheListHead.Flink;
-         CurrentEntry != &g_FontCacheListHead;
-         CurrentEntry = NextEntry)
+    IntLockGlyphCache();
+    while (!IsListEmpty(&SharedFace->GlyphCacheListHead))
     {
-        FontEntry = CONTAINING_RECORD(CurrentEntry, FONT_CACHE_ENTRY, ListEntry);
-        NextEntry = CurrentEntry->Flink;
-
-        if (FontEntry->Face == Face)
-        {
-            RemoveCachedEntry(FontEntry);
-        }
+        CurrentEntry = SharedFace->GlyphCacheListHead.Flink;
+        FontEntry = CONTAINING_RECORD(CurrentEntry, FONT_CACHE_ENTRY, FaceEntry);
+        RemoveCachedEntry(FontEntry);
     }
+    IntUnLockGlyphCache();
 }
 
 static void SharedMem_Release(PSHARED_MEM Ptr)
@@ -326,12 +398,19 @@ SharedFace_Release(PSHARED_FACE Ptr)
     --Ptr->RefCount;
     if (Ptr->RefCount == 0)
     {
-        DPRINT("Releasing SharedFace for %s\n", Ptr->Face->family_name ? Ptr->Face->family_name : "<NULL>");
-        RemoveCacheEntries(Ptr->Face);
-        FT_Done_Face(Ptr->Face);
-        SharedMem_Release(Ptr->Memory);
+        DPRINT("Releasing SharedFace for %s\n",
+               (Ptr->Face && Ptr->Face->family_name) ? Ptr->Face->family_name : "<NULL>");
+        RemoveCacheEntries(Ptr);
+        if (Ptr->Face)
+        {
+            FT_Done_Face(Ptr->Face);
+            SharedMem_Release(Ptr->Memory);
+        }
+        if (Ptr->Filename)
+            ExFreePoolWithTag(Ptr->Filename, TAG_FONT);
         SharedFaceCache_Release(&Ptr->EnglishUS);
         SharedFaceCache_Release(&Ptr->UserLanguage);
+        ExFreePoolWithTag(Ptr->Lock, TAG_INTERNAL_SYNC);
         ExFreePoolWithTag(Ptr, TAG_FONT);
     }
     IntUnLockFreeType();
@@ -364,6 +443,146 @@ CleanupFontEntry(PFONT_ENTRY FontEntry)
     CleanupFontEntryEx(FontEntry, FontEntry->Font);
 }
 
+static ULONG
+IntFontNameHash(PCWSTR pszName, SIZE_T cchMax)
+{
+    ULONG Hash = 2166136261;
+    SIZE_T i;
+
+    /* Case-insensitive the same way as _wcsicmp, which GetFontPenalty uses */
+    for (i = 0; i < cchMax && pszName[i] != UNICODE_NULL; ++i)
+    {
+        Hash ^= towlower(pszName[i]);
+        Hash *= 16777619;
+    }
+    return Hash;
+}
+
+static BOOL
+IntAddFontIndexEntry(PLIST_ENTRY pHead, PFONT_ENTRY FontEntry, ULONG Hash)
+{
+    PFONT_INDEX_ENTRY IndexEntry;
+
+    IndexEntry = ExAllocatePoolWithTag(PagedPool, sizeof(FONT_INDEX_ENTRY), TAG_FONT);
+    if (!IndexEntry)
+        return FALSE;
+
+    IndexEntry->FontEntry = FontEntry;
+    IndexEntry->Hash = Hash;
+    InsertTailList(pHead, &IndexEntry->ListEntry);
+    return TRUE;
+}
+
+/*
+ * IntAddFontToIndex --- adds a global font entry to the name and charset
+ * indexes. The names must be the localized family and full names which
+ * GetFontPenalty compares against lfFaceName.
+ */
+static VOID
+IntAddFontToIndex(PFONT_ENTRY FontEntry, PCUNICODE_STRING FamilyName, PCUNICODE_STRING FullName)
+{
+    ULONG FamilyHash, FullHash;
+    BOOL bOK;
+
+    ASSERT_GLOBALFONTS_LOCK_HELD();
+
+    FontEntry->Sequence = g_FontListSequence++;
+
+    FamilyHash = IntFontNameHash(FamilyName->Buffer, FamilyName->Length / sizeof(WCHAR));
+    FullHash = IntFontNameHash(FullName->Buffer, FullName->Length / sizeof(WCHAR));
+
+    bOK = IntAddFontIndexEntry(&g_FontNameIndex[FamilyHash & (FONT_INDEX_HASH_SIZE - 1)],
+                               FontEntry, FamilyHash);
+    if (bOK && FullHash != FamilyHash)
+    {
+        bOK = IntAddFontIndexEntry(&g_FontNameIndex[FullHash & (FONT_INDEX_HASH_SIZE - 1)],
+                                   FontEntry, FullHash);
+    }
+    if (bOK)
+    {
+        bOK = IntAddFontIndexEntry(&g_FontCharSetIndex[FontEntry->Font->CharSet],
+                                   FontEntry, FontEntry->Font->CharSet);
+    }
+
+    if (!bOK)
+    {
+        /* The mapper can no longer trust the index */
+        DPRINT1("Failed to index font '%wZ'\n", &FontEntry->FaceName);
+        g_FontIndexIncomplete = TRUE;
+    }
+}
+
+static VOID
+IntClearFontRealizationCache(VOID)
+{
+    PLIST_ENTRY ListEntry;
+    PFONT_REALIZATION_ENTRY Entry;
+
+    ExEnterCriticalRegionAndAcquireFastMutexUnsafe(g_FontRealizationLock);
+    while (!IsListEmpty(&g_FontRealizationListHead))
+    {
+        ListEntry = RemoveHeadList(&g_FontRealizationListHead);
+        Entry = CONTAINING_RECORD(ListEntry, FONT_REALIZATION_ENTRY, ListEntry);
+        ExFreePoolWithTag(Entry, TAG_FONT);
+    }
+    g_FontRealizationNumEntries = 0;
+    ExReleaseFastMutexUnsafeAndLeaveCriticalRegion(g_FontRealizationLock);
+}
+
+static BOOL
+IntFindFontRealization(const LOGFONTW *LogFont, FONTOBJ **FontObj, ULONG *MatchPenalty)
+{
+    PLIST_ENTRY ListEntry;
+    PFONT_REALIZATION_ENTRY Entry;
+    BOOL Found = FALSE;
+
+    ExEnterCriticalRegionAndAcquireFastMutexUnsafe(g_FontRealizationLock);
+    for (ListEntry = g_FontRealizationListHead.Flink;
+         ListEntry != &g_FontRealizationListHead;
+         ListEntry = ListEntry->Flink)
+    {
+        Entry = CONTAINING_RECORD(ListEntry, FONT_REALIZATION_ENTRY, ListEntry);
+        if (RtlEqualMemory(&Entry->LogFont, LogFont, sizeof(LOGFONTW)))
+        {
+            *FontObj = Entry->FontObj;
+            *MatchPenalty = Entry->MatchPenalty;
+
+            RemoveEntryList(&Entry->ListEntry);
+            InsertHeadList(&g_FontRealizationListHead, &Entry->ListEntry);
+            Found = TRUE;
+            break;
+        }
+    }
+    ExReleaseFastMutexUnsafeAndLeaveCriticalRegion(g_FontRealizationLock);
+
+    return Found;
+}
+
+static VOID
+IntAddFontRealization(const LOGFONTW *LogFont, FONTOBJ *FontObj, ULONG MatchPenalty)
+{
+    PFONT_REALIZATION_ENTRY Entry;
+
+    Entry = ExAllocatePoolWithTag(PagedPool, sizeof(FONT_REALIZATION_ENTRY), TAG_FONT);
+    if (!Entry)
+        return;
+
+    Entry->LogFont = *LogFont;
+    Entry->FontObj = FontObj;
+    Entry->MatchPenalty = MatchPenalty;
+
+    ExEnterCriticalRegionAndAcquireFastMutexUnsafe(g_FontRealizationLock);
+    InsertHeadList(&g_FontRealizationListHead, &Entry->ListEntry);
+    if (++g_FontRealizationNumEntries > MAX_FONT_REALIZATION_CACHE)
+    {
+        Entry = CONTAINING_RECORD(RemoveTailList(&g_FontRealizationListHead),
+                                  FONT_REALIZATION_ENTRY, ListEntry);
+        ExFreePoolWithTag(Entry, TAG_FONT);
+        g_FontRealizationNumEntries--;
+    }
+    ExReleaseFastMutexUnsafeAndLeaveCriticalRegion(g_FontRealizationLock);
+}
+
 
 static __inline void FTVectorToPOINTFX(FT_Vector *vec, POINTFX *pt)
 {
@@ -487,7 +706,7 @@ VOID DumpPrivateFontList(BOOL bDoLock)
 VOID DumpGlobalFontList(BOOL bDoLock)
 {
     if (bDoLock)
-        IntLockGlobalFonts();
+        IntLockGlobalFontsShared();
 
     DumpFontList(&g_FontListHead);
 
@@ -495,11 +714,24 @@ VOID DumpGlobalFontList(BOOL bDoLock)
         IntUnLockGlobalFonts();
 }
 
+VOID DumpGlyphCacheStats(VOID)
+{
+    DPRINT("## DumpGlyphCacheStats: %lu hits, %lu misses, %lu evictions, "
+           "%lu entries, %Iu of %Iu bytes\n",
+           g_FontCacheStats.Hits,
+           g_FontCacheStats.Misses,
+           g_FontCacheStats.Evictions,
+           g_FontCacheStats.NumEntries,
+           g_FontCacheStats.CurrentSize,
+           g_FontCacheStats.MaxSize);
+}
+
 VOID DumpFontInfo(BOOL bDoLock)
 {
     DumpGlobalFontList(bDoLock);
     DumpPrivateFontList(bDoLock);
     DumpFontSubstList();
+    DumpGlyphCacheStats();
 }
 #endif
 
@@ -656,22 +888,95 @@ IntLoadFontSubstList(PLIST_ENTRY pHead)
     return NT_SUCCESS(Status);
 }
 
+/*
+ * IntInitGlyphCache --- initializes the glyph cache and reads its size limit
+ * (in KB) from the GRE_Initialize key, if present.
+ */
+static BOOL FASTCALL
+IntInitGlyphCache(VOID)
+{
+    NTSTATUS Status;
+    HKEY hKey;
+    DWORD dwValue;
+    ULONG i;
+
+    /* ERESOURCEs must be allocated from non paged pool */
+    g_FontCacheLock = ExAllocatePoolWithTag(NonPagedPool, sizeof(ERESOURCE), TAG_INTERNAL_SYNC);
+    if (g_FontCacheLock == NULL)
+    {
+        return FALSE;
+    }
+    ExInitializeResourceLite(g_FontCacheLock);
+
+    InitializeListHead(&g_FontCacheListHead);
+    for (i = 0; i < FONT_CACHE_HASH_SIZE; ++i)
+    {
+        InitializeListHead(&g_FontCacheHashTable[i]);
+    }
+
+    RtlZeroMemory(&g_FontCacheStats, sizeof(g_FontCacheStats));
+    g_FontCacheStats.MaxSize = FONT_CACHE_DEFAULT_SIZE;
+
+    Status = RegOpenKey(L"\\Registry\\Machine\\Software\\Microsoft\\Windows NT\\CurrentVersion\\GRE_Initialize",
+                        &hKey);
+    if (NT_SUCCESS(Status))
+    {
+        if (RegReadDWORD(hKey, L"GlyphCacheSize", &dwValue) && dwValue != 0)
+        {
+            g_FontCacheStats.MaxSize = max((SIZE_T)dwValue * 1024, FONT_CACHE_MIN_SIZE);
+        }
+        ZwClose(hKey);
+    }
+
+    return TRUE;
+}
+
+static PFONT_CATALOG
+IntOpenFontCatalog(VOID);
+
+static VOID
+IntCloseFontCatalog(PFONT_CATALOG Catalog);
+
 BOOL FASTCALL
 InitFontSupport(VOID)
 {
     ULONG ulError;
+    ULONG i;
 
     InitializeListHead(&g_FontListHead);
-    InitializeListHead(&g_FontCacheListHead);
-    g_FontCacheNumEntries = 0;
+    for (i = 0; i < FONT_INDEX_HASH_SIZE; ++i)
+    {
+        InitializeListHead(&g_FontNameIndex[i]);
+    }
+    for (i = 0; i < _countof(g_FontCharSetIndex); ++i)
+    {
+        InitializeListHead(&g_FontCharSetIndex[i]);
+    }
+
+    InitializeListHead(&g_FontRealizationListHead);
+    g_FontRealizationNumEntries = 0;
     /* Fast Mutexes must be allocated from non paged pool */
-    g_FontListLock = ExAllocatePoolWithTag(NonPagedPool, sizeof(FAST_MUTEX), TAG_INTERNAL_SYNC);
+    g_FontRealizationLock = ExAllocatePoolWithTag(NonPagedPool, sizeof(FAST_MUTEX), TAG_INTERNAL_SYNC);
+    if (g_FontRealizationLock == NULL)
+    {
+        return FALSE;
+    }
+    ExInitializeFastMutex(g_FontRealizationLock);
+
+    if (!IntInitGlyphCache())
+    {
+        return FALSE;
+    }
+
+    /* ERESOURCEs must be allocated from non paged pool */
+    g_FontListLock = ExAllocatePoolWithTag(NonPagedPool, sizeof(ERESOURCE), TAG_INTERNAL_SYNC);
     if (g_FontListLock == NULL)
     {
         return FALSE;
     }
+    ExInitializeResourceLite(g_FontListLock);
 
-    ExInitializeFastMutex(g_FontListLock);
+    /* Fast Mutexes must be allocated from non paged pool */
     g_FreeTypeLock = ExAllocatePoolWithTag(NonPagedPool, sizeof(FAST_MUTEX), TAG_INTERNAL_SYNC);
     if (g_FreeTypeLock == NULL)
     {
@@ -686,6 +991,10 @@ InitFontSupport(VOID)
         return FALSE;
     }
 
+    /* The fonts listed in the registry are registered from the catalog
+       when possible; the others are loaded and added to the catalog */
+    g_FontCatalog = IntOpenFontCatalog();
+
     if (!IntLoadFontsInRegistry())
     {
         DPRINT1("Fonts registry is empty.\n");
@@ -694,6 +1003,12 @@ InitFontSupport(VOID)
         IntLoadSystemFonts();
     }
 
+    if (g_FontCatalog)
+    {
+        IntCloseFontCatalog(g_FontCatalog);
+        g_FontCatalog = NULL;
+    }
+
     IntLoadFontSubstList(&g_FontSubstListHead);
 
 #if DBG
@@ -714,7 +1029,7 @@ LONG FASTCALL IntWidthMatrix(FT_Face face, FT_Matrix *pmat, LONG lfWidth)
     if (lfWidth == 0)
         return 0;
 
-    ASSERT_FREETYPE_LOCK_HELD();
+    /* The caller holds the lock of the face */
     pOS2 = (TT_OS2 *)FT_Get_Sfnt_Table(face, FT_SFNT_OS2);
     if (!pOS2)
         return 0;
@@ -1046,85 +1361,782 @@ IntLoadSystemFonts(VOID)
 static FT_Error
 IntRequestFontSize(PDC dc, PFONTGDI FontGDI, LONG lfWidth, LONG lfHeight);
 
-/* NOTE: If nIndex < 0 then return the number of charsets. */
-UINT FASTCALL IntGetCharSet(INT nIndex, FT_ULong CodePageRange1)
+static NTSTATUS
+IntGetFontLocalizedName(PUNICODE_STRING pNameW, PSHARED_FACE SharedFace,
+                        FT_UShort NameID, FT_UShort LangID);
+
+/*
+ * Font catalog
+ */
+
+static NTSTATUS
+IntMapFontFile(PUNICODE_STRING PathName, PVOID *pBuffer, SIZE_T *pViewSize)
 {
-    UINT BitIndex, CharSet;
-    UINT nCount = 0;
+    NTSTATUS Status;
+    HANDLE FileHandle;
+    IO_STATUS_BLOCK Iosb;
+    OBJECT_ATTRIBUTES ObjectAttributes;
+    PFILE_OBJECT FileObject;
+    PVOID SectionObject;
+    LARGE_INTEGER SectionSize;
 
-    if (CodePageRange1 == 0)
+    *pBuffer = NULL;
+    *pViewSize = 0;
+
+    /* Open the font file */
+    InitializeObjectAttributes(&ObjectAttributes, PathName,
+                               OBJ_KERNEL_HANDLE | OBJ_CASE_INSENSITIVE, NULL, NULL);
+    Status = ZwOpenFile(
+                 &FileHandle,
+                 FILE_GENERIC_READ | SYNCHRONIZE,
+                 &ObjectAttributes,
+                 &Iosb,
+                 FILE_SHARE_READ,
+                 FILE_SYNCHRONOUS_IO_NONALERT);
+    if (!NT_SUCCESS(Status))
     {
-        return (nIndex < 0) ? 1 : DEFAULT_CHARSET;
+        DPRINT1("Could not load font file: %wZ\n", PathName);
+        return Status;
     }
 
-    for (BitIndex = 0; BitIndex < MAXTCIINDEX; ++BitIndex)
+    Status = ObReferenceObjectByHandle(FileHandle, FILE_READ_DATA, NULL,
+                                       KernelMode, (PVOID*)&FileObject, NULL);
+    if (!NT_SUCCESS(Status))
     {
-        if (CodePageRange1 & (1 << BitIndex))
-        {
-            CharSet = g_FontTci[BitIndex].ciCharset;
-            if ((nIndex >= 0) && (nCount == (UINT)nIndex))
-            {
-                return CharSet;
-            }
-            ++nCount;
-        }
+        DPRINT1("ObReferenceObjectByHandle failed.\n");
+        ZwClose(FileHandle);
+        return Status;
     }
 
-    return (nIndex < 0) ? nCount : ANSI_CHARSET;
-}
+    SectionSize.QuadPart = 0LL;
+    Status = MmCreateSection(&SectionObject,
+                             STANDARD_RIGHTS_REQUIRED | SECTION_QUERY | SECTION_MAP_READ,
+                             NULL, &SectionSize, PAGE_READONLY,
+                             SEC_COMMIT, FileHandle, FileObject);
+    ZwClose(FileHandle);
+    if (!NT_SUCCESS(Status))
+    {
+        DPRINT1("Could not map file: %wZ\n", PathName);
+        ObDereferenceObject(FileObject);
+        return Status;
+    }
 
-/* pixels to points */
-#define PX2PT(pixels) FT_MulDiv((pixels), 72, 96)
+    Status = MmMapViewInSystemSpace(SectionObject, pBuffer, pViewSize);
+    if (!NT_SUCCESS(Status))
+        DPRINT1("Could not map file: %wZ\n", PathName);
 
-static INT FASTCALL
-IntGdiLoadFontsFromMemory(PGDI_LOAD_FONT pLoadFont,
-                          PSHARED_FACE SharedFace, FT_Long FontIndex, INT CharSetIndex)
+    ObDereferenceObject(SectionObject);
+    ObDereferenceObject(FileObject);
+    return Status;
+}
+
+static ULONG
+IntFontCatalogChecksum(const BYTE *pb, ULONG cb)
 {
-    FT_Error            Error;
-    PFONT_ENTRY         Entry;
-    FONT_ENTRY_MEM*     PrivateEntry = NULL;
-    FONTGDI *           FontGDI;
-    NTSTATUS            Status;
-    FT_Face             Face;
-    ANSI_STRING         AnsiString;
-    FT_WinFNT_HeaderRec WinFNT;
-    INT                 FaceCount = 0, CharSetCount = 0;
-    PUNICODE_STRING     pFileName       = pLoadFont->pFileName;
-    DWORD               Characteristics = pLoadFont->Characteristics;
-    PUNICODE_STRING     pValueName = &pLoadFont->RegValueName;
-    TT_OS2 *            pOS2;
-    INT                 BitIndex;
-    FT_UShort           os2_version;
-    FT_ULong            os2_ulCodePageRange1;
-    FT_UShort           os2_usWeightClass;
+    ULONG Hash = 2166136261;
+    ULONG i;
 
-    if (SharedFace == NULL && CharSetIndex == -1)
+    for (i = 0; i < cb; ++i)
     {
-        /* load a face from memory */
-        IntLockFreeType();
-        Error = FT_New_Memory_Face(
-                    g_FreeTypeLibrary,
-                    pLoadFont->Memory->Buffer,
-                    pLoadFont->Memory->BufferSize,
-                    ((FontIndex != -1) ? FontIndex : 0),
-                    &Face);
+        Hash ^= pb[i];
+        Hash *= 16777619;
+    }
+    return Hash;
+}
 
-        if (!Error)
-            SharedFace = SharedFace_Create(Face, pLoadFont->Memory);
+static __inline PFONT_CATALOG_FACE
+IntFirstCatalogFace(PFONT_CATALOG_FILE File)
+{
+    return (PFONT_CATALOG_FACE)((PBYTE)(File + 1) + ALIGN_UP_BY(File->PathLength, sizeof(ULONG)));
+}
 
-        IntUnLockFreeType();
+static __inline PFONT_CATALOG_FACE
+IntNextCatalogFace(PFONT_CATALOG_FACE Face)
+{
+    return (PFONT_CATALOG_FACE)((PBYTE)Face + Face->Size);
+}
 
-        if (!Error && FT_IS_SFNT(Face))
-            pLoadFont->IsTrueType = TRUE;
+static VOID
+IntGetCatalogName(PFONT_CATALOG_FACE Face, UINT iName, PUNICODE_STRING pName)
+{
+    PBYTE pb = (PBYTE)(Face + 1);
+    UINT i;
 
-        if (Error || SharedFace == NULL)
-        {
-            if (SharedFace)
-                SharedFace_Release(SharedFace);
+    for (i = 0; i < iName; ++i)
+        pb += Face->NameLength[i];
 
-            if (Error == FT_Err_Unknown_File_Format)
-                DPRINT1("Unknown font file format\n");
-            else
+    pName->Buffer = (PWSTR)pb;
+    pName->Length = pName->MaximumLength = Face->NameLength[iName];
+}
+
+/* Makes a NUL terminated copy, like RtlAnsiStringToUnicodeString does */
+static NTSTATUS
+IntCreateCatalogName(PFONT_CATALOG_FACE Face, UINT iName, PUNICODE_STRING pName)
+{
+    UNICODE_STRING Name;
+
+    IntGetCatalogName(Face, iName, &Name);
+    pName->Buffer = ExAllocatePoolWithTag(PagedPool, Name.Length + sizeof(UNICODE_NULL), TAG_USTR);
+    if (!pName->Buffer)
+        return STATUS_NO_MEMORY;
+
+    RtlCopyMemory(pName->Buffer, Name.Buffer, Name.Length);
+    pName->Buffer[Name.Length / sizeof(WCHAR)] = UNICODE_NULL;
+    pName->Length = Name.Length;
+    pName->MaximumLength = Name.Length + sizeof(UNICODE_NULL);
+    return STATUS_SUCCESS;
+}
+
+/* Checks the sizes of all records once, so that the lookups can trust them */
+static BOOL
+IntValidateFontCatalog(PBYTE pData, ULONG cbData, ULONG FileCount)
+{
+    PFONT_CATALOG_FILE File;
+    PFONT_CATALOG_FACE Face;
+    ULONG Offset = 0, FaceOffset, cbNames, i, j;
+
+    for (i = 0; i < FileCount; ++i)
+    {
+        if (cbData - Offset < sizeof(FONT_CATALOG_FILE))
+            return FALSE;
+
+        File = (PFONT_CATALOG_FILE)(pData + Offset);
+        if (File->Size < sizeof(FONT_CATALOG_FILE) || File->Size > cbData - Offset ||
+            (File->Size % sizeof(ULONG)) != 0 || (File->PathLength % sizeof(WCHAR)) != 0 ||
+            sizeof(FONT_CATALOG_FILE) + ALIGN_UP_BY(File->PathLength, sizeof(ULONG)) > File->Size)
+        {
+            return FALSE;
+        }
+
+        FaceOffset = sizeof(FONT_CATALOG_FILE) + ALIGN_UP_BY(File->PathLength, sizeof(ULONG));
+        for (j = 0; j < File->EntryCount; ++j)
+        {
+            if (File->Size - FaceOffset < sizeof(FONT_CATALOG_FACE))
+                return FALSE;
+
+            Face = (PFONT_CATALOG_FACE)((PBYTE)File + FaceOffset);
+            cbNames = Face->NameLength[0] + Face->NameLength[1] +
+                      Face->NameLength[2] + Face->NameLength[3];
+            if (Face->Size < sizeof(FONT_CATALOG_FACE) + cbNames ||
+                Face->Size > File->Size - FaceOffset || (Face->Size % sizeof(ULONG)) != 0 ||
+                (cbNames % sizeof(WCHAR)) != 0 || Face->NameLength[FONT_CATALOG_FACE_NAME] == 0)
+            {
+                return FALSE;
+            }
+            FaceOffset += Face->Size;
+        }
+
+        if (FaceOffset != File->Size)
+            return FALSE;
+
+        Offset += File->Size;
+    }
+
+    return (Offset == cbData);
+}
+
+static PFONT_CATALOG
+IntOpenFontCatalog(VOID)
+{
+    PFONT_CATALOG Catalog;
+    FONT_CATALOG_HEADER Header;
+    FILE_STANDARD_INFORMATION FileInfo;
+    OBJECT_ATTRIBUTES ObjectAttributes;
+    IO_STATUS_BLOCK Iosb;
+    HANDLE FileHandle;
+    NTSTATUS Status;
+    PBYTE pData = NULL;
+
+    Catalog = ExAllocatePoolWithTag(PagedPool, sizeof(FONT_CATALOG), TAG_FONT);
+    if (!Catalog)
+        return NULL;
+
+    RtlZeroMemory(Catalog, sizeof(FONT_CATALOG));
+    Catalog->FileOffset = MAXULONG;
+
+    InitializeObjectAttributes(&ObjectAttributes, &g_FontCatalogPath,
+                               OBJ_KERNEL_HANDLE | OBJ_CASE_INSENSITIVE, NULL, NULL);
+    Status = ZwOpenFile(&FileHandle, FILE_GENERIC_READ | SYNCHRONIZE, &ObjectAttributes,
+                        &Iosb, FILE_SHARE_READ, FILE_SYNCHRONOUS_IO_NONALERT);
+    if (!NT_SUCCESS(Status))
+    {
+        DPRINT("No font catalog (0x%08lx)\n", Status);
+        return Catalog;
+    }
+
+    Status = ZwQueryInformationFile(FileHandle, &Iosb, &FileInfo, sizeof(FileInfo),
+                                    FileStandardInformation);
+    if (!NT_SUCCESS(Status) ||
+        FileInfo.EndOfFile.QuadPart < sizeof(Header) ||
+        FileInfo.EndOfFile.QuadPart > MAX_FONT_CATALOG_SIZE)
+    {
+        goto Invalid;
+    }
+
+    Status = ZwReadFile(FileHandle, NULL, NULL, NULL, &Iosb, &Header, sizeof(Header), NULL, NULL);
+    if (!NT_SUCCESS(Status) || Iosb.Information != sizeof(Header) ||
+        Header.Magic != FONT_CATALOG_MAGIC || Header.Version != FONT_CATALOG_VERSION ||
+        Header.LanguageID != gusLanguageID ||
+        Header.DataSize != FileInfo.EndOfFile.QuadPart - sizeof(Header))
+    {
+        goto Invalid;
+    }
+
+    if (Header.DataSize != 0)
+    {
+        pData = ExAllocatePoolWithTag(PagedPool, Header.DataSize, TAG_FONT);
+        if (!pData)
+            goto Invalid;
+
+        Status = ZwReadFile(FileHandle, NULL, NULL, NULL, &Iosb, pData, Header.DataSize, NULL, NULL);
+        if (!NT_SUCCESS(Status) || Iosb.Information != Header.DataSize ||
+            IntFontCatalogChecksum(pData, Header.DataSize) != Header.Checksum ||
+            !IntValidateFontCatalog(pData, Header.DataSize, Header.FileCount))
+        {
+            goto Invalid;
+        }
+    }
+
+    ZwClose(FileHandle);
+    Catalog->OldData = pData;
+    Catalog->OldSize = Header.DataSize;
+    Catalog->OldFileCount = Header.FileCount;
+    return Catalog;
+
+Invalid:
+    DPRINT1("Ignoring invalid or outdated font catalog\n");
+    if (pData)
+        ExFreePoolWithTag(pData, TAG_FONT);
+    ZwClose(FileHandle);
+    Catalog->Dirty = TRUE;
+    return Catalog;
+}
+
+static VOID
+IntSaveFontCatalog(PFONT_CATALOG Catalog)
+{
+    FONT_CATALOG_HEADER Header;
+    OBJECT_ATTRIBUTES ObjectAttributes;
+    IO_STATUS_BLOCK Iosb;
+    LARGE_INTEGER Offset;
+    HANDLE FileHandle;
+    NTSTATUS Status;
+
+    Header.Magic = FONT_CATALOG_MAGIC;
+    Header.Version = FONT_CATALOG_VERSION;
+    Header.LanguageID = gusLanguageID;
+    Header.FileCount = Catalog->NewFileCount;
+    Header.DataSize = Catalog->NewSize;
+    Header.Checksum = IntFontCatalogChecksum(Catalog->NewData, Catalog->NewSize);
+
+    InitializeObjectAttributes(&ObjectAttributes, &g_FontCatalogPath,
+                               OBJ_KERNEL_HANDLE | OBJ_CASE_INSENSITIVE, NULL, NULL);
+    Status = ZwCreateFile(&FileHandle, FILE_GENERIC_WRITE | SYNCHRONIZE, &ObjectAttributes,
+                          &Iosb, NULL, FILE_ATTRIBUTE_NORMAL, 0, FILE_OVERWRITE_IF,
+                          FILE_NON_DIRECTORY_FILE | FILE_SYNCHRONOUS_IO_NONALERT, NULL, 0);
+    if (!NT_SUCCESS(Status))
+    {
+        DPRINT1("Could not create the font catalog: 0x%08lx\n", Status);
+        return;
+    }
+
+    Status = ZwWriteFile(FileHandle, NULL, NULL, NULL, &Iosb, &Header, sizeof(Header), NULL, NULL);
+    if (NT_SUCCESS(Status) && Catalog->NewSize != 0)
+    {
+        Status = ZwWriteFile(FileHandle, NULL, NULL, NULL, &Iosb,
+                             Catalog->NewData, Catalog->NewSize, NULL, NULL);
+    }
+    if (!NT_SUCCESS(Status))
+    {
+        /* Make sure a partial catalog will not be trusted */
+        Offset.QuadPart = 0;
+        Header.Magic = 0;
+        ZwWriteFile(FileHandle, NULL, NULL, NULL, &Iosb, &Header, sizeof(Header), &Offset, NULL);
+        DPRINT1("Could not write the font catalog: 0x%08lx\n", Status);
+    }
+
+    ZwClose(FileHandle);
+}
+
+static VOID
+IntCloseFontCatalog(PFONT_CATALOG Catalog)
+{
+    /* Drop an unfinished record */
+    if (Catalog->FileOffset != MAXULONG)
+        Catalog->NewSize = Catalog->FileOffset;
+
+    /* Write it back if a file was added, changed or removed */
+    if (Catalog->Dirty || Catalog->NewFileCount != Catalog->OldFileCount)
+        IntSaveFontCatalog(Catalog);
+
+    if (Catalog->OldData)
+        ExFreePoolWithTag(Catalog->OldData, TAG_FONT);
+    if (Catalog->NewData)
+        ExFreePoolWithTag(Catalog->NewData, TAG_FONT);
+    ExFreePoolWithTag(Catalog, TAG_FONT);
+}
+
+static PVOID
+IntReserveCatalogData(PFONT_CATALOG Catalog, ULONG Size)
+{
+    PBYTE NewData;
+    ULONG NewMaxSize;
+
+    if (Catalog->NewMaxSize - Catalog->NewSize < Size)
+    {
+        NewMaxSize = max(Catalog->NewMaxSize * 2, Catalog->NewSize + Size);
+        NewMaxSize = max(NewMaxSize, PAGE_SIZE);
+        if (NewMaxSize > MAX_FONT_CATALOG_SIZE)
+            return NULL;
+
+        NewData = ExAllocatePoolWithTag(PagedPool, NewMaxSize, TAG_FONT);
+        if (!NewData)
+            return NULL;
+
+        if (Catalog->NewData)
+        {
+            RtlCopyMemory(NewData, Catalog->NewData, Catalog->NewSize);
+            ExFreePoolWithTag(Catalog->NewData, TAG_FONT);
+        }
+        Catalog->NewData = NewData;
+        Catalog->NewMaxSize = NewMaxSize;
+    }
+
+    NewData = Catalog->NewData + Catalog->NewSize;
+    RtlZeroMemory(NewData, Size);
+    Catalog->NewSize += Size;
+    return NewData;
+}
+
+static PFONT_CATALOG_FILE
+IntFindCatalogFile(PFONT_CATALOG Catalog, PUNICODE_STRING PathName,
+                   PFILE_NETWORK_OPEN_INFORMATION FileInfo)
+{
+    PFONT_CATALOG_FILE File;
+    UNICODE_STRING FilePath;
+    ULONG Offset, i;
+
+    /* The registry lists the fonts in the same order every boot, so
+       the record after the previous match is almost always the one */
+    Offset = Catalog->OldOffset;
+    for (i = 0; i < Catalog->OldFileCount; ++i)
+    {
+        if (Offset >= Catalog->OldSize)
+            Offset = 0;
+
+        File = (PFONT_CATALOG_FILE)(Catalog->OldData + Offset);
+        Offset += File->Size;
+
+        FilePath.Buffer = (PWSTR)(File + 1);
+        FilePath.Length = FilePath.MaximumLength = File->PathLength;
+        if (!RtlEqualUnicodeString(&FilePath, PathName, TRUE))
+            continue;
+
+        Catalog->OldOffset = Offset;
+        if (File->LastWriteTime.QuadPart != FileInfo->LastWriteTime.QuadPart ||
+            File->FileSize.QuadPart != FileInfo->EndOfFile.QuadPart)
+        {
+            DPRINT("Font file changed: %wZ\n", PathName);
+            return NULL;
+        }
+        return File;
+    }
+
+    return NULL;
+}
+
+static VOID
+IntBeginCatalogFile(PFONT_CATALOG Catalog, PUNICODE_STRING PathName,
+                    PFILE_NETWORK_OPEN_INFORMATION FileInfo)
+{
+    PFONT_CATALOG_FILE File;
+    ULONG Offset = Catalog->NewSize;
+
+    /* Drop an unfinished record */
+    if (Catalog->FileOffset != MAXULONG)
+        Catalog->NewSize = Offset = Catalog->FileOffset;
+
+    Catalog->Dirty = TRUE;
+    Catalog->FileOffset = MAXULONG;
+
+    File = IntReserveCatalogData(Catalog, sizeof(FONT_CATALOG_FILE) +
+                                          ALIGN_UP_BY(PathName->Length, sizeof(ULONG)));
+    if (!File)
+        return;
+
+    File->PathLength = PathName->Length;
+    File->LastWriteTime = FileInfo->LastWriteTime;
+    File->FileSize = FileInfo->EndOfFile;
+    RtlCopyMemory(File + 1, PathName->Buffer, PathName->Length);
+    Catalog->FileOffset = Offset;
+}
+
+static VOID
+IntAddCatalogFace(PFONT_CATALOG Catalog, PFONT_ENTRY Entry, FT_Long FaceIndex,
+                  PCUNICODE_STRING FamilyName, PCUNICODE_STRING FullName)
+{
+    PCUNICODE_STRING Names[FONT_CATALOG_NAMES];
+    PFONT_CATALOG_FACE Face;
+    PBYTE pb;
+    ULONG Size;
+    UINT i;
+
+    if (Catalog->FileOffset == MAXULONG)
+        return;
+
+    Names[FONT_CATALOG_FACE_NAME] = &Entry->FaceName;
+    Names[FONT_CATALOG_STYLE_NAME] = &Entry->StyleName;
+    Names[FONT_CATALOG_FAMILY_NAME] = FamilyName;
+    Names[FONT_CATALOG_FULL_NAME] = FullName;
+
+    Size = sizeof(FONT_CATALOG_FACE);
+    for (i = 0; i < FONT_CATALOG_NAMES; ++i)
+        Size += Names[i]->Length;
+
+    Face = IntReserveCatalogData(Catalog, ALIGN_UP_BY(Size, sizeof(ULONG)));
+    if (!Face)
+    {
+        /* Do not remember a file with missing faces */
+        Catalog->NewSize = Catalog->FileOffset;
+        Catalog->FileOffset = MAXULONG;
+        return;
+    }
+
+    Face->Size = ALIGN_UP_BY(Size, sizeof(ULONG));
+    Face->FaceIndex = FaceIndex;
+    Face->OriginalWeight = Entry->Font->OriginalWeight;
+    Face->OriginalItalic = Entry->Font->OriginalItalic;
+    Face->CharSet = Entry->Font->CharSet;
+
+    pb = (PBYTE)(Face + 1);
+    for (i = 0; i < FONT_CATALOG_NAMES; ++i)
+    {
+        Face->NameLength[i] = Names[i]->Length;
+        RtlCopyMemory(pb, Names[i]->Buffer, Names[i]->Length);
+        pb += Names[i]->Length;
+    }
+
+    ((PFONT_CATALOG_FILE)(Catalog->NewData + Catalog->FileOffset))->EntryCount++;
+}
+
+static VOID
+IntEndCatalogFile(PFONT_CATALOG Catalog, INT FontCount)
+{
+    PFONT_CATALOG_FILE File;
+
+    if (Catalog->FileOffset == MAXULONG)
+        return;
+
+    File = (PFONT_CATALOG_FILE)(Catalog->NewData + Catalog->FileOffset);
+    if (FontCount > 0 && File->EntryCount > 0)
+    {
+        File->Size = Catalog->NewSize - Catalog->FileOffset;
+        File->FontCount = FontCount;
+        Catalog->NewFileCount++;
+    }
+    else
+    {
+        Catalog->NewSize = Catalog->FileOffset;
+    }
+    Catalog->FileOffset = MAXULONG;
+}
+
+static PSHARED_FACE
+IntCreateDeferredFace(PUNICODE_STRING PathName, FT_Long FaceIndex)
+{
+    PSHARED_FACE SharedFace;
+
+    SharedFace = SharedFace_Create(NULL, NULL);
+    if (!SharedFace)
+        return NULL;
+
+    SharedFace->Filename = ExAllocatePoolWithTag(PagedPool,
+                                                 PathName->Length + sizeof(UNICODE_NULL),
+                                                 TAG_FONT);
+    if (!SharedFace->Filename)
+    {
+        SharedFace_Release(SharedFace);
+        return NULL;
+    }
+
+    RtlCopyMemory(SharedFace->Filename, PathName->Buffer, PathName->Length);
+    SharedFace->Filename[PathName->Length / sizeof(WCHAR)] = UNICODE_NULL;
+    SharedFace->FaceIndex = FaceIndex;
+    return SharedFace;
+}
+
+/*
+ * IntLoadFontsFromCatalog
+ *
+ * Registers the faces of a font file the way IntGdiLoadFontsFromMemory
+ * did when the catalog was written, without opening the file.
+ */
+static INT
+IntLoadFontsFromCatalog(PFONT_CATALOG Catalog, PUNICODE_STRING PathName,
+                        PFILE_NETWORK_OPEN_INFORMATION FileInfo, DWORD Characteristics)
+{
+    PFONT_CATALOG_FILE File, NewFile;
+    PFONT_CATALOG_FACE Face;
+    PSHARED_FACE SharedFace = NULL;
+    PFONT_ENTRY Entry;
+    PFONTGDI FontGDI;
+    UNICODE_STRING FamilyName, FullName;
+    ULONG i;
+
+    File = IntFindCatalogFile(Catalog, PathName, FileInfo);
+    if (!File)
+        return 0;
+
+    for (i = 0, Face = IntFirstCatalogFace(File); i < File->EntryCount;
+         ++i, Face = IntNextCatalogFace(Face))
+    {
+        /* Charset variants of a face share it */
+        if (!SharedFace || SharedFace->FaceIndex != Face->FaceIndex)
+        {
+            if (SharedFace)
+                SharedFace_Release(SharedFace);
+
+            SharedFace = IntCreateDeferredFace(PathName, Face->FaceIndex);
+            if (!SharedFace)
+                break;
+        }
+
+        Entry = ExAllocatePoolWithTag(PagedPool, sizeof(FONT_ENTRY), TAG_FONT);
+        if (!Entry)
+            break;
+
+        FontGDI = EngAllocMem(FL_ZERO_MEMORY, sizeof(FONTGDI), GDITAG_RFONT);
+        if (!FontGDI)
+        {
+            ExFreePoolWithTag(Entry, TAG_FONT);
+            break;
+        }
+
+        FontGDI->Filename = ExAllocatePoolWithTag(PagedPool,
+                                                  PathName->Length + sizeof(UNICODE_NULL),
+                                                  GDITAG_PFF);
+        RtlInitUnicodeString(&Entry->FaceName, NULL);
+        RtlInitUnicodeString(&Entry->StyleName, NULL);
+        if (!FontGDI->Filename ||
+            !NT_SUCCESS(IntCreateCatalogName(Face, FONT_CATALOG_FACE_NAME, &Entry->FaceName)) ||
+            (Face->NameLength[FONT_CATALOG_STYLE_NAME] &&
+             !NT_SUCCESS(IntCreateCatalogName(Face, FONT_CATALOG_STYLE_NAME, &Entry->StyleName))))
+        {
+            if (FontGDI->Filename)
+                ExFreePoolWithTag(FontGDI->Filename, GDITAG_PFF);
+            if (Entry->FaceName.Buffer)
+                RtlFreeUnicodeString(&Entry->FaceName);
+            EngFreeMem(FontGDI);
+            ExFreePoolWithTag(Entry, TAG_FONT);
+            break;
+        }
+
+        RtlCopyMemory(FontGDI->Filename, PathName->Buffer, PathName->Length);
+        FontGDI->Filename[PathName->Length / sizeof(WCHAR)] = UNICODE_NULL;
+
+        IntLockFreeType();
+        SharedFace_AddRef(SharedFace);
+        IntUnLockFreeType();
+
+        FontGDI->SharedFace = SharedFace;
+        FontGDI->CharSet = Face->CharSet;
+        FontGDI->OriginalItalic = Face->OriginalItalic;
+        FontGDI->RequestItalic = FALSE;
+        FontGDI->OriginalWeight = Face->OriginalWeight;
+        FontGDI->RequestWeight = FW_NORMAL;
+
+        Entry->Font = FontGDI;
+        Entry->NotEnum = (Characteristics & FR_NOT_ENUM);
+
+        IntGetCatalogName(Face, FONT_CATALOG_FAMILY_NAME, &FamilyName);
+        IntGetCatalogName(Face, FONT_CATALOG_FULL_NAME, &FullName);
+
+        IntLockGlobalFonts();
+        InsertTailList(&g_FontListHead, &Entry->ListEntry);
+        IntAddFontToIndex(Entry, &FamilyName, &FullName);
+        IntClearFontRealizationCache();
+        IntUnLockGlobalFonts();
+    }
+
+    if (SharedFace)
+        SharedFace_Release(SharedFace);
+
+    if (i == 0)
+        return 0;
+
+    if (i != File->EntryCount)
+    {
+        /* Keep what is registered, loading the file now would duplicate it */
+        DPRINT1("Could not register all fonts of %wZ from the catalog\n", PathName);
+    }
+
+    /* Remember it for the next boot */
+    NewFile = IntReserveCatalogData(Catalog, File->Size);
+    if (NewFile)
+    {
+        RtlCopyMemory(NewFile, File, File->Size);
+        Catalog->NewFileCount++;
+    }
+    else
+    {
+        Catalog->Dirty = TRUE;
+    }
+
+    return File->FontCount;
+}
+
+/* Loads the face of a font registered from the catalog */
+static BOOL
+IntLoadDeferredFace(PSHARED_FACE SharedFace)
+{
+    UNICODE_STRING PathName;
+    PSHARED_MEM Memory;
+    PVOID Buffer;
+    SIZE_T ViewSize;
+    FT_Face Face;
+    FT_Error Error;
+    NTSTATUS Status;
+
+    ASSERT_FACE_LOCK_HELD(SharedFace);
+    ASSERT(SharedFace->Face == NULL);
+    ASSERT(SharedFace->Filename != NULL);
+
+    RtlInitUnicodeString(&PathName, SharedFace->Filename);
+    Status = IntMapFontFile(&PathName, &Buffer, &ViewSize);
+    if (!NT_SUCCESS(Status))
+        return FALSE;
+
+    Memory = SharedMem_Create(Buffer, ViewSize, TRUE);
+    if (!Memory)
+    {
+        MmUnmapViewInSystemSpace(Buffer);
+        return FALSE;
+    }
+
+    IntLockFreeType();
+    Error = FT_New_Memory_Face(g_FreeTypeLibrary, Buffer, ViewSize,
+                               SharedFace->FaceIndex, &Face);
+    if (!Error)
+    {
+        SharedMem_AddRef(Memory);
+        SharedFace->Memory = Memory;
+        SharedFace->Face = Face;
+    }
+    /* Release our copy */
+    SharedMem_Release(Memory);
+    IntUnLockFreeType();
+
+    if (Error)
+    {
+        DPRINT1("Error reading font %wZ (error code: %d)\n", &PathName, Error);
+        return FALSE;
+    }
+
+    DPRINT("Loaded deferred font %wZ (%ld)\n", &PathName, SharedFace->FaceIndex);
+    return TRUE;
+}
+
+/*
+ * IntEnsureFontLoaded
+ *
+ * Must be called before using the face of a font from the global list,
+ * which may have been registered from the catalog without loading it.
+ */
+static BOOL
+IntEnsureFontLoaded(PFONTGDI FontGDI)
+{
+    PSHARED_FACE SharedFace = FontGDI->SharedFace;
+    BOOL Ret = TRUE;
+
+    IntLockFace(SharedFace);
+    if (!SharedFace->Face)
+        Ret = IntLoadDeferredFace(SharedFace);
+    if (Ret && FontGDI->Magic != FONTGDI_MAGIC)
+        IntRequestFontSize(NULL, FontGDI, 0, 0);
+    IntUnLockFace(SharedFace);
+
+    return Ret;
+}
+
+/* NOTE: If nIndex < 0 then return the number of charsets. */
+UINT FASTCALL IntGetCharSet(INT nIndex, FT_ULong CodePageRange1)
+{
+    UINT BitIndex, CharSet;
+    UINT nCount = 0;
+
+    if (CodePageRange1 == 0)
+    {
+        return (nIndex < 0) ? 1 : DEFAULT_CHARSET;
+    }
+
+    for (BitIndex = 0; BitIndex < MAXTCIINDEX; ++BitIndex)
+    {
+        if (CodePageRange1 & (1 << BitIndex))
+        {
+            CharSet = g_FontTci[BitIndex].ciCharset;
+            if ((nIndex >= 0) && (nCount == (UINT)nIndex))
+            {
+                return CharSet;
+            }
+            ++nCount;
+        }
+    }
+
+    return (nIndex < 0) ? nCount : ANSI_CHARSET;
+}
+
+/* pixels to points */
+#define PX2PT(pixels) FT_MulDiv((pixels), 72, 96)
+
+static INT FASTCALL
+IntGdiLoadFontsFromMemory(PGDI_LOAD_FONT pLoadFont,
+                          PSHARED_FACE SharedFace, FT_Long FontIndex, INT CharSetIndex)
+{
+    FT_Error            Error;
+    PFONT_ENTRY         Entry;
+    FONT_ENTRY_MEM*     PrivateEntry = NULL;
+    FONTGDI *           FontGDI;
+    NTSTATUS            Status;
+    FT_Face             Face;
+    ANSI_STRING         AnsiString;
+    FT_WinFNT_HeaderRec WinFNT;
+    INT                 FaceCount = 0, CharSetCount = 0;
+    PUNICODE_STRING     pFileName       = pLoadFont->pFileName;
+    DWORD               Characteristics = pLoadFont->Characteristics;
+    PUNICODE_STRING     pValueName = &pLoadFont->RegValueName;
+    TT_OS2 *            pOS2;
+    INT                 BitIndex;
+    FT_UShort           os2_version;
+    FT_ULong            os2_ulCodePageRange1;
+    FT_UShort           os2_usWeightClass;
+
+    if (SharedFace == NULL && CharSetIndex == -1)
+    {
+        /* load a face from memory */
+        IntLockFreeType();
+        Error = FT_New_Memory_Face(
+                    g_FreeTypeLibrary,
+                    pLoadFont->Memory->Buffer,
+                    pLoadFont->Memory->BufferSize,
+                    ((FontIndex != -1) ? FontIndex : 0),
+                    &Face);
+
+        if (!Error)
+            SharedFace = SharedFace_Create(Face, pLoadFont->Memory);
+
+        IntUnLockFreeType();
+
+        if (!Error && FT_IS_SFNT(Face))
+            pLoadFont->IsTrueType = TRUE;
+
+        if (Error || SharedFace == NULL)
+        {
+            if (SharedFace)
+                SharedFace_Release(SharedFace);
+
+            if (Error == FT_Err_Unknown_File_Format)
+                DPRINT1("Unknown font file format\n");
+            else
                 DPRINT1("Error reading font (error code: %d)\n", Error);
             return 0;   /* failure */
         }
@@ -1209,7 +2221,7 @@ IntGdiLoadFontsFromMemory(PGDI_LOAD_FONT pLoadFont,
     FontGDI->OriginalWeight = FALSE;
     FontGDI->RequestWeight = FW_NORMAL;
 
-    IntLockFreeType();
+    IntLockFace(SharedFace);
     pOS2 = (TT_OS2 *)FT_Get_Sfnt_Table(Face, FT_SFNT_OS2);
     if (pOS2)
     {
@@ -1225,7 +2237,7 @@ IntGdiLoadFontsFromMemory(PGDI_LOAD_FONT pLoadFont,
             FontGDI->OriginalWeight = WinFNT.weight;
         }
     }
-    IntUnLockFreeType();
+    IntUnLockFace(SharedFace);
 
     RtlInitAnsiString(&AnsiString, Face->family_name);
     Status = RtlAnsiStringToUnicodeString(&Entry->FaceName, &AnsiString, TRUE);
@@ -1269,7 +2281,7 @@ IntGdiLoadFontsFromMemory(PGDI_LOAD_FONT pLoadFont,
     }
 
     os2_version = 0;
-    IntLockFreeType();
+    IntLockFace(SharedFace);
     pOS2 = (TT_OS2 *)FT_Get_Sfnt_Table(Face, FT_SFNT_OS2);
     if (pOS2)
     {
@@ -1277,7 +2289,7 @@ IntGdiLoadFontsFromMemory(PGDI_LOAD_FONT pLoadFont,
         os2_ulCodePageRange1 = pOS2->ulCodePageRange1;
         os2_usWeightClass = pOS2->usWeightClass;
     }
-    IntUnLockFreeType();
+    IntUnLockFace(SharedFace);
 
     if (pOS2 && os2_version >= 1)
     {
@@ -1309,13 +2321,13 @@ IntGdiLoadFontsFromMemory(PGDI_LOAD_FONT pLoadFont,
     else
     {
         /* get charset from WinFNT header */
-        IntLockFreeType();
+        IntLockFace(SharedFace);
         Error = FT_Get_WinFNT_Header(Face, &WinFNT);
         if (!Error)
         {
             FontGDI->CharSet = WinFNT.charset;
         }
-        IntUnLockFreeType();
+        IntUnLockFace(SharedFace);
     }
 
     ++FaceCount;
@@ -1325,9 +2337,9 @@ IntGdiLoadFontsFromMemory(PGDI_LOAD_FONT pLoadFont,
     DPRINT("Num glyphs: %d\n", Face->num_glyphs);
     DPRINT("CharSet: %d\n", FontGDI->CharSet);
 
-    IntLockFreeType();
+    IntLockFace(SharedFace);
     IntRequestFontSize(NULL, FontGDI, 0, 0);
-    IntUnLockFreeType();
+    IntUnLockFace(SharedFace);
 
     /* Add this font resource to the font table */
     Entry->Font = FontGDI;
@@ -1344,9 +2356,27 @@ IntGdiLoadFontsFromMemory(PGDI_LOAD_FONT pLoadFont,
     else
     {
         /* global font */
+        UNICODE_STRING FamilyName, FullName;
+
+        RtlInitUnicodeString(&FamilyName, NULL);
+        RtlInitUnicodeString(&FullName, NULL);
+        IntGetFontLocalizedName(&FamilyName, SharedFace, TT_NAME_ID_FONT_FAMILY, gusLanguageID);
+        IntGetFontLocalizedName(&FullName, SharedFace, TT_NAME_ID_FULL_NAME, gusLanguageID);
+
         IntLockGlobalFonts();
         InsertTailList(&g_FontListHead, &Entry->ListEntry);
+        IntAddFontToIndex(Entry, &FamilyName, &FullName);
+        IntClearFontRealizationCache();
         IntUnLockGlobalFonts();
+
+        if (g_FontCatalog)
+        {
+            IntAddCatalogFace(g_FontCatalog, Entry, (FontIndex != -1) ? FontIndex : 0,
+                              &FamilyName, &FullName);
+        }
+
+        RtlFreeUnicodeString(&FamilyName);
+        RtlFreeUnicodeString(&FullName);
     }
 
     if (FontIndex == -1)
@@ -1457,19 +2487,16 @@ IntGdiAddFontResourceEx(PUNICODE_STRING FileName, DWORD Characteristics,
                         DWORD dwFlags)
 {
     NTSTATUS Status;
-    HANDLE FileHandle;
     PVOID Buffer = NULL;
-    IO_STATUS_BLOCK Iosb;
-    PVOID SectionObject;
     SIZE_T ViewSize = 0, Length;
-    LARGE_INTEGER SectionSize;
     OBJECT_ATTRIBUTES ObjectAttributes;
+    FILE_NETWORK_OPEN_INFORMATION FileInfo;
+    BOOL UseCatalog = FALSE;
     GDI_LOAD_FONT LoadFont;
     INT FontCount;
     HANDLE KeyHandle;
     UNICODE_STRING PathName;
     LPWSTR pszBuffer;
-    PFILE_OBJECT FileObject;
     static const UNICODE_STRING TrueTypePostfix = RTL_CONSTANT_STRING(L" (TrueType)");
     static const UNICODE_STRING DosPathPrefix = RTL_CONSTANT_STRING(L"\\??\\");
 
@@ -1488,58 +2515,33 @@ IntGdiAddFontResourceEx(PUNICODE_STRING FileName, DWORD Characteristics,
     else
     {
         Status = DuplicateUnicodeString(FileName, &PathName);
-        if (!NT_SUCCESS(Status))
-            return 0;   /* failure */
-    }
-
-    /* Open the font file */
-    InitializeObjectAttributes(&ObjectAttributes, &PathName,
-                               OBJ_KERNEL_HANDLE | OBJ_CASE_INSENSITIVE, NULL, NULL);
-    Status = ZwOpenFile(
-                 &FileHandle,
-                 FILE_GENERIC_READ | SYNCHRONIZE,
-                 &ObjectAttributes,
-                 &Iosb,
-                 FILE_SHARE_READ,
-                 FILE_SYNCHRONOUS_IO_NONALERT);
-    if (!NT_SUCCESS(Status))
-    {
-        DPRINT1("Could not load font file: %wZ\n", &PathName);
-        RtlFreeUnicodeString(&PathName);
-        return 0;
-    }
-
-    Status = ObReferenceObjectByHandle(FileHandle, FILE_READ_DATA, NULL,
-                                       KernelMode, (PVOID*)&FileObject, NULL);
-    if (!NT_SUCCESS(Status))
-    {
-        DPRINT1("ObReferenceObjectByHandle failed.\n");
-        ZwClose(FileHandle);
-        RtlFreeUnicodeString(&PathName);
-        return 0;
-    }
-
-    SectionSize.QuadPart = 0LL;
-    Status = MmCreateSection(&SectionObject,
-                             STANDARD_RIGHTS_REQUIRED | SECTION_QUERY | SECTION_MAP_READ,
-                             NULL, &SectionSize, PAGE_READONLY,
-                             SEC_COMMIT, FileHandle, FileObject);
-    if (!NT_SUCCESS(Status))
+        if (!NT_SUCCESS(Status))
+            return 0;   /* failure */
+    }
+
+    /* Register the font from the catalog if it knows the file */
+    if (g_FontCatalog && !(dwFlags & AFRX_WRITE_REGISTRY))
     {
-        DPRINT1("Could not map file: %wZ\n", &PathName);
-        ZwClose(FileHandle);
-        ObDereferenceObject(FileObject);
-        RtlFreeUnicodeString(&PathName);
-        return 0;
+        InitializeObjectAttributes(&ObjectAttributes, &PathName,
+                                   OBJ_KERNEL_HANDLE | OBJ_CASE_INSENSITIVE, NULL, NULL);
+        Status = ZwQueryFullAttributesFile(&ObjectAttributes, &FileInfo);
+        if (NT_SUCCESS(Status))
+        {
+            FontCount = IntLoadFontsFromCatalog(g_FontCatalog, &PathName, &FileInfo,
+                                                Characteristics);
+            if (FontCount > 0)
+            {
+                RtlFreeUnicodeString(&PathName);
+                return FontCount;
+            }
+            UseCatalog = TRUE;
+        }
     }
-    ZwClose(FileHandle);
 
-    Status = MmMapViewInSystemSpace(SectionObject, &Buffer, &ViewSize);
+    /* Map the font file */
+    Status = IntMapFontFile(&PathName, &Buffer, &ViewSize);
     if (!NT_SUCCESS(Status))
     {
-        DPRINT1("Could not map file: %wZ\n", &PathName);
-        ObDereferenceObject(SectionObject);
-        ObDereferenceObject(FileObject);
         RtlFreeUnicodeString(&PathName);
         return 0;
     }
@@ -1551,17 +2553,20 @@ IntGdiAddFontResourceEx(PUNICODE_STRING FileName, DWORD Characteristics,
     LoadFont.IsTrueType         = FALSE;
     LoadFont.CharSet            = DEFAULT_CHARSET;
     LoadFont.PrivateEntry       = NULL;
+
+    if (UseCatalog)
+        IntBeginCatalogFile(g_FontCatalog, &PathName, &FileInfo);
+
     FontCount = IntGdiLoadFontsFromMemory(&LoadFont, NULL, -1, -1);
 
+    if (UseCatalog)
+        IntEndCatalogFile(g_FontCatalog, FontCount);
+
     /* Release our copy */
     IntLockFreeType();
     SharedMem_Release(LoadFont.Memory);
     IntUnLockFreeType();
 
-    ObDereferenceObject(SectionObject);
-
-    ObDereferenceObject(FileObject);
-
     /* Save the loaded font name into the registry */
     if (FontCount > 0 && (dwFlags & AFRX_WRITE_REGISTRY))
     {
@@ -2137,7 +3142,7 @@ FillTM(TEXTMETRICW *TM, PFONTGDI FontGDI,
     int Ascent, Descent;
     FT_Face Face = FontGDI->SharedFace->Face;
 
-    ASSERT_FREETYPE_LOCK_HELD();
+    ASSERT_FACE_LOCK_HELD(FontGDI->SharedFace);
 
     XScale = Face->size->metrics.x_scale;
     YScale = Face->size->metrics.y_scale;
@@ -2343,10 +3348,6 @@ FillTM(TEXTMETRICW *TM, PFONTGDI FontGDI,
     TM->tmCharSet = FontGDI->CharSet;
 }
 
-static NTSTATUS
-IntGetFontLocalizedName(PUNICODE_STRING pNameW, PSHARED_FACE SharedFace,
-                        FT_UShort NameID, FT_UShort LangID);
-
 typedef struct FONT_NAMES
 {
     UNICODE_STRING FamilyNameW;     /* family name (TT_NAME_ID_FONT_FAMILY) */
@@ -2484,7 +3485,7 @@ IntGetOutlineTextMetrics(PFONTGDI FontGDI,
     XScale = Face->size->metrics.x_scale;
     YScale = Face->size->metrics.y_scale;
 
-    IntLockFreeType();
+    IntLockFace(SharedFace);
 
     pOS2 = FT_Get_Sfnt_Table(Face, FT_SFNT_OS2);
     pHori = FT_Get_Sfnt_Table(Face, FT_SFNT_HHEA);
@@ -2493,7 +3494,7 @@ IntGetOutlineTextMetrics(PFONTGDI FontGDI,
 
     if (pOS2 == NULL && Error)
     {
-        IntUnLockFreeType();
+        IntUnLockFace(SharedFace);
         DPRINT1("Can't find OS/2 table - not TT font?\n");
         IntFreeFontNames(&FontNames);
         return 0;
@@ -2501,7 +3502,7 @@ IntGetOutlineTextMetrics(PFONTGDI FontGDI,
 
     if (pHori == NULL && Error)
     {
-        IntUnLockFreeType();
+        IntUnLockFace(SharedFace);
         DPRINT1("Can't find HHEA table - not TT font?\n");
         IntFreeFontNames(&FontNames);
         return 0;
@@ -2565,7 +3566,7 @@ IntGetOutlineTextMetrics(PFONTGDI FontGDI,
 #undef SCALE_Y
 
 skip_os2:
-    IntUnLockFreeType();
+    IntUnLockFace(SharedFace);
 
     pb = IntStoreFontNames(&FontNames, Otm);
     ASSERT(pb - (BYTE*)Otm == Cache->OutlineRequiredSize);
@@ -2775,26 +3776,27 @@ IntGetFontLocalizedName(PUNICODE_STRING pNameW, PSHARED_FACE SharedFace,
         /* make cache */
         if (NameID == TT_NAME_ID_FONT_FAMILY)
         {
-            ASSERT_FREETYPE_LOCK_NOT_HELD();
-            IntLockFreeType();
+            ASSERT_FACE_LOCK_NOT_HELD(SharedFace);
+            IntLockFace(SharedFace);
             if (!Cache->FontFamily.Buffer)
                 DuplicateUnicodeString(pNameW, &Cache->FontFamily);
-            IntUnLockFreeType();
+            IntUnLockFace(SharedFace);
         }
         else if (NameID == TT_NAME_ID_FULL_NAME)
         {
-            ASSERT_FREETYPE_LOCK_NOT_HELD();
-            IntLockFreeType();
+            ASSERT_FACE_LOCK_NOT_HELD(SharedFace);
+            IntLockFace(SharedFace);
             if (!Cache->FullName.Buffer)
                 DuplicateUnicodeString(pNameW, &Cache->FullName);
-            IntUnLockFreeType();
+            IntUnLockFace(SharedFace);
         }
     }
 
     return Status;
 }
 
-static void FASTCALL
+/* Returns FALSE if the font could not be loaded and Info was left empty */
+static BOOL FASTCALL
 FontFamilyFillInfo(PFONTFAMILYINFO Info, LPCWSTR FaceName,
                    LPCWSTR FullName, PFONTGDI FontGDI)
 {
@@ -2811,22 +3813,28 @@ FontFamilyFillInfo(PFONTFAMILYINFO Info, LPCWSTR FaceName,
     DWORD fs0;
     NTSTATUS status;
     PSHARED_FACE SharedFace = FontGDI->SharedFace;
-    FT_Face Face = SharedFace->Face;
+    FT_Face Face;
     UNICODE_STRING NameW;
 
     RtlInitUnicodeString(&NameW, NULL);
     RtlZeroMemory(Info, sizeof(FONTFAMILYINFO));
+
+    /* The font may have been registered from the catalog */
+    if (!IntEnsureFontLoaded(FontGDI))
+        return FALSE;
+    Face = SharedFace->Face;
+
     Size = IntGetOutlineTextMetrics(FontGDI, 0, NULL);
     Otm = ExAllocatePoolWithTag(PagedPool, Size, GDITAG_TEXT);
     if (!Otm)
     {
-        return;
+        return FALSE;
     }
     Size = IntGetOutlineTextMetrics(FontGDI, Size, Otm);
     if (!Size)
     {
         ExFreePoolWithTag(Otm, GDITAG_TEXT);
-        return;
+        return FALSE;
     }
 
     Lf = &Info->EnumLogFontEx.elfLogFont;
@@ -2897,18 +3905,18 @@ FontFamilyFillInfo(PFONTFAMILYINFO Info, LPCWSTR FaceName,
     if (!NT_SUCCESS(status))
     {
         ExFreePoolWithTag(Otm, GDITAG_TEXT);
-        return;
+        return TRUE;
     }
     Info->EnumLogFontEx.elfScript[0] = UNICODE_NULL;
 
-    IntLockFreeType();
+    IntLockFace(SharedFace);
     pOS2 = FT_Get_Sfnt_Table(Face, ft_sfnt_os2);
 
     if (!pOS2)
     {
-        IntUnLockFreeType();
+        IntUnLockFace(SharedFace);
         ExFreePoolWithTag(Otm, GDITAG_TEXT);
-        return;
+        return TRUE;
     }
 
     Ntm->ntmSizeEM = Otm->otmEMSquare;
@@ -2933,7 +3941,7 @@ FontFamilyFillInfo(PFONTFAMILYINFO Info, LPCWSTR FaceName,
         else
             fs.fsCsb[0] |= FS_SYMBOL;
     }
-    IntUnLockFreeType();
+    IntUnLockFace(SharedFace);
 
     if (fs.fsCsb[0] == 0)
     {
@@ -2976,6 +3984,7 @@ FontFamilyFillInfo(PFONTFAMILYINFO Info, LPCWSTR FaceName,
         }
     }
     Info->NewTextMetricEx.ntmFontSig = fs;
+    return TRUE;
 }
 
 static BOOLEAN FASTCALL
@@ -3005,7 +4014,8 @@ GetFontFamilyInfoForList(const LOGFONTW *LogFont,
         }
 
         /* get one info entry */
-        FontFamilyFillInfo(&InfoEntry, NULL, NULL, FontGDI);
+        if (!FontFamilyFillInfo(&InfoEntry, NULL, NULL, FontGDI))
+            continue;
 
         if (LogFont->lfFaceName[0] != UNICODE_NULL)
         {
@@ -3082,7 +4092,7 @@ GetFontFamilyInfoForSubstitutes(const LOGFONTW *LogFont,
             continue;
 
         /* search in global fonts */
-        IntLockGlobalFonts();
+        IntLockGlobalFontsShared();
         GetFontFamilyInfoForList(&lf, Info, pFromW->Buffer, pCount, MaxCount, &g_FontListHead);
         IntUnLockGlobalFonts();
 
@@ -3130,25 +4140,88 @@ SameScaleMatrix(
             FLOATOBJ_Equal(&pmx1->efM22, &pmx2->efM22));
 }
 
+static __inline ULONG
+IntGlyphCacheHashMix(ULONG Hash, ULONG Value)
+{
+    /* FNV-1a over the 32-bit value */
+    Hash ^= Value;
+    return Hash * 16777619;
+}
+
+static __inline ULONG
+IntGlyphCacheHashFloat(ULONG Hash, FLOATOBJ *pef)
+{
+    ULONG i, Value;
+    PUCHAR pb = (PUCHAR)pef;
+
+    for (i = 0; i + sizeof(ULONG) <= sizeof(FLOATOBJ); i += sizeof(ULONG))
+    {
+        RtlCopyMemory(&Value, pb + i, sizeof(Value));
+        Hash = IntGlyphCacheHashMix(Hash, Value);
+    }
+    return Hash;
+}
+
+/*
+ * IntGlyphCacheRealizationId --- computes a compact identifier for a font
+ * realization (face, height, render mode and transform). Entries with the
+ * same identifier still have their full key compared on lookup.
+ */
+static ULONG
+IntGlyphCacheRealizationId(
+    PSHARED_FACE SharedFace,
+    INT Height,
+    FT_Render_Mode RenderMode,
+    PMATRIX pmx)
+{
+    ULONG Hash = 2166136261;
+
+    Hash = IntGlyphCacheHashMix(Hash, (ULONG)(ULONG_PTR)SharedFace);
+#ifdef _WIN64
+    Hash = IntGlyphCacheHashMix(Hash, (ULONG)((ULONG_PTR)SharedFace >> 32));
+#endif
+    Hash = IntGlyphCacheHashMix(Hash, (ULONG)Height);
+    Hash = IntGlyphCacheHashMix(Hash, (ULONG)RenderMode);
+    Hash = IntGlyphCacheHashFloat(Hash, &pmx->efM11);
+    Hash = IntGlyphCacheHashFloat(Hash, &pmx->efM12);
+    Hash = IntGlyphCacheHashFloat(Hash, &pmx->efM21);
+    Hash = IntGlyphCacheHashFloat(Hash, &pmx->efM22);
+    return Hash;
+}
+
+static __inline ULONG
+IntGlyphCacheHash(ULONG RealizationId, INT GlyphIndex)
+{
+    return IntGlyphCacheHashMix(RealizationId, (ULONG)GlyphIndex);
+}
+
 FT_BitmapGlyph APIENTRY
 ftGdiGlyphCacheGet(
-    FT_Face Face,
+    PSHARED_FACE SharedFace,
     INT GlyphIndex,
     INT Height,
     FT_Render_Mode RenderMode,
     PMATRIX pmx)
 {
-    PLIST_ENTRY CurrentEntry;
+    PLIST_ENTRY CurrentEntry, BucketHead;
     PFONT_CACHE_ENTRY FontEntry;
+    ULONG RealizationId, Hash;
+    FT_BitmapGlyph BitmapGlyph = NULL;
 
-    ASSERT_FREETYPE_LOCK_HELD();
+    ASSERT_FACE_LOCK_HELD(SharedFace);
 
-    for (CurrentEntry = g_FontCacheListHead.Flink;
-         CurrentEntry != &g_FontCacheListHead;
+    RealizationId = IntGlyphCacheRealizationId(SharedFace, Height, RenderMode, pmx);
+    Hash = IntGlyphCacheHash(RealizationId, GlyphIndex);
+    BucketHead = &g_FontCacheHashTable[Hash & (FONT_CACHE_HASH_SIZE - 1)];
+
+    IntLockGlyphCacheShared();
+    for (CurrentEntry = BucketHead->Flink;
+         CurrentEntry != BucketHead;
          CurrentEntry = CurrentEntry->Flink)
     {
-        FontEntry = CONTAINING_RECORD(CurrentEntry, FONT_CACHE_ENTRY, ListEntry);
-        if ((FontEntry->Face == Face) &&
+        FontEntry = CONTAINING_RECORD(CurrentEntry, FONT_CACHE_ENTRY, HashEntry);
+        if ((FontEntry->Hash == Hash) &&
+            (FontEntry->SharedFace == SharedFace) &&
             (FontEntry->GlyphIndex == GlyphIndex) &&
             (FontEntry->Height == Height) &&
             (FontEntry->RenderMode == RenderMode) &&
@@ -3156,14 +4229,22 @@ ftGdiGlyphCacheGet(
             break;
     }
 
-    if (CurrentEntry == &g_FontCacheListHead)
+    if (CurrentEntry == BucketHead)
     {
-        return NULL;
+        InterlockedIncrement((PLONG)&g_FontCacheStats.Misses);
+    }
+    else
+    {
+        InterlockedIncrement((PLONG)&g_FontCacheStats.Hits);
+
+        /* Give it a second chance on eviction instead of relinking it,
+           which would need the lock exclusively */
+        FontEntry->Referenced = TRUE;
+        BitmapGlyph = FontEntry->BitmapGlyph;
     }
+    IntUnLockGlyphCache();
 
-    RemoveEntryList(CurrentEntry);
-    InsertHeadList(&g_FontCacheListHead, CurrentEntry);
-    return FontEntry->BitmapGlyph;
+    return BitmapGlyph;
 }
 
 /* no cache */
@@ -3210,7 +4291,7 @@ ftGdiGlyphSet(
 
 FT_BitmapGlyph APIENTRY
 ftGdiGlyphCacheSet(
-    FT_Face Face,
+    PSHARED_FACE SharedFace,
     INT GlyphIndex,
     INT Height,
     PMATRIX pmx,
@@ -3222,8 +4303,10 @@ ftGdiGlyphCacheSet(
     PFONT_CACHE_ENTRY NewEntry;
     FT_Bitmap AlignedBitmap;
     FT_BitmapGlyph BitmapGlyph;
+    PFONT_CACHE_ENTRY OldEntry;
+    ULONG Scanned;
 
-    ASSERT_FREETYPE_LOCK_HELD();
+    ASSERT_FACE_LOCK_HELD(SharedFace);
 
     error = FT_Get_Glyph(GlyphSlot, &GlyphCopy);
     if (error)
@@ -3263,18 +4346,60 @@ ftGdiGlyphCacheSet(
     BitmapGlyph->bitmap = AlignedBitmap;
 
     NewEntry->GlyphIndex = GlyphIndex;
-    NewEntry->Face = Face;
+    NewEntry->SharedFace = SharedFace;
     NewEntry->BitmapGlyph = BitmapGlyph;
     NewEntry->Height = Height;
     NewEntry->RenderMode = RenderMode;
     NewEntry->mxWorldToDevice = *pmx;
+    NewEntry->RealizationId = IntGlyphCacheRealizationId(SharedFace, Height, RenderMode, pmx);
+    NewEntry->Hash = IntGlyphCacheHash(NewEntry->RealizationId, GlyphIndex);
+    NewEntry->CacheSize = sizeof(FONT_CACHE_ENTRY) +
+                          abs(BitmapGlyph->bitmap.pitch) * BitmapGlyph->bitmap.rows;
+
+    NewEntry->Referenced = FALSE;
 
+    IntLockGlyphCache();
     InsertHeadList(&g_FontCacheListHead, &NewEntry->ListEntry);
-    if (++g_FontCacheNumEntries > MAX_FONT_CACHE)
+    InsertHeadList(&g_FontCacheHashTable[NewEntry->Hash & (FONT_CACHE_HASH_SIZE - 1)],
+                   &NewEntry->HashEntry);
+    InsertHeadList(&SharedFace->GlyphCacheListHead, &NewEntry->FaceEntry);
+    g_FontCacheStats.NumEntries++;
+    g_FontCacheStats.CurrentSize += NewEntry->CacheSize;
+
+    /* Evict from the tail, but never the new entry. Recently referenced
+       entries get a second chance, and entries of faces that are in use
+       by another thread are skipped. */
+    for (Scanned = 0;
+         g_FontCacheStats.CurrentSize > g_FontCacheStats.MaxSize &&
+         g_FontCacheListHead.Blink != &NewEntry->ListEntry &&
+         Scanned < 2 * g_FontCacheStats.NumEntries;
+         ++Scanned)
     {
-        NewEntry = CONTAINING_RECORD(g_FontCacheListHead.Blink, FONT_CACHE_ENTRY, ListEntry);
-        RemoveCachedEntry(NewEntry);
+        OldEntry = CONTAINING_RECORD(g_FontCacheListHead.Blink, FONT_CACHE_ENTRY, ListEntry);
+
+        if (OldEntry->Referenced)
+        {
+            OldEntry->Referenced = FALSE;
+        }
+        else if (OldEntry->SharedFace == SharedFace)
+        {
+            RemoveCachedEntry(OldEntry);
+            g_FontCacheStats.Evictions++;
+            continue;
+        }
+        else if (ExTryToAcquireFastMutex(OldEntry->SharedFace->Lock))
+        {
+            PFAST_MUTEX FaceLock = OldEntry->SharedFace->Lock;
+            RemoveCachedEntry(OldEntry);
+            ExReleaseFastMutex(FaceLock);
+            g_FontCacheStats.Evictions++;
+            continue;
+        }
+
+        RemoveEntryList(&OldEntry->ListEntry);
+        InsertHeadList(&g_FontCacheListHead, &OldEntry->ListEntry);
     }
+    IntUnLockGlyphCache();
 
     return BitmapGlyph;
 }
@@ -3505,7 +4630,7 @@ IntRequestFontSize(PDC dc, PFONTGDI FontGDI, LONG lfWidth, LONG lfHeight)
     if (lfHeight == -1)
         lfHeight = -2;
 
-    ASSERT_FREETYPE_LOCK_HELD();
+    ASSERT_FACE_LOCK_HELD(FontGDI->SharedFace);
     pOS2 = (TT_OS2 *)FT_Get_Sfnt_Table(face, FT_SFNT_OS2);
     pHori = (TT_HoriHeader *)FT_Get_Sfnt_Table(face, FT_SFNT_HHEA);
 
@@ -3607,7 +4732,7 @@ TextIntUpdateSize(PDC dc,
     LOGFONTW *plf;
 
     if (bDoLock)
-        IntLockFreeType();
+        IntLockFace(FontGDI->SharedFace);
 
     face = FontGDI->SharedFace->Face;
     if (face->charmap == NULL)
@@ -3673,7 +4798,7 @@ TextIntUpdateSize(PDC dc,
     error = IntRequestFontSize(dc, FontGDI, plf->lfWidth, plf->lfHeight);
 
     if (bDoLock)
-        IntUnLockFreeType();
+        IntUnLockFace(FontGDI->SharedFace);
 
     if (error)
     {
@@ -3809,7 +4934,7 @@ ftGdiGetGlyphOutline(
         return GDI_ERROR;
     }
 
-    IntLockFreeType();
+    IntLockFace(FontGDI->SharedFace);
     TextIntUpdateSize(dc, TextObj, FontGDI, FALSE);
     FtSetCoordinateTransform(ft_face, DC_pmxWorldToDevice(dc));
 
@@ -3831,11 +4956,11 @@ ftGdiGetGlyphOutline(
     if (error)
     {
         DPRINT1("WARNING: Failed to load and render glyph! [index: %u]\n", glyph_index);
-        IntUnLockFreeType();
+        IntUnLockFace(FontGDI->SharedFace);
         if (potm) ExFreePoolWithTag(potm, GDITAG_TEXT);
         return GDI_ERROR;
     }
-    IntUnLockFreeType();
+    IntUnLockFace(FontGDI->SharedFace);
 
     FLOATOBJ_Set1(&widthRatio);
     if (aveWidth && potm)
@@ -3869,7 +4994,7 @@ ftGdiGetGlyphOutline(
 
     DPRINT("Advance = %d, lsb = %d, bbx = %d\n",adv, lsb, bbx);
 
-    IntLockFreeType();
+    IntLockFace(FontGDI->SharedFace);
 
     /* Width scaling transform */
     if (!FLOATOBJ_Equal1(&widthRatio))
@@ -3986,7 +5111,7 @@ ftGdiGetGlyphOutline(
            gm.gmBlackBoxX, gm.gmBlackBoxY,
            gm.gmptGlyphOrigin.x, gm.gmptGlyphOrigin.y);
 
-    IntUnLockFreeType();
+    IntUnLockFace(FontGDI->SharedFace);
 
 
     if (iFormat == GGO_METRICS)
@@ -4040,7 +5165,7 @@ ftGdiGetGlyphOutline(
             ft_bitmap.pixel_mode = FT_PIXEL_MODE_MONO;
             ft_bitmap.buffer = pvBuf;
 
-            IntLockFreeType();
+            IntLockFace(FontGDI->SharedFace);
             if (needsTransform)
             {
                 FT_Outline_Transform(&ft_face->glyph->outline, &transMat);
@@ -4049,7 +5174,7 @@ ftGdiGetGlyphOutline(
             /* Note: FreeType will only set 'black' bits for us. */
             RtlZeroMemory(pvBuf, needed);
             FT_Outline_Get_Bitmap(g_FreeTypeLibrary, &ft_face->glyph->outline, &ft_bitmap);
-            IntUnLockFreeType();
+            IntUnLockFace(FontGDI->SharedFace);
             break;
         }
 
@@ -4107,7 +5232,7 @@ ftGdiGetGlyphOutline(
             ft_bitmap.pixel_mode = FT_PIXEL_MODE_GRAY;
             ft_bitmap.buffer = pvBuf;
 
-            IntLockFreeType();
+            IntLockFace(FontGDI->SharedFace);
             if (needsTransform)
             {
                 FT_Outline_Transform(&ft_face->glyph->outline, &transMat);
@@ -4115,7 +5240,7 @@ ftGdiGetGlyphOutline(
             FT_Outline_Translate(&ft_face->glyph->outline, -left, -bottom );
             RtlZeroMemory(ft_bitmap.buffer, cjBuf);
             FT_Outline_Get_Bitmap(g_FreeTypeLibrary, &ft_face->glyph->outline, &ft_bitmap);
-            IntUnLockFreeType();
+            IntUnLockFace(FontGDI->SharedFace);
 
             if (iFormat == GGO_GRAY2_BITMAP)
                 mult = 4;
@@ -4155,23 +5280,23 @@ ftGdiGetGlyphOutline(
 
         if (cjBuf == 0) pvBuf = NULL; /* This is okay, need cjBuf to allocate. */
 
-        IntLockFreeType();
+        IntLockFace(FontGDI->SharedFace);
         if (needsTransform && pvBuf) FT_Outline_Transform(outline, &transMat);
 
         needed = get_native_glyph_outline(outline, cjBuf, NULL);
 
         if (!pvBuf || !cjBuf)
         {
-            IntUnLockFreeType();
+            IntUnLockFace(FontGDI->SharedFace);
             break;
         }
         if (needed > cjBuf)
         {
-            IntUnLockFreeType();
+            IntUnLockFace(FontGDI->SharedFace);
             return GDI_ERROR;
         }
         get_native_glyph_outline(outline, cjBuf, pvBuf);
-        IntUnLockFreeType();
+        IntUnLockFace(FontGDI->SharedFace);
         break;
     }
 
@@ -4182,9 +5307,9 @@ ftGdiGetGlyphOutline(
 
         if (needsTransform && pvBuf)
         {
-            IntLockFreeType();
+            IntLockFace(FontGDI->SharedFace);
             FT_Outline_Transform(outline, &transMat);
-            IntUnLockFreeType();
+            IntUnLockFace(FontGDI->SharedFace);
         }
         needed = get_bezier_glyph_outline(outline, cjBuf, NULL);
 
@@ -4247,7 +5372,7 @@ TextIntGetTextExtentPoint(PDC dc,
         *Fit = 0;
     }
 
-    IntLockFreeType();
+    IntLockFace(FontGDI->SharedFace);
 
     TextIntUpdateSize(dc, TextObj, FontGDI, FALSE);
 
@@ -4275,7 +5400,7 @@ TextIntGetTextExtentPoint(PDC dc,
         if (EmuBold || EmuItalic)
             realglyph = NULL;
         else
-            realglyph = ftGdiGlyphCacheGet(face, glyph_index, plf->lfHeight,
+            realglyph = ftGdiGlyphCacheGet(FontGDI->SharedFace, glyph_index, plf->lfHeight,
                                            RenderMode, pmxWorldToDevice);
 
         if (EmuBold || EmuItalic || !realglyph)
@@ -4301,7 +5426,7 @@ TextIntGetTextExtentPoint(PDC dc,
             }
             else
             {
-                realglyph = ftGdiGlyphCacheSet(face,
+                realglyph = ftGdiGlyphCacheSet(FontGDI->SharedFace,
                                                glyph_index,
                                                plf->lfHeight,
                                                pmxWorldToDevice,
@@ -4347,7 +5472,7 @@ TextIntGetTextExtentPoint(PDC dc,
     ASSERT(FontGDI->Magic == FONTGDI_MAGIC);
     ascender = FontGDI->tmAscent; /* Units above baseline */
     descender = FontGDI->tmDescent; /* Units below baseline */
-    IntUnLockFreeType();
+    IntUnLockFace(FontGDI->SharedFace);
 
     Size->cx = (TotalWidth64 + 32) >> 6;
     Size->cy = ascender + descender;
@@ -4390,7 +5515,7 @@ ftGdiGetTextCharsetInfo(
     TEXTOBJ_UnlockText(TextObj);
 
     memset(&fs, 0, sizeof(FONTSIGNATURE));
-    IntLockFreeType();
+    IntLockFace(FontGdi->SharedFace);
     pOS2 = FT_Get_Sfnt_Table(Face, ft_sfnt_os2);
     if (NULL != pOS2)
     {
@@ -4411,7 +5536,7 @@ ftGdiGetTextCharsetInfo(
         }
     }
     pOS2 = NULL;
-    IntUnLockFreeType();
+    IntUnLockFace(FontGdi->SharedFace);
     DPRINT("Csb 1=%x  0=%x\n", fs.fsCsb[1],fs.fsCsb[0]);
     if (fs.fsCsb[0] == 0)
     { /* Let's see if we can find any interesting cmaps */
@@ -4576,10 +5701,10 @@ ftGdiGetTextMetricsW(
 
         Face = FontGDI->SharedFace->Face;
 
-        IntLockFreeType();
+        IntLockFace(FontGDI->SharedFace);
         Error = IntRequestFontSize(dc, FontGDI, plf->lfWidth, plf->lfHeight);
         FtSetCoordinateTransform(Face, DC_pmxWorldToDevice(dc));
-        IntUnLockFreeType();
+        IntUnLockFace(FontGDI->SharedFace);
 
         if (0 != Error)
         {
@@ -4591,7 +5716,7 @@ ftGdiGetTextMetricsW(
             FT_Face Face = FontGDI->SharedFace->Face;
             Status = STATUS_SUCCESS;
 
-            IntLockFreeType();
+            IntLockFace(FontGDI->SharedFace);
             pOS2 = FT_Get_Sfnt_Table(Face, ft_sfnt_os2);
             if (NULL == pOS2)
             {
@@ -4615,7 +5740,7 @@ ftGdiGetTextMetricsW(
                 /* FIXME: Fill Diff member */
             }
 
-            IntUnLockFreeType();
+            IntUnLockFace(FontGDI->SharedFace);
         }
         TEXTOBJ_UnlockText(TextObj);
     }
@@ -4645,7 +5770,7 @@ ftGdiGetFontData(
     DWORD Result = GDI_ERROR;
     FT_Face Face = FontGdi->SharedFace->Face;
 
-    IntLockFreeType();
+    IntLockFace(FontGdi->SharedFace);
 
     if (FT_IS_SFNT(Face))
     {
@@ -4668,7 +5793,7 @@ ftGdiGetFontData(
             Result = Size;
     }
 
-    IntUnLockFreeType();
+    IntUnLockFace(FontGdi->SharedFace);
 
     return Result;
 }
@@ -5022,18 +6147,64 @@ GetFontPenalty(const LOGFONTW *               LogFont,
 
 #undef GOT_PENALTY
 
+static VOID
+IntUpdateBestFont(FONTOBJ **FontObj, ULONG *MatchPenalty,
+                  const LOGFONTW *LogFont, PFONT_ENTRY CurrentEntry,
+                  OUTLINETEXTMETRICW **pOtm, UINT *pOldOtmSize)
+{
+    ULONG Penalty;
+    FONTGDI *FontGDI;
+    UINT OtmSize;
+    FT_Face Face;
+
+    FontGDI = CurrentEntry->Font;
+    ASSERT(FontGDI);
+
+    /* The font may have been registered from the catalog */
+    if (!IntEnsureFontLoaded(FontGDI))
+        return;
+    Face = FontGDI->SharedFace->Face;
+
+    /* get text metrics */
+    OtmSize = IntGetOutlineTextMetrics(FontGDI, 0, NULL);
+    if (OtmSize > *pOldOtmSize)
+    {
+        if (*pOtm)
+            ExFreePoolWithTag(*pOtm, GDITAG_TEXT);
+        *pOtm = ExAllocatePoolWithTag(PagedPool, OtmSize, GDITAG_TEXT);
+    }
+
+    /* update FontObj if lowest penalty */
+    if (*pOtm)
+    {
+        IntLockFace(FontGDI->SharedFace);
+        IntRequestFontSize(NULL, FontGDI, LogFont->lfWidth, LogFont->lfHeight);
+        IntUnLockFace(FontGDI->SharedFace);
+
+        OtmSize = IntGetOutlineTextMetrics(FontGDI, OtmSize, *pOtm);
+        if (!OtmSize)
+            return;
+
+        *pOldOtmSize = OtmSize;
+
+        Penalty = GetFontPenalty(LogFont, *pOtm, Face->style_name);
+        if (*MatchPenalty == 0xFFFFFFFF || Penalty < *MatchPenalty)
+        {
+            *FontObj = GDIToObj(FontGDI, FONT);
+            *MatchPenalty = Penalty;
+        }
+    }
+}
+
 static __inline VOID
 FindBestFontFromList(FONTOBJ **FontObj, ULONG *MatchPenalty,
                      const LOGFONTW *LogFont,
                      const PLIST_ENTRY Head)
 {
-    ULONG Penalty;
     PLIST_ENTRY Entry;
     PFONT_ENTRY CurrentEntry;
-    FONTGDI *FontGDI;
     OUTLINETEXTMETRICW *Otm = NULL;
-    UINT OtmSize, OldOtmSize = 0;
-    FT_Face Face;
+    UINT OldOtmSize = 0;
 
     ASSERT(FontObj);
     ASSERT(MatchPenalty);
@@ -5048,42 +6219,202 @@ FindBestFontFromList(FONTOBJ **FontObj, ULONG *MatchPenalty,
     for (Entry = Head->Flink; Entry != Head; Entry = Entry->Flink)
     {
         CurrentEntry = CONTAINING_RECORD(Entry, FONT_ENTRY, ListEntry);
+        IntUpdateBestFont(FontObj, MatchPenalty, LogFont, CurrentEntry, &Otm, &OldOtmSize);
+    }
 
-        FontGDI = CurrentEntry->Font;
-        ASSERT(FontGDI);
-        Face = FontGDI->SharedFace->Face;
+    if (Otm)
+        ExFreePoolWithTag(Otm, GDITAG_TEXT);
+}
+
+static int __cdecl
+IntCompareFontEntrySequence(const void *pv1, const void *pv2)
+{
+    const FONT_ENTRY *Entry1 = *(const FONT_ENTRY * const *)pv1;
+    const FONT_ENTRY *Entry2 = *(const FONT_ENTRY * const *)pv2;
+
+    if (Entry1->Sequence < Entry2->Sequence)
+        return -1;
+    if (Entry1->Sequence > Entry2->Sequence)
+        return 1;
+    return 0;
+}
 
-        /* get text metrics */
-        OtmSize = IntGetOutlineTextMetrics(FontGDI, 0, NULL);
-        if (OtmSize > OldOtmSize)
+static ULONG
+IntCollectFontCandidates(PFONT_ENTRY *Candidates, ULONG MaxCount,
+                         const LOGFONTW *LogFont, BOOL UseName, BOOL UseCharSet)
+{
+    PLIST_ENTRY Head, Entry;
+    PFONT_INDEX_ENTRY IndexEntry;
+    ULONG Hash, Count = 0;
+
+    if (UseName)
+    {
+        Hash = IntFontNameHash(LogFont->lfFaceName, _countof(LogFont->lfFaceName));
+        Head = &g_FontNameIndex[Hash & (FONT_INDEX_HASH_SIZE - 1)];
+        for (Entry = Head->Flink; Entry != Head; Entry = Entry->Flink)
         {
-            if (Otm)
-                ExFreePoolWithTag(Otm, GDITAG_TEXT);
-            Otm = ExAllocatePoolWithTag(PagedPool, OtmSize, GDITAG_TEXT);
+            IndexEntry = CONTAINING_RECORD(Entry, FONT_INDEX_ENTRY, ListEntry);
+            if (IndexEntry->Hash != Hash)
+                continue;
+            if (Candidates && Count < MaxCount)
+                Candidates[Count] = IndexEntry->FontEntry;
+            ++Count;
         }
+    }
 
-        /* update FontObj if lowest penalty */
-        if (Otm)
+    if (UseCharSet)
+    {
+        Head = &g_FontCharSetIndex[LogFont->lfCharSet];
+        for (Entry = Head->Flink; Entry != Head; Entry = Entry->Flink)
         {
-            IntLockFreeType();
-            IntRequestFontSize(NULL, FontGDI, LogFont->lfWidth, LogFont->lfHeight);
-            IntUnLockFreeType();
+            IndexEntry = CONTAINING_RECORD(Entry, FONT_INDEX_ENTRY, ListEntry);
+            if (Candidates && Count < MaxCount)
+                Candidates[Count] = IndexEntry->FontEntry;
+            ++Count;
+        }
+    }
 
-            OtmSize = IntGetOutlineTextMetrics(FontGDI, OtmSize, Otm);
-            if (!OtmSize)
-                continue;
+    return Count;
+}
 
-            OldOtmSize = OtmSize;
+static BOOL
+IntIsFontInNameIndex(PFONT_ENTRY FontEntry, ULONG Hash)
+{
+    PLIST_ENTRY Head, Entry;
+    PFONT_INDEX_ENTRY IndexEntry;
 
-            Penalty = GetFontPenalty(LogFont, Otm, Face->style_name);
-            if (*MatchPenalty == 0xFFFFFFFF || Penalty < *MatchPenalty)
-            {
-                *FontObj = GDIToObj(FontGDI, FONT);
-                *MatchPenalty = Penalty;
-            }
-        }
+    Head = &g_FontNameIndex[Hash & (FONT_INDEX_HASH_SIZE - 1)];
+    for (Entry = Head->Flink; Entry != Head; Entry = Entry->Flink)
+    {
+        IndexEntry = CONTAINING_RECORD(Entry, FONT_INDEX_ENTRY, ListEntry);
+        if (IndexEntry->Hash == Hash && IndexEntry->FontEntry == FontEntry)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+/*
+ * IntGetFontPenaltyLowerBound --- the CharSet and FaceName parts of
+ * GetFontPenalty, which the registered charset and the indexed names of
+ * a global font tell without loading its face. NameHash is the hash of
+ * lfFaceName.
+ */
+static ULONG
+IntGetFontPenaltyLowerBound(const LOGFONTW *LogFont, PFONT_ENTRY FontEntry, ULONG NameHash)
+{
+    ULONG Penalty = 0;
+    BYTE CharSet = FontEntry->Font->CharSet;
+
+    if (LogFont->lfCharSet != CharSet)
+    {
+        if (LogFont->lfCharSet != DEFAULT_CHARSET && LogFont->lfCharSet != ANSI_CHARSET)
+            Penalty += 65000;
+        else if (CharSetFromLangID(gusLanguageID) != CharSet)
+            Penalty += (CharSet != ANSI_CHARSET) ? 200 : 100;
+    }
+
+    /* A hash match may be a collision, so only a miss counts */
+    if (LogFont->lfFaceName[0] != UNICODE_NULL && !g_FontIndexIncomplete &&
+        !IntIsFontInNameIndex(FontEntry, NameHash))
+    {
+        Penalty += 10000;
+    }
+
+    return Penalty;
+}
+
+/*
+ * FindBestFontFromIndex --- the same as FindBestFontFromList on the global
+ * font list, but only scores the fonts whose name or charset can match.
+ * Every other font gets at least the FaceName (10000) or CharSet (65000)
+ * penalty, so if a candidate scores below that bound it is the exact
+ * result; otherwise we fall back to scanning the whole list.
+ */
+static VOID
+FindBestFontFromIndex(FONTOBJ **FontObj, ULONG *MatchPenalty,
+                      const LOGFONTW *LogFont)
+{
+    BOOL UseName, UseCharSet;
+    ULONG LowerBound, Count, Hash, i, j;
+    PFONT_ENTRY *Candidates, CurrentEntry;
+    PLIST_ENTRY Entry;
+    FONTOBJ *BestFontObj = *FontObj;
+    ULONG BestPenalty = *MatchPenalty;
+    OUTLINETEXTMETRICW *Otm;
+    UINT OldOtmSize;
+
+    UseName = (LogFont->lfFaceName[0] != UNICODE_NULL);
+    UseCharSet = (LogFont->lfCharSet != DEFAULT_CHARSET &&
+                  LogFont->lfCharSet != ANSI_CHARSET);
+
+    if (UseName && UseCharSet)
+        LowerBound = 10000 + 65000;
+    else if (UseName)
+        LowerBound = 10000;
+    else if (UseCharSet)
+        LowerBound = 65000;
+    else
+        LowerBound = 0;
+
+    if (LowerBound == 0 || g_FontIndexIncomplete)
+        goto FullScan;
+
+    Count = IntCollectFontCandidates(NULL, 0, LogFont, UseName, UseCharSet);
+    if (Count == 0)
+        goto FullScan;
+
+    Candidates = ExAllocatePoolWithTag(PagedPool, Count * sizeof(PFONT_ENTRY), GDITAG_TEXT);
+    if (!Candidates)
+        goto FullScan;
+
+    IntCollectFontCandidates(Candidates, Count, LogFont, UseName, UseCharSet);
+
+    /* Score them in list order, so that ties resolve as in a full scan */
+    qsort(Candidates, Count, sizeof(PFONT_ENTRY), IntCompareFontEntrySequence);
+
+    OldOtmSize = 0x200;
+    Otm = ExAllocatePoolWithTag(PagedPool, OldOtmSize, GDITAG_TEXT);
+    for (i = 0; i < Count; ++i)
+    {
+        if (i > 0 && Candidates[i] == Candidates[i - 1])
+            continue;
+        IntUpdateBestFont(&BestFontObj, &BestPenalty, LogFont, Candidates[i], &Otm, &OldOtmSize);
+    }
+    if (Otm)
+        ExFreePoolWithTag(Otm, GDITAG_TEXT);
+    ExFreePoolWithTag(Candidates, GDITAG_TEXT);
+
+    if (BestFontObj && BestPenalty < LowerBound)
+    {
+        *FontObj = BestFontObj;
+        *MatchPenalty = BestPenalty;
+        return;
     }
 
+    DPRINT("Index miss for '%S' (penalty %lu), scanning all fonts\n", LogFont->lfFaceName, BestPenalty);
+
+FullScan:
+    /*
+     * Score the fonts in list order like FindBestFontFromList, but without
+     * loading those that cannot win: the ones that cannot beat the best
+     * candidate above, or the best font found so far in the list.
+     */
+    Hash = IntFontNameHash(LogFont->lfFaceName, _countof(LogFont->lfFaceName));
+    OldOtmSize = 0x200;
+    Otm = ExAllocatePoolWithTag(PagedPool, OldOtmSize, GDITAG_TEXT);
+    for (Entry = g_FontListHead.Flink; Entry != &g_FontListHead; Entry = Entry->Flink)
+    {
+        CurrentEntry = CONTAINING_RECORD(Entry, FONT_ENTRY, ListEntry);
+
+        LowerBound = IntGetFontPenaltyLowerBound(LogFont, CurrentEntry, Hash);
+        if ((BestPenalty != 0xFFFFFFFF && LowerBound > BestPenalty) ||
+            (*MatchPenalty != 0xFFFFFFFF && LowerBound >= *MatchPenalty))
+        {
+            continue;
+        }
+
+        IntUpdateBestFont(FontObj, MatchPenalty, LogFont, CurrentEntry, &Otm, &OldOtmSize);
+    }
     if (Otm)
         ExFreePoolWithTag(Otm, GDITAG_TEXT);
 }
@@ -5097,8 +6428,8 @@ IntFontType(PFONTGDI Font)
     FT_ULong tmp_size = 0;
     FT_Face Face = Font->SharedFace->Face;
 
-    ASSERT_FREETYPE_LOCK_NOT_HELD();
-    IntLockFreeType();
+    ASSERT_FACE_LOCK_NOT_HELD(Font->SharedFace);
+    IntLockFace(Font->SharedFace);
 
     if (FT_HAS_MULTIPLE_MASTERS(Face))
         Font->FontObj.flFontType |= FO_MULTIPLEMASTER;
@@ -5122,7 +6453,7 @@ IntFontType(PFONTGDI Font)
         Font->FontObj.flFontType |= (FO_CFF|FO_POSTSCRIPT);
     }
 
-    IntUnLockFreeType();
+    IntUnLockFace(Font->SharedFace);
 }
 
 static BOOL
@@ -5182,6 +6513,9 @@ TextIntRealizeFont(HFONT FontHandle, PTEXTOBJ pTextObj)
     ULONG MatchPenalty;
     LOGFONTW *pLogFont;
     LOGFONTW SubstitutedLogFont;
+    FONTOBJ *GlobalFontObj;
+    ULONG GlobalPenalty;
+    SIZE_T cchFaceName;
 
     if (!pTextObj)
     {
@@ -5210,6 +6544,12 @@ TextIntRealizeFont(HFONT FontHandle, PTEXTOBJ pTextObj)
     SubstituteFontRecurse(&SubstitutedLogFont);
     DPRINT("'%S,%u'.\n", SubstitutedLogFont.lfFaceName, SubstitutedLogFont.lfCharSet);
 
+    /* Clear the garbage after the face name, it is part of the cache key */
+    SubstitutedLogFont.lfFaceName[_countof(SubstitutedLogFont.lfFaceName) - 1] = UNICODE_NULL;
+    cchFaceName = wcslen(SubstitutedLogFont.lfFaceName);
+    RtlZeroMemory(&SubstitutedLogFont.lfFaceName[cchFaceName],
+                  (_countof(SubstitutedLogFont.lfFaceName) - cchFaceName) * sizeof(WCHAR));
+
     MatchPenalty = 0xFFFFFFFF;
     TextObj->Font = NULL;
 
@@ -5222,11 +6562,23 @@ TextIntRealizeFont(HFONT FontHandle, PTEXTOBJ pTextObj)
     IntUnLockProcessPrivateFonts(Win32Process);
 
     /* Search system fonts */
-    IntLockGlobalFonts();
-    FindBestFontFromList(&TextObj->Font, &MatchPenalty, &SubstitutedLogFont,
-                         &g_FontListHead);
+    IntLockGlobalFontsShared();
+    if (!IntFindFontRealization(&SubstitutedLogFont, &GlobalFontObj, &GlobalPenalty))
+    {
+        GlobalFontObj = NULL;
+        GlobalPenalty = 0xFFFFFFFF;
+        FindBestFontFromIndex(&GlobalFontObj, &GlobalPenalty, &SubstitutedLogFont);
+        if (GlobalFontObj)
+            IntAddFontRealization(&SubstitutedLogFont, GlobalFontObj, GlobalPenalty);
+    }
     IntUnLockGlobalFonts();
 
+    if (GlobalFontObj && (MatchPenalty == 0xFFFFFFFF || GlobalPenalty < MatchPenalty))
+    {
+        TextObj->Font = GlobalFontObj;
+        MatchPenalty = GlobalPenalty;
+    }
+
     if (NULL == TextObj->Font)
     {
         DPRINT1("Request font %S not found, no fonts loaded at all\n",
@@ -5239,9 +6591,9 @@ TextIntRealizeFont(HFONT FontHandle, PTEXTOBJ pTextObj)
         PFONTGDI FontGdi = ObjToGDI(TextObj->Font, FONT);
         PSHARED_FACE SharedFace = FontGdi->SharedFace;
 
-        IntLockFreeType();
+        IntLockFace(SharedFace);
         IntRequestFontSize(NULL, FontGdi, pLogFont->lfWidth, pLogFont->lfHeight);
-        IntUnLockFreeType();
+        IntUnLockFace(SharedFace);
 
         TextObj->TextFace[0] = UNICODE_NULL;
         if (MatchFontNames(SharedFace, SubstitutedLogFont.lfFaceName))
@@ -5420,7 +6772,7 @@ IntGdiGetFontResourceInfo(
     Count = 0;
 
     /* Try to find the pathname in the global font list */
-    IntLockGlobalFonts();
+    IntLockGlobalFontsShared();
     for (ListEntry = g_FontListHead.Flink; ListEntry != &g_FontListHead;
          ListEntry = ListEntry->Flink)
     {
@@ -5435,9 +6787,13 @@ IntGdiGetFontResourceInfo(
         if (!RtlEqualUnicodeString(&NameInfo1->Name, &NameInfo2->Name, FALSE))
             continue;
 
+        if (!FontFamilyFillInfo(&FamInfo[Count], FontEntry->FaceName.Buffer,
+                                NULL, FontEntry->Font))
+        {
+            continue;
+        }
+
         IsEqual = FALSE;
-        FontFamilyFillInfo(&FamInfo[Count], FontEntry->FaceName.Buffer,
-                           NULL, FontEntry->Font);
         for (i = 0; i < Count; ++i)
         {
             if (EqualFamilyInfo(&FamInfo[i], &FamInfo[Count]))
@@ -5668,7 +7024,7 @@ ftGdiGetKerningPairs( PFONTGDI Font,
 
         char_previous = char_code = FT_Get_First_Char(face, &glyph_index);
 
-        IntLockFreeType();
+        IntLockFace(Font->SharedFace);
 
         while (glyph_index)
         {
@@ -5690,7 +7046,7 @@ ftGdiGetKerningPairs( PFONTGDI Font,
             char_previous = char_code;
             char_code = FT_Get_Next_Char(face, char_code, &glyph_index);
         }
-        IntUnLockFreeType();
+        IntUnLockFace(Font->SharedFace);
     }
     return Count;
 }
@@ -5712,7 +7068,7 @@ IntGetFontFamilyInfo(HDC Dc,
     PPROCESSINFO Win32Process;
 
     /* Enumerate font families in the global list */
-    IntLockGlobalFonts();
+    IntLockGlobalFontsShared();
     if (!GetFontFamilyInfoForList(SafeLogFont, SafeInfo, NULL, &AvailCount,
                                   InfoCount, &g_FontListHead))
     {
@@ -6025,7 +7381,7 @@ IntExtTextOutW(
     FontGDI = ObjToGDI(FontObj, FONT);
     ASSERT(FontGDI);
 
-    IntLockFreeType();
+    IntLockFace(FontGDI->SharedFace);
     face = FontGDI->SharedFace->Face;
 
     plf = &TextObj->logfont.elfEnumLogfontEx.elfLogFont;
@@ -6039,7 +7395,7 @@ IntExtTextOutW(
 
     if (!TextIntUpdateSize(dc, TextObj, FontGDI, FALSE))
     {
-        IntUnLockFreeType();
+        IntUnLockFace(FontGDI->SharedFace);
         bResult = FALSE;
         goto Cleanup;
     }
@@ -6109,7 +7465,7 @@ IntExtTextOutW(
             if (EmuBold || EmuItalic)
                 realglyph = NULL;
             else
-                realglyph = ftGdiGlyphCacheGet(face, glyph_index, plf->lfHeight,
+                realglyph = ftGdiGlyphCacheGet(FontGDI->SharedFace, glyph_index, plf->lfHeight,
                                                RenderMode, pmxWorldToDevice);
             if (!realglyph)
             {
@@ -6133,7 +7489,7 @@ IntExtTextOutW(
                 }
                 else
                 {
-                    realglyph = ftGdiGlyphCacheSet(face,
+                    realglyph = ftGdiGlyphCacheSet(FontGDI->SharedFace,
                                                    glyph_index,
                                                    plf->lfHeight,
                                                    pmxWorldToDevice,
@@ -6143,7 +7499,7 @@ IntExtTextOutW(
                 if (!realglyph)
                 {
                     DPRINT1("Failed to render glyph! [index: %d]\n", glyph_index);
-                    IntUnLockFreeType();
+                    IntUnLockFace(FontGDI->SharedFace);
                     goto Cleanup;
                 }
 
@@ -6218,7 +7574,7 @@ IntExtTextOutW(
             if (error)
             {
                 DPRINT1("Failed to load and render glyph! [index: %d]\n", glyph_index);
-                IntUnLockFreeType();
+                IntUnLockFace(FontGDI->SharedFace);
                 goto Cleanup;
             }
 
@@ -6231,7 +7587,7 @@ IntExtTextOutW(
             if (!realglyph)
             {
                 DPRINT1("Failed to render glyph! [index: %d]\n", glyph_index);
-                IntUnLockFreeType();
+                IntUnLockFace(FontGDI->SharedFace);
                 goto Cleanup;
             }
 
@@ -6332,7 +7688,7 @@ IntExtTextOutW(
         if (EmuBold || EmuItalic)
             realglyph = NULL;
         else
-            realglyph = ftGdiGlyphCacheGet(face, glyph_index, plf->lfHeight,
+            realglyph = ftGdiGlyphCacheGet(FontGDI->SharedFace, glyph_index, plf->lfHeight,
                                            RenderMode, pmxWorldToDevice);
         if (!realglyph)
         {
@@ -6358,7 +7714,7 @@ IntExtTextOutW(
             }
             else
             {
-                realglyph = ftGdiGlyphCacheSet(face,
+                realglyph = ftGdiGlyphCacheSet(FontGDI->SharedFace,
                                                glyph_index,
                                                plf->lfHeight,
                                                pmxWorldToDevice,
@@ -6580,7 +7936,7 @@ IntExtTextOutW(
         pdcattr->ptlCurrent.x = DestRect.right - dc->ptlDCOrig.x;
     }
 
-    IntUnLockFreeType();
+    IntUnLockFace(FontGDI->SharedFace);
 
     EXLATEOBJ_vCleanup(&exloRGB2Dst);
     EXLATEOBJ_vCleanup(&exloDst2RGB);
@@ -6895,13 +8251,13 @@ NtGdiGetCharABCWidthsW(
             return FALSE;
         }
 
-        IntLockFreeType();
+        IntLockFace(FontGDI->SharedFace);
         FT_Set_Charmap(face, found);
-        IntUnLockFreeType();
+        IntUnLockFace(FontGDI->SharedFace);
     }
 
     plf = &TextObj->logfont.elfEnumLogfontEx.elfLogFont;
-    IntLockFreeType();
+    IntLockFace(FontGDI->SharedFace);
     IntRequestFontSize(dc, FontGDI, plf->lfWidth, plf->lfHeight);
     FtSetCoordinateTransform(face, pmxWorldToDevice);
 
@@ -6944,7 +8300,7 @@ NtGdiGetCharABCWidthsW(
             SafeBuff[i - FirstChar].abcC = adv - lsb - bbx;
         }
     }
-    IntUnLockFreeType();
+    IntUnLockFace(FontGDI->SharedFace);
     TEXTOBJ_UnlockText(TextObj);
     Status = MmCopyToCaller(Buffer, SafeBuff, BufferSize);
 
@@ -7085,13 +8441,13 @@ NtGdiGetCharWidthW(
             return FALSE;
         }
 
-        IntLockFreeType();
+        IntLockFace(FontGDI->SharedFace);
         FT_Set_Charmap(face, found);
-        IntUnLockFreeType();
+        IntUnLockFace(FontGDI->SharedFace);
     }
 
     plf = &TextObj->logfont.elfEnumLogfontEx.elfLogFont;
-    IntLockFreeType();
+    IntLockFace(FontGDI->SharedFace);
     IntRequestFontSize(dc, FontGDI, plf->lfWidth, plf->lfHeight);
     FtSetCoordinateTransform(face, pmxWorldToDevice);
 
@@ -7111,7 +8467,7 @@ NtGdiGetCharWidthW(
         else
             SafeBuff[i - FirstChar] = (face->glyph->advance.x + 32) >> 6;
     }
-    IntUnLockFreeType();
+    IntUnLockFace(FontGDI->SharedFace);
     TEXTOBJ_UnlockText(TextObj);
     MmCopyToCaller(Buffer, SafeBuff, BufferSize);
 
@@ -7225,10 +8581,10 @@ NtGdiGetGlyphIndicesW(
         Face = FontGDI->SharedFace->Face;
         if (FT_IS_SFNT(Face))
         {
-            IntLockFreeType();
+            IntLockFace(FontGDI->SharedFace);
             pOS2 = FT_Get_Sfnt_Table(Face, ft_sfnt_os2);
             DefChar = (pOS2->usDefaultChar ? get_glyph_index(Face, pOS2->usDefaultChar) : 0);
-            IntUnLockFreeType();
+            IntUnLockFace(FontGDI->SharedFace);
         }
         else
         {
@@ -7281,7 +8637,7 @@ NtGdiGetGlyphIndicesW(
     }
 
     /* Get glyph indeces */
-    IntLockFreeType();
+    IntLockFace(FontGDI->SharedFace);
     for (i = 0; i < cwc; i++)
     {
         Buffer[i] = get_glyph_index(FontGDI->SharedFace->Face, Safepwc[i]);
@@ -7290,7 +8646,7 @@ NtGdiGetGlyphIndicesW(
             Buffer[i] = DefChar;
         }
     }
-    IntUnLockFreeType();
+    IntUnLockFace(FontGDI->SharedFace);
 
     _SEH2_TRY
     {
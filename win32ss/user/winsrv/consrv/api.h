@@ -70,6 +70,9 @@
         if (!NT_SUCCESS(Status))                \
             return Status;                      \
                                                 \
+        /* Output what the processes queued before this call */     \
+        ConSrvDrainOutputRings(Console);                            \
+                                                \
         Status = Name##Impl(ProcessData, Console,                   \
                             ApiMessage, RequestName, ReplyCode);    \
                                                 \
@@ -81,6 +84,48 @@
     CON_API_ENTRY(Name, TYPE, RequestName);   \
     CON_API_IMPL(Name, TYPE, RequestName)
 
+/*
+ * Same as CON_API, for the APIs that change the screen buffers. While the
+ * console is paused with text still queued in the output rings, they wait
+ * for it to be resumed, like WriteConsole, instead of overtaking that text.
+ */
+#define CON_API_OUTPUT_ENTRY(Name, TYPE, RequestName)   \
+    CON_API_IMPL(Name, TYPE, RequestName);      \
+    static NTSTATUS                             \
+    Name##Call(                                 \
+        IN PCONSOLE_PROCESS_DATA ProcessData,   \
+        IN PCONSRV_CONSOLE Console,             \
+        IN OUT PCSR_API_MESSAGE ApiMessage)     \
+    {                                           \
+        return Name##Impl(ProcessData, Console, ApiMessage,         \
+                          &((PCONSOLE_API_MESSAGE)ApiMessage)->Data.RequestName, \
+                          NULL);                \
+    }                                           \
+    CSR_API(Name)                               \
+    {                                           \
+        NTSTATUS Status;                        \
+        PCSR_THREAD ClientThread = CsrGetClientThread();            \
+        PCONSOLE_PROCESS_DATA ProcessData = ConsoleGetPerProcessData(ClientThread->Process);    \
+        PCONSRV_CONSOLE Console;                \
+                                                \
+        Status = ConSrvGetConsole(ProcessData,  \
+                                  /* RequestName->ConsoleHandle, */   \
+                                  &Console, TRUE);              \
+        if (!NT_SUCCESS(Status))                \
+            return Status;                      \
+                                                \
+        Status = ConSrvCallOutputApi(ProcessData, Console, ApiMessage,  \
+                                     ClientThread, Name##Call, TRUE);   \
+        if (Status == STATUS_PENDING) *ReplyCode = CsrReplyPending;     \
+                                                \
+        ConSrvReleaseConsole(Console, TRUE);    \
+        return Status;                          \
+    }
+
+#define CON_API_OUTPUT(Name, TYPE, RequestName)     \
+    CON_API_OUTPUT_ENTRY(Name, TYPE, RequestName);  \
+    CON_API_IMPL(Name, TYPE, RequestName)
+
 
 /*
  * List of CSR_API_ROUTINE-s defined in this module.
@@ -106,6 +151,8 @@ CSR_API(SrvInvalidateBitMapRect);
 CSR_API(SrvSetConsolePalette);
 CSR_API(SrvReadConsoleOutput);
 CSR_API(SrvWriteConsole);
+CSR_API(SrvMapConsoleOutputRing);
+CSR_API(SrvFlushConsoleOutputRing);
 CSR_API(SrvWriteConsoleOutput);
 CSR_API(SrvReadConsoleOutputString);
 CSR_API(SrvWriteConsoleOutputString);
@@ -175,8 +175,8 @@ ConDrvSetConsoleCursorPosition(IN PCONSOLE Console,
                                IN PTEXTMODE_SCREEN_BUFFER Buffer,
                                IN PCOORD Position);
 /* API_NUMBER: ConsolepSetCursorPosition */
-CON_API(SrvSetConsoleCursorPosition,
-        CONSOLE_SETCURSORPOSITION, SetCursorPositionRequest)
+CON_API_OUTPUT(SrvSetConsoleCursorPosition,
+               CONSOLE_SETCURSORPOSITION, SetCursorPositionRequest)
 {
     NTSTATUS Status;
     PTEXTMODE_SCREEN_BUFFER Buffer;
@@ -333,8 +333,8 @@ NTSTATUS NTAPI
 ConDrvSetConsoleActiveScreenBuffer(IN PCONSOLE Console,
                                    IN PCONSOLE_SCREEN_BUFFER Buffer);
 /* API_NUMBER: ConsolepSetActiveScreenBuffer */
-CON_API(SrvSetConsoleActiveScreenBuffer,
-        CONSOLE_SETACTIVESCREENBUFFER, SetScreenBufferRequest)
+CON_API_OUTPUT(SrvSetConsoleActiveScreenBuffer,
+               CONSOLE_SETACTIVESCREENBUFFER, SetScreenBufferRequest)
 {
     NTSTATUS Status;
     PCONSOLE_SCREEN_BUFFER Buffer;
@@ -444,13 +444,18 @@ DoWriteConsole(IN PCSR_API_MESSAGE ApiMessage,
         Buffer = WriteConsoleRequest->Buffer;
     }
 
-    DPRINT("Calling ConDrvWriteConsole\n");
-    Status = ConDrvWriteConsole(ScreenBuffer->Header.Console,
-                                ScreenBuffer,
-                                WriteConsoleRequest->Unicode,
-                                Buffer,
-                                WriteConsoleRequest->NumBytes / CharSize, // NrCharactersToWrite
-                                &NrCharactersWritten);
+    /* What the processes queued in their output rings goes out first */
+    Status = ConSrvDrainOutputRings((PCONSRV_CONSOLE)ScreenBuffer->Header.Console);
+    if (NT_SUCCESS(Status) && Status != STATUS_PENDING)
+    {
+        DPRINT("Calling ConDrvWriteConsole\n");
+        Status = ConDrvWriteConsole(ScreenBuffer->Header.Console,
+                                    ScreenBuffer,
+                                    WriteConsoleRequest->Unicode,
+                                    Buffer,
+                                    WriteConsoleRequest->NumBytes / CharSize, // NrCharactersToWrite
+                                    &NrCharactersWritten);
+    }
     DPRINT("ConDrvWriteConsole returned (%d ; Status = 0x%08x)\n",
            NrCharactersWritten, Status);
 
@@ -487,6 +492,457 @@ Quit:
 }
 
 
+/* OUTPUT RING ****************************************************************/
+
+/*
+ * Server side of the shared memory ring through which a client process
+ * appends its WriteConsole text without calling us, see CONSOLE_OUTPUT_RING.
+ * The rings of all the processes of a console are drained, with the console
+ * locked, by every console API call before it does anything else and when a
+ * process attaches to the console, so that no direct output can overtake
+ * queued text. While the console is paused, the queued text stays there, and
+ * WriteConsole and the APIs declared with CON_API_OUTPUT wait behind it. A
+ * ring is also drained in the background when its client signals that it
+ * appended text to an empty ring.
+ */
+typedef struct _CONSRV_OUTPUT_RING
+{
+    PCONSOLE_PROCESS_DATA ProcessData;
+    PCONSOLE_OUTPUT_RING Ring;  // Our view
+    PVOID ClientView;
+    HANDLE SectionHandle;
+    HANDLE Event;
+    HANDLE WaitHandle;
+    /* Consecutive writes to the same screen buffer are gathered here */
+    UCHAR Batch[CONSOLE_OUTPUT_RING_MAX_WRITE * 4];
+} CONSRV_OUTPUT_RING, *PCONSRV_OUTPUT_RING;
+
+static VOID
+ConSrvWriteOutputBatch(IN PCONSOLE_PROCESS_DATA ProcessData,
+                       IN HANDLE OutputHandle,
+                       IN BOOLEAN Unicode,
+                       IN PVOID Buffer,
+                       IN ULONG NumBytes)
+{
+    NTSTATUS Status;
+    PTEXTMODE_SCREEN_BUFFER ScreenBuffer;
+
+    /* Like for a write to a closed handle, there is nobody to report a failure to */
+    Status = ConSrvGetTextModeBuffer(ProcessData, OutputHandle,
+                                     &ScreenBuffer, GENERIC_WRITE, FALSE);
+    if (!NT_SUCCESS(Status)) return;
+
+    ConDrvWriteConsole(ScreenBuffer->Header.Console,
+                       ScreenBuffer,
+                       Unicode,
+                       Buffer,
+                       NumBytes / (Unicode ? sizeof(WCHAR) : sizeof(CHAR)),
+                       NULL);
+
+    ConSrvReleaseScreenBuffer(ScreenBuffer, FALSE);
+}
+
+/* The console must be locked */
+NTSTATUS
+ConSrvDrainOutputRing(IN PCONSOLE_PROCESS_DATA ProcessData,
+                      IN PCONSRV_CONSOLE Console)
+{
+    PCONSRV_OUTPUT_RING OutputRing = ProcessData->OutputRing;
+    PCONSOLE_OUTPUT_RING Ring;
+    CONSOLE_OUTPUT_RECORD Record;
+    ULONG ReadOffset, WriteOffset, Position, RecordSize;
+    ULONG BatchBytes = 0;
+    HANDLE BatchHandle = NULL;
+    BOOLEAN BatchUnicode = FALSE;
+
+    if (!OutputRing) return STATUS_SUCCESS;
+    Ring = OutputRing->Ring;
+
+    ReadOffset = Ring->ReadOffset;
+    for (;;)
+    {
+        WriteOffset = Ring->WriteOffset;
+
+        /* The client may write anything there: never trust what we read */
+        if (WriteOffset - ReadOffset > CONSOLE_OUTPUT_RING_SIZE)
+        {
+            DPRINT1("Corrupted output ring, dropping its contents\n");
+            ReadOffset = WriteOffset;
+        }
+
+        /* Text written while the console is paused waits for it to be resumed */
+        if (Console->ConsolePaused && ReadOffset != WriteOffset)
+        {
+            InterlockedExchange((PLONG)&Ring->ReadOffset, ReadOffset);
+            return STATUS_PENDING;
+        }
+
+        /* Gather the records up to a change of screen buffer, or a full batch */
+        while (ReadOffset != WriteOffset)
+        {
+            Position = ReadOffset % CONSOLE_OUTPUT_RING_SIZE;
+            RtlCopyMemory(&Record, &Ring->Data[Position], sizeof(Record));
+
+            if (Record.OutputHandle == NULL &&
+                CONSOLE_OUTPUT_RING_SIZE - Position <= WriteOffset - ReadOffset)
+            {
+                /* The next record starts at the beginning of the data */
+                ReadOffset += CONSOLE_OUTPUT_RING_SIZE - Position;
+                continue;
+            }
+
+            if (Record.OutputHandle == NULL ||
+                Record.NumBytes > CONSOLE_OUTPUT_RING_MAX_WRITE)
+            {
+                DPRINT1("Corrupted output ring, dropping its contents\n");
+                ReadOffset = WriteOffset;
+                break;
+            }
+
+            RecordSize = ALIGN_UP_BY(sizeof(Record) + Record.NumBytes, CONSOLE_OUTPUT_RING_ALIGN);
+            if (RecordSize > CONSOLE_OUTPUT_RING_SIZE - Position ||
+                RecordSize > WriteOffset - ReadOffset)
+            {
+                DPRINT1("Corrupted output ring, dropping its contents\n");
+                ReadOffset = WriteOffset;
+                break;
+            }
+
+            if (BatchBytes != 0 &&
+                (Record.OutputHandle != BatchHandle ||
+                 Record.Unicode != BatchUnicode ||
+                 BatchBytes + Record.NumBytes > sizeof(OutputRing->Batch)))
+            {
+                break;
+            }
+
+            RtlCopyMemory(&OutputRing->Batch[BatchBytes],
+                          &Ring->Data[Position + sizeof(Record)],
+                          Record.NumBytes);
+            BatchHandle   = Record.OutputHandle;
+            BatchUnicode  = Record.Unicode;
+            BatchBytes   += Record.NumBytes;
+            ReadOffset   += RecordSize;
+        }
+
+        if (BatchBytes != 0)
+        {
+            ConSrvWriteOutputBatch(ProcessData, BatchHandle, BatchUnicode,
+                                   OutputRing->Batch, BatchBytes);
+            BatchBytes = 0;
+
+            /* Give the room back to the client */
+            InterlockedExchange((PLONG)&Ring->ReadOffset, ReadOffset);
+            continue;
+        }
+
+        /*
+         * The ring is empty: let the client know, then look again, since it
+         * does not wake us up for what it appends before seeing it empty.
+         */
+        InterlockedExchange((PLONG)&Ring->ReadOffset, ReadOffset);
+        if (Ring->WriteOffset == ReadOffset)
+            break;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+/*
+ * Drains the rings of all the processes of a console. The console must be
+ * locked. Returns STATUS_PENDING if the console is paused and some text has
+ * to wait for it to be resumed.
+ */
+NTSTATUS
+ConSrvDrainOutputRings(IN PCONSRV_CONSOLE Console)
+{
+    NTSTATUS Status = STATUS_SUCCESS;
+    PLIST_ENTRY Entry;
+    PCONSOLE_PROCESS_DATA ProcessData;
+
+    for (Entry = Console->ProcessList.Flink;
+         Entry != &Console->ProcessList;
+         Entry = Entry->Flink)
+    {
+        ProcessData = CONTAINING_RECORD(Entry, CONSOLE_PROCESS_DATA, ConsoleLink);
+        if (!ProcessData->OutputRing) continue;
+
+        if (ConSrvDrainOutputRing(ProcessData, Console) == STATUS_PENDING)
+            Status = STATUS_PENDING;
+    }
+
+    return Status;
+}
+
+// Wait function CSR_WAIT_FUNCTION
+static BOOLEAN
+NTAPI
+OutputApiThread(IN PLIST_ENTRY WaitList,
+                IN PCSR_THREAD WaitThread,
+                IN PCSR_API_MESSAGE WaitApiMessage,
+                IN PVOID WaitContext,
+                IN PVOID WaitArgument1,
+                IN PVOID WaitArgument2,
+                IN ULONG WaitFlags)
+{
+    NTSTATUS Status;
+    PCONSOLE_PROCESS_DATA ProcessData;
+    PCONSRV_CONSOLE Console;
+
+    /*
+     * If we are notified of the process termination via a call
+     * to CsrNotifyWaitBlock triggered by CsrDestroyProcess or
+     * CsrDestroyThread, just return.
+     */
+    if (WaitFlags & CsrProcessTerminating)
+    {
+        Status = STATUS_THREAD_IS_TERMINATING;
+        goto Quit;
+    }
+
+    /* We are notified by ConioUnpause, with the console already locked */
+    ProcessData = ConsoleGetPerProcessData(WaitThread->Process);
+    Status = ConSrvGetConsole(ProcessData, &Console, FALSE);
+    if (!NT_SUCCESS(Status)) goto Quit;
+
+    Status = ConSrvCallOutputApi(ProcessData, Console, WaitApiMessage, WaitThread,
+                                 (PCONSRV_OUTPUT_API)WaitContext, FALSE);
+
+    ConSrvReleaseConsole(Console, FALSE);
+
+Quit:
+    if (Status != STATUS_PENDING)
+    {
+        WaitApiMessage->Status = Status;
+    }
+
+    return (Status == STATUS_PENDING ? FALSE : TRUE);
+}
+
+/*
+ * Calls an API declared with CON_API_OUTPUT once the output rings are drained.
+ * The console must be locked. If it is paused with some text still queued,
+ * returns STATUS_PENDING and, if asked to, waits for it to be resumed.
+ */
+NTSTATUS
+ConSrvCallOutputApi(IN PCONSOLE_PROCESS_DATA ProcessData,
+                    IN PCONSRV_CONSOLE Console,
+                    IN OUT PCSR_API_MESSAGE ApiMessage,
+                    IN PCSR_THREAD ClientThread,
+                    IN PCONSRV_OUTPUT_API OutputApi,
+                    IN BOOLEAN CreateWaitBlock)
+{
+    if (ConSrvDrainOutputRings(Console) != STATUS_PENDING)
+        return OutputApi(ProcessData, Console, ApiMessage);
+
+    if (CreateWaitBlock &&
+        !CsrCreateWait(&Console->WriteWaitQueue,
+                       OutputApiThread,
+                       ClientThread,
+                       ApiMessage,
+                       (PVOID)OutputApi))
+    {
+        /* Fail */
+        return STATUS_NO_MEMORY;
+    }
+
+    /* Wait until we un-pause the console */
+    return STATUS_PENDING;
+}
+
+static VOID
+NTAPI
+ConSrvOutputRingCallback(IN PVOID Context,
+                         IN BOOLEAN TimerOrWaitFired)
+{
+    PCONSRV_OUTPUT_RING OutputRing = Context;
+    PCONSRV_CONSOLE Console;
+
+    if (!NT_SUCCESS(ConSrvGetConsole(OutputRing->ProcessData, &Console, TRUE)))
+        return;
+
+    ConSrvDrainOutputRing(OutputRing->ProcessData, Console);
+    ConSrvReleaseConsole(Console, TRUE);
+}
+
+/* Sets or clears the paused flag of the rings of the processes of a console */
+VOID
+ConSrvPauseOutputRings(IN PCONSRV_CONSOLE Console,
+                       IN BOOLEAN Paused)
+{
+    PLIST_ENTRY Entry;
+    PCONSOLE_PROCESS_DATA ProcessData;
+    PCONSRV_OUTPUT_RING OutputRing;
+
+    for (Entry = Console->ProcessList.Flink;
+         Entry != &Console->ProcessList;
+         Entry = Entry->Flink)
+    {
+        ProcessData = CONTAINING_RECORD(Entry, CONSOLE_PROCESS_DATA, ConsoleLink);
+        OutputRing = ProcessData->OutputRing;
+        if (!OutputRing) continue;
+
+        if (Paused)
+        {
+            InterlockedOr((PLONG)&OutputRing->Ring->Flags, CONSOLE_OUTPUT_RING_PAUSED);
+        }
+        else
+        {
+            InterlockedAnd((PLONG)&OutputRing->Ring->Flags, ~CONSOLE_OUTPUT_RING_PAUSED);
+            /* Output what was queued while paused */
+            NtSetEvent(OutputRing->Event, NULL);
+        }
+    }
+}
+
+/*
+ * Stops the background draining of the ring of a process. It waits for a
+ * running drain to finish, so the console must not be locked.
+ */
+VOID
+ConSrvStopOutputRing(IN PCONSOLE_PROCESS_DATA ProcessData)
+{
+    PCONSRV_OUTPUT_RING OutputRing = ProcessData->OutputRing;
+
+    if (OutputRing && OutputRing->WaitHandle)
+    {
+        RtlDeregisterWaitEx(OutputRing->WaitHandle, INVALID_HANDLE_VALUE);
+        OutputRing->WaitHandle = NULL;
+    }
+}
+
+/* Outputs what is left in the ring of a process, if a console is given, and frees it */
+VOID
+ConSrvDeleteOutputRing(IN PCONSOLE_PROCESS_DATA ProcessData,
+                       IN PCONSRV_CONSOLE Console OPTIONAL)
+{
+    PCONSRV_OUTPUT_RING OutputRing = ProcessData->OutputRing;
+
+    if (!OutputRing) return;
+
+    ConSrvStopOutputRing(ProcessData);
+    if (Console) ConSrvDrainOutputRing(ProcessData, Console);
+
+    ProcessData->OutputRing = NULL;
+
+    /* The client view goes away with the process if it is exiting */
+    if (OutputRing->ClientView)
+        NtUnmapViewOfSection(ProcessData->Process->ProcessHandle, OutputRing->ClientView);
+    if (OutputRing->Ring)
+        NtUnmapViewOfSection(NtCurrentProcess(), OutputRing->Ring);
+    if (OutputRing->SectionHandle) NtClose(OutputRing->SectionHandle);
+    if (OutputRing->Event) NtClose(OutputRing->Event);
+
+    ConsoleFreeHeap(OutputRing);
+}
+
+/* API_NUMBER: ConsolepMapOutputRing */
+CON_API(SrvMapConsoleOutputRing,
+        CONSOLE_MAPOUTPUTRING, MapOutputRingRequest)
+{
+    NTSTATUS Status;
+    PCONSRV_OUTPUT_RING OutputRing;
+    HANDLE ProcessHandle = ProcessData->Process->ProcessHandle;
+    LARGE_INTEGER SectionSize;
+    SIZE_T ViewSize;
+
+    /* No ring for ourselves */
+    if (ProcessData->Process->ClientId.UniqueProcess == NtCurrentTeb()->ClientId.UniqueProcess)
+        return STATUS_NOT_SUPPORTED;
+
+    /* A client which forgot about its ring gets it back */
+    OutputRing = ProcessData->OutputRing;
+    if (OutputRing)
+    {
+        Status = NtDuplicateObject(NtCurrentProcess(),
+                                   OutputRing->Event,
+                                   ProcessHandle,
+                                   &MapOutputRingRequest->Event,
+                                   EVENT_MODIFY_STATE, 0, 0);
+        if (NT_SUCCESS(Status))
+            MapOutputRingRequest->Ring = OutputRing->ClientView;
+        return Status;
+    }
+
+    OutputRing = ConsoleAllocHeap(HEAP_ZERO_MEMORY, sizeof(*OutputRing));
+    if (!OutputRing) return STATUS_NO_MEMORY;
+    OutputRing->ProcessData = ProcessData;
+
+    SectionSize.QuadPart = sizeof(CONSOLE_OUTPUT_RING);
+    Status = NtCreateSection(&OutputRing->SectionHandle,
+                             SECTION_ALL_ACCESS,
+                             NULL,
+                             &SectionSize,
+                             PAGE_READWRITE,
+                             SEC_COMMIT,
+                             NULL);
+    if (!NT_SUCCESS(Status)) goto Quit;
+
+    ViewSize = 0;
+    Status = NtMapViewOfSection(OutputRing->SectionHandle,
+                                NtCurrentProcess(),
+                                (PVOID*)&OutputRing->Ring,
+                                0, 0, NULL, &ViewSize,
+                                ViewUnmap, 0, PAGE_READWRITE);
+    if (!NT_SUCCESS(Status)) goto Quit;
+
+    ViewSize = 0;
+    Status = NtMapViewOfSection(OutputRing->SectionHandle,
+                                ProcessHandle,
+                                &OutputRing->ClientView,
+                                0, 0, NULL, &ViewSize,
+                                ViewUnmap, 0, PAGE_READWRITE);
+    if (!NT_SUCCESS(Status)) goto Quit;
+
+    Status = NtCreateEvent(&OutputRing->Event, EVENT_ALL_ACCESS,
+                           NULL, SynchronizationEvent, FALSE);
+    if (!NT_SUCCESS(Status)) goto Quit;
+
+    Status = NtDuplicateObject(NtCurrentProcess(),
+                               OutputRing->Event,
+                               ProcessHandle,
+                               &MapOutputRingRequest->Event,
+                               EVENT_MODIFY_STATE, 0, 0);
+    if (!NT_SUCCESS(Status)) goto Quit;
+
+    if (Console->ConsolePaused)
+        OutputRing->Ring->Flags = CONSOLE_OUTPUT_RING_PAUSED;
+
+    ProcessData->OutputRing = OutputRing;
+
+    Status = RtlRegisterWait(&OutputRing->WaitHandle,
+                             OutputRing->Event,
+                             ConSrvOutputRingCallback,
+                             OutputRing,
+                             INFINITE,
+                             WT_EXECUTEDEFAULT);
+    if (!NT_SUCCESS(Status))
+    {
+        NtDuplicateObject(ProcessHandle, MapOutputRingRequest->Event,
+                          NULL, NULL, 0, 0, DUPLICATE_CLOSE_SOURCE);
+        goto Quit;
+    }
+
+    MapOutputRingRequest->Ring = OutputRing->ClientView;
+    return STATUS_SUCCESS;
+
+Quit:
+    /* Free what we did set up */
+    ProcessData->OutputRing = OutputRing;
+    ConSrvDeleteOutputRing(ProcessData, NULL);
+    return Status;
+}
+
+/* API_NUMBER: ConsolepFlushOutputRing */
+CON_API(SrvFlushConsoleOutputRing,
+        CONSOLE_FLUSHOUTPUTRING, FlushOutputRingRequest)
+{
+    /* Text held back by a paused console goes out when it is resumed */
+    ConSrvDrainOutputRing(ProcessData, Console);
+    return STATUS_SUCCESS;
+}
+
+
 /* TEXT OUTPUT APIS ***********************************************************/
 
 NTSTATUS NTAPI
@@ -560,8 +1016,8 @@ ConDrvWriteConsoleOutput(IN PCONSOLE Console,
                          IN PCHAR_INFO CharInfo/*Buffer*/,
                          IN OUT PSMALL_RECT WriteRegion);
 /* API_NUMBER: ConsolepWriteConsoleOutput */
-CON_API(SrvWriteConsoleOutput,
-        CONSOLE_WRITEOUTPUT, WriteOutputRequest)
+CON_API_OUTPUT(SrvWriteConsoleOutput,
+               CONSOLE_WRITEOUTPUT, WriteOutputRequest)
 {
     NTSTATUS Status;
     PCSR_PROCESS Process = CsrGetClientThread()->Process;
@@ -798,8 +1254,8 @@ ConDrvWriteConsoleOutputString(IN PCONSOLE Console,
                                // OUT PCOORD EndCoord,
                                OUT PULONG NumCodesWritten OPTIONAL);
 /* API_NUMBER: ConsolepWriteConsoleOutputString */
-CON_API(SrvWriteConsoleOutputString,
-        CONSOLE_WRITEOUTPUTCODE, WriteOutputCodeRequest)
+CON_API_OUTPUT(SrvWriteConsoleOutputString,
+               CONSOLE_WRITEOUTPUTCODE, WriteOutputCodeRequest)
 {
     NTSTATUS Status;
     PTEXTMODE_SCREEN_BUFFER Buffer;
@@ -885,8 +1341,8 @@ ConDrvFillConsoleOutput(IN PCONSOLE Console,
                         IN PCOORD WriteCoord,
                         OUT PULONG NumCodesWritten OPTIONAL);
 /* API_NUMBER: ConsolepFillConsoleOutput */
-CON_API(SrvFillConsoleOutput,
-        CONSOLE_FILLOUTPUTCODE, FillOutputRequest)
+CON_API_OUTPUT(SrvFillConsoleOutput,
+               CONSOLE_FILLOUTPUTCODE, FillOutputRequest)
 {
     NTSTATUS Status;
     PTEXTMODE_SCREEN_BUFFER Buffer;
@@ -964,8 +1420,8 @@ ConDrvSetConsoleTextAttribute(IN PCONSOLE Console,
                               IN PTEXTMODE_SCREEN_BUFFER Buffer,
                               IN WORD Attributes);
 /* API_NUMBER: ConsolepSetTextAttribute */
-CON_API(SrvSetConsoleTextAttribute,
-        CONSOLE_SETTEXTATTRIB, SetTextAttribRequest)
+CON_API_OUTPUT(SrvSetConsoleTextAttribute,
+               CONSOLE_SETTEXTATTRIB, SetTextAttribRequest)
 {
     NTSTATUS Status;
     PTEXTMODE_SCREEN_BUFFER Buffer;
@@ -991,8 +1447,8 @@ ConDrvSetConsoleScreenBufferSize(IN PCONSOLE Console,
                                  IN PTEXTMODE_SCREEN_BUFFER Buffer,
                                  IN PCOORD Size);
 /* API_NUMBER: ConsolepSetScreenBufferSize */
-CON_API(SrvSetConsoleScreenBufferSize,
-        CONSOLE_SETSCREENBUFFERSIZE, SetScreenBufferSizeRequest)
+CON_API_OUTPUT(SrvSetConsoleScreenBufferSize,
+               CONSOLE_SETSCREENBUFFERSIZE, SetScreenBufferSizeRequest)
 {
     NTSTATUS Status;
     PTEXTMODE_SCREEN_BUFFER Buffer;
@@ -1023,8 +1479,8 @@ ConDrvScrollConsoleScreenBuffer(IN PCONSOLE Console,
                                 IN PCOORD DestinationOrigin,
                                 IN CHAR_INFO FillChar);
 /* API_NUMBER: ConsolepScrollScreenBuffer */
-CON_API(SrvScrollConsoleScreenBuffer,
-        CONSOLE_SCROLLSCREENBUFFER, ScrollScreenBufferRequest)
+CON_API_OUTPUT(SrvScrollConsoleScreenBuffer,
+               CONSOLE_SCROLLSCREENBUFFER, ScrollScreenBufferRequest)
 {
     NTSTATUS Status;
     PTEXTMODE_SCREEN_BUFFER Buffer;
@@ -1056,8 +1512,8 @@ ConDrvSetConsoleWindowInfo(IN PCONSOLE Console,
                            IN BOOLEAN Absolute,
                            IN PSMALL_RECT WindowRect);
 /* API_NUMBER: ConsolepSetWindowInfo */
-CON_API(SrvSetConsoleWindowInfo,
-        CONSOLE_SETWINDOWINFO, SetWindowInfoRequest)
+CON_API_OUTPUT(SrvSetConsoleWindowInfo,
+               CONSOLE_SETWINDOWINFO, SetWindowInfoRequest)
 {
     NTSTATUS Status;
     // PCONSOLE_SCREEN_BUFFER Buffer;
@@ -44,4 +44,30 @@ VOID NTAPI ConDrvDeleteScreenBuffer(PCONSOLE_SCREEN_BUFFER Buffer);
 PCONSOLE_SCREEN_BUFFER
 ConDrvGetActiveScreenBuffer(IN PCONSOLE Console);
 
+NTSTATUS
+ConSrvDrainOutputRing(IN PCONSOLE_PROCESS_DATA ProcessData,
+                      IN PCONSRV_CONSOLE Console);
+NTSTATUS
+ConSrvDrainOutputRings(IN PCONSRV_CONSOLE Console);
+
+typedef NTSTATUS
+(*PCONSRV_OUTPUT_API)(IN PCONSOLE_PROCESS_DATA ProcessData,
+                      IN PCONSRV_CONSOLE Console,
+                      IN OUT PCSR_API_MESSAGE ApiMessage);
+NTSTATUS
+ConSrvCallOutputApi(IN PCONSOLE_PROCESS_DATA ProcessData,
+                    IN PCONSRV_CONSOLE Console,
+                    IN OUT PCSR_API_MESSAGE ApiMessage,
+                    IN PCSR_THREAD ClientThread,
+                    IN PCONSRV_OUTPUT_API OutputApi,
+                    IN BOOLEAN CreateWaitBlock);
+VOID
+ConSrvPauseOutputRings(IN PCONSRV_CONSOLE Console,
+                       IN BOOLEAN Paused);
+VOID
+ConSrvStopOutputRing(IN PCONSOLE_PROCESS_DATA ProcessData);
+VOID
+ConSrvDeleteOutputRing(IN PCONSOLE_PROCESS_DATA ProcessData,
+                       IN PCONSRV_CONSOLE Console OPTIONAL);
+
 /* EOF */
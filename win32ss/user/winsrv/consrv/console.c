@@ -860,6 +860,7 @@ ConioPause(PCONSRV_CONSOLE Console, UCHAR Flags)
 {
     Console->PauseFlags |= Flags;
     ConDrvPause((PCONSOLE)Console);
+    ConSrvPauseOutputRings(Console, TRUE);
 }
 
 VOID
@@ -871,6 +872,7 @@ ConioUnpause(PCONSRV_CONSOLE Console, UCHAR Flags)
     if (Console->PauseFlags == 0)
     {
         ConDrvUnpause((PCONSOLE)Console);
+        ConSrvPauseOutputRings(Console, FALSE);
 
         CsrNotifyWait(&Console->WriteWaitQueue,
                       TRUE,
@@ -1202,6 +1204,9 @@ ConSrvInheritConsole(
     /* Return the console handle to the caller */
     ConsoleStartInfo->ConsoleHandle = ProcessData->ConsoleHandle;
 
+    /* Output what the other processes queued before the new one can write */
+    ConSrvDrainOutputRings(Console);
+
     /*
      * Insert the process into the processes list of the console,
      * and set its foreground priority.
@@ -1236,17 +1241,24 @@ ConSrvRemoveConsole(
     ProcessData->ConsoleApp = FALSE;
     ProcessData->Process->Flags &= ~CsrProcessIsConsoleApp;
 
+    /* Stop draining the output ring in the background, this waits for it */
+    ConSrvStopOutputRing(ProcessData);
+
     /* Validate and lock the console */
     if (!ConSrvValidateConsole(&Console,
                                ProcessData->ConsoleHandle,
                                CONSOLE_RUNNING, TRUE))
     {
+        ConSrvDeleteOutputRing(ProcessData, NULL);
         // FIXME: Find another status code
         return STATUS_UNSUCCESSFUL;
     }
 
     DPRINT("ConSrvRemoveConsole - Locking OK\n");
 
+    /* Output what is left in the output ring and free it */
+    ConSrvDeleteOutputRing(ProcessData, Console);
+
     /* Retrieve the console leader process */
     ConsoleLeaderProcess = ConSrvGetConsoleLeaderProcess(Console);
 
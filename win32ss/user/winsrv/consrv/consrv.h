@@ -52,6 +52,8 @@ typedef struct _CONSOLE_PROCESS_DATA
     LPTHREAD_START_ROUTINE CtrlRoutine;
     LPTHREAD_START_ROUTINE PropRoutine; // We hold the property dialog handler there, till all the GUI thingie moves out from CSRSS.
     // LPTHREAD_START_ROUTINE ImeRoutine;
+
+    struct _CONSRV_OUTPUT_RING* OutputRing; // Shared memory WriteConsole ring, if the process asked for one.
 } CONSOLE_PROCESS_DATA, *PCONSOLE_PROCESS_DATA;
 
 #include "include/conio.h"
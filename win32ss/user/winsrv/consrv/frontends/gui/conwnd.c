@@ -1253,6 +1253,9 @@ OnTimer(PGUI_CONSOLE_DATA GuiData)
 
     Buff = GuiData->ActiveBuffer;
 
+    /* Catch up with the text written since the last update */
+    GuiScrollPendingLines(GuiData);
+
     if (GetType(Buff) == TEXTMODE_BUFFER)
     {
         /* Repaint the caret */
@@ -85,6 +85,9 @@ typedef struct _GUI_CONSOLE_DATA
     HFONT Font[FONT_MAXNO];
     UINT CharWidth;     /* The character width and height should be the same for */
     UINT CharHeight;    /* both normal and bold/underlined fonts...              */
+
+    UINT ScrolledLines;         /* Lines the text scrolled by since the window was last updated */
+    SMALL_RECT UpdateRegion;    /* Cells written since then, once the window catches up         */
 /*****************************************************/
 
     PCONSRV_CONSOLE Console;           /* Pointer to the owned console */
@@ -78,6 +78,16 @@ DrawRegion(PGUI_CONSOLE_DATA GuiData,
 {
     RECT RegionRect;
 
+    /*
+     * While the window lags behind the scrolled text, its cells are not where
+     * the region says: update them only once the window has caught up.
+     */
+    if (GuiData->ScrolledLines != 0)
+    {
+        ConioGetUnion(&GuiData->UpdateRegion, &GuiData->UpdateRegion, Region);
+        return;
+    }
+
     SmallRectToRect(GuiData, &RegionRect, Region);
     /* Do not erase the background: it speeds up redrawing and reduce flickering */
     InvalidateRect(GuiData->hWindow, &RegionRect, FALSE);
@@ -92,6 +102,52 @@ InvalidateCell(PGUI_CONSOLE_DATA GuiData,
     DrawRegion(GuiData, &CellRect);
 }
 
+/*
+ * Scrolls the window by the lines the text scrolled by since the window was
+ * last updated, then updates the cells written in the meantime. When output
+ * comes faster than the window repaints, the window is thus scrolled once per
+ * repaint instead of once per write. Must be called with the console locked.
+ */
+VOID
+GuiScrollPendingLines(PGUI_CONSOLE_DATA GuiData)
+{
+    PCONSOLE_SCREEN_BUFFER Buff = GuiData->ActiveBuffer;
+    RECT ScrollRect;
+    SMALL_RECT UpdateRegion;
+
+    if (GuiData->ScrolledLines == 0) return;
+
+    if (GetType(Buff) == TEXTMODE_BUFFER &&
+        GuiData->ScrolledLines < (UINT)Buff->ViewSize.Y)
+    {
+        ScrollRect.left   = 0;
+        ScrollRect.top    = 0;
+        ScrollRect.right  = Buff->ViewSize.X * GuiData->CharWidth;
+        ScrollRect.bottom = Buff->ViewSize.Y * GuiData->CharHeight;
+
+        ScrollWindowEx(GuiData->hWindow,
+                       0,
+                       -(int)(GuiData->ScrolledLines * GuiData->CharHeight),
+                       &ScrollRect,
+                       &ScrollRect,
+                       NULL,
+                       NULL,
+                       SW_INVALIDATE);
+    }
+    else
+    {
+        /* Nothing that is on the screen stays there */
+        InvalidateRect(GuiData->hWindow, NULL, FALSE);
+    }
+
+    UpdateRegion = GuiData->UpdateRegion;
+    GuiData->ScrolledLines = 0;
+    ConioInitRect(&GuiData->UpdateRegion, 0, -1, 0, -1);
+
+    if (!ConioIsRectEmpty(&UpdateRegion))
+        DrawRegion(GuiData, &UpdateRegion);
+}
+
 
 /******************************************************************************
  *                        GUI Terminal Initialization                         *
@@ -508,6 +564,9 @@ GuiInitFrontEnd(IN OUT PFRONTEND This,
 
     InitializeCriticalSection(&GuiData->Lock);
 
+    GuiData->ScrolledLines = 0;
+    ConioInitRect(&GuiData->UpdateRegion, 0, -1, 0, -1);
+
     /*
      * Set up GUI data
      */
@@ -649,7 +708,6 @@ GuiWriteStream(IN OUT PFRONTEND This,
     PGUI_CONSOLE_DATA GuiData = This->Context;
     PCONSOLE_SCREEN_BUFFER Buff;
     SHORT CursorEndX, CursorEndY;
-    RECT ScrollRect;
 
     if (NULL == GuiData || NULL == GuiData->hWindow) return;
 
@@ -659,21 +717,25 @@ GuiWriteStream(IN OUT PFRONTEND This,
     Buff = GuiData->ActiveBuffer;
     if (GetType(Buff) != TEXTMODE_BUFFER) return;
 
+    /*
+     * The window gets scrolled when it next updates, see GuiScrollPendingLines.
+     * Until then, the cells waiting for an update move up with the text.
+     */
     if (0 != ScrolledLines)
     {
-        ScrollRect.left = 0;
-        ScrollRect.top = 0;
-        ScrollRect.right = Buff->ViewSize.X * GuiData->CharWidth;
-        ScrollRect.bottom = Region->Top * GuiData->CharHeight;
-
-        ScrollWindowEx(GuiData->hWindow,
-                       0,
-                       -(int)(ScrolledLines * GuiData->CharHeight),
-                       &ScrollRect,
-                       NULL,
-                       NULL,
-                       NULL,
-                       SW_INVALIDATE);
+        if (GuiData->ScrolledLines != 0 && !ConioIsRectEmpty(&GuiData->UpdateRegion))
+        {
+            if (GuiData->UpdateRegion.Bottom < (SHORT)ScrolledLines)
+            {
+                ConioInitRect(&GuiData->UpdateRegion, 0, -1, 0, -1);
+            }
+            else
+            {
+                GuiData->UpdateRegion.Top = max(GuiData->UpdateRegion.Top - (SHORT)ScrolledLines, 0);
+                GuiData->UpdateRegion.Bottom -= (SHORT)ScrolledLines;
+            }
+        }
+        GuiData->ScrolledLines += ScrolledLines;
     }
 
     DrawRegion(GuiData, Region);
@@ -22,6 +22,9 @@
 
 #define IS_WHITESPACE(c)    ((c) == L'\0' || (c) == L' ' || (c) == L'\t')
 
+/* Maximum number of characters drawn by one ExtTextOutW call */
+#define LINE_RUN_LENGTH     256
+
 /* FUNCTIONS ******************************************************************/
 
 static COLORREF
@@ -437,9 +440,11 @@ GuiPaintTextModeBuffer(PTEXTMODE_SCREEN_BUFFER Buffer,
 {
     PCONSRV_CONSOLE Console = (PCONSRV_CONSOLE)Buffer->Header.Console;
     ULONG TopLine, BottomLine, LeftColumn, RightColumn;
-    ULONG Line, Char, Start;
+    ULONG Line, Char, Start, First, Last, Count;
     PCHAR_INFO From;
-    PWCHAR To;
+    WCHAR LineBuffer[LINE_RUN_LENGTH];  // Characters of the run being gathered
+    INT   CharDx[LINE_RUN_LENGTH];      // and the width of their cells
+    RECT  RunRect;
     WORD LastAttribute, Attribute;
     HFONT OldFont, NewFont;
     BOOLEAN IsUnderline;
@@ -454,6 +459,16 @@ GuiPaintTextModeBuffer(PTEXTMODE_SCREEN_BUFFER Buffer,
     if (!ConDrvValidateConsoleUnsafe((PCONSOLE)Console, CONSOLE_RUNNING, TRUE))
         return;
 
+    /* Catch up with the text that scrolled since the window was last updated */
+    if (GuiData->ScrolledLines != 0)
+    {
+        /* The stale pixels we are about to paint over move up as well */
+        RunRect = *rcView;
+        OffsetRect(&RunRect, 0, -(INT)(GuiData->ScrolledLines * GuiData->CharHeight));
+        GuiScrollPendingLines(GuiData);
+        InvalidateRect(GuiData->hWindow, &RunRect, FALSE);
+    }
+
     ConioInitLongRect(rcFramebuffer,
                       Buffer->ViewOrigin.Y * GuiData->CharHeight + rcView->top,
                       Buffer->ViewOrigin.X * GuiData->CharWidth  + rcView->left,
@@ -470,7 +485,7 @@ GuiPaintTextModeBuffer(PTEXTMODE_SCREEN_BUFFER Buffer,
     if (BottomLine >= (ULONG)Buffer->ScreenBufferSize.Y)
         BottomLine  = Buffer->ScreenBufferSize.Y - 1;
 
-    LastAttribute = ConioCoordToPointer(Buffer, LeftColumn, TopLine)->Attributes;
+    LastAttribute = ConioCoordToPointer(Buffer, LeftColumn, TopLine)->Attributes & ~COMMON_LVB_SBCSDBCS;
 
     SetTextColor(GuiData->hMemDC, PaletteRGBFromAttrib(Console, TextAttribFromAttrib(LastAttribute)));
     SetBkColor(GuiData->hMemDC, PaletteRGBFromAttrib(Console, BkgdAttribFromAttrib(LastAttribute)));
@@ -481,87 +496,94 @@ GuiPaintTextModeBuffer(PTEXTMODE_SCREEN_BUFFER Buffer,
     NewFont = GuiData->Font[IsUnderline ? FONT_BOLD : FONT_NORMAL];
     OldFont = SelectObject(GuiData->hMemDC, NewFont);
 
-    if (Console->IsCJK)
+    /*
+     * Each line is drawn as runs of cells with the same attributes, with one
+     * opaque ExtTextOutW call per run. The character advances are given
+     * explicitly, so that the text sticks to the cell grid whatever the font
+     * and the full-width characters span their two cells.
+     */
+    for (Line = TopLine; Line <= BottomLine; Line++)
     {
-        for (Line = TopLine; Line <= BottomLine; Line++)
+        First = LeftColumn;
+        Last  = RightColumn;
+
+        /* Never draw only half of a full-width character */
+        if (Console->IsCJK)
         {
-            for (Char = LeftColumn; Char <= RightColumn; Char++)
+            if (First > 0 &&
+                (ConioCoordToPointer(Buffer, First, Line)->Attributes & COMMON_LVB_TRAILING_BYTE))
             {
-                From = ConioCoordToPointer(Buffer, Char, Line);
-                Attribute = From->Attributes;
-                SetTextColor(GuiData->hMemDC, PaletteRGBFromAttrib(Console, TextAttribFromAttrib(Attribute)));
-                SetBkColor(GuiData->hMemDC, PaletteRGBFromAttrib(Console, BkgdAttribFromAttrib(Attribute)));
-
-                /* Change underline state if needed */
-                if (!!(Attribute & COMMON_LVB_UNDERSCORE) != IsUnderline)
-                {
-                    IsUnderline = !!(Attribute & COMMON_LVB_UNDERSCORE);
-
-                    /* Select the new font */
-                    NewFont = GuiData->Font[IsUnderline ? FONT_BOLD : FONT_NORMAL];
-                    SelectObject(GuiData->hMemDC, NewFont);
-                }
-
-                if (Attribute & COMMON_LVB_TRAILING_BYTE)
-                    continue;
-
-                TextOutW(GuiData->hMemDC,
-                         Char * GuiData->CharWidth,
-                         Line * GuiData->CharHeight,
-                         &From->Char.UnicodeChar, 1);
+                First--;
+            }
+            if (Last < (ULONG)Buffer->ScreenBufferSize.X - 1 &&
+                (ConioCoordToPointer(Buffer, Last, Line)->Attributes & COMMON_LVB_LEADING_BYTE))
+            {
+                Last++;
             }
         }
-    }
-    else
-    {
-        for (Line = TopLine; Line <= BottomLine; Line++)
-        {
-            WCHAR LineBuffer[80];   // Buffer containing a part or all the line to be displayed
-            From  = ConioCoordToPointer(Buffer, LeftColumn, Line);  // Get the first code of the line
-            Start = LeftColumn;
-            To    = LineBuffer;
 
-            for (Char = LeftColumn; Char <= RightColumn; Char++)
+        From  = ConioCoordToPointer(Buffer, First, Line);  // Get the first code of the line
+        Start = First;
+        Count = 0;
+
+        for (Char = First; ; Char++, From++)
+        {
+            /*
+             * We flush the run at the end of the line, if the new attribute
+             * is different from the current one, or if the run is full
+             * (but keep the trailing byte of a character with its leading one).
+             */
+            Attribute = (Char <= Last) ? (From->Attributes & ~COMMON_LVB_SBCSDBCS) : LastAttribute;
+            if (Char > Last || Attribute != LastAttribute ||
+                (Count == LINE_RUN_LENGTH && !(From->Attributes & COMMON_LVB_TRAILING_BYTE)))
             {
-                /*
-                 * We flush the buffer if the new attribute is different
-                 * from the current one, or if the buffer is full.
-                 */
-                if (From->Attributes != LastAttribute || (Char - Start == sizeof(LineBuffer) / sizeof(WCHAR)))
+                if (Char > Start)
+                {
+                    RunRect.left   = Start * GuiData->CharWidth;
+                    RunRect.top    = Line  * GuiData->CharHeight;
+                    RunRect.right  = Char  * GuiData->CharWidth;
+                    RunRect.bottom = RunRect.top + GuiData->CharHeight;
+                    ExtTextOutW(GuiData->hMemDC,
+                                RunRect.left,
+                                RunRect.top,
+                                ETO_OPAQUE,
+                                &RunRect,
+                                LineBuffer,
+                                Count,
+                                CharDx);
+                }
+                if (Char > Last)
+                    break;
+
+                Start = Char;
+                Count = 0;
+                if (Attribute != LastAttribute)
                 {
-                    TextOutW(GuiData->hMemDC,
-                             Start * GuiData->CharWidth,
-                             Line  * GuiData->CharHeight,
-                             LineBuffer,
-                             Char - Start);
-                    Start = Char;
-                    To    = LineBuffer;
-                    Attribute = From->Attributes;
-                    if (Attribute != LastAttribute)
+                    LastAttribute = Attribute;
+                    SetTextColor(GuiData->hMemDC, PaletteRGBFromAttrib(Console, TextAttribFromAttrib(LastAttribute)));
+                    SetBkColor(GuiData->hMemDC, PaletteRGBFromAttrib(Console, BkgdAttribFromAttrib(LastAttribute)));
+
+                    /* Change underline state if needed */
+                    if (!!(LastAttribute & COMMON_LVB_UNDERSCORE) != IsUnderline)
                     {
-                        LastAttribute = Attribute;
-                        SetTextColor(GuiData->hMemDC, PaletteRGBFromAttrib(Console, TextAttribFromAttrib(LastAttribute)));
-                        SetBkColor(GuiData->hMemDC, PaletteRGBFromAttrib(Console, BkgdAttribFromAttrib(LastAttribute)));
-
-                        /* Change underline state if needed */
-                        if (!!(LastAttribute & COMMON_LVB_UNDERSCORE) != IsUnderline)
-                        {
-                            IsUnderline = !!(LastAttribute & COMMON_LVB_UNDERSCORE);
-                            /* Select the new font */
-                            NewFont = GuiData->Font[IsUnderline ? FONT_BOLD : FONT_NORMAL];
-                            SelectObject(GuiData->hMemDC, NewFont);
-                        }
+                        IsUnderline = !!(LastAttribute & COMMON_LVB_UNDERSCORE);
+                        /* Select the new font */
+                        NewFont = GuiData->Font[IsUnderline ? FONT_BOLD : FONT_NORMAL];
+                        SelectObject(GuiData->hMemDC, NewFont);
                     }
                 }
+            }
 
-                *(To++) = (From++)->Char.UnicodeChar;
+            /* A trailing byte only widens the cell of its leading byte */
+            if ((From->Attributes & COMMON_LVB_TRAILING_BYTE) && Count > 0)
+            {
+                CharDx[Count - 1] += GuiData->CharWidth;
+                continue;
             }
 
-            TextOutW(GuiData->hMemDC,
-                     Start * GuiData->CharWidth,
-                     Line  * GuiData->CharHeight,
-                     LineBuffer,
-                     RightColumn - Start + 1);
+            LineBuffer[Count] = From->Char.UnicodeChar;
+            CharDx[Count] = GuiData->CharWidth;
+            Count++;
         }
     }
 